@@ -0,0 +1,572 @@
+// Runner for the benchmarks registered with BENCHMARK(), and comparison of the JSON results of two runs.
+//
+// usage: shade_bench [--filter TEXT] [--min-time MS] [--repetitions N] [--json FILE] [--list] [--verbose]
+//        shade_bench --compare BASELINE.json CURRENT.json [--threshold PERCENT]
+//
+// A comparison flags a benchmark as regressed when its median time per iteration grew by more than the threshold and
+//  by more than twice the noise (relative standard deviation) of either run, and exits with 1 when any did.
+#include "Bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <thread>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+
+std::vector<BenchInfo>& GetBenchRegistry()
+{
+    static std::vector<BenchInfo> registry;
+    return registry;
+}
+
+
+namespace
+{
+    struct BenchOptions
+    {
+        string  filter;
+        double  minTimeMs       = 100.0;    // per sample
+        uint    repetitions     = 10;
+        bool    verbose         = false;
+    };
+
+    struct BenchResult
+    {
+        string  name;
+        uint64  iterations;                 // per sample
+        uint    samples;
+        double  medianNs;                   // all times are per iteration
+        double  meanNs;
+        double  minNs;
+        double  stddevNs;
+        double  itemsPerSecond;             // zero when not reported
+        double  bytesPerSecond;
+        string  skipReason;
+    };
+
+
+    // The engine logs to stderr outside Windows, which would both flood the terminal and dominate the timing of
+    //  anything that logs, so it is pointed at the null device while benchmarks run. The logger's writer thread is
+    //  flushed either side, so that only the benchmark's own messages are discarded.
+    class LogSilencer
+    {
+    public:
+        LogSilencer(bool enable) : m_savedDescriptor(-1)
+        {
+#if !defined(_WIN32)
+            if (!enable) return;
+            Logger::Get().Flush();
+            fflush(stderr);
+            const int nullDescriptor = open("/dev/null", O_WRONLY);
+            if (nullDescriptor < 0) return;
+            m_savedDescriptor = dup(STDERR_FILENO);
+            dup2(nullDescriptor, STDERR_FILENO);
+            close(nullDescriptor);
+#endif
+        }
+        ~LogSilencer()
+        {
+#if !defined(_WIN32)
+            if (m_savedDescriptor < 0) return;
+            Logger::Get().Flush();
+            fflush(stderr);
+            dup2(m_savedDescriptor, STDERR_FILENO);
+            close(m_savedDescriptor);
+#endif
+        }
+
+    private:
+        int m_savedDescriptor;
+    };
+
+
+    string FormatDuration(double nanoseconds)
+    {
+        if (nanoseconds >= 1.0e9) return fmt::format("{:.3f} s", nanoseconds / 1.0e9);
+        if (nanoseconds >= 1.0e6) return fmt::format("{:.3f} ms", nanoseconds / 1.0e6);
+        if (nanoseconds >= 1.0e3) return fmt::format("{:.3f} us", nanoseconds / 1.0e3);
+        return fmt::format("{:.1f} ns", nanoseconds);
+    }
+
+    string FormatRate(double perSecond, const char* pUnit)
+    {
+        if (perSecond >= 1.0e9) return fmt::format("{:.2f} G{}/s", perSecond / 1.0e9, pUnit);
+        if (perSecond >= 1.0e6) return fmt::format("{:.2f} M{}/s", perSecond / 1.0e6, pUnit);
+        if (perSecond >= 1.0e3) return fmt::format("{:.2f} k{}/s", perSecond / 1.0e3, pUnit);
+        return fmt::format("{:.2f} {}/s", perSecond, pUnit);
+    }
+
+
+    //******************************************************************************************************************
+    //                                                  Running
+    //******************************************************************************************************************
+    // runs a benchmark for a given number of iterations, returning the time taken in nanoseconds
+    double RunOnce(const BenchInfo& info, uint64 iterations, BenchState& state)
+    {
+        state = BenchState(iterations);
+        info.function(state);
+        return state.GetElapsedNanoseconds();
+    }
+
+    BenchResult RunBenchmark(const BenchInfo& info, const BenchOptions& options)
+    {
+        BenchResult result = {};
+        result.name = info.pName;
+
+        // grow the iteration count until a sample lasts long enough, which also serves to warm up
+        const double minTimeNs = options.minTimeMs * 1.0e6;
+        constexpr uint64 MaxIterations = 1000000000;
+        BenchState state(1);
+        uint64 iterations = 1;
+        for (;;)
+        {
+            const double elapsed = RunOnce(info, iterations, state);
+            if (!state.GetSkipReason().empty())
+            {
+                result.skipReason = state.GetSkipReason();
+                return result;
+            }
+            if (elapsed >= minTimeNs || iterations >= MaxIterations) break;
+
+            // aim a little past the target, but no more than a hundredfold at once in case the first runs were cold
+            const double estimate = (elapsed > 0.0) ? iterations * minTimeNs * 1.2 / elapsed : iterations * 100.0;
+            iterations = min<uint64>(max<uint64>(static_cast<uint64>(estimate), iterations * 2),
+                                     min<uint64>(iterations * 100, MaxIterations));
+        }
+
+        vector<double> samples(max(options.repetitions, 1u));
+        for (double& sample : samples)
+        {
+            sample = RunOnce(info, iterations, state) / iterations;
+        }
+
+        double sum = 0.0;
+        for (double sample : samples) sum += sample;
+        double squares = 0.0;
+        result.meanNs = sum / samples.size();
+        for (double sample : samples) squares += (sample - result.meanNs) * (sample - result.meanNs);
+
+        sort(samples.begin(), samples.end());
+        const size_t middle = samples.size() / 2;
+        result.iterations   = iterations;
+        result.samples      = static_cast<uint>(samples.size());
+        result.medianNs     = (samples.size() % 2) ? samples[middle] : 0.5 * (samples[middle - 1] + samples[middle]);
+        result.minNs        = samples.front();
+        result.stddevNs     = (samples.size() > 1) ? sqrt(squares / (samples.size() - 1)) : 0.0;
+        if (state.GetItemsPerIteration() > 0) result.itemsPerSecond = state.GetItemsPerIteration() * 1.0e9 / result.medianNs;
+        if (state.GetBytesPerIteration() > 0) result.bytesPerSecond = state.GetBytesPerIteration() * 1.0e9 / result.medianNs;
+        return result;
+    }
+
+    void PrintResult(const BenchResult& result)
+    {
+        if (!result.skipReason.empty())
+        {
+            fmt::print("{:<32} skipped: {}\n", result.name, result.skipReason);
+            return;
+        }
+
+        string throughput;
+        if (result.itemsPerSecond > 0.0) throughput += FormatRate(result.itemsPerSecond, "items");
+        if (result.bytesPerSecond > 0.0) throughput += (throughput.empty() ? "" : "  ") + FormatRate(result.bytesPerSecond, "B");
+        fmt::print("{:<32} {:>12} {:>12} {:>7.2f}% {:>12}  {}\n", result.name, FormatDuration(result.medianNs),
+                   FormatDuration(result.minNs), 100.0 * result.stddevNs / result.medianNs, result.iterations, throughput);
+    }
+
+
+    //******************************************************************************************************************
+    //                                                  JSON Output
+    //******************************************************************************************************************
+    string EscapeJson(const string& text)
+    {
+        string escaped;
+        for (char c : text)
+        {
+            if      (c == '"')  escaped += "\\\"";
+            else if (c == '\\') escaped += "\\\\";
+            else if (c == '\n') escaped += "\\n";
+            else if (static_cast<unsigned char>(c) < 0x20) escaped += fmt::format("\\u{:04x}", c);
+            else                escaped += c;
+        }
+        return escaped;
+    }
+
+    bool WriteJson(const string& filename, const vector<BenchResult>& results, const BenchOptions& options)
+    {
+        ofstream file(filename);
+        if (!file)
+        {
+            PrintMessage(Error, "Unable to open results file \"{}\"", filename);
+            return false;
+        }
+
+        char date[32] = {};
+        const time_t now = time(nullptr);
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+#if defined(NDEBUG)
+        const char* pBuild = "release";
+#else
+        const char* pBuild = "debug";
+#endif
+
+        file << "{\n";
+        file << fmt::format("  \"context\": {{\"date\": \"{}\", \"build\": \"{}\", \"hardware_threads\": {}, "
+                            "\"min_time_ms\": {}, \"repetitions\": {}}},\n",
+                            date, pBuild, thread::hardware_concurrency(), options.minTimeMs, options.repetitions);
+        file << "  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); ++i)
+        {
+            const BenchResult& result = results[i];
+            file << (i == 0 ? "\n" : ",\n");
+            if (!result.skipReason.empty())
+            {
+                file << fmt::format("    {{\"name\": \"{}\", \"skipped\": \"{}\"}}",
+                                    EscapeJson(result.name), EscapeJson(result.skipReason));
+                continue;
+            }
+            file << fmt::format("    {{\"name\": \"{}\", \"iterations\": {}, \"samples\": {}, \"median_ns\": {}, "
+                                "\"mean_ns\": {}, \"min_ns\": {}, \"stddev_ns\": {}, \"items_per_second\": {}, "
+                                "\"bytes_per_second\": {}}}",
+                                EscapeJson(result.name), result.iterations, result.samples, result.medianNs,
+                                result.meanNs, result.minNs, result.stddevNs, result.itemsPerSecond, result.bytesPerSecond);
+        }
+        file << "\n  ]\n}\n";
+
+        if (!file.good())
+        {
+            PrintMessage(Error, "Failed to write results file \"{}\"", filename);
+            return false;
+        }
+        fmt::print("Wrote {} results to \"{}\"\n", results.size(), filename);
+        return true;
+    }
+
+
+    //******************************************************************************************************************
+    //                                                  JSON Input
+    //******************************************************************************************************************
+    // Just enough JSON to read back result files, including ones edited by hand or by other tools.
+    struct JsonValue
+    {
+        enum Type {Null, Boolean, Number, String, Array, Object};
+
+        Type                                    type = Null;
+        double                                  number = 0.0;
+        string                                  text;
+        vector<JsonValue>                       elements;
+        vector<pair<string, JsonValue>>         members;
+
+        const JsonValue* Find(const char* pKey) const
+        {
+            for (const auto& member : members)
+            {
+                if (member.first == pKey) return &member.second;
+            }
+            return nullptr;
+        }
+        double GetNumber(const char* pKey) const
+        {
+            const JsonValue* pValue = Find(pKey);
+            return (pValue != nullptr && pValue->type == Number) ? pValue->number : 0.0;
+        }
+        string GetString(const char* pKey) const
+        {
+            const JsonValue* pValue = Find(pKey);
+            return (pValue != nullptr && pValue->type == String) ? pValue->text : string();
+        }
+    };
+
+    class JsonReader
+    {
+    public:
+        JsonReader(const string& text) : m_text(text), m_position(0) {}
+
+        bool Parse(JsonValue& value)
+        {
+            return ParseValue(value) && (SkipWhitespace(), m_position == m_text.size());
+        }
+
+    private:
+        void SkipWhitespace()
+        {
+            while (m_position < m_text.size() && isspace(static_cast<unsigned char>(m_text[m_position]))) m_position++;
+        }
+        bool Consume(char c)
+        {
+            SkipWhitespace();
+            if (m_position >= m_text.size() || m_text[m_position] != c) return false;
+            m_position++;
+            return true;
+        }
+        bool ConsumeWord(const char* pWord)
+        {
+            const size_t length = strlen(pWord);
+            if (m_text.compare(m_position, length, pWord) != 0) return false;
+            m_position += length;
+            return true;
+        }
+
+        bool ParseValue(JsonValue& value)
+        {
+            SkipWhitespace();
+            if (m_position >= m_text.size()) return false;
+
+            const char c = m_text[m_position];
+            if (c == '{')   return ParseObject(value);
+            if (c == '[')   return ParseArray(value);
+            if (c == '"')   {value.type = JsonValue::String; return ParseString(value.text);}
+            if (ConsumeWord("true"))    {value.type = JsonValue::Boolean; value.number = 1.0; return true;}
+            if (ConsumeWord("false"))   {value.type = JsonValue::Boolean; value.number = 0.0; return true;}
+            if (ConsumeWord("null"))    {value.type = JsonValue::Null; return true;}
+
+            const char* pStart = m_text.c_str() + m_position;
+            char* pEnd = nullptr;
+            value.type = JsonValue::Number;
+            value.number = strtod(pStart, &pEnd);
+            if (pEnd == pStart) return false;
+            m_position += pEnd - pStart;
+            return true;
+        }
+
+        bool ParseString(string& text)
+        {
+            if (!Consume('"')) return false;
+            while (m_position < m_text.size())
+            {
+                const char c = m_text[m_position++];
+                if (c == '"') return true;
+                if (c != '\\')
+                {
+                    text += c;
+                    continue;
+                }
+                if (m_position >= m_text.size()) return false;
+
+                // escaped code points are only ever names here, so anything beyond ASCII is replaced
+                const char escaped = m_text[m_position++];
+                switch (escaped)
+                {
+                case 'n':   text += '\n';   break;
+                case 't':   text += '\t';   break;
+                case 'r':   text += '\r';   break;
+                case 'b':   text += '\b';   break;
+                case 'f':   text += '\f';   break;
+                case 'u':
+                {
+                    if (m_position + 4 > m_text.size()) return false;
+                    const unsigned long codePoint = strtoul(m_text.substr(m_position, 4).c_str(), nullptr, 16);
+                    text += (codePoint < 0x80) ? static_cast<char>(codePoint) : '?';
+                    m_position += 4;
+                    break;
+                }
+                default:    text += escaped;    break;
+                }
+            }
+            return false;
+        }
+
+        bool ParseArray(JsonValue& value)
+        {
+            value.type = JsonValue::Array;
+            Consume('[');
+            if (Consume(']')) return true;
+            do
+            {
+                value.elements.emplace_back();
+                if (!ParseValue(value.elements.back())) return false;
+            } while (Consume(','));
+            return Consume(']');
+        }
+
+        bool ParseObject(JsonValue& value)
+        {
+            value.type = JsonValue::Object;
+            Consume('{');
+            if (Consume('}')) return true;
+            do
+            {
+                value.members.emplace_back();
+                SkipWhitespace();
+                if (!ParseString(value.members.back().first) || !Consume(':')) return false;
+                if (!ParseValue(value.members.back().second)) return false;
+            } while (Consume(','));
+            return Consume('}');
+        }
+
+        const string&   m_text;
+        size_t          m_position;
+    };
+
+    bool ReadJson(const string& filename, vector<BenchResult>& results)
+    {
+        ifstream file(filename);
+        if (!file)
+        {
+            PrintMessage(Error, "Unable to open results file \"{}\"", filename);
+            return false;
+        }
+        stringstream buffer;
+        buffer << file.rdbuf();
+        const string text = buffer.str();
+
+        JsonValue root;
+        const JsonValue* pBenchmarks = nullptr;
+        if (!JsonReader(text).Parse(root) || (pBenchmarks = root.Find("benchmarks")) == nullptr ||
+            pBenchmarks->type != JsonValue::Array)
+        {
+            PrintMessage(Error, "\"{}\" is not a benchmark results file", filename);
+            return false;
+        }
+
+        for (const JsonValue& entry : pBenchmarks->elements)
+        {
+            BenchResult result = {};
+            result.name             = entry.GetString("name");
+            result.skipReason       = entry.GetString("skipped");
+            result.iterations       = static_cast<uint64>(entry.GetNumber("iterations"));
+            result.samples          = static_cast<uint>(entry.GetNumber("samples"));
+            result.medianNs         = entry.GetNumber("median_ns");
+            result.meanNs           = entry.GetNumber("mean_ns");
+            result.minNs            = entry.GetNumber("min_ns");
+            result.stddevNs         = entry.GetNumber("stddev_ns");
+            result.itemsPerSecond   = entry.GetNumber("items_per_second");
+            result.bytesPerSecond   = entry.GetNumber("bytes_per_second");
+            if (!result.name.empty()) results.push_back(result);
+        }
+        return true;
+    }
+
+
+    //******************************************************************************************************************
+    //                                                  Comparison
+    //******************************************************************************************************************
+    int Compare(const string& baselineFilename, const string& currentFilename, double thresholdPercent)
+    {
+        vector<BenchResult> baseline;
+        vector<BenchResult> current;
+        if (!ReadJson(baselineFilename, baseline) || !ReadJson(currentFilename, current)) return 2;
+
+        map<string, const BenchResult*> currentByName;
+        for (const BenchResult& result : current) currentByName[result.name] = &result;
+
+        uint regressions = 0;
+        uint improvements = 0;
+        fmt::print("{:<32} {:>12} {:>12} {:>9}  {}\n", "Benchmark", "Baseline", "Current", "Change", "Verdict");
+        for (const BenchResult& base : baseline)
+        {
+            const auto it = currentByName.find(base.name);
+            if (it == currentByName.end())
+            {
+                fmt::print("{:<32} {:>12} {:>12} {:>9}  missing\n", base.name, FormatDuration(base.medianNs), "-", "-");
+                continue;
+            }
+            const BenchResult& now = *it->second;
+            currentByName.erase(it);
+            if (!base.skipReason.empty() || !now.skipReason.empty() || base.medianNs <= 0.0 || now.medianNs <= 0.0)
+            {
+                fmt::print("{:<32} {:>12} {:>12} {:>9}  skipped\n", base.name, "-", "-", "-");
+                continue;
+            }
+
+            // a change only counts when it stands clear of the run to run noise of either side
+            const double change = 100.0 * (now.medianNs - base.medianNs) / base.medianNs;
+            const double noise = 100.0 * max(base.stddevNs / base.medianNs, now.stddevNs / now.medianNs);
+            const double significant = max(thresholdPercent, 2.0 * noise);
+            const char* pVerdict = "same";
+            if      (change > significant)  {pVerdict = "REGRESSION";   regressions++;}
+            else if (change < -significant) {pVerdict = "improved";     improvements++;}
+
+            fmt::print("{:<32} {:>12} {:>12} {:>+8.2f}%  {}\n", base.name, FormatDuration(base.medianNs),
+                       FormatDuration(now.medianNs), change, pVerdict);
+        }
+        for (const BenchResult& result : current)
+        {
+            if (currentByName.count(result.name) == 0) continue;
+            fmt::print("{:<32} {:>12} {:>12} {:>9}  new\n", result.name, "-", FormatDuration(result.medianNs), "-");
+        }
+
+        fmt::print("{} regressed and {} improved beyond {:.1f}%\n", regressions, improvements, thresholdPercent);
+        return (regressions > 0) ? 1 : 0;
+    }
+
+
+    void PrintUsage(const char* pProgram)
+    {
+        fmt::print("usage: {} [--filter TEXT] [--min-time MS] [--repetitions N] [--json FILE] [--list] [--verbose]\n"
+                   "       {} --compare BASELINE.json CURRENT.json [--threshold PERCENT]\n", pProgram, pProgram);
+    }
+}
+
+
+int main(int argc, char** argv)
+{
+    BenchOptions options;
+    string jsonFilename;
+    string baselineFilename;
+    string currentFilename;
+    double thresholdPercent = 5.0;
+    bool list = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const bool hasValue = (i + 1 < argc);
+        if      (strcmp(argv[i], "--list") == 0)                    list = true;
+        else if (strcmp(argv[i], "--verbose") == 0)                 options.verbose = true;
+        else if (strcmp(argv[i], "--filter") == 0 && hasValue)      options.filter = argv[++i];
+        else if (strcmp(argv[i], "--min-time") == 0 && hasValue)    options.minTimeMs = max(atof(argv[++i]), 0.001);
+        else if (strcmp(argv[i], "--repetitions") == 0 && hasValue) options.repetitions = max(atoi(argv[++i]), 1);
+        else if (strcmp(argv[i], "--json") == 0 && hasValue)        jsonFilename = argv[++i];
+        else if (strcmp(argv[i], "--threshold") == 0 && hasValue)   thresholdPercent = atof(argv[++i]);
+        else if (strcmp(argv[i], "--compare") == 0 && i + 2 < argc)
+        {
+            baselineFilename = argv[++i];
+            currentFilename = argv[++i];
+        }
+        else
+        {
+            PrintMessage(Error, "Unknown or incomplete argument \"{}\"", argv[i]);
+            PrintUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (!baselineFilename.empty()) return Compare(baselineFilename, currentFilename, thresholdPercent);
+
+    // run in name order, so that result files line up between builds
+    vector<BenchInfo> benchmarks = GetBenchRegistry();
+    sort(benchmarks.begin(), benchmarks.end(), [](const BenchInfo& a, const BenchInfo& b) {return strcmp(a.pName, b.pName) < 0;});
+    benchmarks.erase(remove_if(benchmarks.begin(), benchmarks.end(),
+                               [&](const BenchInfo& info) {return strstr(info.pName, options.filter.c_str()) == nullptr;}),
+                     benchmarks.end());
+
+    if (list)
+    {
+        for (const BenchInfo& info : benchmarks) fmt::print("{}\n", info.pName);
+        return 0;
+    }
+
+    fmt::print("{:<32} {:>12} {:>12} {:>8} {:>12}  {}\n", "Benchmark", "Median", "Min", "Noise", "Iterations", "Throughput");
+    vector<BenchResult> results;
+    for (const BenchInfo& info : benchmarks)
+    {
+        {
+            LogSilencer silencer(!options.verbose);
+            results.push_back(RunBenchmark(info, options));
+        }
+        PrintResult(results.back());
+        fflush(stdout);
+    }
+
+    if (!jsonFilename.empty() && !WriteJson(jsonFilename, results, options)) return 2;
+    return 0;
+}
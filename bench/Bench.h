@@ -0,0 +1,122 @@
+// Bench - Minimal microbenchmark harness behind shade_bench.
+//
+// Benchmarks register themselves with BENCHMARK(Name) and time their hot loop with `while (state.KeepRunning())`, so
+//  that setup before the loop is excluded. The runner first calibrates how many iterations fill a sample of the
+//  requested duration, then records several samples of that many iterations and reports per-iteration statistics.
+//  Results may be written as JSON, and two result files compared to flag regressions.
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "Util.h"
+
+
+class BenchState
+{
+public:
+    BenchState(uint64 iterations) :
+        m_iterations(iterations),
+        m_remaining(iterations),
+        m_started(false),
+        m_running(false),
+        m_elapsed(0),
+        m_itemsPerIteration(0),
+        m_bytesPerIteration(0)
+    {
+    }
+
+    // true once for each iteration, timing from the first call until the last
+    bool KeepRunning()
+    {
+        if (!m_started)
+        {
+            m_started = true;
+            ResumeTiming();
+        }
+        if (m_remaining > 0)
+        {
+            m_remaining--;
+            return true;
+        }
+        PauseTiming();
+        return false;
+    }
+
+    // excludes per-iteration setup from the measurement
+    void PauseTiming()
+    {
+        if (!m_running) return;
+        m_elapsed += std::chrono::steady_clock::now() - m_start;
+        m_running = false;
+    }
+    void ResumeTiming()
+    {
+        if (m_running) return;
+        m_start = std::chrono::steady_clock::now();
+        m_running = true;
+    }
+
+    // throughput, reported per second alongside the time per iteration
+    void SetItemsPerIteration(uint64 items)     {m_itemsPerIteration = items;}
+    void SetBytesPerIteration(uint64 bytes)     {m_bytesPerIteration = bytes;}
+
+    // abandons the benchmark, such as when its inputs are unavailable
+    void Skip(const std::string& reason)        {m_skipReason = reason; m_remaining = 0;}
+
+    uint64 GetIterations() const                {return m_iterations;}
+    double GetElapsedNanoseconds() const        {return std::chrono::duration<double, std::nano>(m_elapsed).count();}
+    uint64 GetItemsPerIteration() const         {return m_itemsPerIteration;}
+    uint64 GetBytesPerIteration() const         {return m_bytesPerIteration;}
+    const std::string& GetSkipReason() const    {return m_skipReason;}
+
+private:
+    uint64                                  m_iterations;
+    uint64                                  m_remaining;
+    bool                                    m_started;
+    bool                                    m_running;
+    std::chrono::steady_clock::time_point   m_start;
+    std::chrono::steady_clock::duration     m_elapsed;
+    uint64                                  m_itemsPerIteration;
+    uint64                                  m_bytesPerIteration;
+    std::string                             m_skipReason;
+};
+
+
+// keeps the compiler from discarding a result, or the work which produced it
+template <typename T>
+inline void BenchDoNotOptimize(const T& value)
+{
+#if defined(_MSC_VER)
+    static const void* volatile pSink;
+    pSink = &value;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
+
+
+//**********************************************************************************************************************
+//                                                      Registration
+//**********************************************************************************************************************
+using BenchFunction = void (*)(BenchState& state);
+
+struct BenchInfo
+{
+    const char*     pName;
+    BenchFunction   function;
+};
+
+std::vector<BenchInfo>& GetBenchRegistry();
+
+struct BenchRegistrar
+{
+    BenchRegistrar(const char* pName, BenchFunction function)  {GetBenchRegistry().push_back({pName, function});}
+};
+
+#define BENCHMARK(name)                                                 \
+    static void name(BenchState& state);                                \
+    static BenchRegistrar benchRegistrar##name(#name, name);            \
+    static void name(BenchState& state)
@@ -0,0 +1,755 @@
+// Benchmarks of the engine's CPU hot paths, none of which need a GPU or a window. Inputs are read relative to the
+//  repository root, where the other benchmarks and the headless runner also expect to be launched from.
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <thread>
+
+#include <imgui.h>
+
+#include "Bench.h"
+#include "Camera.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "Shader.h"
+#include "ShaderAnalysis.h"
+#include "ShaderCache.h"
+#include "ShaderPermutations.h"
+#include "Util3D.h"
+#include "Widgets.h"
+#include "nodes/NodeEditor.h"
+
+using namespace std;
+
+
+namespace
+{
+    const char* MeshFilename    = "./media/rotated_teapot.ply";
+    const char* ShaderFilename  = "src/shaders.hlsl";
+
+    // ImGui and imnodes contexts with no platform or renderer backend, configured as the null engine does
+    class HeadlessImGui
+    {
+    public:
+        HeadlessImGui()
+        {
+            m_pImGuiContext = ImGui::CreateContext();
+            m_pImNodesContext = ImNodes::CreateContext();
+
+            ImGuiIO& io = ImGui::GetIO();
+            io.DisplaySize = ImVec2(1920.0f, 1080.0f);
+            io.DeltaTime = 1.0f / 60.0f;
+            io.IniFilename = nullptr;
+
+            unsigned char* pPixels = nullptr;
+            int fontWidth = 0;
+            int fontHeight = 0;
+            io.Fonts->AddFontDefault();
+            io.Fonts->GetTexDataAsRGBA32(&pPixels, &fontWidth, &fontHeight);
+        }
+        ~HeadlessImGui()
+        {
+            ImNodes::DestroyContext(m_pImNodesContext);
+            ImGui::DestroyContext(m_pImGuiContext);
+        }
+
+    private:
+        ImGuiContext*       m_pImGuiContext;
+        ImNodesContext*     m_pImNodesContext;
+    };
+
+    // a pixel output fed by a chain of alternating arithmetic operators, on constants and system values
+    void AddArithmeticChain(NodeEditor& editor, uint mathCount)
+    {
+        const auto output = [&editor](int nodeId) {return editor.GetNode(nodeId)->AttributesOut()[0].ID;};
+        const auto input = [&editor](int nodeId, uint i) {return editor.GetNode(nodeId)->AttributesIn()[i].ID;};
+        const NodeTypeFlat mathTypes[] = {NodeTypeFlat::NumericAdd, NodeTypeFlat::NumericMultiply,
+                                          NodeTypeFlat::NumericSubtract, NodeTypeFlat::NumericDivide};
+        int previous = editor.AddNode(NodeTypeFlat::NumericSystemValue, ImVec2(0.0f, 0.0f));
+        for (uint i = 0; i < mathCount; ++i)
+        {
+            const ImVec2 position(float(i % 8) * 160.0f, float(i / 8) * 120.0f);
+            const int math = editor.AddNode(mathTypes[i % 4], position);
+            const int operand = editor.AddNode((i % 2 == 0) ? NodeTypeFlat::NumericConstant
+                                                            : NodeTypeFlat::NumericSystemValue, position);
+            editor.AddLink(output(previous), input(math, 0));
+            editor.AddLink(output(operand), input(math, 1));
+            previous = math;
+        }
+        const int pixelOutput = editor.AddNode(NodeTypeFlat::ShaderPixelOutput, ImVec2(0.0f, 0.0f));
+        for (uint i = 0; i < 3; ++i) editor.AddLink(output(previous), input(pixelOutput, i));
+    }
+
+    // Branches of chained arithmetic, each from its own constant, merged pairwise into one result, of 64 times the
+    //  branch length nodes. Editing every branch's constant reaches the whole graph, whose branches are independent
+    //  until they merge.
+    void AddBranchingGraph(NodeEditor& editor, uint branchLength, vector<NodeNumericConstant*>& sources)
+    {
+        constexpr uint BranchCount = 64;
+        const auto output = [&editor](int nodeId) {return editor.GetNode(nodeId)->AttributesOut()[0].ID;};
+        const auto input = [&editor](int nodeId, uint i) {return editor.GetNode(nodeId)->AttributesIn()[i].ID;};
+        const MessageSeverity threshold = Logger::GetThreshold();
+        Logger::SetThreshold(Warning);
+
+        ImGui::NewFrame();
+        vector<int> ends;
+        for (uint branch = 0; branch < BranchCount; ++branch)
+        {
+            int previous = editor.AddNode(NodeTypeFlat::NumericConstant, ImVec2(0.0f, 0.0f));
+            sources.push_back(static_cast<NodeNumericConstant*>(editor.GetNode(previous)));
+            for (uint i = 0; i < branchLength; ++i)
+            {
+                const int math = editor.AddNode((i % 2 == 0) ? NodeTypeFlat::NumericMultiply : NodeTypeFlat::NumericAdd,
+                                                ImVec2(0.0f, 0.0f));
+                editor.AddLink(output(previous), input(math, 0));
+                previous = math;
+            }
+            ends.push_back(previous);
+        }
+        while (ends.size() > 1)
+        {
+            vector<int> merged;
+            for (size_t i = 0; i < ends.size(); i += 2)
+            {
+                const int add = editor.AddNode(NodeTypeFlat::NumericAdd, ImVec2(0.0f, 0.0f));
+                editor.AddLink(output(ends[i]), input(add, 0));
+                editor.AddLink(output(ends[i + 1]), input(add, 1));
+                merged.push_back(add);
+            }
+            ends.swap(merged);
+        }
+        ImGui::EndFrame();
+        FrameArena::EndFrame();
+        Logger::SetThreshold(threshold);
+    }
+
+    // the whole branching graph of about 10k nodes re-evaluated, serially without a job system or across its threads
+    void EvaluateBranchingGraph(BenchState& state, JobSystem* pJobSystem)
+    {
+        HeadlessImGui imgui;
+        NodeEditor editor;
+        vector<NodeNumericConstant*> sources;
+        AddBranchingGraph(editor, 156, sources);
+        NodeEvaluator& evaluator = editor.GetEvaluator();
+        evaluator.Evaluate();
+        state.SetItemsPerIteration(evaluator.GetNodeCount());
+
+        while (state.KeepRunning())
+        {
+            for (NodeNumericConstant* pSource : sources) pSource->SetValue(pSource->Value() + 1.0f);
+            BenchDoNotOptimize(pJobSystem ? evaluator.EvaluateParallel(*pJobSystem) : evaluator.Evaluate());
+        }
+    }
+
+    void NodeGraphEvaluateScaling(BenchState& state, uint threadCount)
+    {
+        if (threadCount > thread::hardware_concurrency())
+        {
+            state.Skip("more threads than the machine has");
+            return;
+        }
+
+        JobSystem jobSystem(threadCount);
+        EvaluateBranchingGraph(state, &jobSystem);
+    }
+
+    // a directory of a few hundred entries, created once and removed when the benchmarks exit
+    class ScanFixture
+    {
+    public:
+        static constexpr uint DirectoryCount = 32;
+        static constexpr uint FileCount = 480;
+
+        ScanFixture() : m_path(filesystem::temp_directory_path() / "shade_bench_scan")
+        {
+            filesystem::remove_all(m_path);
+            filesystem::create_directories(m_path);
+            for (uint i = 0; i < DirectoryCount; ++i) filesystem::create_directory(m_path / fmt::format("directory_{:03}", i));
+            for (uint i = 0; i < FileCount; ++i) ofstream(m_path / fmt::format("file_{:03}.ply", i)) << i;
+        }
+        ~ScanFixture()
+        {
+            error_code error;
+            filesystem::remove_all(m_path, error);
+        }
+
+        const filesystem::path& GetPath() const {return m_path;}
+
+    private:
+        filesystem::path m_path;
+    };
+
+    constexpr uint ShaderBatchSize = 8;
+
+    vector<ShaderCompileRequest> ShaderBatchRequests(vector<Shader>& shaders)
+    {
+        vector<ShaderCompileRequest> requests;
+        for (uint i = 0; i < shaders.size(); ++i)
+        {
+            const bool vertex = (i % 2) == 0;
+            requests.push_back({&shaders[i], ShaderFilename, vertex ? "VSMain" : "PSMain", vertex ? "vs_6_0" : "ps_6_0",
+                                {fmt::format("SHADE_BENCH_VARIANT={}", i / 2)}});
+        }
+        return requests;
+    }
+
+    // the shared shader cache moved to an empty directory of its own, so benchmarks neither see nor disturb its entries
+    class ScopedShaderCache
+    {
+    public:
+        ScopedShaderCache(bool enabled) :
+            m_previousDirectory(ShaderCache::Get().GetDirectory()),
+            m_previousEnabled(ShaderCache::Get().IsEnabled())
+        {
+            ShaderCache& cache = ShaderCache::Get();
+            cache.SetDirectory(filesystem::temp_directory_path() / "shade_bench_shader_cache");
+            cache.Clear();
+            cache.SetEnabled(enabled);
+        }
+        ~ScopedShaderCache()
+        {
+            ShaderCache& cache = ShaderCache::Get();
+            cache.Clear();
+            cache.SetDirectory(m_previousDirectory);
+            cache.SetEnabled(m_previousEnabled);
+        }
+
+    private:
+        filesystem::path    m_previousDirectory;
+        bool                m_previousEnabled;
+    };
+}
+
+
+//**********************************************************************************************************************
+//                                                      Geometry
+//**********************************************************************************************************************
+BENCHMARK(MeshLoadFromFile)
+{
+    if (!filesystem::exists(MeshFilename)) return state.Skip(fmt::format("{} not found", MeshFilename));
+
+    while (state.KeepRunning())
+    {
+        Mesh mesh;
+        BenchDoNotOptimize(mesh.LoadFromFile(MeshFilename));
+    }
+}
+
+BENCHMARK(MeshPopulateGeometryBuffer)
+{
+    if (!filesystem::exists(MeshFilename)) return state.Skip(fmt::format("{} not found", MeshFilename));
+
+    // vertices, colors and faces, as laid out for the geometry manager's upload buffer
+    Mesh mesh(MeshFilename);
+    const uint streams = (1u << VertexStreamPosition) | (1u << VertexStreamColor);
+    vector<UINT8> buffer(mesh.GetGeometryBufferSize(streams));
+    state.SetBytesPerIteration(buffer.size());
+
+    while (state.KeepRunning())
+    {
+        BenchDoNotOptimize(mesh.PopulateGeometryBuffer(buffer.data(), streams));
+        BenchDoNotOptimize(buffer);
+    }
+}
+
+// per-object transforms rebuilt and stored transposed, as into a constant buffer every frame
+BENCHMARK(TransformDataUpdate)
+{
+    constexpr uint ObjectCount = 1024;
+    vector<TransformData> transforms(ObjectCount);
+    vector<XMFLOAT4X4> constants(ObjectCount);
+    for (uint i = 0; i < ObjectCount; ++i)
+    {
+        transforms[i].translation = XMFLOAT3(float(i % 32), float(i / 32), 0.0f);
+        transforms[i].scale = XMFLOAT3(1.0f + i * 0.001f, 1.0f, 1.0f);
+    }
+    state.SetItemsPerIteration(ObjectCount);
+
+    while (state.KeepRunning())
+    {
+        for (uint i = 0; i < ObjectCount; ++i)
+        {
+            transforms[i].rotation.y += 0.001f;
+            transforms[i].matrixDirty = true;
+            transforms[i].StoreTransformMatrixT(&constants[i]);
+        }
+        BenchDoNotOptimize(constants);
+    }
+}
+
+// view and projection matrices of a moving camera, as ShaderToyScene::OnUpdate() does each frame
+BENCHMARK(CameraMatrices)
+{
+    Camera camera;
+    camera.SetPosition({0, 5, -45});
+    camera.SetDirection({0, 0, 1});
+    XMFLOAT4X4 view;
+    XMFLOAT4X4 projection;
+
+    while (state.KeepRunning())
+    {
+        camera.Rotate(0.0f, 0.001f, 0.0f);
+        camera.Update();
+        XMStoreFloat4x4(&view, XMMatrixTranspose(camera.GetViewMatrix()));
+        XMStoreFloat4x4(&projection, XMMatrixTranspose(camera.GetProjectionMatrix()));
+        BenchDoNotOptimize(view);
+        BenchDoNotOptimize(projection);
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                      Shaders
+//**********************************************************************************************************************
+BENCHMARK(ShaderCompileVertex)
+{
+    if (!filesystem::exists(ShaderFilename)) return state.Skip(fmt::format("{} not found", ShaderFilename));
+
+    // the compiler is a shared library on Linux, which may not be installed next to the benchmarks
+    ComPtr<IDxcCompiler3> pCompiler;
+    if (FAILED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&pCompiler)))) return state.Skip("DXC is unavailable");
+
+    ScopedShaderCache cache(false);
+    Shader shader;
+    while (state.KeepRunning())
+    {
+        BenchDoNotOptimize(shader.Compile(ShaderFilename, "VSMain", "vs_6_0"));
+    }
+}
+
+BENCHMARK(ShaderCompilePixel)
+{
+    if (!filesystem::exists(ShaderFilename)) return state.Skip(fmt::format("{} not found", ShaderFilename));
+
+    ComPtr<IDxcCompiler3> pCompiler;
+    if (FAILED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&pCompiler)))) return state.Skip("DXC is unavailable");
+
+    ScopedShaderCache cache(false);
+    Shader shader;
+    while (state.KeepRunning())
+    {
+        BenchDoNotOptimize(shader.Compile(ShaderFilename, "PSMain", "ps_6_0"));
+    }
+}
+
+BENCHMARK(ShaderCompileCached)
+{
+    if (!filesystem::exists(ShaderFilename)) return state.Skip(fmt::format("{} not found", ShaderFilename));
+
+    ComPtr<IDxcCompiler3> pCompiler;
+    if (FAILED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&pCompiler)))) return state.Skip("DXC is unavailable");
+
+    // a warm start, the shader having been compiled into the cache once beforehand
+    ScopedShaderCache cache(true);
+    Shader shader;
+    shader.Compile(ShaderFilename, "VSMain", "vs_6_0");
+    while (state.KeepRunning())
+    {
+        BenchDoNotOptimize(shader.Compile(ShaderFilename, "VSMain", "vs_6_0"));
+    }
+    if (!shader.WasCached()) state.Skip("the shader was not cached");
+}
+
+// both entry points in a few variants each, as a startup compiling a scene's shaders would, one after another and then
+//  as one batch across the job system
+BENCHMARK(ShaderCompileSerial)
+{
+    if (!filesystem::exists(ShaderFilename)) return state.Skip(fmt::format("{} not found", ShaderFilename));
+
+    ComPtr<IDxcCompiler3> pCompiler;
+    if (FAILED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&pCompiler)))) return state.Skip("DXC is unavailable");
+
+    ScopedShaderCache cache(false);
+    vector<Shader> shaders(ShaderBatchSize);
+    const vector<ShaderCompileRequest> requests = ShaderBatchRequests(shaders);
+    state.SetItemsPerIteration(ShaderBatchSize);
+    while (state.KeepRunning())
+    {
+        for (const ShaderCompileRequest& request : requests)
+        {
+            const HRESULT result = request.pShader->Compile(request.filename, request.entry, request.target,
+                                                            request.defines);
+            BenchDoNotOptimize(result);
+        }
+    }
+}
+
+BENCHMARK(ShaderCompileBatch)
+{
+    if (!filesystem::exists(ShaderFilename)) return state.Skip(fmt::format("{} not found", ShaderFilename));
+
+    ComPtr<IDxcCompiler3> pCompiler;
+    if (FAILED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&pCompiler)))) return state.Skip("DXC is unavailable");
+
+    ScopedShaderCache cache(false);
+    vector<Shader> shaders(ShaderBatchSize);
+    const vector<ShaderCompileRequest> requests = ShaderBatchRequests(shaders);
+    state.SetItemsPerIteration(ShaderBatchSize);
+    while (state.KeepRunning())
+    {
+        for (future<HRESULT>& result : Shader::CompileBatch(requests)) BenchDoNotOptimize(result.get());
+    }
+}
+
+// what a pipeline pays each frame to find its permutation, once compiled
+BENCHMARK(ShaderPermutationRequest)
+{
+    if (!filesystem::exists(ShaderFilename)) return state.Skip(fmt::format("{} not found", ShaderFilename));
+
+    ComPtr<IDxcCompiler3> pCompiler;
+    if (FAILED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&pCompiler)))) return state.Skip("DXC is unavailable");
+
+    ScopedShaderCache cache(false);
+    ShaderPermutations permutations;
+    const vector<ShaderStageDesc> stages = {{ShaderFilename, "VSMain", "vs_6_0"}, {ShaderFilename, "PSMain", "ps_6_0"}};
+    if (FAILED(permutations.Init(stages, {"VISUALIZE_DEPTH"}))) return state.Skip("the shaders failed to compile");
+
+    const ShaderPermutationKey key = permutations.GetKeywordMask("VISUALIZE_DEPTH");
+    const auto deadline = chrono::steady_clock::now() + chrono::seconds(10);
+    while (permutations.Request(key) == nullptr)
+    {
+        if (chrono::steady_clock::now() > deadline) return state.Skip("the permutation did not compile");
+        this_thread::sleep_for(chrono::milliseconds(1));
+    }
+    while (state.KeepRunning())
+    {
+        BenchDoNotOptimize(permutations.Request(key));
+    }
+}
+
+// what the shader costs panel pays for each shader compiled, disassembly included
+BENCHMARK(ShaderAnalyze)
+{
+    if (!filesystem::exists(ShaderFilename)) return state.Skip(fmt::format("{} not found", ShaderFilename));
+
+    ComPtr<IDxcCompiler3> pCompiler;
+    if (FAILED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&pCompiler)))) return state.Skip("DXC is unavailable");
+
+    ScopedShaderCache cache(false);
+    Shader shader;
+    if (FAILED(shader.Compile(ShaderFilename, "VSMain", "vs_6_0"))) return state.Skip("the shader failed to compile");
+    while (state.KeepRunning())
+    {
+        ShaderCost cost;
+        BenchDoNotOptimize(ShaderAnalysis::Analyze(shader.GetBlob(), cost));
+        BenchDoNotOptimize(cost);
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                      UI
+//**********************************************************************************************************************
+// a frame of the node editor holding a graph of a few dozen nodes, as drawn by ShaderToyScene
+BENCHMARK(NodeEditorUpdate)
+{
+    constexpr uint NodeCount = 64;
+    HeadlessImGui imgui;
+    NodeEditor editor;
+
+    ImGui::NewFrame();
+    for (uint i = 0; i < NodeCount; ++i)
+    {
+        const NodeTypeFlat type = (i % 4 == 0) ? NodeTypeFlat::Null : NodeTypeFlat::NumericConstant;
+        editor.AddNode(type, ImVec2(float(i % 8) * 160.0f, float(i / 8) * 120.0f));
+    }
+    ImGui::EndFrame();
+    state.SetItemsPerIteration(NodeCount);
+
+    while (state.KeepRunning())
+    {
+        ImGui::NewFrame();
+        editor.Update();
+        editor.Draw();
+        ImGui::Render();
+        BenchDoNotOptimize(ImGui::GetDrawData());
+        FrameArena::EndFrame();
+    }
+}
+
+// Building a graph of 100k nodes, each link resolving its attributes and nodes by ID, as loading a large graph does
+BENCHMARK(NodeGraphBuild100k)
+{
+    constexpr uint BranchLength = 1562;
+    state.SetItemsPerIteration(64 * (BranchLength + 1) + 63);
+
+    while (state.KeepRunning())
+    {
+        HeadlessImGui imgui;
+        NodeEditor editor;
+        vector<NodeNumericConstant*> sources;
+        AddBranchingGraph(editor, BranchLength, sources);
+        BenchDoNotOptimize(editor.GetNodeCount());
+    }
+}
+
+// a frame of the node editor holding 100k nodes, without edits, so what it costs is drawing and its lists
+BENCHMARK(NodeEditorUpdate100k)
+{
+    constexpr uint BranchLength = 1562;
+    HeadlessImGui imgui;
+    NodeEditor editor;
+    vector<NodeNumericConstant*> sources;
+    AddBranchingGraph(editor, BranchLength, sources);
+    editor.GetEvaluator().Evaluate();
+    state.SetItemsPerIteration(editor.GetNodeCount());
+
+    while (state.KeepRunning())
+    {
+        ImGui::NewFrame();
+        editor.Update();
+        editor.Draw();
+        ImGui::Render();
+        BenchDoNotOptimize(ImGui::GetDrawData());
+        FrameArena::EndFrame();
+    }
+}
+
+// Loading a saved graph of 100k nodes into an empty editor, with the file mapped and its nodes linked in topological
+//  order, timing only the load
+BENCHMARK(NodeGraphLoad100k)
+{
+    constexpr uint BranchLength = 1562;
+    const filesystem::path path = filesystem::temp_directory_path() / "shade_bench_graph.bin";
+    {
+        HeadlessImGui imgui;
+        NodeEditor editor;
+        vector<NodeNumericConstant*> sources;
+        AddBranchingGraph(editor, BranchLength, sources);
+        if (!editor.SaveGraph(path)) return state.Skip("the graph could not be saved");
+        state.SetItemsPerIteration(editor.GetNodeCount());
+    }
+    const MessageSeverity threshold = Logger::GetThreshold();
+    Logger::SetThreshold(Warning);
+
+    while (state.KeepRunning())
+    {
+        state.PauseTiming();
+        HeadlessImGui imgui;
+        NodeEditor editor;
+        ImGui::NewFrame();
+        state.ResumeTiming();
+        BenchDoNotOptimize(editor.LoadGraph(path));
+        state.PauseTiming();
+        ImGui::EndFrame();
+        FrameArena::EndFrame();
+    }
+    Logger::SetThreshold(threshold);
+
+    error_code error;
+    filesystem::remove(path, error);
+}
+
+// An autosave of a 100k node graph after editing one constant, which appends only the chunk of the file holding it
+BENCHMARK(NodeGraphAutosave100k)
+{
+    constexpr uint BranchLength = 1562;
+    const filesystem::path path = filesystem::temp_directory_path() / "shade_bench_graph.bin";
+    HeadlessImGui imgui;
+    NodeEditor editor;
+    vector<NodeNumericConstant*> sources;
+    AddBranchingGraph(editor, BranchLength, sources);
+    if (!editor.SaveGraph(path)) return state.Skip("the graph could not be saved");
+    state.SetItemsPerIteration(editor.GetNodeCount());
+
+    while (state.KeepRunning())
+    {
+        sources[0]->SetValue(sources[0]->Value() + 1.0f);
+        BenchDoNotOptimize(editor.SaveGraph(path));
+    }
+
+    error_code error;
+    filesystem::remove(path, error);
+}
+
+// Compiling a chain of arithmetic mixing system values and constants into HLSL, which the editor does on every edit.
+//  The repeated constants and system values are each numbered to a single instruction.
+BENCHMARK(NodeGraphCompile)
+{
+    constexpr uint MathCount = 64;
+    HeadlessImGui imgui;
+    NodeEditor editor;
+
+    ImGui::NewFrame();
+    AddArithmeticChain(editor, MathCount);
+    ImGui::EndFrame();
+    FrameArena::EndFrame();
+    state.SetItemsPerIteration(MathCount);
+
+    while (state.KeepRunning())
+    {
+        BenchDoNotOptimize(editor.CompileGraph());
+        BenchDoNotOptimize(editor.GetGeneratedCode().size());
+    }
+}
+
+// the same graph as bytecode over a million lanes, as CPU-side procedural geometry would run it per vertex
+BENCHMARK(NodeProgramRun)
+{
+    constexpr uint MathCount = 64;
+    constexpr uint LaneCount = 1 << 20;
+    HeadlessImGui imgui;
+    NodeEditor editor;
+
+    ImGui::NewFrame();
+    AddArithmeticChain(editor, MathCount);
+    ImGui::EndFrame();
+    FrameArena::EndFrame();
+    editor.CompileGraph();
+
+    vector<float> pixelX(LaneCount);
+    for (uint i = 0; i < LaneCount; ++i) pixelX[i] = float(i % 1920);
+    vector<float> channels(size_t(LaneCount) * 4);
+    const float* inputs[magic_enum::enum_count<NodeSystemValue>()] = {pixelX.data()};
+    float* outputs[] = {&channels[0], &channels[LaneCount], &channels[LaneCount * 2], &channels[LaneCount * 3]};
+    NodeProgram::Scratch scratch;
+    state.SetItemsPerIteration(LaneCount);
+
+    while (state.KeepRunning())
+    {
+        editor.GetProgram().Run(inputs, outputs, LaneCount, scratch);
+        BenchDoNotOptimize(channels.data());
+    }
+}
+
+// Editing a constant near the end of one of many chains of arithmetic, which re-evaluates only the few nodes it feeds
+//  out of a graph of thousands.
+BENCHMARK(NodeGraphEvaluateEdit)
+{
+    constexpr uint ChainCount = 64;
+    constexpr uint ChainLength = 64;
+    HeadlessImGui imgui;
+    NodeEditor editor;
+
+    ImGui::NewFrame();
+    vector<NodeNumericConstant*> edited;
+    for (uint chain = 0; chain < ChainCount; ++chain)
+    {
+        int previous = editor.AddNode(NodeTypeFlat::NumericConstant, ImVec2(0.0f, 0.0f));
+        for (uint i = 0; i < ChainLength; ++i)
+        {
+            const int add = editor.AddNode(NodeTypeFlat::NumericAdd, ImVec2(0.0f, 0.0f));
+            const int operand = editor.AddNode(NodeTypeFlat::NumericConstant, ImVec2(0.0f, 0.0f));
+            editor.AddLink(editor.GetNode(previous)->AttributesOut()[0].ID, editor.GetNode(add)->AttributesIn()[0].ID);
+            editor.AddLink(editor.GetNode(operand)->AttributesOut()[0].ID, editor.GetNode(add)->AttributesIn()[1].ID);
+            if (i == ChainLength - 4) edited.push_back(static_cast<NodeNumericConstant*>(editor.GetNode(operand)));
+            previous = add;
+        }
+    }
+    ImGui::EndFrame();
+    FrameArena::EndFrame();
+    editor.GetEvaluator().Evaluate();
+
+    uint iteration = 0;
+    while (state.KeepRunning())
+    {
+        NodeNumericConstant* pConstant = edited[iteration++ % ChainCount];
+        pConstant->SetValue(pConstant->Value() + 1.0f);
+        BenchDoNotOptimize(editor.GetEvaluator().Evaluate());
+    }
+}
+
+// every node of a graph of about 10k re-evaluated, its independent branches on as many threads as the job system has
+BENCHMARK(NodeGraphEvaluateSerial)     {EvaluateBranchingGraph(state, nullptr);}
+BENCHMARK(NodeGraphEvaluate1Thread)    {NodeGraphEvaluateScaling(state, 1);}
+BENCHMARK(NodeGraphEvaluate2Threads)   {NodeGraphEvaluateScaling(state, 2);}
+BENCHMARK(NodeGraphEvaluate4Threads)   {NodeGraphEvaluateScaling(state, 4);}
+BENCHMARK(NodeGraphEvaluate8Threads)   {NodeGraphEvaluateScaling(state, 8);}
+BENCHMARK(NodeGraphEvaluate16Threads)  {NodeGraphEvaluateScaling(state, 16);}
+
+// the file picker's refresh of a directory listing
+BENCHMARK(FilePickerScanDirectory)
+{
+    static ScanFixture fixture;
+    vector<filesystem::directory_entry> directories;
+    vector<filesystem::directory_entry> files;
+    state.SetItemsPerIteration(ScanFixture::DirectoryCount + ScanFixture::FileCount);
+
+    while (state.KeepRunning())
+    {
+        ScanDirectory(fixture.GetPath(), directories, files);
+        BenchDoNotOptimize(files);
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                  Frame Temporaries
+//**********************************************************************************************************************
+// labels and attribute lists of a frame's worth of nodes, as the node editor builds them, from the heap
+BENCHMARK(FrameTemporariesHeap)
+{
+    constexpr uint NodeCount = 64;
+    state.SetItemsPerIteration(NodeCount);
+
+    while (state.KeepRunning())
+    {
+        for (uint i = 0; i < NodeCount; ++i)
+        {
+            const string title = fmt::format("{}| {}", i, "Numeric Constant");
+            const vector<int> attributes = {int(i * 2), int(i * 2 + 1)};
+            BenchDoNotOptimize(title);
+            BenchDoNotOptimize(attributes);
+        }
+    }
+}
+
+// the same from the frame arena, ending a frame every iteration
+BENCHMARK(FrameTemporariesArena)
+{
+    constexpr uint NodeCount = 64;
+    state.SetItemsPerIteration(NodeCount);
+
+    while (state.KeepRunning())
+    {
+        for (uint i = 0; i < NodeCount; ++i)
+        {
+            const FrameString title = FrameFormat("{}| {}", i, "Numeric Constant");
+            const FrameVector<int> attributes({int(i * 2), int(i * 2 + 1)}, FrameArena::Resource());
+            BenchDoNotOptimize(title);
+            BenchDoNotOptimize(attributes);
+        }
+        FrameArena::EndFrame();
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                      Logging
+//**********************************************************************************************************************
+// a formatted message with a severity tag, written to a log nobody reads (the null device, outside Windows)
+BENCHMARK(PrintMessageFormatted)
+{
+    uint frame = 0;
+    while (state.KeepRunning())
+    {
+        PrintMessage(Info, "Frame {} took {:.3f}ms across {} draws on \"{}\"", frame++, 16.667, 128, "Simple Scene");
+    }
+}
+
+// the same message through the deferred logger, which only copies its arguments on the calling thread
+BENCHMARK(LogInfoDeferred)
+{
+    uint frame = 0;
+    while (state.KeepRunning())
+    {
+        LOG_INFO("Frame {} took {:.3f}ms across {} draws on \"{}\"", frame++, 16.667, 128, "Simple Scene");
+    }
+}
+
+// a message below the runtime threshold, which costs only the check
+BENCHMARK(LogFilteredOut)
+{
+    const MessageSeverity threshold = Logger::GetThreshold();
+    Logger::SetThreshold(Warning);
+
+    uint frame = 0;
+    while (state.KeepRunning())
+    {
+        LOG_INFO("Frame {} took {:.3f}ms across {} draws on \"{}\"", frame++, 16.667, 128, "Simple Scene");
+    }
+    Logger::SetThreshold(threshold);
+}
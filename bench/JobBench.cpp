@@ -0,0 +1,141 @@
+// Scheduling overhead and scaling of the job system. The overhead benchmarks run empty jobs on the shared pool, so they
+//  measure only allocation, queueing, stealing and completion. The scaling benchmarks run the same parallel loop on
+//  pools of increasing size, against a plain loop on the calling thread.
+#include <cmath>
+#include <memory>
+#include <vector>
+
+#include "Bench.h"
+#include "JobSystem.h"
+
+using namespace std;
+
+
+namespace
+{
+    constexpr uint FanOutJobs       = 1024;
+    constexpr uint ChainLength      = 256;
+    constexpr uint LoopCount        = 1 << 16;
+
+    // a few hundred nanoseconds of arithmetic, about the cost of transforming a small batch of vertices
+    float Work(uint index)
+    {
+        float value = static_cast<float>(index);
+        for (uint i = 0; i < 64; ++i) value = sqrtf(value * 1.0001f + 1.0f);
+        return value;
+    }
+
+    void ParallelForScaling(BenchState& state, uint threadCount)
+    {
+        if (threadCount > thread::hardware_concurrency())
+        {
+            state.Skip("more threads than the machine has");
+            return;
+        }
+
+        JobSystem jobSystem(threadCount);
+        vector<float> results(LoopCount);
+        state.SetItemsPerIteration(LoopCount);
+
+        while (state.KeepRunning())
+        {
+            jobSystem.ParallelFor(LoopCount, [&](uint index) {results[index] = Work(index);});
+            BenchDoNotOptimize(results);
+        }
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                  Scheduling Overhead
+//**********************************************************************************************************************
+BENCHMARK(JobSubmitWait)
+{
+    JobSystem& jobSystem = JobSystem::Get();
+
+    while (state.KeepRunning())
+    {
+        Job* pJob = jobSystem.CreateJob([] {});
+        jobSystem.Submit(pJob);
+        jobSystem.Wait(pJob);
+    }
+}
+
+BENCHMARK(JobFanOut)
+{
+    JobSystem& jobSystem = JobSystem::Get();
+    state.SetItemsPerIteration(FanOutJobs);
+
+    while (state.KeepRunning())
+    {
+        Job* pRoot = jobSystem.CreateEmptyJob();
+        for (uint i = 0; i < FanOutJobs; ++i)
+        {
+            jobSystem.Submit(jobSystem.CreateJob([] {}, pRoot));
+        }
+        jobSystem.Submit(pRoot);
+        jobSystem.Wait(pRoot);
+    }
+}
+
+BENCHMARK(JobDependencyChain)
+{
+    JobSystem& jobSystem = JobSystem::Get();
+    vector<Job*> jobs(ChainLength);
+    state.SetItemsPerIteration(ChainLength);
+
+    while (state.KeepRunning())
+    {
+        for (uint i = 0; i < ChainLength; ++i)
+        {
+            jobs[i] = jobSystem.CreateJob([] {});
+            if (i > 0) jobSystem.AddDependency(jobs[i], jobs[i - 1]);
+        }
+
+        // submitted last to first, so each job is queued by its prerequisite finishing rather than by submission
+        for (uint i = ChainLength; i-- > 0;)
+        {
+            jobSystem.Submit(jobs[i]);
+        }
+        jobSystem.Wait(jobs.back());
+    }
+}
+
+BENCHMARK(JobMainThreadRoundTrip)
+{
+    // a worker job handing its result to a main thread job, as an API call after a background load would
+    JobSystem& jobSystem = JobSystem::Get();
+
+    while (state.KeepRunning())
+    {
+        Job* pRoot = jobSystem.CreateEmptyJob();
+        jobSystem.Submit(jobSystem.CreateJob([&jobSystem, pRoot]
+        {
+            jobSystem.Submit(jobSystem.CreateMainThreadJob([] {}, pRoot));
+        }, pRoot));
+        jobSystem.Submit(pRoot);
+        jobSystem.Wait(pRoot);
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                   Parallel For
+//**********************************************************************************************************************
+BENCHMARK(ParallelForSerial)
+{
+    vector<float> results(LoopCount);
+    state.SetItemsPerIteration(LoopCount);
+
+    while (state.KeepRunning())
+    {
+        for (uint i = 0; i < LoopCount; ++i) results[i] = Work(i);
+        BenchDoNotOptimize(results);
+    }
+}
+
+BENCHMARK(ParallelFor1Thread)   {ParallelForScaling(state, 1);}
+BENCHMARK(ParallelFor2Threads)  {ParallelForScaling(state, 2);}
+BENCHMARK(ParallelFor4Threads)  {ParallelForScaling(state, 4);}
+BENCHMARK(ParallelFor8Threads)  {ParallelForScaling(state, 8);}
+BENCHMARK(ParallelFor16Threads) {ParallelForScaling(state, 16);}
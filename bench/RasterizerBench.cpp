@@ -0,0 +1,202 @@
+// Measures software rasterizer throughput in triangles per second, on the teapot used by the default scene and on
+//  generated scenes of around a million triangles. Each scene is drawn at every requested thread count.
+//
+// usage: RasterizerBench [--frames N] [--size S] [--threads T]
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "backends/SoftwareRasterizer.h"
+#include "Camera.h"
+#include "Mesh.h"
+
+using namespace std;
+
+
+struct BenchScene
+{
+    std::string             name;
+    std::vector<XMFLOAT3>   positions;
+    std::vector<XMFLOAT4>   colors;
+    std::vector<uint>       indices;
+    XMFLOAT4X4              modelViewProjection;
+};
+
+static BenchScene LoadTeapot()
+{
+    BenchScene scene;
+    scene.name = "teapot";
+
+    Mesh mesh("./media/rotated_teapot.ply");
+    const uint vertexCount = mesh.GetNumVertices();
+    const uint faceCount = mesh.GetNumFaces();
+
+    // same layout the geometry manager uploads
+    const uint streams = (1u << VertexStreamPosition) | (1u << VertexStreamColor);
+    std::vector<UINT8> buffer(mesh.GetGeometryBufferSize(streams));
+    const MeshBufferLayout layout = mesh.PopulateGeometryBuffer(buffer.data(), streams);
+
+    scene.positions.resize(vertexCount);
+    scene.colors.resize(vertexCount);
+    scene.indices.resize(faceCount * 3);
+    memcpy(scene.positions.data(), buffer.data() + layout.vertexOffset, layout.vertexSize);
+    memcpy(scene.colors.data(), buffer.data() + layout.colorOffset, layout.colorSize);
+    memcpy(scene.indices.data(), buffer.data() + layout.facesOffset, layout.facesSize);
+
+    // the default scene's camera
+    Camera camera;
+    camera.SetPosition({0, 5, -45});
+    camera.SetDirection({0, 0, 1});
+    camera.Update();
+    XMStoreFloat4x4(&scene.modelViewProjection, camera.GetViewMatrix() * camera.GetProjectionMatrix());
+
+    return scene;
+}
+
+// a screen-filling grid, many triangles being smaller than a pixel, which stresses setup and binning
+static BenchScene GenerateGrid(uint cells)
+{
+    BenchScene scene;
+    scene.name = fmt::format("grid {}", cells * cells * 2);
+
+    for (uint y = 0; y <= cells; ++y)
+    {
+        for (uint x = 0; x <= cells; ++x)
+        {
+            const float u = float(x) / cells;
+            const float v = float(y) / cells;
+            scene.positions.push_back({u * 2.0f - 1.0f, 1.0f - v * 2.0f, 0.5f});
+            scene.colors.push_back({u, v, 1.0f - u, 1.0f});
+        }
+    }
+    for (uint y = 0; y < cells; ++y)
+    {
+        for (uint x = 0; x < cells; ++x)
+        {
+            const uint i = y * (cells + 1) + x;
+            scene.indices.insert(scene.indices.end(), {i, i + 1, i + cells + 1});
+            scene.indices.insert(scene.indices.end(), {i + 1, i + cells + 2, i + cells + 1});
+        }
+    }
+
+    XMStoreFloat4x4(&scene.modelViewProjection, XMMatrixIdentity());
+    return scene;
+}
+
+// randomly placed small triangles at varying depths, which stresses depth testing and overdraw
+static BenchScene GenerateScatter(uint triangleCount)
+{
+    BenchScene scene;
+    scene.name = fmt::format("scatter {}", triangleCount);
+
+    mt19937 generator(1234);
+    uniform_real_distribution<float> position(-20.0f, 20.0f);
+    uniform_real_distribution<float> depth(10.0f, 60.0f);
+    uniform_real_distribution<float> offset(-0.5f, 0.5f);
+    uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    for (uint i = 0; i < triangleCount; ++i)
+    {
+        const XMFLOAT3 center = {position(generator), position(generator), depth(generator)};
+        const XMFLOAT4 color = {unit(generator), unit(generator), unit(generator), 1.0f};
+        for (uint j = 0; j < 3; ++j)
+        {
+            scene.positions.push_back({center.x + offset(generator), center.y + offset(generator), center.z + offset(generator)});
+            scene.colors.push_back(color);
+            scene.indices.push_back(i * 3 + j);
+        }
+    }
+
+    const XMMATRIX view = XMMatrixLookToLH(XMVectorSet(0, 0, 0, 1), XMVectorSet(0, 0, 1, 0), XMVectorSet(0, 1, 0, 0));
+    const XMMATRIX projection = XMMatrixPerspectiveFovLH(XM_PIDIV4, 1.0f, 0.1f, 100.0f);
+    XMStoreFloat4x4(&scene.modelViewProjection, view * projection);
+    return scene;
+}
+
+static void RunScene(const BenchScene& scene, uint size, uint frameCount, uint threadCount)
+{
+    SoftwareRasterizer rasterizer(threadCount);
+
+    std::vector<uint32_t> color(size * size);
+    std::vector<float> depth(size * size);
+    const RasterTarget target = {color.data(), depth.data(), size, size, size, size};
+
+    RasterState state = {};
+    state.viewport              = {0.0f, 0.0f, float(size), float(size), 0.0f, 1.0f};
+    state.scissorRect           = {0, 0, LONG(size), LONG(size)};
+    state.cullMode              = D3D12_CULL_MODE_NONE;     // generated scenes have mixed winding
+    state.depthEnable           = true;
+    state.depthWrite            = true;
+    state.depthFunc             = D3D12_COMPARISON_FUNC_LESS;
+
+    RasterDraw draw = {};
+    draw.pPositions             = reinterpret_cast<const UINT8*>(scene.positions.data());
+    draw.positionStride         = sizeof(XMFLOAT3);
+    draw.positionComponents     = 3;
+    draw.pColors                = reinterpret_cast<const UINT8*>(scene.colors.data());
+    draw.colorStride            = sizeof(XMFLOAT4);
+    draw.colorComponents        = 4;
+    draw.vertexCount            = static_cast<uint>(scene.positions.size());
+    draw.pIndices               = scene.indices.data();
+    draw.indexCount             = static_cast<uint>(scene.indices.size());
+    draw.modelViewProjection    = scene.modelViewProjection;
+
+    const float clearColor[4] = {0.0f, 0.2f, 0.4f, 1.0f};
+    const auto DrawFrame = [&]()
+    {
+        rasterizer.ClearColor(target, clearColor);
+        rasterizer.ClearDepth(target, 1.0f);
+        rasterizer.Draw(target, state, draw);
+    };
+
+    // warm up so that working memory has grown to its steady state
+    DrawFrame();
+    rasterizer.ResetStats();
+
+    const auto start = chrono::steady_clock::now();
+    for (uint frame = 0; frame < frameCount; ++frame)
+    {
+        DrawFrame();
+    }
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    const RasterStats& stats = rasterizer.GetStats();
+    PrintMessage("{:<16} {:>3} threads {:>9.3f}ms/frame {:>9.2f}M tris/s ({} rasterized, {} culled, {} clipped per frame)\n",
+                 scene.name, rasterizer.GetThreadCount(), seconds * 1000.0 / frameCount,
+                 stats.trianglesSubmitted / seconds / 1.0e6,
+                 stats.trianglesRasterized / frameCount, stats.trianglesCulled / frameCount, stats.trianglesClipped / frameCount);
+}
+
+int main(int argc, char** argv)
+{
+    uint frameCount = 20;
+    uint size = 800;
+    uint maxThreads = max(1u, thread::hardware_concurrency());
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if      (strcmp(argv[i], "--frames") == 0)  frameCount = max(1, atoi(argv[i + 1]));
+        else if (strcmp(argv[i], "--size") == 0)    size = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--threads") == 0) maxThreads = max(1, atoi(argv[i + 1]));
+    }
+
+    const std::vector<BenchScene> scenes =
+    {
+        LoadTeapot(),
+        GenerateGrid(708),          // ~1M triangles
+        GenerateScatter(1000000),
+    };
+
+    for (const BenchScene& scene : scenes)
+    {
+        // single-threaded baseline, then doubling up to the requested maximum
+        for (uint threads = 1; ; threads = min(threads * 2, maxThreads))
+        {
+            RunScene(scene, size, frameCount, threads);
+            if (threads == maxThreads) break;
+        }
+    }
+
+    return 0;
+}
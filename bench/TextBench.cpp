@@ -0,0 +1,125 @@
+// Throughput of UTF-8 transcoding, against the std::wstring_convert it replaced. Each pair converts the same text, once
+//  shader source as nearly all of the engine's strings are ASCII, and once prose mixing scripts of every UTF-8 length.
+#define _SILENCE_CXX17_CODECVT_HEADER_DEPRECATION_WARNING 1   // the baseline is deprecated
+#include <codecvt>
+#include <filesystem>
+#include <fstream>
+#include <locale>
+#include <sstream>
+
+#include "Bench.h"
+#include "Utf.h"
+
+using namespace std;
+
+
+namespace
+{
+    using WideConverter = wstring_convert<codecvt_utf8<wchar_t>, wchar_t>;
+
+    constexpr size_t TextSize = 64 * 1024;
+
+    string RepeatToSize(const string& sample)
+    {
+        string text;
+        while (text.size() < TextSize) text += sample;
+        return text;
+    }
+
+    const string& AsciiText()
+    {
+        static const string text = []()
+        {
+            ifstream file("src/shaders.hlsl");
+            stringstream source;
+            source << file.rdbuf();
+            return RepeatToSize(file.good() ? source.str() : string("float4 PSMain(PSInput input) : SV_TARGET\n"));
+        }();
+        return text;
+    }
+
+    const string& MixedText()
+    {
+        static const string text = RepeatToSize("Shade \xe2\x80\x94 th\xc3\xa9\xc3\xa2tre, \xce\x95\xce\xbb\xce\xbb\xce\xb7"
+                                                "\xce\xbd\xce\xb9\xce\xba\xce\xac, \xd1\x80\xd1\x83\xd1\x81\xd1\x81\xd0\xba"
+                                                "\xd0\xb8\xd0\xb9, \xe6\x97\xa5\xe6\x9c\xac\xe8\xaa\x9e, \xed\x95\x9c\xea"
+                                                "\xb5\xad\xec\x96\xb4, \xf0\x9f\x8e\xa8\xf0\x9f\x96\x8c. ");
+        return text;
+    }
+
+    void TranscodeToWide(BenchState& state, const string& text)
+    {
+        vector<wchar_t> wide(text.size() * MaxWidePerUtf8);
+        state.SetBytesPerIteration(text.size());
+
+        while (state.KeepRunning())
+        {
+            BenchDoNotOptimize(Utf8ToWide(text.data(), text.size(), wide.data(), wide.size()));
+            BenchDoNotOptimize(wide);
+        }
+    }
+
+    void CodecvtToWide(BenchState& state, const string& text)
+    {
+        WideConverter converter;
+        state.SetBytesPerIteration(text.size());
+
+        while (state.KeepRunning())
+        {
+            BenchDoNotOptimize(converter.from_bytes(text));
+        }
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                      UTF-8 to Wide
+//**********************************************************************************************************************
+BENCHMARK(Utf8ToWideAscii)      {TranscodeToWide(state, AsciiText());}
+BENCHMARK(CodecvtToWideAscii)   {CodecvtToWide(state, AsciiText());}
+BENCHMARK(Utf8ToWideMixed)      {TranscodeToWide(state, MixedText());}
+BENCHMARK(CodecvtToWideMixed)   {CodecvtToWide(state, MixedText());}
+
+
+//**********************************************************************************************************************
+//                                                      Wide to UTF-8
+//**********************************************************************************************************************
+BENCHMARK(WideToUtf8Mixed)
+{
+    const wstring wide = ToWideString(MixedText());
+    vector<char> narrow(wide.size() * MaxUtf8PerWide);
+    state.SetBytesPerIteration(MixedText().size());
+
+    while (state.KeepRunning())
+    {
+        BenchDoNotOptimize(WideToUtf8(wide.data(), wide.size(), narrow.data(), narrow.size()));
+        BenchDoNotOptimize(narrow);
+    }
+}
+
+BENCHMARK(CodecvtToUtf8Mixed)
+{
+    const wstring wide = ToWideString(MixedText());
+    WideConverter converter;
+    state.SetBytesPerIteration(MixedText().size());
+
+    while (state.KeepRunning())
+    {
+        BenchDoNotOptimize(converter.to_bytes(wide));
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                      Validation
+//**********************************************************************************************************************
+BENCHMARK(ValidateUtf8Mixed)
+{
+    const string& text = MixedText();
+    state.SetBytesPerIteration(text.size());
+
+    while (state.KeepRunning())
+    {
+        BenchDoNotOptimize(IsValidUtf8(text.data(), text.size()));
+    }
+}
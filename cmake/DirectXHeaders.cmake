@@ -0,0 +1,37 @@
+# Windows builds get the D3D12 headers, DirectXMath and friends from the Windows
+#   SDK. Elsewhere only the headless backends are available, but they are still
+#   written against the D3D12 API, so we fetch Microsoft's open-source copies of
+#   those headers instead. DirectXMath expects the SAL annotations header, which
+#   is not shipped with either, so grab the copy used by the .NET runtime.
+
+if(NOT WIN32)
+    include(FetchContent)
+
+    FetchContent_Declare(DirectX-Headers
+        GIT_REPOSITORY https://github.com/microsoft/DirectX-Headers.git
+        GIT_TAG        v1.614.0
+        GIT_SHALLOW    TRUE
+    )
+    FetchContent_Declare(DirectXMath
+        GIT_REPOSITORY https://github.com/microsoft/DirectXMath.git
+        GIT_TAG        feb2024
+        GIT_SHALLOW    TRUE
+    )
+    set(DXHEADERS_BUILD_TEST OFF CACHE BOOL "" FORCE)
+    set(DXHEADERS_BUILD_GOOGLE_TEST OFF CACHE BOOL "" FORCE)
+    FetchContent_MakeAvailable(DirectX-Headers)
+    FetchContent_Populate(DirectXMath)
+
+    set(SAL_PATH ${PROJECT_SOURCE_DIR}/extern/sal)
+    if(NOT EXISTS ${SAL_PATH}/sal.h)
+        message("Fetching sal.h")
+        file(DOWNLOAD https://raw.githubusercontent.com/dotnet/runtime/v8.0.1/src/coreclr/pal/inc/rt/sal.h
+             ${SAL_PATH}/sal.h
+             TIMEOUT 30
+        )
+    endif()
+
+    include_directories(${directxmath_SOURCE_DIR}/Inc ${SAL_PATH})
+    set_target_properties(DirectX-Headers PROPERTIES FOLDER "Libraries")
+    set_target_properties(DirectX-Guids PROPERTIES FOLDER "Libraries")
+endif()
@@ -3,6 +3,19 @@
 #   the LLVM source. As such, it is a sizable repo. For simplicity, we will just
 #   grab an archive of release binaries off of GitHub.
 
+# Release archives are only published for Windows, so other platforms use a DXC
+#   installed on the system, such as the one shipped with the Vulkan SDK.
+if(NOT WIN32)
+    find_path(DXC_INCLUDE_DIR dxcapi.h PATH_SUFFIXES dxc REQUIRED)
+    find_library(DXC_LIBRARY dxcompiler REQUIRED)
+    get_filename_component(DXC_LIBRARY_DIR ${DXC_LIBRARY} DIRECTORY)
+    set(DXC_BINARY_DIR ${DXC_LIBRARY_DIR})
+
+    include_directories(${DXC_INCLUDE_DIR})
+    link_directories(${DXC_LIBRARY_DIR})
+    return()
+endif()
+
 # DXC origin and local file paths
 set(DXC_ORIGIN_FILE https://github.com/microsoft/DirectXShaderCompiler/releases/download/v1.6.2106/dxc_2021_07_01.zip)
 set(DXC_ORIGIN_FILE_MD5 7f9d593e65cec70326c3773eb2b05fa1)
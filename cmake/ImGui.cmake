@@ -12,15 +12,21 @@ set(IMGUI_SOURCES
     ${IMGUI_SOURCE_PATH}/imgui_draw.cpp
     ${IMGUI_SOURCE_PATH}/imgui_tables.cpp
     ${IMGUI_SOURCE_PATH}/imgui_widgets.cpp
-    ${IMGUI_SOURCE_PATH}/backends/imgui_impl_dx12.cpp
-    ${IMGUI_SOURCE_PATH}/backends/imgui_impl_win32.cpp
 )
 set(IMGUI_HEADERS
     ${IMGUI_SOURCE_PATH}/imgui.h
+)
+
+# platform and renderer backends are only needed by the windowed D3D12 build
+set(IMGUI_BACKEND_SOURCES
+    ${IMGUI_SOURCE_PATH}/backends/imgui_impl_dx12.cpp
+    ${IMGUI_SOURCE_PATH}/backends/imgui_impl_win32.cpp
+)
+set(IMGUI_BACKEND_HEADERS
     ${IMGUI_SOURCE_PATH}/backends/imgui_impl_dx12.h
     ${IMGUI_SOURCE_PATH}/backends/imgui_impl_win32.h
 )
-source_group("ImGui" FILES ${IMGUI_SOURCES} ${IMGUI_HEADERS})
+source_group("ImGui" FILES ${IMGUI_SOURCES} ${IMGUI_HEADERS} ${IMGUI_BACKEND_SOURCES} ${IMGUI_BACKEND_HEADERS})
 
 include_directories(${IMGUI_SOURCE_DIRS})
 add_compile_definitions(IMGUI_DISABLE_OBSOLETE_FUNCTIONS=1)
@@ -0,0 +1,13 @@
+# The Vulkan backend is optional, and is built whenever a Vulkan SDK or the
+#   system's loader and headers can be found. Shaders reach it as SPIR-V from
+#   the same DXC that Shade already uses, so nothing else is required.
+
+option(SHADE_VULKAN "Build the Vulkan backend" ON)
+
+if(SHADE_VULKAN)
+    find_package(Vulkan 1.3)
+    if(NOT Vulkan_FOUND)
+        message("Vulkan 1.3 not found, the Vulkan backend will not be built")
+        set(SHADE_VULKAN OFF)
+    endif()
+endif()
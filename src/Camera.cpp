@@ -61,6 +61,16 @@ void Camera::Rotate(float alpha, float beta, float gamma)
     if (gamma != 0.0f) rotations *= XMMatrixRotationX(gamma);
 }
 
+// points the camera at target, with yaw and pitch to match so that Update() keeps the new direction
+void Camera::LookAt(XMFLOAT3 target)
+{
+    const XMVECTOR direction = XMVector3Normalize(XMLoadFloat3(&target) - XMLoadFloat3(&m_position));
+    XMStoreFloat3(&m_direction, direction);
+
+    m_pitch = asin(m_direction.y);
+    m_yaw = atan2(m_direction.x, m_direction.z);
+}
+
 void Camera::YawRight(uint ticks)
 {
     m_yaw += ticks*m_turnSpeed;
@@ -38,6 +38,8 @@ public:
 
     void SetPosition(XMFLOAT3 pos)      {m_position = pos;}
     void SetDirection(XMFLOAT3 dir)     {m_direction = dir;}    // note this is different from "look at"
+    void LookAt(XMFLOAT3 target);
+    void SetAspectRatio(float ratio)    {m_aspectRatio = ratio;}
     XMFLOAT3 GetPosition()              {return m_position;}
     XMFLOAT3 GetDirection()             {return m_direction;}
     XMFLOAT3 GetUpVector()              {return m_up;}
@@ -4,6 +4,7 @@
 //**********************************************************************************************************************
 //                                                   Windows & D3D12
 //**********************************************************************************************************************
+#if defined(_WIN32)
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
@@ -19,10 +20,28 @@
 #include <d3d12.h>
 #include <dxgi1_4.h>
 //#include <D3Dcompiler.h>
+#else
+// Outside of Windows, the DirectX-Headers project provides the D3D12 API headers along with a small adapter for the
+//  Win32 and COM types they depend upon. There is no DXGI, window or swapchain, so only headless backends are built.
+#include <wsl/winadapter.h>
+#include <wsl/wrladapter.h>
+#include <directx/d3d12.h>
+
+#ifndef _countof
+#define _countof(array) (sizeof(array) / sizeof((array)[0]))
+#endif
+#endif
 #include <DirectXMath.h>    // SimpleMath from DirectXTK12 wraps this
 
 #include "d3dx12.h"     // redistributable utility header
 
+// native window handle, which is null for headless backends
+#if defined(_WIN32)
+using WindowHandle = HWND;
+#else
+using WindowHandle = void*;
+#endif
+
 
 //**********************************************************************************************************************
 //                                            C++ Standard Template Library
@@ -57,12 +76,14 @@ namespace magic_enum::customize {
 //                                                      Typedefs
 //**********************************************************************************************************************
 using uint = uint32_t;
+using uint32 = uint32_t;
 using uint64 = uint64_t;
 
 
 //**********************************************************************************************************************
 //                                                    Wrapper Enums
 //**********************************************************************************************************************
+#if defined(_WIN32)
 enum class MessageSizeType // WM_SIZE wParam macro values in WinUser.h
 {
     SizeRestored  = SIZE_RESTORED,
@@ -71,6 +92,7 @@ enum class MessageSizeType // WM_SIZE wParam macro values in WinUser.h
     SizeMaxShow   = SIZE_MAXSHOW,
     SizeMaxHide   = SIZE_MAXHIDE,
 };
+#endif
 
 
 static float BLACK[] = {0.0, 0.0, 0.0, 1.0};
@@ -3,8 +3,13 @@
 #include <dwmapi.h>
 
 #include "Shader.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include "MemoryTracker.h"
 #include "Mesh.h"
-#include "ShaderToyScene.h"
+#include "Profiler.h"
+#include "Scene.h"
+#include "ShaderAnalysis.h"
 #include "Widgets.h"
 #include <imnodes.h>
 
@@ -12,9 +17,6 @@
 using namespace std;
 
 
-Dx12RenderEngine* Dx12RenderEngine::pCurrentEngine = nullptr;
-
-
 //**********************************************************************************************************************
 //                                              Constructors & Destructors
 //**********************************************************************************************************************
@@ -30,23 +32,28 @@ Dx12RenderEngine::Dx12RenderEngine(UINT width, UINT height) :
     m_frameIndex(0),
     m_pFenceEvent(nullptr),
     m_fenceValue(0),
+    m_timestampFrequency(0),
     m_pImGuiContext(nullptr),
     m_fullscreen(false),
     m_showDebugConsole(false),
     m_showImGuiDemoWindow(false),
     m_showImGuiMetrics(false),
     m_showImGuiStyleEditor(false),
+    m_showProfiler(false),
+    m_showMemory(false),
+    m_showShaderCosts(false),
     m_frameIsReady(false),
     m_swapchainNeedsResize(false)
 {
-    pCurrentEngine = this;
+    m_pLogConsole = make_shared<LogConsoleSink>();
+    Logger::Get().AddSink(m_pLogConsole);
 }
 
 
 //**********************************************************************************************************************
 //                                              Engine Primary Interfaces
 //**********************************************************************************************************************
-void Dx12RenderEngine::Init(const HWND window)
+void Dx12RenderEngine::Init(const WindowHandle window)
 {
     m_window = window;
     GetWindowRect(m_window, &m_windowPosition);
@@ -109,6 +116,23 @@ void Dx12RenderEngine::Init(const HWND window)
     CreateCommandAllocator(&m_pCommandAllocator);
     CreateCommandList(&m_pCommandList);
 
+    // Timestamps bracket each frame's submissions for the GPU frame time. The opening one needs a list of its own, as
+    //  scenes submit their work before the engine's list is executed.
+    {
+        D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+        queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+        queryHeapDesc.Count = 2;
+        CheckResult(m_pDevice->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&m_pTimestampHeap)));
+
+        const auto readbackProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK);
+        const auto bufferProps = CD3DX12_RESOURCE_DESC::Buffer(2 * sizeof(UINT64));
+        CheckResult(CreateResource(&readbackProps, &bufferProps, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, &m_pTimestampReadback));
+        CheckResult(m_pCommandQueue->GetTimestampFrequency(&m_timestampFrequency));
+
+        CreateCommandAllocator(&m_pTimestampAllocator);
+        CreateCommandList(&m_pTimestampCommandList);
+    }
+
     // resource management constructs and core resources
     {
         // descriptor heaps
@@ -118,7 +142,7 @@ void Dx12RenderEngine::Init(const HWND window)
             rtvHeapDesc.NumDescriptors = 4;
             rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
             rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-            CheckResult(m_pDevice->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&m_pRtvHeap)));
+            CheckResult(CreateDescriptorHeap(&rtvHeapDesc, &m_pRtvHeap));
 
             m_rtvDescriptorSize = m_pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 
@@ -127,7 +151,7 @@ void Dx12RenderEngine::Init(const HWND window)
             srvHeapDesc.NumDescriptors = 1024;
             srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
             srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-            CheckResult(m_pDevice->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&m_pSrvHeap)));
+            CheckResult(CreateDescriptorHeap(&srvHeapDesc, &m_pSrvHeap));
 
             m_srvDescriptorSize = m_pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
         }
@@ -137,13 +161,7 @@ void Dx12RenderEngine::Init(const HWND window)
             constexpr uint uploadBufferSize = 8*1024*1024;
             const auto uploadProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
             const auto bufferProps = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
-            CheckResult(m_pDevice->CreateCommittedResource(
-                &uploadProps,
-                D3D12_HEAP_FLAG_NONE,
-                &bufferProps,
-                D3D12_RESOURCE_STATE_GENERIC_READ,
-                nullptr,
-                IID_PPV_ARGS(&m_pUploadBuffer)));
+            CheckResult(CreateResource(&uploadProps, &bufferProps, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, &m_pUploadBuffer));
         }
 
         // default heap (committed resource) for geometry data
@@ -151,13 +169,7 @@ void Dx12RenderEngine::Init(const HWND window)
             constexpr uint geometryBufferSize = 8*1024*1024;
             const auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
             const auto bufferProps = CD3DX12_RESOURCE_DESC::Buffer(geometryBufferSize);
-            CheckResult(m_pDevice->CreateCommittedResource(
-                &heapProps,
-                D3D12_HEAP_FLAG_NONE,
-                &bufferProps,
-                D3D12_RESOURCE_STATE_GENERIC_READ,
-                nullptr,
-                IID_PPV_ARGS(&m_pGeometryBuffer)));
+            CheckResult(CreateResource(&heapProps, &bufferProps, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, &m_pGeometryBuffer));
 
             // keep this buffer persistently mapped
             CD3DX12_RANGE readRange(0, 0);
@@ -232,6 +244,7 @@ void Dx12RenderEngine::Init(const HWND window)
 
     // configure and initialize ImGui
     {
+        MemoryTracker::InstallImGuiAllocator();
         m_pImGuiContext = ImGui::CreateContext();
         m_pImNodesContext = ImNodes::CreateContext();
         ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_DockingEnable;
@@ -285,12 +298,15 @@ void Dx12RenderEngine::OnRender()
 
     //if (shouldRender)
     {
-        OnUpdate();
-        PreRender();
-        Render();
-        PostRender();
+        if (!m_frameGraph.IsCompiled()) BuildFrameGraph();
+
+        m_frameStats.BeginFrame();
+        m_frameGraph.Execute(JobSystem::Get(), &m_frameStats);
+        m_frameStats.EndFrame();
+        FrameArena::EndFrame();
         m_frameIsReady = true;
     }
+    PROFILE_FRAME();
 }
 
 void Dx12RenderEngine::OnDestroy()
@@ -306,10 +322,14 @@ void Dx12RenderEngine::OnDestroy()
     ImGui::DestroyContext(m_pImGuiContext);
     m_pImNodesContext = nullptr;
     m_pImGuiContext = nullptr;
+
+    Logger::Get().RemoveSink(m_pLogConsole.get());
 }
 
 void Dx12RenderEngine::Flush()
 {
+    PROFILE_FUNCTION();
+
     // For the time being, we only expect one frame from a single pipeline in flight. When parallel work across multiple
     //  queues is wanted, we will need a proper synchronization mechanism and possibly a scheduler.
 
@@ -437,6 +457,7 @@ HRESULT Dx12RenderEngine::CreateCommandList(ID3D12GraphicsCommandList6** ppComma
                                            (void**)(ppCommandList));
 
     CheckResult(result, "command list creation");
+    if (SUCCEEDED(result)) m_stats.commandListsCreated++;
     return result;
 }
 
@@ -461,6 +482,10 @@ HRESULT Dx12RenderEngine::CreateRootSignature(CD3DX12_VERSIONED_ROOT_SIGNATURE_D
         {
             PrintMessage(Error, "Root signature creation failed!\n");
         }
+        else
+        {
+            m_stats.rootSignaturesCreated++;
+        }
     }
     else
     {
@@ -475,6 +500,7 @@ HRESULT Dx12RenderEngine::CreatePipelineState(D3D12_GRAPHICS_PIPELINE_STATE_DESC
 {
     HRESULT result = m_pDevice->CreateGraphicsPipelineState(pDesc, IID_PPV_ARGS(ppPipelineState));
     CheckResult(result, "PSO creation from state description");
+    if (SUCCEEDED(result)) m_stats.pipelineStatesCreated++;
 
     return result;
 }
@@ -484,20 +510,67 @@ HRESULT Dx12RenderEngine::CreatePipelineState(D3D12_PIPELINE_STATE_STREAM_DESC*
 {
     HRESULT result = m_pDevice->CreatePipelineState(pStreamDesc, IID_PPV_ARGS(ppPipelineState));
     CheckResult(result, "PSO creation from stream description");
+    if (SUCCEEDED(result)) m_stats.pipelineStatesCreated++;
 
     return result;
 }
 
-HRESULT Dx12RenderEngine::CreateResource(ID3D12Resource** ppResource)
+// all resources are committed for now, so each one gets its own implicit heap
+HRESULT Dx12RenderEngine::CreateResource(const D3D12_HEAP_PROPERTIES* pHeapProperties,
+                                         const D3D12_RESOURCE_DESC*   pDesc,
+                                         D3D12_RESOURCE_STATES        initialState,
+                                         const D3D12_CLEAR_VALUE*     pClearValue,
+                                         ID3D12Resource**             ppResource)
 {
-    // TODO: implement
-    return 0;
+    HRESULT result = m_pDevice->CreateCommittedResource(pHeapProperties,
+                                                        D3D12_HEAP_FLAG_NONE,
+                                                        pDesc,
+                                                        initialState,
+                                                        pClearValue,
+                                                        IID_PPV_ARGS(ppResource));
+    CheckResult(result, "committed resource creation");
+
+    if (SUCCEEDED(result))
+    {
+        const D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = m_pDevice->GetResourceAllocationInfo(0, 1, pDesc);
+        m_stats.resourcesCreated++;
+        m_stats.resourceBytes[pHeapProperties->Type] += allocationInfo.SizeInBytes;
+        MemoryTracker::TrackResource(*ppResource, pHeapProperties->Type, allocationInfo.SizeInBytes);
+    }
+
+    return result;
+}
+
+HRESULT Dx12RenderEngine::CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* pDesc,
+                                               ID3D12DescriptorHeap**            ppDescriptorHeap)
+{
+    HRESULT result = m_pDevice->CreateDescriptorHeap(pDesc, IID_PPV_ARGS(ppDescriptorHeap));
+    CheckResult(result, "descriptor heap creation");
+    if (SUCCEEDED(result)) m_stats.descriptorHeapsCreated++;
+
+    return result;
+}
+
+void Dx12RenderEngine::CreateRenderTargetView(ID3D12Resource*                      pResource,
+                                              const D3D12_RENDER_TARGET_VIEW_DESC* pDesc,
+                                              D3D12_CPU_DESCRIPTOR_HANDLE          destDescriptor)
+{
+    m_pDevice->CreateRenderTargetView(pResource, pDesc, destDescriptor);
+}
+
+void Dx12RenderEngine::CreateDepthStencilView(ID3D12Resource*                      pResource,
+                                              const D3D12_DEPTH_STENCIL_VIEW_DESC* pDesc,
+                                              D3D12_CPU_DESCRIPTOR_HANDLE          destDescriptor)
+{
+    m_pDevice->CreateDepthStencilView(pResource, pDesc, destDescriptor);
 }
 
 void Dx12RenderEngine::ExecuteCommandList(ID3D12GraphicsCommandList6* pCommandList)
 {
+    PROFILE_FUNCTION();
     ID3D12CommandList* ppCommandLists[] = { pCommandList };
     m_pCommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+    m_stats.commandListsExecuted++;
 }
 
 
@@ -556,10 +629,32 @@ D3D12_GPU_DESCRIPTOR_HANDLE Dx12RenderEngine::AddSrvForResource(D3D12_SHADER_RES
 //**********************************************************************************************************************
 //                                              Engine Internal Helpers
 //**********************************************************************************************************************
-void Dx12RenderEngine::OnUpdate()
+void Dx12RenderEngine::BuildFrameGraph()
 {
-    m_pScene->OnUpdate();
+    // The engine's stages stay on the main thread, which owns the window and the ImGui platform backend, and each
+    //  writes the engine so that they keep their order around the scene's stages.
+    ImGuiContext* pImGuiContext = ImGui::GetCurrentContext();
+
+    m_frameGraph.AddTask("Engine::OnUpdate", [this] {OnUpdate();}).Writes(this).OnMainThread()
+        .Measures(FrameStatUpdateTime);
+    m_frameGraph.AddTask("Engine::PreRender", [this] {PreRender();}).Writes(this).Writes(pImGuiContext).OnMainThread();
+    m_frameGraph.AddTask("Engine::BuildUI", [this] {BuildEngineUi();}).Writes(this).Writes(pImGuiContext).OnMainThread()
+        .Measures(FrameStatUiTime);
+
+    m_pScene->AddTasks(m_frameGraph);
+    m_pScene->AddUiTasks(m_frameGraph);
+
+    m_frameGraph.AddTask("Engine::Render", [this] {Render();}).Writes(this).Writes(pImGuiContext).OnMainThread()
+        .Measures(FrameStatUiTime);
+    m_frameGraph.AddTask("Engine::PostRender", [this] {PostRender();}).Writes(this).OnMainThread()
+        .Measures(FrameStatPresentTime);
 
+    m_frameGraph.Compile();
+}
+
+void Dx12RenderEngine::OnUpdate()
+{
+    PROFILE_FUNCTION();
     m_swapchainMutex.lock();
     if (m_swapchainNeedsResize) ResizeSwapchain();
     m_swapchainMutex.unlock();
@@ -569,54 +664,66 @@ void Dx12RenderEngine::OnUpdate()
 
 void Dx12RenderEngine::PreRender()
 {
-    // TODO: perform pre-render work for new frame
-}
+    PROFILE_FUNCTION();
 
-void Dx12RenderEngine::Render()
-{
-    // Inform ImGui backends and core that we are starting a new frame, and construct the immediate-mode UI. The UI
-    //  will be drawn later via insertions into command list.
-    ImGui_ImplDX12_NewFrame();
-    ImGui_ImplWin32_NewFrame();
-    ImGui::NewFrame();
+    // Inform ImGui backends and core that we are starting a new frame, so that the UI can be constructed by later
+    //  stages. The UI will be drawn at the end of the frame via insertions into command list.
+    {
+        PROFILE_SCOPE("ImGui::NewFrame");
+        ImGui_ImplDX12_NewFrame();
+        ImGui_ImplWin32_NewFrame();
+        ImGui::NewFrame();
+    }
 
     // reset so that scene can make requests
     CheckResult(m_pCommandAllocator->Reset());
     CheckResult(m_pCommandList->Reset(m_pCommandAllocator.Get(), nullptr));
 
-    // execute scene pipelines
-    m_pScene->OnRender();
+    // open the frame's GPU timing ahead of anything the scene submits
+    CheckResult(m_pTimestampAllocator->Reset());
+    CheckResult(m_pTimestampCommandList->Reset(m_pTimestampAllocator.Get(), nullptr));
+    m_pTimestampCommandList->EndQuery(m_pTimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0);
+    CheckResult(m_pTimestampCommandList->Close());
+    ExecuteCommandList(m_pTimestampCommandList.Get());
+}
 
-    // build dockspace with main menu bar, then populate with engine and scene contents
-    BuildEngineUi();
-    m_pScene->BuildUI();
-    ImGui::Render();
+void Dx12RenderEngine::Render()
+{
+    PROFILE_FUNCTION();
 
-    // after UI is described, update the floating windows and re-draw their viewports
-    ImGui::UpdatePlatformWindows();
-    ImGui::RenderPlatformWindowsDefault(NULL, (void*)m_pCommandList.Get());
+    // the engine and scene have described the UI, so update the floating windows and re-draw their viewports
+    {
+        PROFILE_SCOPE("ImGui::Render");
+        ImGui::Render();
+        ImGui::UpdatePlatformWindows();
+        ImGui::RenderPlatformWindowsDefault(NULL, (void*)m_pCommandList.Get());
+    }
 
     // collect ImGui commands and execute them, drawing the UI
     PopulateCommandList();
     ID3D12CommandList* ppCommandLists[] = { m_pCommandList.Get() };
     m_pCommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+}
 
+void Dx12RenderEngine::PostRender()
+{
     // present the frame we just generated and wait for all remaining work to complete
-    CheckResult(m_pSwapChain->Present(1, 0));   // sync to next vertical blank
-                                                //CheckResult(m_pSwapChain->Present(0, 0));   // present immediately (no vsync)
-    Flush();
+    {
+        PROFILE_SCOPE("Present");
+        CheckResult(m_pSwapChain->Present(1, 0));   // sync to next vertical blank
+                                                    //CheckResult(m_pSwapChain->Present(0, 0));   // present immediately (no vsync)
+        Flush();
+    }
+    RecordGpuFrameTime();
 
     // progress to next frame in swapchain
     m_frameIndex = m_pSwapChain->GetCurrentBackBufferIndex();
 }
 
-void Dx12RenderEngine::PostRender()
-{
-    // TODO: perform post-render work for new frame
-}
-
 void Dx12RenderEngine::BuildEngineUi()
 {
+    PROFILE_FUNCTION();
+
     const ImGuiViewport* mainViewport = ImGui::GetMainViewport();
     m_menuBarText = "Hello!";
 
@@ -658,6 +765,9 @@ void Dx12RenderEngine::BuildEngineUi()
             ImGui::Checkbox("Show Debug Console", &m_showDebugConsole);
             ImGui::Checkbox("Show ImGui Metrics/Debug", &m_showImGuiMetrics);
             ImGui::Checkbox("Show ImGui Style Editor", &m_showImGuiStyleEditor);
+            ImGui::Checkbox("Show Profiler", &m_showProfiler);
+            ImGui::Checkbox("Show Memory", &m_showMemory);
+            ImGui::Checkbox("Show Shader Costs", &m_showShaderCosts);
             ImGui::Separator();
             ImGui::MenuItem("Foo");
             ImGui::EndMenu();
@@ -705,8 +815,8 @@ void Dx12RenderEngine::BuildEngineUi()
     {
         if (m_showDebugConsole)
         {
-            ImGui::Begin("Debug Console");
-            ImGui::Text("this should be a debug console");
+            ImGui::Begin("Debug Console", &m_showDebugConsole);
+            m_pLogConsole->DrawUI();
             ImGui::End();
         }
         if (m_showImGuiDemoWindow)
@@ -721,6 +831,24 @@ void Dx12RenderEngine::BuildEngineUi()
         {
             ImGui::ShowStyleEditor();
         }
+        if (m_showProfiler)
+        {
+            ImGui::Begin("Profiler", &m_showProfiler);
+            Profiler::Get().DrawFlameView();
+            ImGui::End();
+        }
+        if (m_showMemory)
+        {
+            ImGui::Begin("Memory", &m_showMemory);
+            MemoryTracker::BuildUI();
+            ImGui::End();
+        }
+        if (m_showShaderCosts)
+        {
+            ImGui::Begin("Shader Costs", &m_showShaderCosts);
+            ShaderAnalysis::Get().BuildUI();
+            ImGui::End();
+        }
     }
 
     // display mode info
@@ -764,6 +892,8 @@ void Dx12RenderEngine::BuildEngineUi()
         ImGui::Text("Resolution: %ux%u", width, height);
         ImGui::Separator();
         ImGui::Text("Present #%u\n", frameStats.PresentRefreshCount);
+        ImGui::Separator();
+        m_frameStats.BuildUI();
         ImGui::End();
     }
 
@@ -784,6 +914,8 @@ void Dx12RenderEngine::BuildEngineUi()
 
 void Dx12RenderEngine::PopulateCommandList()
 {
+    PROFILE_FUNCTION();
+
     // ImGui uses the heaps we provide, so we need to set them
     ID3D12DescriptorHeap* ppHeaps[] = { m_pSrvHeap.Get() };
     m_pCommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
@@ -802,6 +934,10 @@ void Dx12RenderEngine::PopulateCommandList()
     ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), m_pCommandList.Get());
     // TODO: transition viewport resources back
 
+    // close the frame's GPU timing, resolving both timestamps for readback once the frame completes
+    m_pCommandList->EndQuery(m_pTimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 1);
+    m_pCommandList->ResolveQueryData(m_pTimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, 0, 2, m_pTimestampReadback.Get(), 0);
+
     // transition back buffer to present mode prior to present
     const auto afterBarrier = CD3DX12_RESOURCE_BARRIER::Transition(m_pRenderTargets[m_frameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
     m_pCommandList->ResourceBarrier(1, &afterBarrier);
@@ -810,6 +946,23 @@ void Dx12RenderEngine::PopulateCommandList()
     CheckResult(m_pCommandList->Close());
 }
 
+// reads the timestamps resolved by the frame which has just been flushed
+void Dx12RenderEngine::RecordGpuFrameTime()
+{
+    if (m_timestampFrequency == 0) return;
+
+    UINT64* pTimestamps = nullptr;
+    const CD3DX12_RANGE readRange(0, 2 * sizeof(UINT64));
+    const CD3DX12_RANGE writeRange(0, 0);
+    if (FAILED(m_pTimestampReadback->Map(0, &readRange, reinterpret_cast<void**>(&pTimestamps)))) return;
+
+    if (pTimestamps[1] >= pTimestamps[0])
+    {
+        m_frameStats.Add(FrameStatGpuTime, (pTimestamps[1] - pTimestamps[0]) * 1000.0 / m_timestampFrequency);
+    }
+    m_pTimestampReadback->Unmap(0, &writeRange);
+}
+
 void Dx12RenderEngine::ResizeSwapchain()
 {
     m_width = m_newWindowPosition.cx;
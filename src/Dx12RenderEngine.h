@@ -12,8 +12,6 @@
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
 
-class ShaderToyScene;
-
 
 // The engine owns the device, adapter, swapchain and UI pipeline/heaps/resources. It schedules work and manages
 //  resources at the request of client Scenes. Ideally clients would know nothing about the engine internals, simply
@@ -25,7 +23,7 @@ public:
     Dx12RenderEngine(UINT width, UINT height);
 
     // primary interfaces for render loop
-    void Init(const HWND window);   // initialize API and other state
+    void Init(const WindowHandle window);   // initialize API and other state
     void OnRender();
     void Flush();
     void OnDestroy();
@@ -43,9 +41,21 @@ public:
                                 ID3D12RootSignature**                   ppRootSignature);
     HRESULT CreatePipelineState(D3D12_GRAPHICS_PIPELINE_STATE_DESC*     pDesc,
                                 ID3D12PipelineState**                   ppPipelineState);
-    HRESULT CreatePipelineState(D3D12_PIPELINE_STATE_STREAM_DESC* pStreamDesc,
-                                ID3D12PipelineState** ppPipelineState);
-    HRESULT CreateResource(ID3D12Resource** ppResource);
+    HRESULT CreatePipelineState(D3D12_PIPELINE_STATE_STREAM_DESC*       pStreamDesc,
+                                ID3D12PipelineState**                   ppPipelineState);
+    HRESULT CreateResource(const D3D12_HEAP_PROPERTIES*                 pHeapProperties,
+                           const D3D12_RESOURCE_DESC*                   pDesc,
+                           D3D12_RESOURCE_STATES                        initialState,
+                           const D3D12_CLEAR_VALUE*                     pClearValue,
+                           ID3D12Resource**                             ppResource);
+    HRESULT CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC*      pDesc,
+                                 ID3D12DescriptorHeap**                 ppDescriptorHeap);
+    void CreateRenderTargetView(ID3D12Resource*                         pResource,
+                                const D3D12_RENDER_TARGET_VIEW_DESC*    pDesc,
+                                D3D12_CPU_DESCRIPTOR_HANDLE             destDescriptor);
+    void CreateDepthStencilView(ID3D12Resource*                         pResource,
+                                const D3D12_DEPTH_STENCIL_VIEW_DESC*    pDesc,
+                                D3D12_CPU_DESCRIPTOR_HANDLE             destDescriptor);
     void ExecuteCommandList(ID3D12GraphicsCommandList6*                 pCommandList);
 
     // utility functions provided to clients
@@ -56,27 +66,23 @@ public:
     ID3D12Device8* GetDevice() {return m_pDevice.Get();}
     uint GetRtvDescriptorSize() {m_pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);}
     uint GetCbvSrvUavDescriptorSize() {m_pDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);}
-    void SetScene(ShaderToyScene* pScene) {m_pScene = pScene;}
 
     // debug and global UI
     D3D12_GPU_DESCRIPTOR_HANDLE AddSrvForResource(D3D12_SHADER_RESOURCE_VIEW_DESC desc, ComPtr<ID3D12Resource> pResource);
 
-
-    // have this be a single static globally-accessible instance
-    // TODO: proper Singleton restrictions?
-    static Dx12RenderEngine* pCurrentEngine;
-
 private:
     static constexpr UINT FrameCount = 2;
 
 
     // internal helpers
+    void BuildFrameGraph();         // declares the engine's stages around the scene's, once per scene
     void OnUpdate();                // process inputs (physics, user, network, etc...)
     void PreRender();               // do some work at dawn of new frame
-    void Render();                  // issue work and Present()
-    void PostRender();              // work and clenup after frame presented
+    void Render();                  // draw the UI and submit
+    void PostRender();              // Present() and clean up after the frame
     void BuildEngineUi();
     void PopulateCommandList();
+    void RecordGpuFrameTime();
     void ResizeSwapchain();
     void SetDebugData();
 
@@ -114,6 +120,13 @@ private:
     ComPtr<ID3D12Fence>                 m_pFence;
     UINT64                              m_fenceValue;
 
+    // GPU frame timing
+    ComPtr<ID3D12QueryHeap>             m_pTimestampHeap;
+    ComPtr<ID3D12Resource>              m_pTimestampReadback;
+    ComPtr<ID3D12CommandAllocator>      m_pTimestampAllocator;
+    ComPtr<ID3D12GraphicsCommandList6>  m_pTimestampCommandList;    // opens each frame ahead of scene submissions
+    UINT64                              m_timestampFrequency;       // ticks per second, zero if unavailable
+
     // UI
     ImGuiContext*                       m_pImGuiContext;
     ImNodesContext*                     m_pImNodesContext;
@@ -125,8 +138,9 @@ private:
     bool                                m_showImGuiDemoWindow;  // demo is primary documentation for ImGui
     bool                                m_showImGuiMetrics;     // useful for debugging draws and UI
     bool                                m_showImGuiStyleEditor; // useful for configuring and debugging UI
+    bool                                m_showProfiler;         // flame view of the CPU zones of recent frames
+    bool                                m_showMemory;           // live and peak memory by subsystem and heap type
+    bool                                m_showShaderCosts;      // static costs of compiled shaders, and their changes
     std::string                         m_menuBarText;
-
-    // components
-    ShaderToyScene*                     m_pScene;
+    std::shared_ptr<LogConsoleSink>     m_pLogConsole;          // recent messages, for the debug console
 };
@@ -0,0 +1,146 @@
+// FlatHashMap - Open addressing hash map from integer keys, for IDs looked up every frame.
+//
+// Entries are stored inline in a single power-of-two array and found by linear probing from a Fibonacci hash of the
+//  key, so a lookup is a multiply and usually one cache line, where std::map walks a node per level of its tree and
+//  std::unordered_map chases a bucket to a separately allocated node. The table doubles once it is three quarters
+//  full. Erasing shifts the rest of the probe sequence back instead of leaving tombstones, so lookups never slow down
+//  as keys come and go, and clearing keeps the array, so a map refilled each use stops allocating once it has grown.
+//
+// Pointers to values are invalidated by any insertion which grows the table and by any erase.
+#pragma once
+
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Common.h"
+
+
+template <typename Key, typename Value>
+class FlatHashMap
+{
+    static_assert(std::is_integral_v<Key>, "keys are hashed as integers");
+
+public:
+    FlatHashMap()                                           : m_size(0), m_shift(64) {}
+
+    Value* Find(Key key);                                   // or null if missing
+    const Value* Find(Key key) const;
+    Value& operator[](Key key);                             // inserting a value-initialized one if missing
+    bool Erase(Key key);
+
+    void Reserve(size_t count);
+    void Clear();                                           // keeping the table's capacity
+    size_t Size() const                                     {return m_size;}
+    bool Empty() const                                      {return m_size == 0;}
+
+private:
+    struct Entry
+    {
+        Key     key;
+        bool    occupied;
+        Value   value;
+    };
+
+    size_t Home(Key key) const                              {return (uint64(key) * 0x9E3779B97F4A7C15ull) >> m_shift;}
+    size_t Mask() const                                     {return m_entries.size() - 1;}
+    size_t Probe(Key key) const;                            // the key's entry, or the empty entry ending its probe
+    void Rehash(size_t capacity);
+
+    std::vector<Entry>  m_entries;
+    size_t              m_size;
+    uint                m_shift;                            // 64 less the log2 of the capacity
+};
+
+
+//**********************************************************************************************************************
+//                                                  Template Definitions
+//**********************************************************************************************************************
+template <typename Key, typename Value>
+size_t FlatHashMap<Key, Value>::Probe(Key key) const
+{
+    size_t index = Home(key);
+    while (m_entries[index].occupied && m_entries[index].key != key) index = (index + 1) & Mask();
+    return index;
+}
+
+template <typename Key, typename Value>
+Value* FlatHashMap<Key, Value>::Find(Key key)
+{
+    if (m_size == 0) return nullptr;
+    Entry& entry = m_entries[Probe(key)];
+    return entry.occupied ? &entry.value : nullptr;
+}
+
+template <typename Key, typename Value>
+const Value* FlatHashMap<Key, Value>::Find(Key key) const
+{
+    return const_cast<FlatHashMap*>(this)->Find(key);
+}
+
+template <typename Key, typename Value>
+Value& FlatHashMap<Key, Value>::operator[](Key key)
+{
+    if ((m_size + 1) * 4 > m_entries.size() * 3) Rehash(std::max<size_t>(16, m_entries.size() * 2));
+
+    Entry& entry = m_entries[Probe(key)];
+    if (!entry.occupied)
+    {
+        entry.key = key;
+        entry.occupied = true;
+        entry.value = Value();
+        m_size++;
+    }
+    return entry.value;
+}
+
+template <typename Key, typename Value>
+bool FlatHashMap<Key, Value>::Erase(Key key)
+{
+    if (m_size == 0) return false;
+    size_t hole = Probe(key);
+    if (!m_entries[hole].occupied) return false;
+
+    // entries later in the probe sequence move back into the hole unless that would put them before their home
+    for (size_t index = (hole + 1) & Mask(); m_entries[index].occupied; index = (index + 1) & Mask())
+    {
+        const size_t home = Home(m_entries[index].key);
+        if (((index - home) & Mask()) < ((index - hole) & Mask())) continue;
+        m_entries[hole] = std::move(m_entries[index]);
+        hole = index;
+    }
+    m_entries[hole].occupied = false;
+    m_entries[hole].value = Value();
+    m_size--;
+    return true;
+}
+
+template <typename Key, typename Value>
+void FlatHashMap<Key, Value>::Reserve(size_t count)
+{
+    size_t capacity = 16;
+    while (capacity * 3 < count * 4) capacity *= 2;
+    if (capacity > m_entries.size()) Rehash(capacity);
+}
+
+template <typename Key, typename Value>
+void FlatHashMap<Key, Value>::Clear()
+{
+    for (Entry& entry : m_entries) entry = Entry();
+    m_size = 0;
+}
+
+template <typename Key, typename Value>
+void FlatHashMap<Key, Value>::Rehash(size_t capacity)
+{
+    std::vector<Entry> entries(capacity);
+    entries.swap(m_entries);
+    m_shift = 64;
+    for (size_t bits = capacity; bits > 1; bits >>= 1) m_shift--;
+
+    for (Entry& entry : entries)
+    {
+        if (entry.occupied) m_entries[Probe(entry.key)] = std::move(entry);
+    }
+}
@@ -0,0 +1,125 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "MemoryTracker.h"
+
+using namespace std;
+
+
+namespace
+{
+    // frames ended so far, which every arena compares against its own on allocation
+    atomic<uint64> FrameIndex(0);
+
+    uint8_t* AlignUp(uint8_t* pAddress, size_t alignment)
+    {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(pAddress);
+        return reinterpret_cast<uint8_t*>((address + alignment - 1) & ~(uintptr_t(alignment) - 1));
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                              Constructors & Destructors
+//**********************************************************************************************************************
+FrameArena::FrameArena(size_t blockSize) :
+    m_blockIndex(0),
+    m_pCurrent(nullptr),
+    m_pEnd(nullptr),
+    m_usedBytes(0),
+    m_blockSize(blockSize),
+    m_frameIndex(FrameIndex.load(memory_order_relaxed))
+{
+}
+
+FrameArena::~FrameArena()
+{
+}
+
+FrameArena& FrameArena::Get()
+{
+    thread_local FrameArena arena;
+    return arena;
+}
+
+
+//**********************************************************************************************************************
+//                                                  Primary Interfaces
+//**********************************************************************************************************************
+void FrameArena::EndFrame()
+{
+    FrameIndex.fetch_add(1, memory_order_relaxed);
+}
+
+uint64 FrameArena::GetFrameIndex()
+{
+    return FrameIndex.load(memory_order_relaxed);
+}
+
+void FrameArena::Reset()
+{
+    m_blockIndex = 0;
+    m_usedBytes = 0;
+    m_pCurrent = m_blocks.empty() ? nullptr : m_blocks[0].pMemory.get();
+    m_pEnd = m_blocks.empty() ? nullptr : m_pCurrent + m_blocks[0].size;
+    m_frameIndex = FrameIndex.load(memory_order_relaxed);
+}
+
+size_t FrameArena::GetUsedBytes() const
+{
+    if (m_blocks.empty()) return 0;
+    return m_usedBytes + (m_pCurrent - m_blocks[m_blockIndex].pMemory.get());
+}
+
+size_t FrameArena::GetCapacity() const
+{
+    size_t capacity = 0;
+    for (const Block& block : m_blocks) capacity += block.size;
+    return capacity;
+}
+
+
+//**********************************************************************************************************************
+//                                                      Allocation
+//**********************************************************************************************************************
+void* FrameArena::do_allocate(size_t bytes, size_t alignment)
+{
+    // the first allocation of a frame rewinds whatever the thread allocated during earlier frames
+    if (m_frameIndex != FrameIndex.load(memory_order_relaxed)) Reset();
+
+    uint8_t* pMemory = AlignUp(m_pCurrent, alignment);
+    if (m_pCurrent == nullptr || pMemory + bytes > m_pEnd) pMemory = NextBlock(bytes, alignment);
+
+    m_pCurrent = pMemory + bytes;
+    return pMemory;
+}
+
+uint8_t* FrameArena::NextBlock(size_t bytes, size_t alignment)
+{
+    if (!m_blocks.empty()) m_usedBytes += m_blocks[m_blockIndex].size;
+
+    // move on to the first block kept from earlier frames which is large enough, skipping any which are too small
+    const size_t required = bytes + alignment;
+    size_t index = m_blocks.empty() ? 0 : m_blockIndex + 1;
+    while (index < m_blocks.size() && m_blocks[index].size < required)
+    {
+        m_usedBytes += m_blocks[index].size;
+        index++;
+    }
+
+    // otherwise the arena grows, doubling the last block so that a frame needs few blocks however large it gets
+    if (index == m_blocks.size())
+    {
+        MEMORY_SCOPE(MemoryTagFrameArena);
+        const size_t size = max({m_blockSize, required, m_blocks.empty() ? size_t(0) : m_blocks.back().size * 2});
+        m_blocks.push_back({make_unique<uint8_t[]>(size), size});
+        LOG_DEBUG("Frame arena grew to {} blocks, {} bytes", m_blocks.size(), GetCapacity());
+    }
+
+    m_blockIndex = index;
+    m_pCurrent = m_blocks[index].pMemory.get();
+    m_pEnd = m_pCurrent + m_blocks[index].size;
+    return AlignUp(m_pCurrent, alignment);
+}
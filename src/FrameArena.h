@@ -0,0 +1,80 @@
+// FrameArena - Per-thread linear allocator for temporaries which live no longer than the frame that made them.
+//
+// Each thread owns an arena of blocks which it bumps through without locking. FrameArena::EndFrame() only advances a
+//  frame counter, and every arena rewinds to its first block the next time its thread allocates, so ending a frame
+//  costs the same however much was allocated. Blocks are kept from frame to frame, which leaves a steady-state frame
+//  with no heap allocations once the arenas have grown to fit it.
+//
+// The arena is a std::pmr::memory_resource, so per-frame strings and vectors are the pmr containers constructed with
+//  FrameArena::Resource(). Deallocation does nothing, and nothing allocated here may be kept past EndFrame(). What a
+//  thread allocates outside of frames, such as during startup, is reclaimed by the first EndFrame() after it.
+#pragma once
+
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#include "Util.h"
+
+
+template <typename T>
+using FrameVector = std::pmr::vector<T>;
+using FrameString = std::pmr::string;
+
+
+class FrameArena : public std::pmr::memory_resource
+{
+public:
+    static constexpr size_t DefaultBlockSize = 256 * 1024;
+
+    FrameArena(size_t blockSize = DefaultBlockSize);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // the calling thread's arena, and the resource to construct per-frame containers with
+    static FrameArena& Get();
+    static std::pmr::memory_resource* Resource()    {return &Get();}
+
+    // Ends the frame for every thread's arena at once. Called between frames, when no thread holds any temporaries.
+    static void EndFrame();
+    static uint64 GetFrameIndex();
+
+    void Reset();                                   // rewinds to the first block, keeping every block for reuse
+
+    size_t GetUsedBytes() const;                    // in the current frame
+    size_t GetCapacity() const;
+
+private:
+    struct Block
+    {
+        std::unique_ptr<uint8_t[]>  pMemory;
+        size_t                      size;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment);
+    void do_deallocate(void* pMemory, size_t bytes, size_t alignment)   {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept {return this == &other;}
+
+    uint8_t* NextBlock(size_t bytes, size_t alignment);
+
+    std::vector<Block>      m_blocks;
+    size_t                  m_blockIndex;           // block being allocated from
+    uint8_t*                m_pCurrent;             // next free byte in that block
+    uint8_t*                m_pEnd;
+    size_t                  m_usedBytes;            // in blocks before the current one
+    size_t                  m_blockSize;
+    uint64                  m_frameIndex;           // frame the arena was last reset for
+};
+
+
+// Formats into a string allocated from the calling thread's arena.
+template <typename... Args>
+FrameString FrameFormat(fmt::format_string<Args...> format, Args&&... args)
+{
+    FrameString result(FrameArena::Resource());
+    fmt::format_to(std::back_inserter(result), format, std::forward<Args>(args)...);
+    return result;
+}
@@ -0,0 +1,141 @@
+#include "FrameDumper.h"
+
+#include "Profiler.h"
+
+using namespace std;
+
+
+FrameDumper::FrameDumper(string directory, ImageFileFormat format, uint ringSize, uint encoderCount) :
+    m_directory(directory),
+    m_format(format),
+    m_slots(max(ringSize, 1u)),
+    m_finishing(false),
+    m_stats({})
+{
+    std::error_code error;
+    filesystem::create_directories(m_directory, error);
+    if (error) PrintMessage(Error, "Unable to create frame directory \"{}\": {}", m_directory, error.message());
+
+    for (uint i = 0; i < m_slots.size(); ++i)
+    {
+        m_freeSlots.push_back(i);
+    }
+    for (uint i = 0; i < max(encoderCount, 1u); ++i)
+    {
+        m_encoders.emplace_back(&FrameDumper::EncodeLoop, this);
+    }
+}
+
+FrameDumper::~FrameDumper()
+{
+    Finish();
+}
+
+bool FrameDumper::Capture(ID3D12Resource* pRenderTarget, uint frameIndex)
+{
+    PROFILE_FUNCTION();
+    const D3D12_RESOURCE_DESC desc = pRenderTarget->GetDesc();
+    if (desc.Format != DXGI_FORMAT_R8G8B8A8_UNORM)
+    {
+        PrintMessage(Error, "Frame capture only supports R8G8B8A8_UNORM targets, not {}", magic_enum::enum_name(desc.Format));
+        return false;
+    }
+
+    // claim a slot, waiting on the encoders only if all of them are in use
+    uint slotIndex = 0;
+    {
+        unique_lock<mutex> lock(m_mutex);
+        if (m_freeSlots.empty())
+        {
+            const auto start = chrono::steady_clock::now();
+            m_slotFreed.wait(lock, [this]() {return !m_freeSlots.empty();});
+            m_stats.stalls++;
+            m_stats.stallMilliseconds += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        }
+        slotIndex = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+
+    // the slot is ours alone until it is queued, so the copy happens outside the lock
+    Slot& slot = m_slots[slotIndex];
+    slot.width      = static_cast<uint>(desc.Width);
+    slot.height     = desc.Height;
+    slot.rowPitch   = slot.width * 4;
+    slot.frameIndex = frameIndex;
+    slot.pixels.resize(size_t(slot.rowPitch) * slot.height);
+    const HRESULT hr = pRenderTarget->ReadFromSubresource(slot.pixels.data(), slot.rowPitch, 0, 0, nullptr);
+
+    lock_guard<mutex> lock(m_mutex);
+    if (FAILED(hr))
+    {
+        CheckResult(hr, "reading back frame");
+        m_freeSlots.push_back(slotIndex);
+        return false;
+    }
+
+    m_queuedSlots.push_back(slotIndex);
+    m_stats.framesCaptured++;
+    m_slotQueued.notify_one();
+    return true;
+}
+
+void FrameDumper::Finish()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_finishing = true;
+    }
+    m_slotQueued.notify_all();
+
+    for (thread& encoder : m_encoders)
+    {
+        if (encoder.joinable()) encoder.join();
+    }
+    m_encoders.clear();
+}
+
+string FrameDumper::GetFilename(uint frameIndex) const
+{
+    return fmt::format("{}/frame_{:05}{}", m_directory, frameIndex, ImageFileExtension(m_format));
+}
+
+// encoders drain the queue before exiting, so that finishing never drops frames
+void FrameDumper::EncodeLoop()
+{
+    PROFILE_THREAD("Frame Encoder");
+    std::vector<UINT8> encoded;
+    while (true)
+    {
+        uint slotIndex = 0;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            m_slotQueued.wait(lock, [this]() {return m_finishing || !m_queuedSlots.empty();});
+            if (m_queuedSlots.empty()) return;
+
+            slotIndex = m_queuedSlots.front();
+            m_queuedSlots.pop_front();
+        }
+
+        PROFILE_SCOPE("EncodeFrame");
+        const Slot& slot = m_slots[slotIndex];
+        const auto start = chrono::steady_clock::now();
+        bool written = EncodeImage(m_format, slot.pixels.data(), slot.width, slot.height, slot.rowPitch, encoded);
+        if (written)
+        {
+            ofstream file(GetFilename(slot.frameIndex), ios::binary);
+            file.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+            written = file.good();
+        }
+        const double encodeMilliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        if (!written) PrintMessage(Error, "Failed to write \"{}\"", GetFilename(slot.frameIndex));
+
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_stats.encodeMilliseconds += encodeMilliseconds;
+            if (written) m_stats.framesWritten++;
+            else         m_stats.writeFailures++;
+            m_freeSlots.push_back(slotIndex);
+        }
+        m_slotFreed.notify_one();
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "RenderEngine.h"
+#include "ImageWriter.h"
+
+
+struct FrameDumperStats
+{
+    uint64 framesCaptured;
+    uint64 framesWritten;
+    uint64 writeFailures;
+    uint64 stalls;                  // captures which had to wait for the encoders to free a slot
+    double stallMilliseconds;       // render loop time lost to those waits
+    double encodeMilliseconds;      // summed across encoder threads
+};
+
+
+// Writes rendered frames to disk without holding up the render loop. Capture() copies a render target into the next
+//  free slot of a fixed ring of CPU buffers and returns, while background threads encode filled slots and write them
+//  out. The render loop only waits when every slot is still queued for encoding, which is counted as a stall.
+//
+// Render targets are read with ReadFromSubresource() once the engine has executed the frame, which suits the headless
+//  backends whose resources live in CPU memory. RGBA8 targets are the only ones supported.
+class FrameDumper
+{
+public:
+    FrameDumper(std::string directory, ImageFileFormat format, uint ringSize = 8, uint encoderCount = 1);
+    ~FrameDumper();
+
+    // copies the frame and queues it, returning false if the target cannot be captured
+    bool Capture(ID3D12Resource* pRenderTarget, uint frameIndex);
+
+    // blocks until every queued frame has been written and stops the encoders
+    void Finish();
+
+    const FrameDumperStats& GetStats() const    {return m_stats;}
+    std::string GetFilename(uint frameIndex) const;
+
+private:
+    struct Slot
+    {
+        std::vector<UINT8>  pixels;
+        uint                width;
+        uint                height;
+        uint                rowPitch;
+        uint                frameIndex;
+    };
+
+    void EncodeLoop();
+
+    // configuration
+    std::string                 m_directory;
+    ImageFileFormat             m_format;
+
+    // ring of readback slots, each either free or queued for encoding
+    std::vector<Slot>           m_slots;
+    std::vector<uint>           m_freeSlots;
+    std::deque<uint>            m_queuedSlots;
+    std::mutex                  m_mutex;
+    std::condition_variable     m_slotFreed;
+    std::condition_variable     m_slotQueued;
+    bool                        m_finishing;
+
+    std::vector<std::thread>    m_encoders;
+    FrameDumperStats            m_stats;
+};
@@ -0,0 +1,284 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include <imgui.h>
+
+using namespace std;
+
+
+namespace
+{
+    struct FrameStatInfo
+    {
+        const char* pName;      // CSV column
+        const char* pLabel;     // UI row
+        bool        isCounter;  // counters are zero, rather than unmeasured, when nothing was added
+    };
+
+    const FrameStatInfo FrameStatInfos[FrameStatCount] =
+    {
+        {"cpu_ms",          "CPU frame (ms)",   false},
+        {"gpu_ms",          "GPU frame (ms)",   false},
+        {"update_ms",       "Update (ms)",      false},
+        {"render_ms",       "Render (ms)",      false},
+        {"ui_ms",           "UI (ms)",          false},
+        {"present_ms",      "Present (ms)",     false},
+        {"draw_calls",      "Draw calls",       true},
+        {"triangles",       "Triangles",        true},
+        {"upload_bytes",    "Upload bytes",     true},
+    };
+
+    // nearest rank on sorted samples
+    double Percentile(const FrameVector<double>& sorted, double percentile)
+    {
+        const size_t rank = static_cast<size_t>(ceil(percentile / 100.0 * sorted.size()));
+        return sorted[min(max<size_t>(rank, 1), sorted.size()) - 1];
+    }
+
+    const char* ValueFormat(FrameStat stat)
+    {
+        return FrameStatInfos[stat].isCounter ? "%.0f" : "%.3f";
+    }
+}
+
+
+FrameStats::FrameStats(uint capacity) :
+    m_frames(max(capacity, 1u)),
+    m_framesRecorded(0),
+    m_current({}),
+    m_frameStart(chrono::steady_clock::now()),
+    m_histogramStat(FrameStatCpuTime)
+{
+    fill(begin(m_current.values), end(m_current.values), NAN);
+}
+
+
+void FrameStats::SetCapacity(uint capacity)
+{
+    m_frames.assign(max(capacity, 1u), {});
+    m_framesRecorded = 0;
+}
+
+
+//**********************************************************************************************************************
+//                                                      Recording
+//**********************************************************************************************************************
+void FrameStats::BeginFrame()
+{
+    m_current.frameIndex = m_framesRecorded;
+    fill(begin(m_current.values), end(m_current.values), NAN);
+    m_frameStart = chrono::steady_clock::now();
+}
+
+void FrameStats::EndFrame()
+{
+    m_current.values[FrameStatCpuTime] = chrono::duration<double, milli>(chrono::steady_clock::now() - m_frameStart).count();
+    for (uint i = 0; i < FrameStatCount; ++i)
+    {
+        if (FrameStatInfos[i].isCounter && isnan(m_current.values[i])) m_current.values[i] = 0.0;
+    }
+
+    m_frames[m_framesRecorded % m_frames.size()] = m_current;
+    m_framesRecorded++;
+}
+
+void FrameStats::Add(FrameStat stat, double value)
+{
+    double& current = m_current.values[stat];
+    current = isnan(current) ? value : current + value;
+}
+
+
+//**********************************************************************************************************************
+//                                                      Queries
+//**********************************************************************************************************************
+uint FrameStats::GetFrameCount() const
+{
+    return static_cast<uint>(min<uint64>(m_framesRecorded, m_frames.size()));
+}
+
+const FrameStats::FrameRecord& FrameStats::GetRecord(uint age) const
+{
+    const uint64 oldest = m_framesRecorded - GetFrameCount();
+    return m_frames[(oldest + age) % m_frames.size()];
+}
+
+FrameStatSummary FrameStats::Summarize(FrameStat stat) const
+{
+    FrameStatSummary summary = {};
+    FrameVector<double> samples(FrameArena::Resource());
+    samples.reserve(GetFrameCount());
+    double sum = 0.0;
+    for (uint i = 0; i < GetFrameCount(); ++i)
+    {
+        const double value = GetRecord(i).values[stat];
+        if (isnan(value)) continue;
+
+        samples.push_back(value);
+        sum += value;
+        summary.last = value;
+    }
+    if (samples.empty()) return summary;
+
+    sort(samples.begin(), samples.end());
+    summary.samples = static_cast<uint>(samples.size());
+    summary.mean    = sum / samples.size();
+    summary.min     = samples.front();
+    summary.max     = samples.back();
+    summary.p50     = Percentile(samples, 50.0);
+    summary.p95     = Percentile(samples, 95.0);
+    summary.p99     = Percentile(samples, 99.0);
+    return summary;
+}
+
+void FrameStats::GetHistory(FrameStat stat, FrameVector<float>& values) const
+{
+    values.clear();
+    for (uint i = 0; i < GetFrameCount(); ++i)
+    {
+        const double value = GetRecord(i).values[stat];
+        if (!isnan(value)) values.push_back(static_cast<float>(value));
+    }
+}
+
+const char* FrameStats::GetName(FrameStat stat)
+{
+    return FrameStatInfos[stat].pName;
+}
+
+
+//**********************************************************************************************************************
+//                                                      Output
+//**********************************************************************************************************************
+bool FrameStats::ExportCsv(const string& filename) const
+{
+    ofstream file(filename);
+    if (!file)
+    {
+        PrintMessage(Error, "Unable to open stats file \"{}\"", filename);
+        return false;
+    }
+
+    // unmeasured values are left empty
+    file << "frame";
+    for (const FrameStatInfo& info : FrameStatInfos) file << ',' << info.pName;
+    file << '\n';
+    for (uint i = 0; i < GetFrameCount(); ++i)
+    {
+        const FrameRecord& record = GetRecord(i);
+        file << record.frameIndex;
+        for (double value : record.values)
+        {
+            file << ',';
+            if (!isnan(value)) file << value;
+        }
+        file << '\n';
+    }
+
+    if (!file.good())
+    {
+        PrintMessage(Error, "Failed to write stats file \"{}\"", filename);
+        return false;
+    }
+    PrintMessage(Info, "Wrote {} frames of stats to \"{}\"", GetFrameCount(), filename);
+    return true;
+}
+
+void FrameStats::PrintSummary() const
+{
+    PrintMessage(Info, "Frame stats over the last {} frames:", GetFrameCount());
+    for (uint i = 0; i < FrameStatCount; ++i)
+    {
+        const FrameStatSummary summary = Summarize(static_cast<FrameStat>(i));
+        if (summary.samples == 0) continue;
+
+        PrintMessage(Info, "  {:<16} mean {:>12.3f}  p50 {:>12.3f}  p95 {:>12.3f}  p99 {:>12.3f}  max {:>12.3f}",
+                     FrameStatInfos[i].pLabel, summary.mean, summary.p50, summary.p95, summary.p99, summary.max);
+    }
+}
+
+void FrameStats::BuildUI()
+{
+    if (GetFrameCount() == 0)
+    {
+        ImGui::TextUnformatted("No frames recorded yet");
+        return;
+    }
+
+    // rolling summary of every stat, with a sparkline of its recent history
+    FrameVector<float> history(FrameArena::Resource());
+    history.reserve(GetFrameCount());
+    const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit;
+    if (ImGui::BeginTable("Frame Stats", 7, flags))
+    {
+        ImGui::TableSetupColumn("Stat");
+        ImGui::TableSetupColumn("Last");
+        ImGui::TableSetupColumn("p50");
+        ImGui::TableSetupColumn("p95");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableSetupColumn("Max");
+        ImGui::TableSetupColumn("History", ImGuiTableColumnFlags_WidthStretch);
+        ImGui::TableHeadersRow();
+
+        for (uint i = 0; i < FrameStatCount; ++i)
+        {
+            const FrameStat stat = static_cast<FrameStat>(i);
+            const FrameStatSummary summary = Summarize(stat);
+
+            ImGui::PushID(i);
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(FrameStatInfos[i].pLabel);
+            for (double value : {summary.last, summary.p50, summary.p95, summary.p99, summary.max})
+            {
+                ImGui::TableNextColumn();
+                if (summary.samples == 0)   ImGui::TextDisabled("-");
+                else                        ImGui::Text(ValueFormat(stat), value);
+            }
+            ImGui::TableNextColumn();
+            GetHistory(stat, history);
+            ImGui::PlotLines("##Sparkline", history.data(), static_cast<int>(history.size()), 0, nullptr, 0.0f,
+                             static_cast<float>(summary.max), ImVec2(-1.0f, ImGui::GetTextLineHeight()));
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+
+    // distribution of a single stat
+    ImGui::SetNextItemWidth(200.0f);
+    if (ImGui::BeginCombo("Histogram", FrameStatInfos[m_histogramStat].pLabel))
+    {
+        for (int i = 0; i < FrameStatCount; ++i)
+        {
+            if (ImGui::Selectable(FrameStatInfos[i].pLabel, i == m_histogramStat)) m_histogramStat = i;
+        }
+        ImGui::EndCombo();
+    }
+
+    const FrameStat stat = static_cast<FrameStat>(m_histogramStat);
+    const FrameStatSummary summary = Summarize(stat);
+    if (summary.samples > 0)
+    {
+        constexpr uint BinCount = 48;
+        float bins[BinCount] = {};
+        const double range = max(summary.max - summary.min, DBL_EPSILON);
+        GetHistory(stat, history);
+        for (float value : history)
+        {
+            bins[min(static_cast<uint>((value - summary.min) / range * BinCount), BinCount - 1)] += 1.0f;
+        }
+
+        const FrameString overlay = FrameFormat("p50 {:.3f}  p95 {:.3f}  p99 {:.3f}", summary.p50, summary.p95, summary.p99);
+        ImGui::PlotHistogram("##Histogram", bins, BinCount, 0, overlay.c_str(), 0.0f, FLT_MAX, ImVec2(-1.0f, 80.0f));
+        ImGui::Text(ValueFormat(stat), summary.min);
+        ImGui::SameLine(ImGui::GetContentRegionAvail().x - 80.0f);
+        ImGui::Text(ValueFormat(stat), summary.max);
+    }
+
+    if (ImGui::Button("Export CSV")) ExportCsv("frame_stats.csv");
+    ImGui::SameLine();
+    ImGui::Text("%u of %llu frames held", GetFrameCount(), (unsigned long long)m_framesRecorded);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "FrameArena.h"
+#include "Util.h"
+
+
+// Per-frame measurements. Times are in milliseconds, and are left unmeasured by backends which cannot provide them
+//  (e.g. GPU time on the null backend) rather than reported as zero.
+enum FrameStat
+{
+    FrameStatCpuTime,       // wall time of the frame on the render thread
+    FrameStatGpuTime,       // device execution time of the frame's submissions
+    FrameStatUpdateTime,    // engine and scene OnUpdate()
+    FrameStatRenderTime,    // scene recording and submission
+    FrameStatUiTime,        // building and recording the UI
+    FrameStatPresentTime,   // presenting and waiting on the frame's work
+    FrameStatDrawCalls,
+    FrameStatTriangles,
+    FrameStatUploadBytes,   // bytes written by the CPU into upload heaps
+    FrameStatCount
+};
+
+struct FrameStatSummary
+{
+    uint    samples;        // frames within the window which measured this stat
+    double  last;
+    double  mean;
+    double  min;
+    double  max;
+    double  p50;
+    double  p95;
+    double  p99;
+};
+
+
+// Records every stat of the last Capacity frames in a fixed ring, from which rolling percentiles, histograms and
+//  sparklines are computed on request. Nothing here depends on a window or device, so headless runs collect the same
+//  numbers as the windowed build and may export them as CSV for comparison between builds.
+class FrameStats
+{
+public:
+    static constexpr uint DefaultCapacity = 1024;
+
+    FrameStats(uint capacity = DefaultCapacity);
+
+    // resizes the ring, discarding everything recorded so far
+    void SetCapacity(uint capacity);
+
+    // frame boundaries, where ending a frame records its CPU time and commits it to the ring
+    void BeginFrame();
+    void EndFrame();
+
+    // accumulates into the frame in progress
+    void Add(FrameStat stat, double value);
+
+    // rolling statistics over the frames currently held
+    FrameStatSummary Summarize(FrameStat stat) const;
+    void GetHistory(FrameStat stat, FrameVector<float>& values) const;  // oldest first, unmeasured frames omitted
+    uint GetFrameCount() const;
+    uint64 GetFramesRecorded() const    {return m_framesRecorded;}
+
+    // output
+    bool ExportCsv(const std::string& filename) const;
+    void PrintSummary() const;
+    void BuildUI();
+
+    static const char* GetName(FrameStat stat);
+
+private:
+    struct FrameRecord
+    {
+        uint64  frameIndex;
+        double  values[FrameStatCount];     // NaN when not measured
+    };
+
+    const FrameRecord& GetRecord(uint age) const;   // zero being the oldest held
+
+    std::vector<FrameRecord>                m_frames;
+    uint64                                  m_framesRecorded;
+    FrameRecord                             m_current;
+    std::chrono::steady_clock::time_point   m_frameStart;
+
+    // UI state
+    int                                     m_histogramStat;
+};
+
+
+// Adds the lifetime of the enclosing scope, in milliseconds, to a time stat of the frame in progress.
+class FrameStatTimer
+{
+public:
+    FrameStatTimer(FrameStats& stats, FrameStat stat) :
+        m_stats(stats),
+        m_stat(stat),
+        m_start(std::chrono::steady_clock::now())
+    {
+    }
+    ~FrameStatTimer()
+    {
+        m_stats.Add(m_stat, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count());
+    }
+
+    FrameStatTimer(const FrameStatTimer&) = delete;
+    FrameStatTimer& operator=(const FrameStatTimer&) = delete;
+
+private:
+    FrameStats&                             m_stats;
+    FrameStat                               m_stat;
+    std::chrono::steady_clock::time_point   m_start;
+};
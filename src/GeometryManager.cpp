@@ -1,12 +1,21 @@
 #include "GeometryManager.h"
 
+#include <algorithm>
+
+#include "JobSystem.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
+#include "TaskGraph.h"
+
 using namespace std;
 
 
 GeometryManager::GeometryManager() :
     m_drawableCounter(0),
     m_meshCounter(0),
+    m_vertexStreams(VertexStreamsAll),
     m_pUploadBuffer(nullptr),
+    m_uploadBufferSize(0),
     m_uploadBufferOffset(0),
     m_pUploadBufferBegin(nullptr),
     m_pUploadBufferEnd(nullptr),
@@ -20,20 +29,14 @@ GeometryManager::~GeometryManager()
 
 void GeometryManager::Init()
 {
-    Dx12RenderEngine* pEngine = Dx12RenderEngine::pCurrentEngine;
-    auto* pDevice = pEngine->GetDevice();
+    MEMORY_SCOPE(MemoryTagGeometryManager);
+    RenderEngine* pEngine = RenderEngine::pCurrentEngine;
 
     // constant buffer for per-mesh per-frame data
     {
         const auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
         const auto bufferProps = CD3DX12_RESOURCE_DESC::Buffer(256 * 64);
-        CheckResult(pDevice->CreateCommittedResource(
-            &heapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &bufferProps,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&m_pConstantBuffer)));
+        CheckResult(pEngine->CreateResource(&heapProps, &bufferProps, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, &m_pConstantBuffer));
 
         CD3DX12_RANGE readRange(0, 0);
         CheckResult(m_pConstantBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_pConstantBufferDataDataBegin)));
@@ -44,17 +47,12 @@ void GeometryManager::Init()
         constexpr uint uploadBufferSize = 32*1024*1024;
         const auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
         const auto bufferProps = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
-        CheckResult(pDevice->CreateCommittedResource(
-            &heapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &bufferProps,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&m_pUploadBuffer)));
+        CheckResult(pEngine->CreateResource(&heapProps, &bufferProps, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, &m_pUploadBuffer));
 
         CD3DX12_RANGE readRange(0, 0);
         CheckResult(m_pUploadBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_pUploadBufferBegin)));
         m_pUploadBufferEnd = m_pUploadBufferBegin;
+        m_uploadBufferSize = uploadBufferSize;
         m_uploadBufferOffset = 0;
     }
     // default heap (committed resource) for geometry data
@@ -62,13 +60,7 @@ void GeometryManager::Init()
         constexpr uint geometryBufferSize = 8*1024*1024;
         const auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
         const auto bufferProps = CD3DX12_RESOURCE_DESC::Buffer(geometryBufferSize);
-        CheckResult(pDevice->CreateCommittedResource(
-            &heapProps,
-            D3D12_HEAP_FLAG_NONE,
-            &bufferProps,
-            D3D12_RESOURCE_STATE_GENERIC_READ,
-            nullptr,
-            IID_PPV_ARGS(&m_pGeometryBuffer)));
+        CheckResult(pEngine->CreateResource(&heapProps, &bufferProps, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, &m_pGeometryBuffer));
     }
 
     // set debug names
@@ -104,8 +96,8 @@ void GeometryManager::BuildUI()
         }
         if (dirty)
         {
+            // picked up by the next transform propagation, along with the bounds
             drawable.transformData.matrixDirty = true;
-            drawable.transformData.StoreTransformMatrixT(PointerByteIncrement(m_pConstantBufferDataDataBegin, 256*drawable.meshID));
         }
         ImGui::PopID();
     }
@@ -115,9 +107,37 @@ void GeometryManager::BuildUI()
 
 uint GeometryManager::AddMesh(string filename, bool addDrawable)
 {
-    Mesh* pMesh = new Mesh(filename);
+    PROFILE_FUNCTION();
+    MEMORY_SCOPE(MemoryTagGeometryManager);
+    return AddLoadedMesh(new Mesh(filename), addDrawable);
+}
+
+void GeometryManager::AddMeshes(const vector<string>& filenames, bool addDrawable)
+{
+    PROFILE_FUNCTION();
+    MEMORY_SCOPE(MemoryTagGeometryManager);
+
+    // parsing dominates, so files are loaded on the job system and then uploaded in order on this thread
+    vector<Mesh*> meshes(filenames.size());
+    JobSystem::Get().ParallelFor(static_cast<uint>(filenames.size()), [&](uint index)
+    {
+        MEMORY_SCOPE(MemoryTagGeometryManager);
+        meshes[index] = new Mesh(filenames[index]);
+    }, 1);
+
+    for (Mesh* pMesh : meshes)
+    {
+        AddLoadedMesh(pMesh, addDrawable);
+    }
+}
+
+uint GeometryManager::AddLoadedMesh(Mesh* pMesh, bool addDrawable)
+{
     m_Meshes.push_back(pMesh);
-    RegisterAndUploadMesh(pMesh);
+    m_meshBounds.push_back(pMesh->ComputeBounds());
+    m_meshConstants.emplace_back();
+    XMStoreFloat4x4(&m_meshConstants.back(), XMMatrixIdentity());
+    const bool uploaded = RegisterAndUploadMesh(pMesh);
 
     // we should only upload each mesh once unless there is an explicit AddMesh call for the same file
     uint meshCount = m_Meshes.size();
@@ -127,14 +147,14 @@ uint GeometryManager::AddMesh(string filename, bool addDrawable)
     if (addDrawable)
     {
         Drawable drawable = {};
-        drawable.shouldDraw     = true;
+        drawable.shouldDraw     = uploaded;
         drawable.drawableType   = StaticMeshDrawable;
         drawable.drawableID     = m_drawableCounter++;
         drawable.meshID         = m_meshCounter++;
         drawable.transformData  = TransformData();
         AddDrawable(drawable);
 
-        drawable.transformData.StoreTransformMatrix(&m_meshConstants[meshCount].modelMatrix);
+        drawable.transformData.StoreTransformMatrixT(&m_meshConstants[drawable.meshID]);
         drawable.transformData.StoreTransformMatrixT(PointerByteIncrement(m_pConstantBufferDataDataBegin, 256*drawable.meshID));
     }
 
@@ -143,45 +163,192 @@ uint GeometryManager::AddMesh(string filename, bool addDrawable)
 
 uint GeometryManager::AddDrawable(Drawable drawable)
 {
+    BoundingBox bounds;
+    m_meshBounds[drawable.meshID].Transform(bounds, drawable.transformData.GetTransformMatrix());
+
+    m_drawOrder.push_back(static_cast<uint>(m_drawables.size()));
     m_drawables.push_back(drawable);
+    m_drawableBounds.push_back(bounds);
+    m_visibility.push_back(1);
     return drawable.drawableID;
 }
 
-MeshBufferLayout GeometryManager::RegisterAndUploadMesh(Mesh* pMesh)
+void GeometryManager::AddTasks(TaskGraph& graph, Camera* pCamera)
+{
+    // culling and sorting only need the camera once it has moved, so propagation overlaps the camera update
+    graph.AddTask("Transform Propagation", [this] {UpdateTransforms();})
+        .Writes(&m_drawables)
+        .Measures(FrameStatUpdateTime);
+
+    graph.AddTask("Culling", [this, pCamera] {Cull(pCamera->GetViewMatrix() * pCamera->GetProjectionMatrix());})
+        .Reads(pCamera)
+        .Reads(&m_drawables)
+        .Writes(&m_drawOrder)
+        .Measures(FrameStatUpdateTime);
+
+    graph.AddTask("Draw Sorting", [this, pCamera] {SortDrawOrder(pCamera->GetViewMatrix());})
+        .Reads(pCamera)
+        .Reads(&m_drawables)
+        .Writes(&m_drawOrder)
+        .Measures(FrameStatUpdateTime);
+}
+
+void GeometryManager::UpdateTransforms()
+{
+    PROFILE_FUNCTION();
+    JobSystem::Get().ParallelFor(static_cast<uint>(m_drawables.size()), [this](uint index)
+    {
+        Drawable& drawable = m_drawables[index];
+        if (!drawable.transformData.matrixDirty) return;
+
+        drawable.transformData.UpdateTransformMatrix();
+        drawable.transformData.StoreTransformMatrixT(&m_meshConstants[drawable.meshID]);
+        drawable.transformData.StoreTransformMatrixT(PointerByteIncrement(m_pConstantBufferDataDataBegin, 256*drawable.meshID));
+        m_meshBounds[drawable.meshID].Transform(m_drawableBounds[index], drawable.transformData.GetTransformMatrix());
+    });
+}
+
+void GeometryManager::Cull(FXMMATRIX viewProjection)
+{
+    PROFILE_FUNCTION();
+
+    // with row vectors, each clip-space coordinate is a column of the matrix, so the planes are sums and differences
+    //  of rows of its transpose: -w <= x <= w, -w <= y <= w and 0 <= z <= w, which holds for reversed depth as well
+    const XMMATRIX columns = XMMatrixTranspose(viewProjection);
+    const XMVECTOR planes[6] =
+    {
+        XMVectorAdd(columns.r[3], columns.r[0]),
+        XMVectorSubtract(columns.r[3], columns.r[0]),
+        XMVectorAdd(columns.r[3], columns.r[1]),
+        XMVectorSubtract(columns.r[3], columns.r[1]),
+        columns.r[2],
+        XMVectorSubtract(columns.r[3], columns.r[2]),
+    };
+
+    JobSystem::Get().ParallelFor(static_cast<uint>(m_drawables.size()), [&](uint index)
+    {
+        const BoundingBox& bounds = m_drawableBounds[index];
+        const XMVECTOR center = XMVectorSetW(XMLoadFloat3(&bounds.Center), 1.0f);
+        const XMVECTOR extents = XMLoadFloat3(&bounds.Extents);
+
+        // outside if even the corner furthest along a plane's normal is behind it
+        bool visible = true;
+        for (const XMVECTOR& plane : planes)
+        {
+            const float distance = XMVectorGetX(XMVector4Dot(plane, center));
+            const float radius = XMVectorGetX(XMVector3Dot(XMVectorAbs(plane), extents));
+            if (distance + radius < 0.0f) {visible = false; break;}
+        }
+        m_visibility[index] = visible;
+    });
+
+    m_drawOrder.clear();
+    for (uint i = 0; i < m_drawables.size(); ++i)
+    {
+        if (m_visibility[i] && m_drawables[i].shouldDraw) m_drawOrder.push_back(i);
+    }
+}
+
+void GeometryManager::SortDrawOrder(FXMMATRIX view)
+{
+    PROFILE_FUNCTION();
+
+    m_sortKeys.clear();
+    for (uint index : m_drawOrder)
+    {
+        const XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&m_drawableBounds[index].Center), view);
+        m_sortKeys.push_back({XMVectorGetZ(center), index});
+    }
+    sort(m_sortKeys.begin(), m_sortKeys.end());
+
+    for (uint i = 0; i < m_sortKeys.size(); ++i)
+    {
+        m_drawOrder[i] = m_sortKeys[i].second;
+    }
+}
+
+void GeometryManager::AddVertexStreams(uint streams)
 {
-    MeshBufferLayout layout = pMesh->PopulateGeometryBuffer((void*)m_pUploadBufferEnd);
+    if ((streams & ~m_vertexStreams) == 0) return;
+    PROFILE_FUNCTION();
+    MEMORY_SCOPE(MemoryTagGeometryManager);
 
+    // The meshes uploaded so far are uploaded again after the last, with the widened streams. Their previous copies are
+    //  left where they are, as frames recorded already may still read them, and only the views are switched.
+    const uint newStreams = m_vertexStreams | streams;
+    uint64 size = 0;
+    for (const Mesh* pMesh : m_Meshes)
+    {
+        size += pMesh->GetGeometryBufferSize(newStreams);
+    }
+    if (size > m_uploadBufferSize - m_uploadBufferOffset)
+    {
+        LOG_ERROR("Geometry manager cannot add vertex streams {:#x}: meshes need {}B again, {}B are left",
+                  streams, size, m_uploadBufferSize - m_uploadBufferOffset);
+        return;
+    }
+
+    m_vertexStreams = newStreams;
+    for (size_t i = 0; i < m_Meshes.size(); ++i)
+    {
+        UploadMesh(m_Meshes[i], m_meshBufferViews[i]);
+    }
+    LOG_INFO("Geometry manager uploaded {} meshes again with vertex streams {:#x}", m_Meshes.size(), m_vertexStreams);
+}
+
+bool GeometryManager::RegisterAndUploadMesh(Mesh* pMesh)
+{
     MeshBufferViews newMeshViews = {};
+    const bool uploaded = UploadMesh(pMesh, newMeshViews);
+    m_meshBufferViews.push_back(newMeshViews);
+
+    return uploaded;
+}
+
+bool GeometryManager::UploadMesh(Mesh* pMesh, MeshBufferViews& newMeshViews)
+{
+    PROFILE_FUNCTION();
+    const uint size = pMesh->GetGeometryBufferSize(m_vertexStreams);
+    if (size > m_uploadBufferSize - m_uploadBufferOffset)
+    {
+        LOG_ERROR("Geometry manager upload buffer is full: a mesh needs {}B, {}B of {}B are left",
+                  size, m_uploadBufferSize - m_uploadBufferOffset, m_uploadBufferSize);
+        return false;
+    }
+
+    MeshBufferLayout layout = pMesh->PopulateGeometryBuffer((void*)m_pUploadBufferEnd, m_vertexStreams);
+
+    newMeshViews = {};
     auto baseOffset = m_pUploadBuffer->GetGPUVirtualAddress() + m_uploadBufferOffset;
-    newMeshViews.vertexBufferView.BufferLocation = baseOffset + layout.vertexOffset;
-    newMeshViews.colorBufferView.BufferLocation  = baseOffset + layout.colorOffset;
-    newMeshViews.normalBufferView.BufferLocation = baseOffset + layout.normalOffset;
-    newMeshViews.indexBufferView.BufferLocation  = baseOffset + layout.facesOffset;
-
-    newMeshViews.vertexBufferView.SizeInBytes = layout.vertexSize;
-    newMeshViews.colorBufferView.SizeInBytes  = layout.colorSize;
-    newMeshViews.normalBufferView.SizeInBytes = layout.normalSize;
-    newMeshViews.indexBufferView.SizeInBytes  = layout.facesSize;
-
-    newMeshViews.vertexBufferView.StrideInBytes = sizeof(aiVector3D);
-    newMeshViews.colorBufferView.StrideInBytes  = sizeof(aiColor4D);
-    newMeshViews.normalBufferView.StrideInBytes = sizeof(aiVector3D);
+    const uint streamOffsets[VertexStreamCount] = {layout.vertexOffset, layout.colorOffset, layout.normalOffset};
+    const uint streamSizes[VertexStreamCount]   = {layout.vertexSize, layout.colorSize, layout.normalSize};
+    for (uint stream = 0; stream < VertexStreamCount; ++stream)
+    {
+        if (!(m_vertexStreams & (1u << stream))) continue;
+
+        D3D12_VERTEX_BUFFER_VIEW& view = newMeshViews.streamViews[stream];
+        view.BufferLocation = baseOffset + streamOffsets[stream];
+        view.SizeInBytes    = streamSizes[stream];
+        view.StrideInBytes  = VertexStreamInfos[stream].stride;
+    }
+    newMeshViews.indexBufferView.BufferLocation = baseOffset + layout.facesOffset;
+    newMeshViews.indexBufferView.SizeInBytes    = layout.facesSize;
     newMeshViews.indexBufferView.Format         = DXGI_FORMAT_R32_UINT;
 
-    PrintMessage("\nVertex Buffer: {}B @ {}"
-                 "\nColor Buffer:  {}B @ {}"
-                 "\nNormal Buffer: {}B @ {}"
-                 "\nIndex Buffer:  {}B @ {}"
-                 "\n",
-                 newMeshViews.vertexBufferView.SizeInBytes, newMeshViews.vertexBufferView.BufferLocation,
-                 newMeshViews.colorBufferView.SizeInBytes, newMeshViews.colorBufferView.BufferLocation,
-                 newMeshViews.normalBufferView.SizeInBytes, newMeshViews.normalBufferView.BufferLocation,
-                 newMeshViews.indexBufferView.SizeInBytes, newMeshViews.indexBufferView.BufferLocation
-                 );
+    const D3D12_VERTEX_BUFFER_VIEW* pStreamViews = newMeshViews.streamViews;
+    LOG_DEBUG("\nVertex Buffer: {}B @ {}"
+              "\nColor Buffer:  {}B @ {}"
+              "\nNormal Buffer: {}B @ {}"
+              "\nIndex Buffer:  {}B @ {}",
+              pStreamViews[VertexStreamPosition].SizeInBytes, pStreamViews[VertexStreamPosition].BufferLocation,
+              pStreamViews[VertexStreamColor].SizeInBytes, pStreamViews[VertexStreamColor].BufferLocation,
+              pStreamViews[VertexStreamNormal].SizeInBytes, pStreamViews[VertexStreamNormal].BufferLocation,
+              newMeshViews.indexBufferView.SizeInBytes, newMeshViews.indexBufferView.BufferLocation
+              );
 
     m_pUploadBufferEnd += layout.totalSize;
     m_uploadBufferOffset += layout.totalSize;
-    m_meshBufferViews.push_back(newMeshViews);
+    RenderEngine::pCurrentEngine->GetFrameStats().Add(FrameStatUploadBytes, layout.totalSize);
 
-    return layout;
+    return true;
 }
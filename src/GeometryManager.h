@@ -4,11 +4,18 @@
 #include <string>
 #include <vector>
 
-#include "Dx12RenderEngine.h"
+#include <imgui.h>
+
+#include "Camera.h"
+#include "RenderEngine.h"
 #include "Mesh.h"
 #include "Util.h"
 #include "Util3D.h"
 
+using namespace DirectX;
+
+class TaskGraph;
+
 
 enum DrawableType
 {
@@ -48,10 +55,8 @@ struct Drawable
 // data for static meshes
 struct MeshBufferViews
 {
-    D3D12_VERTEX_BUFFER_VIEW vertexBufferView;  // triangle vertices
-    D3D12_VERTEX_BUFFER_VIEW colorBufferView;   // per-vertex colors
-    D3D12_VERTEX_BUFFER_VIEW normalBufferView;  // per-vertex normals
-    D3D12_INDEX_BUFFER_VIEW  indexBufferView;   // triangle indices
+    D3D12_VERTEX_BUFFER_VIEW streamViews[VertexStreamCount];    // by VertexStream, empty for those not uploaded
+    D3D12_INDEX_BUFFER_VIEW  indexBufferView;                   // triangle indices
 };
 
 
@@ -67,20 +72,37 @@ public:
     void Init();
     void BuildUI();
 
+    // The vertex streams uploaded for meshes added from then on, which are all of them unless narrowed to those the
+    //  pipelines drawing the meshes read. Adding streams later uploads the meshes added so far again, with them.
+    void SetVertexStreams(uint streams)                     {m_vertexStreams = streams;}
+    void AddVertexStreams(uint streams);
+    uint GetVertexStreams() const                           {return m_vertexStreams;}
+
     uint AddMesh(std::string filename, bool addDrawable=true);
+    void AddMeshes(const std::vector<std::string>& filenames, bool addDrawable=true);    // loaded in parallel
+
+    // per-frame stages, run as tasks of the frame graph
+    void AddTasks(TaskGraph& graph, Camera* pCamera);
+    void UpdateTransforms();                        // rebuilds dirty model matrices and world-space bounds
+    void Cull(FXMMATRIX viewProjection);            // keeps drawables whose bounds intersect the view frustum
+    void SortDrawOrder(FXMMATRIX view);             // front to back, to make the most of early depth rejection
 
     // TODO: replace vectors with maps or lists to allow removal
     std::vector<Drawable>* GetDrawables()                   {return &m_drawables;}
-    Drawable GetDrawable(uint index)                        {return m_drawables[index];}
+    const Drawable& GetDrawable(uint index)                 {return m_drawables[index];}
     Mesh* GetMesh(uint index)                               {return m_Meshes[index];}
     std::vector<MeshBufferViews>* GetMeshBufferViews()      {return &m_meshBufferViews;}
-    MeshBufferViews GetMeshBufferView(uint index)           {return m_meshBufferViews[index];}
+    const MeshBufferViews& GetMeshBufferView(uint index)    {return m_meshBufferViews[index];}
+    const std::vector<uint>* GetDrawOrder()                 {return &m_drawOrder;}  // visible drawables, in order
     ID3D12Resource* GetConstantBufferResource()             {return m_pConstantBuffer.Get();}
     uint64 GetConstantBufferOffset(uint index)              {return m_pConstantBuffer->GetGPUVirtualAddress() + 256*index;}
+    const XMFLOAT4X4& GetMeshConstants(uint index) const    {return m_meshConstants[index];}    // for root constants
 
 protected:
+    uint AddLoadedMesh(Mesh* pMesh, bool addDrawable);
     uint AddDrawable(Drawable drawable);
-    MeshBufferLayout RegisterAndUploadMesh(Mesh* pMesh);
+    bool RegisterAndUploadMesh(Mesh* pMesh);
+    bool UploadMesh(Mesh* pMesh, MeshBufferViews& newMeshViews);   // false, leaving the views, if out of room
 
 
     // identifiers
@@ -91,13 +113,24 @@ protected:
     std::vector<Drawable>               m_drawables;            // per-instance geometry data
     std::vector<Mesh*>                  m_Meshes;               // CPU-side mesh representations
 
+    // visibility, refreshed every frame by the culling and sorting stages
+    std::vector<BoundingBox>            m_meshBounds;           // object-space, per mesh
+    std::vector<BoundingBox>            m_drawableBounds;       // world-space, per drawable
+    std::vector<uint8_t>                m_visibility;           // per drawable, written in parallel by Cull()
+    std::vector<uint>                   m_drawOrder;            // indices of the drawables to draw
+    std::vector<std::pair<float, uint>> m_sortKeys;             // view depth and index, kept to reuse the allocation
+
     // constant buffer for per-mesh data
     ComPtr<ID3D12Resource>              m_pConstantBuffer;
     UINT8*                              m_pConstantBufferDataDataBegin;
-    MeshConstants                       m_meshConstants[64];
+    std::vector<XMFLOAT4X4>             m_meshConstants;        // per mesh, a copy of the buffer's model matrices
+
+    // vertex streams uploaded, as a mask of VertexStream bits
+    uint                                m_vertexStreams;
 
     // upload buffer for shipping geometry data to GPU
     ComPtr<ID3D12Resource>              m_pUploadBuffer;        // generic CPU->GPU uploads
+    uint                                m_uploadBufferSize;
     uint                                m_uploadBufferOffset;   // offset to next free spot in upload buffer
     UINT8*                              m_pUploadBufferBegin;   // start of mapped region
     UINT8*                              m_pUploadBufferEnd;     // end of last added element
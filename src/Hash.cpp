@@ -0,0 +1,101 @@
+#include "Hash.h"
+
+#include <cstring>
+
+using namespace std;
+
+
+namespace
+{
+    // the xxHash64 primes, and the MurmurHash3 finalizer to spread every bit of a lane across the result
+    constexpr uint64 Prime1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64 Prime2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr uint64 Prime3 = 0x165667B19E3779F9ull;
+
+    uint64 RotateLeft(uint64 value, int bits)
+    {
+        return (value << bits) | (value >> (64 - bits));
+    }
+
+    uint64 Avalanche(uint64 value)
+    {
+        value ^= value >> 33;
+        value *= 0xFF51AFD7ED558CCDull;
+        value ^= value >> 33;
+        value *= 0xC4CEB9FE1A85EC53ull;
+        value ^= value >> 33;
+        return value;
+    }
+}
+
+
+string Hash128::ToString() const
+{
+    return fmt::format("{:016x}{:016x}", high, low);
+}
+
+Hasher::Hasher() :
+    m_lanes{Prime1, Prime2},
+    m_pending(0),
+    m_pendingBytes(0),
+    m_length(0)
+{
+}
+
+void Hasher::Round(uint64 (&lanes)[2], uint64 word)
+{
+    // two lanes with different rounds, so that a collision in one is no more likely to be a collision in the other
+    lanes[0] = RotateLeft(lanes[0] + word * Prime2, 31) * Prime1;
+    lanes[1] = RotateLeft(lanes[1] ^ (word * Prime3), 27) * Prime1 + Prime2;
+}
+
+void Hasher::Add(const void* pData, size_t size)
+{
+    const uint8_t* pBytes = static_cast<const uint8_t*>(pData);
+    m_length += size;
+
+    // top up a word left partial by the last call, then take whole words straight from the data
+    for (; m_pendingBytes != 0 && size != 0; ++pBytes, --size)
+    {
+        m_pending |= uint64(*pBytes) << (8 * m_pendingBytes);
+        if (++m_pendingBytes == 8)
+        {
+            Round(m_lanes, m_pending);
+            m_pending = 0;
+            m_pendingBytes = 0;
+        }
+    }
+    for (; size >= 8; pBytes += 8, size -= 8)
+    {
+        uint64 word;
+        memcpy(&word, pBytes, sizeof(word));
+        Round(m_lanes, word);
+    }
+    for (; size != 0; ++pBytes, --size)
+    {
+        m_pending |= uint64(*pBytes) << (8 * m_pendingBytes++);
+    }
+}
+
+void Hasher::Add(string_view text)
+{
+    Add(uint64(text.size()));
+    Add(text.data(), text.size());
+}
+
+void Hasher::Add(wstring_view text)
+{
+    Add(uint64(text.size()));
+    Add(text.data(), text.size() * sizeof(wchar_t));
+}
+
+Hash128 Hasher::Finish() const
+{
+    uint64 lanes[2] = {m_lanes[0], m_lanes[1]};
+    if (m_pendingBytes != 0) Round(lanes, m_pending);
+
+    Hash128 hash;
+    hash.high = Avalanche(lanes[0] ^ m_length);
+    hash.low = Avalanche(lanes[1] + RotateLeft(lanes[0], 17) + m_length * Prime3);
+    return hash;
+}
@@ -0,0 +1,43 @@
+// Hash - Streaming 128-bit hash of bytes and strings, for content addressing and change detection.
+//
+// The two lanes are rounds of xxHash64 with different mixing, finished by the MurmurHash3 finalizer. It is not
+//  cryptographic, but spreads every input bit across the result, so either half on its own still makes a good 64-bit
+//  hash. Strings are hashed with their length, so that consecutive strings cannot run together into the same bytes.
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "Util.h"
+
+
+struct Hash128
+{
+    uint64  high;
+    uint64  low;
+
+    std::string ToString() const;   // 32 hex digits
+    bool operator==(const Hash128& other) const         {return high == other.high && low == other.low;}
+};
+
+
+class Hasher
+{
+public:
+    Hasher();
+
+    void Add(const void* pData, size_t size);
+    void Add(std::string_view text);
+    void Add(std::wstring_view text);
+    void Add(uint64 value)                          {Add(&value, sizeof(value));}
+
+    Hash128 Finish() const;                         // of everything added so far, which more may follow
+
+private:
+    static void Round(uint64 (&lanes)[2], uint64 word);
+
+    uint64  m_lanes[2];
+    uint64  m_pending;                              // bytes not yet making up a whole word
+    uint    m_pendingBytes;
+    uint64  m_length;
+};
@@ -0,0 +1,291 @@
+#include "ImageWriter.h"
+
+#include <array>
+#include <cstring>
+#include <DirectXPackedVector.h>
+
+using namespace std;
+
+
+namespace
+{
+    //******************************************************************************************************************
+    //                                                  Byte Output
+    //******************************************************************************************************************
+    void Append(vector<UINT8>& out, const void* pData, size_t size)
+    {
+        const UINT8* pBytes = static_cast<const UINT8*>(pData);
+        out.insert(out.end(), pBytes, pBytes + size);
+    }
+
+    void AppendU32BigEndian(vector<UINT8>& out, uint32_t value)
+    {
+        const UINT8 bytes[4] = {UINT8(value >> 24), UINT8(value >> 16), UINT8(value >> 8), UINT8(value)};
+        Append(out, bytes, sizeof(bytes));
+    }
+
+    // EXR is little endian throughout, as is every platform Shade runs on
+    template <typename T>
+    void AppendLittleEndian(vector<UINT8>& out, T value)
+    {
+        Append(out, &value, sizeof(value));
+    }
+
+    void AppendString(vector<UINT8>& out, const char* pString)
+    {
+        Append(out, pString, strlen(pString) + 1);
+    }
+
+
+    //******************************************************************************************************************
+    //                                                      PNG
+    //******************************************************************************************************************
+    uint32_t Crc32(const UINT8* pData, size_t size)
+    {
+        static const auto table = []()
+        {
+            array<uint32_t, 256> table = {};
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k) c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+                table[i] = c;
+            }
+            return table;
+        }();
+
+        uint32_t crc = 0xFFFFFFFFu;
+        for (size_t i = 0; i < size; ++i)
+        {
+            crc = table[(crc ^ pData[i]) & 0xFF] ^ (crc >> 8);
+        }
+        return crc ^ 0xFFFFFFFFu;
+    }
+
+    // running Adler-32, deferring the modulo for as long as the sums cannot overflow
+    struct Adler32
+    {
+        uint32_t a = 1;
+        uint32_t b = 0;
+
+        void Update(const UINT8* pData, size_t size)
+        {
+            constexpr size_t MaxRun = 5552;
+            while (size > 0)
+            {
+                const size_t run = min(size, MaxRun);
+                for (size_t i = 0; i < run; ++i)
+                {
+                    a += pData[i];
+                    b += a;
+                }
+                a %= 65521;
+                b %= 65521;
+                pData += run;
+                size -= run;
+            }
+        }
+        uint32_t Value() const  {return (b << 16) | a;}
+    };
+
+    // writes a chunk whose data has already been appended after its length and type
+    void FinishPngChunk(vector<UINT8>& out, size_t chunkStart)
+    {
+        const size_t dataSize = out.size() - chunkStart - 8;
+        const UINT8 length[4] = {UINT8(dataSize >> 24), UINT8(dataSize >> 16), UINT8(dataSize >> 8), UINT8(dataSize)};
+        memcpy(out.data() + chunkStart, length, sizeof(length));
+        AppendU32BigEndian(out, Crc32(out.data() + chunkStart + 4, dataSize + 4));
+    }
+
+    size_t BeginPngChunk(vector<UINT8>& out, const char type[4])
+    {
+        const size_t chunkStart = out.size();
+        AppendU32BigEndian(out, 0);     // length, filled in by FinishPngChunk()
+        Append(out, type, 4);
+        return chunkStart;
+    }
+
+    // Scanlines are stored unfiltered in stored deflate blocks. Compression would cost far more than the copy, and the
+    //  files are typically short-lived regression and turntable frames.
+    void EncodePng(const UINT8* pPixels, uint width, uint height, uint rowPitch, vector<UINT8>& out)
+    {
+        constexpr size_t MaxStoredBlock = 65535;
+        const size_t rowBytes = size_t(width) * 4;
+        const size_t rawSize = (rowBytes + 1) * height;
+        const size_t blockCount = max<size_t>((rawSize + MaxStoredBlock - 1) / MaxStoredBlock, 1);
+        out.reserve(rawSize + blockCount * 5 + 128);
+
+        static const UINT8 signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        Append(out, signature, sizeof(signature));
+
+        // header: 8 bit RGBA, no interlacing
+        size_t chunk = BeginPngChunk(out, "IHDR");
+        AppendU32BigEndian(out, width);
+        AppendU32BigEndian(out, height);
+        const UINT8 format[5] = {8, 6, 0, 0, 0};
+        Append(out, format, sizeof(format));
+        FinishPngChunk(out, chunk);
+
+        // image data as a single zlib stream
+        chunk = BeginPngChunk(out, "IDAT");
+        const UINT8 zlibHeader[2] = {0x78, 0x01};
+        Append(out, zlibHeader, sizeof(zlibHeader));
+
+        Adler32 adler;
+        size_t remaining = rawSize;
+        size_t blockRemaining = 0;
+        const auto AppendRaw = [&](const UINT8* pData, size_t size)
+        {
+            adler.Update(pData, size);
+            while (size > 0)
+            {
+                if (blockRemaining == 0)
+                {
+                    const uint16_t length = static_cast<uint16_t>(min(remaining, MaxStoredBlock));
+                    const UINT8 blockHeader[5] = {UINT8(remaining <= MaxStoredBlock ? 1 : 0),
+                                                  UINT8(length), UINT8(length >> 8), UINT8(~length), UINT8(~length >> 8)};
+                    Append(out, blockHeader, sizeof(blockHeader));
+                    blockRemaining = length;
+                }
+
+                const size_t run = min(size, blockRemaining);
+                Append(out, pData, run);
+                pData += run;
+                size -= run;
+                blockRemaining -= run;
+                remaining -= run;
+            }
+        };
+
+        const UINT8 filterNone = 0;
+        for (uint y = 0; y < height; ++y)
+        {
+            AppendRaw(&filterNone, 1);
+            AppendRaw(pPixels + size_t(y) * rowPitch, rowBytes);
+        }
+        AppendU32BigEndian(out, adler.Value());
+        FinishPngChunk(out, chunk);
+
+        chunk = BeginPngChunk(out, "IEND");
+        FinishPngChunk(out, chunk);
+    }
+
+
+    //******************************************************************************************************************
+    //                                                      EXR
+    //******************************************************************************************************************
+    template <typename T>
+    void AppendExrAttribute(vector<UINT8>& out, const char* pName, const char* pType, const T& value)
+    {
+        AppendString(out, pName);
+        AppendString(out, pType);
+        AppendLittleEndian<int32_t>(out, sizeof(T));
+        Append(out, &value, sizeof(T));
+    }
+
+    // Single scanline chunks of half floats, with channels in the alphabetical order the format requires. Values are
+    //  the render target's normalized values, without any transfer function applied.
+    void EncodeExr(const UINT8* pPixels, uint width, uint height, uint rowPitch, vector<UINT8>& out)
+    {
+        using namespace DirectX::PackedVector;
+
+        static const auto unormToHalf = []()
+        {
+            array<HALF, 256> table = {};
+            for (uint i = 0; i < 256; ++i) table[i] = XMConvertFloatToHalf(i / 255.0f);
+            return table;
+        }();
+
+        const size_t lineDataSize = size_t(width) * 4 * sizeof(HALF);
+        out.reserve((lineDataSize + 16) * height + 512);
+
+        const UINT8 magic[4] = {0x76, 0x2F, 0x31, 0x01};
+        Append(out, magic, sizeof(magic));
+        AppendLittleEndian<int32_t>(out, 2);    // version 2, single part scanline image
+
+        // channel list, each being a name, HALF, linear flag, reserved bytes, and x/y sampling
+        const char* channelNames[] = {"A", "B", "G", "R"};
+        AppendString(out, "channels");
+        AppendString(out, "chlist");
+        AppendLittleEndian<int32_t>(out, _countof(channelNames) * 18 + 1);
+        for (const char* pName : channelNames)
+        {
+            AppendString(out, pName);
+            AppendLittleEndian<int32_t>(out, 1);
+            AppendLittleEndian<int32_t>(out, 0);
+            AppendLittleEndian<int32_t>(out, 1);
+            AppendLittleEndian<int32_t>(out, 1);
+        }
+        out.push_back(0);
+
+        const int32_t window[4] = {0, 0, int32_t(width) - 1, int32_t(height) - 1};
+        const float screenWindowCenter[2] = {0.0f, 0.0f};
+        AppendExrAttribute(out, "compression", "compression", UINT8(0));
+        AppendExrAttribute(out, "dataWindow", "box2i", window);
+        AppendExrAttribute(out, "displayWindow", "box2i", window);
+        AppendExrAttribute(out, "lineOrder", "lineOrder", UINT8(0));
+        AppendExrAttribute(out, "pixelAspectRatio", "float", 1.0f);
+        AppendExrAttribute(out, "screenWindowCenter", "v2f", screenWindowCenter);
+        AppendExrAttribute(out, "screenWindowWidth", "float", 1.0f);
+        out.push_back(0);
+
+        // offset table, every chunk being the same size
+        const uint64_t firstChunk = out.size() + uint64_t(height) * sizeof(uint64_t);
+        for (uint y = 0; y < height; ++y)
+        {
+            AppendLittleEndian<uint64_t>(out, firstChunk + y * (lineDataSize + 8));
+        }
+
+        // scanlines, planar by channel
+        static const uint channelOffsets[] = {3, 2, 1, 0};   // A, B, G, R within RGBA8
+        const size_t dataStart = out.size();
+        out.resize(dataStart + height * (lineDataSize + 8));
+        UINT8* pOut = out.data() + dataStart;
+        for (uint y = 0; y < height; ++y)
+        {
+            const int32_t header[2] = {int32_t(y), int32_t(lineDataSize)};
+            memcpy(pOut, header, sizeof(header));
+            HALF* pHalfs = reinterpret_cast<HALF*>(pOut + sizeof(header));
+
+            const UINT8* pRow = pPixels + size_t(y) * rowPitch;
+            for (uint channelOffset : channelOffsets)
+            {
+                for (uint x = 0; x < width; ++x) *pHalfs++ = unormToHalf[pRow[x * 4 + channelOffset]];
+            }
+            pOut += lineDataSize + 8;
+        }
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                  Image Output
+//**********************************************************************************************************************
+bool EncodeImage(ImageFileFormat format, const UINT8* pPixels, uint width, uint height, uint rowPitch,
+                 vector<UINT8>& encoded)
+{
+    encoded.clear();
+    if (width == 0 || height == 0 || rowPitch < width * 4) return false;
+
+    switch (format)
+    {
+    case ImageFileFormatPng:    EncodePng(pPixels, width, height, rowPitch, encoded); return true;
+    case ImageFileFormatExr:    EncodeExr(pPixels, width, height, rowPitch, encoded); return true;
+    default:                    return false;
+    }
+}
+
+bool WriteImage(const string& filename, ImageFileFormat format, const UINT8* pPixels, uint width, uint height, uint rowPitch)
+{
+    vector<UINT8> encoded;
+    if (!EncodeImage(format, pPixels, width, height, rowPitch, encoded)) return false;
+
+    ofstream file(filename, ios::binary);
+    file.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+    return file.good();
+}
+
+const char* ImageFileExtension(ImageFileFormat format)
+{
+    return (format == ImageFileFormatExr) ? ".exr" : ".png";
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Util.h"
+
+
+enum ImageFileFormat
+{
+    ImageFileFormatPng,
+    ImageFileFormatExr,
+};
+
+
+// Minimal encoders for dumping RGBA8 frames, with no dependencies beyond the standard library. Both are tuned for
+//  throughput rather than size: PNGs are written with stored (uncompressed) deflate blocks, and EXRs as uncompressed
+//  half-float scanlines. Encoding reuses the caller's buffer so that repeated frames do not allocate.
+//
+// TODO: optional compression for archival output
+bool EncodeImage(ImageFileFormat format, const UINT8* pPixels, uint width, uint height, uint rowPitch,
+                 std::vector<UINT8>& encoded);
+bool WriteImage(const std::string& filename, ImageFileFormat format, const UINT8* pPixels, uint width, uint height,
+                uint rowPitch);
+
+const char* ImageFileExtension(ImageFileFormat format);
@@ -0,0 +1,397 @@
+#include "JobSystem.h"
+
+#include <cassert>
+
+#include "MemoryTracker.h"
+#include "Profiler.h"
+
+using namespace std;
+
+
+namespace
+{
+    constexpr uint SpinsBeforeSleep = 64;   // failed searches before an idle worker sleeps, or a waiter yields
+
+    // the pool the current thread works for, and its index there
+    thread_local const JobSystem*   t_pSystem       = nullptr;
+    thread_local uint               t_threadIndex   = 0;
+}
+
+
+//**********************************************************************************************************************
+//                                                      JobDeque
+//**********************************************************************************************************************
+JobDeque::JobDeque() :
+    m_top(0),
+    m_bottom(0),
+    m_pJobs(make_unique<atomic<Job*>[]>(Capacity))
+{
+}
+
+bool JobDeque::Push(Job* pJob)
+{
+    const int64_t bottom = m_bottom.load(memory_order_relaxed);
+    const int64_t top = m_top.load(memory_order_acquire);
+    if (bottom - top >= Capacity) return false;
+
+    // release on the slot as well as the fence makes the job's contents visible to a thief which loads it with acquire
+    m_pJobs[bottom & (Capacity - 1)].store(pJob, memory_order_release);
+    atomic_thread_fence(memory_order_release);
+    m_bottom.store(bottom + 1, memory_order_relaxed);
+    return true;
+}
+
+Job* JobDeque::Pop()
+{
+    const int64_t bottom = m_bottom.load(memory_order_relaxed) - 1;
+    m_bottom.store(bottom, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t top = m_top.load(memory_order_relaxed);
+
+    if (top > bottom)
+    {
+        m_bottom.store(bottom + 1, memory_order_relaxed);
+        return nullptr;
+    }
+
+    Job* pJob = m_pJobs[bottom & (Capacity - 1)].load(memory_order_relaxed);
+    if (top == bottom)
+    {
+        // the last job, which a thief may be taking at the same time
+        if (!m_top.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed)) pJob = nullptr;
+        m_bottom.store(bottom + 1, memory_order_relaxed);
+    }
+    return pJob;
+}
+
+Job* JobDeque::Steal()
+{
+    int64_t top = m_top.load(memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    const int64_t bottom = m_bottom.load(memory_order_acquire);
+    if (top >= bottom) return nullptr;
+
+    Job* pJob = m_pJobs[top & (Capacity - 1)].load(memory_order_acquire);
+    if (!m_top.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed)) return nullptr;
+    return pJob;
+}
+
+
+//**********************************************************************************************************************
+//                                              Constructors & Destructors
+//**********************************************************************************************************************
+JobSystem::JobSystem(uint threadCount) :
+    m_mainThreadId(this_thread::get_id()),
+    m_externalCount(0),
+    m_mainThreadCount(0),
+    m_sleepers(0),
+    m_wakeGeneration(0),
+    m_exiting(false)
+{
+    if (threadCount == 0) threadCount = max(1u, thread::hardware_concurrency());
+
+    m_deques.resize(threadCount);
+    for (unique_ptr<JobDeque>& pDeque : m_deques) pDeque = make_unique<JobDeque>();
+
+    // value initialization leaves every job finished, so any slot may be taken first
+    m_rings.resize(threadCount + 1);
+    for (JobRing& ring : m_rings) ring = {make_unique<Job[]>(JobsPerThread), 0};
+
+    t_pSystem = this;
+    t_threadIndex = 0;
+
+    // the calling thread acts as thread zero
+    for (uint i = 1; i < threadCount; ++i)
+    {
+        m_workers.emplace_back(&JobSystem::WorkerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        lock_guard<mutex> lock(m_sleepMutex);
+        m_exiting = true;
+        m_wakeGeneration++;
+    }
+    m_wakeCondition.notify_all();
+
+    for (thread& worker : m_workers)
+    {
+        worker.join();
+    }
+
+    if (t_pSystem == this) t_pSystem = nullptr;
+}
+
+JobSystem& JobSystem::Get()
+{
+    static JobSystem jobSystem;
+    return jobSystem;
+}
+
+
+//**********************************************************************************************************************
+//                                                  Primary Interfaces
+//**********************************************************************************************************************
+Job* JobSystem::CreateEmptyJob(Job* pParent)
+{
+    return AllocateJob(pParent);
+}
+
+void JobSystem::AddDependency(Job* pJob, Job* pPrerequisite)
+{
+    // a prerequisite whose continuations are full passes its dependents on to the empty job in its last one
+    while (pPrerequisite->continuationCount.load(memory_order_relaxed) == Job::MaxContinuations)
+    {
+        pPrerequisite = pPrerequisite->continuations[Job::MaxContinuations - 1];
+    }
+
+    // The last continuation left becomes an empty job, whose blocker until submission stands for the prerequisite, so
+    //  that the prerequisite finishing queues it and it queues the dependents joined to it in turn.
+    uint index = pPrerequisite->continuationCount.load(memory_order_relaxed);
+    if (index == Job::MaxContinuations - 1)
+    {
+        Job* pJoin = CreateEmptyJob();
+        pPrerequisite->continuations[index] = pJoin;
+        pPrerequisite->continuationCount.store(Job::MaxContinuations, memory_order_relaxed);
+        pPrerequisite = pJoin;
+        index = 0;
+    }
+
+    pJob->blockers.fetch_add(1, memory_order_relaxed);
+    pPrerequisite->continuations[index] = pJob;
+    pPrerequisite->continuationCount.store(index + 1, memory_order_relaxed);
+}
+
+void JobSystem::Submit(Job* pJob)
+{
+    // the last of the submission and the prerequisites to finish queues the job
+    if (pJob->blockers.fetch_sub(1, memory_order_acq_rel) == 1) Enqueue(pJob);
+}
+
+void JobSystem::Wait(const Job* pJob)
+{
+    const uint threadIndex = GetThreadIndex();
+    uint idleCount = 0;
+
+    while (!IsFinished(pJob))
+    {
+        if (threadIndex != ExternalThread && RunOne(threadIndex))
+        {
+            idleCount = 0;
+        }
+        else if (++idleCount >= SpinsBeforeSleep)
+        {
+            this_thread::yield();
+        }
+    }
+}
+
+void JobSystem::RunMainThreadJobs()
+{
+    assert(GetThreadIndex() == 0 && "main thread jobs may only be run by the main thread");
+
+    while (m_mainThreadCount.load(memory_order_acquire) > 0)
+    {
+        Job* pJob = nullptr;
+        {
+            lock_guard<mutex> lock(m_mainThreadMutex);
+            if (m_mainThreadJobs.empty()) return;
+            pJob = m_mainThreadJobs.front();
+            m_mainThreadJobs.pop_front();
+            m_mainThreadCount--;
+        }
+        Execute(pJob);
+    }
+}
+
+uint JobSystem::GetThreadIndex() const
+{
+    if (t_pSystem == this) return t_threadIndex;
+    return (this_thread::get_id() == m_mainThreadId) ? 0 : ExternalThread;
+}
+
+
+//**********************************************************************************************************************
+//                                                      Scheduling
+//**********************************************************************************************************************
+Job* JobSystem::AllocateJob(Job* pParent)
+{
+    const uint threadIndex = GetThreadIndex();
+    const bool external = (threadIndex == ExternalThread);
+
+    unique_lock<mutex> lock(m_externalMutex, defer_lock);
+    if (external) lock.lock();
+
+    // jobs which are still running, such as the roots of enclosing parallel loops, are stepped over
+    JobRing& ring = m_rings[external ? GetThreadCount() : threadIndex];
+    Job* pJob = &ring.pJobs[ring.next++ % JobsPerThread];
+    for (uint skipped = 1; !IsFinished(pJob); ++skipped)
+    {
+        assert(skipped < JobsPerThread && "job ring overflow, too many jobs in flight from one thread");
+        pJob = &ring.pJobs[ring.next++ % JobsPerThread];
+    }
+
+    pJob->function = nullptr;
+    pJob->pParent = pParent;
+    pJob->unfinished.store(1, memory_order_relaxed);
+    pJob->blockers.store(1, memory_order_relaxed);
+    pJob->continuationCount.store(0, memory_order_relaxed);
+    pJob->mainThread = false;
+
+    if (pParent != nullptr) pParent->unfinished.fetch_add(1, memory_order_relaxed);
+    return pJob;
+}
+
+void JobSystem::Enqueue(Job* pJob)
+{
+    // nothing to run, so it finishes as soon as it is ready
+    if (pJob->function == nullptr)
+    {
+        Finish(pJob);
+        return;
+    }
+
+    if (pJob->mainThread)
+    {
+        lock_guard<mutex> lock(m_mainThreadMutex);
+        m_mainThreadJobs.push_back(pJob);
+        m_mainThreadCount++;
+        return;
+    }
+
+    const uint threadIndex = GetThreadIndex();
+    if (threadIndex == ExternalThread || !m_deques[threadIndex]->Push(pJob))
+    {
+        lock_guard<mutex> lock(m_externalMutex);
+        m_externalJobs.push_back(pJob);
+        m_externalCount++;
+    }
+    WakeThreads();
+}
+
+void JobSystem::Finish(Job* pJob)
+{
+    // once the job is seen as finished its slot may be reused, so everything needed afterwards is read beforehand
+    Job* pParent = pJob->pParent;
+    const uint continuationCount = pJob->continuationCount.load(memory_order_relaxed);
+    Job* continuations[Job::MaxContinuations];
+    copy_n(pJob->continuations, continuationCount, continuations);
+
+    if (pJob->unfinished.fetch_sub(1, memory_order_acq_rel) != 1) return;
+
+    for (uint i = 0; i < continuationCount; ++i)
+    {
+        Submit(continuations[i]);
+    }
+
+    if (pParent != nullptr) Finish(pParent);
+}
+
+void JobSystem::Execute(Job* pJob)
+{
+    pJob->function(*pJob);
+    Finish(pJob);
+}
+
+bool JobSystem::RunOne(uint threadIndex)
+{
+    Job* pJob = FindJob(threadIndex);
+    if (pJob == nullptr) return false;
+
+    Execute(pJob);
+    return true;
+}
+
+Job* JobSystem::FindJob(uint threadIndex)
+{
+    if (threadIndex == 0 && m_mainThreadCount.load(memory_order_acquire) > 0)
+    {
+        lock_guard<mutex> lock(m_mainThreadMutex);
+        if (!m_mainThreadJobs.empty())
+        {
+            Job* pJob = m_mainThreadJobs.front();
+            m_mainThreadJobs.pop_front();
+            m_mainThreadCount--;
+            return pJob;
+        }
+    }
+
+    if (Job* pJob = m_deques[threadIndex]->Pop()) return pJob;
+
+    // steal from the others in turn, starting with the next thread along so that thieves spread out
+    const uint threadCount = GetThreadCount();
+    for (uint i = 1; i < threadCount; ++i)
+    {
+        if (Job* pJob = m_deques[(threadIndex + i) % threadCount]->Steal()) return pJob;
+    }
+
+    if (m_externalCount.load(memory_order_acquire) > 0)
+    {
+        lock_guard<mutex> lock(m_externalMutex);
+        if (!m_externalJobs.empty())
+        {
+            Job* pJob = m_externalJobs.front();
+            m_externalJobs.pop_front();
+            m_externalCount--;
+            return pJob;
+        }
+    }
+    return nullptr;
+}
+
+void JobSystem::WakeThreads()
+{
+    // pairs with the fence in WorkerLoop, so either the sleeper sees the new job or this sees the sleeper
+    atomic_thread_fence(memory_order_seq_cst);
+    if (m_sleepers.load(memory_order_relaxed) == 0) return;
+
+    {
+        lock_guard<mutex> lock(m_sleepMutex);
+        m_wakeGeneration++;
+    }
+    m_wakeCondition.notify_one();
+}
+
+void JobSystem::WorkerLoop(uint threadIndex)
+{
+    t_pSystem = this;
+    t_threadIndex = threadIndex;
+    PROFILE_THREAD("Job Worker");
+    MemoryTracker::MarkFrameThread();
+
+    uint idleCount = 0;
+    while (!m_exiting.load(memory_order_relaxed))
+    {
+        if (RunOne(threadIndex))
+        {
+            idleCount = 0;
+            continue;
+        }
+        if (++idleCount < SpinsBeforeSleep)
+        {
+            this_thread::yield();
+            continue;
+        }
+        idleCount = 0;
+
+        // announce the sleep, then look once more under the lock which any waker must take to notify
+        Job* pJob = nullptr;
+        {
+            unique_lock<mutex> lock(m_sleepMutex);
+            const uint64 generation = m_wakeGeneration;
+            m_sleepers.fetch_add(1, memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+
+            pJob = FindJob(threadIndex);
+            if (pJob == nullptr)
+            {
+                m_wakeCondition.wait(lock, [&] {return m_exiting || m_wakeGeneration != generation;});
+            }
+            m_sleepers.fetch_sub(1, memory_order_relaxed);
+        }
+
+        if (pJob != nullptr) Execute(pJob);
+    }
+}
@@ -0,0 +1,208 @@
+// JobSystem - Work-stealing job scheduler shared by the engine's parallel work.
+//
+// Every thread in the pool owns a Chase-Lev deque, pushing and popping its own jobs at the bottom without locking while
+//  idle threads steal from the top of the others. Jobs are fixed-size records holding a function pointer and up to 64
+//  bytes of captures inline, allocated from a ring owned by the creating thread, so spawning a job neither locks nor
+//  allocates. Threads which find nothing to run spin briefly, then sleep until more work is submitted.
+//
+// A job is finished once it and every child created under it have run. Dependencies are declared with AddDependency()
+//  before submission, and a job is only queued once all of its prerequisites have finished. Jobs created with
+//  CreateMainThreadJob() are only ever run by the thread which created the system, while it waits or when it calls
+//  RunMainThreadJobs(), for API calls which must stay on that thread.
+//
+// The creating thread takes part as thread zero whenever it waits. Threads outside the pool may also create, submit and
+//  wait on jobs, but their submissions go through a locked queue and they only yield while waiting.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+#include "Common.h"
+
+
+// A unit of work. Each thread allocates jobs from its own ring, reusing the oldest finished slot, so a job may be waited
+//  on until some thousands more have been created by the same thread.
+struct alignas(64) Job
+{
+    static constexpr uint   MaxContinuations    = 8;
+    static constexpr size_t StorageSize         = 64;
+
+    void                (*function)(Job& job);  // null for jobs which only group others
+    Job*                pParent;
+    std::atomic<int>    unfinished;             // one for the job itself plus one per unfinished child
+    std::atomic<int>    blockers;               // unfinished prerequisites, plus one until the job is submitted
+    std::atomic<uint>   continuationCount;
+    Job*                continuations[MaxContinuations];    // the last an empty job joining more, once full
+    bool                mainThread;
+    alignas(16) unsigned char storage[StorageSize];
+};
+
+
+// Chase-Lev work-stealing deque of fixed capacity. Only the owning thread may push or pop, at the bottom, while any thread
+//  may steal from the top. Memory ordering follows Le et al., "Correct and Efficient Work-Stealing for Weak Memory
+//  Models" (PPoPP 2013).
+class JobDeque
+{
+public:
+    static constexpr int64_t Capacity = 4096;
+
+    JobDeque();
+
+    bool Push(Job* pJob);                       // false if the deque is full
+    Job* Pop();
+    Job* Steal();                               // null if empty or if another thread won the race
+
+private:
+    alignas(64) std::atomic<int64_t>        m_top;
+    alignas(64) std::atomic<int64_t>        m_bottom;
+    std::unique_ptr<std::atomic<Job*>[]>    m_pJobs;
+};
+
+
+class JobSystem
+{
+public:
+    static constexpr uint ExternalThread = ~0u;
+
+    JobSystem(uint threadCount = 0);            // including the calling thread, zero uses one per hardware thread
+    ~JobSystem();
+
+    // the pool shared by the engine, created on first use by the thread which will act as its main thread
+    static JobSystem& Get();
+
+    template <typename Function>
+    Job* CreateJob(Function&& function, Job* pParent = nullptr);
+    template <typename Function>
+    Job* CreateMainThreadJob(Function&& function, Job* pParent = nullptr);
+    Job* CreateEmptyJob(Job* pParent = nullptr);    // for grouping children or joining several prerequisites
+
+    // pJob will not be queued before pPrerequisite has finished, neither having been submitted yet. Dependents beyond
+    //  the prerequisite's continuations are joined through empty jobs, so there is no limit to how many it has, but
+    //  those of one prerequisite must be added from one thread.
+    void AddDependency(Job* pJob, Job* pPrerequisite);
+
+    void Submit(Job* pJob);
+    void Wait(const Job* pJob);                 // runs other jobs until pJob has finished
+    static bool IsFinished(const Job* pJob)     {return pJob->unfinished.load(std::memory_order_acquire) == 0;}
+
+    // Calls function(index) for every index below count and waits for them all. The range is split in halves down to
+    //  grainSize indices per job, which by default gives each thread a few jobs to balance uneven costs with.
+    template <typename Function>
+    void ParallelFor(uint count, Function&& function, uint grainSize = 0);
+
+    void RunMainThreadJobs();                   // runs any main thread jobs which are ready, from the main thread only
+
+    uint GetThreadCount() const                 {return static_cast<uint>(m_deques.size());}
+    uint GetThreadIndex() const;                // zero for the main thread, ExternalThread outside the pool
+
+private:
+    static constexpr uint JobsPerThread = 2048;
+
+    struct JobRing
+    {
+        std::unique_ptr<Job[]>  pJobs;
+        uint                    next;
+    };
+
+    Job* AllocateJob(Job* pParent);
+    void Enqueue(Job* pJob);
+    void Finish(Job* pJob);
+    void Execute(Job* pJob);
+    bool RunOne(uint threadIndex);
+    Job* FindJob(uint threadIndex);
+    void WakeThreads();
+    void WorkerLoop(uint threadIndex);
+
+    template <typename Function>
+    void RunRange(Job* pRoot, const Function* pFunction, uint begin, uint end, uint grainSize);
+
+    std::vector<std::unique_ptr<JobDeque>>  m_deques;       // one per thread, the main thread's first
+    std::vector<JobRing>                    m_rings;        // one per thread, plus one for external threads
+    std::vector<std::thread>                m_workers;
+    std::thread::id                         m_mainThreadId;
+
+    std::mutex                              m_externalMutex;
+    std::deque<Job*>                        m_externalJobs; // submitted from outside the pool
+    std::atomic<uint>                       m_externalCount;
+
+    std::mutex                              m_mainThreadMutex;
+    std::deque<Job*>                        m_mainThreadJobs;
+    std::atomic<uint>                       m_mainThreadCount;
+
+    std::mutex                              m_sleepMutex;
+    std::condition_variable                 m_wakeCondition;
+    std::atomic<uint>                       m_sleepers;
+    uint64                                  m_wakeGeneration;
+    std::atomic<bool>                       m_exiting;
+};
+
+
+//**********************************************************************************************************************
+//                                                  Template Definitions
+//**********************************************************************************************************************
+template <typename Function>
+Job* JobSystem::CreateJob(Function&& function, Job* pParent)
+{
+    using Stored = std::decay_t<Function>;
+    static_assert(sizeof(Stored) <= Job::StorageSize, "job captures are too large, capture a pointer to them instead");
+    static_assert(alignof(Stored) <= 16, "job captures are over-aligned");
+
+    Job* pJob = AllocateJob(pParent);
+    new (pJob->storage) Stored(std::forward<Function>(function));
+    pJob->function = [](Job& job)
+    {
+        Stored& stored = *std::launder(reinterpret_cast<Stored*>(job.storage));
+        stored();
+        stored.~Stored();
+    };
+    return pJob;
+}
+
+template <typename Function>
+Job* JobSystem::CreateMainThreadJob(Function&& function, Job* pParent)
+{
+    Job* pJob = CreateJob(std::forward<Function>(function), pParent);
+    pJob->mainThread = true;
+    return pJob;
+}
+
+template <typename Function>
+void JobSystem::ParallelFor(uint count, Function&& function, uint grainSize)
+{
+    if (count == 0) return;
+    if (grainSize == 0) grainSize = std::max(1u, count / (GetThreadCount() * 4));
+
+    if (count <= grainSize || GetThreadCount() == 1)
+    {
+        for (uint i = 0; i < count; ++i) function(i);
+        return;
+    }
+
+    // the calling thread splits off the upper halves for others to steal and keeps the first grain for itself
+    Job* pRoot = CreateEmptyJob();
+    RunRange(pRoot, &function, 0, count, grainSize);
+    Submit(pRoot);
+    Wait(pRoot);
+}
+
+template <typename Function>
+void JobSystem::RunRange(Job* pRoot, const Function* pFunction, uint begin, uint end, uint grainSize)
+{
+    while (end - begin > grainSize)
+    {
+        const uint middle = begin + (end - begin) / 2;
+        Submit(CreateJob([this, pRoot, pFunction, middle, end, grainSize]()
+        {
+            RunRange(pRoot, pFunction, middle, end, grainSize);
+        }, pRoot));
+        end = middle;
+    }
+
+    for (uint i = begin; i < end; ++i) (*pFunction)(i);
+}
@@ -0,0 +1,403 @@
+#include "Log.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include <imgui.h>
+
+#include "Profiler.h"
+
+using namespace std;
+
+
+namespace
+{
+    const chrono::steady_clock::time_point LoggerEpoch = chrono::steady_clock::now();
+
+    thread_local LogThreadBuffer* t_pThreadBuffer = nullptr;
+
+    // a line as the stream and debugger sinks write it, matching what PrintMessage() always wrote
+    void FormatLine(const LogMessage& message, fmt::memory_buffer& line)
+    {
+        if (message.raw)
+        {
+            line.append(message.text.data(), message.text.data() + message.text.size());
+            return;
+        }
+        fmt::format_to(fmt::appender(line), "{} {}\n", MessageSeverityTags[message.severity], message.text);
+    }
+
+    const ImVec4 SeverityColors[] =
+    {
+        ImVec4(0.6f, 0.6f, 0.6f, 1.0f),
+        ImVec4(0.9f, 0.9f, 0.9f, 1.0f),
+        ImVec4(1.0f, 0.8f, 0.3f, 1.0f),
+        ImVec4(1.0f, 0.4f, 0.4f, 1.0f),
+        ImVec4(1.0f, 0.2f, 0.8f, 1.0f),
+    };
+}
+
+
+//**********************************************************************************************************************
+//                                                      Sinks
+//**********************************************************************************************************************
+void LogStreamSink::Write(const LogMessage& message)
+{
+    fmt::memory_buffer line;
+    FormatLine(message, line);
+    fwrite(line.data(), 1, line.size(), m_pStream);
+}
+
+void LogStreamSink::Flush()
+{
+    fflush(m_pStream);
+}
+
+void LogDebuggerSink::Write(const LogMessage& message)
+{
+#if defined(_WIN32)
+    fmt::memory_buffer line;
+    FormatLine(message, line);
+    line.push_back('\0');
+    OutputDebugStringA(line.data());
+#endif
+}
+
+LogFileSink::LogFileSink(const string& filename) :
+    m_pFile(fopen(filename.c_str(), "w"))
+{
+}
+
+LogFileSink::~LogFileSink()
+{
+    if (m_pFile) fclose(m_pFile);
+}
+
+void LogFileSink::Write(const LogMessage& message)
+{
+    if (!m_pFile) return;
+
+    fmt::memory_buffer line;
+    if (!message.raw) fmt::format_to(fmt::appender(line), "{:12.6f} ", message.timestamp / 1e9);
+    FormatLine(message, line);
+    fwrite(line.data(), 1, line.size(), m_pFile);
+}
+
+void LogFileSink::Flush()
+{
+    if (m_pFile) fflush(m_pFile);
+}
+
+LogConsoleSink::LogConsoleSink(uint capacity) :
+    m_first(0),
+    m_capacity(max(capacity, 1u)),
+    m_autoScroll(true),
+    m_filter{}
+{
+    for (bool& show : m_showSeverity) show = true;
+}
+
+void LogConsoleSink::Write(const LogMessage& message)
+{
+    // raw messages bring their own newlines, which the console's one line per entry does not want
+    string_view text = message.text;
+    while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.remove_suffix(1);
+    if (text.empty()) return;
+
+    lock_guard<mutex> lock(m_mutex);
+    if (m_entries.size() < m_capacity)
+    {
+        m_entries.push_back({message.severity, message.timestamp, string(text)});
+        return;
+    }
+    Entry& entry = m_entries[m_first];
+    entry.severity = message.severity;
+    entry.timestamp = message.timestamp;
+    entry.text.assign(text.data(), text.size());
+    m_first = (m_first + 1) % m_entries.size();
+}
+
+void LogConsoleSink::Clear()
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_entries.clear();
+    m_first = 0;
+}
+
+void LogConsoleSink::DrawUI()
+{
+    int threshold = Logger::GetThreshold();
+    ImGui::SetNextItemWidth(100.0f);
+    if (ImGui::Combo("Threshold", &threshold, "Debug\0Info\0Warning\0Error\0Fatal Error\0"))
+    {
+        Logger::SetThreshold(static_cast<MessageSeverity>(threshold));
+    }
+    for (uint i = Debug; i <= FatalError; ++i)
+    {
+        ImGui::SameLine();
+        ImGui::Checkbox(MessageSeverityTags[i], &m_showSeverity[i]);
+    }
+    ImGui::SetNextItemWidth(200.0f);
+    ImGui::InputText("Filter", m_filter, sizeof(m_filter));
+    ImGui::SameLine();
+    ImGui::Checkbox("Auto-scroll", &m_autoScroll);
+    ImGui::SameLine();
+    if (ImGui::Button("Clear")) Clear();
+    ImGui::SameLine();
+    ImGui::TextDisabled("%llu dropped", (unsigned long long)Logger::Get().GetDroppedCount());
+    ImGui::Separator();
+
+    ImGui::BeginChild("Log Messages", ImVec2(0, 0), false, ImGuiWindowFlags_HorizontalScrollbar);
+    {
+        lock_guard<mutex> lock(m_mutex);
+        const string_view filter = m_filter;
+        for (size_t i = 0; i < m_entries.size(); ++i)
+        {
+            const Entry& entry = m_entries[(m_first + i) % m_entries.size()];
+            if (!m_showSeverity[entry.severity]) continue;
+            if (!filter.empty() && entry.text.find(filter) == string::npos) continue;
+
+            ImGui::TextDisabled("%10.3f", entry.timestamp / 1e9);
+            ImGui::SameLine();
+            ImGui::PushStyleColor(ImGuiCol_Text, SeverityColors[entry.severity]);
+            ImGui::TextUnformatted(entry.text.data(), entry.text.data() + entry.text.size());
+            ImGui::PopStyleColor();
+        }
+    }
+    if (m_autoScroll && ImGui::GetScrollY() >= ImGui::GetScrollMaxY()) ImGui::SetScrollHereY(1.0f);
+    ImGui::EndChild();
+}
+
+
+//**********************************************************************************************************************
+//                                                  Thread Buffers
+//**********************************************************************************************************************
+LogThreadBuffer::LogThreadBuffer(uint threadIndex) :
+    m_threadIndex(threadIndex),
+    m_drainIndex(0),
+    m_reportedDrops(0),
+    m_pData(new uint8_t[Capacity]),
+    m_writeIndex(0),
+    m_cachedReadIndex(0),
+    m_padding(0),
+    m_dropped(0),
+    m_readIndex(0)
+{
+}
+
+
+//**********************************************************************************************************************
+//                                                      Logger
+//**********************************************************************************************************************
+Logger::Logger() :
+    m_flushRequests(0),
+    m_flushesCompleted(0),
+    m_stopping(false),
+    m_droppedMessages(0)
+{
+#if defined(_WIN32)
+    m_sinks.push_back(make_shared<LogDebuggerSink>());
+#else
+    m_sinks.push_back(make_shared<LogStreamSink>(stderr));  // no debugger output window, so headless runs log to stderr
+#endif
+
+    s_asynchronous = true;
+    m_thread = thread(&Logger::WriterThread, this);
+    atexit([]() {Get().Shutdown();});
+}
+
+Logger& Logger::Get()
+{
+    // never destroyed, so that static destructors may still log after the writer thread has stopped
+    static Logger* pLogger = new Logger();
+    return *pLogger;
+}
+
+uint64 Logger::Now()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - LoggerEpoch).count();
+}
+
+LogThreadBuffer& Logger::GetThreadBuffer()
+{
+    if (t_pThreadBuffer == nullptr) t_pThreadBuffer = &Get().RegisterThread();
+    return *t_pThreadBuffer;
+}
+
+LogThreadBuffer& Logger::RegisterThread()
+{
+    lock_guard<mutex> lock(m_threadMutex);
+    m_threads.push_back(make_unique<LogThreadBuffer>(static_cast<uint>(m_threads.size())));
+    return *m_threads.back();
+}
+
+void Logger::AddSink(shared_ptr<LogSink> pSink)
+{
+    lock_guard<mutex> lock(m_sinkMutex);
+    m_sinks.push_back(move(pSink));
+}
+
+void Logger::RemoveSink(const LogSink* pSink)
+{
+    lock_guard<mutex> lock(m_sinkMutex);
+    m_sinks.erase(remove_if(m_sinks.begin(), m_sinks.end(), [&](const shared_ptr<LogSink>& p) {return p.get() == pSink;}),
+                  m_sinks.end());
+}
+
+void Logger::ClearSinks()
+{
+    lock_guard<mutex> lock(m_sinkMutex);
+    m_sinks.clear();
+}
+
+void Logger::Flush()
+{
+    if (!s_asynchronous)
+    {
+        lock_guard<mutex> lock(m_sinkMutex);
+        for (shared_ptr<LogSink>& pSink : m_sinks) pSink->Flush();
+        return;
+    }
+
+    unique_lock<mutex> lock(m_flushMutex);
+    const uint64 request = ++m_flushRequests;
+    m_wake.notify_one();
+    m_flushed.wait(lock, [&]() {return m_flushesCompleted >= request || m_stopping;});
+}
+
+void Logger::Shutdown()
+{
+    {
+        lock_guard<mutex> lock(m_flushMutex);
+        if (m_stopping) return;
+        m_stopping = true;
+    }
+    m_wake.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+
+    // anything queued between the writer's last pass and the switch is written here, by the only remaining reader
+    s_asynchronous = false;
+    Drain();
+    lock_guard<mutex> lock(m_sinkMutex);
+    for (shared_ptr<LogSink>& pSink : m_sinks) pSink->Flush();
+}
+
+void Logger::WriterThread()
+{
+    PROFILE_THREAD("Log Writer");
+
+    while (true)
+    {
+        uint64 request;
+        bool stopping;
+        {
+            lock_guard<mutex> lock(m_flushMutex);
+            request = m_flushRequests;
+            stopping = m_stopping;
+        }
+
+        // messages published before a flush was requested are visible to the pass which follows it
+        const bool wrote = Drain();
+        if (request > m_flushesCompleted || stopping)
+        {
+            {
+                lock_guard<mutex> lock(m_sinkMutex);
+                for (shared_ptr<LogSink>& pSink : m_sinks) pSink->Flush();
+            }
+            lock_guard<mutex> lock(m_flushMutex);
+            m_flushesCompleted = max(m_flushesCompleted, request);
+            m_flushed.notify_all();
+        }
+        if (stopping) return;
+
+        if (!wrote)
+        {
+            unique_lock<mutex> lock(m_flushMutex);
+            m_wake.wait_for(lock, chrono::milliseconds(2), [&]() {return m_stopping || m_flushRequests > m_flushesCompleted;});
+        }
+    }
+}
+
+bool Logger::Drain()
+{
+    // threads registering meanwhile are picked up by the next pass
+    {
+        lock_guard<mutex> lock(m_threadMutex);
+        m_drainThreads.clear();
+        for (unique_ptr<LogThreadBuffer>& pBuffer : m_threads) m_drainThreads.push_back(pBuffer.get());
+    }
+
+    m_pending.clear();
+    m_drainEnds.resize(m_drainThreads.size());
+    uint64 dropped = 0;
+    for (size_t i = 0; i < m_drainThreads.size(); ++i)
+    {
+        LogThreadBuffer& buffer = *m_drainThreads[i];
+        const uint64 end = buffer.m_writeIndex.load(memory_order_acquire);
+        for (uint64 index = buffer.m_drainIndex; index < end;)
+        {
+            const auto* pHeader = reinterpret_cast<const LogDetail::RecordHeader*>(
+                buffer.m_pData.get() + (index & (LogThreadBuffer::Capacity - 1)));
+            if (!(pHeader->flags & LogDetail::RecordPadding)) m_pending.push_back({pHeader, buffer.m_threadIndex});
+            index += pHeader->size;
+        }
+        m_drainEnds[i] = end;
+
+        const uint64 threadDropped = buffer.m_dropped.load(memory_order_relaxed);
+        dropped += threadDropped - buffer.m_reportedDrops;
+        buffer.m_reportedDrops = threadDropped;
+    }
+
+    // each ring is in order already, but messages from different threads are interleaved by time
+    stable_sort(m_pending.begin(), m_pending.end(), [](const PendingRecord& a, const PendingRecord& b) {
+        return a.pHeader->timestamp < b.pHeader->timestamp;
+    });
+
+    {
+        lock_guard<mutex> lock(m_sinkMutex);
+        for (const PendingRecord& record : m_pending)
+        {
+            const LogDetail::RecordHeader& header = *record.pHeader;
+            m_text.clear();
+            try
+            {
+                header.format(fmt::string_view(header.pFormat, header.formatSize),
+                              reinterpret_cast<const uint8_t*>(&header + 1), m_text);
+            }
+            catch (const fmt::format_error& error)
+            {
+                m_text.clear();
+                fmt::format_to(fmt::appender(m_text), "<{}> {}", error.what(), string_view(header.pFormat, header.formatSize));
+            }
+
+            const LogMessage message = {static_cast<MessageSeverity>(header.severity), (header.flags & LogDetail::RecordRaw) != 0,
+                                        header.timestamp, record.threadIndex, string_view(m_text.data(), m_text.size())};
+            for (shared_ptr<LogSink>& pSink : m_sinks) pSink->Write(message);
+        }
+
+        if (dropped > 0)
+        {
+            m_droppedMessages.fetch_add(dropped, memory_order_relaxed);
+            const string text = fmt::format("{} log messages were dropped while the writer thread fell behind", dropped);
+            const LogMessage message = {Warning, false, Now(), 0, text};
+            for (shared_ptr<LogSink>& pSink : m_sinks) pSink->Write(message);
+        }
+    }
+
+    // space is handed back only once the records are no longer referenced
+    for (size_t i = 0; i < m_drainThreads.size(); ++i)
+    {
+        m_drainThreads[i]->m_drainIndex = m_drainEnds[i];
+        m_drainThreads[i]->m_readIndex.store(m_drainEnds[i], memory_order_release);
+    }
+    return !m_pending.empty() || dropped > 0;
+}
+
+void Logger::WriteSynchronous(MessageSeverity severity, bool raw, string_view text)
+{
+    const uint threadIndex = t_pThreadBuffer ? t_pThreadBuffer->m_threadIndex : 0;
+    const LogMessage message = {severity, raw, Now(), threadIndex, text};
+    lock_guard<mutex> lock(m_sinkMutex);
+    for (shared_ptr<LogSink>& pSink : m_sinks) pSink->Write(message);
+    if (severity == FatalError) for (shared_ptr<LogSink>& pSink : m_sinks) pSink->Flush();
+}
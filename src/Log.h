@@ -0,0 +1,456 @@
+// Log - Asynchronous logging with deferred formatting.
+//
+// LOG_INFO("format {}", args...) and its siblings check the format string against the arguments at compile time, then
+//  copy the arguments, not the formatted text, into a ring owned by the calling thread. A writer thread decodes every
+//  ring in timestamp order, formats the messages and hands them to the registered sinks, so the calling thread takes
+//  no lock, makes no allocation and does no formatting.
+//
+// Arithmetic and other trivially copyable arguments are captured as bytes and strings along with their length. Any
+//  other type is formatted with "{}" on the calling thread, so it is shown as formatting it there would show it.
+//  Messages below SHADE_LOG_LEVEL are compiled out, and those below the runtime threshold cost a load and a branch.
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include "Common.h"
+
+
+//enum class MessageSeverity
+enum MessageSeverity
+{
+    Debug,
+    Info,
+    Warning,
+    Error,
+    FatalError,
+};
+// TODO: constexpr?
+static const char* MessageSeverityTags[] =
+{
+    "[DEBUG]",
+    "[INFO]",
+    "[WARNING]",
+    "[ERROR]",
+    "[FATAL ERROR]"
+};
+
+
+//**********************************************************************************************************************
+//                                                  Instrumentation
+//**********************************************************************************************************************
+// The lowest severity compiled in, as a MessageSeverity value. Debug messages are kept only in builds with asserts.
+#if !defined(SHADE_LOG_LEVEL)
+#if defined(NDEBUG)
+#define SHADE_LOG_LEVEL 1
+#else
+#define SHADE_LOG_LEVEL 0
+#endif
+#endif
+
+// format strings must be literals, which FMT_STRING checks against the arguments as the call is compiled
+#define SHADE_LOG(severity, format, ...)                                                                    \
+    do                                                                                                      \
+    {                                                                                                       \
+        if constexpr (static_cast<int>(severity) >= SHADE_LOG_LEVEL)                                        \
+        {                                                                                                   \
+            if (Logger::IsEnabled(severity)) Logger::Log(severity, false, FMT_STRING(format), ##__VA_ARGS__); \
+        }                                                                                                   \
+    } while (0)
+
+#define LOG_DEBUG(format, ...)      SHADE_LOG(Debug, format, ##__VA_ARGS__)
+#define LOG_INFO(format, ...)       SHADE_LOG(Info, format, ##__VA_ARGS__)
+#define LOG_WARNING(format, ...)    SHADE_LOG(Warning, format, ##__VA_ARGS__)
+#define LOG_ERROR(format, ...)      SHADE_LOG(Error, format, ##__VA_ARGS__)
+#define LOG_FATAL(format, ...)      SHADE_LOG(FatalError, format, ##__VA_ARGS__)
+
+
+//**********************************************************************************************************************
+//                                                  Argument Capture
+//**********************************************************************************************************************
+namespace LogDetail
+{
+    template <typename T> using Stored = std::remove_cv_t<std::remove_reference_t<T>>;
+
+    template <typename T>
+    constexpr bool IsString = std::is_same_v<std::decay_t<T>, const char*> || std::is_same_v<std::decay_t<T>, char*> ||
+                              std::is_same_v<Stored<T>, std::string> || std::is_same_v<Stored<T>, std::string_view>;
+
+    template <typename T>
+    constexpr bool IsCopied = !IsString<T> && !std::is_array_v<Stored<T>> && std::is_trivially_copyable_v<Stored<T>>;
+
+    // the type an argument is formatted from on the writer thread
+    template <typename T>
+    using Decoded = std::conditional_t<IsCopied<T>, Stored<T>, fmt::string_view>;
+
+    inline std::string_view ToView(const char* pString)             {return pString ? pString : "(null)";}
+    inline std::string_view ToView(const std::string& string)       {return string;}
+    inline std::string_view ToView(std::string_view string)         {return string;}
+
+    // strings and copyable values pass through, anything else becomes its text
+    template <typename T>
+    decltype(auto) Capture(const T& value)
+    {
+        if constexpr (IsString<T> || IsCopied<T>) return (value);
+        else return fmt::format("{}", value);
+    }
+
+    template <typename T>
+    size_t EncodedSize(const T& value)
+    {
+        if constexpr (IsCopied<T>) return sizeof(Stored<T>);
+        else return sizeof(uint32_t) + ToView(value).size();
+    }
+
+    template <typename T>
+    uint8_t* Encode(uint8_t* pOut, const T& value)
+    {
+        if constexpr (IsCopied<T>)
+        {
+            memcpy(pOut, &value, sizeof(Stored<T>));
+            return pOut + sizeof(Stored<T>);
+        }
+        else
+        {
+            const std::string_view view = ToView(value);
+            const uint32_t length = static_cast<uint32_t>(view.size());
+            memcpy(pOut, &length, sizeof(length));
+            memcpy(pOut + sizeof(length), view.data(), length);
+            return pOut + sizeof(length) + length;
+        }
+    }
+
+    template <typename T>
+    Decoded<T> Decode(const uint8_t*& pIn)
+    {
+        if constexpr (IsCopied<T>)
+        {
+            Stored<T> value;
+            memcpy(&value, pIn, sizeof(value));
+            pIn += sizeof(value);
+            return value;
+        }
+        else
+        {
+            uint32_t length;
+            memcpy(&length, pIn, sizeof(length));
+            const fmt::string_view view(reinterpret_cast<const char*>(pIn) + sizeof(length), length);
+            pIn += sizeof(length) + length;
+            return view;
+        }
+    }
+
+    // Rebuilds the arguments of a record and formats them. Elements of a braced initializer are evaluated in order, so
+    //  the arguments are decoded in the order they were encoded.
+    template <typename... Args>
+    void Format(fmt::string_view format, const uint8_t* pArgs, fmt::memory_buffer& output)
+    {
+        std::tuple<Decoded<Args>...> values{Decode<Args>(pArgs)...};
+        std::apply([&](const auto&... decoded) {
+            fmt::vformat_to(fmt::appender(output), format, fmt::make_format_args(decoded...));
+        }, values);
+    }
+
+    using FormatFunction = void (*)(fmt::string_view format, const uint8_t* pArgs, fmt::memory_buffer& output);
+
+    enum RecordFlags : uint16_t
+    {
+        RecordPadding   = 1 << 0,   // fills the end of the ring when a record would not fit before wrapping
+        RecordRaw       = 1 << 1,   // written without a severity tag or newline
+    };
+
+    // precedes the encoded arguments of every message in a thread's ring, and keeps them 8 byte aligned
+    struct RecordHeader
+    {
+        uint32_t        size;           // of the whole record, header included
+        uint16_t        flags;
+        uint16_t        severity;
+        uint32_t        formatSize;
+        const char*     pFormat;        // literals only, so the pointer outlives the record
+        FormatFunction  format;
+        uint64          timestamp;
+    };
+}
+
+
+//**********************************************************************************************************************
+//                                                      Sinks
+//**********************************************************************************************************************
+// a formatted message, valid for the duration of LogSink::Write()
+struct LogMessage
+{
+    MessageSeverity     severity;
+    bool                raw;            // text is written as is, being a PrintMessage() without a severity
+    uint64              timestamp;      // nanoseconds since the logger started
+    uint                threadIndex;
+    std::string_view    text;
+};
+
+// Receives every message the thresholds let through. Sinks are called from the writer thread alone, one message at a
+//  time, until the logger shuts down, after which they are called synchronously by whichever thread logs.
+class LogSink
+{
+public:
+    virtual ~LogSink() {}
+    virtual void Write(const LogMessage& message) = 0;
+    virtual void Flush() {}
+};
+
+// standard error, or any other C stream
+class LogStreamSink : public LogSink
+{
+public:
+    LogStreamSink(FILE* pStream) : m_pStream(pStream) {}
+    virtual void Write(const LogMessage& message);
+    virtual void Flush();
+
+private:
+    FILE*   m_pStream;
+};
+
+// the debugger's output window, through OutputDebugString()
+class LogDebuggerSink : public LogSink
+{
+public:
+    virtual void Write(const LogMessage& message);
+};
+
+// a text file, each line stamped with the seconds since startup
+class LogFileSink : public LogSink
+{
+public:
+    LogFileSink(const std::string& filename);
+    ~LogFileSink();
+    virtual void Write(const LogMessage& message);
+    virtual void Flush();
+
+    bool IsOpen() const     {return m_pFile != nullptr;}
+
+private:
+    FILE*   m_pFile;
+};
+
+// the most recent messages, kept for the in-app console window
+class LogConsoleSink : public LogSink
+{
+public:
+    LogConsoleSink(uint capacity = 4096);
+    virtual void Write(const LogMessage& message);
+
+    // draws the messages, with filters and the runtime threshold, into the current ImGui window
+    void DrawUI();
+    void Clear();
+
+private:
+    struct Entry
+    {
+        MessageSeverity     severity;
+        uint64              timestamp;
+        std::string         text;
+    };
+
+    std::mutex              m_mutex;
+    std::vector<Entry>      m_entries;      // circular once full, m_first being the oldest
+    size_t                  m_first;
+    uint                    m_capacity;
+    bool                    m_autoScroll;
+    bool                    m_showSeverity[FatalError + 1];
+    char                    m_filter[128];
+};
+
+
+//**********************************************************************************************************************
+//                                                      Logger
+//**********************************************************************************************************************
+// Single producer ring of encoded messages, written only by the thread which owns it and read only by the writer
+//  thread. Indices grow without wrapping. A record which would straddle the end of the ring is instead written at its
+//  start, after a padding record, so that every record is contiguous.
+class LogThreadBuffer
+{
+public:
+    static constexpr uint Capacity = 1 << 20;
+    static constexpr uint MaxRecordSize = Capacity / 4;
+
+    LogThreadBuffer(uint threadIndex);
+
+    // Space for a record of the given size, a multiple of 8. When the ring is full, either waits for the writer thread
+    //  or counts the message as dropped and returns null.
+    uint8_t* Reserve(uint size, bool wait)
+    {
+        const uint64 writeIndex = m_writeIndex.load(std::memory_order_relaxed);
+        const uint offset = static_cast<uint>(writeIndex & (Capacity - 1));
+        const uint padding = (offset + size > Capacity) ? Capacity - offset : 0;
+        while (writeIndex + padding + size - m_cachedReadIndex > Capacity)
+        {
+            m_cachedReadIndex = m_readIndex.load(std::memory_order_acquire);
+            if (writeIndex + padding + size - m_cachedReadIndex <= Capacity) break;
+            if (!wait)
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            std::this_thread::yield();
+        }
+
+        m_padding = padding;
+        if (padding == 0) return m_pData.get() + offset;
+
+        LogDetail::RecordHeader* pHeader = reinterpret_cast<LogDetail::RecordHeader*>(m_pData.get() + offset);
+        pHeader->size = padding;
+        pHeader->flags = LogDetail::RecordPadding;
+        return m_pData.get();
+    }
+
+    // publishes the reserved record to the writer thread
+    void Commit(uint size)
+    {
+        m_writeIndex.store(m_writeIndex.load(std::memory_order_relaxed) + m_padding + size, std::memory_order_release);
+    }
+
+    uint                                m_threadIndex;
+    uint64                              m_drainIndex;       // writer thread only
+    uint64                              m_reportedDrops;    // writer thread only
+    std::unique_ptr<uint8_t[]>          m_pData;
+
+    // the owner's and the writer's indices are kept on separate cache lines
+    alignas(64) std::atomic<uint64>     m_writeIndex;
+    uint64                              m_cachedReadIndex;  // owner only
+    uint                                m_padding;          // owner only
+    std::atomic<uint64>                 m_dropped;
+    alignas(64) std::atomic<uint64>     m_readIndex;
+};
+
+
+// Owns the thread rings, the sinks and the writer thread. Threads register their ring on their first message, which is
+//  the only time the logger takes a lock on their behalf. The logger is never destroyed; it is shut down at exit, after
+//  which messages are formatted and written on the calling thread.
+class Logger
+{
+public:
+    static Logger& Get();
+
+    // the runtime threshold, which may only raise the compiled-in SHADE_LOG_LEVEL
+    static bool IsEnabled(MessageSeverity severity)
+    {
+        return static_cast<int>(severity) >= s_threshold.load(std::memory_order_relaxed);
+    }
+    static void SetThreshold(MessageSeverity severity)  {s_threshold.store(severity, std::memory_order_relaxed);}
+    static MessageSeverity GetThreshold()               {return static_cast<MessageSeverity>(s_threshold.load());}
+
+    // Queues a message for the writer thread. Prefer the LOG_ macros, which skip the call and its arguments altogether
+    //  when the message is filtered out. Errors wait for space rather than being dropped, and fatal errors flush.
+    template <typename... Args>
+    static void Log(MessageSeverity severity, bool raw, fmt::format_string<Args...> format, Args&&... args);
+
+    static uint64 Now();
+    static LogThreadBuffer& GetThreadBuffer();
+
+    void AddSink(std::shared_ptr<LogSink> pSink);
+    void RemoveSink(const LogSink* pSink);
+    void ClearSinks();
+
+    // returns once every message queued before the call has been written and the sinks flushed
+    void Flush();
+
+    // writes everything outstanding, stops the writer thread and leaves logging synchronous
+    void Shutdown();
+
+    uint64 GetDroppedCount() const      {return m_droppedMessages.load(std::memory_order_relaxed);}
+
+private:
+    Logger();
+
+    LogThreadBuffer& RegisterThread();
+    void WriterThread();
+    bool Drain();
+    void WriteSynchronous(MessageSeverity severity, bool raw, std::string_view text);
+
+    inline static std::atomic<int>                  s_threshold = SHADE_LOG_LEVEL;
+    inline static std::atomic<bool>                 s_asynchronous = false;
+
+    // registered threads, whose rings live as long as the logger
+    std::mutex                                      m_threadMutex;
+    std::vector<std::unique_ptr<LogThreadBuffer>>   m_threads;
+
+    // writer thread only
+    struct PendingRecord
+    {
+        const LogDetail::RecordHeader*  pHeader;
+        uint                            threadIndex;
+    };
+    std::vector<LogThreadBuffer*>                   m_drainThreads;
+    std::vector<uint64>                             m_drainEnds;
+    std::vector<PendingRecord>                      m_pending;
+    fmt::memory_buffer                              m_text;
+
+    std::mutex                                      m_sinkMutex;
+    std::vector<std::shared_ptr<LogSink>>           m_sinks;
+
+    // flush requests are numbered, and each pass of the writer thread completes those made before it began
+    std::mutex                                      m_flushMutex;
+    std::condition_variable                         m_wake;
+    std::condition_variable                         m_flushed;
+    uint64                                          m_flushRequests;
+    uint64                                          m_flushesCompleted;
+    bool                                            m_stopping;
+
+    std::atomic<uint64>                             m_droppedMessages;
+    std::thread                                     m_thread;
+};
+
+
+template <typename... Args>
+void Logger::Log(MessageSeverity severity, bool raw, fmt::format_string<Args...> format, Args&&... args)
+{
+    using namespace LogDetail;
+    const fmt::string_view formatView = format;
+
+    if (!s_asynchronous.load(std::memory_order_relaxed))
+    {
+        Get().WriteSynchronous(severity, raw, fmt::vformat(formatView, fmt::make_format_args(args...)));
+        return;
+    }
+
+    const std::tuple<decltype(Capture(args))...> captured{Capture(args)...};
+    size_t size = sizeof(RecordHeader);
+    std::apply([&](const auto&... value) {((size += EncodedSize(value)), ...);}, captured);
+    size = (size + 7) & ~size_t(7);
+
+    LogThreadBuffer& buffer = GetThreadBuffer();
+    uint8_t* pRecord = (size <= LogThreadBuffer::MaxRecordSize) ? buffer.Reserve(uint(size), severity >= Error) : nullptr;
+    if (pRecord == nullptr)
+    {
+        // messages too long for the ring are written in place, behind everything already queued
+        if (size > LogThreadBuffer::MaxRecordSize)
+        {
+            Get().Flush();
+            Get().WriteSynchronous(severity, raw, fmt::vformat(formatView, fmt::make_format_args(args...)));
+        }
+        return;
+    }
+
+    RecordHeader* pHeader = reinterpret_cast<RecordHeader*>(pRecord);
+    pHeader->size = static_cast<uint32_t>(size);
+    pHeader->flags = raw ? RecordRaw : 0;
+    pHeader->severity = static_cast<uint16_t>(severity);
+    pHeader->formatSize = static_cast<uint32_t>(formatView.size());
+    pHeader->pFormat = formatView.data();
+    pHeader->format = &LogDetail::Format<Stored<Args>...>;
+    pHeader->timestamp = Now();
+
+    uint8_t* pArgs = pRecord + sizeof(RecordHeader);
+    std::apply([&](const auto&... value) {((pArgs = Encode(pArgs, value)), ...);}, captured);
+    buffer.Commit(static_cast<uint>(size));
+
+    if (severity == FatalError) Get().Flush();
+}
@@ -0,0 +1,99 @@
+#include "MappedFile.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+
+//**********************************************************************************************************************
+//                                              Constructors & Destructors
+//**********************************************************************************************************************
+MappedFile::MappedFile() :
+    m_pData(nullptr),
+    m_size(0)
+#if defined(_WIN32)
+    , m_mapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+
+//**********************************************************************************************************************
+//                                                  Primary Interfaces
+//**********************************************************************************************************************
+#if defined(_WIN32)
+bool MappedFile::Open(const filesystem::path& path)
+{
+    Close();
+
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    // the mapping keeps the file open, so its handle is not needed past this point
+    LARGE_INTEGER size = {};
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+    {
+        m_mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    CloseHandle(file);
+    if (m_mapping == nullptr) return false;
+
+    m_pData = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_pData == nullptr)
+    {
+        Close();
+        return false;
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_pData != nullptr) UnmapViewOfFile(m_pData);
+    if (m_mapping != nullptr) CloseHandle(m_mapping);
+    m_pData = nullptr;
+    m_size = 0;
+    m_mapping = nullptr;
+}
+#else
+bool MappedFile::Open(const filesystem::path& path)
+{
+    Close();
+
+    const int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) return false;
+
+    // the mapping holds its own reference to the file, so the descriptor is closed either way
+    struct stat status = {};
+    void* pData = MAP_FAILED;
+    if (fstat(file, &status) == 0 && status.st_size > 0)
+    {
+        pData = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    }
+    close(file);
+    if (pData == MAP_FAILED) return false;
+
+    m_pData = static_cast<const uint8_t*>(pData);
+    m_size = static_cast<size_t>(status.st_size);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_pData != nullptr) munmap(const_cast<uint8_t*>(m_pData), m_size);
+    m_pData = nullptr;
+    m_size = 0;
+}
+#endif
@@ -0,0 +1,36 @@
+// MappedFile - Read-only memory mapping of a whole file.
+//
+// The view is mapped on open and unmapped on destruction, and pages are only read from disk when first touched, so
+//  opening a large file costs the same as opening a small one. Files are opened allowing others to write, rename and
+//  delete them, which on Windows would otherwise fail while the view is held; replacing a file by renaming another over
+//  it leaves existing views of the old contents intact.
+#pragma once
+
+#include <filesystem>
+
+#include "Util.h"
+
+
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool Open(const std::filesystem::path& path);   // false if the file is missing, empty or cannot be mapped
+    void Close();
+
+    const uint8_t* GetData() const      {return m_pData;}
+    size_t GetSize() const              {return m_size;}
+    bool IsOpen() const                 {return m_pData != nullptr;}
+
+private:
+    const uint8_t*  m_pData;
+    size_t          m_size;
+#if defined(_WIN32)
+    HANDLE          m_mapping;
+#endif
+};
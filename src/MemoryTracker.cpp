@@ -0,0 +1,494 @@
+#include "MemoryTracker.h"
+
+#include <cstdlib>
+#include <new>
+
+#include <imgui.h>
+
+using namespace std;
+
+
+namespace
+{
+    // Counters of one subsystem or heap. Zero initialized with static storage, before any dynamic initializer runs.
+    struct alignas(64) MemoryCounters
+    {
+        atomic<uint64>  liveBytes;
+        atomic<uint64>  peakBytes;
+        atomic<uint64>  liveAllocations;
+        atomic<uint64>  totalAllocations;
+        atomic<uint64>  totalBytes;
+
+        void Add(uint64 bytes)
+        {
+            const uint64 live = liveBytes.fetch_add(bytes, memory_order_relaxed) + bytes;
+            uint64 peak = peakBytes.load(memory_order_relaxed);
+            while (live > peak && !peakBytes.compare_exchange_weak(peak, live, memory_order_relaxed)) {}
+
+            liveAllocations.fetch_add(1, memory_order_relaxed);
+            totalAllocations.fetch_add(1, memory_order_relaxed);
+            totalBytes.fetch_add(bytes, memory_order_relaxed);
+        }
+        void Remove(uint64 bytes)
+        {
+            liveBytes.fetch_sub(bytes, memory_order_relaxed);
+            liveAllocations.fetch_sub(1, memory_order_relaxed);
+        }
+        MemoryStats Load() const
+        {
+            return {liveBytes.load(memory_order_relaxed), peakBytes.load(memory_order_relaxed),
+                    liveAllocations.load(memory_order_relaxed), totalAllocations.load(memory_order_relaxed),
+                    totalBytes.load(memory_order_relaxed)};
+        }
+    };
+
+    constexpr uint HeapTypeCount = D3D12_HEAP_TYPE_CUSTOM + 1;   // indexed by D3D12_HEAP_TYPE
+
+    MemoryCounters CpuCounters[MemoryTagCount];
+    MemoryCounters GpuHeapCounters[HeapTypeCount];
+    MemoryCounters GpuTagCounters[MemoryTagCount];
+
+    thread_local MemoryTag CurrentTag = MemoryTagUntagged;
+    thread_local bool IsFrameThread = false;
+    alignas(64) atomic<uint64> FrameThreadAllocations;
+
+    const char* MemoryTagNames[MemoryTagCount] =
+    {
+        "Untagged",
+        "Mesh",
+        "GeometryManager",
+        "PipelineState",
+        "NodeEditor",
+        "UI",
+        "FrameArena",
+        "Profiler",
+    };
+
+    const char* HeapTypeNames[HeapTypeCount] =
+    {
+        "Unknown",
+        "Default",
+        "Upload",
+        "Readback",
+        "Custom",
+    };
+
+
+    //******************************************************************************************************************
+    //                                              CPU Allocation Headers
+    //******************************************************************************************************************
+    // Precedes every tracked allocation. The size of the header keeps the default new alignment of the block.
+    //  Blocks which were not allocated here (such as those handed over by modules with their own heap) lack the
+    //  header's magic, which is salted with the block's address, and are freed without being accounted.
+    struct AllocationHeader
+    {
+        uint64      sizeAndTag;     // size in the upper 56 bits, tag in the lowest 8
+        uint32_t    offset;         // from the start of the underlying malloc() block
+        uint32_t    magic;
+    };
+    static_assert(sizeof(AllocationHeader) == 16, "allocation header must preserve 16 byte alignment");
+
+    constexpr uint32_t AllocationMagic = 0x5ADE3E30;
+
+    uint32_t SaltedMagic(const void* pMemory)
+    {
+        const uint64 address = reinterpret_cast<uintptr_t>(pMemory);
+        return AllocationMagic ^ static_cast<uint32_t>(address ^ (address >> 32));
+    }
+
+    AllocationHeader* GetHeader(void* pMemory)
+    {
+        return static_cast<AllocationHeader*>(pMemory) - 1;
+    }
+
+
+    //******************************************************************************************************************
+    //                                              GPU Resource Sentinel
+    //******************************************************************************************************************
+    // {6F3A5E52-8C1B-4D0A-9B7E-3A2C1D5E4F60}
+    const GUID MemoryTrackerSentinelGuid = {0x6f3a5e52, 0x8c1b, 0x4d0a, {0x9b, 0x7e, 0x3a, 0x2c, 0x1d, 0x5e, 0x4f, 0x60}};
+
+    // Attached to a tracked resource as private data, so that the resource's destruction releases it, and with it the
+    //  bytes accounted against its heap type and tag.
+    class ResourceSentinel : public IUnknown
+    {
+    public:
+        ResourceSentinel(D3D12_HEAP_TYPE heapType, MemoryTag tag, uint64 bytes) :
+            m_refCount(1),
+            m_heapType(heapType),
+            m_tag(tag),
+            m_bytes(bytes)
+        {
+            GpuHeapCounters[m_heapType].Add(m_bytes);
+            GpuTagCounters[m_tag].Add(m_bytes);
+        }
+        virtual ~ResourceSentinel()
+        {
+            GpuHeapCounters[m_heapType].Remove(m_bytes);
+            GpuTagCounters[m_tag].Remove(m_bytes);
+        }
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject)
+        {
+            if (ppvObject == nullptr) return E_POINTER;
+            if (riid != __uuidof(IUnknown))
+            {
+                *ppvObject = nullptr;
+                return E_NOINTERFACE;
+            }
+
+            AddRef();
+            *ppvObject = static_cast<IUnknown*>(this);
+            return S_OK;
+        }
+        ULONG STDMETHODCALLTYPE AddRef()
+        {
+            return ++m_refCount;
+        }
+        ULONG STDMETHODCALLTYPE Release()
+        {
+            const ULONG refCount = --m_refCount;
+            if (refCount == 0) delete this;
+            return refCount;
+        }
+
+    private:
+        atomic<ULONG>       m_refCount;
+        D3D12_HEAP_TYPE     m_heapType;
+        MemoryTag           m_tag;
+        uint64              m_bytes;
+    };
+
+
+    //******************************************************************************************************************
+    //                                                  Formatting
+    //******************************************************************************************************************
+    string FormatBytes(uint64 bytes)
+    {
+        if (bytes >= (1ull << 30)) return fmt::format("{:.2f} GB", bytes / double(1ull << 30));
+        if (bytes >= (1ull << 20)) return fmt::format("{:.2f} MB", bytes / double(1ull << 20));
+        if (bytes >= (1ull << 10)) return fmt::format("{:.2f} KB", bytes / double(1ull << 10));
+        return fmt::format("{} B", bytes);
+    }
+
+    // allocation rates are sampled between UI updates, rather than on every allocation
+    struct AllocationRateSampler
+    {
+        chrono::steady_clock::time_point    lastSample;
+        uint64                              lastTotals[MemoryTagCount];
+        float                               rates[MemoryTagCount];
+
+        void Update()
+        {
+            constexpr double SampleInterval = 0.5;
+            const auto now = chrono::steady_clock::now();
+            const double elapsed = chrono::duration<double>(now - lastSample).count();
+            if (elapsed < SampleInterval) return;
+
+            for (uint i = 0; i < MemoryTagCount; ++i)
+            {
+                const uint64 total = CpuCounters[i].totalAllocations.load(memory_order_relaxed);
+                rates[i] = (lastSample.time_since_epoch().count() == 0) ? 0.0f
+                                                                         : static_cast<float>((total - lastTotals[i]) / elapsed);
+                lastTotals[i] = total;
+            }
+            lastSample = now;
+        }
+    };
+    AllocationRateSampler RateSampler;
+}
+
+
+//**********************************************************************************************************************
+//                                                  CPU Allocations
+//**********************************************************************************************************************
+void* MemoryTracker::Allocate(size_t size, size_t alignment, MemoryTag tag)
+{
+    // over-aligned blocks leave room to slide the header and user memory forward to the next boundary
+    const size_t padding = (alignment > sizeof(AllocationHeader)) ? alignment : 0;
+    uint8_t* pBlock = static_cast<uint8_t*>(malloc(size + padding + sizeof(AllocationHeader)));
+    if (pBlock == nullptr) return nullptr;
+
+    uintptr_t user = reinterpret_cast<uintptr_t>(pBlock) + sizeof(AllocationHeader);
+    if (padding > 0) user = (user + alignment - 1) & ~(uintptr_t(alignment) - 1);
+
+    void* pMemory = reinterpret_cast<void*>(user);
+    AllocationHeader* pHeader = GetHeader(pMemory);
+    pHeader->sizeAndTag = (uint64(size) << 8) | tag;
+    pHeader->offset     = static_cast<uint32_t>(user - reinterpret_cast<uintptr_t>(pBlock));
+    pHeader->magic      = SaltedMagic(pMemory);
+
+    CpuCounters[tag].Add(size);
+    if (IsFrameThread && tag != MemoryTagProfiler) FrameThreadAllocations.fetch_add(1, memory_order_relaxed);
+    return pMemory;
+}
+
+void MemoryTracker::Free(void* pMemory)
+{
+    if (pMemory == nullptr) return;
+
+    AllocationHeader* pHeader = GetHeader(pMemory);
+    if (pHeader->magic != SaltedMagic(pMemory))
+    {
+        free(pMemory);
+        return;
+    }
+
+    CpuCounters[pHeader->sizeAndTag & 0xff].Remove(pHeader->sizeAndTag >> 8);
+    pHeader->magic = 0;
+    free(reinterpret_cast<uint8_t*>(pMemory) - pHeader->offset);
+}
+
+void MemoryTracker::MarkFrameThread()
+{
+    IsFrameThread = true;
+}
+
+uint64 MemoryTracker::GetFrameThreadAllocations()
+{
+    return FrameThreadAllocations.load(memory_order_relaxed);
+}
+
+MemoryTag MemoryTracker::GetThreadTag()
+{
+    return CurrentTag;
+}
+
+MemoryTag MemoryTracker::SetThreadTag(MemoryTag tag)
+{
+    const MemoryTag previous = CurrentTag;
+    CurrentTag = tag;
+    return previous;
+}
+
+void* MemoryTracker::ImGuiAllocate(size_t size, void* pUserData)
+{
+    return Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, MemoryTagUI);
+}
+
+void MemoryTracker::ImGuiFree(void* pMemory, void* pUserData)
+{
+    Free(pMemory);
+}
+
+void MemoryTracker::InstallImGuiAllocator()
+{
+#if defined(SHADE_MEMORY_TRACKING)
+    ImGui::SetAllocatorFunctions(ImGuiAllocate, ImGuiFree);
+#endif
+}
+
+bool MemoryTracker::IsCpuTrackingEnabled()
+{
+#if defined(SHADE_MEMORY_TRACKING)
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+//**********************************************************************************************************************
+//                                                  GPU Resources
+//**********************************************************************************************************************
+void MemoryTracker::TrackResource(ID3D12Resource* pResource, D3D12_HEAP_TYPE heapType, uint64 bytes)
+{
+    if (pResource == nullptr) return;
+    if (heapType >= HeapTypeCount) heapType = D3D12_HEAP_TYPE_CUSTOM;
+
+    // the resource holds the only reference once attached, and one that fails to attach is untracked straight away
+    ComPtr<IUnknown> pSentinel;
+    pSentinel.Attach(new ResourceSentinel(heapType, GetThreadTag(), bytes));
+    if (FAILED(pResource->SetPrivateDataInterface(MemoryTrackerSentinelGuid, pSentinel.Get())))
+    {
+        PrintMessage(Warning, "Unable to track the memory of a resource");
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                      Queries
+//**********************************************************************************************************************
+MemoryStats MemoryTracker::GetCpuStats(MemoryTag tag)
+{
+    return CpuCounters[tag].Load();
+}
+
+MemoryStats MemoryTracker::GetGpuStats(D3D12_HEAP_TYPE heapType)
+{
+    return (heapType < HeapTypeCount) ? GpuHeapCounters[heapType].Load() : MemoryStats{};
+}
+
+uint64 MemoryTracker::GetGpuLiveBytes(MemoryTag tag)
+{
+    return GpuTagCounters[tag].liveBytes.load(memory_order_relaxed);
+}
+
+const char* MemoryTracker::GetTagName(MemoryTag tag)
+{
+    return MemoryTagNames[tag];
+}
+
+
+//**********************************************************************************************************************
+//                                                      Output
+//**********************************************************************************************************************
+void MemoryTracker::Dump()
+{
+    // snapshot first, so that the output's own allocations are not part of it
+    MemoryStats cpu[MemoryTagCount];
+    MemoryStats gpuTags[MemoryTagCount];
+    MemoryStats gpuHeaps[HeapTypeCount];
+    for (uint i = 0; i < MemoryTagCount; ++i) cpu[i] = CpuCounters[i].Load();
+    for (uint i = 0; i < MemoryTagCount; ++i) gpuTags[i] = GpuTagCounters[i].Load();
+    for (uint i = 0; i < HeapTypeCount; ++i) gpuHeaps[i] = GpuHeapCounters[i].Load();
+
+    if (IsCpuTrackingEnabled())
+    {
+        PrintMessage(Info, "CPU memory by subsystem:");
+        for (uint i = 0; i < MemoryTagCount; ++i)
+        {
+            PrintMessage(Info, "  {:<16} live {:>11} ({:>7} blocks)  peak {:>11}  allocated {:>11} in {} blocks",
+                         MemoryTagNames[i], FormatBytes(cpu[i].liveBytes), cpu[i].liveAllocations,
+                         FormatBytes(cpu[i].peakBytes), FormatBytes(cpu[i].totalBytes), cpu[i].totalAllocations);
+        }
+    }
+    else
+    {
+        PrintMessage(Info, "CPU memory tracking is not built in (SHADE_MEMORY_TRACKING)");
+    }
+
+    PrintMessage(Info, "GPU memory by heap type:");
+    for (uint i = 0; i < HeapTypeCount; ++i)
+    {
+        if (gpuHeaps[i].totalAllocations == 0) continue;
+        PrintMessage(Info, "  {:<16} live {:>11} ({:>4} resources)  peak {:>11}",
+                     HeapTypeNames[i], FormatBytes(gpuHeaps[i].liveBytes), gpuHeaps[i].liveAllocations,
+                     FormatBytes(gpuHeaps[i].peakBytes));
+    }
+
+    PrintMessage(Info, "GPU memory by subsystem:");
+    for (uint i = 0; i < MemoryTagCount; ++i)
+    {
+        if (gpuTags[i].totalAllocations == 0) continue;
+        PrintMessage(Info, "  {:<16} live {:>11} ({:>4} resources)  peak {:>11}",
+                     MemoryTagNames[i], FormatBytes(gpuTags[i].liveBytes), gpuTags[i].liveAllocations,
+                     FormatBytes(gpuTags[i].peakBytes));
+    }
+}
+
+void MemoryTracker::BuildUI()
+{
+    RateSampler.Update();
+    const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit;
+
+    if (!IsCpuTrackingEnabled())
+    {
+        ImGui::TextDisabled("CPU tracking is not built in (SHADE_MEMORY_TRACKING)");
+    }
+    else if (ImGui::CollapsingHeader("CPU", ImGuiTreeNodeFlags_DefaultOpen) && ImGui::BeginTable("CPU Memory", 6, flags))
+    {
+        ImGui::TableSetupColumn("Subsystem");
+        ImGui::TableSetupColumn("Live");
+        ImGui::TableSetupColumn("Peak");
+        ImGui::TableSetupColumn("Blocks");
+        ImGui::TableSetupColumn("Allocs/s");
+        ImGui::TableSetupColumn("Allocated");
+        ImGui::TableHeadersRow();
+
+        for (uint i = 0; i < MemoryTagCount; ++i)
+        {
+            const MemoryStats stats = CpuCounters[i].Load();
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();   ImGui::TextUnformatted(MemoryTagNames[i]);
+            ImGui::TableNextColumn();   ImGui::TextUnformatted(FormatBytes(stats.liveBytes).c_str());
+            ImGui::TableNextColumn();   ImGui::TextUnformatted(FormatBytes(stats.peakBytes).c_str());
+            ImGui::TableNextColumn();   ImGui::Text("%llu", (unsigned long long)stats.liveAllocations);
+            ImGui::TableNextColumn();   ImGui::Text("%.0f", RateSampler.rates[i]);
+            ImGui::TableNextColumn();   ImGui::TextUnformatted(FormatBytes(stats.totalBytes).c_str());
+        }
+        ImGui::EndTable();
+    }
+
+    if (ImGui::CollapsingHeader("GPU", ImGuiTreeNodeFlags_DefaultOpen))
+    {
+        if (ImGui::BeginTable("GPU Heaps", 4, flags))
+        {
+            ImGui::TableSetupColumn("Heap type");
+            ImGui::TableSetupColumn("Live");
+            ImGui::TableSetupColumn("Peak");
+            ImGui::TableSetupColumn("Resources");
+            ImGui::TableHeadersRow();
+
+            for (uint i = D3D12_HEAP_TYPE_DEFAULT; i < HeapTypeCount; ++i)
+            {
+                const MemoryStats stats = GpuHeapCounters[i].Load();
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();   ImGui::TextUnformatted(HeapTypeNames[i]);
+                ImGui::TableNextColumn();   ImGui::TextUnformatted(FormatBytes(stats.liveBytes).c_str());
+                ImGui::TableNextColumn();   ImGui::TextUnformatted(FormatBytes(stats.peakBytes).c_str());
+                ImGui::TableNextColumn();   ImGui::Text("%llu", (unsigned long long)stats.liveAllocations);
+            }
+            ImGui::EndTable();
+        }
+
+        if (ImGui::BeginTable("GPU Subsystems", 3, flags))
+        {
+            ImGui::TableSetupColumn("Subsystem");
+            ImGui::TableSetupColumn("Live");
+            ImGui::TableSetupColumn("Resources");
+            ImGui::TableHeadersRow();
+
+            for (uint i = 0; i < MemoryTagCount; ++i)
+            {
+                const MemoryStats stats = GpuTagCounters[i].Load();
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();   ImGui::TextUnformatted(MemoryTagNames[i]);
+                ImGui::TableNextColumn();   ImGui::TextUnformatted(FormatBytes(stats.liveBytes).c_str());
+                ImGui::TableNextColumn();   ImGui::Text("%llu", (unsigned long long)stats.liveAllocations);
+            }
+            ImGui::EndTable();
+        }
+    }
+
+    if (ImGui::Button("Dump")) Dump();
+}
+
+
+//**********************************************************************************************************************
+//                                              Global Allocation Hooks
+//**********************************************************************************************************************
+// Every replaceable form of operator new and delete, routed through the tracker with the calling thread's tag.
+#if defined(SHADE_MEMORY_TRACKING)
+namespace
+{
+    void* TrackedNew(size_t size, size_t alignment)
+    {
+        void* pMemory = MemoryTracker::Allocate(size, alignment, CurrentTag);
+        if (pMemory == nullptr) throw bad_alloc();
+        return pMemory;
+    }
+}
+
+void* operator new(size_t size)                                             {return TrackedNew(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);}
+void* operator new[](size_t size)                                           {return TrackedNew(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);}
+void* operator new(size_t size, align_val_t alignment)                      {return TrackedNew(size, size_t(alignment));}
+void* operator new[](size_t size, align_val_t alignment)                    {return TrackedNew(size, size_t(alignment));}
+void* operator new(size_t size, const nothrow_t&) noexcept                  {return MemoryTracker::Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, CurrentTag);}
+void* operator new[](size_t size, const nothrow_t&) noexcept                {return MemoryTracker::Allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, CurrentTag);}
+void* operator new(size_t size, align_val_t alignment, const nothrow_t&) noexcept   {return MemoryTracker::Allocate(size, size_t(alignment), CurrentTag);}
+void* operator new[](size_t size, align_val_t alignment, const nothrow_t&) noexcept {return MemoryTracker::Allocate(size, size_t(alignment), CurrentTag);}
+
+void operator delete(void* pMemory) noexcept                                        {MemoryTracker::Free(pMemory);}
+void operator delete[](void* pMemory) noexcept                                      {MemoryTracker::Free(pMemory);}
+void operator delete(void* pMemory, size_t) noexcept                                {MemoryTracker::Free(pMemory);}
+void operator delete[](void* pMemory, size_t) noexcept                              {MemoryTracker::Free(pMemory);}
+void operator delete(void* pMemory, align_val_t) noexcept                           {MemoryTracker::Free(pMemory);}
+void operator delete[](void* pMemory, align_val_t) noexcept                         {MemoryTracker::Free(pMemory);}
+void operator delete(void* pMemory, size_t, align_val_t) noexcept                   {MemoryTracker::Free(pMemory);}
+void operator delete[](void* pMemory, size_t, align_val_t) noexcept                 {MemoryTracker::Free(pMemory);}
+void operator delete(void* pMemory, const nothrow_t&) noexcept                      {MemoryTracker::Free(pMemory);}
+void operator delete[](void* pMemory, const nothrow_t&) noexcept                    {MemoryTracker::Free(pMemory);}
+void operator delete(void* pMemory, align_val_t, const nothrow_t&) noexcept         {MemoryTracker::Free(pMemory);}
+void operator delete[](void* pMemory, align_val_t, const nothrow_t&) noexcept       {MemoryTracker::Free(pMemory);}
+#endif
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <atomic>
+
+#include "Util.h"
+
+
+// Subsystems to which memory is attributed. CPU allocations take the tag of the innermost MEMORY_SCOPE on the
+//  allocating thread, and GPU resources the tag in effect when they are created.
+enum MemoryTag
+{
+    MemoryTagUntagged,
+    MemoryTagMesh,
+    MemoryTagGeometryManager,
+    MemoryTagPipelineState,
+    MemoryTagNodeEditor,
+    MemoryTagUI,
+    MemoryTagFrameArena,        // blocks of the per-thread frame arenas, not what is allocated from them
+    MemoryTagProfiler,
+    MemoryTagCount
+};
+
+
+//**********************************************************************************************************************
+//                                                  Instrumentation
+//**********************************************************************************************************************
+// CPU tracking replaces the global operator new and delete, so it is only compiled in with SHADE_MEMORY_TRACKING.
+//  Without it, scopes vanish and only GPU resources are accounted.
+#if defined(SHADE_MEMORY_TRACKING)
+#define MEMORY_CONCAT_INNER(a, b)   a##b
+#define MEMORY_CONCAT(a, b)         MEMORY_CONCAT_INNER(a, b)
+#define MEMORY_SCOPE(tag)           MemoryTagScope MEMORY_CONCAT(memoryScope, __LINE__)(tag)
+#else
+#define MEMORY_SCOPE(tag)           ((void)0)
+#endif
+
+
+struct MemoryStats
+{
+    uint64  liveBytes;
+    uint64  peakBytes;
+    uint64  liveAllocations;
+    uint64  totalAllocations;       // since startup, from which allocation rates are derived
+    uint64  totalBytes;
+};
+
+
+// Process-wide memory accounting. Counters are atomics with static storage, so that allocations made during static
+//  initialization are counted, and nothing here takes a lock.
+//
+// Allocations made inside other modules are only seen where the global operator new is interposed across modules, as
+//  with shared libraries on Linux. On Windows, assimp's own heap (and so the aiScene it builds) is not visible.
+class MemoryTracker
+{
+public:
+    // CPU allocations, prefixed by a header recording their size and tag
+    static void* Allocate(size_t size, size_t alignment, MemoryTag tag);
+    static void Free(void* pMemory);
+    static MemoryTag GetThreadTag();
+    static MemoryTag SetThreadTag(MemoryTag tag);   // returns the previous tag
+
+    // Allocations made by the threads doing frame work, the main thread and job workers, so that a frame's count is
+    //  not disturbed by whatever background threads allocate meanwhile. The profiler's are left out, as its history
+    //  grows every frame by design.
+    static void MarkFrameThread();
+    static uint64 GetFrameThreadAllocations();
+
+    // ImGui's allocator hooks, which attribute everything ImGui and imnodes allocate to the UI
+    static void* ImGuiAllocate(size_t size, void* pUserData);
+    static void ImGuiFree(void* pMemory, void* pUserData);
+    static void InstallImGuiAllocator();    // before the ImGui context is created
+
+    // Accounts a GPU resource until it is destroyed, which is detected through a private data interface attached to
+    //  the resource and released along with it.
+    static void TrackResource(ID3D12Resource* pResource, D3D12_HEAP_TYPE heapType, uint64 bytes);
+
+    // snapshots
+    static MemoryStats GetCpuStats(MemoryTag tag);
+    static MemoryStats GetGpuStats(D3D12_HEAP_TYPE heapType);
+    static uint64 GetGpuLiveBytes(MemoryTag tag);
+    static bool IsCpuTrackingEnabled();
+
+    // output
+    static void Dump();
+    static void BuildUI();
+
+    static const char* GetTagName(MemoryTag tag);
+};
+
+
+// Attributes allocations on this thread to a tag for the lifetime of the scope.
+class MemoryTagScope
+{
+public:
+    MemoryTagScope(MemoryTag tag) : m_previous(MemoryTracker::SetThreadTag(tag)) {}
+    ~MemoryTagScope()   {MemoryTracker::SetThreadTag(m_previous);}
+
+    MemoryTagScope(const MemoryTagScope&) = delete;
+    MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+
+private:
+    MemoryTag m_previous;
+};
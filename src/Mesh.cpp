@@ -1,13 +1,22 @@
 #include "Mesh.h"
 
+#include <cfloat>
+
+#include "MemoryTracker.h"
+#include "Profiler.h"
+
 using namespace std;
 using namespace std::filesystem;
 using namespace Assimp;
 using namespace DirectX;
 
 
-//Assimp::Importer Mesh::m_importer = Assimp::Importer();
-Assimp::Importer Mesh::m_importer;
+const VertexStreamInfo VertexStreamInfos[VertexStreamCount] =
+{
+    {"POSITION",    DXGI_FORMAT_R32G32B32_FLOAT,    sizeof(aiVector3D)},
+    {"COLOR",       DXGI_FORMAT_R32G32B32_FLOAT,    sizeof(aiColor4D)},     // alpha is left out, and reads as 1
+    {"NORMAL",      DXGI_FORMAT_R32G32B32_FLOAT,    sizeof(aiVector3D)},
+};
 
 map<string, MeshFileFormat> Mesh::FileExtensionMap = {
     {"",        UnknownFormat},
@@ -17,12 +26,14 @@ map<string, MeshFileFormat> Mesh::FileExtensionMap = {
 
 Mesh::Mesh()
     :
+    m_pScene(nullptr),
     m_isValidMesh(false)
 {
 }
 
 Mesh::Mesh(string filename)
     :
+    m_pScene(nullptr),
     m_isValidMesh(false)
 {
     LoadFromFile(filename);
@@ -40,11 +51,6 @@ Mesh::Mesh(Mesh& other)
 
 Mesh::~Mesh()
 {
-    if (m_isValidMesh)
-    {
-        m_importer.FreeScene();
-    }
-
     if (m_pScene != nullptr)
     {
         delete m_pScene;
@@ -53,6 +59,8 @@ Mesh::~Mesh()
 
 HRESULT Mesh::LoadFromFile(string filename)
 {
+    PROFILE_FUNCTION();
+    MEMORY_SCOPE(MemoryTagMesh);
     HRESULT result = S_OK;
 
     // verify file exists
@@ -67,49 +75,47 @@ HRESULT Mesh::LoadFromFile(string filename)
     }
     else
     {
+        // importers are not thread safe, so each load has its own and meshes may be loaded on any thread
+        Importer importer;
         const uint flags = aiProcess_JoinIdenticalVertices | aiProcess_Triangulate;
-        //m_importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, aiComponent_MATERIALS); // strip materials
-        m_pScene = const_cast<aiScene*>(m_importer.ReadFile(filepath.string(), flags));
+        //importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, aiComponent_MATERIALS); // strip materials
+        m_pScene = const_cast<aiScene*>(importer.ReadFile(filepath.string(), flags));
         if (m_pScene == nullptr)
         {
-            PrintMessage(Error, "assimp failed to load {}\n\t\t{}", filepath.filename().string(), m_importer.GetErrorString());
+            PrintMessage(Error, "assimp failed to load {}\n\t\t{}", filepath.filename().string(), importer.GetErrorString());
             result = E_FAIL;
         }
         else
         {
             // TODO: use dynamically allocated storage
-            m_pScene = m_importer.GetOrphanedScene(); // detach scene from importer
-            PrintMessage(Info,
-                         "{} loaded:\n"
-                         "\t{} meshes, {} materials, {} textures\n"
-                         "\t{} cameras, {} lights, {} animations",
-                         filepath.string(),
-                         m_pScene->mNumMeshes, m_pScene->mNumMaterials, m_pScene->mNumTextures,
-                         m_pScene->mNumCameras, m_pScene->mNumLights, m_pScene->mNumAnimations);
+            m_pScene = importer.GetOrphanedScene(); // detach scene from importer
+            LOG_INFO("{} loaded:\n"
+                     "\t{} meshes, {} materials, {} textures\n"
+                     "\t{} cameras, {} lights, {} animations",
+                     filepath.string(),
+                     m_pScene->mNumMeshes, m_pScene->mNumMaterials, m_pScene->mNumTextures,
+                     m_pScene->mNumCameras, m_pScene->mNumLights, m_pScene->mNumAnimations);
             for (uint i=0; i<m_pScene->mNumMeshes; ++i)
             {
                 aiMesh* pMesh = m_pScene->mMeshes[i];
-                PrintMessage(Info,
-                             "\t\"{}\" - {} vertices, {} faces, {} bones\n"
-                             "\t\t{} color channels, {} UV channels, material #{}",
-                             pMesh->mName.C_Str(), pMesh->mNumVertices, pMesh->mNumFaces, pMesh->mNumBones,
-                             pMesh->GetNumColorChannels(), pMesh->GetNumUVChannels(), pMesh->mMaterialIndex
-                             );
+                LOG_DEBUG("\t\"{}\" - {} vertices, {} faces, {} bones\n"
+                          "\t\t{} color channels, {} UV channels, material #{}",
+                          pMesh->mName.C_Str(), pMesh->mNumVertices, pMesh->mNumFaces, pMesh->mNumBones,
+                          pMesh->GetNumColorChannels(), pMesh->GetNumUVChannels(), pMesh->mMaterialIndex
+                          );
             }
             for (uint i = 0; i < m_pScene->mNumMaterials; ++i)
             {
                 aiMaterial* pMaterial = m_pScene->mMaterials[i];
-                PrintMessage(Info,
-                             "\t\"{}\" - {} properties\n",
-                             pMaterial->GetName().C_Str(), pMaterial->mNumProperties
+                LOG_DEBUG("\t\"{}\" - {} properties\n",
+                          pMaterial->GetName().C_Str(), pMaterial->mNumProperties
                 );
                 for (uint j = 0; j < pMaterial->mNumProperties; ++j)
                 {
                     aiMaterialProperty* pProperty = pMaterial->mProperties[j];
-                    PrintMessage(Info,
-                                 "\t\t{} - {}",
-                                 j, pProperty->mKey.C_Str()
-                                 );
+                    LOG_DEBUG("\t\t{} - {}",
+                              j, pProperty->mKey.C_Str()
+                              );
                 }
             }
 
@@ -124,12 +130,35 @@ HRESULT Mesh::LoadFromFile(string filename)
 
 void Mesh::Unload()
 {
-    m_importer.FreeScene();
+    delete m_pScene;
+    m_pScene = nullptr;
 
     m_isValidMesh = false;
 }
 
-MeshBufferLayout Mesh::PopulateGeometryBuffer(void* pBuffer)
+BoundingBox Mesh::ComputeBounds() const
+{
+    BoundingBox bounds;
+    if (m_pScene == nullptr) return bounds;
+
+    XMVECTOR minimum = XMVectorReplicate(FLT_MAX);
+    XMVECTOR maximum = XMVectorReplicate(-FLT_MAX);
+    for (uint i = 0; i < m_pScene->mNumMeshes; ++i)
+    {
+        const aiMesh* pMesh = m_pScene->mMeshes[i];
+        for (uint j = 0; j < pMesh->mNumVertices; ++j)
+        {
+            const XMVECTOR position = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(&pMesh->mVertices[j]));
+            minimum = XMVectorMin(minimum, position);
+            maximum = XMVectorMax(maximum, position);
+        }
+    }
+
+    if (XMVector3LessOrEqual(minimum, maximum)) BoundingBox::CreateFromPoints(bounds, minimum, maximum);
+    return bounds;
+}
+
+MeshBufferLayout Mesh::PopulateGeometryBuffer(void* pBuffer, uint streams)
 {
     HRESULT result = S_OK;
     MeshBufferLayout layout = {};
@@ -142,6 +171,7 @@ MeshBufferLayout Mesh::PopulateGeometryBuffer(void* pBuffer)
         aiMesh* pMesh =  m_pScene->mMeshes[i];
 
         // vertices
+        if (streams & (1u << VertexStreamPosition))
         {
             layout.vertexSize = pMesh->mNumVertices * sizeof(aiVector3D);
             layout.vertexOffset = totalOffset;
@@ -152,16 +182,16 @@ MeshBufferLayout Mesh::PopulateGeometryBuffer(void* pBuffer)
         }
 
         //per-vertex colors
-        if (pMesh->HasVertexColors(0))
+        if ((streams & (1u << VertexStreamColor)) && pMesh->HasVertexColors(0))
         {
             layout.colorSize = pMesh->mNumVertices * sizeof(aiColor4D);
             layout.colorOffset = totalOffset;
 
-            memcpy(writePointer, pMesh->mColors[i], layout.colorSize);
+            memcpy(writePointer, pMesh->mColors[0], layout.colorSize);
             writePointer += pMesh->mNumVertices * 4;
             totalOffset += layout.colorSize;
         }
-        else
+        else if (streams & (1u << VertexStreamColor))
         {
             layout.colorSize = pMesh->mNumVertices * sizeof(aiColor4D);
             layout.colorOffset = totalOffset;
@@ -176,15 +206,17 @@ MeshBufferLayout Mesh::PopulateGeometryBuffer(void* pBuffer)
             totalOffset += layout.colorSize;
         }
 
-        //if (pMesh->HasNormals())
-        //{
-        //    layout.normalSize = pMesh->mNumVertices * sizeof(aiVector3D);
-        //    layout.normalOffset = totalOffset;
-        //    //memcpy(writePointer, &test, sizeof(test));
-        //    memcpy(writePointer, pMesh->mNormals, layout.normalSize);
-        //    writePointer += pMesh->mNumVertices * 3;
-        //    totalOffset += layout.normalSize;
-        //}
+        // per-vertex normals, zero for meshes without any
+        if (streams & (1u << VertexStreamNormal))
+        {
+            layout.normalSize = pMesh->mNumVertices * sizeof(aiVector3D);
+            layout.normalOffset = totalOffset;
+
+            if (pMesh->HasNormals()) memcpy(writePointer, pMesh->mNormals, layout.normalSize);
+            else memset(writePointer, 0, layout.normalSize);
+            writePointer += pMesh->mNumVertices * 3;
+            totalOffset += layout.normalSize;
+        }
 
         // linearize index buffer to notate faces
         if (pMesh->HasFaces())
@@ -201,23 +233,35 @@ MeshBufferLayout Mesh::PopulateGeometryBuffer(void* pBuffer)
         }
     }
 
-    layout.totalSize = layout.vertexSize + layout.colorSize +
-                       layout.normalSize + layout.normalOffset;
-    PrintMessage("\n=== Offsets ==="
-                 "\nVertices:   {}"
-                 "\nColors:     {}"
-                 "\nNormals:    {}"
-                 "\nFaces:      {}"
-                 "\n",
-                 layout.vertexOffset, layout.colorOffset, layout.normalOffset, layout.facesOffset);
-    PrintMessage("\n=== Sizes ==="
-                 "\nVertices:   {}"
-                 "\nColors:     {}"
-                 "\nNormals:    {}"
-                 "\nFaces:      {}"
-                 "\nTOTAL:      {}"
-                 "\n",
-                 layout.vertexSize, layout.colorSize, layout.normalSize, layout.facesSize, layout.totalSize);
+    layout.totalSize = totalOffset;
+    LOG_DEBUG("\n=== Offsets ==="
+              "\nVertices:   {}"
+              "\nColors:     {}"
+              "\nNormals:    {}"
+              "\nFaces:      {}",
+              layout.vertexOffset, layout.colorOffset, layout.normalOffset, layout.facesOffset);
+    LOG_DEBUG("\n=== Sizes ==="
+              "\nVertices:   {}"
+              "\nColors:     {}"
+              "\nNormals:    {}"
+              "\nFaces:      {}"
+              "\nTOTAL:      {}",
+              layout.vertexSize, layout.colorSize, layout.normalSize, layout.facesSize, layout.totalSize);
 
     return layout;
 }
+
+uint Mesh::GetGeometryBufferSize(uint streams) const
+{
+    uint size = 0;
+    for (uint i = 0; i < m_pScene->mNumMeshes; ++i)
+    {
+        const aiMesh* pMesh = m_pScene->mMeshes[i];
+        for (uint stream = 0; stream < VertexStreamCount; ++stream)
+        {
+            if (streams & (1u << stream)) size += pMesh->mNumVertices * VertexStreamInfos[stream].stride;
+        }
+        size += pMesh->mNumFaces * 3 * sizeof(uint);
+    }
+    return size;
+}
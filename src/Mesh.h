@@ -10,6 +10,7 @@
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <DirectXCollision.h>
 #include <DirectXMath.h>
 
 
@@ -19,6 +20,27 @@ enum MeshFileFormat
     OBJ,
 };
 
+// Per-vertex attributes, each laid out as a stream of its own and bound to the input slot numbered as it is. Sets of
+//  streams are masks with bit i set for stream i.
+enum VertexStream
+{
+    VertexStreamPosition,
+    VertexStreamColor,
+    VertexStreamNormal,
+    VertexStreamCount
+};
+
+constexpr uint VertexStreamsAll = (1u << VertexStreamCount) - 1;
+
+struct VertexStreamInfo
+{
+    const char*     pSemanticName;      // of the vertex shader input reading the stream
+    DXGI_FORMAT     format;             // as the input assembler reads it
+    uint            stride;             // in bytes, which may be more than the format
+};
+
+extern const VertexStreamInfo VertexStreamInfos[VertexStreamCount];
+
 struct MeshBufferLayout
 {
     uint vertexOffset;
@@ -44,7 +66,9 @@ public:
     // main functionality
     HRESULT LoadFromFile(std::string filename);
     void Unload();
-    MeshBufferLayout PopulateGeometryBuffer(void* pBuffer);
+    MeshBufferLayout PopulateGeometryBuffer(void* pBuffer, uint streams);   // leaves out the streams not in the mask
+    uint GetGeometryBufferSize(uint streams) const;
+    DirectX::BoundingBox ComputeBounds() const;     // of every vertex in the scene, as laid out in the buffer
 
     // setters/getters/queries
     const aiScene* GetScene() const {return m_pScene;}
@@ -54,7 +78,6 @@ public:
 
 private:
     static std::map<std::string, MeshFileFormat> FileExtensionMap;
-    static Assimp::Importer m_importer;
     aiScene* m_pScene;
 
     bool m_isValidMesh;
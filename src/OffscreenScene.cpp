@@ -0,0 +1,81 @@
+#include "OffscreenScene.h"
+
+#include "TaskGraph.h"
+
+
+OffscreenScene::OffscreenScene(const OffscreenSceneDesc& desc) :
+    m_desc(desc),
+    m_constantBufferData({}),
+    m_frameIndex(0)
+{
+}
+OffscreenScene::~OffscreenScene()
+{
+}
+
+void OffscreenScene::Init(RenderEngine* pEngine)
+{
+    // the pipeline comes first, as meshes are uploaded with only the vertex streams its shaders read
+    PipelineCreateInfo pipelineCreateInfo = {};
+    pipelineCreateInfo.RenderTargetWidth = m_desc.width;
+    pipelineCreateInfo.RenderTargetHeight = m_desc.height;
+    m_pipelineState.Init(pipelineCreateInfo);
+
+    m_geometryManager.Init();
+    m_geometryManager.SetVertexStreams(m_pipelineState.GetVertexStreams());
+    m_geometryManager.AddMeshes(m_desc.meshes);
+
+    m_camera.SetPosition(m_desc.eye);
+    m_camera.LookAt(m_desc.target);
+    m_camera.SetAspectRatio(static_cast<float>(m_desc.width) / m_desc.height);
+
+    m_pipelineState.RegisterGeometryManager(&m_geometryManager);
+    m_pipelineState.SetConstantBufferData({&m_constantBufferData, sizeof(m_constantBufferData)});
+}
+
+void OffscreenScene::AddTasks(TaskGraph& graph)
+{
+    graph.AddTask("Camera", [this] {OnUpdate();})
+        .Reads(&m_frameIndex)
+        .Writes(&m_camera)
+        .Writes(&m_constantBufferData)
+        .Measures(FrameStatUpdateTime);
+
+    m_geometryManager.AddTasks(graph, &m_camera);
+
+    graph.AddTask("Scene::OnRender", [this] {OnRender();})
+        .Reads(&m_constantBufferData)
+        .Reads(m_geometryManager.GetDrawables())
+        .Reads(m_geometryManager.GetDrawOrder())
+        .Writes(&m_pipelineState)
+        .Writes(&m_frameIndex)
+        .Writes(RenderEngine::pCurrentEngine)
+        .Measures(FrameStatRenderTime);
+}
+
+void OffscreenScene::OnUpdate()
+{
+    // orbit the eye about the target's vertical axis, stopping a frame short of the full turn so that 360 degrees loops
+    const float progress = static_cast<float>(m_frameIndex) / std::max(m_desc.frameCount, 1u);
+    const XMVECTOR target = XMLoadFloat3(&m_desc.target);
+    const XMVECTOR offset = XMLoadFloat3(&m_desc.eye) - target;
+    const XMMATRIX rotation = XMMatrixRotationY(XMConvertToRadians(m_desc.turntableDegrees * progress));
+
+    XMFLOAT3 eye;
+    XMStoreFloat3(&eye, target + XMVector3TransformNormal(offset, rotation));
+    m_camera.SetPosition(eye);
+    m_camera.LookAt(m_desc.target);
+    m_camera.Update();
+
+    // provide view and projection matrices to shader
+    XMStoreFloat4x4(&m_constantBufferData.viewMatrix, XMMatrixTranspose(m_camera.GetViewMatrix()));
+    XMStoreFloat4x4(&m_constantBufferData.projectionMatrix, XMMatrixTranspose(m_camera.GetProjectionMatrix()));
+}
+
+void OffscreenScene::OnRender()
+{
+    m_pipelineState.UpdateConstantBufferData();
+    m_pipelineState.Render();
+    m_pipelineState.Execute();
+    m_frameIndex++;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Scene.h"
+#include "PipelineState.h"
+#include "Camera.h"
+#include "GeometryManager.h"
+
+
+struct OffscreenSceneDesc
+{
+    std::vector<std::string>    meshes;             // files loaded through the geometry manager
+    XMFLOAT3                    eye;                // camera position
+    XMFLOAT3                    target;             // point the camera looks at
+    float                       turntableDegrees;   // orbit of the eye about target's vertical axis over the whole run
+    uint                        frameCount;         // frames over which the turntable orbit is spread
+    uint                        width;
+    uint                        height;
+};
+
+
+// Renders a fixed list of meshes from a scripted camera, with no UI, for batch and regression rendering. The camera
+//  can orbit its target over the run, which produces turntables when every frame is dumped.
+class OffscreenScene : public Scene
+{
+public:
+    OffscreenScene(const OffscreenSceneDesc& desc);
+    ~OffscreenScene();
+
+    void Init(RenderEngine* pEngine);
+    void BuildUI()  {}
+    void OnUpdate();
+    void OnRender();
+
+    void AddTasks(TaskGraph& graph);
+
+    ComPtr<ID3D12Resource> GetRenderTarget()    {return m_pipelineState.GetRenderTarget();}
+
+private:
+    struct SceneConstantBuffer
+    {
+        XMFLOAT4X4 viewMatrix;
+        XMFLOAT4X4 projectionMatrix;
+    };
+
+    // components
+    GeometryManager                     m_geometryManager;
+    PipelineState                       m_pipelineState;
+    Camera                              m_camera;
+
+    // scene data
+    OffscreenSceneDesc                  m_desc;
+    SceneConstantBuffer                 m_constantBufferData;
+    uint                                m_frameIndex;       // frame currently being rendered
+};
@@ -1,6 +1,11 @@
 #include "PipelineState.h"
 
+#if defined(_WIN32)
 #include <dxgi.h>
+#endif
+
+#include "MemoryTracker.h"
+#include "Profiler.h"
 
 // initialize pipeline ID counter
 uint PipelineState::m_pipelineIdCounter = 0;
@@ -10,14 +15,22 @@ PipelineState::PipelineState()
     :
     m_pipelineId(m_pipelineIdCounter++),
     m_viewport(0.0f, 0.0f, 800, 800),
-    m_scissorRect(0, 0, 800, 800)
+    m_scissorRect(0, 0, 800, 800),
+    m_permutation(0),
+    m_usingFallback(false),
+    m_vertexStreams(0),
+    m_reverseDepth(false)
 {
 }
 PipelineState::PipelineState(PipelineCreateInfo createInfo)
     :
     m_pipelineId(m_pipelineIdCounter++),
     m_viewport(0.0f, 0.0f, 800, 800),
-    m_scissorRect(0, 0, 800, 800)
+    m_scissorRect(0, 0, 800, 800),
+    m_permutation(0),
+    m_usingFallback(false),
+    m_vertexStreams(0),
+    m_reverseDepth(false)
 {
     Init(createInfo);
 }
@@ -27,31 +40,18 @@ PipelineState::~PipelineState()
 
 void PipelineState::Init(PipelineCreateInfo createInfo)
 {
-    Dx12RenderEngine* pEngine = Dx12RenderEngine::pCurrentEngine;
-    auto* pDevice = pEngine->GetDevice();
+    PROFILE_FUNCTION();
+    MEMORY_SCOPE(MemoryTagPipelineState);
+    RenderEngine* pEngine = RenderEngine::pCurrentEngine;
+
+    const uint width = (createInfo.RenderTargetWidth != 0) ? createInfo.RenderTargetWidth : 800;
+    const uint height = (createInfo.RenderTargetHeight != 0) ? createInfo.RenderTargetHeight : 800;
+    m_viewport = CD3DX12_VIEWPORT(0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height));
+    m_scissorRect = CD3DX12_RECT(0, 0, width, height);
 
     pEngine->CreateCommandAllocator(&m_pCommandAllocator);
     pEngine->CreateCommandList(&m_pCommandList);
 
-    // create root signature
-    {
-        CD3DX12_DESCRIPTOR_RANGE1 ranges[1];
-        ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DATA_STATIC);
-        CD3DX12_ROOT_PARAMETER1 rootParameters[3];
-        rootParameters[0].InitAsConstantBufferView(0, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, D3D12_SHADER_VISIBILITY_ALL);  // global
-        rootParameters[1].InitAsConstantBufferView(1, 0, D3D12_ROOT_DESCRIPTOR_FLAG_DATA_STATIC, D3D12_SHADER_VISIBILITY_ALL);  // per-drawable
-        rootParameters[2].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_VERTEX);
-
-        D3D12_ROOT_SIGNATURE_FLAGS rootSignatureFlags =
-            D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT |
-            D3D12_ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS;
-
-        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
-        rootSignatureDesc.Init_1_1(_countof(rootParameters), rootParameters, 0, nullptr, rootSignatureFlags);
-
-        pEngine->CreateRootSignature(&rootSignatureDesc, &m_pRootSignature);
-    }
-
     // create this pipeline's heaps and committed resources
     {
         // descriptor heaps
@@ -61,34 +61,28 @@ void PipelineState::Init(PipelineCreateInfo createInfo)
             rtvHeapDesc.NumDescriptors = 1;
             rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
             rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-            CheckResult(pDevice->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&m_pRtvHeap)));
+            CheckResult(pEngine->CreateDescriptorHeap(&rtvHeapDesc, &m_pRtvHeap));
 
             // SRV descriptor heap
             D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
             srvHeapDesc.NumDescriptors = 2;
             srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
             srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-            CheckResult(pDevice->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&m_pSrvHeap)));
+            CheckResult(pEngine->CreateDescriptorHeap(&srvHeapDesc, &m_pSrvHeap));
 
             // DSV descriptor heap
             D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc = {};
             dsvHeapDesc.NumDescriptors = 1;
             dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
             dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-            CheckResult(pDevice->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&m_pDsvHeap)));
+            CheckResult(pEngine->CreateDescriptorHeap(&dsvHeapDesc, &m_pDsvHeap));
         }
 
         // constant buffer for per-frame data
         {
             const auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
             const auto bufferProps = CD3DX12_RESOURCE_DESC::Buffer(1024 * 64);
-            CheckResult(pDevice->CreateCommittedResource(
-                &heapProps,
-                D3D12_HEAP_FLAG_NONE,
-                &bufferProps,
-                D3D12_RESOURCE_STATE_GENERIC_READ,
-                nullptr,
-                IID_PPV_ARGS(&m_pConstantBuffer)));
+            CheckResult(pEngine->CreateResource(&heapProps, &bufferProps, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, &m_pConstantBuffer));
 
             CD3DX12_RANGE readRange(0, 0);
             CheckResult(m_pConstantBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_pConstandBufferDataDataBegin)));
@@ -97,8 +91,8 @@ void PipelineState::Init(PipelineCreateInfo createInfo)
         // render target
         {
             D3D12_RESOURCE_DESC desc = {};
-            desc.Width = 800;
-            desc.Height = 800;
+            desc.Width = width;
+            desc.Height = height;
             desc.DepthOrArraySize = 1;
             desc.SampleDesc.Count = 1;
             desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
@@ -107,17 +101,11 @@ void PipelineState::Init(PipelineCreateInfo createInfo)
 
             // create resource for render target
             const auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-            CheckResult(pDevice->CreateCommittedResource(
-                &heapProps,
-                D3D12_HEAP_FLAG_NONE,
-                &desc,
-                D3D12_RESOURCE_STATE_RENDER_TARGET,
-                nullptr,
-                IID_PPV_ARGS(&m_pRenderTarget)));
+            CheckResult(pEngine->CreateResource(&heapProps, &desc, D3D12_RESOURCE_STATE_RENDER_TARGET, nullptr, &m_pRenderTarget));
 
             // create render target view
             CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(m_pRtvHeap->GetCPUDescriptorHandleForHeapStart());
-            pDevice->CreateRenderTargetView(m_pRenderTarget.Get(), nullptr, rtvHandle);
+            pEngine->CreateRenderTargetView(m_pRenderTarget.Get(), nullptr, rtvHandle);
         }
 
         // depth stencil
@@ -128,40 +116,27 @@ void PipelineState::Init(PipelineCreateInfo createInfo)
             depthStencilDesc.Flags = D3D12_DSV_FLAG_NONE;
 
             const auto heapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
-            const auto texProps = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R32_TYPELESS, 800, 800, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
+            const auto texProps = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R32_TYPELESS, width, height, 1, 1, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
             const auto clearProps = CD3DX12_CLEAR_VALUE(DXGI_FORMAT_D32_FLOAT, 0.0f, 0);
-            CheckResult(pDevice->CreateCommittedResource(
-                &heapProps,
-                D3D12_HEAP_FLAG_NONE,
-                &texProps,
-                D3D12_RESOURCE_STATE_DEPTH_WRITE,
-                &clearProps,
-                IID_PPV_ARGS(&m_pDepthStencil)
-                ));
-
-            pDevice->CreateDepthStencilView(m_pDepthStencil.Get(), &depthStencilDesc, m_pDsvHeap->GetCPUDescriptorHandleForHeapStart());
+            CheckResult(pEngine->CreateResource(&heapProps, &texProps, D3D12_RESOURCE_STATE_DEPTH_WRITE, &clearProps, &m_pDepthStencil));
+
+            pEngine->CreateDepthStencilView(m_pDepthStencil.Get(), &depthStencilDesc, m_pDsvHeap->GetCPUDescriptorHandleForHeapStart());
         }
     }
 
-    static Shader vertexShader, pixelShader;
-    vertexShader.Compile("src/shaders.hlsl", "VSMain", "vs_6_0");
-    pixelShader.Compile("src/shaders.hlsl", "PSMain", "ps_6_0");
-
-    // IA layout for vertex buffers
-    static D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
+    // only the fallback permutation is compiled here, and the others when first rendered with
+    const std::vector<ShaderStageDesc> shaderStages =
     {
-        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-        { "COLOR", 0, DXGI_FORMAT_R32G32B32_FLOAT, 1, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+        {"src/shaders.hlsl", "VSMain", "vs_6_0"},
+        {"src/shaders.hlsl", "PSMain", "ps_6_0"},
     };
+    CheckResult(m_shaders.Init(shaderStages, {"VISUALIZE_DEPTH", "NODE_GRAPH"}), "compiling shaders", true);
 
     m_initialized = true;
 
-    // describe and create the PSO
-    D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
-    psoDesc.InputLayout                     = { inputElementDescs, _countof(inputElementDescs) };
-    psoDesc.pRootSignature                  = m_pRootSignature.Get();
-    psoDesc.VS                              = CD3DX12_SHADER_BYTECODE(vertexShader.GetBlob());
-    psoDesc.PS                              = CD3DX12_SHADER_BYTECODE(pixelShader.GetBlob());
+    // describe the PSO, whose root signature and input layout come with each permutation's shaders, and create the
+    //  fallback's for the initial depth test
+    psoDesc = {};
     psoDesc.RasterizerState                 = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
     psoDesc.BlendState                      = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
     psoDesc.DepthStencilState               = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);;
@@ -172,9 +147,11 @@ void PipelineState::Init(PipelineCreateInfo createInfo)
     psoDesc.RTVFormats[0]                   = DXGI_FORMAT_R8G8B8A8_UNORM;
     psoDesc.SampleDesc.Count                = 1;
 
-    CheckResult(pEngine->CreatePipelineState(&psoDesc, &m_pPipelineState), "compiling pipeline", true);
-    psoDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_GREATER;
-    CheckResult(pEngine->CreatePipelineState(&psoDesc, &m_pPipelineStateReverseDepth), "compiling reverse-depth pipeline", true);
+    const PipelineVariant* pFallback = GetVariantPipeline(0, m_shaders.GetFallback());
+    if (pFallback == nullptr) CheckResult(E_FAIL, "compiling pipeline", true);
+    m_pPipelineState = pFallback->pPipelineState;
+    m_pLayout = pFallback->pLayout;
+    m_vertexStreams = m_pLayout->vertexStreams;
     m_compiled = true;
 
     // set debug names
@@ -183,11 +160,8 @@ void PipelineState::Init(PipelineCreateInfo createInfo)
         SetDebugName(m_pCommandAllocator.Get(),             commonString + " command allocator");
         SetDebugName(m_pCommandList.Get(),                  commonString + " command list");
 
-        SetDebugName(m_pRootSignature.Get(),                commonString + " root signature");
         SetDebugName(m_pRtvHeap.Get(),                      commonString + " RTV descriptor heap");
         SetDebugName(m_pSrvHeap.Get(),                      commonString + " SRV descriptor heap");
-        SetDebugName(m_pPipelineState.Get(),                commonString + " PSO");
-        SetDebugName(m_pPipelineStateReverseDepth.Get(),    commonString + " reverse-depth PSO");
 
         SetDebugName(m_pRenderTarget.Get(),                 commonString + " render target");
         SetDebugName(m_pConstantBuffer.Get(),               commonString + " constant buffer");
@@ -197,14 +171,18 @@ void PipelineState::Init(PipelineCreateInfo createInfo)
 
 void PipelineState::Render()
 {
+    PROFILE_FUNCTION();
+    ID3D12PipelineState* pPipelineState = SelectPipelineState();
+
     CheckResult(m_pCommandAllocator->Reset());
-    CheckResult(m_pCommandList->Reset(m_pCommandAllocator.Get(), m_reverseDepth ? m_pPipelineStateReverseDepth.Get() : m_pPipelineState.Get()));
+    CheckResult(m_pCommandList->Reset(m_pCommandAllocator.Get(), pPipelineState));
 
     // specify resource layouts and bindings
-    m_pCommandList->SetGraphicsRootSignature(m_pRootSignature.Get());
+    m_pCommandList->SetGraphicsRootSignature(m_pLayout->pRootSignature.Get());
     ID3D12DescriptorHeap* ppHeaps[] = { m_pSrvHeap.Get() };
     //m_pCommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
-    m_pCommandList->SetGraphicsRootConstantBufferView(0, m_pConstantBuffer->GetGPUVirtualAddress());
+    SetRootConstantBuffer(m_pLayout->sceneConstants, m_pConstantBuffer->GetGPUVirtualAddress(), m_pConstantBufferData,
+                          m_constantBufferDataSize);
 
     // set rasterizer state
     m_pCommandList->RSSetViewports(1, &m_viewport);
@@ -224,20 +202,159 @@ void PipelineState::Render()
     CheckResult(m_pCommandList->Close());
 }
 
+void PipelineState::SetShaderKeyword(std::string_view keyword, bool enabled)
+{
+    const ShaderPermutationKey mask = m_shaders.GetKeywordMask(keyword);
+    if (mask == 0) LOG_WARNING("Pipeline #{} has no shader keyword {}", m_pipelineId, keyword);
+    m_permutation = enabled ? (m_permutation | mask) : (m_permutation & ~mask);
+}
+
+ID3D12PipelineState* PipelineState::SelectPipelineState()
+{
+    // one frame is in flight at most, and it finished before this one began
+    m_retiredObjects.clear();
+
+    // The requested permutation once it has compiled and its pipeline built, and the fallback's until then. Should even
+    //  that fail to build, after a reload, the latest frame's pipeline carries on.
+    const ShaderPermutations::Variant* pVariant = m_shaders.Request(m_permutation);
+    const PipelineVariant* pPipeline = nullptr;
+    if (pVariant != nullptr) pPipeline = GetVariantPipeline(m_permutation, *pVariant);
+    m_usingFallback = (pPipeline == nullptr);
+    if (m_usingFallback) pPipeline = GetVariantPipeline(0, m_shaders.GetFallback());
+
+    if (pPipeline != nullptr)
+    {
+        m_pPipelineState = pPipeline->pPipelineState;
+        m_pLayout = pPipeline->pLayout;
+    }
+    return m_pPipelineState.Get();
+}
+
+const PipelineState::PipelineVariant* PipelineState::GetVariantPipeline(ShaderPermutationKey key,
+                                                                        const ShaderPermutations::Variant& variant)
+{
+    // the depth test is the only state varying between pipelines, so it is not worth a permutation keyword of its own
+    const uint64 pipelineKey = (static_cast<uint64>(key) << 1) | (m_reverseDepth ? 1 : 0);
+    auto [found, inserted] = m_pipelineStates.try_emplace(pipelineKey, PipelineVariant{nullptr, nullptr, 0});
+    PipelineVariant& pipeline = found->second;
+    if (!inserted && pipeline.revision == variant.revision)
+    {
+        return (pipeline.pPipelineState != nullptr) ? &pipeline : nullptr;
+    }
+    PROFILE_SCOPE("Build Pipeline Variant");
+    MEMORY_SCOPE(MemoryTagPipelineState);
+
+    // a failure is not retried until the shaders are reloaded, and one after a reload keeps the previous pipeline
+    pipeline.revision = variant.revision;
+    std::shared_ptr<ProgramLayout> pLayout = GetProgramLayout(key, variant);
+    ComPtr<ID3D12PipelineState> pPipelineState;
+    if (pLayout->pRootSignature != nullptr)
+    {
+        D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = psoDesc;
+        desc.pRootSignature = pLayout->pRootSignature.Get();
+        desc.InputLayout = {pLayout->inputLayout.data(), static_cast<UINT>(pLayout->inputLayout.size())};
+        desc.VS = CD3DX12_SHADER_BYTECODE(variant.shaders[0]->GetBlob());
+        desc.PS = CD3DX12_SHADER_BYTECODE(variant.shaders[1]->GetBlob());
+        desc.DepthStencilState.DepthFunc = m_reverseDepth ? D3D12_COMPARISON_FUNC_GREATER : D3D12_COMPARISON_FUNC_LESS;
+        if (FAILED(RenderEngine::pCurrentEngine->CreatePipelineState(&desc, &pPipelineState))) pPipelineState.Reset();
+    }
+    if (pPipelineState == nullptr)
+    {
+        LOG_ERROR("Pipeline #{} could not be built for shader permutation {:#x}", m_pipelineId, key);
+        return (pipeline.pPipelineState != nullptr) ? &pipeline : nullptr;
+    }
+
+    if (pipeline.pPipelineState != nullptr)
+    {
+        m_retiredObjects.push_back(pipeline.pPipelineState.Get());
+        m_retiredObjects.push_back(pipeline.pLayout->pRootSignature.Get());
+        LOG_INFO("Pipeline #{} switched to reloaded shaders", m_pipelineId);
+    }
+    pipeline.pPipelineState = std::move(pPipelineState);
+    pipeline.pLayout = std::move(pLayout);
+
+    const std::string name = fmt::format("Pipeline #{} PSO {:#x}{}", m_pipelineId, key,
+                                         m_reverseDepth ? " reverse-depth" : "");
+    SetDebugName(pipeline.pPipelineState.Get(), name);
+    return &pipeline;
+}
+
+std::shared_ptr<PipelineState::ProgramLayout> PipelineState::GetProgramLayout(
+    ShaderPermutationKey key, const ShaderPermutations::Variant& variant)
+{
+    // shared by both depth tests' pipelines, while those built from earlier shaders hold on to the layout they had
+    std::shared_ptr<ProgramLayout>& pLayout = m_layouts[key];
+    if (pLayout != nullptr && pLayout->revision == variant.revision) return pLayout;
+
+    pLayout = std::make_shared<ProgramLayout>();
+    pLayout->vertexStreams  = 0;
+    pLayout->sceneConstants = -1;
+    pLayout->meshConstants  = -1;
+    pLayout->revision       = variant.revision;
+
+    // SPIR-V makes every constant buffer a uniform buffer, which cannot be root constants
+    const bool allowRootConstants = (RenderEngine::pCurrentEngine->GetShaderFormat() != ShaderFormatSpirv);
+    ShaderReflection reflection;
+    HRESULT result = reflection.Reflect(variant.shaders);
+    if (SUCCEEDED(result)) result = reflection.GetInputLayout(pLayout->inputLayout, pLayout->vertexStreams);
+    if (SUCCEEDED(result))
+    {
+        result = reflection.CreateRootSignature(allowRootConstants, pLayout->pRootSignature, pLayout->rootParameters);
+    }
+    if (FAILED(result))
+    {
+        LOG_ERROR("Pipeline #{} could not derive a root signature from shader permutation {:#x}", m_pipelineId, key);
+        pLayout->pRootSignature.Reset();
+        return pLayout;
+    }
+
+    // meshes are uploaded with the streams the fallback reads, and again with more when a permutation reads those
+    if (m_pGeometryManager != nullptr) m_pGeometryManager->AddVertexStreams(pLayout->vertexStreams);
+
+    for (size_t i = 0; i < pLayout->rootParameters.size(); ++i)
+    {
+        const std::string& name = pLayout->rootParameters[i].name;
+        if (name == "SceneConstants")       pLayout->sceneConstants = static_cast<int>(i);
+        else if (name == "MeshConstants")   pLayout->meshConstants = static_cast<int>(i);
+        else LOG_WARNING("Pipeline #{} has nothing to bind to {} in shader permutation {:#x}", m_pipelineId, name, key);
+    }
+
+    SetDebugName(pLayout->pRootSignature.Get(), fmt::format("Pipeline #{} root signature {:#x}", m_pipelineId, key));
+    return pLayout;
+}
+
+// as root constants copied from the CPU's data, or as a root CBV, whichever the layout made of the constant buffer
+void PipelineState::SetRootConstantBuffer(int rootParameter, D3D12_GPU_VIRTUAL_ADDRESS address, const void* pData,
+                                          uint size)
+{
+    if (rootParameter < 0) return;
+
+    const ShaderRootParameter& parameter = m_pLayout->rootParameters[rootParameter];
+    if (parameter.type == D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS)
+    {
+        const uint num32BitValues = std::min<uint>(parameter.num32BitValues, size / sizeof(uint32));
+        m_pCommandList->SetGraphicsRoot32BitConstants(rootParameter, num32BitValues, pData, 0);
+    }
+    else
+    {
+        m_pCommandList->SetGraphicsRootConstantBufferView(rootParameter, address);
+    }
+}
+
 void PipelineState::DrawAllGeometry()
 {
-    const auto begin = m_pGeometryManager->GetDrawables()->begin();
-    const auto end = m_pGeometryManager->GetDrawables()->end();
+    // the culled and sorted order, which already leaves out drawables which should not be drawn
+    const std::vector<Drawable>& drawables = *m_pGeometryManager->GetDrawables();
 
-    for (auto itr = begin; itr != end; ++itr)
+    for (uint index : *m_pGeometryManager->GetDrawOrder())
     {
-        if (!itr->shouldDraw) continue;
+        const Drawable& drawable = drawables[index];
 
-        switch (itr->drawableType)
+        switch (drawable.drawableType)
         {
         case StaticMeshDrawable:
         {
-            DrawStaticMesh(*itr);
+            DrawStaticMesh(drawable);
             break;
         }
         case UnknownDrawable:
@@ -252,17 +369,27 @@ void PipelineState::DrawAllGeometry()
 
 void PipelineState::DrawStaticMesh(const Drawable& drawable)
 {
-    MeshBufferViews meshViews = m_pGeometryManager->GetMeshBufferView(drawable.meshID);
+    const MeshBufferViews& meshViews = m_pGeometryManager->GetMeshBufferView(drawable.meshID);
 
+    // only the streams the shaders read are bound, each to the slot numbered as the stream
     m_pCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    m_pCommandList->IASetVertexBuffers(0, 1, &meshViews.vertexBufferView);
-    m_pCommandList->IASetVertexBuffers(1, 1, &meshViews.colorBufferView);
+    for (uint stream = 0; stream < VertexStreamCount; ++stream)
+    {
+        if (m_pLayout->vertexStreams & (1u << stream))
+        {
+            m_pCommandList->IASetVertexBuffers(stream, 1, &meshViews.streamViews[stream]);
+        }
+    }
     m_pCommandList->IASetIndexBuffer(&meshViews.indexBufferView);
-    m_pCommandList->SetGraphicsRootConstantBufferView(0, m_pConstantBuffer->GetGPUVirtualAddress());
-    m_pCommandList->SetGraphicsRootConstantBufferView(1, m_pGeometryManager->GetConstantBufferOffset(drawable.meshID));
+    SetRootConstantBuffer(m_pLayout->meshConstants, m_pGeometryManager->GetConstantBufferOffset(drawable.meshID),
+                          &m_pGeometryManager->GetMeshConstants(drawable.meshID), sizeof(XMFLOAT4X4));
 
     const uint numTriangles = m_pGeometryManager->GetMesh(drawable.meshID)->GetNumFaces()*3;
     m_pCommandList->DrawIndexedInstanced(numTriangles, 1, 0, 0, 0);
+
+    FrameStats& frameStats = RenderEngine::pCurrentEngine->GetFrameStats();
+    frameStats.Add(FrameStatDrawCalls, 1);
+    frameStats.Add(FrameStatTriangles, numTriangles / 3);
 }
 
 // immediately update constant buffer data and retain pointer to CPU memory
@@ -278,4 +405,5 @@ void PipelineState::UpdateConstantBufferData()
 {
     assert(m_pConstantBufferData != nullptr);
     memcpy(m_pConstandBufferDataDataBegin, m_pConstantBufferData, m_constantBufferDataSize);
+    RenderEngine::pCurrentEngine->GetFrameStats().Add(FrameStatUploadBytes, m_constantBufferDataSize);
 }
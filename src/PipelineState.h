@@ -1,8 +1,12 @@
 #pragma once
 
-#include "Dx12RenderEngine.h"
+#include <string_view>
+#include <unordered_map>
+
+#include "RenderEngine.h"
 #include "GeometryManager.h"
-#include "Shader.h"
+#include "ShaderPermutations.h"
+#include "ShaderReflection.h"
 
 
 struct CbvData
@@ -18,6 +22,9 @@ struct PipelineCreateInfo
 
     uint UploadBufferSize;
     uint GeometryBufferSize;
+
+    uint RenderTargetWidth;     // 800 if left as 0
+    uint RenderTargetHeight;    // 800 if left as 0
 };
 
 
@@ -31,8 +38,8 @@ public:
 
     // common usage
     void Init(PipelineCreateInfo createInfo);
-    void Render();
-    void Execute() {Dx12RenderEngine::pCurrentEngine->ExecuteCommandList(m_pCommandList.Get());}
+    void Render();                  // with the requested shader permutation once compiled, and the fallback until then
+    void Execute() {RenderEngine::pCurrentEngine->ExecuteCommandList(m_pCommandList.Get());}
 
     // geometry and draws
     void RegisterGeometryManager(GeometryManager* pGeometryManager) {m_pGeometryManager = pGeometryManager;}
@@ -44,7 +51,7 @@ public:
 
     // getters/setters
     ComPtr<ID3D12PipelineState> GetPipelineState()  {return m_pPipelineState;}
-    ComPtr<ID3D12RootSignature> GetRootSignature()  {return m_pRootSignature;}
+    ComPtr<ID3D12RootSignature> GetRootSignature()  {return m_pLayout->pRootSignature;}
     ComPtr<ID3D12Resource> GetRenderTarget()        {return m_pRenderTarget;}
     ComPtr<ID3D12Resource> GetDepthStencil()        {return m_pDepthStencil;}
     ComPtr<ID3D12DescriptorHeap> GetRtvHeap()       {return m_pRtvHeap;}
@@ -52,11 +59,47 @@ public:
     void SetViewport(CD3DX12_VIEWPORT viewport)     {m_viewport = viewport;}
     void SetReverseDepth(bool reverse)              {m_reverseDepth = reverse;}
 
+    // shader permutations, whose keywords are declared by Init()
+    void SetShaderPermutation(ShaderPermutationKey key) {m_permutation = key;}
+    ShaderPermutationKey GetShaderPermutation() const   {return m_permutation;}
+    void SetShaderKeyword(std::string_view keyword, bool enabled);
+    bool IsUsingFallbackShaders() const             {return m_usingFallback;}   // while the permutation compiles
+
+    // The vertex streams the fallback's shaders read, which a geometry manager need upload no more than at first. A
+    //  permutation reading others adds them to the registered geometry manager's, which uploads its meshes again.
+    uint GetVertexStreams() const                   {return m_vertexStreams;}
+
     // state queries
     const bool isInitialized() const {m_initialized;}
     const bool isCompiled() const {m_compiled;}
 
 protected:
+    // what a permutation's shaders bind and read, derived from their reflection
+    struct ProgramLayout
+    {
+        ComPtr<ID3D12RootSignature>             pRootSignature;     // null if it could not be derived
+        std::vector<ShaderRootParameter>        rootParameters;
+        std::vector<D3D12_INPUT_ELEMENT_DESC>   inputLayout;
+        uint                                    vertexStreams;      // read, as a mask of VertexStream bits
+        int                                     sceneConstants;     // root parameter indices, or -1 if unused
+        int                                     meshConstants;
+        uint                                    revision;           // of the shaders it was derived from
+    };
+
+    // a pipeline built on first use
+    struct PipelineVariant
+    {
+        ComPtr<ID3D12PipelineState>     pPipelineState;     // null if it failed to build
+        std::shared_ptr<ProgramLayout>  pLayout;            // it was built with
+        uint                            revision;           // of the shaders it was built from
+    };
+
+    ID3D12PipelineState* SelectPipelineState();
+    const PipelineVariant* GetVariantPipeline(ShaderPermutationKey key, const ShaderPermutations::Variant& variant);
+    std::shared_ptr<ProgramLayout> GetProgramLayout(ShaderPermutationKey key,
+                                                    const ShaderPermutations::Variant& variant);
+    void SetRootConstantBuffer(int rootParameter, D3D12_GPU_VIRTUAL_ADDRESS address, const void* pData, uint size);
+
     // instance metadata
     bool                                m_initialized;
     bool                                m_compiled;
@@ -72,16 +115,25 @@ protected:
     ComPtr<ID3D12GraphicsCommandList6>  m_pCommandList;
 
     // pipeline state
-    ComPtr<ID3D12RootSignature>         m_pRootSignature;
     ComPtr<ID3D12DescriptorHeap>        m_pRtvHeap;
     ComPtr<ID3D12DescriptorHeap>        m_pSrvHeap;
     ComPtr<ID3D12DescriptorHeap>        m_pDsvHeap;
-    D3D12_GRAPHICS_PIPELINE_STATE_DESC  psoDesc;
-    ComPtr<ID3D12PipelineState>         m_pPipelineState;
-    ComPtr<ID3D12PipelineState>         m_pPipelineStateReverseDepth;
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC  psoDesc;                            // without shaders or depth test
+    ComPtr<ID3D12PipelineState>         m_pPipelineState;                   // used by the latest frame
+    std::shared_ptr<ProgramLayout>      m_pLayout;                          // of the latest frame's pipeline
+    std::unordered_map<uint64, PipelineVariant>     m_pipelineStates;       // by permutation and depth test
+    std::unordered_map<ShaderPermutationKey, std::shared_ptr<ProgramLayout>>    m_layouts;
+    std::vector<ComPtr<ID3D12DeviceChild>>          m_retiredObjects;       // replaced by a shader reload, and
+                                                                            //  kept until their last frame ends
     CD3DX12_VIEWPORT                    m_viewport;
     CD3DX12_RECT                        m_scissorRect;
 
+    // shaders
+    ShaderPermutations                  m_shaders;
+    ShaderPermutationKey                m_permutation;                      // requested
+    bool                                m_usingFallback;
+    uint                                m_vertexStreams;                    // read by the fallback
+
     // constant buffer
     ComPtr<ID3D12Resource>              m_pConstantBuffer;
     void*                               m_pConstantBufferData;
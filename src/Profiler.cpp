@@ -0,0 +1,413 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <string_view>
+#include <unordered_map>
+
+#include <imgui.h>
+
+#include "MemoryTracker.h"
+
+using namespace std;
+
+
+namespace
+{
+    const chrono::steady_clock::time_point ProfilerEpoch = chrono::steady_clock::now();
+
+    thread_local ProfileThreadBuffer* t_pThreadBuffer = nullptr;
+
+    // JSON strings, with zone names being identifiers and function names in practice
+    void WriteJsonString(ofstream& file, const char* pString)
+    {
+        file << '"';
+        for (const char* p = pString; *p; ++p)
+        {
+            if      (*p == '"' || *p == '\\')   file << '\\' << *p;
+            else if (UINT8(*p) < 0x20)          file << ' ';
+            else                                file << *p;
+        }
+        file << '"';
+    }
+
+    // zones take a stable colour from their name, since the same literal may have several addresses
+    ImU32 ZoneColor(const char* pName)
+    {
+        const size_t hash = std::hash<string_view>()(pName);
+        return ImColor::HSV((hash % 360) / 360.0f, 0.45f, 0.75f);
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                  Thread Buffers
+//**********************************************************************************************************************
+ProfileThreadBuffer::ProfileThreadBuffer(uint threadIndex) :
+    m_threadIndex(threadIndex),
+    m_name(fmt::format("Thread {}", threadIndex)),
+    m_depth(0),
+    m_readIndex(0),
+    m_pEvents(new ProfileEvent[Capacity]),
+    m_writeIndex(0)
+{
+}
+
+uint64 ProfileThreadBuffer::Collect(uint64 readIndex, vector<ProfileEvent>& events, uint64& dropped) const
+{
+    const uint64 writeIndex = m_writeIndex.load(memory_order_acquire);
+    const uint64 oldest = (writeIndex > Capacity) ? writeIndex - Capacity : 0;
+    if (readIndex < oldest)
+    {
+        dropped += oldest - readIndex;
+        readIndex = oldest;
+    }
+
+    const size_t first = events.size();
+    for (uint64 i = readIndex; i < writeIndex; ++i)
+    {
+        events.push_back(m_pEvents[i & (Capacity - 1)]);
+    }
+
+    // anything the owner may have overwritten while it was being copied is discarded
+    const uint64 overwritten = m_writeIndex.load(memory_order_acquire);
+    const uint64 valid = (overwritten > Capacity) ? overwritten - Capacity : 0;
+    if (valid > readIndex)
+    {
+        const size_t lost = static_cast<size_t>(min(valid, writeIndex) - readIndex);
+        events.erase(events.begin() + first, events.begin() + first + lost);
+        dropped += lost;
+    }
+    return writeIndex;
+}
+
+
+//**********************************************************************************************************************
+//                                                      Profiler
+//**********************************************************************************************************************
+Profiler::Profiler() :
+    m_historySize(240),
+    m_frameStart(0),
+    m_droppedEvents(0),
+    m_paused(false),
+    m_selectedFrame(-1),
+    m_zoom(1.0f)
+{
+}
+
+Profiler& Profiler::Get()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+uint64 Profiler::Now()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - ProfilerEpoch).count();
+}
+
+void Profiler::SetThreadName(const char* pName)
+{
+    ProfileThreadBuffer& buffer = GetThreadBuffer();
+    lock_guard<mutex> lock(Get().m_threadMutex);
+    buffer.m_name = pName;
+}
+
+ProfileThreadBuffer& Profiler::GetThreadBuffer()
+{
+    if (t_pThreadBuffer == nullptr) t_pThreadBuffer = &Get().RegisterThread();
+    return *t_pThreadBuffer;
+}
+
+ProfileThreadBuffer& Profiler::RegisterThread()
+{
+    MEMORY_SCOPE(MemoryTagProfiler);
+    lock_guard<mutex> lock(m_threadMutex);
+    m_threads.push_back(make_unique<ProfileThreadBuffer>(static_cast<uint>(m_threads.size())));
+    return *m_threads.back();
+}
+
+void Profiler::EndFrame()
+{
+    MEMORY_SCOPE(MemoryTagProfiler);
+    ProfileFrame frame;
+    frame.start = m_frameStart;
+    frame.end = Now();
+    frame.criticalPath = move(m_criticalPath);
+    m_criticalPath.clear();
+    m_frameStart = frame.end;
+
+    // buffers are drained even while paused, so that resuming does not report a backlog of stale zones
+    {
+        lock_guard<mutex> lock(m_threadMutex);
+        for (unique_ptr<ProfileThreadBuffer>& pBuffer : m_threads)
+        {
+            pBuffer->m_readIndex = pBuffer->Collect(pBuffer->m_readIndex, frame.events, m_droppedEvents);
+        }
+    }
+    if (m_paused) return;
+
+    lock_guard<mutex> lock(m_historyMutex);
+    m_history.push_back(move(frame));
+    while (m_history.size() > m_historySize) m_history.pop_front();
+}
+
+void Profiler::SetHistorySize(uint frameCount)
+{
+    lock_guard<mutex> lock(m_historyMutex);
+    m_historySize = max(frameCount, 1u);
+    while (m_history.size() > m_historySize) m_history.pop_front();
+}
+
+bool Profiler::ExportChromeTrace(const string& filename)
+{
+    MEMORY_SCOPE(MemoryTagProfiler);
+    ofstream file(filename);
+    if (!file)
+    {
+        PrintMessage(Error, "Unable to open trace file \"{}\"", filename);
+        return false;
+    }
+
+    // timestamps are in microseconds, keeping the nanoseconds as fractions
+    file << fixed << setprecision(3);
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Shade\"}}";
+    {
+        lock_guard<mutex> lock(m_threadMutex);
+        for (size_t i = 0; i < m_threads.size(); ++i)
+        {
+            file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i
+                 << ",\"args\":{\"name\":";
+            WriteJsonString(file, m_threads[i]->m_name.c_str());
+            file << "}}";
+        }
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << m_threads.size()
+             << ",\"args\":{\"name\":\"Critical Path\"}}";
+    }
+    const size_t criticalPathThread = m_threads.size();
+
+    lock_guard<mutex> lock(m_historyMutex);
+    uint64 eventCount = 0;
+    for (const ProfileFrame& frame : m_history)
+    {
+        file << ",\n{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":" << frame.end / 1000.0 << "}";
+        for (const ProfileEvent& event : frame.events)
+        {
+            file << ",\n{\"name\":";
+            WriteJsonString(file, event.pName);
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.threadIndex << ",\"ts\":" << event.start / 1000.0
+                 << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+        }
+        for (const ProfileEvent& event : frame.criticalPath)
+        {
+            file << ",\n{\"name\":";
+            WriteJsonString(file, event.pName);
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << criticalPathThread << ",\"ts\":" << event.start / 1000.0
+                 << ",\"dur\":" << (event.end - event.start) / 1000.0 << "}";
+        }
+        eventCount += frame.events.size();
+    }
+    file << "\n]}\n";
+
+    if (!file.good())
+    {
+        PrintMessage(Error, "Failed to write trace file \"{}\"", filename);
+        return false;
+    }
+    PrintMessage(Info, "Wrote {} zones across {} frames to \"{}\"", eventCount, m_history.size(), filename);
+    return true;
+}
+
+
+//**********************************************************************************************************************
+//                                                      Flame View
+//**********************************************************************************************************************
+void Profiler::DrawFlameView()
+{
+    MEMORY_SCOPE(MemoryTagProfiler);
+    ImGui::Checkbox("Pause", &m_paused);
+    ImGui::SameLine();
+    if (ImGui::Button("Latest"))
+    {
+        m_selectedFrame = -1;
+        m_paused = false;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Export Trace")) ExportChromeTrace("shade_trace.json");
+    if (m_droppedEvents > 0)
+    {
+        ImGui::SameLine();
+        ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "%llu zones dropped", (unsigned long long)m_droppedEvents);
+    }
+
+    lock_guard<mutex> lock(m_historyMutex);
+    if (m_history.empty())
+    {
+        ImGui::TextUnformatted("No frames collected yet");
+        return;
+    }
+
+    // frame time history, where picking a frame pauses collection so that it stays put
+    vector<float> frameTimes;
+    frameTimes.reserve(m_history.size());
+    for (const ProfileFrame& frame : m_history) frameTimes.push_back((frame.end - frame.start) / 1e6f);
+    ImGui::PlotHistogram("##FrameTimes", frameTimes.data(), static_cast<int>(frameTimes.size()), 0, "frame ms", 0.0f,
+                         FLT_MAX, ImVec2(-1.0f, 60.0f));
+    if (ImGui::IsItemClicked())
+    {
+        const float x = (ImGui::GetMousePos().x - ImGui::GetItemRectMin().x) / ImGui::GetItemRectSize().x;
+        m_selectedFrame = clamp(static_cast<int>(x * frameTimes.size()), 0, static_cast<int>(frameTimes.size()) - 1);
+        m_paused = true;
+    }
+
+    int frameIndex = (m_selectedFrame < 0) ? static_cast<int>(m_history.size()) - 1
+                                           : min(m_selectedFrame, static_cast<int>(m_history.size()) - 1);
+    if (ImGui::SliderInt("Frame", &frameIndex, 0, static_cast<int>(m_history.size()) - 1))
+    {
+        m_selectedFrame = frameIndex;
+        m_paused = true;
+    }
+    ImGui::SliderFloat("Zoom", &m_zoom, 1.0f, 64.0f, "%.1fx", ImGuiSliderFlags_Logarithmic);
+
+    const ProfileFrame& frame = m_history[frameIndex];
+    const double frameDuration = static_cast<double>(max<uint64>(frame.end - frame.start, 1));
+    ImGui::Text("%.3f ms, %zu zones", frameDuration / 1e6, frame.events.size());
+
+    // the chain of frame graph tasks which bounded the frame, the only tasks whose speed-up shortens it
+    if (!frame.criticalPath.empty())
+    {
+        string path;
+        uint64 pathTime = 0;
+        for (const ProfileEvent& event : frame.criticalPath)
+        {
+            if (!path.empty()) path += " > ";
+            path += event.pName;
+            pathTime += event.end - event.start;
+        }
+        ImGui::TextWrapped("Critical path, %.3f ms in tasks: %s", pathTime / 1e6, path.c_str());
+    }
+
+    // lay out one lane per thread, each as deep as its deepest zone
+    uint threadCount = 0;
+    for (const ProfileEvent& event : frame.events) threadCount = max(threadCount, event.threadIndex + 1);
+    vector<uint> laneDepths(threadCount, 0);
+    for (const ProfileEvent& event : frame.events)
+    {
+        laneDepths[event.threadIndex] = max(laneDepths[event.threadIndex], event.depth + 1);
+    }
+    vector<string> threadNames(threadCount);
+    {
+        lock_guard<mutex> threadLock(m_threadMutex);
+        for (uint i = 0; i < threadCount; ++i) threadNames[i] = m_threads[i]->m_name;
+    }
+
+    const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+    const float criticalLaneHeight = frame.criticalPath.empty() ? 0.0f : 2.0f * rowHeight;
+    float flameHeight = criticalLaneHeight;
+    for (uint depth : laneDepths) flameHeight += (depth > 0) ? (depth + 1) * rowHeight : 0.0f;
+
+    ImGui::BeginChild("##Flame", ImVec2(0.0f, min(flameHeight + 2.0f * rowHeight, 400.0f)), true,
+                      ImGuiWindowFlags_HorizontalScrollbar);
+    {
+        const float width = ImGui::GetContentRegionAvail().x * m_zoom;
+        const ImVec2 origin = ImGui::GetCursorScreenPos();
+        ImDrawList* pDrawList = ImGui::GetWindowDrawList();
+
+        // zones are positioned the same way in every lane, the critical path's included
+        const auto drawZone = [&](const ProfileEvent& event, float y0, ImU32 outline)
+        {
+            // zones from other threads may straddle the frame boundary, so are clipped to it
+            const uint64 start = clamp(event.start, frame.start, frame.end);
+            const uint64 end = clamp(event.end, frame.start, frame.end);
+            const float x0 = origin.x + static_cast<float>((start - frame.start) / frameDuration) * width;
+            const float x1 = max(origin.x + static_cast<float>((end - frame.start) / frameDuration) * width, x0 + 1.0f);
+            const ImVec2 rectMin(x0, y0);
+            const ImVec2 rectMax(x1, y0 + rowHeight - 1.0f);
+
+            pDrawList->AddRectFilled(rectMin, rectMax, ZoneColor(event.pName));
+            if (outline != 0) pDrawList->AddRect(rectMin, rectMax, outline, 0.0f, 0, 2.0f);
+            if (x1 - x0 > 8.0f)
+            {
+                pDrawList->PushClipRect(rectMin, rectMax, true);
+                pDrawList->AddText(ImVec2(x0 + 2.0f, y0), IM_COL32_BLACK, event.pName);
+                pDrawList->PopClipRect();
+            }
+            if (ImGui::IsMouseHoveringRect(rectMin, rectMax))
+            {
+                ImGui::SetTooltip("%s\n%.3f ms", event.pName, (event.end - event.start) / 1e6);
+            }
+        };
+
+        float laneTop = origin.y;
+        if (!frame.criticalPath.empty())
+        {
+            pDrawList->AddText(ImVec2(ImGui::GetWindowPos().x + ImGui::GetStyle().WindowPadding.x, laneTop),
+                               ImGui::GetColorU32(ImGuiCol_TextDisabled), "Critical Path");
+            for (const ProfileEvent& event : frame.criticalPath)
+            {
+                drawZone(event, laneTop + rowHeight, IM_COL32(255, 64, 64, 255));
+            }
+            laneTop += criticalLaneHeight;
+        }
+
+        vector<float> laneTops(threadCount, 0.0f);
+        for (uint i = 0; i < threadCount; ++i)
+        {
+            if (laneDepths[i] == 0) continue;
+            pDrawList->AddText(ImVec2(ImGui::GetWindowPos().x + ImGui::GetStyle().WindowPadding.x, laneTop),
+                               ImGui::GetColorU32(ImGuiCol_TextDisabled), threadNames[i].c_str());
+            laneTops[i] = laneTop + rowHeight;
+            laneTop += (laneDepths[i] + 1) * rowHeight;
+        }
+
+        for (const ProfileEvent& event : frame.events)
+        {
+            drawZone(event, laneTops[event.threadIndex] + event.depth * rowHeight, 0);
+        }
+        ImGui::Dummy(ImVec2(width, flameHeight));
+    }
+    ImGui::EndChild();
+
+    // inclusive time per zone name, heaviest first
+    struct ZoneSummary
+    {
+        uint    calls;
+        uint64  total;
+        uint64  longest;
+    };
+    unordered_map<string_view, ZoneSummary> summaries;
+    for (const ProfileEvent& event : frame.events)
+    {
+        ZoneSummary& summary = summaries[event.pName];
+        summary.calls++;
+        summary.total += event.end - event.start;
+        summary.longest = max(summary.longest, event.end - event.start);
+    }
+    vector<pair<string_view, ZoneSummary>> sorted(summaries.begin(), summaries.end());
+    sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {return a.second.total > b.second.total;});
+
+    const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY;
+    if (ImGui::BeginTable("Zones", 4, flags, ImVec2(0.0f, 200.0f)))
+    {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Zone");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Total ms");
+        ImGui::TableSetupColumn("Longest ms");
+        ImGui::TableHeadersRow();
+        for (const auto& [name, summary] : sorted)
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(name.data(), name.data() + name.size());
+            ImGui::TableNextColumn();
+            ImGui::Text("%u", summary.calls);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", summary.total / 1e6);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", summary.longest / 1e6);
+        }
+        ImGui::EndTable();
+    }
+}
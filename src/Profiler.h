@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "Util.h"
+
+
+//**********************************************************************************************************************
+//                                                  Instrumentation
+//**********************************************************************************************************************
+// Zones are named with string literals (or __FUNCTION__), which are stored by pointer and must outlive the profiler.
+//  Building without SHADE_PROFILE removes every zone at compile time, leaving nothing behind in the instrumented code.
+#if defined(SHADE_PROFILE)
+#define PROFILE_CONCAT_INNER(a, b)  a##b
+#define PROFILE_CONCAT(a, b)        PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name)         ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION()          PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_THREAD(name)        Profiler::SetThreadName(name)
+#define PROFILE_FRAME()             Profiler::Get().EndFrame()
+#else
+#define PROFILE_SCOPE(name)         ((void)0)
+#define PROFILE_FUNCTION()          ((void)0)
+#define PROFILE_THREAD(name)        ((void)0)
+#define PROFILE_FRAME()             ((void)0)
+#endif
+
+
+// a completed zone, in nanoseconds since the profiler started
+struct ProfileEvent
+{
+    const char*     pName;
+    uint64          start;
+    uint64          end;
+    uint            depth;          // nesting level within the thread, zero being outermost
+    uint            threadIndex;
+};
+
+// every zone which completed between two EndFrame() calls, across all threads
+struct ProfileFrame
+{
+    uint64                      start;
+    uint64                      end;
+    std::vector<ProfileEvent>   events;
+    std::vector<ProfileEvent>   criticalPath;   // the frame graph's tasks which bounded the frame, first to last
+};
+
+
+// Single producer ring of completed zones, written only by the thread which owns it. The write index is published with
+//  release semantics so that any other thread can collect without taking a lock. Should the owner lap a reader, the
+//  overwritten zones are detected after the copy and dropped rather than reported torn.
+class ProfileThreadBuffer
+{
+public:
+    static constexpr uint Capacity = 1 << 16;
+
+    ProfileThreadBuffer(uint threadIndex);
+
+    void Push(const char* pName, uint64 start, uint64 end, uint depth)
+    {
+        const uint64 index = m_writeIndex.load(std::memory_order_relaxed);
+        m_pEvents[index & (Capacity - 1)] = {pName, start, end, depth, m_threadIndex};
+        m_writeIndex.store(index + 1, std::memory_order_release);
+    }
+
+    // appends zones written since readIndex, returning the index to resume from and counting any which were lost
+    uint64 Collect(uint64 readIndex, std::vector<ProfileEvent>& events, uint64& dropped) const;
+
+    uint                m_threadIndex;
+    std::string         m_name;
+    uint                m_depth;        // owner only
+    uint64              m_readIndex;    // collector only
+
+private:
+    std::unique_ptr<ProfileEvent[]>     m_pEvents;
+    std::atomic<uint64>                 m_writeIndex;
+};
+
+
+// Gathers the zones of every thread into frames. Threads register their buffer on their first zone, which is the only
+//  time the profiler takes a lock on their behalf. Frames are collected on the thread calling EndFrame(), and a bounded
+//  history of them is kept for the flame view and for trace export.
+class Profiler
+{
+public:
+    static Profiler& Get();
+
+    static uint64 Now();
+    static void SetThreadName(const char* pName);
+    static ProfileThreadBuffer& GetThreadBuffer();
+
+    // closes the current frame, collecting every thread's zones into the history
+    void EndFrame();
+
+    // attaches the critical path of the frame's task graph to the current frame, from the thread calling EndFrame()
+    void SetCriticalPath(std::vector<ProfileEvent> criticalPath)   {m_criticalPath = std::move(criticalPath);}
+
+    // writes the history as Chrome trace event JSON, which Perfetto and chrome://tracing both load
+    bool ExportChromeTrace(const std::string& filename);
+
+    // draws the flame view and zone summary of a frame from the history into the current ImGui window
+    void DrawFlameView();
+
+    void SetHistorySize(uint frameCount);
+    uint64 GetDroppedEventCount() const     {return m_droppedEvents;}
+
+private:
+    Profiler();
+
+    ProfileThreadBuffer& RegisterThread();
+
+    // registered threads, whose buffers live as long as the profiler
+    std::mutex                                          m_threadMutex;
+    std::vector<std::unique_ptr<ProfileThreadBuffer>>   m_threads;
+
+    // collected frames, guarded so that export may run alongside collection
+    std::mutex                                          m_historyMutex;
+    std::deque<ProfileFrame>                            m_history;
+    uint                                                m_historySize;
+    uint64                                              m_frameStart;
+    std::vector<ProfileEvent>                           m_criticalPath;     // for the frame in progress
+    uint64                                              m_droppedEvents;
+
+    // flame view state
+    bool                                                m_paused;
+    int                                                 m_selectedFrame;    // negative selects the most recent
+    float                                               m_zoom;
+};
+
+
+// Times the enclosing scope and records it to the calling thread's buffer on exit.
+class ProfileZone
+{
+public:
+    ProfileZone(const char* pName) :
+        m_pName(pName),
+        m_buffer(Profiler::GetThreadBuffer()),
+        m_start(Profiler::Now())
+    {
+        m_buffer.m_depth++;
+    }
+    ~ProfileZone()
+    {
+        m_buffer.m_depth--;
+        m_buffer.Push(m_pName, m_start, Profiler::Now(), m_buffer.m_depth);
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char*             m_pName;
+    ProfileThreadBuffer&    m_buffer;
+    uint64                  m_start;
+};
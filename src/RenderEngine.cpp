@@ -3,15 +3,26 @@
 using namespace Microsoft::WRL;
 
 
+RenderEngine* RenderEngine::pCurrentEngine = nullptr;
+
+
 RenderEngine::RenderEngine(UINT width, UINT height, std::wstring name) :
     m_width(width),
     m_height(height),
     m_name(name),
-    m_useWarpDevice(false)
+    m_useWarpDevice(false),
+    m_window(nullptr),
+    m_pScene(nullptr),
+    m_stats({})
 {
     m_aspectRatio = static_cast<float>(width) / static_cast<float>(height);
+    pCurrentEngine = this;
 }
 
 RenderEngine::~RenderEngine()
 {
+    if (pCurrentEngine == this)
+    {
+        pCurrentEngine = nullptr;
+    }
 }
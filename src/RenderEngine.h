@@ -4,8 +4,41 @@
 #include "Shade.h"
 
 #include "Util.h"
+#include "FrameStats.h"
+#include "TaskGraph.h"
 
+class Scene;
 
+
+// Statistics gathered by a backend about the API traffic it has been asked to perform. Backends which talk to a real
+//  device can leave most of this alone, but headless backends use it to report what a frame would have cost.
+struct RenderEngineStats
+{
+    uint64 commandListsCreated;
+    uint64 commandListsExecuted;
+    uint64 pipelineStatesCreated;
+    uint64 rootSignaturesCreated;
+    uint64 descriptorHeapsCreated;
+    uint64 resourcesCreated;
+    uint64 resourceBytes[D3D12_HEAP_TYPE_CUSTOM + 1];  // indexed by D3D12_HEAP_TYPE
+    uint64 drawCalls;
+    uint64 indicesDrawn;
+    uint64 validationErrors;
+};
+
+
+// Shader bytecode consumed by a backend. DXC produces either from the same HLSL.
+enum ShaderFormat
+{
+    ShaderFormatDxil,
+    ShaderFormatSpirv,
+};
+
+
+// Interface shared by all rendering backends. Scenes and their components only ever talk to the engine through this
+//  interface via RenderEngine::pCurrentEngine, so that a scene may be driven by the D3D12 backend, or by a headless
+//  one on machines without a GPU or window. The API surface is still described with D3D12 structures, since those are
+//  what the rest of the code base is written against.
 class RenderEngine
 {
 public:
@@ -13,7 +46,7 @@ public:
     virtual ~RenderEngine();
 
     // primary interfaces for render loop
-    virtual void Init(const HWND window) = 0;
+    virtual void Init(const WindowHandle window) = 0;
     virtual void OnUpdate() = 0;
     virtual void PreRender() = 0;
     virtual void OnRender() = 0;
@@ -26,9 +59,46 @@ public:
     virtual void OnKeyDown(UINT8 key)   {}
     virtual void OnKeyUp(UINT8 key)     {}
 
-    uint GetWidth() const               {return m_width;}
-    uint GetHeight() const              {return m_height;}
-    const std::wstring GetName() const  {return m_name;}
+    // API access provided to clients
+    virtual HRESULT CreateCommandAllocator(ID3D12CommandAllocator**             ppCommandAllocator) = 0;
+    virtual HRESULT CreateCommandList(ID3D12GraphicsCommandList6**              ppCommandList) = 0;
+    virtual HRESULT CreateRootSignature(CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC*  pDesc,
+                                        ID3D12RootSignature**                   ppRootSignature) = 0;
+    virtual HRESULT CreatePipelineState(D3D12_GRAPHICS_PIPELINE_STATE_DESC*     pDesc,
+                                        ID3D12PipelineState**                   ppPipelineState) = 0;
+    virtual HRESULT CreatePipelineState(D3D12_PIPELINE_STATE_STREAM_DESC*       pStreamDesc,
+                                        ID3D12PipelineState**                   ppPipelineState) = 0;
+    virtual HRESULT CreateResource(const D3D12_HEAP_PROPERTIES*                 pHeapProperties,
+                                   const D3D12_RESOURCE_DESC*                   pDesc,
+                                   D3D12_RESOURCE_STATES                        initialState,
+                                   const D3D12_CLEAR_VALUE*                     pClearValue,
+                                   ID3D12Resource**                             ppResource) = 0;
+    virtual HRESULT CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC*      pDesc,
+                                         ID3D12DescriptorHeap**                 ppDescriptorHeap) = 0;
+    virtual void CreateRenderTargetView(ID3D12Resource*                         pResource,
+                                        const D3D12_RENDER_TARGET_VIEW_DESC*    pDesc,
+                                        D3D12_CPU_DESCRIPTOR_HANDLE             destDescriptor) = 0;
+    virtual void CreateDepthStencilView(ID3D12Resource*                         pResource,
+                                        const D3D12_DEPTH_STENCIL_VIEW_DESC*    pDesc,
+                                        D3D12_CPU_DESCRIPTOR_HANDLE             destDescriptor) = 0;
+    virtual void ExecuteCommandList(ID3D12GraphicsCommandList6*                 pCommandList) = 0;
+
+    // debug and global UI
+    virtual D3D12_GPU_DESCRIPTOR_HANDLE AddSrvForResource(D3D12_SHADER_RESOURCE_VIEW_DESC desc,
+                                                          ComPtr<ID3D12Resource>          pResource) = 0;
+
+    // getters/setters
+    virtual ShaderFormat GetShaderFormat() const {return ShaderFormatDxil;}
+    uint GetWidth() const                       {return m_width;}
+    uint GetHeight() const                      {return m_height;}
+    const std::wstring GetName() const          {return m_name;}
+    const RenderEngineStats& GetStats() const   {return m_stats;}
+    FrameStats& GetFrameStats()                 {return m_frameStats;}
+    void SetScene(Scene* pScene)                {m_pScene = pScene; m_frameGraph.Clear();}
+
+    // have this be a single static globally-accessible instance
+    // TODO: proper Singleton restrictions?
+    static RenderEngine* pCurrentEngine;
 
 protected:
     uint m_width;
@@ -36,6 +106,12 @@ protected:
     float m_aspectRatio;
     bool m_useWarpDevice;
 
-    HWND m_window;
+    WindowHandle m_window;
     std::wstring m_name;
+
+    // components
+    Scene* m_pScene;
+    RenderEngineStats m_stats;
+    FrameStats m_frameStats;
+    TaskGraph m_frameGraph;             // the engine's and scene's stages, built on the first frame after SetScene()
 };
@@ -1 +1,18 @@
 #include "Scene.h"
+
+#include "RenderEngine.h"
+#include "TaskGraph.h"
+
+
+void Scene::AddTasks(TaskGraph& graph)
+{
+    graph.AddTask("Scene::OnUpdate", [this] {OnUpdate();}).Writes(this).Measures(FrameStatUpdateTime);
+    graph.AddTask("Scene::OnRender", [this] {OnRender();}).Writes(this).Writes(RenderEngine::pCurrentEngine)
+         .Measures(FrameStatRenderTime);
+}
+
+void Scene::AddUiTasks(TaskGraph& graph)
+{
+    graph.AddTask("Scene::BuildUI", [this] {BuildUI();}).Writes(this).Writes(ImGui::GetCurrentContext())
+         .Measures(FrameStatUiTime);
+}
@@ -1,13 +1,29 @@
 #pragma once
 
-#include <d3d12.h>
-#include <dxgi1_6.h>
-
 #include <imgui.h>
 
 #include "Util.h"
 #include "Util3D.h"
 
+class RenderEngine;
+class TaskGraph;
+
+
+// A scene owns the content to be rendered and the pipelines which render it. Engines drive scenes through this
+//  interface, adding the scene's tasks to the frame graph they build once and execute every frame. By default those
+//  call OnUpdate() then OnRender(), and BuildUI() while the engine builds its UI.
 class Scene
 {
+public:
+    virtual ~Scene() {}
+
+    virtual void Init(RenderEngine* pEngine) = 0;
+    virtual void BuildUI() = 0;
+    virtual void OnUpdate() = 0;
+    virtual void OnRender() = 0;
+
+    // Declares the scene's stages and the data they touch. Scenes with stages which can run alongside one another
+    //  declare them separately, the last recording and submitting its work through the engine.
+    virtual void AddTasks(TaskGraph& graph);
+    virtual void AddUiTasks(TaskGraph& graph);  // run between the engine beginning and rendering its UI
 };
@@ -4,7 +4,9 @@
 #include <dwmapi.h>
 
 #include "Dx12RenderEngine.h"
+#include "Profiler.h"
 #include "ShaderToyScene.h"
+#include "ShaderWatcher.h"
 
 
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
@@ -14,6 +16,7 @@ LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lPara
 _Use_decl_annotations_
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
 {
+    PROFILE_THREAD("Main");
     Dx12RenderEngine engine(800, 800);
     ShaderToyScene scene(L"Simple Scene");
 
@@ -47,7 +50,8 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow)
         hInstance,
         &engine);
 
-    // initialize engine and scene
+    // initialize engine and scene, whose shaders reload as they are edited
+    ShaderWatcher::Get().SetEnabled(true);
     engine.SetScene(&scene);
     engine.Init(window);
     scene.Init(&engine);
@@ -142,6 +146,8 @@ LRESULT CALLBACK WindowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lPara
 
         case WM_KEYDOWN:
         {
+            // F5 recompiles every shader, as saving one does
+            if (wParam == VK_F5) ShaderWatcher::Get().ReloadAll();
             //pEngine->OnKeyDown(wParam);
             break;
         }
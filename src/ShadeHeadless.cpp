@@ -0,0 +1,307 @@
+// Headless entry point. Drives a scene with the null, software or Vulkan backend for a fixed number of frames and
+//  reports what was recorded, which lets Shade be exercised on machines with no GPU or display.
+//
+// Given meshes or an output directory, an offscreen scene is rendered instead of the interactive one: the meshes are
+//  drawn from a scripted camera, optionally orbiting for turntables, and each frame can be dumped to PNG or EXR.
+//
+// Profiled zones of the whole run can be exported with --trace, for loading into Perfetto or chrome://tracing, and
+//  per-frame timings and counts with --stats, as CSV for comparing builds. Memory held by each subsystem is reported
+//  once the frames are done. Messages may be copied to a file with --log, and filtered with --log-level.
+//
+// With --max-frame-allocations, the run fails should any frame after the first few make more heap allocations than
+//  allowed. Per-frame temporaries come from the frame arenas, so zero guards against regressions in steady state.
+//
+// Compiled shaders are cached in ./shader_cache, or the directory given with --shader-cache, where "off" compiles every
+//  shader afresh. Scene initialization is timed, which compares cold and warm starts. With --shader-reload on, shaders
+//  are recompiled as their files are edited, as in the windowed build.
+//
+// Shader permutations besides the fallback compile on first use, and --shader-manifest writes every one the run used
+//  to a precompile manifest. --precompile-shaders compiles such a manifest into the cache before the scene starts, so
+//  with --frames 0 it warms the cache offline for later runs.
+//
+// With --shader-costs on, the static costs of every shader compiled are reported once the frames are done: bytecode
+//  size, instructions by category and estimated register pressure, with changes for those recompiled while reloading.
+#include "Shade.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+#include "backends/NullRenderEngine.h"
+#include "backends/SoftwareRenderEngine.h"
+#if defined(SHADE_VULKAN)
+#include "backends/VulkanRenderEngine.h"
+#endif
+#include "FrameDumper.h"
+#include "MemoryTracker.h"
+#include "OffscreenScene.h"
+#include "Profiler.h"
+#include "ShaderAnalysis.h"
+#include "ShaderCache.h"
+#include "ShaderPermutations.h"
+#include "ShaderToyScene.h"
+#include "ShaderWatcher.h"
+
+
+static bool ParseFloat3(const char* pText, XMFLOAT3& value)
+{
+    return sscanf(pText, "%f,%f,%f", &value.x, &value.y, &value.z) == 3;
+}
+
+static bool ParseImageFormat(const char* pText, ImageFileFormat& format)
+{
+    if      (strcmp(pText, "png") == 0) format = ImageFileFormatPng;
+    else if (strcmp(pText, "exr") == 0) format = ImageFileFormatExr;
+    else                                return false;
+    return true;
+}
+
+static bool ParseSeverity(const char* pText, MessageSeverity& severity)
+{
+    if      (strcmp(pText, "debug") == 0)   severity = Debug;
+    else if (strcmp(pText, "info") == 0)    severity = Info;
+    else if (strcmp(pText, "warning") == 0) severity = Warning;
+    else if (strcmp(pText, "error") == 0)   severity = Error;
+    else                                    return false;
+    return true;
+}
+
+static bool ParseSwitch(const char* pText, bool& value)
+{
+    if      (strcmp(pText, "on") == 0)  value = true;
+    else if (strcmp(pText, "off") == 0) value = false;
+    else                                return false;
+    return true;
+}
+
+static void PrintUsage(const char* pProgram)
+{
+    PrintMessage("usage: {} [--backend null|software|vulkan] [--frames N] [--width W] [--height H] [--threads T]\n"
+                 "       [--mesh FILE]... [--eye X,Y,Z] [--target X,Y,Z] [--turntable DEGREES]\n"
+                 "       [--output DIR] [--format png|exr] [--ring N] [--encoders N] [--trace FILE] [--stats FILE]\n"
+                 "       [--log FILE] [--log-level debug|info|warning|error] [--max-frame-allocations N]\n"
+                 "       [--shader-cache DIR|off] [--shader-reload on|off] [--shader-manifest FILE]\n"
+                 "       [--precompile-shaders FILE] [--shader-costs on|off]\n", pProgram);
+}
+
+int main(int argc, char** argv)
+{
+    uint frameCount = 100;
+    uint width = 800;
+    uint height = 800;
+    uint threadCount = 0;
+    std::string backend = "null";
+
+    // offscreen scene and frame dumps
+    OffscreenSceneDesc offscreenDesc = {};
+    offscreenDesc.eye = {0, 5, -45};
+    offscreenDesc.target = {0, 5, 0};
+    std::string outputDirectory;
+    ImageFileFormat outputFormat = ImageFileFormatPng;
+    uint ringSize = 8;
+    uint encoderCount = 1;
+    std::string traceFilename;
+    std::string statsFilename;
+    std::string logFilename;
+    MessageSeverity logLevel = Logger::GetThreshold();
+    int maxFrameAllocations = -1;       // unchecked unless given
+    std::string shaderCacheDirectory;
+    bool shaderReload = false;
+    std::string shaderManifestFilename;
+    std::string precompileFilename;
+    bool shaderCosts = false;
+
+    // simple flag parsing, each flag takes a single value
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        bool valid = true;
+        if      (strcmp(argv[i], "--frames") == 0)      frameCount = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--width") == 0)       width = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--height") == 0)      height = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--threads") == 0)     threadCount = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--backend") == 0)     backend = argv[i + 1];
+        else if (strcmp(argv[i], "--mesh") == 0)        offscreenDesc.meshes.push_back(argv[i + 1]);
+        else if (strcmp(argv[i], "--eye") == 0)         valid = ParseFloat3(argv[i + 1], offscreenDesc.eye);
+        else if (strcmp(argv[i], "--target") == 0)      valid = ParseFloat3(argv[i + 1], offscreenDesc.target);
+        else if (strcmp(argv[i], "--turntable") == 0)   offscreenDesc.turntableDegrees = static_cast<float>(atof(argv[i + 1]));
+        else if (strcmp(argv[i], "--output") == 0)      outputDirectory = argv[i + 1];
+        else if (strcmp(argv[i], "--format") == 0)      valid = ParseImageFormat(argv[i + 1], outputFormat);
+        else if (strcmp(argv[i], "--ring") == 0)        ringSize = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--encoders") == 0)    encoderCount = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--trace") == 0)       traceFilename = argv[i + 1];
+        else if (strcmp(argv[i], "--stats") == 0)       statsFilename = argv[i + 1];
+        else if (strcmp(argv[i], "--log") == 0)         logFilename = argv[i + 1];
+        else if (strcmp(argv[i], "--log-level") == 0)   valid = ParseSeverity(argv[i + 1], logLevel);
+        else if (strcmp(argv[i], "--max-frame-allocations") == 0) maxFrameAllocations = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "--shader-cache") == 0) shaderCacheDirectory = argv[i + 1];
+        else if (strcmp(argv[i], "--shader-reload") == 0) valid = ParseSwitch(argv[i + 1], shaderReload);
+        else if (strcmp(argv[i], "--shader-manifest") == 0) shaderManifestFilename = argv[i + 1];
+        else if (strcmp(argv[i], "--precompile-shaders") == 0) precompileFilename = argv[i + 1];
+        else if (strcmp(argv[i], "--shader-costs") == 0) valid = ParseSwitch(argv[i + 1], shaderCosts);
+        else
+        {
+            PrintMessage(Error, "Unknown argument \"{}\"", argv[i]);
+            PrintUsage(argv[0]);
+            return 1;
+        }
+
+        if (!valid)
+        {
+            PrintMessage(Error, "Invalid value \"{}\" for {}", argv[i + 1], argv[i]);
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    Logger::SetThreshold(logLevel);
+    if (!logFilename.empty())
+    {
+        std::shared_ptr<LogFileSink> pLogFile = std::make_shared<LogFileSink>(logFilename);
+        if (pLogFile->IsOpen()) Logger::Get().AddSink(pLogFile);
+        else PrintMessage(Warning, "Cannot open log file \"{}\"", logFilename);
+    }
+
+    if      (shaderCacheDirectory == "off")     ShaderCache::Get().SetEnabled(false);
+    else if (!shaderCacheDirectory.empty())     ShaderCache::Get().SetDirectory(shaderCacheDirectory);
+    ShaderWatcher::Get().SetEnabled(shaderReload);
+
+    // keep every frame when tracing, plus one for the zones which complete after the last
+    PROFILE_THREAD("Main");
+    if (!traceFilename.empty())
+    {
+#if !defined(SHADE_PROFILE)
+        PrintMessage(Warning, "Profiling is compiled out of this build, so the trace will be empty");
+#endif
+        Profiler::Get().SetHistorySize(frameCount + 1);
+    }
+
+    std::unique_ptr<NullRenderEngine> pEngine;
+    if      (backend == "null")     pEngine = std::make_unique<NullRenderEngine>(width, height);
+    else if (backend == "software") pEngine = std::make_unique<SoftwareRenderEngine>(width, height, threadCount);
+#if defined(SHADE_VULKAN)
+    else if (backend == "vulkan")   pEngine = std::make_unique<VulkanRenderEngine>(width, height);
+#endif
+    else
+    {
+        PrintMessage(Error, "Unknown backend \"{}\"", backend);
+        return 1;
+    }
+    NullRenderEngine& engine = *pEngine;
+    if (!statsFilename.empty()) engine.GetFrameStats().SetCapacity(frameCount);
+
+    // compiled once the backend is known, as it decides between DXIL and SPIR-V
+    if (!precompileFilename.empty() && !ShaderPermutations::Precompile(precompileFilename)) return 6;
+
+    // the interactive scene, unless asked to render something specific
+    std::unique_ptr<Scene> pScene;
+    OffscreenScene* pOffscreenScene = nullptr;
+    if (offscreenDesc.meshes.empty() && outputDirectory.empty())
+    {
+        pScene = std::make_unique<ShaderToyScene>(L"Simple Scene");
+    }
+    else
+    {
+        if (offscreenDesc.meshes.empty()) offscreenDesc.meshes.push_back("./media/rotated_teapot.ply");
+        offscreenDesc.frameCount = frameCount;
+        offscreenDesc.width = width;
+        offscreenDesc.height = height;
+        pOffscreenScene = new OffscreenScene(offscreenDesc);
+        pScene.reset(pOffscreenScene);
+    }
+    Scene& scene = *pScene;
+
+    // initialize engine and scene, which compiles the scene's shaders or loads them from the cache
+    const auto initStart = std::chrono::steady_clock::now();
+    engine.SetScene(&scene);
+    engine.Init(nullptr);
+    scene.Init(&engine);
+    const double initMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - initStart).count();
+
+    std::unique_ptr<FrameDumper> pDumper;
+    if (!outputDirectory.empty())
+    {
+        pDumper = std::make_unique<FrameDumper>(outputDirectory, outputFormat, ringSize, encoderCount);
+    }
+
+    // the first frames create UI windows and grow the frame arenas, so allocations are only checked after them
+    constexpr uint AllocationWarmupFrames = 10;
+    if (maxFrameAllocations >= 0 && !MemoryTracker::IsCpuTrackingEnabled())
+    {
+        PrintMessage(Warning, "Allocations cannot be checked without CPU memory tracking (SHADE_MEMORY_TRACKING)");
+        maxFrameAllocations = -1;
+    }
+    uint64 worstFrameAllocations = 0;
+    uint framesOverBudget = 0;
+    MemoryTracker::MarkFrameThread();   // job workers mark themselves; the log, watcher and encoders don't
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint frame = 0; frame < frameCount; ++frame)
+    {
+        const uint64 allocationsBefore = MemoryTracker::GetFrameThreadAllocations();
+        engine.OnRender();
+        const uint64 allocations = MemoryTracker::GetFrameThreadAllocations() - allocationsBefore;
+        if (frame >= AllocationWarmupFrames)
+        {
+            worstFrameAllocations = std::max(worstFrameAllocations, allocations);
+            if (maxFrameAllocations >= 0 && allocations > static_cast<uint64>(maxFrameAllocations)) framesOverBudget++;
+        }
+
+        if (pDumper != nullptr) pDumper->Capture(pOffscreenScene->GetRenderTarget().Get(), frame);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    const double totalMs = std::chrono::duration<double, std::milli>(end - start).count();
+    PrintMessage(Info, "{} frames in {:.2f}ms ({:.3f}ms CPU per frame)", frameCount, totalMs, totalMs / std::max(frameCount, 1u));
+    engine.PrintStats();
+    engine.GetFrameStats().PrintSummary();
+    MemoryTracker::Dump();
+
+    const ShaderCache::Stats shaderCacheStats = ShaderCache::Get().GetStats();
+    if (shaderCacheStats.hits + shaderCacheStats.misses > 0)
+    {
+        PrintMessage(Info, "Shader cache:           {} hits, {} misses ({:.2f}ms initializing the scene)",
+                     shaderCacheStats.hits, shaderCacheStats.misses, initMs);
+    }
+    if (!statsFilename.empty()) engine.GetFrameStats().ExportCsv(statsFilename);
+    if (!shaderManifestFilename.empty()) ShaderPermutations::WriteManifest(shaderManifestFilename);
+    if (shaderCosts) ShaderAnalysis::Get().Dump();
+
+    int exitCode = (engine.GetStats().validationErrors == 0) ? 0 : 2;
+
+    if (maxFrameAllocations >= 0)
+    {
+        if (frameCount <= AllocationWarmupFrames)
+        {
+            PrintMessage(Warning, "Allocations are only checked after {} warm-up frames", AllocationWarmupFrames);
+        }
+        PrintMessage(framesOverBudget > 0 ? Error : Info, "Heap allocations:       at most {} per frame, {} frames over {}",
+                     worstFrameAllocations, framesOverBudget, maxFrameAllocations);
+        if (framesOverBudget > 0 && exitCode == 0) exitCode = 5;
+    }
+
+    // the render loop never waited on writes unless stalled, so report how long the encoders took to catch up
+    if (pDumper != nullptr)
+    {
+        pDumper->Finish();
+        const double drainMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - end).count();
+
+        const FrameDumperStats& stats = pDumper->GetStats();
+        PrintMessage(Info, "Frames written:         {} of {} to {} ({:.2f}ms draining after the last frame)",
+                     stats.framesWritten, stats.framesCaptured, outputDirectory, drainMs);
+        PrintMessage(Info, "Encode time:            {:.3f}ms per frame", stats.encodeMilliseconds / std::max<uint64>(stats.framesWritten, 1));
+        PrintMessage(stats.stalls > 0 ? Warning : Info, "Capture stalls:         {} ({:.2f}ms)", stats.stalls, stats.stallMilliseconds);
+        if (stats.writeFailures > 0 || stats.framesCaptured < frameCount) exitCode = 3;
+    }
+
+    // collect whatever completed since the last frame, such as the encoders draining
+    if (!traceFilename.empty())
+    {
+        PROFILE_FRAME();
+        if (!Profiler::Get().ExportChromeTrace(traceFilename) && exitCode == 0) exitCode = 4;
+    }
+
+    // clean up and exit
+    engine.OnDestroy();
+    return exitCode;
+}
@@ -1,15 +1,145 @@
 #include "Shader.h"
 
+#include <cstdlib>
+#include <vector>
 
-Shader::Shader() :
-    m_pBlob(nullptr),
-    m_pErrors(nullptr)
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "RenderEngine.h"
+#include "ShaderAnalysis.h"
+#include "ShaderCache.h"
+
+
+namespace
 {
-    if (m_pCompiler == nullptr)
+    // Versions of the compiler and of the validator which signs DXIL, as either changes the bytecode produced. Queried
+    //  once per process, which is the only time DXC is loaded when every shader is found in the cache.
+    const std::string& CompilerVersion()
     {
-        CheckResult(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&m_pCompiler)), "Shader Compiler Instance");
-        CheckResult(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&m_pUtils)), "DXC Utils Instance");
+        static const std::string version = []
+        {
+            std::string result;
+            const auto describe = [&result](const char* pName, REFCLSID clsid)
+            {
+                ComPtr<IDxcVersionInfo> pInfo;
+                UINT32 major = 0, minor = 0;
+                if (FAILED(DxcCreateInstance(clsid, IID_PPV_ARGS(&pInfo))) || FAILED(pInfo->GetVersion(&major, &minor)))
+                {
+                    result += fmt::format("{} none;", pName);
+                    return;
+                }
+                result += fmt::format("{} {}.{}", pName, major, minor);
+
+                // releases share a major and minor version, and differ by commit
+                ComPtr<IDxcVersionInfo2> pInfo2;
+                UINT32 commitCount = 0;
+                char* pCommitHash = nullptr;
+                if (SUCCEEDED(pInfo.As(&pInfo2)) && SUCCEEDED(pInfo2->GetCommitInfo(&commitCount, &pCommitHash)))
+                {
+                    result += fmt::format(".{} {}", commitCount, pCommitHash != nullptr ? pCommitHash : "");
+#if defined(_WIN32)
+                    CoTaskMemFree(pCommitHash);
+#else
+                    free(pCommitHash);  // DXC's allocator outside of Windows is malloc
+#endif
+                }
+                result += ";";
+            };
+            describe("dxc", CLSID_DxcCompiler);
+            describe("validator", CLSID_DxcValidator);
+            LOG_DEBUG("Shader compiler versions: {}", result);
+            return result;
+        }();
+        return version;
     }
+
+    // the name a shader's costs are listed under, the same for every compile of the same variant
+    std::string AnalysisName(const std::string& filename, const std::string& entry, const std::string& target,
+                             const std::vector<std::string>& defines)
+    {
+        std::string name = fmt::format("{} {} {}", filename, entry, target);
+        for (const std::string& define : defines) name += ' ' + define;
+        return name;
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                  Compiler Pool
+//**********************************************************************************************************************
+ShaderCompilerPool::ShaderCompilerPool() :
+    m_instanceCount(0)
+{
+}
+
+ShaderCompilerPool& ShaderCompilerPool::Get()
+{
+    static ShaderCompilerPool pool;
+    return pool;
+}
+
+ShaderCompilerPool::Lease ShaderCompilerPool::Acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_idle.empty())
+        {
+            std::unique_ptr<Compiler> pCompiler = std::move(m_idle.back());
+            m_idle.pop_back();
+            return Lease(this, std::move(pCompiler));
+        }
+    }
+
+    // created outside the lock, as loading DXC for the first instance takes a while
+    PROFILE_SCOPE("Create Shader Compiler");
+    std::unique_ptr<Compiler> pCompiler = std::make_unique<Compiler>();
+    HRESULT result = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&pCompiler->pCompiler));
+    if (SUCCEEDED(result)) result = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&pCompiler->pUtils));
+    if (SUCCEEDED(result)) result = pCompiler->pUtils->CreateDefaultIncludeHandler(&pCompiler->pIncludeHandler);
+    if (FAILED(result))
+    {
+        CheckResult(result, "Shader Compiler Instance");
+        return Lease(this, nullptr);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_instanceCount++;
+    return Lease(this, std::move(pCompiler));
+}
+
+void ShaderCompilerPool::Release(std::unique_ptr<Compiler> pCompiler)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_idle.push_back(std::move(pCompiler));
+}
+
+uint ShaderCompilerPool::GetInstanceCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_instanceCount;
+}
+
+ShaderCompilerPool::Lease::Lease(ShaderCompilerPool* pPool, std::unique_ptr<Compiler> pCompiler) :
+    m_pPool(pPool),
+    m_pCompiler(std::move(pCompiler))
+{
+}
+
+ShaderCompilerPool::Lease::~Lease()
+{
+    if (m_pCompiler != nullptr) m_pPool->Release(std::move(m_pCompiler));
+}
+
+
+//**********************************************************************************************************************
+//                                                      Shader
+//**********************************************************************************************************************
+Shader::Shader() :
+    m_pBlob(nullptr),
+    m_pErrors(nullptr),
+    m_compiled(false),
+    m_cached(false)
+{
 }
 
 Shader::~Shader()
@@ -18,14 +148,17 @@ Shader::~Shader()
 }
 
 
-HRESULT Shader::Compile(std::string filename, const std::string entry, const std::string target)
+HRESULT Shader::Compile(std::string filename, const std::string entry, const std::string target,
+                        const std::vector<std::string>& defines)
 {
+    PROFILE_FUNCTION();
     HRESULT result = S_OK;
+    m_cached = false;
 
     // load shader text
     m_filename = filename;
     std::ifstream ifile(m_filename);
-    if (!ifile.good()) PrintMessage(Error, "Shader {} could not be opened", filename);
+    if (!ifile.good()) LOG_ERROR("Shader {} could not be opened", filename);
     std::stringstream buffer;
     buffer << ifile.rdbuf();
     m_shaderText = buffer.str();
@@ -36,21 +169,75 @@ HRESULT Shader::Compile(std::string filename, const std::string entry, const std
     sourceBuffer.Ptr = m_shaderText.c_str();
     sourceBuffer.Size = m_shaderText.size();
     sourceBuffer.Encoding = CP_UTF8;
+
+    // The source is named so that includes resolve against its directory, as the cache's hash of them does. Everything
+    //  after the name and include directory goes into the cache key.
+    std::filesystem::path includeDirectory = std::filesystem::path(m_filename).parent_path();
+    if (includeDirectory.empty()) includeDirectory = ".";
+    const std::wstring wideFilename = ToWideString(m_filename);
+    const std::wstring wideIncludeDirectory = ToWideString(PathToUtf8(includeDirectory));
     const std::wstring wideEntry = ToWideString(entry);
     const std::wstring wideTarget = ToWideString(target);
-    LPCWSTR compileArgs[] =
+    std::vector<std::wstring> wideDefines;
+    for (const std::string& define : defines) wideDefines.push_back(ToWideString(define));
+    std::vector<LPCWSTR> compileArgs =
+    {
+        wideFilename.c_str(),
+        L"-I", wideIncludeDirectory.c_str(),
+    };
+    const size_t keyedArgsStart = compileArgs.size();
+    compileArgs.insert(compileArgs.end(),
     {
         L"-E", wideEntry.c_str(),
         L"-T", wideTarget.c_str(),
-        //L"shaders.hlsl",
-        //L"-E", L"PSMain",
-        //L"-T", L"ps_6_0",
         //L"-Zi"
-    };
-    result = m_pCompiler->Compile(&sourceBuffer, compileArgs, _countof(compileArgs), nullptr, IID_PPV_ARGS(&pResults));
+    });
+    for (const std::wstring& define : wideDefines)
+    {
+        compileArgs.push_back(L"-D");
+        compileArgs.push_back(define.c_str());
+    }
+
+    // Vulkan consumes SPIR-V, with constant buffers packed by D3D rules so that CPU-side layouts stay the same. Registers
+    //  map onto bindings of the same number, in the set matching their space.
+    const RenderEngine* pEngine = RenderEngine::pCurrentEngine;
+    const size_t spirvArgsStart = compileArgs.size();
+    if (pEngine != nullptr && pEngine->GetShaderFormat() == ShaderFormatSpirv)
+    {
+        compileArgs.push_back(L"-spirv");
+        compileArgs.push_back(L"-fvk-use-dx-layout");
+        compileArgs.push_back(L"-fspv-target-env=vulkan1.3");
+    }
+
+    // The hash of the source also finds the files it includes, which hot reloading watches. An unchanged shader is
+    //  loaded as it was last compiled, which also skips replaying any warnings.
+    ShaderHasher hasher;
+    hasher.Add(CompilerVersion());
+    for (size_t i = keyedArgsStart; i < compileArgs.size(); ++i) hasher.Add(std::wstring_view(compileArgs[i]));
+    if (spirvArgsStart != compileArgs.size()) hasher.Add(std::string_view("dxil reflection"));  // unlike older entries
+    hasher.AddSource(m_filename, m_shaderText);
+    m_dependencies = hasher.GetSourceFiles();
+
+    ShaderCache& cache = ShaderCache::Get();
+    const ShaderCacheKey key = hasher.Finish();
+    if (cache.IsEnabled() && cache.Load(key, m_pBlob, m_pReflection))
+    {
+        m_pErrors.Reset();
+        m_compiled = true;
+        m_cached = true;
+        ShaderAnalysis::Get().Record(AnalysisName(filename, entry, target, defines), m_pBlob.Get());
+        return S_OK;
+    }
+
+    ShaderCompilerPool::Lease compiler = ShaderCompilerPool::Get().Acquire();
+    if (!compiler.IsValid()) return E_FAIL;
+    result = compiler->pCompiler->Compile(&sourceBuffer, compileArgs.data(), static_cast<UINT32>(compileArgs.size()),
+                                          compiler->pIncludeHandler.Get(), IID_PPV_ARGS(&pResults));
 
     if (pResults != nullptr) // check for compilation outputs
     {
+        // Compile() only fails for bad arguments, and errors in the shader are reported by the status
+        if (SUCCEEDED(result)) pResults->GetStatus(&result);
         ComPtr<IDxcBlobUtf16> pOutputName;
         pResults->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&m_pErrors), &pOutputName);
     }
@@ -58,19 +245,87 @@ HRESULT Shader::Compile(std::string filename, const std::string entry, const std
     {
         if (SUCCEEDED(result))
         {
-            PrintMessage(Warning, "{} {} {}:\n {}", filename, entry, target, m_pErrors->GetStringPointer());
+            LOG_WARNING("{} {} {}:\n {}", filename, entry, target, m_pErrors->GetStringPointer());
         }
         else
         {
-            PrintMessage(Error, "Shader compilation failed!\n {}", m_pErrors->GetStringPointer());
+            LOG_ERROR("Shader compilation failed!\n {}", m_pErrors->GetStringPointer());
         }
     }
     if (SUCCEEDED(result)) // save shader blob
     {
         // TODO: PDB blob required for -Zi
         pResults->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&m_pBlob), nullptr);
+        m_pReflection.Reset();
+        if (pResults->HasOutput(DXC_OUT_REFLECTION))
+        {
+            pResults->GetOutput(DXC_OUT_REFLECTION, IID_PPV_ARGS(&m_pReflection), nullptr);
+        }
+
+        // SPIR-V comes without reflection, which pipelines derive their layouts from, so it is taken from a DXIL
+        //  compile of the same source and cached alongside
+        if (spirvArgsStart != compileArgs.size())
+        {
+            ComPtr<IDxcResult> pDxilResults;
+            HRESULT dxilResult = compiler->pCompiler->Compile(&sourceBuffer, compileArgs.data(),
+                                                              static_cast<UINT32>(spirvArgsStart),
+                                                              compiler->pIncludeHandler.Get(),
+                                                              IID_PPV_ARGS(&pDxilResults));
+            if (SUCCEEDED(dxilResult)) pDxilResults->GetStatus(&dxilResult);
+            if (SUCCEEDED(dxilResult) && pDxilResults->HasOutput(DXC_OUT_REFLECTION))
+            {
+                pDxilResults->GetOutput(DXC_OUT_REFLECTION, IID_PPV_ARGS(&m_pReflection), nullptr);
+            }
+        }
         m_compiled = true;
+
+        if (cache.IsEnabled()) cache.Store(key, m_pBlob.Get(), m_pReflection.Get());
+        ShaderAnalysis::Get().Record(AnalysisName(filename, entry, target, defines), m_pBlob.Get());
     }
 
     return result;
 }
+
+std::vector<std::future<HRESULT>> Shader::CompileBatch(const std::vector<ShaderCompileRequest>& requests)
+{
+    PROFILE_FUNCTION();
+
+    // shared by the jobs, whose captures only have room for a pointer to it
+    struct Batch
+    {
+        std::vector<ShaderCompileRequest>       requests;
+        std::vector<std::promise<HRESULT>>      results;
+    };
+    std::shared_ptr<Batch> pBatch = std::make_shared<Batch>();
+    pBatch->requests = requests;
+    pBatch->results.resize(requests.size());
+
+    std::vector<std::future<HRESULT>> futures;
+    for (std::promise<HRESULT>& result : pBatch->results) futures.push_back(result.get_future());
+
+    const auto compile = [](Batch& batch, size_t index)
+    {
+        const ShaderCompileRequest& request = batch.requests[index];
+        try
+        {
+            batch.results[index].set_value(request.pShader->Compile(request.filename, request.entry, request.target,
+                                                                    request.defines));
+        }
+        catch (...)
+        {
+            batch.results[index].set_exception(std::current_exception());
+        }
+    };
+
+    JobSystem& jobSystem = JobSystem::Get();
+    for (size_t i = 0; i < requests.size(); ++i)
+    {
+        if (jobSystem.GetThreadCount() == 1)
+        {
+            compile(*pBatch, i);
+            continue;
+        }
+        jobSystem.Submit(jobSystem.CreateJob([pBatch, i, compile] {compile(*pBatch, i);}));
+    }
+    return futures;
+}
@@ -3,8 +3,69 @@
 #include "Shade.h"
 
 #include <dxcapi.h>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include "Util.h"
 
+class Shader;
+
+
+// Thread-safe pool of DXC instances, which are not safe to share between threads. A compile leases an instance for its
+//  duration and returns it after, so instances are only created for compiles which overlap, at most one per thread.
+class ShaderCompilerPool
+{
+public:
+    struct Compiler
+    {
+        ComPtr<IDxcCompiler3>       pCompiler;
+        ComPtr<IDxcUtils>           pUtils;
+        ComPtr<IDxcIncludeHandler>  pIncludeHandler;
+    };
+
+    // returns its compiler to the pool when destroyed
+    class Lease
+    {
+    public:
+        Lease(ShaderCompilerPool* pPool, std::unique_ptr<Compiler> pCompiler);
+        ~Lease();
+        Lease(Lease&&) = default;
+
+        Compiler* operator->() const        {return m_pCompiler.get();}
+        bool IsValid() const                {return m_pCompiler != nullptr;}   // false if DXC could not be loaded
+
+    private:
+        ShaderCompilerPool*         m_pPool;
+        std::unique_ptr<Compiler>   m_pCompiler;
+    };
+
+    ShaderCompilerPool();
+
+    static ShaderCompilerPool& Get();
+
+    Lease Acquire();
+    uint GetInstanceCount() const;          // created so far, leased or idle
+
+private:
+    void Release(std::unique_ptr<Compiler> pCompiler);
+
+    mutable std::mutex                      m_mutex;
+    std::vector<std::unique_ptr<Compiler>>  m_idle;
+    uint                                    m_instanceCount;
+};
+
+
+// a shader to compile as part of a batch, with the shader needing to outlive the compile
+struct ShaderCompileRequest
+{
+    Shader*                     pShader;
+    std::string                 filename;
+    std::string                 entry;
+    std::string                 target;
+    std::vector<std::string>    defines;
+};
+
 
 class Shader
 {
@@ -12,23 +73,33 @@ public:
     Shader();
     ~Shader();
 
-    HRESULT Compile(std::string filename, const std::string entry, const std::string target);
+    // Compiled shaders are kept in the ShaderCache, and an unchanged shader is loaded from there without running DXC.
+    HRESULT Compile(std::string filename, const std::string entry, const std::string target,
+                    const std::vector<std::string>& defines = {});
+
+    // Compiles every request at once on the job system, returning futures of their results in the same order. With the
+    //  pool to itself, a batch takes about as long as its slowest compile. Waiting on the futures only blocks, so a job
+    //  system with no workers compiles the batch before returning.
+    static std::vector<std::future<HRESULT>> CompileBatch(const std::vector<ShaderCompileRequest>& requests);
 
     ID3DBlob* GetBlob() const      {return m_pBlob.Get();};
+    ID3DBlob* GetReflectionBlob() const     {return m_pReflection.Get();};  // of DXIL, even for SPIR-V
     const IDxcBlobUtf8* GetErrorBlob() const {return m_pErrors.Get();};
+    bool WasCached() const                  {return m_cached;}              // by the last Compile()
 
-private:
-    // TODO: static compiler instance, or shader cache/manager
-    // compiler and compiler utilities instances
-    ComPtr<IDxcCompiler3>   m_pCompiler;
-    ComPtr<IDxcUtils>       m_pUtils;
+    // the source and every file it includes, canonical, as of the last Compile()
+    const std::vector<std::filesystem::path>& GetDependencies() const   {return m_dependencies;}
 
+private:
     std::string             m_filename;
     std::string             m_shaderText;
     std::string             m_entrypoint;
+    std::vector<std::filesystem::path>  m_dependencies;
 
 
     ComPtr<ID3DBlob>        m_pBlob;
+    ComPtr<ID3DBlob>        m_pReflection;
     ComPtr<IDxcBlobUtf8>    m_pErrors;
     bool m_compiled;
+    bool m_cached;
 };
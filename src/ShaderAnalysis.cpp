@@ -0,0 +1,402 @@
+#include "ShaderAnalysis.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include <imgui.h>
+
+#include "Profiler.h"
+#include "Shader.h"
+
+using namespace std;
+
+
+namespace
+{
+    // the panel stays responsive when first shown with many shaders, filling in over a few frames
+    constexpr uint MaxAnalysesPerFrame = 4;
+
+    bool IsValueCharacter(char c)
+    {
+        return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.' || c == '$' || c == '-';
+    }
+
+    string_view Trim(string_view text)
+    {
+        const size_t first = text.find_first_not_of(" \t\r");
+        if (first == string_view::npos) return {};
+        const size_t last = text.find_last_not_of(" \t\r");
+        return text.substr(first, last - first + 1);
+    }
+
+    string_view FirstToken(string_view text)
+    {
+        return text.substr(0, text.find_first_of(" \t"));
+    }
+
+    // a DXIL operation, by the name following @dx.op.
+    ShaderCostCategory CategoryOfOperation(string_view name)
+    {
+        if (name.rfind("sample", 0) == 0 || name.rfind("texture", 0) == 0) return ShaderCostTexture;
+        if (name == "calculateLOD" || name == "getDimensions")             return ShaderCostTexture;
+        if (name.find("Handle") != string_view::npos)                     return ShaderCostOther;
+        if (name == "discard")                                             return ShaderCostControlFlow;
+
+        // bufferLoad, cbufferLoadLegacy, rawBufferStore, loadInput, storeOutput, atomicBinOp and the like
+        const string_view memoryWords[] = {"load", "Load", "store", "Store", "atomic"};
+        for (string_view word : memoryWords)
+        {
+            if (name.find(word) != string_view::npos) return ShaderCostMemory;
+        }
+        return ShaderCostAlu;
+    }
+
+    // an LLVM instruction, by its opcode
+    ShaderCostCategory CategoryOfOpcode(string_view opcode)
+    {
+        const string_view controlFlow[] = {"br", "switch", "ret", "unreachable", "indirectbr"};
+        const string_view memory[] = {"load", "store", "getelementptr", "alloca", "atomicrmw", "cmpxchg", "fence"};
+        const string_view other[] = {"phi", "extractvalue", "insertvalue", "bitcast", "call"};
+        const auto isOneOf = [opcode](const auto& opcodes)
+        {
+            return find(begin(opcodes), end(opcodes), opcode) != end(opcodes);
+        };
+        if (isOneOf(controlFlow))   return ShaderCostControlFlow;
+        if (isOneOf(memory))        return ShaderCostMemory;
+        if (isOneOf(other))         return ShaderCostOther;
+        return ShaderCostAlu;
+    }
+
+    // the instruction on a line of a function body, without its result
+    ShaderCostCategory CategoryOfInstruction(string_view instruction)
+    {
+        string_view opcode = FirstToken(instruction);
+        if (opcode == "tail" || opcode == "notail" || opcode == "musttail")
+        {
+            opcode = FirstToken(Trim(instruction.substr(opcode.size())));
+        }
+        if (opcode != "call") return CategoryOfOpcode(opcode);
+
+        const string_view prefix = "@dx.op.";
+        const size_t start = instruction.find(prefix);
+        if (start == string_view::npos) return ShaderCostOther;     // intrinsics such as lifetime markers
+        const string_view name = instruction.substr(start + prefix.size());
+        return CategoryOfOperation(name.substr(0, name.find_first_of(".(")));
+    }
+
+    // a count, and its change since the previous compile, in red if it grew and in green if it shrank
+    void CostCell(uint value, const uint* pPrevious)
+    {
+        ImGui::TableNextColumn();
+        ImGui::Text("%u", value);
+        if (pPrevious == nullptr || *pPrevious == value) return;
+
+        const int change = static_cast<int>(value) - static_cast<int>(*pPrevious);
+        const ImVec4 color = (change > 0) ? ImVec4(1.0f, 0.45f, 0.45f, 1.0f) : ImVec4(0.45f, 1.0f, 0.45f, 1.0f);
+        ImGui::SameLine();
+        ImGui::TextColored(color, "%+d", change);
+    }
+
+    bool SameBytes(ID3DBlob* pA, ID3DBlob* pB)
+    {
+        return pA->GetBufferSize() == pB->GetBufferSize() &&
+               memcmp(pA->GetBufferPointer(), pB->GetBufferPointer(), pA->GetBufferSize()) == 0;
+    }
+}
+
+
+const char* const ShaderAnalysis::CategoryNames[ShaderCostCategoryCount] =
+{
+    "ALU",
+    "Memory",
+    "Texture",
+    "Control",
+    "Other",
+};
+
+ShaderAnalysis& ShaderAnalysis::Get()
+{
+    static ShaderAnalysis analysis;
+    return analysis;
+}
+
+
+//**********************************************************************************************************************
+//                                                      Counting
+//**********************************************************************************************************************
+HRESULT ShaderAnalysis::Analyze(ID3DBlob* pBlob, ShaderCost& cost)
+{
+    PROFILE_FUNCTION();
+    cost = {};
+    if (pBlob == nullptr) return E_INVALIDARG;
+
+    // DXIL comes in a container starting with its fourcc, which SPIR-V modules do not
+    const size_t size = pBlob->GetBufferSize();
+    if (size < 4 || memcmp(pBlob->GetBufferPointer(), "DXBC", 4) != 0) return E_NOTIMPL;
+
+    ShaderCompilerPool::Lease compiler = ShaderCompilerPool::Get().Acquire();
+    if (!compiler.IsValid()) return E_FAIL;
+
+    const DxcBuffer buffer = {pBlob->GetBufferPointer(), size, 0};
+    ComPtr<IDxcResult> pResult;
+    ComPtr<IDxcBlobUtf8> pDisassembly;
+    HRESULT result = compiler->pCompiler->Disassemble(&buffer, IID_PPV_ARGS(&pResult));
+    if (SUCCEEDED(result)) pResult->GetStatus(&result);
+    if (SUCCEEDED(result)) result = pResult->GetOutput(DXC_OUT_DISASSEMBLY, IID_PPV_ARGS(&pDisassembly), nullptr);
+    if (FAILED(result)) return result;
+    if (pDisassembly == nullptr) return E_FAIL;
+
+    cost = CountDisassembly({pDisassembly->GetStringPointer(), pDisassembly->GetStringLength()});
+    cost.bytecodeSize = static_cast<uint>(size);
+    return S_OK;
+}
+
+ShaderCost ShaderAnalysis::CountDisassembly(string_view disassembly)
+{
+    ShaderCost cost = {};
+
+    // per function, where each value was defined and last used, by instruction index
+    bool inFunction = false;
+    vector<pair<uint, uint>> lifetimes;
+    unordered_map<string_view, size_t> values;
+    uint instructionIndex = 0;
+    const auto finishFunction = [&]
+    {
+        vector<int> changes(instructionIndex + 1, 0);
+        for (const auto& [defined, lastUsed] : lifetimes)
+        {
+            changes[defined]++;
+            changes[lastUsed + 1]--;
+        }
+        int live = 0;
+        for (int change : changes)
+        {
+            live += change;
+            cost.peakLiveValues = max(cost.peakLiveValues, static_cast<uint>(live));
+        }
+        lifetimes.clear();
+        values.clear();
+        instructionIndex = 0;
+        inFunction = false;
+    };
+
+    for (size_t start = 0; start < disassembly.size();)
+    {
+        size_t end = disassembly.find('\n', start);
+        if (end == string_view::npos) end = disassembly.size();
+        string_view line = disassembly.substr(start, end - start);
+        start = end + 1;
+
+        // comments, which DXC annotates operations and labels blocks with, are not part of the instruction
+        line = Trim(line.substr(0, line.find(';')));
+        if (line.empty()) continue;
+        if (!inFunction)
+        {
+            inFunction = (line.rfind("define ", 0) == 0);
+            continue;
+        }
+        if (line == "}")
+        {
+            finishFunction();
+            continue;
+        }
+        if (line.back() == ':') continue;   // a label
+
+        // the result, if any, and every operand which is a value of this function, so not a type or a global
+        string_view instruction = line;
+        string_view result;
+        const size_t equals = line.find(" = ");
+        if (line[0] == '%' && equals != string_view::npos)
+        {
+            result = line.substr(0, equals);
+            instruction = line.substr(equals + 3);
+        }
+        for (size_t i = instruction.find('%'); i != string_view::npos; i = instruction.find('%', i + 1))
+        {
+            size_t nameEnd = i + 1;
+            while (nameEnd < instruction.size() && IsValueCharacter(instruction[nameEnd])) nameEnd++;
+            auto found = values.find(instruction.substr(i, nameEnd - i));
+            if (found != values.end()) lifetimes[found->second].second = instructionIndex;
+        }
+        if (!result.empty())
+        {
+            values[result] = lifetimes.size();
+            lifetimes.push_back({instructionIndex, instructionIndex});
+        }
+
+        cost.instructions[CategoryOfInstruction(instruction)]++;
+        cost.totalInstructions++;
+        instructionIndex++;
+    }
+    if (inFunction) finishFunction();
+    return cost;
+}
+
+
+//**********************************************************************************************************************
+//                                                  Recorded Shaders
+//**********************************************************************************************************************
+void ShaderAnalysis::Record(const string& name, ID3DBlob* pBlob)
+{
+    if (pBlob == nullptr) return;
+
+    // shaders loaded from the cache, or recompiled with edits that changed nothing, keep their previous costs
+    lock_guard<mutex> lock(m_mutex);
+    Entry& entry = m_entries[name];
+    if (entry.latest.pBlob != nullptr)
+    {
+        if (SameBytes(entry.latest.pBlob.Get(), pBlob)) return;
+        entry.previous = move(entry.latest);
+        entry.changes++;
+    }
+    entry.latest = {pBlob, {}, S_OK, false};
+}
+
+void ShaderAnalysis::AnalyzePending()
+{
+    // copied out, as DXC runs without the lock so that compiles recording meanwhile are not held up
+    struct Pending
+    {
+        string              name;
+        ComPtr<ID3DBlob>    pBlob;
+        ShaderCost          cost;
+        HRESULT             result;
+    };
+    vector<Pending> pending;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        for (const auto& [name, entry] : m_entries)
+        {
+            for (const Analysis* pAnalysis : {&entry.latest, &entry.previous})
+            {
+                if (pAnalysis->pBlob == nullptr || pAnalysis->analyzed) continue;
+                if (pending.size() < MaxAnalysesPerFrame) pending.push_back({name, pAnalysis->pBlob, {}, S_OK});
+            }
+        }
+    }
+    if (pending.empty()) return;
+
+    for (Pending& shader : pending) shader.result = Analyze(shader.pBlob.Get(), shader.cost);
+
+    // matched by blob, as the shader may have been recompiled while analysing
+    lock_guard<mutex> lock(m_mutex);
+    for (const Pending& shader : pending)
+    {
+        Entry& entry = m_entries[shader.name];
+        for (Analysis* pAnalysis : {&entry.latest, &entry.previous})
+        {
+            if (pAnalysis->pBlob != shader.pBlob) continue;
+            pAnalysis->cost = shader.cost;
+            pAnalysis->result = shader.result;
+            pAnalysis->analyzed = true;
+        }
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                      Output
+//**********************************************************************************************************************
+void ShaderAnalysis::Dump()
+{
+    // the whole backlog at once, as nothing is shown interactively to spread it over
+    for (;;)
+    {
+        AnalyzePending();
+        lock_guard<mutex> lock(m_mutex);
+        const auto isPending = [](const auto& named)
+        {
+            const Entry& entry = named.second;
+            return (entry.latest.pBlob != nullptr && !entry.latest.analyzed) ||
+                   (entry.previous.pBlob != nullptr && !entry.previous.analyzed);
+        };
+        if (none_of(m_entries.begin(), m_entries.end(), isPending)) break;
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+    PrintMessage(Info, "Shader costs, with changes since each shader's previous compile:");
+    for (const auto& [name, entry] : m_entries)
+    {
+        const ShaderCost& cost = entry.latest.cost;
+        if (FAILED(entry.latest.result))
+        {
+            PrintMessage(Info, "  {}: {}", name, (entry.latest.result == E_NOTIMPL) ? "not DXIL" : "not analysed");
+            continue;
+        }
+
+        const bool compare = entry.previous.pBlob != nullptr && SUCCEEDED(entry.previous.result);
+        const auto describe = [compare](uint value, uint previous)
+        {
+            if (!compare || value == previous) return fmt::format("{}", value);
+            return fmt::format("{} ({:+})", value, static_cast<int>(value) - static_cast<int>(previous));
+        };
+        const ShaderCost& before = entry.previous.cost;
+        string categories;
+        for (uint i = 0; i < ShaderCostCategoryCount; ++i)
+        {
+            if (i != 0) categories += ", ";
+            const string count = describe(cost.instructions[i], before.instructions[i]);
+            categories += fmt::format("{} {}", CategoryNames[i], count);
+        }
+        PrintMessage(Info, "  {}: {} bytes, {} instructions ({}), peak {} live values", name,
+                     describe(cost.bytecodeSize, before.bytecodeSize),
+                     describe(cost.totalInstructions, before.totalInstructions), categories,
+                     describe(cost.peakLiveValues, before.peakLiveValues));
+    }
+}
+
+void ShaderAnalysis::BuildUI()
+{
+    AnalyzePending();
+
+    lock_guard<mutex> lock(m_mutex);
+    if (m_entries.empty())
+    {
+        ImGui::TextDisabled("No shaders have been compiled");
+        return;
+    }
+    ImGui::TextDisabled("Changes are since each shader's previous compile. Live values estimate register pressure.");
+
+    const ImGuiTableFlags flags = ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders | ImGuiTableFlags_SizingFixedFit |
+                                  ImGuiTableFlags_ScrollY;
+    if (!ImGui::BeginTable("Shader Costs", ShaderCostCategoryCount + 5, flags)) return;
+
+    ImGui::TableSetupScrollFreeze(1, 1);
+    ImGui::TableSetupColumn("Shader");
+    ImGui::TableSetupColumn("Bytes");
+    for (const char* pName : CategoryNames) ImGui::TableSetupColumn(pName);
+    ImGui::TableSetupColumn("Total");
+    ImGui::TableSetupColumn("Live");
+    ImGui::TableSetupColumn("Changes");
+    ImGui::TableHeadersRow();
+
+    for (const auto& [name, entry] : m_entries)
+    {
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();   ImGui::TextUnformatted(name.c_str());
+
+        const Analysis& latest = entry.latest;
+        if (!latest.analyzed || FAILED(latest.result))
+        {
+            ImGui::TableNextColumn();
+            if (!latest.analyzed)                   ImGui::TextDisabled("analysing");
+            else if (latest.result == E_NOTIMPL)    ImGui::TextDisabled("not DXIL");
+            else                                    ImGui::TextDisabled("failed");
+            continue;
+        }
+
+        const bool compare = entry.previous.analyzed && SUCCEEDED(entry.previous.result);
+        const ShaderCost& cost = latest.cost;
+        const ShaderCost& before = entry.previous.cost;
+        const auto cell = [compare](uint value, const uint& previous) {CostCell(value, compare ? &previous : nullptr);};
+        cell(cost.bytecodeSize, before.bytecodeSize);
+        for (uint i = 0; i < ShaderCostCategoryCount; ++i) cell(cost.instructions[i], before.instructions[i]);
+        cell(cost.totalInstructions, before.totalInstructions);
+        cell(cost.peakLiveValues, before.peakLiveValues);
+        ImGui::TableNextColumn();   ImGui::Text("%u", entry.changes);
+    }
+    ImGui::EndTable();
+}
@@ -0,0 +1,83 @@
+// ShaderAnalysis - Static costs of compiled shaders, counted from DXC's disassembly of their DXIL, and compared between
+//  recompiles so that an edit making a shader more expensive shows up without profiling it on a GPU.
+//
+// Instructions are counted by category from the disassembled LLVM IR: DXIL operations such as sample or bufferLoad by
+//  their name, and plain LLVM instructions by their opcode. Handle creation, phis and value extraction are bookkeeping
+//  which the driver's compiler mostly folds away, so they are counted as other and not as ALU. Register pressure is
+//  estimated as the peak number of SSA values live at once, scanning each function in order. That ignores values kept
+//  alive around loops, so it is a lower bound, but one that moves as real pressure does.
+//
+// Every successful Shader::Compile() records its bytecode under the shader's file, entry point, target and defines.
+//  Only the bytecode is kept, the latest and the one before it, and disassembly waits until the panel is shown. SPIR-V
+//  cannot be disassembled by DXC, so shaders compiled for Vulkan are listed without costs.
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+#include "Util.h"
+
+
+enum ShaderCostCategory
+{
+    ShaderCostAlu,
+    ShaderCostMemory,           // constant and other buffers, and stage inputs and outputs
+    ShaderCostTexture,          // samples, loads, stores and gathers, and resource queries
+    ShaderCostControlFlow,      // branches, returns and discards
+    ShaderCostOther,            // handles, phis, extraction and casts
+    ShaderCostCategoryCount
+};
+
+struct ShaderCost
+{
+    uint    instructions[ShaderCostCategoryCount];
+    uint    totalInstructions;
+    uint    peakLiveValues;     // estimate of register pressure, in SSA values of mostly 32 bits
+    uint    bytecodeSize;       // in bytes, of the whole container
+};
+
+
+class ShaderAnalysis
+{
+public:
+    static const char* const CategoryNames[ShaderCostCategoryCount];
+
+    static ShaderAnalysis& Get();
+
+    // Disassembles DXIL and counts its costs. Fails with E_NOTIMPL for SPIR-V, or as DXC fails.
+    static HRESULT Analyze(ID3DBlob* pBlob, ShaderCost& cost);
+
+    // the counting alone, from disassembled text, with the bytecode size left at zero
+    static ShaderCost CountDisassembly(std::string_view disassembly);
+
+    // Keeps the bytecode of a shader as its latest, unless unchanged, and the previous latest to compare against.
+    //  Thread-safe, as shaders compile on the job system and the watcher's thread.
+    void Record(const std::string& name, ID3DBlob* pBlob);
+
+    // both analyse what was recorded since, the panel a few shaders a frame and the log all of them at once
+    void BuildUI();
+    void Dump();
+
+private:
+    struct Analysis
+    {
+        ComPtr<ID3DBlob>    pBlob;
+        ShaderCost          cost;
+        HRESULT             result;
+        bool                analyzed;
+    };
+
+    struct Entry
+    {
+        Analysis            latest;
+        Analysis            previous;   // with no blob until the shader changes
+        uint                changes;    // recompiles which changed the bytecode
+    };
+
+    void AnalyzePending();
+
+    std::mutex                      m_mutex;
+    std::map<std::string, Entry>    m_entries;      // by name, the order they are listed in
+};
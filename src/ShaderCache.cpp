@@ -0,0 +1,418 @@
+#include "ShaderCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "MappedFile.h"
+#include "Profiler.h"
+
+using namespace std;
+
+
+namespace
+{
+    constexpr uint32 EntryMagic     = 0x43444853;   // "SHDC"
+    constexpr uint32 EntryVersion   = 1;
+    const char* EntryExtension      = ".bin";
+
+    // Entry files begin with this, followed by the bytecode and then the reflection data, each 8 byte aligned.
+    struct EntryHeader
+    {
+        uint32  magic;
+        uint32  version;
+        uint64  keyHigh;
+        uint64  keyLow;
+        uint64  objectSize;
+        uint64  reflectionSize;
+    };
+
+    size_t AlignEntry(size_t size)
+    {
+        return (size + 7) & ~size_t(7);
+    }
+
+    bool ReadText(const filesystem::path& path, string& text)
+    {
+        ifstream file(path, ios::binary);
+        if (!file.good()) return false;
+        text.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+        return true;
+    }
+
+    // Hands out part of a mapped entry as a blob, keeping the mapping alive for as long as any blob over it is held.
+    //  ID3DBlob shares its IID with IDxcBlob, so these may be passed to DXC as well as to D3D.
+    class MappedBlob : public ID3DBlob
+    {
+    public:
+        MappedBlob(shared_ptr<MappedFile> pFile, size_t offset, size_t size) :
+            m_refCount(1),
+            m_pFile(move(pFile)),
+            m_offset(offset),
+            m_size(size)
+        {
+        }
+        virtual ~MappedBlob()
+        {
+        }
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject)
+        {
+            if (ppvObject == nullptr) return E_POINTER;
+            if (riid != __uuidof(IUnknown) && riid != __uuidof(ID3DBlob))
+            {
+                *ppvObject = nullptr;
+                return E_NOINTERFACE;
+            }
+
+            AddRef();
+            *ppvObject = static_cast<ID3DBlob*>(this);
+            return S_OK;
+        }
+        ULONG STDMETHODCALLTYPE AddRef()
+        {
+            return ++m_refCount;
+        }
+        ULONG STDMETHODCALLTYPE Release()
+        {
+            const ULONG refCount = --m_refCount;
+            if (refCount == 0) delete this;
+            return refCount;
+        }
+
+        LPVOID STDMETHODCALLTYPE GetBufferPointer()
+        {
+            return const_cast<uint8_t*>(m_pFile->GetData() + m_offset);
+        }
+        SIZE_T STDMETHODCALLTYPE GetBufferSize()
+        {
+            return m_size;
+        }
+
+    private:
+        atomic<ULONG>           m_refCount;
+        shared_ptr<MappedFile>  m_pFile;
+        size_t                  m_offset;
+        size_t                  m_size;
+    };
+}
+
+
+//**********************************************************************************************************************
+//                                                      Hashing
+//**********************************************************************************************************************
+void ShaderHasher::AddSource(const filesystem::path& path, string_view text)
+{
+    Add(text);
+
+    error_code error;
+    m_sourceFiles.push_back(filesystem::weakly_canonical(path, error));
+    AddIncludes(path.parent_path(), path.parent_path(), text);
+}
+
+void ShaderHasher::AddIncludes(const filesystem::path& directory, const filesystem::path& rootDirectory,
+                               string_view text)
+{
+    for (size_t lineStart = 0; lineStart < text.size();)
+    {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == string_view::npos) lineEnd = text.size();
+        string_view line = text.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        // #include "name" or #include <name>, with any spacing around the hash
+        const auto skipSpaces = [&line]
+        {
+            while (!line.empty() && (line[0] == ' ' || line[0] == '\t')) line.remove_prefix(1);
+        };
+        skipSpaces();
+        if (line.empty() || line[0] != '#') continue;
+        line.remove_prefix(1);
+        skipSpaces();
+        if (line.substr(0, 7) != "include") continue;
+        line.remove_prefix(7);
+        skipSpaces();
+        if (line.empty() || (line[0] != '"' && line[0] != '<')) continue;
+        const size_t nameEnd = line.find(line[0] == '"' ? '"' : '>', 1);
+        if (nameEnd == string_view::npos) continue;
+        const filesystem::path name(string(line.substr(1, nameEnd - 1)));
+
+        // the including file's directory first, then the directory of the file being compiled
+        error_code error;
+        filesystem::path includePath = directory / name;
+        if (!filesystem::exists(includePath, error)) includePath = rootDirectory / name;
+        if (!filesystem::exists(includePath, error))
+        {
+            Add(~uint64(0));    // a missing include fails compilation, which is never cached, but keeps keys distinct
+            continue;
+        }
+
+        includePath = filesystem::weakly_canonical(includePath, error);
+        if (find(m_sourceFiles.begin(), m_sourceFiles.end(), includePath) != m_sourceFiles.end()) continue;
+        m_sourceFiles.push_back(includePath);
+
+        string includeText;
+        if (!ReadText(includePath, includeText)) continue;
+        Add(includeText);
+        AddIncludes(includePath.parent_path(), rootDirectory, includeText);
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                              Constructors & Destructors
+//**********************************************************************************************************************
+ShaderCache::ShaderCache() :
+    m_directory("shader_cache"),
+    m_sizeLimit(DefaultSizeLimit),
+    m_enabled(true),
+    m_opened(false),
+    m_totalSize(0),
+    m_hits(0),
+    m_misses(0)
+{
+}
+
+ShaderCache::~ShaderCache()
+{
+}
+
+ShaderCache& ShaderCache::Get()
+{
+    static ShaderCache cache;
+    return cache;
+}
+
+
+//**********************************************************************************************************************
+//                                                  Configuration
+//**********************************************************************************************************************
+void ShaderCache::SetDirectory(const filesystem::path& directory)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_directory = directory;
+    m_entries.clear();
+    m_totalSize = 0;
+    m_opened = false;
+}
+
+void ShaderCache::SetSizeLimit(uint64 bytes)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_sizeLimit = bytes;
+    if (m_opened) Evict("");
+}
+
+ShaderCache::Stats ShaderCache::GetStats() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return {m_hits, m_misses, m_entries.size(), m_totalSize};
+}
+
+filesystem::path ShaderCache::EntryPath(const string& name) const
+{
+    return m_directory / (name + EntryExtension);
+}
+
+void ShaderCache::Open()
+{
+    PROFILE_FUNCTION();
+    m_opened = true;
+
+    error_code error;
+    filesystem::create_directories(m_directory, error);
+    if (error)
+    {
+        LOG_WARNING("Shader cache directory {} could not be created: {}", PathToUtf8(m_directory), error.message());
+        return;
+    }
+
+    // entries written by earlier runs, or by other processes sharing the directory
+    for (const filesystem::directory_entry& file : filesystem::directory_iterator(m_directory, error))
+    {
+        const filesystem::path& path = file.path();
+        if (!file.is_regular_file(error) || path.extension() != EntryExtension) continue;
+        const uint64 size = file.file_size(error);
+        const filesystem::file_time_type lastUse = file.last_write_time(error);
+        if (error) continue;
+        m_entries[path.stem().string()] = {size, lastUse};
+        m_totalSize += size;
+    }
+    LOG_DEBUG("Shader cache {} holds {} entries, {}", PathToUtf8(m_directory), m_entries.size(),
+              HumanReadableFileSize(static_cast<uint>(m_totalSize)));
+
+    Evict("");
+}
+
+
+//**********************************************************************************************************************
+//                                                  Primary Interfaces
+//**********************************************************************************************************************
+bool ShaderCache::Load(const ShaderCacheKey& key, ComPtr<ID3DBlob>& pObject, ComPtr<ID3DBlob>& pReflection)
+{
+    PROFILE_FUNCTION();
+    lock_guard<mutex> lock(m_mutex);
+    if (!m_opened) Open();
+
+    // the index may not know of entries written by other processes, so the file is always looked for
+    const string name = key.ToString();
+    const filesystem::path path = EntryPath(name);
+    shared_ptr<MappedFile> pFile = make_shared<MappedFile>();
+    if (!pFile->Open(path))
+    {
+        m_misses++;
+        return false;
+    }
+
+    EntryHeader header;
+    bool valid = pFile->GetSize() >= sizeof(header);
+    if (valid)
+    {
+        memcpy(&header, pFile->GetData(), sizeof(header));
+        valid = header.magic == EntryMagic && header.version == EntryVersion &&
+                header.keyHigh == key.high && header.keyLow == key.low && header.objectSize != 0;
+
+        // each size against what remains of the file, as damaged sizes could overflow a sum of them
+        const uint64 remaining = pFile->GetSize() - sizeof(header);
+        valid = valid && header.objectSize <= remaining && AlignEntry(header.objectSize) <= remaining &&
+                header.reflectionSize <= remaining - AlignEntry(header.objectSize);
+    }
+    if (!valid)
+    {
+        // left by an older version or damaged, and rewritten once the shader has compiled
+        LOG_WARNING("Shader cache entry {} is invalid and will be replaced", name);
+        pFile->Close();
+        error_code error;
+        filesystem::remove(path, error);
+        auto entry = m_entries.find(name);
+        if (entry != m_entries.end())
+        {
+            m_totalSize -= entry->second.size;
+            m_entries.erase(entry);
+        }
+        m_misses++;
+        return false;
+    }
+
+    // refreshed on disk as well as in the index, so that least recently used survives between runs
+    const filesystem::file_time_type now = filesystem::file_time_type::clock::now();
+    error_code error;
+    filesystem::last_write_time(path, now, error);
+    auto entry = m_entries.find(name);
+    if (entry == m_entries.end())
+    {
+        m_entries[name] = {pFile->GetSize(), now};
+        m_totalSize += pFile->GetSize();
+    }
+    else
+    {
+        entry->second.lastUse = now;
+    }
+
+    const size_t objectOffset = sizeof(header);
+    const size_t reflectionOffset = objectOffset + AlignEntry(header.objectSize);
+    pObject.Attach(new MappedBlob(pFile, objectOffset, header.objectSize));
+    pReflection.Reset();
+    if (header.reflectionSize != 0) pReflection.Attach(new MappedBlob(pFile, reflectionOffset, header.reflectionSize));
+
+    m_hits++;
+    return true;
+}
+
+void ShaderCache::Store(const ShaderCacheKey& key, ID3DBlob* pObject, ID3DBlob* pReflection)
+{
+    PROFILE_FUNCTION();
+    if (pObject == nullptr || pObject->GetBufferSize() == 0) return;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        if (!m_opened) Open();
+    }
+
+    EntryHeader header = {};
+    header.magic = EntryMagic;
+    header.version = EntryVersion;
+    header.keyHigh = key.high;
+    header.keyLow = key.low;
+    header.objectSize = pObject->GetBufferSize();
+    header.reflectionSize = pReflection != nullptr ? pReflection->GetBufferSize() : 0;
+
+    // written beside the entry and renamed over it, named uniquely so that concurrent writers never share a file
+    const string name = key.ToString();
+    const filesystem::path path = EntryPath(name);
+    filesystem::path tempPath = path;
+    tempPath += fmt::format(".{:x}.{:x}.tmp", Profiler::Now(), hash<thread::id>()(this_thread::get_id()));
+
+    const char padding[8] = {};
+    ofstream file(tempPath, ios::binary | ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(static_cast<const char*>(pObject->GetBufferPointer()), header.objectSize);
+    file.write(padding, AlignEntry(header.objectSize) - header.objectSize);
+    if (header.reflectionSize != 0)
+    {
+        file.write(static_cast<const char*>(pReflection->GetBufferPointer()), header.reflectionSize);
+    }
+    file.close();
+
+    error_code error;
+    if (file.fail())
+    {
+        LOG_WARNING("Shader cache entry {} could not be written", PathToUtf8(tempPath));
+        filesystem::remove(tempPath, error);
+        return;
+    }
+    filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        // most likely another process wrote the same entry first, and has it mapped
+        filesystem::remove(tempPath, error);
+        return;
+    }
+
+    lock_guard<mutex> lock(m_mutex);
+    const uint64 size = sizeof(header) + AlignEntry(header.objectSize) + header.reflectionSize;
+    Entry& entry = m_entries[name];
+    m_totalSize += size - entry.size;
+    entry = {size, filesystem::file_time_type::clock::now()};
+    Evict(name);
+}
+
+void ShaderCache::Clear()
+{
+    lock_guard<mutex> lock(m_mutex);
+    if (!m_opened) Open();
+
+    error_code error;
+    for (const auto& [name, entry] : m_entries)
+    {
+        filesystem::remove(EntryPath(name), error);
+    }
+    m_entries.clear();
+    m_totalSize = 0;
+}
+
+void ShaderCache::Evict(const string& keep)
+{
+    if (m_totalSize <= m_sizeLimit) return;
+
+    vector<pair<filesystem::file_time_type, string>> entries;
+    entries.reserve(m_entries.size());
+    for (const auto& [name, entry] : m_entries)
+    {
+        if (name != keep) entries.push_back({entry.lastUse, name});
+    }
+    sort(entries.begin(), entries.end());
+
+    // oldest first, forgetting entries another process holds open too, which the next index of the directory recounts
+    error_code error;
+    for (size_t i = 0; i < entries.size() && m_totalSize > m_sizeLimit; ++i)
+    {
+        const string& name = entries[i].second;
+        filesystem::remove(EntryPath(name), error);
+        m_totalSize -= m_entries[name].size;
+        m_entries.erase(name);
+        LOG_DEBUG("Shader cache evicted {}", name);
+    }
+}
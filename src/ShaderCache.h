@@ -0,0 +1,105 @@
+// ShaderCache - Content-addressed on-disk cache of compiled shaders, which lets unchanged shaders skip the compiler.
+//
+// Entries are keyed by a 128-bit hash of everything the compiler's output depends on: the source along with every file
+//  it includes, the entry point, target profile, defines and other arguments, and the versions of the compiler and
+//  validator. Editing a shader or any of its includes, or updating DXC, therefore misses rather than serving stale
+//  bytecode, and no entry ever needs invalidating.
+//
+// Each entry is a file holding the bytecode and reflection data, which are handed out as blobs over a memory mapping of
+//  it, so a hit reads nothing but the pages D3D copies. Entries are written to a temporary file and renamed into place,
+//  so processes sharing the directory never see a partial entry. The directory is kept under a size limit by evicting
+//  the least recently used entries, with each hit refreshing its entry's modification time so the order survives
+//  between runs.
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Hash.h"
+#include "Util.h"
+
+
+// names an entry's file by its ToString()
+typedef Hash128 ShaderCacheKey;
+
+
+// Hashes each part of a key in turn, and the sources with the files they include.
+class ShaderHasher : public Hasher
+{
+public:
+    // Hashes source text along with every file it includes, found relative to the including file as the compiler finds
+    //  them. Includes are scanned for without preprocessing, so those in comments or disabled blocks are hashed too,
+    //  which can only cause needless misses. Each file is hashed once however often it is included.
+    void AddSource(const std::filesystem::path& path, std::string_view text);
+
+    // every file hashed by AddSource(), canonical and with the source first
+    const std::vector<std::filesystem::path>& GetSourceFiles() const  {return m_sourceFiles;}
+
+private:
+    void AddIncludes(const std::filesystem::path& directory, const std::filesystem::path& rootDirectory,
+                     std::string_view text);
+
+    std::vector<std::filesystem::path>  m_sourceFiles;  // every file hashed by AddSource()
+};
+
+
+class ShaderCache
+{
+public:
+    static constexpr uint64 DefaultSizeLimit = 256ull * 1024 * 1024;
+
+    ShaderCache();
+    ~ShaderCache();
+
+    ShaderCache(const ShaderCache&) = delete;
+    ShaderCache& operator=(const ShaderCache&) = delete;
+
+    static ShaderCache& Get();                      // shared by every shader, in "shader_cache" until moved
+
+    // The directory is created if need be, and indexed the first time the cache is used after being set.
+    void SetDirectory(const std::filesystem::path& directory);
+    const std::filesystem::path& GetDirectory() const      {return m_directory;}
+    void SetSizeLimit(uint64 bytes);
+    void SetEnabled(bool enabled)                   {m_enabled = enabled;}
+    bool IsEnabled() const                          {return m_enabled;}
+
+    // A hit returns blobs over a mapping of the entry, which stay valid however long they are held, even should the
+    //  entry be evicted. Reflection data is optional.
+    bool Load(const ShaderCacheKey& key, ComPtr<ID3DBlob>& pObject, ComPtr<ID3DBlob>& pReflection);
+    void Store(const ShaderCacheKey& key, ID3DBlob* pObject, ID3DBlob* pReflection);
+    void Clear();                                   // removes every entry
+
+    struct Stats
+    {
+        uint64  hits;
+        uint64  misses;
+        uint64  entries;
+        uint64  bytes;
+    };
+    Stats GetStats() const;
+
+private:
+    struct Entry
+    {
+        uint64                              size;
+        std::filesystem::file_time_type     lastUse;
+    };
+
+    void Open();
+    void Evict(const std::string& keep);
+    std::filesystem::path EntryPath(const std::string& name) const;
+
+    mutable std::mutex                      m_mutex;
+    std::filesystem::path                   m_directory;
+    uint64                                  m_sizeLimit;
+    bool                                    m_enabled;
+    bool                                    m_opened;
+
+    std::unordered_map<std::string, Entry>  m_entries;      // by key string
+    uint64                                  m_totalSize;
+    uint64                                  m_hits;
+    uint64                                  m_misses;
+};
@@ -0,0 +1,297 @@
+#include "ShaderPermutations.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+#include "Profiler.h"
+#include "ShaderCache.h"
+#include "ShaderWatcher.h"
+
+using namespace std;
+
+
+namespace
+{
+    // every initialized program, for manifests
+    mutex& ProgramsMutex()
+    {
+        static mutex programsMutex;
+        return programsMutex;
+    }
+
+    vector<ShaderPermutations*>& Programs()
+    {
+        static vector<ShaderPermutations*> programs;
+        return programs;
+    }
+
+    HRESULT WaitForCompile(future<HRESULT>& compile)
+    {
+        try
+        {
+            return compile.get();
+        }
+        catch (...)
+        {
+            return E_FAIL;
+        }
+    }
+
+    // the first failure, if any
+    HRESULT WaitForCompiles(vector<future<HRESULT>>& compiles)
+    {
+        HRESULT result = S_OK;
+        for (future<HRESULT>& compile : compiles)
+        {
+            const HRESULT stageResult = WaitForCompile(compile);
+            if (SUCCEEDED(result)) result = stageResult;
+        }
+        compiles.clear();
+        return result;
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                              Constructors & Destructors
+//**********************************************************************************************************************
+ShaderPermutations::ShaderPermutations() :
+    m_keyMask(0)
+{
+}
+
+ShaderPermutations::~ShaderPermutations()
+{
+    {
+        lock_guard<mutex> lock(ProgramsMutex());
+        vector<ShaderPermutations*>& programs = Programs();
+        programs.erase(remove(programs.begin(), programs.end(), this), programs.end());
+    }
+
+    // the compiles write to the variants' shaders
+    for (auto& [key, pEntry] : m_variants)
+    {
+        WaitForCompiles(pEntry->compiles);
+        if (pEntry->watch != 0) ShaderWatcher::Get().Unwatch(pEntry->watch);
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                  Primary Interfaces
+//**********************************************************************************************************************
+HRESULT ShaderPermutations::Init(const vector<ShaderStageDesc>& stages, const vector<string>& keywords)
+{
+    PROFILE_FUNCTION();
+    assert(m_variants.empty() && keywords.size() <= MaxKeywords);
+
+    m_stages = stages;
+    m_keywords = keywords;
+    m_keyMask = (keywords.size() < 32) ? (1u << keywords.size()) - 1 : ~0u;
+    {
+        lock_guard<mutex> lock(ProgramsMutex());
+        Programs().push_back(this);
+    }
+
+    Entry& fallback = StartCompile(0);
+    const HRESULT result = WaitForCompiles(fallback.compiles);
+    fallback.state = SUCCEEDED(result) ? VariantReady : VariantFailed;
+    fallback.watch = ShaderWatcher::Get().Watch(GetRequests(0, fallback.variant));
+    return result;
+}
+
+ShaderPermutationKey ShaderPermutations::GetKeywordMask(string_view keyword) const
+{
+    for (size_t i = 0; i < m_keywords.size(); ++i)
+    {
+        if (m_keywords[i] == keyword) return 1u << i;
+    }
+    return 0;
+}
+
+vector<string> ShaderPermutations::GetDefines(ShaderPermutationKey key) const
+{
+    vector<string> defines;
+    for (size_t i = 0; i < m_keywords.size(); ++i)
+    {
+        defines.push_back(m_keywords[i] + (((key >> i) & 1) ? "=1" : "=0"));
+    }
+    return defines;
+}
+
+const ShaderPermutations::Variant* ShaderPermutations::Request(ShaderPermutationKey key)
+{
+    key &= m_keyMask;
+    auto found = m_variants.find(key);
+    Entry& entry = (found != m_variants.end()) ? *found->second : StartCompile(key);
+
+    Update(key, entry);
+    return (entry.state == VariantReady) ? &entry.variant : nullptr;
+}
+
+const ShaderPermutations::Variant& ShaderPermutations::GetFallback()
+{
+    Entry& fallback = *m_variants.at(0);
+    Update(0, fallback);
+    return fallback.variant;
+}
+
+
+//**********************************************************************************************************************
+//                                                      Manifests
+//**********************************************************************************************************************
+bool ShaderPermutations::WriteManifest(const string& filename)
+{
+    // one line per compile, which programs sharing a shader would otherwise repeat
+    set<string> lines;
+    {
+        lock_guard<mutex> lock(ProgramsMutex());
+        for (const ShaderPermutations* pProgram : Programs())
+        {
+            // only the keys are read, as the rendering thread may be swapping in reloaded shaders
+            lock_guard<mutex> programLock(pProgram->m_mutex);
+            for (const auto& [key, pEntry] : pProgram->m_variants)
+            {
+                string defines;
+                for (const string& define : pProgram->GetDefines(key)) defines += ' ' + define;
+                for (const ShaderStageDesc& stage : pProgram->m_stages)
+                {
+                    lines.insert(stage.filename + ' ' + stage.entry + ' ' + stage.target + defines);
+                }
+            }
+        }
+    }
+
+    ofstream file(filename);
+    if (!file)
+    {
+        PrintMessage(Error, "Unable to open shader manifest \"{}\"", filename);
+        return false;
+    }
+    file << "# file entry target defines...\n";
+    for (const string& line : lines) file << line << '\n';
+
+    if (!file.good())
+    {
+        PrintMessage(Error, "Failed to write shader manifest \"{}\"", filename);
+        return false;
+    }
+    PrintMessage(Info, "Wrote {} shaders to \"{}\"", lines.size(), filename);
+    return true;
+}
+
+bool ShaderPermutations::Precompile(const string& filename)
+{
+    PROFILE_FUNCTION();
+    ifstream file(filename);
+    if (!file)
+    {
+        PrintMessage(Error, "Unable to open shader manifest \"{}\"", filename);
+        return false;
+    }
+    if (!ShaderCache::Get().IsEnabled())
+    {
+        PrintMessage(Warning, "The shader cache is off, so precompiled shaders will not be kept");
+    }
+
+    vector<ShaderCompileRequest> requests;
+    vector<unique_ptr<Shader>> shaders;
+    string line;
+    while (getline(file, line))
+    {
+        istringstream fields(line);
+        ShaderCompileRequest request = {};
+        if (!(fields >> request.filename) || request.filename[0] == '#') continue;
+        if (!(fields >> request.entry >> request.target))
+        {
+            PrintMessage(Warning, "Skipping incomplete shader manifest line \"{}\"", line);
+            continue;
+        }
+        for (string define; fields >> define;) request.defines.push_back(define);
+
+        shaders.push_back(make_unique<Shader>());
+        request.pShader = shaders.back().get();
+        requests.push_back(move(request));
+    }
+
+    const auto start = chrono::steady_clock::now();
+    vector<future<HRESULT>> compiles = Shader::CompileBatch(requests);
+    uint failures = 0;
+    for (future<HRESULT>& compile : compiles)
+    {
+        if (FAILED(WaitForCompile(compile))) failures++;
+    }
+    const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+    PrintMessage(failures > 0 ? Warning : Info, "Precompiled {} shaders from \"{}\" in {:.1f}ms ({} failed)",
+                 requests.size(), filename, ms, failures);
+    return failures == 0;
+}
+
+
+//**********************************************************************************************************************
+//                                                  Compiling Variants
+//**********************************************************************************************************************
+vector<ShaderCompileRequest> ShaderPermutations::GetRequests(ShaderPermutationKey key, const Variant& variant) const
+{
+    const vector<string> defines = GetDefines(key);
+    vector<ShaderCompileRequest> requests;
+    for (size_t i = 0; i < m_stages.size(); ++i)
+    {
+        const ShaderStageDesc& stage = m_stages[i];
+        requests.push_back({variant.shaders[i].get(), stage.filename, stage.entry, stage.target, defines});
+    }
+    return requests;
+}
+
+ShaderPermutations::Entry& ShaderPermutations::StartCompile(ShaderPermutationKey key)
+{
+    unique_ptr<Entry> pEntry = make_unique<Entry>();
+    for (size_t i = 0; i < m_stages.size(); ++i) pEntry->variant.shaders.push_back(make_shared<Shader>());
+    pEntry->variant.revision = 0;
+    pEntry->state = VariantCompiling;
+    pEntry->watch = 0;
+    pEntry->compiles = Shader::CompileBatch(GetRequests(key, pEntry->variant));
+
+    lock_guard<mutex> lock(m_mutex);
+    Entry& entry = *pEntry;
+    m_variants[key] = move(pEntry);
+    return entry;
+}
+
+void ShaderPermutations::Update(ShaderPermutationKey key, Entry& entry)
+{
+    // a compile in flight is only looked in on, never waited for
+    if (entry.state == VariantCompiling)
+    {
+        for (future<HRESULT>& compile : entry.compiles)
+        {
+            if (compile.wait_for(chrono::seconds(0)) != future_status::ready) return;
+        }
+
+        // watched even if it failed, so that the edit fixing it makes it ready
+        const HRESULT result = WaitForCompiles(entry.compiles);
+        entry.state = SUCCEEDED(result) ? VariantReady : VariantFailed;
+        entry.watch = ShaderWatcher::Get().Watch(GetRequests(key, entry.variant));
+        if (FAILED(result))
+        {
+            LOG_WARNING("Shader variant {:#x} of {} failed to compile, so the fallback stands in for it", key,
+                        m_stages[0].filename);
+        }
+    }
+
+    // stages which were not recompiled keep their shaders, which failed ones have no bytecode in
+    vector<shared_ptr<Shader>> shaders;
+    if (entry.watch == 0 || !ShaderWatcher::Get().TakeReload(entry.watch, shaders)) return;
+    bool complete = true;
+    for (size_t i = 0; i < shaders.size(); ++i)
+    {
+        if (shaders[i] != nullptr) entry.variant.shaders[i] = move(shaders[i]);
+        complete = complete && entry.variant.shaders[i]->GetBlob() != nullptr;
+    }
+    entry.variant.revision++;
+    entry.state = complete ? VariantReady : VariantFailed;
+}
@@ -0,0 +1,94 @@
+// ShaderPermutations - Variants of a program's shaders, selected by feature keywords and compiled on first use.
+//
+// A program, such as a vertex and pixel shader pair, declares the keywords its source tests with #if. Every stage is
+//  compiled with each keyword defined, as 1 when set and 0 when not, and a permutation key is a bitmask with bit i set
+//  for the i-th keyword declared. Only the fallback variant, with no keywords set, is compiled up front. Any other is
+//  compiled on the job system the first time it is requested, and the fallback stands in until it is ready, so features
+//  cost nothing until used however many combinations they make. Each variant is watched for hot reload as a whole.
+//
+// Every variant requested is recorded, and WriteManifest() lists those of every program as a precompile manifest, with
+//  one compile per line: the file, entry point and target, then the defines. Precompile() compiles a manifest into the
+//  shader cache, so that a run afterwards finds every variant the recorded one used ready from the first frame.
+#pragma once
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Shader.h"
+
+
+typedef uint32 ShaderPermutationKey;
+
+// one stage of a program
+struct ShaderStageDesc
+{
+    std::string     filename;
+    std::string     entry;
+    std::string     target;
+};
+
+
+class ShaderPermutations
+{
+public:
+    static constexpr uint MaxKeywords = 32;
+
+    struct Variant
+    {
+        std::vector<std::shared_ptr<Shader>>    shaders;    // per stage, in the order declared
+        uint                                    revision;   // counts hot reloads, for what is built from the shaders
+    };
+
+    ShaderPermutations();
+    ~ShaderPermutations();                  // waits for compiles in flight
+
+    ShaderPermutations(const ShaderPermutations&) = delete;
+    ShaderPermutations& operator=(const ShaderPermutations&) = delete;
+
+    // Declares the program and compiles its fallback before returning, failing as that does.
+    HRESULT Init(const std::vector<ShaderStageDesc>& stages, const std::vector<std::string>& keywords);
+
+    ShaderPermutationKey GetKeywordMask(std::string_view keyword) const;    // zero if not declared
+    std::vector<std::string> GetDefines(ShaderPermutationKey key) const;
+
+    // The variant if compiled, or else null, its compile being started by the first request. A variant which failed to
+    //  compile stays null until an edit fixes it. Both switch to shaders hot reloaded since the last call, and variants
+    //  stay at the same address for the life of the program. Called from one thread, the one rendering.
+    const Variant* Request(ShaderPermutationKey key);
+    const Variant& GetFallback();
+
+    static bool WriteManifest(const std::string& filename);    // of every program's requested variants
+    static bool Precompile(const std::string& filename);       // false if any compile failed
+
+private:
+    enum VariantState
+    {
+        VariantCompiling,
+        VariantReady,
+        VariantFailed,
+    };
+
+    struct Entry
+    {
+        Variant                             variant;
+        VariantState                        state;
+        std::vector<std::future<HRESULT>>   compiles;   // per stage, while compiling
+        uint                                watch;      // zero if not hot reloading
+    };
+
+    std::vector<ShaderCompileRequest> GetRequests(ShaderPermutationKey key, const Variant& variant) const;
+    Entry& StartCompile(ShaderPermutationKey key);
+    void Update(ShaderPermutationKey key, Entry& entry);
+
+    std::vector<ShaderStageDesc>                                        m_stages;
+    std::vector<std::string>                                            m_keywords;
+    ShaderPermutationKey                                                m_keyMask;      // of every keyword declared
+
+    mutable std::mutex                                                  m_mutex;        // for manifests
+    std::unordered_map<ShaderPermutationKey, std::unique_ptr<Entry>>    m_variants;
+};
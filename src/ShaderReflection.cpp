@@ -0,0 +1,238 @@
+#include "ShaderReflection.h"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cstring>
+#include <map>
+
+#if defined(_WIN32)
+#include <d3d12shader.h>
+#else
+#include <directx/d3d12shader.h>
+#endif
+
+#include "Profiler.h"
+#include "RenderEngine.h"
+
+using namespace std;
+
+
+namespace
+{
+    // the stages a root signature can deny access to, and the visibility of parameters bound to them
+    struct StageAccess
+    {
+        uint                        stageType;
+        D3D12_SHADER_VISIBILITY     visibility;
+        D3D12_ROOT_SIGNATURE_FLAGS  denyFlag;
+    };
+
+    const StageAccess StageAccesses[] =
+    {
+        {D3D12_SHVER_VERTEX_SHADER,   D3D12_SHADER_VISIBILITY_VERTEX,   D3D12_ROOT_SIGNATURE_FLAG_DENY_VERTEX_SHADER_ROOT_ACCESS},
+        {D3D12_SHVER_HULL_SHADER,     D3D12_SHADER_VISIBILITY_HULL,     D3D12_ROOT_SIGNATURE_FLAG_DENY_HULL_SHADER_ROOT_ACCESS},
+        {D3D12_SHVER_DOMAIN_SHADER,   D3D12_SHADER_VISIBILITY_DOMAIN,   D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS},
+        {D3D12_SHVER_GEOMETRY_SHADER, D3D12_SHADER_VISIBILITY_GEOMETRY, D3D12_ROOT_SIGNATURE_FLAG_DENY_GEOMETRY_SHADER_ROOT_ACCESS},
+        {D3D12_SHVER_PIXEL_SHADER,    D3D12_SHADER_VISIBILITY_PIXEL,    D3D12_ROOT_SIGNATURE_FLAG_DENY_PIXEL_SHADER_ROOT_ACCESS},
+    };
+
+    D3D12_SHADER_VISIBILITY VisibilityOf(uint stageType)
+    {
+        for (const StageAccess& access : StageAccesses)
+        {
+            if (access.stageType == stageType) return access.visibility;
+        }
+        return D3D12_SHADER_VISIBILITY_ALL;
+    }
+
+    D3D12_DESCRIPTOR_RANGE_TYPE RangeTypeOf(D3D_SHADER_INPUT_TYPE type)
+    {
+        switch (type)
+        {
+        case D3D_SIT_CBUFFER:                   return D3D12_DESCRIPTOR_RANGE_TYPE_CBV;
+        case D3D_SIT_SAMPLER:                   return D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER;
+        case D3D_SIT_TBUFFER:
+        case D3D_SIT_TEXTURE:
+        case D3D_SIT_STRUCTURED:
+        case D3D_SIT_BYTEADDRESS:
+        case D3D_SIT_RTACCELERATIONSTRUCTURE:   return D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+        default:                                return D3D12_DESCRIPTOR_RANGE_TYPE_UAV;
+        }
+    }
+
+    // HLSL semantics are case-insensitive
+    bool SameSemantic(const string& name, const char* pStreamName)
+    {
+        const auto sameLetter = [](char a, char b) {return toupper(a) == toupper(b);};
+        return equal(name.begin(), name.end(), pStreamName, pStreamName + strlen(pStreamName), sameLetter);
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                      Reflection
+//**********************************************************************************************************************
+HRESULT ShaderReflection::Reflect(const vector<shared_ptr<Shader>>& shaders)
+{
+    PROFILE_FUNCTION();
+    m_bindings.clear();
+    m_vertexInputs.clear();
+    m_stages = 0;
+
+    ShaderCompilerPool::Lease compiler = ShaderCompilerPool::Get().Acquire();
+    if (!compiler.IsValid()) return E_FAIL;
+
+    for (const shared_ptr<Shader>& pShader : shaders)
+    {
+        ID3DBlob* pBlob = pShader->GetReflectionBlob();
+        if (pBlob == nullptr) return E_FAIL;
+
+        const DxcBuffer buffer = {pBlob->GetBufferPointer(), pBlob->GetBufferSize(), 0};
+        ComPtr<ID3D12ShaderReflection> pReflection;
+        D3D12_SHADER_DESC desc = {};
+        HRESULT result = compiler->pUtils->CreateReflection(&buffer, IID_PPV_ARGS(&pReflection));
+        if (SUCCEEDED(result)) result = pReflection->GetDesc(&desc);
+        if (FAILED(result)) return result;
+
+        const uint stageType = D3D12_SHVER_GET_TYPE(desc.Version);
+        const D3D12_SHADER_VISIBILITY visibility = VisibilityOf(stageType);
+        m_stages |= 1u << stageType;
+
+        for (uint i = 0; i < desc.BoundResources; ++i)
+        {
+            D3D12_SHADER_INPUT_BIND_DESC bindDesc = {};
+            if (FAILED(pReflection->GetResourceBindingDesc(i, &bindDesc))) return E_FAIL;
+
+            // a resource bound by several stages is one binding, visible to all of them
+            const auto sameResource = [&bindDesc](const ShaderBinding& binding)
+            {
+                return binding.type == bindDesc.Type && binding.shaderRegister == bindDesc.BindPoint &&
+                       binding.registerSpace == bindDesc.Space;
+            };
+            auto found = find_if(m_bindings.begin(), m_bindings.end(), sameResource);
+            if (found != m_bindings.end())
+            {
+                if (found->visibility != visibility) found->visibility = D3D12_SHADER_VISIBILITY_ALL;
+                continue;
+            }
+
+            ShaderBinding binding = {bindDesc.Name, bindDesc.Type, bindDesc.BindPoint, bindDesc.Space,
+                                     bindDesc.BindCount, 0, visibility};
+            D3D12_SHADER_BUFFER_DESC bufferDesc = {};
+            if (bindDesc.Type == D3D_SIT_CBUFFER &&
+                SUCCEEDED(pReflection->GetConstantBufferByName(bindDesc.Name)->GetDesc(&bufferDesc)))
+            {
+                binding.size = bufferDesc.Size;
+            }
+            m_bindings.push_back(binding);
+        }
+
+        if (stageType != D3D12_SHVER_VERTEX_SHADER) continue;
+        for (uint i = 0; i < desc.InputParameters; ++i)
+        {
+            D3D12_SIGNATURE_PARAMETER_DESC parameter = {};
+            if (FAILED(pReflection->GetInputParameterDesc(i, &parameter))) return E_FAIL;
+            if (parameter.SystemValueType != D3D_NAME_UNDEFINED) continue;
+
+            m_vertexInputs.push_back({parameter.SemanticName, parameter.SemanticIndex, parameter.ReadWriteMask != 0});
+        }
+    }
+    return S_OK;
+}
+
+
+//**********************************************************************************************************************
+//                                                  Derived Layouts
+//**********************************************************************************************************************
+HRESULT ShaderReflection::CreateRootSignature(bool allowRootConstants, ComPtr<ID3D12RootSignature>& pRootSignature,
+                                              vector<ShaderRootParameter>& parameters) const
+{
+    PROFILE_FUNCTION();
+
+    // Parameters are ordered by how often they change, root constants first and tables last, as drivers keep the
+    //  start of a root signature in registers and may spill the rest to memory.
+    vector<CD3DX12_ROOT_PARAMETER1> rootParameters;
+    vector<const ShaderBinding*> rootDescriptors;
+    map<pair<D3D12_SHADER_VISIBILITY, bool>, vector<CD3DX12_DESCRIPTOR_RANGE1>> tables;    // by stage and samplers
+    map<pair<D3D12_SHADER_VISIBILITY, bool>, string> tableNames;
+    parameters.clear();
+
+    for (const ShaderBinding& binding : m_bindings)
+    {
+        const uint num32BitValues = binding.size / sizeof(uint32);
+        if (binding.type == D3D_SIT_CBUFFER && binding.count == 1)
+        {
+            if (!allowRootConstants || num32BitValues > MaxRootConstants)
+            {
+                rootDescriptors.push_back(&binding);
+                continue;
+            }
+            rootParameters.emplace_back().InitAsConstants(num32BitValues, binding.shaderRegister, binding.registerSpace,
+                                                          binding.visibility);
+            parameters.push_back({binding.name, D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS, num32BitValues});
+            continue;
+        }
+
+        const D3D12_DESCRIPTOR_RANGE_TYPE rangeType = RangeTypeOf(binding.type);
+        const auto table = make_pair(binding.visibility, rangeType == D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER);
+        const uint count = (binding.count != 0) ? binding.count : UINT_MAX;
+        tables[table].emplace_back().Init(rangeType, count, binding.shaderRegister, binding.registerSpace);
+        tableNames.try_emplace(table, binding.name);
+    }
+
+    for (const ShaderBinding* pBinding : rootDescriptors)
+    {
+        rootParameters.emplace_back().InitAsConstantBufferView(pBinding->shaderRegister, pBinding->registerSpace,
+                                                               D3D12_ROOT_DESCRIPTOR_FLAG_NONE, pBinding->visibility);
+        parameters.push_back({pBinding->name, D3D12_ROOT_PARAMETER_TYPE_CBV, 0});
+    }
+    for (const auto& [table, ranges] : tables)
+    {
+        const uint rangeCount = static_cast<uint>(ranges.size());
+        rootParameters.emplace_back().InitAsDescriptorTable(rangeCount, ranges.data(), table.first);
+        parameters.push_back({tableNames[table], D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE, 0});
+    }
+
+    // stages which bind nothing are denied root access, which spares the driver from passing them root arguments
+    uint visibilities = 0;
+    for (const CD3DX12_ROOT_PARAMETER1& parameter : rootParameters) visibilities |= 1u << parameter.ShaderVisibility;
+    D3D12_ROOT_SIGNATURE_FLAGS flags = D3D12_ROOT_SIGNATURE_FLAG_NONE;
+    if (!m_vertexInputs.empty()) flags |= D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+    for (const StageAccess& access : StageAccesses)
+    {
+        const bool present = (m_stages >> access.stageType) & 1;
+        const uint visibleTo = (1u << D3D12_SHADER_VISIBILITY_ALL) | (1u << access.visibility);
+        if (!present || (visibilities & visibleTo) == 0) flags |= access.denyFlag;
+    }
+
+    CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC desc;
+    desc.Init_1_1(static_cast<uint>(rootParameters.size()), rootParameters.data(), 0, nullptr, flags);
+    return RenderEngine::pCurrentEngine->CreateRootSignature(&desc, &pRootSignature);
+}
+
+HRESULT ShaderReflection::GetInputLayout(vector<D3D12_INPUT_ELEMENT_DESC>& elements, uint& streams) const
+{
+    elements.clear();
+    streams = 0;
+    for (const ShaderVertexInput& input : m_vertexInputs)
+    {
+        uint stream = 0;
+        while (stream < VertexStreamCount && !SameSemantic(input.semanticName, VertexStreamInfos[stream].pSemanticName))
+        {
+            stream++;
+        }
+        if (stream == VertexStreamCount || input.semanticIndex != 0)
+        {
+            LOG_ERROR("Vertex shader input {}{} is not a stream meshes provide", input.semanticName,
+                      input.semanticIndex);
+            return E_INVALIDARG;
+        }
+
+        const VertexStreamInfo& info = VertexStreamInfos[stream];
+        const D3D12_INPUT_CLASSIFICATION perVertex = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA;
+        elements.push_back({info.pSemanticName, 0, info.format, stream, 0, perVertex, 0});
+        if (input.read) streams |= 1u << stream;
+    }
+    return S_OK;
+}
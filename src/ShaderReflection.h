@@ -0,0 +1,77 @@
+// ShaderReflection - What a program's shaders bind and read, as DXC reports it, and the root signature and input layout
+//  derived from that.
+//
+// A program's root signature is built from the resources its stages still use once compiled, rather than written by
+//  hand to match the HLSL, so one which a permutation compiles out costs nothing. Constant buffers of no more than
+//  MaxRootConstants DWORDs become root constants, set along with each draw without a buffer behind them, and larger
+//  ones root CBVs. Every other resource is packed into a descriptor table per stage, with samplers in tables of their
+//  own as D3D requires. Stages which bind nothing are denied root access.
+//
+// The input layout reads each vertex shader input from the mesh stream of the same semantic, in the format that stream
+//  is uploaded in, so that shaders are free to declare positions as float4. Inputs which the shader declares but never
+//  reads stay in the layout, as D3D requires, but their streams are left out of those the program reads, and so need
+//  not be uploaded or bound.
+//
+// Reflection comes with DXIL only, so shaders compiled to SPIR-V carry that of a DXIL compile of the same source.
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+#include "Shader.h"
+
+
+// a resource bound by one or more of a program's stages
+struct ShaderBinding
+{
+    std::string                 name;
+    D3D_SHADER_INPUT_TYPE       type;
+    uint                        shaderRegister;
+    uint                        registerSpace;
+    uint                        count;              // of an array, or zero if unbounded
+    uint                        size;               // in bytes, of constant buffers
+    D3D12_SHADER_VISIBILITY     visibility;         // ALL if bound by more than one stage
+};
+
+// a vertex shader input, which is not a system value
+struct ShaderVertexInput
+{
+    std::string                 semanticName;
+    uint                        semanticIndex;
+    bool                        read;               // false if declared but unused
+};
+
+// what was made of a binding in a derived root signature, with the parameters in root signature order
+struct ShaderRootParameter
+{
+    std::string                 name;               // of the constant buffer, or of a table's first resource
+    D3D12_ROOT_PARAMETER_TYPE   type;
+    uint                        num32BitValues;     // of root constants
+};
+
+
+class ShaderReflection
+{
+public:
+    static constexpr uint MaxRootConstants = 16;    // DWORDs, which is a matrix
+
+    // Merges the reflection of every stage, failing if any stage has none.
+    HRESULT Reflect(const std::vector<std::shared_ptr<Shader>>& shaders);
+
+    const std::vector<ShaderBinding>& GetBindings() const           {return m_bindings;}
+    const std::vector<ShaderVertexInput>& GetVertexInputs() const   {return m_vertexInputs;}
+
+    // Without root constants every constant buffer is a root CBV, which SPIR-V needs as it makes them uniform buffers.
+    HRESULT CreateRootSignature(bool allowRootConstants, ComPtr<ID3D12RootSignature>& pRootSignature,
+                                std::vector<ShaderRootParameter>& parameters) const;
+
+    // Fails for an input with a semantic no mesh stream provides. Streams is set to the mask of those read.
+    HRESULT GetInputLayout(std::vector<D3D12_INPUT_ELEMENT_DESC>& elements, uint& streams) const;
+
+private:
+    std::vector<ShaderBinding>      m_bindings;
+    std::vector<ShaderVertexInput>  m_vertexInputs;
+    uint                            m_stages;       // mask of the D3D12_SHVER_*_SHADER types reflected
+};
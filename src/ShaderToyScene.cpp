@@ -1,37 +1,49 @@
 #include "ShaderToyScene.h"
 
+#include "TaskGraph.h"
 #include "Widgets.h"
 #include <imgui_internal.h>
 
 ShaderToyScene::ShaderToyScene(std::wstring name) :
     m_name(name),
-    m_constantBufferData({})
+    m_constantBufferData({}),
+    m_visualizeDepth(false),
+    m_nodeGraphShading(false)
 {
 }
 ShaderToyScene::~ShaderToyScene()
 {
 }
 
-void ShaderToyScene::Init(Dx12RenderEngine* pEngine)
+void ShaderToyScene::Init(RenderEngine* pEngine)
 {
     m_pEngine = pEngine;
 
+    // the pipeline comes first, as meshes are uploaded with only the vertex streams its shaders read
+    // TODO: actually use PipelineCreateInfo...
+    PipelineCreateInfo pipelineCreateInfo = {};
+    m_pipelineState.Init(pipelineCreateInfo);
+
     m_geometryManager.Init();
+    m_geometryManager.SetVertexStreams(m_pipelineState.GetVertexStreams());
     uint teapotID = m_geometryManager.AddMesh("./media/rotated_teapot.ply");
     uint cubeID = m_geometryManager.AddMesh("./media/colored_cube.ply");
 
     m_camera.SetPosition({0, 5, -45});
     m_camera.SetDirection({0, 0, 1});
 
-    // TODO: actually use PipelineCreateInfo...
-    PipelineCreateInfo pipelineCreateInfo = {};
-    m_pipelineState.Init(pipelineCreateInfo);
     m_pipelineState.RegisterGeometryManager(&m_geometryManager);
     m_pipelineState.SetConstantBufferData({&m_constantBufferData, sizeof(m_constantBufferData)});
     m_pipelineState.SetClearColor(m_clearColor);
 
     m_viewportForRtv.Init("RTV Viewport", m_pipelineState.GetRenderTarget());
     m_viewportForDepth.Init("Depth Viewport", m_pipelineState.GetDepthStencil());
+
+    // the graph as last saved, which the editor then saves back to as it's edited
+    m_nodeEditor.SetGraphFile("node_graph.bin");
+
+    // the graph is compiled into a file which shaders.hlsl includes, for the watcher to recompile it when edited
+    m_nodeEditor.SetOutputFile("src/node_graph.hlsl");
 }
 
 void ShaderToyScene::BuildUI()
@@ -69,6 +81,21 @@ void ShaderToyScene::BuildUI()
             m_pipelineState.SetReverseDepth(m_reverseDepth);
         }
 
+        // a shader permutation, rendered with the fallback for the moment it takes to compile
+        if (ImGui::Checkbox("Visualize Depth", &m_visualizeDepth))
+        {
+            m_pipelineState.SetShaderKeyword("VISUALIZE_DEPTH", m_visualizeDepth);
+        }
+        if (ImGui::Checkbox("Node Graph Shading", &m_nodeGraphShading))
+        {
+            m_pipelineState.SetShaderKeyword("NODE_GRAPH", m_nodeGraphShading);
+        }
+        if (m_pipelineState.IsUsingFallbackShaders())
+        {
+            ImGui::SameLine();
+            ImGui::TextDisabled("(compiling)");
+        }
+
         ImGui::End();
     }
 
@@ -122,6 +149,37 @@ void ShaderToyScene::BuildUI()
     m_viewportForDepth.DrawUI();
 }
 
+void ShaderToyScene::AddTasks(TaskGraph& graph)
+{
+    graph.AddTask("Camera", [this] {OnUpdate();})
+        .Writes(&m_camera)
+        .Writes(&m_constantBufferData)
+        .Measures(FrameStatUpdateTime);
+
+    m_geometryManager.AddTasks(graph, &m_camera);
+
+    graph.AddTask("Scene::OnRender", [this] {OnRender();})
+        .Reads(&m_constantBufferData)
+        .Reads(m_geometryManager.GetDrawables())
+        .Reads(m_geometryManager.GetDrawOrder())
+        .Writes(&m_pipelineState)
+        .Writes(m_pEngine)
+        .Measures(FrameStatRenderTime);
+}
+
+void ShaderToyScene::AddUiTasks(TaskGraph& graph)
+{
+    // the UI edits the camera, the drawables' transforms and the pipeline's shaders directly
+    graph.AddTask("Scene::BuildUI", [this] {BuildUI();})
+        .Writes(this)
+        .Writes(&m_camera)
+        .Writes(m_geometryManager.GetDrawables())
+        .Writes(&m_pipelineState)
+        .Writes(m_pEngine)
+        .Writes(ImGui::GetCurrentContext())
+        .Measures(FrameStatUiTime);
+}
+
 void ShaderToyScene::OnUpdate()
 {
     m_camera.Update();
@@ -15,11 +15,14 @@ public:
     ShaderToyScene(std::wstring name);
     ~ShaderToyScene();
 
-    void Init(Dx12RenderEngine* pEngine);
+    void Init(RenderEngine* pEngine);
     void BuildUI();
     void OnUpdate();
     void OnRender();
 
+    void AddTasks(TaskGraph& graph);
+    void AddUiTasks(TaskGraph& graph);
+
 private:
     struct SceneConstantBuffer
     {
@@ -28,7 +31,7 @@ private:
     };
 
     // components
-    Dx12RenderEngine*                   m_pEngine;
+    RenderEngine*                       m_pEngine;
     GeometryManager                     m_geometryManager;
     PipelineState                       m_pipelineState;
     Camera                              m_camera;
@@ -41,4 +44,6 @@ private:
     float                               m_clearColor[4] = {0.0f, 0.2f, 0.4f, 1.0f};
     SceneConstantBuffer                 m_constantBufferData;
     bool                                m_reverseDepth;
+    bool                                m_visualizeDepth;
+    bool                                m_nodeGraphShading;
 };
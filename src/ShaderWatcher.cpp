@@ -0,0 +1,364 @@
+#include "ShaderWatcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+
+#if !defined(_WIN32)
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "ShaderCache.h"
+
+using namespace std;
+
+
+namespace
+{
+    // how long the thread blocks at a time, which bounds how long exiting or ReloadAll() take to be noticed
+    constexpr uint WakeIntervalMs = 50;
+
+    bool DependsOn(const vector<filesystem::path>& dependencies, const vector<filesystem::path>& changed)
+    {
+        for (const filesystem::path& path : changed)
+        {
+            if (find(dependencies.begin(), dependencies.end(), path) != dependencies.end()) return true;
+        }
+        return false;
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                              Constructors & Destructors
+//**********************************************************************************************************************
+ShaderWatcher::ShaderWatcher() :
+    m_nextId(1),
+    m_enabled(false),
+    m_exiting(false),
+    m_reloadAll(false),
+    m_filesChanged(false),
+    m_notifyHandle(-1)
+{
+    // what the thread compiles with is created first, and so destroyed only after the thread has been joined
+    JobSystem::Get();
+    ShaderCompilerPool::Get();
+    ShaderCache::Get();
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+    m_exiting = true;
+    if (m_thread.joinable()) m_thread.join();
+#if !defined(_WIN32)
+    if (m_notifyHandle >= 0) close(m_notifyHandle);
+#endif
+}
+
+ShaderWatcher& ShaderWatcher::Get()
+{
+    static ShaderWatcher watcher;
+    return watcher;
+}
+
+
+//**********************************************************************************************************************
+//                                                  Primary Interfaces
+//**********************************************************************************************************************
+uint ShaderWatcher::Watch(const vector<ShaderCompileRequest>& requests)
+{
+    if (!m_enabled || requests.empty()) return 0;
+
+    lock_guard<mutex> lock(m_mutex);
+    const uint id = m_nextId++;
+    WatchedShaders& watched = m_watches[id];
+    for (const ShaderCompileRequest& request : requests)
+    {
+        watched.dependencies.push_back(request.pShader->GetDependencies());
+        watched.requests.push_back(request);
+        watched.requests.back().pShader = nullptr;
+    }
+    watched.hasPending = false;
+
+    m_filesChanged = true;
+    if (!m_thread.joinable()) Start();
+    return id;
+}
+
+void ShaderWatcher::Unwatch(uint id)
+{
+    lock_guard<mutex> lock(m_mutex);
+    m_watches.erase(id);
+}
+
+bool ShaderWatcher::TakeReload(uint id, vector<shared_ptr<Shader>>& shaders)
+{
+    lock_guard<mutex> lock(m_mutex);
+    auto watched = m_watches.find(id);
+    if (watched == m_watches.end() || !watched->second.hasPending) return false;
+
+    shaders = move(watched->second.pending);
+    watched->second.pending.clear();
+    watched->second.hasPending = false;
+    return true;
+}
+
+void ShaderWatcher::ReloadAll()
+{
+    m_reloadAll = true;
+}
+
+
+//**********************************************************************************************************************
+//                                                  Watching Thread
+//**********************************************************************************************************************
+void ShaderWatcher::Start()
+{
+#if !defined(_WIN32)
+    m_notifyHandle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_notifyHandle < 0) LOG_WARNING("inotify is unavailable, so shader files will be polled for changes");
+#endif
+    m_thread = thread(&ShaderWatcher::ThreadLoop, this);
+}
+
+void ShaderWatcher::ThreadLoop()
+{
+    PROFILE_THREAD("Shader Watcher");
+
+    while (!m_exiting)
+    {
+        vector<filesystem::path> changed;
+        WaitForChanges(changed);
+
+        const bool all = m_reloadAll.exchange(false);
+        if (!changed.empty() || all) Recompile(changed, all);
+    }
+}
+
+void ShaderWatcher::WaitForChanges(vector<filesystem::path>& changed)
+{
+    if (m_notifyHandle >= 0)
+    {
+        if (m_filesChanged.exchange(false)) UpdateNotifications();
+        WaitForNotifications(changed);
+    }
+    else
+    {
+        PollFiles(changed);
+    }
+
+    sort(changed.begin(), changed.end());
+    changed.erase(unique(changed.begin(), changed.end()), changed.end());
+}
+
+void ShaderWatcher::UpdateNotifications()
+{
+#if !defined(_WIN32)
+    // Directories are watched rather than files, as editors often save by writing a new file and renaming it over the
+    //  old one, which would end a watch on the file itself. Watches are kept once added, for the rare directory which
+    //  no shader needs any more.
+    vector<filesystem::path> directories;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        for (const auto& [id, watched] : m_watches)
+        {
+            for (const vector<filesystem::path>& dependencies : watched.dependencies)
+            {
+                for (const filesystem::path& path : dependencies) directories.push_back(path.parent_path());
+            }
+        }
+    }
+    sort(directories.begin(), directories.end());
+    directories.erase(unique(directories.begin(), directories.end()), directories.end());
+
+    for (const filesystem::path& directory : directories)
+    {
+        const auto isWatched = [&directory](const auto& watch) {return watch.second == directory;};
+        if (any_of(m_watchedDirectories.begin(), m_watchedDirectories.end(), isWatched)) continue;
+
+        const uint32_t events = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+        const int watch = inotify_add_watch(m_notifyHandle, directory.c_str(), events);
+        if (watch < 0)
+        {
+            LOG_WARNING("Shader directory {} cannot be watched for changes", PathToUtf8(directory));
+            continue;
+        }
+        m_watchedDirectories[watch] = directory;
+    }
+#endif
+}
+
+void ShaderWatcher::WaitForNotifications(vector<filesystem::path>& changed)
+{
+#if !defined(_WIN32)
+    pollfd descriptor = {m_notifyHandle, POLLIN, 0};
+    if (poll(&descriptor, 1, WakeIntervalMs) <= 0) return;
+
+    // then keep reading until the burst of events from a save has settled
+    alignas(inotify_event) char buffer[4096];
+    do
+    {
+        ssize_t length;
+        while ((length = read(m_notifyHandle, buffer, sizeof(buffer))) > 0)
+        {
+            for (const char* pEvent = buffer; pEvent < buffer + length;)
+            {
+                const inotify_event* pNotification = reinterpret_cast<const inotify_event*>(pEvent);
+                pEvent += sizeof(inotify_event) + pNotification->len;
+
+                auto directory = m_watchedDirectories.find(pNotification->wd);
+                if (directory == m_watchedDirectories.end() || pNotification->len == 0) continue;
+                error_code error;
+                changed.push_back(filesystem::weakly_canonical(directory->second / pNotification->name, error));
+            }
+        }
+    } while (poll(&descriptor, 1, SettleMs) > 0);
+#endif
+}
+
+void ShaderWatcher::PollFiles(vector<filesystem::path>& changed)
+{
+    // files newly watched are recorded straight away, so that an edit made before the next interval is not missed
+    const bool filesChanged = m_filesChanged.exchange(false);
+    for (uint waited = 0; waited < PollIntervalMs && !filesChanged && !m_exiting && !m_reloadAll;)
+    {
+        this_thread::sleep_for(chrono::milliseconds(WakeIntervalMs));
+        waited += WakeIntervalMs;
+    }
+
+    vector<filesystem::path> files;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        for (const auto& [id, watched] : m_watches)
+        {
+            for (const vector<filesystem::path>& dependencies : watched.dependencies)
+            {
+                files.insert(files.end(), dependencies.begin(), dependencies.end());
+            }
+        }
+    }
+
+    // a file first seen is only recorded, and one which cannot be read is most likely being saved
+    const auto checkFiles = [this, &files, &changed]
+    {
+        for (const filesystem::path& file : files)
+        {
+            error_code error;
+            const filesystem::file_time_type time = filesystem::last_write_time(file, error);
+            if (error) continue;
+
+            auto [recorded, inserted] = m_fileTimes.try_emplace(file.string(), time);
+            if (!inserted && recorded->second != time)
+            {
+                recorded->second = time;
+                changed.push_back(file);
+            }
+        }
+    };
+    checkFiles();
+    if (changed.empty()) return;
+
+    // changes still being written are taken in with these, rather than triggering another reload
+    this_thread::sleep_for(chrono::milliseconds(SettleMs));
+    checkFiles();
+}
+
+void ShaderWatcher::Recompile(const vector<filesystem::path>& changed, bool all)
+{
+    PROFILE_FUNCTION();
+    const auto start = chrono::steady_clock::now();
+
+    // the shaders depending on what changed, copied out so that they compile without holding the lock
+    struct Reload
+    {
+        uint                        id;
+        vector<size_t>              indices;
+        vector<shared_ptr<Shader>>  shaders;
+    };
+    vector<Reload> reloads;
+    vector<ShaderCompileRequest> requests;
+    {
+        lock_guard<mutex> lock(m_mutex);
+        for (const auto& [id, watched] : m_watches)
+        {
+            Reload reload = {id};
+            for (size_t i = 0; i < watched.requests.size(); ++i)
+            {
+                if (!all && !DependsOn(watched.dependencies[i], changed)) continue;
+
+                shared_ptr<Shader> pShader = make_shared<Shader>();
+                requests.push_back(watched.requests[i]);
+                requests.back().pShader = pShader.get();
+                reload.indices.push_back(i);
+                reload.shaders.push_back(move(pShader));
+            }
+            if (!reload.indices.empty()) reloads.push_back(move(reload));
+        }
+    }
+    if (requests.empty()) return;
+
+    vector<future<HRESULT>> futures = Shader::CompileBatch(requests);
+    vector<HRESULT> results;
+    for (future<HRESULT>& result : futures)
+    {
+        try
+        {
+            results.push_back(result.get());
+        }
+        catch (...)
+        {
+            results.push_back(E_FAIL);
+        }
+    }
+
+    // a pipeline only takes its replacements if every one of them compiled
+    lock_guard<mutex> lock(m_mutex);
+    uint failures = 0;
+    size_t next = 0;
+    for (Reload& reload : reloads)
+    {
+        const auto first = results.begin() + next;
+        const auto succeededOne = [](HRESULT result) {return SUCCEEDED(result);};
+        const bool succeeded = all_of(first, first + reload.indices.size(), succeededOne);
+        next += reload.indices.size();
+
+        auto watched = m_watches.find(reload.id);
+        if (watched == m_watches.end()) continue;   // unwatched while compiling
+        WatchedShaders& shaders = watched->second;
+
+        // includes may have been added or removed, and are followed whether or not the shader now compiles
+        for (size_t i = 0; i < reload.indices.size(); ++i)
+        {
+            const vector<filesystem::path>& dependencies = reload.shaders[i]->GetDependencies();
+            if (!dependencies.empty()) shaders.dependencies[reload.indices[i]] = dependencies;
+        }
+
+        if (!succeeded)
+        {
+            failures++;
+            continue;
+        }
+        if (!shaders.hasPending) shaders.pending.assign(shaders.requests.size(), nullptr);
+        for (size_t i = 0; i < reload.indices.size(); ++i)
+        {
+            shaders.pending[reload.indices[i]] = move(reload.shaders[i]);
+        }
+        shaders.hasPending = true;
+    }
+    m_filesChanged = true;
+
+    const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    if (failures == 0)
+    {
+        LOG_INFO("Reloaded {} shaders in {:.1f}ms", requests.size(), ms);
+    }
+    else
+    {
+        LOG_WARNING("{} of {} pipelines keep their previous shaders, as the new ones failed to compile", failures,
+                    reloads.size());
+    }
+}
@@ -0,0 +1,83 @@
+// ShaderWatcher - Hot reloading of shaders whose source, or any file it includes, changes on disk.
+//
+// Pipelines register the shaders they were built from, and a background thread watches every file those shaders were
+//  compiled from: with inotify on Linux, and elsewhere by polling modification times. Once a burst of changes settles,
+//  only the shaders depending on a changed file are compiled again, into new shader objects on the job system, while
+//  rendering carries on with the old ones. A pipeline takes the replacements at the start of its next frame, and only
+//  when every one of them compiled, so an edit which breaks a shader leaves the last working pipeline in place.
+//
+// ReloadAll() recompiles every watched shader whether changed or not, as F5 does in the windowed build.
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "Shader.h"
+
+
+class ShaderWatcher
+{
+public:
+    static constexpr uint PollIntervalMs    = 250;  // between checks of modification times, without inotify
+    static constexpr uint SettleMs          = 30;   // quiet time before compiling, as a save comes as several events
+
+    ShaderWatcher();
+    ~ShaderWatcher();
+
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    static ShaderWatcher& Get();
+
+    // Off until enabled, in which case Watch() registers nothing. The thread is started by the first shaders watched.
+    void SetEnabled(bool enabled)       {m_enabled = enabled;}
+    bool IsEnabled() const              {return m_enabled;}
+
+    // Watches the files each already compiled shader came from, returning the id to take replacements by, or zero
+    //  when disabled. The requests are kept for recompiling, and their shaders are not touched again.
+    uint Watch(const std::vector<ShaderCompileRequest>& requests);
+    void Unwatch(uint id);
+
+    // Replacements compiled since the last call, in the order the shaders were watched, with null for those which were
+    //  not recompiled. False if there are none, which is the common case and takes no more than a lock.
+    bool TakeReload(uint id, std::vector<std::shared_ptr<Shader>>& shaders);
+
+    void ReloadAll();
+
+private:
+    struct WatchedShaders
+    {
+        std::vector<ShaderCompileRequest>                   requests;       // with no shaders
+        std::vector<std::vector<std::filesystem::path>>     dependencies;   // per request
+        std::vector<std::shared_ptr<Shader>>                pending;        // per request, until taken
+        bool                                                hasPending;
+    };
+
+    void Start();
+    void ThreadLoop();
+    void WaitForChanges(std::vector<std::filesystem::path>& changed);
+    void WaitForNotifications(std::vector<std::filesystem::path>& changed);
+    void PollFiles(std::vector<std::filesystem::path>& changed);
+    void UpdateNotifications();
+    void Recompile(const std::vector<std::filesystem::path>& changed, bool all);
+
+    std::mutex                                              m_mutex;
+    std::unordered_map<uint, WatchedShaders>                m_watches;
+    uint                                                    m_nextId;
+    bool                                                    m_enabled;
+
+    std::thread                                             m_thread;
+    std::atomic<bool>                                       m_exiting;
+    std::atomic<bool>                                       m_reloadAll;
+    std::atomic<bool>                                       m_filesChanged;     // the set of files to watch
+
+    // used by the thread only
+    std::unordered_map<std::string, std::filesystem::file_time_type> m_fileTimes;  // when polling
+    int                                                     m_notifyHandle;     // inotify, or -1 when polling
+    std::unordered_map<int, std::filesystem::path>          m_watchedDirectories;   // by inotify watch
+};
@@ -0,0 +1,211 @@
+#include "TaskGraph.h"
+
+#include <algorithm>
+#include <cassert>
+#include <unordered_map>
+
+#include "JobSystem.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
+
+using namespace std;
+
+
+//**********************************************************************************************************************
+//                                              Constructors & Destructors
+//**********************************************************************************************************************
+TaskGraph::TaskGraph() :
+    m_compiled(false),
+    m_pJobSystem(nullptr),
+    m_pRoot(nullptr)
+{
+}
+
+TaskGraph::~TaskGraph()
+{
+}
+
+
+//**********************************************************************************************************************
+//                                                    Construction
+//**********************************************************************************************************************
+TaskGraph::Task& TaskGraph::AddTask(const char* pName, function<void()> function)
+{
+    assert(!m_compiled && "tasks must be added before the graph is compiled");
+
+    Task task;
+    task.m_pName = pName;
+    task.m_function = move(function);
+    task.m_mainThread = false;
+    task.m_stat = FrameStatCount;
+    task.m_index = static_cast<uint>(m_tasks.size());
+    m_tasks.push_back(move(task));
+    return m_tasks.back();
+}
+
+void TaskGraph::Compile()
+{
+    // the tasks which last wrote each piece of data, and those which have read it since
+    struct Access
+    {
+        int             lastWriter = -1;
+        vector<uint>    readers;
+    };
+    unordered_map<const void*, Access> accesses;
+
+    for (Task& task : m_tasks)
+    {
+        vector<uint>& prerequisites = task.m_prerequisites;
+        prerequisites = task.m_after;
+        for (const void* pData : task.m_reads)
+        {
+            const Access& access = accesses[pData];
+            if (access.lastWriter >= 0) prerequisites.push_back(access.lastWriter);
+        }
+        for (const void* pData : task.m_writes)
+        {
+            const Access& access = accesses[pData];
+            if (access.lastWriter >= 0) prerequisites.push_back(access.lastWriter);
+            prerequisites.insert(prerequisites.end(), access.readers.begin(), access.readers.end());
+        }
+
+        // recorded only now, so that a task both reading and writing something does not wait on itself
+        for (const void* pData : task.m_reads) accesses[pData].readers.push_back(task.m_index);
+        for (const void* pData : task.m_writes)
+        {
+            Access& access = accesses[pData];
+            access.lastWriter = task.m_index;
+            access.readers.clear();
+        }
+
+        sort(prerequisites.begin(), prerequisites.end());
+        prerequisites.erase(unique(prerequisites.begin(), prerequisites.end()), prerequisites.end());
+        prerequisites.erase(remove(prerequisites.begin(), prerequisites.end(), task.m_index), prerequisites.end());
+        for (uint prerequisite : prerequisites)
+        {
+            assert(prerequisite < task.m_index && "tasks may only follow tasks declared before them");
+            m_tasks[prerequisite].m_successors.push_back(task.m_index);
+        }
+    }
+
+    m_pPending = make_unique<atomic<uint>[]>(m_tasks.size());
+    m_timings.assign(m_tasks.size(), {});
+    m_compiled = true;
+
+    for (const Task& task : m_tasks)
+    {
+        LOG_DEBUG("Task \"{}\" follows {} and precedes {} tasks{}", task.m_pName, task.m_prerequisites.size(),
+                  task.m_successors.size(), task.m_mainThread ? ", on the main thread" : "");
+    }
+}
+
+void TaskGraph::Clear()
+{
+    m_tasks.clear();
+    m_pPending.reset();
+    m_timings.clear();
+    m_criticalPath.clear();
+    m_compiled = false;
+}
+
+
+//**********************************************************************************************************************
+//                                                      Execution
+//**********************************************************************************************************************
+void TaskGraph::Execute(JobSystem& jobSystem, FrameStats* pStats)
+{
+    PROFILE_FUNCTION();
+    if (!m_compiled) Compile();
+    assert(jobSystem.GetThreadIndex() == 0 && "graphs run from the main thread, which main thread tasks need");
+
+    for (uint i = 0; i < GetTaskCount(); ++i)
+    {
+        m_pPending[i].store(static_cast<uint>(m_tasks[i].m_prerequisites.size()), memory_order_relaxed);
+    }
+
+    // every task is a child of the root, so waiting on it waits for the whole graph
+    m_pJobSystem = &jobSystem;
+    m_pRoot = jobSystem.CreateEmptyJob();
+    for (const Task& task : m_tasks)
+    {
+        if (task.m_prerequisites.empty()) Launch(task.m_index);
+    }
+    jobSystem.Submit(m_pRoot);
+    jobSystem.Wait(m_pRoot);
+    m_pRoot = nullptr;
+
+    FindCriticalPath();
+
+    if (pStats != nullptr)
+    {
+        for (const Task& task : m_tasks)
+        {
+            if (task.m_stat == FrameStatCount) continue;
+            const TaskTiming& timing = m_timings[task.m_index];
+            pStats->Add(task.m_stat, (timing.end - timing.start) / 1e6);
+        }
+    }
+
+#if defined(SHADE_PROFILE)
+    MEMORY_SCOPE(MemoryTagProfiler);
+    vector<ProfileEvent> criticalPath;
+    for (uint index : m_criticalPath)
+    {
+        const TaskTiming& timing = m_timings[index];
+        criticalPath.push_back({m_tasks[index].m_pName, timing.start, timing.end, 0, timing.threadIndex});
+    }
+    Profiler::Get().SetCriticalPath(move(criticalPath));
+#endif
+}
+
+void TaskGraph::Launch(uint index)
+{
+    const auto run = [this, index] {Run(index);};
+    Job* pJob = m_tasks[index].m_mainThread ? m_pJobSystem->CreateMainThreadJob(run, m_pRoot)
+                                            : m_pJobSystem->CreateJob(run, m_pRoot);
+    m_pJobSystem->Submit(pJob);
+}
+
+void TaskGraph::Run(uint index)
+{
+    Task& task = m_tasks[index];
+    TaskTiming& timing = m_timings[index];
+
+    timing.start = Profiler::Now();
+    {
+        PROFILE_SCOPE(task.m_pName);
+        task.m_function();
+    }
+    timing.end = Profiler::Now();
+#if defined(SHADE_PROFILE)
+    timing.threadIndex = Profiler::GetThreadBuffer().m_threadIndex;
+#endif
+
+    for (uint successor : task.m_successors)
+    {
+        if (m_pPending[successor].fetch_sub(1, memory_order_acq_rel) == 1) Launch(successor);
+    }
+}
+
+void TaskGraph::FindCriticalPath()
+{
+    // walk back from the last task to finish, through whichever prerequisite released each task
+    m_criticalPath.clear();
+    if (m_tasks.empty()) return;
+
+    const auto endsBefore = [this](uint a, uint b) {return m_timings[a].end < m_timings[b].end;};
+    uint index = 0;
+    for (uint i = 1; i < GetTaskCount(); ++i)
+    {
+        if (endsBefore(index, i)) index = i;
+    }
+
+    while (true)
+    {
+        m_criticalPath.push_back(index);
+        const vector<uint>& prerequisites = m_tasks[index].m_prerequisites;
+        if (prerequisites.empty()) break;
+        index = *max_element(prerequisites.begin(), prerequisites.end(), endsBefore);
+    }
+    reverse(m_criticalPath.begin(), m_criticalPath.end());
+}
@@ -0,0 +1,98 @@
+// TaskGraph - Declarative graph of the stages of a frame, built once and executed on the job system every frame.
+//
+// Tasks are declared in the order they would run on a single thread, along with the data each one reads and writes,
+//  identified by address. Compile() turns those declarations into edges: a task follows the last earlier task to write
+//  anything it touches, and a task which writes follows every earlier task which read the same data since that write.
+//  Executing the graph therefore gives the same results as running the tasks in order, while tasks with no data in
+//  common run concurrently. Tasks calling into APIs which must stay on the main thread are run there while it waits.
+//
+// Each execution records when and where every task ran, and the critical path which ended the frame: the chain of tasks
+//  each started by the last of its prerequisites to finish. With SHADE_PROFILE, tasks appear as profiler zones and the
+//  critical path is handed to the profiler, which shows it as a lane of its own.
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "Common.h"
+#include "FrameStats.h"
+
+class JobSystem;
+struct Job;
+
+
+struct TaskTiming
+{
+    uint64  start;          // nanoseconds on the profiler's clock
+    uint64  end;
+    uint    threadIndex;    // the profiler's index of the thread which ran the task
+};
+
+
+class TaskGraph
+{
+public:
+    // a declared task, whose setters chain so that a declaration reads as one statement
+    class Task
+    {
+    public:
+        Task& Reads(const void* pData)          {m_reads.push_back(pData); return *this;}
+        Task& Writes(const void* pData)         {m_writes.push_back(pData); return *this;}
+        Task& After(uint taskIndex)             {m_after.push_back(taskIndex); return *this;}
+        Task& OnMainThread()                    {m_mainThread = true; return *this;}
+        Task& Measures(FrameStat stat)          {m_stat = stat; return *this;}  // adds its duration to a frame stat
+
+        uint GetIndex() const                   {return m_index;}
+
+    private:
+        friend class TaskGraph;
+
+        const char*                 m_pName;    // stored by pointer, so a string literal like profiler zone names
+        std::function<void()>       m_function;
+        std::vector<const void*>    m_reads;
+        std::vector<const void*>    m_writes;
+        std::vector<uint>           m_after;
+        bool                        m_mainThread;
+        FrameStat                   m_stat;
+        uint                        m_index;
+
+        // derived by Compile()
+        std::vector<uint>           m_prerequisites;
+        std::vector<uint>           m_successors;
+    };
+
+    TaskGraph();
+    ~TaskGraph();
+
+    Task& AddTask(const char* pName, std::function<void()> function);   // valid until the next task is added
+    void Compile();
+    void Clear();
+    bool IsCompiled() const                     {return m_compiled;}
+
+    // Runs every task once and waits for them all, from the job system's main thread. Durations of tasks which measure
+    //  a frame stat are added to pStats once all have finished.
+    void Execute(JobSystem& jobSystem, FrameStats* pStats = nullptr);
+
+    uint GetTaskCount() const                   {return static_cast<uint>(m_tasks.size());}
+    const char* GetTaskName(uint index) const   {return m_tasks[index].m_pName;}
+    const std::vector<uint>& GetPrerequisites(uint index) const {return m_tasks[index].m_prerequisites;}
+    const TaskTiming& GetTiming(uint index) const               {return m_timings[index];}
+    const std::vector<uint>& GetCriticalPath() const            {return m_criticalPath;}   // first task first
+
+private:
+    void Launch(uint index);
+    void Run(uint index);
+    void FindCriticalPath();
+
+    std::vector<Task>                       m_tasks;
+    bool                                    m_compiled;
+
+    // per execution
+    JobSystem*                              m_pJobSystem;
+    Job*                                    m_pRoot;
+    std::unique_ptr<std::atomic<uint>[]>    m_pPending;         // unfinished prerequisites per task
+    std::vector<TaskTiming>                 m_timings;
+    std::vector<uint>                       m_criticalPath;
+};
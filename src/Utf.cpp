@@ -0,0 +1,414 @@
+#include "Utf.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define UTF_SSE2 1
+#endif
+
+using namespace std;
+
+
+namespace
+{
+    constexpr size_t BlockSize = 16;   // code units converted at once while the input is ASCII
+
+    inline bool IsContinuation(uint8_t byte)    {return (byte & 0xC0) == 0x80;}
+    inline bool IsSurrogate(char32_t c)         {return c >= 0xD800 && c <= 0xDFFF;}
+
+    //******************************************************************************************************************
+    // ASCII blocks, each of which either converts all 16 code units or leaves the output untouched
+    //******************************************************************************************************************
+#if defined(UTF_SSE2)
+    template <typename Char>
+    inline bool WidenAsciiBlock(const uint8_t* pInput, Char* pOutput)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pInput));
+        if (_mm_movemask_epi8(bytes) != 0) return false;
+
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+        const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+        if constexpr (sizeof(Char) == 2)
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pOutput), low);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pOutput + 8), high);
+        }
+        else
+        {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pOutput), _mm_unpacklo_epi16(low, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pOutput + 4), _mm_unpackhi_epi16(low, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pOutput + 8), _mm_unpacklo_epi16(high, zero));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pOutput + 12), _mm_unpackhi_epi16(high, zero));
+        }
+        return true;
+    }
+
+    template <typename Char>
+    inline bool NarrowAsciiBlock(const Char* pInput, uint8_t* pOutput)
+    {
+        const __m128i zero = _mm_setzero_si128();
+        if constexpr (sizeof(Char) == 2)
+        {
+            const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pInput));
+            const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pInput + 8));
+            const __m128i nonAscii = _mm_and_si128(_mm_or_si128(low, high), _mm_set1_epi16(static_cast<short>(0xFF80)));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(nonAscii, zero)) != 0xFFFF) return false;
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pOutput), _mm_packus_epi16(low, high));
+        }
+        else
+        {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pInput));
+            const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pInput + 4));
+            const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pInput + 8));
+            const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pInput + 12));
+            const __m128i all = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+            const __m128i nonAscii = _mm_and_si128(all, _mm_set1_epi32(~0x7F));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(nonAscii, zero)) != 0xFFFF) return false;
+
+            // every value is below 0x80, so neither signed nor unsigned saturation alters any of them
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(pOutput),
+                             _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+        }
+        return true;
+    }
+
+    inline bool IsAsciiBlock(const uint8_t* pInput)
+    {
+        return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pInput))) == 0;
+    }
+#else
+    // eight bytes to a word where there is no SSE2, which compilers vectorize further where they can
+    inline bool IsAsciiBlock(const uint8_t* pInput)
+    {
+        uint64_t words[2];
+        memcpy(words, pInput, sizeof(words));
+        return ((words[0] | words[1]) & 0x8080808080808080ull) == 0;
+    }
+
+    template <typename Char>
+    inline bool WidenAsciiBlock(const uint8_t* pInput, Char* pOutput)
+    {
+        if (!IsAsciiBlock(pInput)) return false;
+        for (size_t i = 0; i < BlockSize; ++i) pOutput[i] = pInput[i];
+        return true;
+    }
+
+    template <typename Char>
+    inline bool NarrowAsciiBlock(const Char* pInput, uint8_t* pOutput)
+    {
+        uint32_t all = 0;   // wchar_t may be signed
+        for (size_t i = 0; i < BlockSize; ++i) all |= static_cast<uint32_t>(pInput[i]);
+        if (all >= 0x80) return false;
+        for (size_t i = 0; i < BlockSize; ++i) pOutput[i] = static_cast<uint8_t>(pInput[i]);
+        return true;
+    }
+#endif
+
+    //******************************************************************************************************************
+    // Code points
+    //******************************************************************************************************************
+    // well-formed sequences as given by table 3-7 of the Unicode standard, returning zero for anything else
+    inline size_t DecodeSequence(const uint8_t* p, const uint8_t* pEnd, char32_t& codePoint)
+    {
+        const size_t available = pEnd - p;
+        const uint8_t lead = p[0];
+        if (lead < 0x80)
+        {
+            codePoint = lead;
+            return 1;
+        }
+        if (lead < 0xC2) return 0;  // a continuation byte, or the lead of an overlong two byte form
+        if (lead < 0xE0)
+        {
+            if (available < 2 || !IsContinuation(p[1])) return 0;
+            codePoint = (char32_t(lead & 0x1F) << 6) | (p[1] & 0x3F);
+            return 2;
+        }
+        if (lead < 0xF0)
+        {
+            if (available < 3) return 0;
+            const uint8_t low = (lead == 0xE0) ? 0xA0 : 0x80;   // overlong
+            const uint8_t high = (lead == 0xED) ? 0x9F : 0xBF;  // surrogates
+            if (p[1] < low || p[1] > high || !IsContinuation(p[2])) return 0;
+            codePoint = (char32_t(lead & 0x0F) << 12) | (char32_t(p[1] & 0x3F) << 6) | (p[2] & 0x3F);
+            return 3;
+        }
+        if (lead < 0xF5)
+        {
+            if (available < 4) return 0;
+            const uint8_t low = (lead == 0xF0) ? 0x90 : 0x80;   // overlong
+            const uint8_t high = (lead == 0xF4) ? 0x8F : 0xBF;  // beyond U+10FFFF
+            if (p[1] < low || p[1] > high || !IsContinuation(p[2]) || !IsContinuation(p[3])) return 0;
+            codePoint = (char32_t(lead & 0x07) << 18) | (char32_t(p[1] & 0x3F) << 12) | (char32_t(p[2] & 0x3F) << 6) |
+                        (p[3] & 0x3F);
+            return 4;
+        }
+        return 0;
+    }
+
+    inline size_t Utf8Length(char32_t codePoint)
+    {
+        return (codePoint < 0x80) ? 1 : (codePoint < 0x800) ? 2 : (codePoint < 0x10000) ? 3 : 4;
+    }
+
+    inline uint8_t* EncodeUtf8(char32_t codePoint, uint8_t* q)
+    {
+        if (codePoint < 0x80)
+        {
+            *q++ = static_cast<uint8_t>(codePoint);
+        }
+        else if (codePoint < 0x800)
+        {
+            *q++ = static_cast<uint8_t>(0xC0 | (codePoint >> 6));
+            *q++ = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+        }
+        else if (codePoint < 0x10000)
+        {
+            *q++ = static_cast<uint8_t>(0xE0 | (codePoint >> 12));
+            *q++ = static_cast<uint8_t>(0x80 | ((codePoint >> 6) & 0x3F));
+            *q++ = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+        }
+        else
+        {
+            *q++ = static_cast<uint8_t>(0xF0 | (codePoint >> 18));
+            *q++ = static_cast<uint8_t>(0x80 | ((codePoint >> 12) & 0x3F));
+            *q++ = static_cast<uint8_t>(0x80 | ((codePoint >> 6) & 0x3F));
+            *q++ = static_cast<uint8_t>(0x80 | (codePoint & 0x3F));
+        }
+        return q;
+    }
+
+    // a code point from UTF-16 or UTF-32, by the size of the code unit, returning the units it occupies or zero
+    template <typename Char>
+    inline size_t DecodeWide(const Char* p, const Char* pEnd, char32_t& codePoint)
+    {
+        const char32_t first = static_cast<char32_t>(p[0]);
+        if constexpr (sizeof(Char) == 2)
+        {
+            if (!IsSurrogate(first))
+            {
+                codePoint = first;
+                return 1;
+            }
+            if (first >= 0xDC00 || pEnd - p < 2 || p[1] < 0xDC00 || p[1] > 0xDFFF) return 0;
+            codePoint = 0x10000 + ((first - 0xD800) << 10) + (static_cast<char32_t>(p[1]) - 0xDC00);
+            return 2;
+        }
+        else
+        {
+            codePoint = first;
+            return (first > 0x10FFFF || IsSurrogate(first)) ? 0 : 1;
+        }
+    }
+
+    //******************************************************************************************************************
+    // Transcoders, converting ASCII a block at a time and then anything else up to the next block boundary by code point
+    //******************************************************************************************************************
+    template <typename Char>
+    UtfResult FromUtf8(const char* pInput, size_t length, Char* pOutput, size_t capacity)
+    {
+        const uint8_t* const pBegin = reinterpret_cast<const uint8_t*>(pInput);
+        const uint8_t* const pEnd = pBegin + length;
+        const uint8_t* p = pBegin;
+        Char* q = pOutput;
+        Char* const pOutputEnd = pOutput + capacity;
+
+        while (p < pEnd)
+        {
+            while (pEnd - p >= ptrdiff_t(BlockSize) && pOutputEnd - q >= ptrdiff_t(BlockSize) && WidenAsciiBlock(p, q))
+            {
+                p += BlockSize;
+                q += BlockSize;
+            }
+
+            const uint8_t* const pBlockEnd = (pEnd - p > ptrdiff_t(BlockSize)) ? p + BlockSize : pEnd;
+            while (p < pBlockEnd)
+            {
+                char32_t codePoint;
+                const size_t read = DecodeSequence(p, pEnd, codePoint);
+                if (read == 0) return {UtfInvalidInput, size_t(p - pBegin), size_t(q - pOutput)};
+
+                const size_t written = (sizeof(Char) == 2 && codePoint >= 0x10000) ? 2 : 1;
+                if (size_t(pOutputEnd - q) < written) return {UtfOutputTooSmall, size_t(p - pBegin), size_t(q - pOutput)};
+                if (written == 2)
+                {
+                    q[0] = static_cast<Char>(0xD800 + ((codePoint - 0x10000) >> 10));
+                    q[1] = static_cast<Char>(0xDC00 + ((codePoint - 0x10000) & 0x3FF));
+                }
+                else
+                {
+                    q[0] = static_cast<Char>(codePoint);
+                }
+                p += read;
+                q += written;
+            }
+        }
+        return {UtfSuccess, length, size_t(q - pOutput)};
+    }
+
+    template <typename Char>
+    UtfResult ToUtf8(const Char* pInput, size_t length, char* pOutput, size_t capacity)
+    {
+        const Char* const pEnd = pInput + length;
+        const Char* p = pInput;
+        uint8_t* const pBegin = reinterpret_cast<uint8_t*>(pOutput);
+        uint8_t* q = pBegin;
+        uint8_t* const pOutputEnd = pBegin + capacity;
+
+        while (p < pEnd)
+        {
+            while (pEnd - p >= ptrdiff_t(BlockSize) && pOutputEnd - q >= ptrdiff_t(BlockSize) && NarrowAsciiBlock(p, q))
+            {
+                p += BlockSize;
+                q += BlockSize;
+            }
+
+            const Char* const pBlockEnd = (pEnd - p > ptrdiff_t(BlockSize)) ? p + BlockSize : pEnd;
+            while (p < pBlockEnd)
+            {
+                char32_t codePoint;
+                const size_t read = DecodeWide(p, pEnd, codePoint);
+                if (read == 0) return {UtfInvalidInput, size_t(p - pInput), size_t(q - pBegin)};
+                if (size_t(pOutputEnd - q) < Utf8Length(codePoint))
+                {
+                    return {UtfOutputTooSmall, size_t(p - pInput), size_t(q - pBegin)};
+                }
+                q = EncodeUtf8(codePoint, q);
+                p += read;
+            }
+        }
+        return {UtfSuccess, length, size_t(q - pBegin)};
+    }
+
+    template <typename Char>
+    bool IsValidWide(const Char* pInput, size_t length)
+    {
+        const Char* const pEnd = pInput + length;
+        for (const Char* p = pInput; p < pEnd;)
+        {
+            char32_t codePoint;
+            const size_t read = DecodeWide(p, pEnd, codePoint);
+            if (read == 0) return false;
+            p += read;
+        }
+        return true;
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                  Validation & Sizes
+//**********************************************************************************************************************
+bool IsValidUtf8(const char* pInput, size_t length)
+{
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(pInput);
+    const uint8_t* const pEnd = p + length;
+    while (p < pEnd)
+    {
+        if (pEnd - p >= ptrdiff_t(BlockSize) && IsAsciiBlock(p))
+        {
+            p += BlockSize;
+            continue;
+        }
+
+        char32_t codePoint;
+        const size_t read = DecodeSequence(p, pEnd, codePoint);
+        if (read == 0) return false;
+        p += read;
+    }
+    return true;
+}
+
+bool IsValidUtf16(const char16_t* pInput, size_t length)
+{
+    return IsValidWide(pInput, length);
+}
+
+bool IsValidUtf32(const char32_t* pInput, size_t length)
+{
+    return IsValidWide(pInput, length);
+}
+
+size_t DecodeUtf8(const char* pInput, size_t length, char32_t& codePoint)
+{
+    if (length == 0) return 0;
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(pInput);
+    return DecodeSequence(p, p + length, codePoint);
+}
+
+// every byte but a continuation starts a code point, and those starting with 0xF0 or above need a surrogate pair
+size_t Utf16LengthOfUtf8(const char* pInput, size_t length)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        const uint8_t byte = static_cast<uint8_t>(pInput[i]);
+        count += !IsContinuation(byte) + (byte >= 0xF0);
+    }
+    return count;
+}
+
+size_t Utf32LengthOfUtf8(const char* pInput, size_t length)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < length; ++i) count += !IsContinuation(static_cast<uint8_t>(pInput[i]));
+    return count;
+}
+
+// surrogate pairs are counted as two units of two bytes each
+size_t Utf8LengthOfUtf16(const char16_t* pInput, size_t length)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < length; ++i)
+    {
+        const char16_t unit = pInput[i];
+        count += (unit < 0x80) ? 1 : (unit < 0x800 || IsSurrogate(unit)) ? 2 : 3;
+    }
+    return count;
+}
+
+size_t Utf8LengthOfUtf32(const char32_t* pInput, size_t length)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < length; ++i) count += Utf8Length(pInput[i]);
+    return count;
+}
+
+
+//**********************************************************************************************************************
+//                                                      Transcoding
+//**********************************************************************************************************************
+UtfResult Utf8ToUtf16(const char* pInput, size_t length, char16_t* pOutput, size_t capacity)
+{
+    return FromUtf8(pInput, length, pOutput, capacity);
+}
+
+UtfResult Utf8ToUtf32(const char* pInput, size_t length, char32_t* pOutput, size_t capacity)
+{
+    return FromUtf8(pInput, length, pOutput, capacity);
+}
+
+UtfResult Utf16ToUtf8(const char16_t* pInput, size_t length, char* pOutput, size_t capacity)
+{
+    return ToUtf8(pInput, length, pOutput, capacity);
+}
+
+UtfResult Utf32ToUtf8(const char32_t* pInput, size_t length, char* pOutput, size_t capacity)
+{
+    return ToUtf8(pInput, length, pOutput, capacity);
+}
+
+// wchar_t is transcoded as whichever of UTF-16 or UTF-32 its size matches
+UtfResult Utf8ToWide(const char* pInput, size_t length, wchar_t* pOutput, size_t capacity)
+{
+    return FromUtf8(pInput, length, pOutput, capacity);
+}
+
+UtfResult WideToUtf8(const wchar_t* pInput, size_t length, char* pOutput, size_t capacity)
+{
+    return ToUtf8(pInput, length, pOutput, capacity);
+}
@@ -0,0 +1,69 @@
+// Utf - Validating transcoding between UTF-8, UTF-16 and UTF-32.
+//
+// The transcoders write into buffers provided by the caller, never allocate and keep no state, so they may be called
+//  from any thread. Runs of ASCII, which make up nearly all shader arguments, paths and messages, are converted 16 code
+//  units at a time with SSE2 where available and 8 byte words elsewhere. Anything else is decoded and validated one code
+//  point at a time.
+//
+// Conversion stops at the first ill-formed sequence: overlong forms, surrogates encoded in UTF-8, code points beyond
+//  U+10FFFF, truncated sequences and unpaired UTF-16 surrogates are all rejected. The string conversions in Util.h
+//  build on these and substitute U+FFFD instead, for display.
+#pragma once
+
+#include <cstddef>
+
+
+enum UtfStatus
+{
+    UtfSuccess,
+    UtfInvalidInput,        // the input is ill-formed at UtfResult::read
+    UtfOutputTooSmall,      // the output is full, and conversion may resume from UtfResult::read
+};
+
+struct UtfResult
+{
+    UtfStatus   status;
+    size_t      read;       // input code units consumed
+    size_t      written;    // output code units produced
+};
+
+constexpr char32_t UtfReplacementCharacter = 0xFFFD;
+
+
+//**********************************************************************************************************************
+//                                                  Validation & Sizes
+//**********************************************************************************************************************
+bool IsValidUtf8(const char* pInput, size_t length);
+bool IsValidUtf16(const char16_t* pInput, size_t length);
+bool IsValidUtf32(const char32_t* pInput, size_t length);
+
+// Decodes the code point at the start of the input, returning the code units it occupies, or zero where the input is
+//  empty or ill-formed there.
+size_t DecodeUtf8(const char* pInput, size_t length, char32_t& codePoint);
+
+// code units needed to transcode valid input, for sizing a buffer exactly
+size_t Utf16LengthOfUtf8(const char* pInput, size_t length);
+size_t Utf32LengthOfUtf8(const char* pInput, size_t length);
+size_t Utf8LengthOfUtf16(const char16_t* pInput, size_t length);
+size_t Utf8LengthOfUtf32(const char32_t* pInput, size_t length);
+
+
+//**********************************************************************************************************************
+//                                                      Transcoding
+//**********************************************************************************************************************
+// No output ever needs more code units than these multiples of the input, whether or not it is valid.
+constexpr size_t MaxUtf16PerUtf8 = 1;
+constexpr size_t MaxUtf32PerUtf8 = 1;
+constexpr size_t MaxUtf8PerUtf16 = 3;
+constexpr size_t MaxUtf8PerUtf32 = 4;
+
+UtfResult Utf8ToUtf16(const char* pInput, size_t length, char16_t* pOutput, size_t capacity);
+UtfResult Utf8ToUtf32(const char* pInput, size_t length, char32_t* pOutput, size_t capacity);
+UtfResult Utf16ToUtf8(const char16_t* pInput, size_t length, char* pOutput, size_t capacity);
+UtfResult Utf32ToUtf8(const char32_t* pInput, size_t length, char* pOutput, size_t capacity);
+
+// wchar_t holds UTF-16 on Windows and UTF-32 elsewhere, which is also what DXC's Linux adapter expects
+UtfResult Utf8ToWide(const char* pInput, size_t length, wchar_t* pOutput, size_t capacity);
+UtfResult WideToUtf8(const wchar_t* pInput, size_t length, char* pOutput, size_t capacity);
+constexpr size_t MaxWidePerUtf8 = 1;
+constexpr size_t MaxUtf8PerWide = (sizeof(wchar_t) == 2) ? MaxUtf8PerUtf16 : MaxUtf8PerUtf32;
@@ -1,11 +1,13 @@
 #include "Util.h"
 
 #include <system_error>
-#include <locale>
-#include <codecvt>
 #include <sstream>
 #include <chrono>
+#if defined(_WIN32)
 #include <debugapi.h>
+#endif
+
+#include "Utf.h"
 
 using namespace std;
 
@@ -13,20 +15,57 @@ using namespace std;
 //**********************************************************************************************************************
 //                                                      Converters
 //**********************************************************************************************************************
-std::wstring ToWideString(const std::string& str)
+std::wstring ToWideString(std::string_view str)
 {
-    using convert_typeX = std::codecvt_utf8<wchar_t>;
-    static std::wstring_convert<convert_typeX, wchar_t> converter;
-
-    return converter.from_bytes(str);
+    std::wstring wide(str.size() * MaxWidePerUtf8, L'\0');
+    size_t read = 0;
+    size_t written = 0;
+    while (read < str.size())
+    {
+        const UtfResult result = Utf8ToWide(str.data() + read, str.size() - read, wide.data() + written,
+                                            wide.size() - written);
+        read += result.read;
+        written += result.written;
+        if (result.status == UtfInvalidInput)
+        {
+            wide[written++] = static_cast<wchar_t>(UtfReplacementCharacter);
+            read++;
+        }
+    }
+    wide.resize(written);
+    return wide;
 }
 
-std::string ToNormalString(const std::wstring& wstr)
+std::string ToNormalString(std::wstring_view wstr)
 {
-    using convert_typeX = std::codecvt_utf8<wchar_t>;
-    static std::wstring_convert<convert_typeX, wchar_t> converter;
+    std::string narrow(wstr.size() * MaxUtf8PerWide, '\0');
+    size_t read = 0;
+    size_t written = 0;
+    while (read < wstr.size())
+    {
+        const UtfResult result = WideToUtf8(wstr.data() + read, wstr.size() - read, narrow.data() + written,
+                                            narrow.size() - written);
+        read += result.read;
+        written += result.written;
+        if (result.status == UtfInvalidInput)
+        {
+            narrow.replace(written, 3, "\xEF\xBF\xBD");   // U+FFFD
+            written += 3;
+            read++;
+        }
+    }
+    narrow.resize(written);
+    return narrow;
+}
 
-    return converter.to_bytes(wstr);
+// paths are UTF-16 on Windows, and taken to be UTF-8 already elsewhere
+std::string PathToUtf8(const std::filesystem::path& path)
+{
+#if defined(_WIN32)
+    return ToNormalString(path.generic_wstring());
+#else
+    return path.generic_string();
+#endif
 }
 
 const std::string HumanReadableFileSize(uint fileSize)
@@ -11,39 +11,25 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <chrono>
 #include <time.h>
 #include <limits>
 #include <filesystem>
+#if defined(_WIN32)
 #include <Windows.h>
 #include <d3d12.h>
 #include <dxgi1_6.h>
 #include <wrl.h>
+#endif
 
 #include <fmt/format.h>
 
-#include "d3dx12.h"
 #include "Common.h"
+#include "Log.h"
 
 using Microsoft::WRL::ComPtr;
 
-//enum class MessageSeverity
-enum MessageSeverity
-{
-    Info,
-    Warning,
-    Error,
-    FatalError,
-};
-// TODO: constexpr?
-static const char* MessageSeverityTags[] =
-{
-    "[INFO]",
-    "[WARNING]",
-    "[ERROR]",
-    "[FATAL ERROR]"
-};
-
 
 //**********************************************************************************************************************
 //                                                      Converters
@@ -56,8 +42,12 @@ std::time_t TimeConvert(TP tp)
     return system_clock::to_time_t(sctp);
 }
 
-std::wstring ToWideString(const std::string& str);
-std::string ToNormalString(const std::wstring& wstr);
+// UTF-8 to and from wchar_t, with U+FFFD in place of anything ill-formed (see Utf.h for conversions into buffers)
+std::wstring ToWideString(std::string_view str);
+std::string ToNormalString(std::wstring_view wstr);
+
+// a path in generic form as UTF-8, for display
+std::string PathToUtf8(const std::filesystem::path& path);
 
 const std::string HumanReadableFileSize(uint fileSize);
 
@@ -65,22 +55,24 @@ const std::string HumanReadableFileSize(uint fileSize);
 //**********************************************************************************************************************
 //                                              Printing, Logging & Errors
 //**********************************************************************************************************************
-static void PrintMessageHelper(const std::string& format, fmt::format_args args)
+// Runtime format strings cannot be checked or deferred, so these are formatted on the calling thread and only the text
+//  is queued. Literal format strings should use the LOG_ macros instead.
+static void PrintMessageHelper(MessageSeverity severity, bool raw, const std::string& format, fmt::format_args args)
 {
-    //fmt::vprint(format, args);
-    OutputDebugStringA(fmt::vformat(format, args).c_str());
+    const std::string text = fmt::vformat(format, args);
+    Logger::Log(severity, raw, "{}", text);
 }
 template <typename... Args>
 static void PrintMessage(const std::string& format, const Args& ... args) // bring your own newlines!
 {
-    PrintMessageHelper(format, fmt::make_format_args(args...));
+    if (!Logger::IsEnabled(Info)) return;
+    PrintMessageHelper(Info, true, format, fmt::make_format_args(args...));
 }
 template <typename... Args>
 static void PrintMessage(MessageSeverity severity, const std::string& format, const Args& ... args)
 {
-    std::stringstream ss;
-    ss << MessageSeverityTags[static_cast<UINT>(severity)] << " " << format << "\n";
-    PrintMessageHelper(ss.str(), fmt::make_format_args(args...));
+    if (!Logger::IsEnabled(severity)) return;
+    PrintMessageHelper(severity, false, format, fmt::make_format_args(args...));
 }
 
 void CheckResult(HRESULT hr, const std::string& msg = "", bool except=false);
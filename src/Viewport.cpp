@@ -9,7 +9,7 @@ uint Viewport::NumViewports = 0;
 Viewport::Viewport() :
     m_viewportId(NumViewports++),
     m_isValid(false),
-    m_pEngine(Dx12RenderEngine::pCurrentEngine)
+    m_pEngine(RenderEngine::pCurrentEngine)
 {
 }
 Viewport::~Viewport()
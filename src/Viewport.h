@@ -6,7 +6,9 @@
 #pragma once
 
 #include "Util.h"
-#include "Dx12RenderEngine.h"
+#include <imgui.h>
+
+#include "RenderEngine.h"
 
 
 enum class ViewportType
@@ -36,7 +38,7 @@ public:
     virtual void SubmitWork();              // request engine do requisite prep work
     virtual void DrawUI();                  // draw ImGui window with contents and UI
 
-    const std::string GetName() const           {return m_name;}
+    const std::string& GetName() const          {return m_name;}
     ComPtr<ID3D12Resource> GetResource()        {return m_pResource;}
     ComPtr<ID3D12Resource> GetResourcePinned()  {return m_pResourcePinned;}
 
@@ -47,7 +49,7 @@ protected:
     void DrawPinnedResource();
 
     // components
-    Dx12RenderEngine* m_pEngine;
+    RenderEngine* m_pEngine;
     ComPtr<ID3D12Resource> m_pResource;
     ComPtr<ID3D12Resource> m_pResourcePinned;   // for creating a copy of target resource
     D3D12_GPU_DESCRIPTOR_HANDLE m_srvHandle;
@@ -1,10 +1,14 @@
 #include "Widgets.h"
 
 #include <algorithm>
+#include <cwchar>
 #include <locale>
+#include <stdexcept>
 
 #include <ctype.h>
 
+#include "Utf.h"
+
 
 enum class FilePickerWigetSortMode {
     None,
@@ -15,6 +19,17 @@ enum class FilePickerWigetSortMode {
 };
 
 
+// std::gmtime is not thread safe, and the safe variants differ between the MSVC and POSIX runtimes
+static void SafeGmTime(const std::time_t* pTime, std::tm* pResult)
+{
+#if defined(_WIN32)
+    gmtime_s(pResult, pTime);
+#else
+    gmtime_r(pTime, pResult);
+#endif
+}
+
+
 // not very unicode friendly, but generic strings should be generic enough
 bool FileSorterName(const std::filesystem::directory_entry& a, const std::filesystem::directory_entry& b)
 {
@@ -42,6 +57,43 @@ bool FileSorterDate(const std::filesystem::directory_entry& a, const std::filesy
 };
 
 
+// Orders names by code point, ignoring case as the user's locale defines it. Code points are compared as they are
+//  decoded, rather than widening and lowercasing both names in full.
+static int CompareNamesCaseless(std::string_view left, std::string_view right)
+{
+    static const std::locale userLocale = []()
+    {
+        try
+        {
+            return std::locale("");
+        }
+        catch (const std::runtime_error&)
+        {
+            return std::locale::classic();  // an unknown locale in the environment
+        }
+    }();
+    static const std::ctype<wchar_t>& facet = std::use_facet<std::ctype<wchar_t>>(userLocale);
+
+    size_t leftOffset = 0;
+    size_t rightOffset = 0;
+    while (leftOffset < left.size() && rightOffset < right.size())
+    {
+        // ill-formed bytes compare as themselves, one at a time
+        char32_t leftCode = static_cast<unsigned char>(left[leftOffset]);
+        char32_t rightCode = static_cast<unsigned char>(right[rightOffset]);
+        leftOffset += std::max<size_t>(DecodeUtf8(left.data() + leftOffset, left.size() - leftOffset, leftCode), 1);
+        rightOffset += std::max<size_t>(DecodeUtf8(right.data() + rightOffset, right.size() - rightOffset, rightCode), 1);
+
+        // wchar_t cannot hold code points beyond the BMP on Windows, which are left as they are
+        constexpr char32_t WideMax = static_cast<char32_t>(WCHAR_MAX);
+        if (leftCode <= WideMax) leftCode = static_cast<char32_t>(facet.tolower(static_cast<wchar_t>(leftCode)));
+        if (rightCode <= WideMax) rightCode = static_cast<char32_t>(facet.tolower(static_cast<wchar_t>(rightCode)));
+        if (leftCode != rightCode) return (leftCode < rightCode) ? -1 : 1;
+    }
+    return (left.size() - leftOffset > 0) - (right.size() - rightOffset > 0);
+}
+
+
 // Comparison function for sorting file browser widget results.
 //
 // This function is expected to be called upon each refresh or re-sort for the contents of a directory. It is called as
@@ -64,24 +116,8 @@ static bool CompareWithSortSpecs(const std::filesystem::directory_entry& left,
         {
         case 0: // name
         {
-            std::locale::global(std::locale(""));
-            std::wstringstream ss;
-            ss.imbue(std::locale());
-            auto& facet = std::use_facet<std::ctype<WCHAR>>(std::locale());
-
-            //auto leftName = left.path().u8string();
-            //auto rightName = right.path().u8string();
-            auto leftName = left.path().generic_wstring();
-            auto rightName = right.path().generic_wstring();
-
-            facet.tolower(&leftName[0], &leftName[0] + leftName.size());
-            facet.tolower(&rightName[0], &rightName[0] + rightName.size());
-
-            result = (descending) ? leftName < rightName
-                                  : leftName > rightName;
-
-            //result = (descending) ? left.path().generic_string() < right.path().generic_string()
-            //                      : left.path().generic_string() > right.path().generic_string();
+            const int order = CompareNamesCaseless(PathToUtf8(left.path()), PathToUtf8(right.path()));
+            result = (descending) ? order < 0 : order > 0;
             break;
         }
         case 1: // size
@@ -119,10 +155,8 @@ static bool CompareWithSortSpecs(const std::filesystem::directory_entry& left,
 //  some other relative path operation comes into play, then this will need revising.
 //
 // TODO: style table buttons
-void FilePickerWidget(char* buffer, const size_t bufferSize, const std::string startLocation)
+void FilePickerWidget(char* buffer, const size_t bufferSize, const std::string& startLocation)
 {
-    std::filesystem::directory_iterator currentDirectory(std::filesystem::current_path());
-
     // widget populates a destination string with a file path via an interactive popup
     ImGui::InputTextWithHint("##FilePickerWidgetInputTextBoxLabel", "file path", buffer, bufferSize);
     ImGui::SameLine();
@@ -141,6 +175,9 @@ void FilePickerWidget(char* buffer, const size_t bufferSize, const std::string s
         static std::vector<std::filesystem::directory_entry> files;
         std::stringstream ss;
 
+        // opened only while the popup is, as this allocates and reads the filesystem
+        std::filesystem::directory_iterator currentDirectory(std::filesystem::current_path());
+
         static ImGuiTableFlags flags = ImGuiTableFlags_Resizable    |
                                        ImGuiTableFlags_Reorderable  |
                                        ImGuiTableFlags_Sortable     |
@@ -151,26 +188,14 @@ void FilePickerWidget(char* buffer, const size_t bufferSize, const std::string s
         // rebuild lists of content for current directory
         if (refresh)
         {
-            directories.clear();
-            files.clear();
-            for (auto& entry : currentDirectory)
-            {
-                if (entry.is_directory())
-                {
-                    directories.push_back(entry);
-                }
-                else
-                {
-                    files.push_back(entry);
-                }
-            }
+            ScanDirectory(std::filesystem::current_path(), directories, files);
             refresh = false;
         }
 
         // TODO: add text box for pasting in path
 
         // string of buttons which navigate to all the parents of current path
-        ImGui::Text("%s", std::filesystem::current_path().generic_u8string().c_str());
+        ImGui::TextUnformatted(PathToUtf8(std::filesystem::current_path()).c_str());
         std::filesystem::path builtPath = "";
         ImGui::Text("Navigation: ");
         for (const auto& element : currentDirectory->path().parent_path())
@@ -180,7 +205,7 @@ void FilePickerWidget(char* buffer, const size_t bufferSize, const std::string s
             builtPath += '/';
 
             ImGui::SameLine();
-            if (ImGui::Button((const char*)(element.generic_u8string().c_str())))
+            if (ImGui::Button(PathToUtf8(element).c_str()))
             {
                 std::filesystem::current_path(builtPath);
                 refresh = true;
@@ -211,7 +236,7 @@ void FilePickerWidget(char* buffer, const size_t bufferSize, const std::string s
         // std::filesystem iterators do not include . and .. so add .. in
         ImGui::TableNextColumn(); // name
         std::filesystem::path dotDot("..");
-        if (ImGui::Button((const char*)(dotDot.filename().generic_u8string().c_str())))
+        if (ImGui::Button(PathToUtf8(dotDot.filename()).c_str()))
         {
             std::filesystem::current_path(dotDot);
             refresh = true;
@@ -230,13 +255,13 @@ void FilePickerWidget(char* buffer, const size_t bufferSize, const std::string s
             std::time_t tt = TimeConvert(lastWriteTime);
             //std::tm *gmt = std::gmtime(&tt); // std::gmtime not thread safe
             std::tm gmt;
-            gmtime_s(&gmt, &tt);
+            SafeGmTime(&tt, &gmt);
             ss << std::put_time(&gmt, "%c");
 
             // name
             ImGui::TableNextColumn();
             // TODO: style these buttons
-            if (ImGui::Button((const char*)(entry.path().filename().generic_u8string().c_str())))
+            if (ImGui::Button(PathToUtf8(entry.path().filename()).c_str()))
             {
                 std::filesystem::current_path(entry);
                 refresh = true;
@@ -260,20 +285,20 @@ void FilePickerWidget(char* buffer, const size_t bufferSize, const std::string s
             const std::filesystem::file_time_type lastWriteTime = entry.last_write_time();
             std::time_t tt = TimeConvert(lastWriteTime);
             std::tm gmt;
-            gmtime_s(&gmt, &tt);
+            SafeGmTime(&tt, &gmt);
             ss << std::put_time(&gmt, "%c");
 
             // name
             ImGui::TableNextColumn();
             // TODO: style these buttons
-            ImGui::Button((const char*)(entry.path().filename().generic_u8string().c_str()));
+            ImGui::Button(PathToUtf8(entry.path().filename()).c_str());
 
             // size
             ImGui::TableNextColumn();
             ImGui::Text(HumanReadableFileSize(entry.file_size()).c_str());
             // type
             ImGui::TableNextColumn();
-            ImGui::Text("%S", entry.path().extension().c_str());
+            ImGui::TextUnformatted(PathToUtf8(entry.path().extension()).c_str());
             // date
             ImGui::TableNextColumn();
             ImGui::Text(ss.str().c_str());
@@ -287,6 +312,25 @@ void FilePickerWidget(char* buffer, const size_t bufferSize, const std::string s
     }
 }
 
+void ScanDirectory(const std::filesystem::path&                   directory,
+                   std::vector<std::filesystem::directory_entry>& directories,
+                   std::vector<std::filesystem::directory_entry>& files)
+{
+    directories.clear();
+    files.clear();
+    for (auto& entry : std::filesystem::directory_iterator(directory))
+    {
+        if (entry.is_directory())
+        {
+            directories.push_back(entry);
+        }
+        else
+        {
+            files.push_back(entry);
+        }
+    }
+}
+
 bool SliderU64(const char* label, uint64_t* value, uint64_t min, uint64_t max, const char* format)
 {
     return ImGui::SliderScalar(label, ImGuiDataType_S64, value, &min, &max, format);
@@ -1,8 +1,15 @@
+#include <vector>
+
 #include <imgui.h>
 
 #include "Util.h"
 
-void FilePickerWidget(char* buffer, const size_t bufferSize, const std::string startLocation = "");
+void FilePickerWidget(char* buffer, const size_t bufferSize, const std::string& startLocation = "");
+
+// splits the contents of a directory into subdirectories and files, as listed by the file picker
+void ScanDirectory(const std::filesystem::path&                   directory,
+                   std::vector<std::filesystem::directory_entry>& directories,
+                   std::vector<std::filesystem::directory_entry>& files);
 
 
 bool SliderU64(const char* label, uint64_t* value, uint64_t min = 0, uint64_t max = 0, const char* format = "%llu");
@@ -0,0 +1,570 @@
+#include "NullObjects.h"
+
+using namespace std;
+
+
+uint BytesPerPixel(DXGI_FORMAT format)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:
+    case DXGI_FORMAT_R32G32B32A32_UINT:
+    case DXGI_FORMAT_R32G32B32A32_TYPELESS:
+        return 16;
+    case DXGI_FORMAT_R32G32B32_FLOAT:
+        return 12;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:
+    case DXGI_FORMAT_R32G32_FLOAT:
+        return 8;
+    case DXGI_FORMAT_R8_UNORM:
+        return 1;
+    default:    // RGBA8, R32 and D32 make up nearly everything we create
+        return 4;
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                      Resource
+//**********************************************************************************************************************
+void NullResource::AlignedDeleter::operator()(UINT8* pData) const
+{
+    if (owned) ::operator delete[](pData, align_val_t(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT));
+}
+
+NullResource::NullResource(RenderEngineStats* pStats, const D3D12_HEAP_PROPERTIES& heapProperties, const D3D12_RESOURCE_DESC& desc) :
+    NullResource(pStats, heapProperties, desc, true)
+{
+}
+
+NullResource::NullResource(RenderEngineStats* pStats, const D3D12_HEAP_PROPERTIES& heapProperties, const D3D12_RESOURCE_DESC& desc,
+                           bool allocate) :
+    NullDeviceChild(pStats),
+    m_heapProperties(heapProperties),
+    m_desc(desc),
+    m_size(0),
+    m_rowPitch(0),
+    m_mapCount(0)
+{
+    if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        m_size = desc.Width;
+    }
+    else
+    {
+        // only mip 0 is backed, as nothing in Shade generates mips yet
+        m_rowPitch = desc.Width * BytesPerPixel(desc.Format);
+        m_size = m_rowPitch * desc.Height * desc.DepthOrArraySize;
+    }
+
+    // match the placement alignment of a real heap so that root CBV and buffer view alignment checks are meaningful
+    if (allocate)
+    {
+        UINT8* pData = static_cast<UINT8*>(::operator new[](m_size, align_val_t(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)));
+        memset(pData, 0, m_size);
+        m_pData.reset(pData);
+    }
+}
+
+void NullResource::SetExternalData(UINT8* pData)
+{
+    m_pData.reset();
+    m_pData.get_deleter().owned = false;
+    m_pData.reset(pData);
+}
+
+HRESULT NullResource::Map(UINT subresource, const D3D12_RANGE* pReadRange, void** ppData)
+{
+    if (m_heapProperties.Type == D3D12_HEAP_TYPE_DEFAULT)
+    {
+        PrintMessage(Error, "Null backend: Map() called on default heap resource \"{}\"", m_name);
+        m_pStats->validationErrors++;
+        return E_INVALIDARG;
+    }
+
+    m_mapCount++;
+    if (ppData != nullptr) *ppData = m_pData.get();
+    return S_OK;
+}
+
+void NullResource::Unmap(UINT subresource, const D3D12_RANGE* pWrittenRange)
+{
+    NULL_BACKEND_VALIDATE(m_pStats, m_mapCount > 0, "Null backend: Unmap() without matching Map() on \"{}\"", m_name);
+    if (m_mapCount > 0) m_mapCount--;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS NullResource::GetGPUVirtualAddress()
+{
+    NULL_BACKEND_VALIDATE(m_pStats, m_desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER,
+                          "Null backend: GetGPUVirtualAddress() called on texture \"{}\"", m_name);
+    return reinterpret_cast<D3D12_GPU_VIRTUAL_ADDRESS>(m_pData.get());
+}
+
+HRESULT NullResource::WriteToSubresource(UINT dstSubresource, const D3D12_BOX* pDstBox, const void* pSrcData,
+                                         UINT srcRowPitch, UINT srcDepthPitch)
+{
+    // whole-subresource writes only, which is all a CPU-visible texture upload needs
+    const uint64 rowBytes = min<uint64>(m_rowPitch, srcRowPitch);
+    for (uint row = 0; row < m_desc.Height; ++row)
+    {
+        memcpy(m_pData.get() + row*m_rowPitch, static_cast<const UINT8*>(pSrcData) + row*srcRowPitch, rowBytes);
+    }
+    return S_OK;
+}
+
+HRESULT NullResource::ReadFromSubresource(void* pDstData, UINT dstRowPitch, UINT dstDepthPitch,
+                                          UINT srcSubresource, const D3D12_BOX* pSrcBox)
+{
+    const uint64 rowBytes = min<uint64>(m_rowPitch, dstRowPitch);
+    for (uint row = 0; row < m_desc.Height; ++row)
+    {
+        memcpy(static_cast<UINT8*>(pDstData) + row*dstRowPitch, m_pData.get() + row*m_rowPitch, rowBytes);
+    }
+    return S_OK;
+}
+
+HRESULT NullResource::GetHeapProperties(D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS* pHeapFlags)
+{
+    if (pHeapProperties != nullptr) *pHeapProperties = m_heapProperties;
+    if (pHeapFlags != nullptr)      *pHeapFlags = D3D12_HEAP_FLAG_NONE;
+    return S_OK;
+}
+
+
+//**********************************************************************************************************************
+//                                                  Descriptor Heap
+//**********************************************************************************************************************
+NullDescriptorHeap::NullDescriptorHeap(RenderEngineStats* pStats, const D3D12_DESCRIPTOR_HEAP_DESC& desc) :
+    NullDeviceChild(pStats),
+    m_desc(desc),
+    m_descriptors(desc.NumDescriptors, {nullptr, desc.Type, DXGI_FORMAT_UNKNOWN})
+{
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE NullDescriptorHeap::GetCPUDescriptorHandleForHeapStart()
+{
+    return {reinterpret_cast<SIZE_T>(m_descriptors.data())};
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE NullDescriptorHeap::GetGPUDescriptorHandleForHeapStart()
+{
+    NULL_BACKEND_VALIDATE(m_pStats, m_desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE,
+                          "Null backend: GPU handle requested from non-shader-visible heap \"{}\"", m_name);
+    return {reinterpret_cast<UINT64>(m_descriptors.data())};
+}
+
+
+//**********************************************************************************************************************
+//                                                  Pipeline Objects
+//**********************************************************************************************************************
+NullRootSignature::NullRootSignature(RenderEngineStats* pStats, const CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC& desc) :
+    NullDeviceChild(pStats)
+{
+    // the two versions' parameters only differ in descriptor flags, which are not needed
+    uint constantsOffset = 0;
+    const auto addParameter = [this, &constantsOffset](const auto& source)
+    {
+        NullRootParameter parameter = {};
+        parameter.type          = source.ParameterType;
+        parameter.visibility    = source.ShaderVisibility;
+        if (source.ParameterType == D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS)
+        {
+            parameter.shaderRegister    = source.Constants.ShaderRegister;
+            parameter.registerSpace     = source.Constants.RegisterSpace;
+            parameter.num32BitValues    = source.Constants.Num32BitValues;
+            parameter.constantsOffset   = constantsOffset;
+            constantsOffset += parameter.num32BitValues;
+        }
+        else if (source.ParameterType != D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE)
+        {
+            parameter.shaderRegister    = source.Descriptor.ShaderRegister;
+            parameter.registerSpace     = source.Descriptor.RegisterSpace;
+        }
+        m_parameters.push_back(parameter);
+    };
+
+    if (desc.Version == D3D_ROOT_SIGNATURE_VERSION_1_1)
+    {
+        for (uint i = 0; i < desc.Desc_1_1.NumParameters; ++i) addParameter(desc.Desc_1_1.pParameters[i]);
+    }
+    else
+    {
+        for (uint i = 0; i < desc.Desc_1_0.NumParameters; ++i) addParameter(desc.Desc_1_0.pParameters[i]);
+    }
+}
+
+int NullRootSignature::FindConstantBuffer(uint shaderRegister, uint registerSpace) const
+{
+    for (size_t i = 0; i < m_parameters.size(); ++i)
+    {
+        const NullRootParameter& parameter = m_parameters[i];
+        const bool constantBuffer = (parameter.type == D3D12_ROOT_PARAMETER_TYPE_CBV ||
+                                     parameter.type == D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS);
+        if (constantBuffer && parameter.shaderRegister == shaderRegister && parameter.registerSpace == registerSpace)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+NullPipelineState::NullPipelineState(RenderEngineStats* pStats, const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc) :
+    NullDeviceChild(pStats),
+    m_rasterizerState(CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT)),
+    m_depthStencilState(CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT))
+{
+    if (pDesc != nullptr)
+    {
+        m_rasterizerState   = pDesc->RasterizerState;
+        m_depthStencilState = pDesc->DepthStencilState;
+
+        // deep copy the input layout, since the semantic names belong to the caller
+        m_semanticNames.reserve(pDesc->InputLayout.NumElements);
+        for (uint i = 0; i < pDesc->InputLayout.NumElements; ++i)
+        {
+            m_semanticNames.push_back(pDesc->InputLayout.pInputElementDescs[i].SemanticName);
+            m_inputLayout.push_back(pDesc->InputLayout.pInputElementDescs[i]);
+            m_inputLayout.back().SemanticName = m_semanticNames.back().c_str();
+        }
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                  Command List
+//**********************************************************************************************************************
+NullCommandList::NullCommandList(RenderEngineStats* pStats) :
+    NullDeviceChild(pStats),
+    m_isOpen(false),    // like CreateCommandList1(), lists begin closed
+    m_commandCount(0)
+{
+    ClearState(nullptr);
+}
+
+HRESULT NullCommandList::QueryInterface(REFIID riid, void** ppvObject)
+{
+    if (ppvObject == nullptr) return E_POINTER;
+
+    // every older command list interface is a base of the one we implement
+    if (riid == __uuidof(IUnknown)                  ||
+        riid == __uuidof(ID3D12CommandList)         ||
+        riid == __uuidof(ID3D12GraphicsCommandList) ||
+        riid == __uuidof(ID3D12GraphicsCommandList1)||
+        riid == __uuidof(ID3D12GraphicsCommandList2)||
+        riid == __uuidof(ID3D12GraphicsCommandList3)||
+        riid == __uuidof(ID3D12GraphicsCommandList4)||
+        riid == __uuidof(ID3D12GraphicsCommandList5)||
+        riid == __uuidof(ID3D12GraphicsCommandList6))
+    {
+        AddRef();
+        *ppvObject = static_cast<ID3D12GraphicsCommandList6*>(this);
+        return S_OK;
+    }
+
+    *ppvObject = nullptr;
+    return E_NOINTERFACE;
+}
+
+bool NullCommandList::IsRecording(const char* pCommandName)
+{
+    NULL_BACKEND_VALIDATE(m_pStats, m_isOpen, "Null backend: {} recorded into closed command list \"{}\"", pCommandName, m_name);
+    m_commandCount++;
+    return m_isOpen;
+}
+
+bool NullCommandList::ValidateDrawState(const char* pCommandName)
+{
+    const uint64 errorCount = m_pStats->validationErrors;
+
+    NULL_BACKEND_VALIDATE(m_pStats, m_pRootSignature != nullptr, "Null backend: {} without a graphics root signature", pCommandName);
+    NULL_BACKEND_VALIDATE(m_pStats, m_pPipelineState != nullptr, "Null backend: {} without a pipeline state", pCommandName);
+    NULL_BACKEND_VALIDATE(m_pStats, m_numRenderTargets > 0 || m_pDepthStencil != nullptr,
+                          "Null backend: {} without any render target or depth stencil bound", pCommandName);
+    NULL_BACKEND_VALIDATE(m_pStats, m_topology != D3D_PRIMITIVE_TOPOLOGY_UNDEFINED,
+                          "Null backend: {} without a primitive topology", pCommandName);
+
+    return (errorCount == m_pStats->validationErrors);
+}
+
+bool NullCommandList::ValidateRootConstants(const char* pCommandName, uint rootParameterIndex, uint num32BitValues,
+                                            uint destOffset)
+{
+    const uint64 errorCount = m_pStats->validationErrors;
+    NULL_BACKEND_VALIDATE(m_pStats, m_pRootSignature != nullptr, "Null backend: {} before root signature",
+                          pCommandName);
+    if (m_pRootSignature == nullptr) return false;
+    NULL_BACKEND_VALIDATE(m_pStats, rootParameterIndex < m_pRootSignature->NumParameters(),
+                          "Null backend: {} root parameter {} out of range", pCommandName, rootParameterIndex);
+    if (errorCount != m_pStats->validationErrors) return false;
+
+    const NullRootParameter& parameter = m_pRootSignature->GetParameter(rootParameterIndex);
+    NULL_BACKEND_VALIDATE(m_pStats, parameter.type == D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS,
+                          "Null backend: {} root parameter {} is not root constants", pCommandName, rootParameterIndex);
+    NULL_BACKEND_VALIDATE(m_pStats, destOffset + num32BitValues <= parameter.num32BitValues,
+                          "Null backend: {} writes {} values at {} into root parameter {}, which holds {}",
+                          pCommandName, num32BitValues, destOffset, rootParameterIndex, parameter.num32BitValues);
+    return (errorCount == m_pStats->validationErrors);
+}
+
+HRESULT NullCommandList::Close()
+{
+    if (!m_isOpen)
+    {
+        PrintMessage(Error, "Null backend: Close() on already closed command list \"{}\"", m_name);
+        m_pStats->validationErrors++;
+        return E_FAIL;
+    }
+
+    m_isOpen = false;
+    return S_OK;
+}
+
+HRESULT NullCommandList::Reset(ID3D12CommandAllocator* pAllocator, ID3D12PipelineState* pInitialState)
+{
+    NULL_BACKEND_VALIDATE(m_pStats, pAllocator != nullptr, "Null backend: Reset() on \"{}\" without an allocator", m_name);
+    NULL_BACKEND_VALIDATE(m_pStats, !m_isOpen, "Null backend: Reset() on open command list \"{}\"", m_name);
+
+    ClearState(pInitialState);
+    m_isOpen = true;
+    m_commandCount = 0;
+    return S_OK;
+}
+
+void NullCommandList::ClearState(ID3D12PipelineState* pPipelineState)
+{
+    m_pRootSignature    = nullptr;
+    m_pPipelineState    = static_cast<NullPipelineState*>(pPipelineState);
+    m_topology          = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+    m_indexBufferView   = {};
+    m_numRenderTargets  = 0;
+    m_pDepthStencil     = nullptr;
+    m_viewport          = {};
+    m_scissorRect       = {};
+    memset(m_vertexBufferViews, 0, sizeof(m_vertexBufferViews));
+    memset(m_rootAddresses, 0, sizeof(m_rootAddresses));
+    memset(m_rootConstants, 0, sizeof(m_rootConstants));
+    memset(m_pRenderTargets, 0, sizeof(m_pRenderTargets));
+}
+
+void NullCommandList::DrawInstanced(UINT vertexCountPerInstance, UINT instanceCount, UINT startVertexLocation,
+                                    UINT startInstanceLocation)
+{
+    if (IsRecording("DrawInstanced") && ValidateDrawState("DrawInstanced"))
+    {
+        m_pStats->drawCalls++;
+    }
+}
+
+void NullCommandList::DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation,
+                                           INT baseVertexLocation, UINT startInstanceLocation)
+{
+    if (IsRecording("DrawIndexedInstanced") && ValidateDrawState("DrawIndexedInstanced"))
+    {
+        const uint indexSize = (m_indexBufferView.Format == DXGI_FORMAT_R16_UINT) ? 2 : 4;
+        NULL_BACKEND_VALIDATE(m_pStats, m_indexBufferView.BufferLocation != 0, "Null backend: indexed draw without an index buffer");
+        NULL_BACKEND_VALIDATE(m_pStats, (startIndexLocation + indexCountPerInstance)*indexSize <= m_indexBufferView.SizeInBytes,
+                              "Null backend: indexed draw reads {} indices past the end of a {}B index buffer",
+                              startIndexLocation + indexCountPerInstance, m_indexBufferView.SizeInBytes);
+
+        m_pStats->drawCalls++;
+        m_pStats->indicesDrawn += uint64(indexCountPerInstance) * instanceCount;
+    }
+}
+
+void NullCommandList::CopyBufferRegion(ID3D12Resource* pDstBuffer, UINT64 dstOffset, ID3D12Resource* pSrcBuffer,
+                                       UINT64 srcOffset, UINT64 numBytes)
+{
+    if (IsRecording("CopyBufferRegion"))
+    {
+        // no queue to defer to, so copies land immediately
+        NullResource* pDst = static_cast<NullResource*>(pDstBuffer);
+        NullResource* pSrc = static_cast<NullResource*>(pSrcBuffer);
+        NULL_BACKEND_VALIDATE(m_pStats, dstOffset + numBytes <= pDst->GetSize() && srcOffset + numBytes <= pSrc->GetSize(),
+                              "Null backend: CopyBufferRegion() out of bounds");
+        memcpy(pDst->GetData() + dstOffset, pSrc->GetData() + srcOffset, numBytes);
+    }
+}
+
+void NullCommandList::CopyResource(ID3D12Resource* pDstResource, ID3D12Resource* pSrcResource)
+{
+    if (IsRecording("CopyResource"))
+    {
+        NullResource* pDst = static_cast<NullResource*>(pDstResource);
+        NullResource* pSrc = static_cast<NullResource*>(pSrcResource);
+        NULL_BACKEND_VALIDATE(m_pStats, pDst->GetSize() == pSrc->GetSize(), "Null backend: CopyResource() size mismatch");
+        memcpy(pDst->GetData(), pSrc->GetData(), min(pDst->GetSize(), pSrc->GetSize()));
+    }
+}
+
+void NullCommandList::IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY primitiveTopology)
+{
+    if (IsRecording("IASetPrimitiveTopology")) m_topology = primitiveTopology;
+}
+
+void NullCommandList::RSSetViewports(UINT numViewports, const D3D12_VIEWPORT* pViewports)
+{
+    if (IsRecording("RSSetViewports") && numViewports > 0) m_viewport = pViewports[0];
+}
+
+void NullCommandList::RSSetScissorRects(UINT numRects, const D3D12_RECT* pRects)
+{
+    if (IsRecording("RSSetScissorRects") && numRects > 0) m_scissorRect = pRects[0];
+}
+
+void NullCommandList::SetPipelineState(ID3D12PipelineState* pPipelineState)
+{
+    if (IsRecording("SetPipelineState")) m_pPipelineState = static_cast<NullPipelineState*>(pPipelineState);
+}
+
+void NullCommandList::ResourceBarrier(UINT numBarriers, const D3D12_RESOURCE_BARRIER* pBarriers)
+{
+    if (IsRecording("ResourceBarrier"))
+    {
+        for (uint i = 0; i < numBarriers; ++i)
+        {
+            if (pBarriers[i].Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION)
+            {
+                NULL_BACKEND_VALIDATE(m_pStats, pBarriers[i].Transition.StateBefore != pBarriers[i].Transition.StateAfter,
+                                      "Null backend: redundant transition barrier in \"{}\"", m_name);
+            }
+        }
+    }
+}
+
+void NullCommandList::SetDescriptorHeaps(UINT numDescriptorHeaps, ID3D12DescriptorHeap* const* ppDescriptorHeaps)
+{
+    if (IsRecording("SetDescriptorHeaps"))
+    {
+        for (uint i = 0; i < numDescriptorHeaps; ++i)
+        {
+            const D3D12_DESCRIPTOR_HEAP_DESC desc = ppDescriptorHeaps[i]->GetDesc();
+            NULL_BACKEND_VALIDATE(m_pStats, desc.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE,
+                                  "Null backend: SetDescriptorHeaps() given a non-shader-visible heap");
+        }
+    }
+}
+
+void NullCommandList::SetGraphicsRootSignature(ID3D12RootSignature* pRootSignature)
+{
+    if (IsRecording("SetGraphicsRootSignature"))
+    {
+        // changing root signature invalidates all root arguments
+        m_pRootSignature = static_cast<NullRootSignature*>(pRootSignature);
+        memset(m_rootAddresses, 0, sizeof(m_rootAddresses));
+        memset(m_rootConstants, 0, sizeof(m_rootConstants));
+    }
+}
+
+void NullCommandList::SetGraphicsRootDescriptorTable(UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+{
+    if (IsRecording("SetGraphicsRootDescriptorTable") && rootParameterIndex < MaxRootParameters)
+    {
+        m_rootAddresses[rootParameterIndex] = baseDescriptor.ptr;
+    }
+}
+
+void NullCommandList::SetGraphicsRoot32BitConstant(UINT rootParameterIndex, UINT srcData, UINT destOffset)
+{
+    if (IsRecording("SetGraphicsRoot32BitConstant") &&
+        ValidateRootConstants("SetGraphicsRoot32BitConstant", rootParameterIndex, 1, destOffset))
+    {
+        const NullRootParameter& parameter = m_pRootSignature->GetParameter(rootParameterIndex);
+        m_rootConstants[parameter.constantsOffset + destOffset] = srcData;
+    }
+}
+
+void NullCommandList::SetGraphicsRoot32BitConstants(UINT rootParameterIndex, UINT num32BitValues,
+                                                    const void* pSrcData, UINT destOffset)
+{
+    if (IsRecording("SetGraphicsRoot32BitConstants") &&
+        ValidateRootConstants("SetGraphicsRoot32BitConstants", rootParameterIndex, num32BitValues, destOffset))
+    {
+        const NullRootParameter& parameter = m_pRootSignature->GetParameter(rootParameterIndex);
+        memcpy(m_rootConstants + parameter.constantsOffset + destOffset, pSrcData, num32BitValues * sizeof(UINT));
+    }
+}
+
+void NullCommandList::SetGraphicsRootConstantBufferView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+{
+    if (IsRecording("SetGraphicsRootConstantBufferView"))
+    {
+        NULL_BACKEND_VALIDATE(m_pStats, m_pRootSignature != nullptr, "Null backend: root CBV set before root signature");
+        NULL_BACKEND_VALIDATE(m_pStats, m_pRootSignature == nullptr || rootParameterIndex < m_pRootSignature->NumParameters(),
+                              "Null backend: root parameter {} out of range", rootParameterIndex);
+        NULL_BACKEND_VALIDATE(m_pStats, bufferLocation % D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT == 0,
+                              "Null backend: root CBV at 0x{:X} is not 256B aligned", bufferLocation);
+
+        if (rootParameterIndex < MaxRootParameters) m_rootAddresses[rootParameterIndex] = bufferLocation;
+    }
+}
+
+void NullCommandList::IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView)
+{
+    if (IsRecording("IASetIndexBuffer"))
+    {
+        m_indexBufferView = (pView != nullptr) ? *pView : D3D12_INDEX_BUFFER_VIEW{};
+        NULL_BACKEND_VALIDATE(m_pStats, pView == nullptr ||
+                                        pView->Format == DXGI_FORMAT_R16_UINT || pView->Format == DXGI_FORMAT_R32_UINT,
+                              "Null backend: index buffer format must be R16_UINT or R32_UINT");
+    }
+}
+
+void NullCommandList::IASetVertexBuffers(UINT startSlot, UINT numViews, const D3D12_VERTEX_BUFFER_VIEW* pViews)
+{
+    if (IsRecording("IASetVertexBuffers"))
+    {
+        NULL_BACKEND_VALIDATE(m_pStats, startSlot + numViews <= D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT,
+                              "Null backend: vertex buffer slots [{},{}) out of range", startSlot, startSlot + numViews);
+
+        for (uint i = 0; i < numViews && startSlot + i < D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT; ++i)
+        {
+            m_vertexBufferViews[startSlot + i] = (pViews != nullptr) ? pViews[i] : D3D12_VERTEX_BUFFER_VIEW{};
+        }
+    }
+}
+
+void NullCommandList::OMSetRenderTargets(UINT numRenderTargetDescriptors,
+                                         const D3D12_CPU_DESCRIPTOR_HANDLE* pRenderTargetDescriptors,
+                                         BOOL rtsSingleHandleToDescriptorRange,
+                                         const D3D12_CPU_DESCRIPTOR_HANDLE* pDepthStencilDescriptor)
+{
+    if (IsRecording("OMSetRenderTargets"))
+    {
+        NULL_BACKEND_VALIDATE(m_pStats, numRenderTargetDescriptors <= D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT,
+                              "Null backend: {} render targets bound", numRenderTargetDescriptors);
+
+        m_numRenderTargets = min<uint>(numRenderTargetDescriptors, D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT);
+        for (uint i = 0; i < m_numRenderTargets; ++i)
+        {
+            m_pRenderTargets[i] = rtsSingleHandleToDescriptorRange ? NullDescriptorHeap::FromHandle(pRenderTargetDescriptors[0]) + i
+                                                                   : NullDescriptorHeap::FromHandle(pRenderTargetDescriptors[i]);
+            NULL_BACKEND_VALIDATE(m_pStats, m_pRenderTargets[i]->heapType == D3D12_DESCRIPTOR_HEAP_TYPE_RTV,
+                                  "Null backend: render target {} is not an RTV descriptor", i);
+        }
+
+        m_pDepthStencil = (pDepthStencilDescriptor != nullptr) ? NullDescriptorHeap::FromHandle(*pDepthStencilDescriptor) : nullptr;
+        NULL_BACKEND_VALIDATE(m_pStats, m_pDepthStencil == nullptr || m_pDepthStencil->heapType == D3D12_DESCRIPTOR_HEAP_TYPE_DSV,
+                              "Null backend: depth stencil is not a DSV descriptor");
+    }
+}
+
+void NullCommandList::ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView, D3D12_CLEAR_FLAGS clearFlags,
+                                            FLOAT depth, UINT8 stencil, UINT numRects, const D3D12_RECT* pRects)
+{
+    if (IsRecording("ClearDepthStencilView"))
+    {
+        NullDescriptor* pDescriptor = NullDescriptorHeap::FromHandle(depthStencilView);
+        NULL_BACKEND_VALIDATE(m_pStats, pDescriptor->pResource.Get() != nullptr, "Null backend: clearing an empty DSV descriptor");
+        NULL_BACKEND_VALIDATE(m_pStats, depth >= 0.0f && depth <= 1.0f, "Null backend: depth clear value {} outside [0,1]", depth);
+    }
+}
+
+void NullCommandList::ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView, const FLOAT colorRGBA[4],
+                                            UINT numRects, const D3D12_RECT* pRects)
+{
+    if (IsRecording("ClearRenderTargetView"))
+    {
+        NullDescriptor* pDescriptor = NullDescriptorHeap::FromHandle(renderTargetView);
+        NULL_BACKEND_VALIDATE(m_pStats, pDescriptor->pResource.Get() != nullptr, "Null backend: clearing an empty RTV descriptor");
+    }
+}
@@ -0,0 +1,449 @@
+// NullObjects - Stand-in implementations of the D3D12 interfaces handed out by the null backend.
+//
+// Clients of the engine record commands and map resources through the regular D3D12 interfaces. These objects accept
+//  those calls without a device, validating usage and tallying what would have been submitted. Resources are backed
+//  by CPU memory, and their GPU virtual addresses are simply CPU addresses, so buffer views and root descriptors built
+//  by clients remain dereferenceable. Descriptor handles likewise point directly at NullDescriptor entries.
+//
+// TODO: GetPrivateData() only knows about debug names, not data set with SetPrivateDataInterface()
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "RenderEngine.h"
+
+
+// reports a usage error and counts it against the backend's statistics
+#define NULL_BACKEND_VALIDATE(pStats, condition, ...)  \
+    if (!(condition))                                  \
+    {                                                  \
+        PrintMessage(Error, __VA_ARGS__);              \
+        (pStats)->validationErrors++;                  \
+    }
+
+uint BytesPerPixel(DXGI_FORMAT format);
+
+
+//**********************************************************************************************************************
+//                                                  Common Base
+//**********************************************************************************************************************
+template <typename Interface>
+class NullDeviceChild : public Interface
+{
+public:
+    NullDeviceChild(RenderEngineStats* pStats) : m_refCount(1), m_pStats(pStats) {}
+    virtual ~NullDeviceChild() {}
+
+    // IUnknown
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject)
+    {
+        if (ppvObject == nullptr) return E_POINTER;
+
+        if (riid == __uuidof(IUnknown) || riid == __uuidof(Interface))
+        {
+            AddRef();
+            *ppvObject = static_cast<Interface*>(this);
+            return S_OK;
+        }
+
+        *ppvObject = nullptr;
+        return E_NOINTERFACE;
+    }
+    ULONG STDMETHODCALLTYPE AddRef()
+    {
+        return ++m_refCount;
+    }
+    ULONG STDMETHODCALLTYPE Release()
+    {
+        const ULONG refCount = --m_refCount;
+        if (refCount == 0) delete this;
+        return refCount;
+    }
+
+    // ID3D12Object
+    HRESULT STDMETHODCALLTYPE GetPrivateData(REFGUID guid, UINT* pDataSize, void* pData)
+    {
+        if (guid != WKPDID_D3DDebugObjectName || pDataSize == nullptr) return E_FAIL;
+
+        if (pData != nullptr) memcpy(pData, m_name.c_str(), std::min<size_t>(*pDataSize, m_name.size()));
+        *pDataSize = static_cast<UINT>(m_name.size());
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE SetPrivateData(REFGUID guid, UINT dataSize, const void* pData)
+    {
+        if (guid == WKPDID_D3DDebugObjectName && pData != nullptr)
+        {
+            m_name.assign(static_cast<const char*>(pData), dataSize);
+        }
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE SetPrivateDataInterface(REFGUID guid, const IUnknown* pData)
+    {
+        // held until replaced or until this object is destroyed, as with D3D12
+        IUnknown* pInterface = const_cast<IUnknown*>(pData);
+        auto it = std::find_if(m_interfaces.begin(), m_interfaces.end(), [&](const auto& entry) {return entry.first == guid;});
+        if (it == m_interfaces.end())   {if (pInterface != nullptr) m_interfaces.emplace_back(guid, pInterface);}
+        else if (pInterface != nullptr) it->second = pInterface;
+        else                            m_interfaces.erase(it);
+        return S_OK;
+    }
+    HRESULT STDMETHODCALLTYPE SetName(LPCWSTR name)
+    {
+        m_name = ToNormalString(name);
+        return S_OK;
+    }
+
+    // ID3D12DeviceChild
+    HRESULT STDMETHODCALLTYPE GetDevice(REFIID riid, void** ppvDevice)
+    {
+        // there is no device to hand back
+        if (ppvDevice != nullptr) *ppvDevice = nullptr;
+        return E_NOINTERFACE;
+    }
+
+    const std::string& GetDebugName() const {return m_name;}
+
+protected:
+    std::atomic<ULONG>                              m_refCount;         // released from any thread, as in D3D12
+    RenderEngineStats*                              m_pStats;
+    std::string                                     m_name;
+    std::vector<std::pair<GUID, ComPtr<IUnknown>>>  m_interfaces;       // private data interfaces
+};
+
+
+//**********************************************************************************************************************
+//                                              Resources & Descriptors
+//**********************************************************************************************************************
+class NullResource : public NullDeviceChild<ID3D12Resource>
+{
+public:
+    NullResource(RenderEngineStats* pStats, const D3D12_HEAP_PROPERTIES& heapProperties, const D3D12_RESOURCE_DESC& desc);
+
+    // ID3D12Resource
+    HRESULT STDMETHODCALLTYPE Map(UINT subresource, const D3D12_RANGE* pReadRange, void** ppData);
+    void STDMETHODCALLTYPE Unmap(UINT subresource, const D3D12_RANGE* pWrittenRange);
+    D3D12_RESOURCE_DESC STDMETHODCALLTYPE GetDesc()                 {return m_desc;}
+    D3D12_GPU_VIRTUAL_ADDRESS STDMETHODCALLTYPE GetGPUVirtualAddress();
+    HRESULT STDMETHODCALLTYPE WriteToSubresource(UINT dstSubresource, const D3D12_BOX* pDstBox, const void* pSrcData,
+                                                 UINT srcRowPitch, UINT srcDepthPitch);
+    HRESULT STDMETHODCALLTYPE ReadFromSubresource(void* pDstData, UINT dstRowPitch, UINT dstDepthPitch,
+                                                  UINT srcSubresource, const D3D12_BOX* pSrcBox);
+    HRESULT STDMETHODCALLTYPE GetHeapProperties(D3D12_HEAP_PROPERTIES* pHeapProperties, D3D12_HEAP_FLAGS* pHeapFlags);
+
+    // backend access to the underlying memory
+    UINT8* GetData()                {return m_pData.get();}
+    uint64 GetSize() const          {return m_size;}
+    uint64 GetRowPitch() const      {return m_rowPitch;}
+    const D3D12_HEAP_PROPERTIES& GetHeapProperties() const {return m_heapProperties;}
+
+protected:
+    // for backends which provide their own memory, such as a mapped device allocation
+    NullResource(RenderEngineStats* pStats, const D3D12_HEAP_PROPERTIES& heapProperties, const D3D12_RESOURCE_DESC& desc,
+                 bool allocate);
+    void SetExternalData(UINT8* pData);
+
+private:
+    struct AlignedDeleter
+    {
+        bool owned = true;  // external memory belongs to whoever provided it
+        void operator()(UINT8* pData) const;
+    };
+
+    D3D12_HEAP_PROPERTIES                       m_heapProperties;
+    D3D12_RESOURCE_DESC                         m_desc;
+    std::unique_ptr<UINT8[], AlignedDeleter>    m_pData;
+    uint64                                      m_size;
+    uint64                                      m_rowPitch;     // bytes per row of mip 0 for textures
+    uint                                        m_mapCount;
+};
+
+
+// a descriptor simply remembers which resource it views and how, keeping that resource alive while it does
+struct NullDescriptor
+{
+    ComPtr<NullResource>        pResource;
+    D3D12_DESCRIPTOR_HEAP_TYPE  heapType;
+    DXGI_FORMAT                 format;
+};
+
+class NullDescriptorHeap : public NullDeviceChild<ID3D12DescriptorHeap>
+{
+public:
+    NullDescriptorHeap(RenderEngineStats* pStats, const D3D12_DESCRIPTOR_HEAP_DESC& desc);
+
+    // ID3D12DescriptorHeap
+    D3D12_DESCRIPTOR_HEAP_DESC STDMETHODCALLTYPE GetDesc()                              {return m_desc;}
+    D3D12_CPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetCPUDescriptorHandleForHeapStart();
+    D3D12_GPU_DESCRIPTOR_HANDLE STDMETHODCALLTYPE GetGPUDescriptorHandleForHeapStart();
+
+    static NullDescriptor* FromHandle(D3D12_CPU_DESCRIPTOR_HANDLE handle)   {return reinterpret_cast<NullDescriptor*>(handle.ptr);}
+    static NullDescriptor* FromHandle(D3D12_GPU_DESCRIPTOR_HANDLE handle)   {return reinterpret_cast<NullDescriptor*>(handle.ptr);}
+
+private:
+    D3D12_DESCRIPTOR_HEAP_DESC  m_desc;
+    std::vector<NullDescriptor> m_descriptors;
+};
+
+
+//**********************************************************************************************************************
+//                                                  Pipeline Objects
+//**********************************************************************************************************************
+// a root parameter, as far as command lists need it to validate and resolve root arguments
+struct NullRootParameter
+{
+    D3D12_ROOT_PARAMETER_TYPE   type;
+    D3D12_SHADER_VISIBILITY     visibility;
+    uint                        shaderRegister;     // of root constants and descriptors
+    uint                        registerSpace;
+    uint                        num32BitValues;     // of root constants
+    uint                        constantsOffset;    // of root constants, in DWORDs from the first parameter's
+};
+
+class NullRootSignature : public NullDeviceChild<ID3D12RootSignature>
+{
+public:
+    NullRootSignature(RenderEngineStats* pStats, const CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC& desc);
+
+    uint NumParameters() const                              {return static_cast<uint>(m_parameters.size());}
+    const NullRootParameter& GetParameter(uint index) const {return m_parameters[index];}
+
+    // the root CBV or root constants a constant buffer register is bound by, or -1 if neither
+    int FindConstantBuffer(uint shaderRegister, uint registerSpace) const;
+
+private:
+    std::vector<NullRootParameter> m_parameters;
+};
+
+
+// The PSO retains the fixed-function state a CPU rasterizer would need. Shader bytecode is not interpreted.
+class NullPipelineState : public NullDeviceChild<ID3D12PipelineState>
+{
+public:
+    NullPipelineState(RenderEngineStats* pStats, const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc);
+
+    // ID3D12PipelineState
+    HRESULT STDMETHODCALLTYPE GetCachedBlob(ID3DBlob** ppBlob)  {return E_NOTIMPL;}
+
+    const D3D12_RASTERIZER_DESC& GetRasterizerState() const         {return m_rasterizerState;}
+    const D3D12_DEPTH_STENCIL_DESC& GetDepthStencilState() const    {return m_depthStencilState;}
+    const std::vector<D3D12_INPUT_ELEMENT_DESC>& GetInputLayout() const {return m_inputLayout;}
+
+private:
+    D3D12_RASTERIZER_DESC                   m_rasterizerState;
+    D3D12_DEPTH_STENCIL_DESC                m_depthStencilState;
+    std::vector<D3D12_INPUT_ELEMENT_DESC>   m_inputLayout;
+    std::vector<std::string>                m_semanticNames;    // backing storage for m_inputLayout
+};
+
+
+class NullCommandAllocator : public NullDeviceChild<ID3D12CommandAllocator>
+{
+public:
+    NullCommandAllocator(RenderEngineStats* pStats) : NullDeviceChild(pStats) {}
+
+    // ID3D12CommandAllocator
+    HRESULT STDMETHODCALLTYPE Reset()   {return S_OK;}
+};
+
+
+//**********************************************************************************************************************
+//                                                  Command List
+//**********************************************************************************************************************
+// Tracks bound state so that draws can be validated, and counts what is recorded. Everything beyond the handful of
+//  calls Shade makes is accepted and ignored. Derived backends may override the draw calls to actually execute them.
+class NullCommandList : public NullDeviceChild<ID3D12GraphicsCommandList6>
+{
+public:
+    NullCommandList(RenderEngineStats* pStats);
+
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject);
+
+    // ID3D12CommandList
+    D3D12_COMMAND_LIST_TYPE STDMETHODCALLTYPE GetType() {return D3D12_COMMAND_LIST_TYPE_DIRECT;}
+
+    // ID3D12GraphicsCommandList
+    HRESULT STDMETHODCALLTYPE Close();
+    HRESULT STDMETHODCALLTYPE Reset(ID3D12CommandAllocator* pAllocator, ID3D12PipelineState* pInitialState);
+    void STDMETHODCALLTYPE ClearState(ID3D12PipelineState* pPipelineState);
+    void STDMETHODCALLTYPE DrawInstanced(UINT vertexCountPerInstance, UINT instanceCount, UINT startVertexLocation,
+                                         UINT startInstanceLocation);
+    void STDMETHODCALLTYPE DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation,
+                                                INT baseVertexLocation, UINT startInstanceLocation);
+    void STDMETHODCALLTYPE Dispatch(UINT x, UINT y, UINT z)                                 {IsRecording("Dispatch");}
+    void STDMETHODCALLTYPE CopyBufferRegion(ID3D12Resource* pDstBuffer, UINT64 dstOffset, ID3D12Resource* pSrcBuffer,
+                                            UINT64 srcOffset, UINT64 numBytes);
+    void STDMETHODCALLTYPE CopyTextureRegion(const D3D12_TEXTURE_COPY_LOCATION* pDst, UINT dstX, UINT dstY, UINT dstZ,
+                                             const D3D12_TEXTURE_COPY_LOCATION* pSrc, const D3D12_BOX* pSrcBox)
+                                                                                            {IsRecording("CopyTextureRegion");}
+    void STDMETHODCALLTYPE CopyResource(ID3D12Resource* pDstResource, ID3D12Resource* pSrcResource);
+    void STDMETHODCALLTYPE CopyTiles(ID3D12Resource* pTiledResource, const D3D12_TILED_RESOURCE_COORDINATE* pStart,
+                                     const D3D12_TILE_REGION_SIZE* pSize, ID3D12Resource* pBuffer, UINT64 bufferOffset,
+                                     D3D12_TILE_COPY_FLAGS flags)                           {IsRecording("CopyTiles");}
+    void STDMETHODCALLTYPE ResolveSubresource(ID3D12Resource* pDstResource, UINT dstSubresource,
+                                              ID3D12Resource* pSrcResource, UINT srcSubresource, DXGI_FORMAT format)
+                                                                                            {IsRecording("ResolveSubresource");}
+    void STDMETHODCALLTYPE IASetPrimitiveTopology(D3D12_PRIMITIVE_TOPOLOGY primitiveTopology);
+    void STDMETHODCALLTYPE RSSetViewports(UINT numViewports, const D3D12_VIEWPORT* pViewports);
+    void STDMETHODCALLTYPE RSSetScissorRects(UINT numRects, const D3D12_RECT* pRects);
+    void STDMETHODCALLTYPE OMSetBlendFactor(const FLOAT blendFactor[4])                     {IsRecording("OMSetBlendFactor");}
+    void STDMETHODCALLTYPE OMSetStencilRef(UINT stencilRef)                                 {IsRecording("OMSetStencilRef");}
+    void STDMETHODCALLTYPE SetPipelineState(ID3D12PipelineState* pPipelineState);
+    void STDMETHODCALLTYPE ResourceBarrier(UINT numBarriers, const D3D12_RESOURCE_BARRIER* pBarriers);
+    void STDMETHODCALLTYPE ExecuteBundle(ID3D12GraphicsCommandList* pCommandList)           {IsRecording("ExecuteBundle");}
+    void STDMETHODCALLTYPE SetDescriptorHeaps(UINT numDescriptorHeaps, ID3D12DescriptorHeap* const* ppDescriptorHeaps);
+    void STDMETHODCALLTYPE SetComputeRootSignature(ID3D12RootSignature* pRootSignature)     {IsRecording("SetComputeRootSignature");}
+    void STDMETHODCALLTYPE SetGraphicsRootSignature(ID3D12RootSignature* pRootSignature);
+    void STDMETHODCALLTYPE SetComputeRootDescriptorTable(UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor)
+                                                                                            {IsRecording("SetComputeRootDescriptorTable");}
+    void STDMETHODCALLTYPE SetGraphicsRootDescriptorTable(UINT rootParameterIndex, D3D12_GPU_DESCRIPTOR_HANDLE baseDescriptor);
+    void STDMETHODCALLTYPE SetComputeRoot32BitConstant(UINT rootParameterIndex, UINT srcData, UINT destOffset)
+                                                                                            {IsRecording("SetComputeRoot32BitConstant");}
+    void STDMETHODCALLTYPE SetGraphicsRoot32BitConstant(UINT rootParameterIndex, UINT srcData, UINT destOffset);
+    void STDMETHODCALLTYPE SetComputeRoot32BitConstants(UINT rootParameterIndex, UINT num32BitValues,
+                                                        const void* pSrcData, UINT destOffset)
+                                                                                            {IsRecording("SetComputeRoot32BitConstants");}
+    void STDMETHODCALLTYPE SetGraphicsRoot32BitConstants(UINT rootParameterIndex, UINT num32BitValues,
+                                                         const void* pSrcData, UINT destOffset);
+    void STDMETHODCALLTYPE SetComputeRootConstantBufferView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+                                                                                            {IsRecording("SetComputeRootConstantBufferView");}
+    void STDMETHODCALLTYPE SetGraphicsRootConstantBufferView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation);
+    void STDMETHODCALLTYPE SetComputeRootShaderResourceView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+                                                                                            {IsRecording("SetComputeRootShaderResourceView");}
+    void STDMETHODCALLTYPE SetGraphicsRootShaderResourceView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+                                                                                            {IsRecording("SetGraphicsRootShaderResourceView");}
+    void STDMETHODCALLTYPE SetComputeRootUnorderedAccessView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+                                                                                            {IsRecording("SetComputeRootUnorderedAccessView");}
+    void STDMETHODCALLTYPE SetGraphicsRootUnorderedAccessView(UINT rootParameterIndex, D3D12_GPU_VIRTUAL_ADDRESS bufferLocation)
+                                                                                            {IsRecording("SetGraphicsRootUnorderedAccessView");}
+    void STDMETHODCALLTYPE IASetIndexBuffer(const D3D12_INDEX_BUFFER_VIEW* pView);
+    void STDMETHODCALLTYPE IASetVertexBuffers(UINT startSlot, UINT numViews, const D3D12_VERTEX_BUFFER_VIEW* pViews);
+    void STDMETHODCALLTYPE SOSetTargets(UINT startSlot, UINT numViews, const D3D12_STREAM_OUTPUT_BUFFER_VIEW* pViews)
+                                                                                            {IsRecording("SOSetTargets");}
+    void STDMETHODCALLTYPE OMSetRenderTargets(UINT numRenderTargetDescriptors,
+                                              const D3D12_CPU_DESCRIPTOR_HANDLE* pRenderTargetDescriptors,
+                                              BOOL rtsSingleHandleToDescriptorRange,
+                                              const D3D12_CPU_DESCRIPTOR_HANDLE* pDepthStencilDescriptor);
+    void STDMETHODCALLTYPE ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView, D3D12_CLEAR_FLAGS clearFlags,
+                                                 FLOAT depth, UINT8 stencil, UINT numRects, const D3D12_RECT* pRects);
+    void STDMETHODCALLTYPE ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView, const FLOAT colorRGBA[4],
+                                                 UINT numRects, const D3D12_RECT* pRects);
+    void STDMETHODCALLTYPE ClearUnorderedAccessViewUint(D3D12_GPU_DESCRIPTOR_HANDLE viewGpuHandle,
+                                                        D3D12_CPU_DESCRIPTOR_HANDLE viewCpuHandle, ID3D12Resource* pResource,
+                                                        const UINT values[4], UINT numRects, const D3D12_RECT* pRects)
+                                                                                            {IsRecording("ClearUnorderedAccessViewUint");}
+    void STDMETHODCALLTYPE ClearUnorderedAccessViewFloat(D3D12_GPU_DESCRIPTOR_HANDLE viewGpuHandle,
+                                                         D3D12_CPU_DESCRIPTOR_HANDLE viewCpuHandle, ID3D12Resource* pResource,
+                                                         const FLOAT values[4], UINT numRects, const D3D12_RECT* pRects)
+                                                                                            {IsRecording("ClearUnorderedAccessViewFloat");}
+    void STDMETHODCALLTYPE DiscardResource(ID3D12Resource* pResource, const D3D12_DISCARD_REGION* pRegion)
+                                                                                            {IsRecording("DiscardResource");}
+    void STDMETHODCALLTYPE BeginQuery(ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE type, UINT index)
+                                                                                            {IsRecording("BeginQuery");}
+    void STDMETHODCALLTYPE EndQuery(ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE type, UINT index)
+                                                                                            {IsRecording("EndQuery");}
+    void STDMETHODCALLTYPE ResolveQueryData(ID3D12QueryHeap* pQueryHeap, D3D12_QUERY_TYPE type, UINT startIndex,
+                                            UINT numQueries, ID3D12Resource* pDestinationBuffer, UINT64 alignedOffset)
+                                                                                            {IsRecording("ResolveQueryData");}
+    void STDMETHODCALLTYPE SetPredication(ID3D12Resource* pBuffer, UINT64 alignedOffset, D3D12_PREDICATION_OP operation)
+                                                                                            {IsRecording("SetPredication");}
+    void STDMETHODCALLTYPE SetMarker(UINT metadata, const void* pData, UINT size)           {IsRecording("SetMarker");}
+    void STDMETHODCALLTYPE BeginEvent(UINT metadata, const void* pData, UINT size)          {IsRecording("BeginEvent");}
+    void STDMETHODCALLTYPE EndEvent()                                                       {IsRecording("EndEvent");}
+    void STDMETHODCALLTYPE ExecuteIndirect(ID3D12CommandSignature* pCommandSignature, UINT maxCommandCount,
+                                           ID3D12Resource* pArgumentBuffer, UINT64 argumentBufferOffset,
+                                           ID3D12Resource* pCountBuffer, UINT64 countBufferOffset)
+                                                                                            {IsRecording("ExecuteIndirect");}
+
+    // ID3D12GraphicsCommandList1
+    void STDMETHODCALLTYPE AtomicCopyBufferUINT(ID3D12Resource* pDstBuffer, UINT64 dstOffset, ID3D12Resource* pSrcBuffer,
+                                                UINT64 srcOffset, UINT dependencies,
+                                                ID3D12Resource* const* ppDependentResources,
+                                                const D3D12_SUBRESOURCE_RANGE_UINT64* pDependentSubresourceRanges)
+                                                                                            {IsRecording("AtomicCopyBufferUINT");}
+    void STDMETHODCALLTYPE AtomicCopyBufferUINT64(ID3D12Resource* pDstBuffer, UINT64 dstOffset, ID3D12Resource* pSrcBuffer,
+                                                  UINT64 srcOffset, UINT dependencies,
+                                                  ID3D12Resource* const* ppDependentResources,
+                                                  const D3D12_SUBRESOURCE_RANGE_UINT64* pDependentSubresourceRanges)
+                                                                                            {IsRecording("AtomicCopyBufferUINT64");}
+    void STDMETHODCALLTYPE OMSetDepthBounds(FLOAT min, FLOAT max)                           {IsRecording("OMSetDepthBounds");}
+    void STDMETHODCALLTYPE SetSamplePositions(UINT numSamplesPerPixel, UINT numPixels,
+                                              D3D12_SAMPLE_POSITION* pSamplePositions)      {IsRecording("SetSamplePositions");}
+    void STDMETHODCALLTYPE ResolveSubresourceRegion(ID3D12Resource* pDstResource, UINT dstSubresource, UINT dstX, UINT dstY,
+                                                    ID3D12Resource* pSrcResource, UINT srcSubresource, D3D12_RECT* pSrcRect,
+                                                    DXGI_FORMAT format, D3D12_RESOLVE_MODE resolveMode)
+                                                                                            {IsRecording("ResolveSubresourceRegion");}
+    void STDMETHODCALLTYPE SetViewInstanceMask(UINT mask)                                   {IsRecording("SetViewInstanceMask");}
+
+    // ID3D12GraphicsCommandList2
+    void STDMETHODCALLTYPE WriteBufferImmediate(UINT count, const D3D12_WRITEBUFFERIMMEDIATE_PARAMETER* pParams,
+                                                const D3D12_WRITEBUFFERIMMEDIATE_MODE* pModes)
+                                                                                            {IsRecording("WriteBufferImmediate");}
+
+    // ID3D12GraphicsCommandList3
+    void STDMETHODCALLTYPE SetProtectedResourceSession(ID3D12ProtectedResourceSession* pProtectedResourceSession)
+                                                                                            {IsRecording("SetProtectedResourceSession");}
+
+    // ID3D12GraphicsCommandList4
+    void STDMETHODCALLTYPE BeginRenderPass(UINT numRenderTargets, const D3D12_RENDER_PASS_RENDER_TARGET_DESC* pRenderTargets,
+                                           const D3D12_RENDER_PASS_DEPTH_STENCIL_DESC* pDepthStencil,
+                                           D3D12_RENDER_PASS_FLAGS flags)                   {IsRecording("BeginRenderPass");}
+    void STDMETHODCALLTYPE EndRenderPass()                                                  {IsRecording("EndRenderPass");}
+    void STDMETHODCALLTYPE InitializeMetaCommand(ID3D12MetaCommand* pMetaCommand, const void* pData, SIZE_T dataSize)
+                                                                                            {IsRecording("InitializeMetaCommand");}
+    void STDMETHODCALLTYPE ExecuteMetaCommand(ID3D12MetaCommand* pMetaCommand, const void* pData, SIZE_T dataSize)
+                                                                                            {IsRecording("ExecuteMetaCommand");}
+    void STDMETHODCALLTYPE BuildRaytracingAccelerationStructure(
+        const D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC* pDesc, UINT numPostbuildInfoDescs,
+        const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC* pPostbuildInfoDescs)
+                                                                                            {IsRecording("BuildRaytracingAccelerationStructure");}
+    void STDMETHODCALLTYPE EmitRaytracingAccelerationStructurePostbuildInfo(
+        const D3D12_RAYTRACING_ACCELERATION_STRUCTURE_POSTBUILD_INFO_DESC* pDesc, UINT numSourceAccelerationStructures,
+        const D3D12_GPU_VIRTUAL_ADDRESS* pSourceAccelerationStructureData)
+                                                                                            {IsRecording("EmitRaytracingAccelerationStructurePostbuildInfo");}
+    void STDMETHODCALLTYPE CopyRaytracingAccelerationStructure(D3D12_GPU_VIRTUAL_ADDRESS destData,
+                                                               D3D12_GPU_VIRTUAL_ADDRESS sourceData,
+                                                               D3D12_RAYTRACING_ACCELERATION_STRUCTURE_COPY_MODE mode)
+                                                                                            {IsRecording("CopyRaytracingAccelerationStructure");}
+    void STDMETHODCALLTYPE SetPipelineState1(ID3D12StateObject* pStateObject)               {IsRecording("SetPipelineState1");}
+    void STDMETHODCALLTYPE DispatchRays(const D3D12_DISPATCH_RAYS_DESC* pDesc)              {IsRecording("DispatchRays");}
+
+    // ID3D12GraphicsCommandList5
+    void STDMETHODCALLTYPE RSSetShadingRate(D3D12_SHADING_RATE baseShadingRate, const D3D12_SHADING_RATE_COMBINER* combiners)
+                                                                                            {IsRecording("RSSetShadingRate");}
+    void STDMETHODCALLTYPE RSSetShadingRateImage(ID3D12Resource* pShadingRateImage)         {IsRecording("RSSetShadingRateImage");}
+
+    // ID3D12GraphicsCommandList6
+    void STDMETHODCALLTYPE DispatchMesh(UINT x, UINT y, UINT z)                             {IsRecording("DispatchMesh");}
+
+    // backend queries
+    bool IsOpen() const             {return m_isOpen;}
+    uint64 CommandCount() const     {return m_commandCount;}
+
+protected:
+    static constexpr uint MaxRootParameters = 64;   // root signatures are limited to 64 DWORDs
+
+    bool IsRecording(const char* pCommandName);
+    bool ValidateDrawState(const char* pCommandName);
+    bool ValidateRootConstants(const char* pCommandName, uint rootParameterIndex, uint num32BitValues, uint destOffset);
+
+    // recording state
+    bool                        m_isOpen;
+    uint64                      m_commandCount;
+
+    // bound state
+    NullRootSignature*          m_pRootSignature;
+    NullPipelineState*          m_pPipelineState;
+    D3D12_PRIMITIVE_TOPOLOGY    m_topology;
+    D3D12_INDEX_BUFFER_VIEW     m_indexBufferView;
+    D3D12_VERTEX_BUFFER_VIEW    m_vertexBufferViews[D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+    D3D12_GPU_VIRTUAL_ADDRESS   m_rootAddresses[MaxRootParameters];  // root CBVs and descriptor tables
+    UINT                        m_rootConstants[MaxRootParameters];  // of every parameter, at its constants offset
+    NullDescriptor*             m_pRenderTargets[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT];
+    uint                        m_numRenderTargets;
+    NullDescriptor*             m_pDepthStencil;
+    D3D12_VIEWPORT              m_viewport;
+    D3D12_RECT                  m_scissorRect;
+};
@@ -0,0 +1,338 @@
+#include "NullRenderEngine.h"
+
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
+#include "Scene.h"
+
+
+using namespace std;
+
+
+//**********************************************************************************************************************
+//                                              Constructors & Destructors
+//**********************************************************************************************************************
+NullRenderEngine::NullRenderEngine(UINT width, UINT height) :
+    NullRenderEngine(width, height, L"Null Render Engine")
+{
+}
+
+NullRenderEngine::NullRenderEngine(UINT width, UINT height, wstring name) :
+    RenderEngine(width, height, name),
+    m_srvCount(0),
+    m_pImGuiContext(nullptr),
+    m_pImNodesContext(nullptr),
+    m_frameCount(0)
+{
+}
+
+
+//**********************************************************************************************************************
+//                                              Engine Primary Interfaces
+//**********************************************************************************************************************
+void NullRenderEngine::Init(const WindowHandle window)
+{
+    m_window = window;
+
+    // SRV heap mirrors the D3D12 engine so that viewports can register their textures
+    D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
+    srvHeapDesc.NumDescriptors = 1024;
+    srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+    srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+    CheckResult(CreateDescriptorHeap(&srvHeapDesc, &m_pSrvHeap));
+
+    // ImGui runs without platform or renderer backends, so we fill in what they would have provided
+    {
+        MemoryTracker::InstallImGuiAllocator();
+        m_pImGuiContext = ImGui::CreateContext();
+        m_pImNodesContext = ImNodes::CreateContext();
+        ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_DockingEnable;
+
+        auto& io = ImGui::GetIO();
+        io.DisplaySize = ImVec2(static_cast<float>(m_width), static_cast<float>(m_height));
+        io.DeltaTime = 1.0f / 60.0f;
+        io.IniFilename = nullptr;   // headless runs should not clobber the interactive layout
+
+        // the atlas must be built before the first frame, even though it is never uploaded
+        unsigned char* pPixels = nullptr;
+        int fontWidth = 0;
+        int fontHeight = 0;
+        io.Fonts->AddFontDefault();
+        io.Fonts->GetTexDataAsRGBA32(&pPixels, &fontWidth, &fontHeight);
+        m_srvCount++; // entry 0 is used for text glyphs
+    }
+
+    PrintMessage(Info, "Null engine initialized at {}x{}", m_width, m_height);
+}
+
+void NullRenderEngine::OnUpdate()
+{
+    // the scene updates within the frame graph
+}
+
+void NullRenderEngine::PreRender()
+{
+    PROFILE_SCOPE("ImGui::NewFrame");
+    ImGui::NewFrame();
+}
+
+void NullRenderEngine::OnRender()
+{
+    if (!m_frameGraph.IsCompiled()) BuildFrameGraph();
+
+    m_frameStats.BeginFrame();
+    m_frameGraph.Execute(JobSystem::Get(), &m_frameStats);
+    m_frameStats.EndFrame();
+    FrameArena::EndFrame();
+    PROFILE_FRAME();
+}
+
+void NullRenderEngine::PostRender()
+{
+    m_frameCount++;
+}
+
+void NullRenderEngine::Flush()
+{
+    // all work completes as it is recorded, so there is never anything in flight
+}
+
+void NullRenderEngine::OnDestroy()
+{
+    if (m_pImNodesContext != nullptr) ImNodes::DestroyContext(m_pImNodesContext);
+    if (m_pImGuiContext != nullptr)   ImGui::DestroyContext(m_pImGuiContext);
+    m_pImNodesContext = nullptr;
+    m_pImGuiContext = nullptr;
+}
+
+
+//**********************************************************************************************************************
+//                                              Mediated API Access
+//**********************************************************************************************************************
+HRESULT NullRenderEngine::CreateCommandAllocator(ID3D12CommandAllocator** ppCommandAllocator)
+{
+    *ppCommandAllocator = new NullCommandAllocator(&m_stats);
+    return S_OK;
+}
+
+HRESULT NullRenderEngine::CreateCommandList(ID3D12GraphicsCommandList6** ppCommandList)
+{
+    *ppCommandList = new NullCommandList(&m_stats);
+    m_stats.commandListsCreated++;
+    return S_OK;
+}
+
+HRESULT NullRenderEngine::CreateRootSignature(CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC* pDesc, ID3D12RootSignature** ppRootSignature)
+{
+    // Tally the root signature's cost the same way the runtime does. Tables cost one DWORD, root descriptors two, and
+    //  root constants one per value.
+    uint numParameters = 0;
+    uint cost = 0;
+    if (pDesc->Version == D3D_ROOT_SIGNATURE_VERSION_1_1)
+    {
+        numParameters = pDesc->Desc_1_1.NumParameters;
+        for (uint i = 0; i < numParameters; ++i)
+        {
+            const D3D12_ROOT_PARAMETER1& parameter = pDesc->Desc_1_1.pParameters[i];
+            cost += (parameter.ParameterType == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE) ? 1 :
+                    (parameter.ParameterType == D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS)  ? parameter.Constants.Num32BitValues : 2;
+        }
+    }
+    else
+    {
+        numParameters = pDesc->Desc_1_0.NumParameters;
+        for (uint i = 0; i < numParameters; ++i)
+        {
+            const D3D12_ROOT_PARAMETER& parameter = pDesc->Desc_1_0.pParameters[i];
+            cost += (parameter.ParameterType == D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE) ? 1 :
+                    (parameter.ParameterType == D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS)  ? parameter.Constants.Num32BitValues : 2;
+        }
+    }
+
+    if (cost > D3D12_MAX_ROOT_COST)
+    {
+        PrintMessage(Error, "Root signature serialization failed:\nroot signature costs {} DWORDs, limit is {}", cost, D3D12_MAX_ROOT_COST);
+        m_stats.validationErrors++;
+        return E_INVALIDARG;
+    }
+
+    NullRootSignature* pRootSignature = NewRootSignature(*pDesc);
+    if (pRootSignature == nullptr) return E_FAIL;
+
+    *ppRootSignature = pRootSignature;
+    m_stats.rootSignaturesCreated++;
+    return S_OK;
+}
+
+HRESULT NullRenderEngine::CreatePipelineState(D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc,
+                                              ID3D12PipelineState**               ppPipelineState)
+{
+    NULL_BACKEND_VALIDATE(&m_stats, pDesc->pRootSignature != nullptr, "Null backend: PSO created without a root signature");
+    NULL_BACKEND_VALIDATE(&m_stats, pDesc->VS.pShaderBytecode != nullptr, "Null backend: PSO created without a vertex shader");
+
+    NullPipelineState* pPipelineState = NewPipelineState(pDesc);
+    if (pPipelineState == nullptr) return E_FAIL;
+
+    *ppPipelineState = pPipelineState;
+    m_stats.pipelineStatesCreated++;
+    return S_OK;
+}
+
+HRESULT NullRenderEngine::CreatePipelineState(D3D12_PIPELINE_STATE_STREAM_DESC* pStreamDesc,
+                                              ID3D12PipelineState**             ppPipelineState)
+{
+    // stream subobjects are not parsed, so fixed-function state takes on D3D12 defaults
+    NullPipelineState* pPipelineState = NewPipelineState(nullptr);
+    if (pPipelineState == nullptr) return E_FAIL;
+
+    *ppPipelineState = pPipelineState;
+    m_stats.pipelineStatesCreated++;
+    return S_OK;
+}
+
+HRESULT NullRenderEngine::CreateResource(const D3D12_HEAP_PROPERTIES* pHeapProperties,
+                                         const D3D12_RESOURCE_DESC*   pDesc,
+                                         D3D12_RESOURCE_STATES        initialState,
+                                         const D3D12_CLEAR_VALUE*     pClearValue,
+                                         ID3D12Resource**             ppResource)
+{
+    if (pDesc->Dimension == D3D12_RESOURCE_DIMENSION_BUFFER && pHeapProperties->Type == D3D12_HEAP_TYPE_UPLOAD)
+    {
+        NULL_BACKEND_VALIDATE(&m_stats, initialState == D3D12_RESOURCE_STATE_GENERIC_READ,
+                              "Null backend: upload heap resources must start in GENERIC_READ");
+    }
+
+    NullResource* pResource = NewResource(*pHeapProperties, *pDesc);
+    if (pResource == nullptr) return E_OUTOFMEMORY;
+
+    m_stats.resourcesCreated++;
+    m_stats.resourceBytes[pHeapProperties->Type] += pResource->GetSize();
+    MemoryTracker::TrackResource(pResource, pHeapProperties->Type, pResource->GetSize());
+
+    *ppResource = pResource;
+    return S_OK;
+}
+
+HRESULT NullRenderEngine::CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC* pDesc,
+                                               ID3D12DescriptorHeap**            ppDescriptorHeap)
+{
+    const bool canBeShaderVisible = (pDesc->Type == D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) ||
+                                    (pDesc->Type == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+    if (!canBeShaderVisible && (pDesc->Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE))
+    {
+        PrintMessage(Error, "Null backend: RTV and DSV heaps cannot be shader visible");
+        m_stats.validationErrors++;
+        return E_INVALIDARG;
+    }
+
+    *ppDescriptorHeap = new NullDescriptorHeap(&m_stats, *pDesc);
+    m_stats.descriptorHeapsCreated++;
+    return S_OK;
+}
+
+void NullRenderEngine::CreateRenderTargetView(ID3D12Resource*                      pResource,
+                                              const D3D12_RENDER_TARGET_VIEW_DESC* pDesc,
+                                              D3D12_CPU_DESCRIPTOR_HANDLE          destDescriptor)
+{
+    NullDescriptor* pDescriptor = NullDescriptorHeap::FromHandle(destDescriptor);
+    NULL_BACKEND_VALIDATE(&m_stats, pDescriptor->heapType == D3D12_DESCRIPTOR_HEAP_TYPE_RTV,
+                          "Null backend: RTV written into a non-RTV heap");
+
+    pDescriptor->pResource = static_cast<NullResource*>(pResource);
+    pDescriptor->format = (pDesc != nullptr) ? pDesc->Format : pResource->GetDesc().Format;
+}
+
+void NullRenderEngine::CreateDepthStencilView(ID3D12Resource*                      pResource,
+                                              const D3D12_DEPTH_STENCIL_VIEW_DESC* pDesc,
+                                              D3D12_CPU_DESCRIPTOR_HANDLE          destDescriptor)
+{
+    NullDescriptor* pDescriptor = NullDescriptorHeap::FromHandle(destDescriptor);
+    NULL_BACKEND_VALIDATE(&m_stats, pDescriptor->heapType == D3D12_DESCRIPTOR_HEAP_TYPE_DSV,
+                          "Null backend: DSV written into a non-DSV heap");
+
+    pDescriptor->pResource = static_cast<NullResource*>(pResource);
+    pDescriptor->format = (pDesc != nullptr) ? pDesc->Format : pResource->GetDesc().Format;
+}
+
+void NullRenderEngine::ExecuteCommandList(ID3D12GraphicsCommandList6* pCommandList)
+{
+    NullCommandList* pNullCommandList = static_cast<NullCommandList*>(pCommandList);
+    NULL_BACKEND_VALIDATE(&m_stats, !pNullCommandList->IsOpen(), "Null backend: executing a command list that was not closed");
+    m_stats.commandListsExecuted++;
+}
+
+
+//**********************************************************************************************************************
+//                                                  Debug & Global UI
+//**********************************************************************************************************************
+D3D12_GPU_DESCRIPTOR_HANDLE NullRenderEngine::AddSrvForResource(D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc, ComPtr<ID3D12Resource> pResource)
+{
+    if (m_srvCount >= m_pSrvHeap->GetDesc().NumDescriptors)
+    {
+        PrintMessage(Error, "Null backend: SRV heap is full at {} descriptors", m_srvCount);
+        m_stats.validationErrors++;
+        return {0};
+    }
+
+    const uint index = m_srvCount++;
+    NullDescriptor* pDescriptor = NullDescriptorHeap::FromHandle(m_pSrvHeap->GetCPUDescriptorHandleForHeapStart()) + index;
+    pDescriptor->pResource = static_cast<NullResource*>(pResource.Get());
+    pDescriptor->format = srvDesc.Format;
+
+    return {reinterpret_cast<UINT64>(pDescriptor)};
+}
+
+void NullRenderEngine::PrintStats() const
+{
+    PrintMessage(Info, "Frames:                 {}", m_frameCount);
+    PrintMessage(Info, "Command lists executed: {}", m_stats.commandListsExecuted);
+    PrintMessage(Info, "Draw calls:             {}", m_stats.drawCalls);
+    PrintMessage(Info, "Indices drawn:          {}", m_stats.indicesDrawn);
+    PrintMessage(Info, "Pipeline states:        {}", m_stats.pipelineStatesCreated);
+    PrintMessage(Info, "Resources:              {} ({} KiB default, {} KiB upload)", m_stats.resourcesCreated,
+                 m_stats.resourceBytes[D3D12_HEAP_TYPE_DEFAULT] / 1024, m_stats.resourceBytes[D3D12_HEAP_TYPE_UPLOAD] / 1024);
+    PrintMessage(m_stats.validationErrors > 0 ? Error : Info, "Validation errors:      {}", m_stats.validationErrors);
+}
+
+
+//**********************************************************************************************************************
+//                                              Engine Internal Helpers
+//**********************************************************************************************************************
+void NullRenderEngine::BuildFrameGraph()
+{
+    // the scene records and submits its own work, then describes its UI, between the engine's own stages
+    m_frameGraph.AddTask("Engine::PreRender", [this] {PreRender();}).Writes(this).Writes(m_pImGuiContext);
+    if (m_pScene != nullptr)
+    {
+        m_pScene->AddTasks(m_frameGraph);
+        m_pScene->AddUiTasks(m_frameGraph);
+    }
+    m_frameGraph.AddTask("Engine::Render", [this] {Render();}).Writes(this).Writes(m_pImGuiContext)
+        .Measures(FrameStatUiTime);
+    m_frameGraph.AddTask("Engine::PostRender", [this] {PostRender();}).Writes(this);
+
+    m_frameGraph.Compile();
+}
+
+void NullRenderEngine::Render()
+{
+    // UI draw data is generated but has nowhere to go
+    PROFILE_SCOPE("ImGui::Render");
+    ImGui::Render();
+}
+
+NullResource* NullRenderEngine::NewResource(const D3D12_HEAP_PROPERTIES& heapProperties, const D3D12_RESOURCE_DESC& desc)
+{
+    return new NullResource(&m_stats, heapProperties, desc);
+}
+
+NullRootSignature* NullRenderEngine::NewRootSignature(const CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC& desc)
+{
+    return new NullRootSignature(&m_stats, desc);
+}
+
+NullPipelineState* NullRenderEngine::NewPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc)
+{
+    return new NullPipelineState(&m_stats, pDesc);
+}
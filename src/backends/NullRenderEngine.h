@@ -0,0 +1,80 @@
+#pragma once
+
+#include "RenderEngine.h"
+
+#include <imgui.h>
+#include <imnodes.h>
+
+#include "backends/NullObjects.h"
+
+using Microsoft::WRL::ComPtr;
+
+
+// The null engine accepts and validates all API traffic without a device, window or GPU. Scenes run unmodified,
+//  building their UI and recording their command lists each frame, which makes it suitable for CI, profiling of CPU
+//  work, and any other headless runs. Nothing is presented, and draws are counted rather than executed.
+class NullRenderEngine : public RenderEngine
+{
+public:
+    NullRenderEngine(UINT width, UINT height);
+    NullRenderEngine(UINT width, UINT height, std::wstring name);
+
+    // primary interfaces for render loop
+    void Init(const WindowHandle window);   // window is ignored
+    void OnUpdate();
+    void PreRender();
+    void OnRender();
+    void PostRender();
+    void Flush();
+    void OnDestroy();
+
+    // API access provided to clients
+    HRESULT CreateCommandAllocator(ID3D12CommandAllocator**             ppCommandAllocator);
+    HRESULT CreateCommandList(ID3D12GraphicsCommandList6**              ppCommandList);
+    HRESULT CreateRootSignature(CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC*  pDesc,
+                                ID3D12RootSignature**                   ppRootSignature);
+    HRESULT CreatePipelineState(D3D12_GRAPHICS_PIPELINE_STATE_DESC*     pDesc,
+                                ID3D12PipelineState**                   ppPipelineState);
+    HRESULT CreatePipelineState(D3D12_PIPELINE_STATE_STREAM_DESC*       pStreamDesc,
+                                ID3D12PipelineState**                   ppPipelineState);
+    HRESULT CreateResource(const D3D12_HEAP_PROPERTIES*                 pHeapProperties,
+                           const D3D12_RESOURCE_DESC*                   pDesc,
+                           D3D12_RESOURCE_STATES                        initialState,
+                           const D3D12_CLEAR_VALUE*                     pClearValue,
+                           ID3D12Resource**                             ppResource);
+    HRESULT CreateDescriptorHeap(const D3D12_DESCRIPTOR_HEAP_DESC*      pDesc,
+                                 ID3D12DescriptorHeap**                 ppDescriptorHeap);
+    void CreateRenderTargetView(ID3D12Resource*                         pResource,
+                                const D3D12_RENDER_TARGET_VIEW_DESC*    pDesc,
+                                D3D12_CPU_DESCRIPTOR_HANDLE             destDescriptor);
+    void CreateDepthStencilView(ID3D12Resource*                         pResource,
+                                const D3D12_DEPTH_STENCIL_VIEW_DESC*    pDesc,
+                                D3D12_CPU_DESCRIPTOR_HANDLE             destDescriptor);
+    void ExecuteCommandList(ID3D12GraphicsCommandList6*                 pCommandList);
+
+    // debug and global UI
+    D3D12_GPU_DESCRIPTOR_HANDLE AddSrvForResource(D3D12_SHADER_RESOURCE_VIEW_DESC desc, ComPtr<ID3D12Resource> pResource);
+
+    // getters/setters
+    uint64 GetFrameCount() const    {return m_frameCount;}
+    virtual void PrintStats() const;
+
+protected:
+    // internal helpers
+    void BuildFrameGraph();
+    void Render();
+
+    // object construction, which derived backends may replace with objects of their own, returning null on failure
+    virtual NullResource* NewResource(const D3D12_HEAP_PROPERTIES& heapProperties, const D3D12_RESOURCE_DESC& desc);
+    virtual NullRootSignature* NewRootSignature(const CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC& desc);
+    virtual NullPipelineState* NewPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc);
+
+    // stand-ins for the device's own objects
+    ComPtr<ID3D12DescriptorHeap>        m_pSrvHeap;
+    uint                                m_srvCount;
+
+    // UI
+    ImGuiContext*                       m_pImGuiContext;
+    ImNodesContext*                     m_pImNodesContext;
+    uint64                              m_frameCount;
+};
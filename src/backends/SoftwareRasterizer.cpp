@@ -0,0 +1,608 @@
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <DirectXPackedVector.h>
+
+#include "Profiler.h"
+
+using namespace std;
+using namespace DirectX::PackedVector;
+
+
+namespace
+{
+    constexpr uint VertexChunkSize      = 4096; // vertices transformed per task
+    constexpr uint MinChunkTriangles    = 1024; // fewest triangles worth setting up as a separate task
+    constexpr uint ChunksPerThread      = 4;    // extra chunks help balance uneven clipping and culling costs
+    constexpr uint MaxClipVertices      = 16;   // a triangle clipped by six planes has at most nine vertices
+
+    // clip-space planes as dot(plane, position) >= 0, the last four being scaled by the guard band
+    enum ClipPlane
+    {
+        NearPlane,
+        FarPlane,
+        LeftPlane,
+        RightPlane,
+        BottomPlane,
+        TopPlane,
+        ClipPlaneCount
+    };
+
+    XMVECTOR DepthTest(D3D12_COMPARISON_FUNC func, FXMVECTOR depth, FXMVECTOR stored)
+    {
+        switch (func)
+        {
+        case D3D12_COMPARISON_FUNC_NEVER:           return XMVectorFalseInt();
+        case D3D12_COMPARISON_FUNC_LESS:            return XMVectorLess(depth, stored);
+        case D3D12_COMPARISON_FUNC_EQUAL:           return XMVectorEqual(depth, stored);
+        case D3D12_COMPARISON_FUNC_LESS_EQUAL:      return XMVectorLessOrEqual(depth, stored);
+        case D3D12_COMPARISON_FUNC_GREATER:         return XMVectorGreater(depth, stored);
+        case D3D12_COMPARISON_FUNC_NOT_EQUAL:       return XMVectorNotEqual(depth, stored);
+        case D3D12_COMPARISON_FUNC_GREATER_EQUAL:   return XMVectorGreaterOrEqual(depth, stored);
+        case D3D12_COMPARISON_FUNC_ALWAYS:
+        default:                                    return XMVectorTrueInt();
+        }
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                              Constructors & Destructors
+//**********************************************************************************************************************
+SoftwareRasterizer::SoftwareRasterizer(uint threadCount) :
+    m_pOwnedJobSystem(threadCount ? make_unique<JobSystem>(threadCount) : nullptr),
+    m_pJobSystem(threadCount ? m_pOwnedJobSystem.get() : &JobSystem::Get()),
+    m_activeChunkCount(0),
+    m_tilesX(0),
+    m_tilesY(0),
+    m_stats({})
+{
+    m_tileBuffers.resize(m_pJobSystem->GetThreadCount() + 1);
+}
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+}
+
+
+//**********************************************************************************************************************
+//                                                  Primary Interfaces
+//**********************************************************************************************************************
+void SoftwareRasterizer::ClearColor(const RasterTarget& target, const float color[4], const D3D12_RECT* pRect)
+{
+    if (target.pColor == nullptr) return;
+
+    XMUBYTEN4 packed;
+    XMStoreUByteN4(&packed, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(color)));
+
+    const D3D12_RECT rect = (pRect != nullptr) ? *pRect : D3D12_RECT{0, 0, LONG(target.width), LONG(target.height)};
+    for (LONG y = max<LONG>(rect.top, 0); y < min<LONG>(rect.bottom, target.height); ++y)
+    {
+        uint32_t* pRow = target.pColor + y*target.colorPitch;
+        fill(pRow + max<LONG>(rect.left, 0), pRow + min<LONG>(rect.right, target.width), packed.v);
+    }
+}
+
+void SoftwareRasterizer::ClearDepth(const RasterTarget& target, float depth, const D3D12_RECT* pRect)
+{
+    if (target.pDepth == nullptr) return;
+
+    const D3D12_RECT rect = (pRect != nullptr) ? *pRect : D3D12_RECT{0, 0, LONG(target.width), LONG(target.height)};
+    for (LONG y = max<LONG>(rect.top, 0); y < min<LONG>(rect.bottom, target.height); ++y)
+    {
+        float* pRow = target.pDepth + y*target.depthPitch;
+        fill(pRow + max<LONG>(rect.left, 0), pRow + min<LONG>(rect.right, target.width), depth);
+    }
+}
+
+void SoftwareRasterizer::Draw(const RasterTarget& target, const RasterState& inputState, const RasterDraw& draw)
+{
+    PROFILE_FUNCTION();
+
+    const uint vertexCount = draw.vertexCount;
+    const uint triangleCount = draw.indexCount / 3;
+    if (triangleCount == 0 || vertexCount == 0) return;
+
+    // restrict scissor to the target and viewport, so setup never produces pixels off the edge of either
+    RasterState state = inputState;
+    state.scissorRect.left   = max<LONG>({state.scissorRect.left,   0, LONG(floorf(state.viewport.TopLeftX))});
+    state.scissorRect.top    = max<LONG>({state.scissorRect.top,    0, LONG(floorf(state.viewport.TopLeftY))});
+    state.scissorRect.right  = min<LONG>({state.scissorRect.right,  LONG(target.width),
+                                          LONG(ceilf(state.viewport.TopLeftX + state.viewport.Width))});
+    state.scissorRect.bottom = min<LONG>({state.scissorRect.bottom, LONG(target.height),
+                                          LONG(ceilf(state.viewport.TopLeftY + state.viewport.Height))});
+    state.depthEnable &= (target.pDepth != nullptr);
+    if (state.scissorRect.left >= state.scissorRect.right || state.scissorRect.top >= state.scissorRect.bottom) return;
+
+    // transform all vertices up front, as indexed meshes share most of them between triangles
+    if (m_clipPositions.size() < vertexCount)
+    {
+        m_clipPositions.resize(vertexCount);
+        m_colors.resize(vertexCount);
+    }
+    ParallelFor((vertexCount + VertexChunkSize - 1) / VertexChunkSize, [&](uint index, uint)
+    {
+        PROFILE_SCOPE("TransformVertices");
+        TransformVertices(draw, index*VertexChunkSize, min(vertexCount, (index + 1)*VertexChunkSize));
+    });
+
+    // prepare bins for this target's tiles
+    m_tilesX = (target.width + TileSize - 1) / TileSize;
+    m_tilesY = (target.height + TileSize - 1) / TileSize;
+    const uint tileCount = m_tilesX * m_tilesY;
+    const uint chunkCount = clamp((triangleCount + MinChunkTriangles - 1) / MinChunkTriangles, 1u, GetThreadCount()*ChunksPerThread);
+    if (m_chunks.size() < chunkCount) m_chunks.resize(chunkCount);
+    for (uint i = 0; i < chunkCount; ++i)
+    {
+        m_chunks[i].triangles.clear();
+        m_chunks[i].tileBins.resize(tileCount);
+        for (vector<uint32_t>& bin : m_chunks[i].tileBins) bin.clear();
+        m_chunks[i].stats = {};
+    }
+
+    // set up and bin contiguous runs of triangles, so that walking chunks in order preserves submission order
+    const uint trianglesPerChunk = (triangleCount + chunkCount - 1) / chunkCount;
+    ParallelFor(chunkCount, [&](uint index, uint)
+    {
+        PROFILE_SCOPE("SetupTriangles");
+        SetupTriangles(draw, state, index, index*trianglesPerChunk, min(triangleCount, (index + 1)*trianglesPerChunk));
+    });
+
+    // only tiles which received triangles need to be touched
+    m_activeTiles.clear();
+    for (uint tile = 0; tile < tileCount; ++tile)
+    {
+        for (uint chunk = 0; chunk < chunkCount; ++chunk)
+        {
+            if (!m_chunks[chunk].tileBins[tile].empty())
+            {
+                m_activeTiles.push_back(tile);
+                break;
+            }
+        }
+    }
+
+    m_activeChunkCount = chunkCount;
+    ParallelFor(static_cast<uint>(m_activeTiles.size()), [&](uint index, uint workerIndex)
+    {
+        PROFILE_SCOPE("RasterizeTile");
+        RasterizeTile(target, state, m_activeTiles[index], workerIndex);
+    });
+
+    for (uint i = 0; i < chunkCount; ++i)
+    {
+        m_stats.trianglesCulled     += m_chunks[i].stats.trianglesCulled;
+        m_stats.trianglesClipped    += m_chunks[i].stats.trianglesClipped;
+        m_stats.trianglesRasterized += m_chunks[i].stats.trianglesRasterized;
+    }
+    m_stats.trianglesSubmitted += triangleCount;
+}
+
+
+//**********************************************************************************************************************
+//                                                      Stages
+//**********************************************************************************************************************
+void SoftwareRasterizer::TransformVertices(const RasterDraw& draw, uint begin, uint end)
+{
+    const XMMATRIX mvp = XMLoadFloat4x4(&draw.modelViewProjection);
+
+    // VSMain: position is promoted to w=1, then multiplied by the MVP matrix
+    if (draw.positionComponents == 3)
+    {
+        XMVector3TransformStream(&m_clipPositions[begin], sizeof(XMFLOAT4A),
+                                 reinterpret_cast<const XMFLOAT3*>(draw.pPositions + begin*draw.positionStride),
+                                 draw.positionStride, end - begin, mvp);
+    }
+    else
+    {
+        for (uint i = begin; i < end; ++i)
+        {
+            const XMVECTOR position = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(draw.pPositions + i*draw.positionStride));
+            XMStoreFloat4A(&m_clipPositions[i], XMVector4Transform(position, mvp));
+        }
+    }
+
+    // colors are passed through, with missing alpha filled in like the input assembler would
+    for (uint i = begin; i < end; ++i)
+    {
+        XMVECTOR color = g_XMOne;
+        if (draw.pColors != nullptr)
+        {
+            const UINT8* pColor = draw.pColors + i*draw.colorStride;
+            color = (draw.colorComponents >= 4) ? XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(pColor))
+                                                : XMVectorSetW(XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(pColor)), 1.0f);
+        }
+        XMStoreFloat4A(&m_colors[i], color);
+    }
+}
+
+void SoftwareRasterizer::SetupTriangles(const RasterDraw& draw, const RasterState& state, uint chunkIndex, uint begin, uint end)
+{
+    BinChunk& chunk = m_chunks[chunkIndex];
+
+    // outside of the viewport's guard band, fixed point coordinates would overflow, so clip there instead
+    const float guardBandX = max(1.0f, GuardBand / (0.5f * state.viewport.Width));
+    const float guardBandY = max(1.0f, GuardBand / (0.5f * state.viewport.Height));
+    const XMVECTORF32 planes[ClipPlaneCount] =
+    {
+        {{{ 0.0f,  0.0f,  1.0f, 0.0f       }}},
+        {{{ 0.0f,  0.0f, -1.0f, 1.0f       }}},
+        {{{ 1.0f,  0.0f,  0.0f, guardBandX }}},
+        {{{-1.0f,  0.0f,  0.0f, guardBandX }}},
+        {{{ 0.0f,  1.0f,  0.0f, guardBandY }}},
+        {{{ 0.0f, -1.0f,  0.0f, guardBandY }}},
+    };
+
+    for (uint triangle = begin; triangle < end; ++triangle)
+    {
+        // fetch indices, skipping triangles which reference vertices outside the buffer as a GPU would
+        ClipVertex vertices[MaxClipVertices];
+        uint outcodes[3];
+        bool inBounds = true;
+        for (uint i = 0; i < 3; ++i)
+        {
+            uint index = triangle*3 + i;
+            if (draw.pIndices != nullptr)
+            {
+                index = draw.indices16Bit ? static_cast<const uint16_t*>(draw.pIndices)[index]
+                                          : static_cast<const uint32_t*>(draw.pIndices)[index];
+            }
+            index += draw.baseVertex;
+            if (index >= draw.vertexCount)
+            {
+                inBounds = false;
+                break;
+            }
+
+            vertices[i].position = m_clipPositions[index];
+            vertices[i].color    = m_colors[index];
+
+            const XMVECTOR position = XMLoadFloat4A(&m_clipPositions[index]);
+            outcodes[i] = 0;
+            for (uint plane = 0; plane < ClipPlaneCount; ++plane)
+            {
+                if (XMVectorGetX(XMVector4Dot(planes[plane], position)) < 0.0f) outcodes[i] |= (1 << plane);
+            }
+        }
+        if (!inBounds || (outcodes[0] & outcodes[1] & outcodes[2]) != 0)
+        {
+            chunk.stats.trianglesCulled++;
+            continue;
+        }
+
+        const uint clipMask = outcodes[0] | outcodes[1] | outcodes[2];
+        if (clipMask == 0)
+        {
+            SetupTriangle(vertices, state, chunk);
+            continue;
+        }
+
+        // Sutherland-Hodgman against each plane the triangle straddles, then fan out the resulting polygon
+        ClipVertex scratch[MaxClipVertices];
+        ClipVertex* pInput = vertices;
+        ClipVertex* pOutput = scratch;
+        uint vertexCount = 3;
+        for (uint plane = 0; plane < ClipPlaneCount && vertexCount >= 3; ++plane)
+        {
+            if ((clipMask & (1 << plane)) == 0) continue;
+
+            uint outputCount = 0;
+            for (uint i = 0; i < vertexCount; ++i)
+            {
+                const ClipVertex& current = pInput[i];
+                const ClipVertex& next = pInput[(i + 1) % vertexCount];
+                const float currentDistance = XMVectorGetX(XMVector4Dot(planes[plane], XMLoadFloat4(&current.position)));
+                const float nextDistance = XMVectorGetX(XMVector4Dot(planes[plane], XMLoadFloat4(&next.position)));
+
+                if (currentDistance >= 0.0f) pOutput[outputCount++] = current;
+                if ((currentDistance >= 0.0f) != (nextDistance >= 0.0f))
+                {
+                    const float t = currentDistance / (currentDistance - nextDistance);
+                    ClipVertex& split = pOutput[outputCount++];
+                    XMStoreFloat4(&split.position, XMVectorLerp(XMLoadFloat4(&current.position), XMLoadFloat4(&next.position), t));
+                    XMStoreFloat4(&split.color, XMVectorLerp(XMLoadFloat4(&current.color), XMLoadFloat4(&next.color), t));
+                }
+            }
+            swap(pInput, pOutput);
+            vertexCount = outputCount;
+        }
+
+        chunk.stats.trianglesClipped++;
+        for (uint i = 2; i < vertexCount; ++i)
+        {
+            const ClipVertex fan[3] = {pInput[0], pInput[i - 1], pInput[i]};
+            SetupTriangle(fan, state, chunk);
+        }
+    }
+}
+
+void SoftwareRasterizer::SetupTriangle(const ClipVertex* pVertices, const RasterState& state, BinChunk& chunk)
+{
+    constexpr float SubpixelScale = float(1 << SubpixelBits);
+    const D3D12_VIEWPORT& viewport = state.viewport;
+
+    // perspective divide and viewport transform, snapping to the subpixel grid
+    int x[3], y[3];
+    float screenX[3], screenY[3], attributes[3][6];
+    for (uint i = 0; i < 3; ++i)
+    {
+        const XMFLOAT4& position = pVertices[i].position;
+        const XMFLOAT4& color = pVertices[i].color;
+        const float invW = 1.0f / position.w;
+
+        x[i] = static_cast<int>(lrintf((viewport.TopLeftX + (position.x*invW + 1.0f) * 0.5f * viewport.Width) * SubpixelScale));
+        y[i] = static_cast<int>(lrintf((viewport.TopLeftY + (1.0f - position.y*invW) * 0.5f * viewport.Height) * SubpixelScale));
+        screenX[i] = x[i] / SubpixelScale;
+        screenY[i] = y[i] / SubpixelScale;
+
+        attributes[i][0] = viewport.MinDepth + position.z*invW * (viewport.MaxDepth - viewport.MinDepth);
+        attributes[i][1] = invW;
+        attributes[i][2] = color.x * invW;
+        attributes[i][3] = color.y * invW;
+        attributes[i][4] = color.z * invW;
+        attributes[i][5] = color.w * invW;
+    }
+
+    // Screen space has y pointing down, so a positive area is a clockwise triangle. Anything left is reordered to be
+    //  clockwise, which keeps the interior on the positive side of every edge.
+    int64_t area = int64_t(x[1] - x[0]) * (y[2] - y[0]) - int64_t(x[2] - x[0]) * (y[1] - y[0]);
+    const bool frontFacing = state.frontCounterClockwise ? (area < 0) : (area > 0);
+    if (area == 0 ||
+        (state.cullMode == D3D12_CULL_MODE_BACK && !frontFacing) ||
+        (state.cullMode == D3D12_CULL_MODE_FRONT && frontFacing))
+    {
+        chunk.stats.trianglesCulled++;
+        return;
+    }
+
+    uint order[3] = {0, 1, 2};
+    if (area < 0)
+    {
+        swap(order[1], order[2]);
+        area = -area;
+    }
+
+    TriangleSetup setup;
+    const int minX = min({x[0], x[1], x[2]});
+    const int minY = min({y[0], y[1], y[2]});
+    const int maxX = max({x[0], x[1], x[2]});
+    const int maxY = max({y[0], y[1], y[2]});
+    setup.minX = max<int>(state.scissorRect.left,   minX >> SubpixelBits);
+    setup.minY = max<int>(state.scissorRect.top,    minY >> SubpixelBits);
+    setup.maxX = min<int>(state.scissorRect.right,  (maxX >> SubpixelBits) + 1);
+    setup.maxY = min<int>(state.scissorRect.bottom, (maxY >> SubpixelBits) + 1);
+    if (setup.minX >= setup.maxX || setup.minY >= setup.maxY)
+    {
+        chunk.stats.trianglesCulled++;
+        return;
+    }
+
+    // edge opposite each vertex, with the top-left rule applied by biasing non top-left edges away from zero
+    for (uint edge = 0; edge < 3; ++edge)
+    {
+        const uint a = order[(edge + 1) % 3];
+        const uint b = order[(edge + 2) % 3];
+        const int A = y[a] - y[b];
+        const int B = x[b] - x[a];
+        const bool isTopLeft = (A > 0) || (A == 0 && B > 0);
+
+        setup.edgeA[edge] = A;
+        setup.edgeB[edge] = B;
+        setup.edgeC[edge] = -(int64_t(A) * x[a] + int64_t(B) * y[a]) - (isTopLeft ? 0 : 1);
+    }
+
+    // attribute planes, which are linear in screen space as every attribute was divided by w
+    const uint v0 = order[0];
+    const uint v1 = order[1];
+    const uint v2 = order[2];
+    const float dx1 = screenX[v1] - screenX[v0];
+    const float dy1 = screenY[v1] - screenY[v0];
+    const float dx2 = screenX[v2] - screenX[v0];
+    const float dy2 = screenY[v2] - screenY[v0];
+    const float invDeterminant = 1.0f / (dx1*dy2 - dx2*dy1);
+
+    setup.refX = screenX[v0];
+    setup.refY = screenY[v0];
+    for (uint i = 0; i < 6; ++i)
+    {
+        const float d1 = attributes[v1][i] - attributes[v0][i];
+        const float d2 = attributes[v2][i] - attributes[v0][i];
+        setup.planes[i][0] = attributes[v0][i];
+        setup.planes[i][1] = (d1*dy2 - d2*dy1) * invDeterminant;
+        setup.planes[i][2] = (d2*dx1 - d1*dx2) * invDeterminant;
+    }
+
+    // bin into every tile overlapped by the bounds, leaving finer rejection to the tile itself
+    const uint32_t index = static_cast<uint32_t>(chunk.triangles.size());
+    chunk.triangles.push_back(setup);
+    chunk.stats.trianglesRasterized++;
+    for (int tileY = setup.minY / TileSize; tileY <= (setup.maxY - 1) / TileSize; ++tileY)
+    {
+        for (int tileX = setup.minX / TileSize; tileX <= (setup.maxX - 1) / TileSize; ++tileX)
+        {
+            chunk.tileBins[tileY*m_tilesX + tileX].push_back(index);
+        }
+    }
+}
+
+void SoftwareRasterizer::RasterizeTile(const RasterTarget& target, const RasterState& state, uint tileIndex, uint workerIndex)
+{
+    TileBuffer& tile = m_tileBuffers[workerIndex];
+    const int tileX = (tileIndex % m_tilesX) * TileSize;
+    const int tileY = (tileIndex / m_tilesX) * TileSize;
+    const int tileWidth = min<int>(TileSize, target.width - tileX);
+    const int tileHeight = min<int>(TileSize, target.height - tileY);
+
+    for (int row = 0; row < tileHeight; ++row)
+    {
+        if (target.pColor != nullptr)
+            memcpy(&tile.color[row*TileSize], target.pColor + (tileY + row)*target.colorPitch + tileX, tileWidth*sizeof(uint32_t));
+        if (target.pDepth != nullptr)
+            memcpy(&tile.depth[row*TileSize], target.pDepth + (tileY + row)*target.depthPitch + tileX, tileWidth*sizeof(float));
+    }
+
+    for (uint chunk = 0; chunk < m_activeChunkCount; ++chunk)
+    {
+        const BinChunk& binChunk = m_chunks[chunk];
+        for (const uint32_t triangle : binChunk.tileBins[tileIndex])
+        {
+            RasterizeTriangle(binChunk.triangles[triangle], state, tileX, tileY, tileWidth, tileHeight, tile);
+        }
+    }
+
+    for (int row = 0; row < tileHeight; ++row)
+    {
+        if (target.pColor != nullptr)
+            memcpy(target.pColor + (tileY + row)*target.colorPitch + tileX, &tile.color[row*TileSize], tileWidth*sizeof(uint32_t));
+        if (target.pDepth != nullptr && state.depthWrite)
+            memcpy(target.pDepth + (tileY + row)*target.depthPitch + tileX, &tile.depth[row*TileSize], tileWidth*sizeof(float));
+    }
+}
+
+void SoftwareRasterizer::RasterizeTriangle(const TriangleSetup& triangle, const RasterState& state, int tileX, int tileY,
+                                           int tileWidth, int tileHeight, TileBuffer& tile)
+{
+    constexpr int One = 1 << SubpixelBits;
+    constexpr int Half = One / 2;
+
+    // portion of the tile within the triangle's bounds
+    const int x0 = max(triangle.minX, tileX);
+    const int y0 = max(triangle.minY, tileY);
+    const int x1 = min(triangle.maxX, tileX + tileWidth);
+    const int y1 = min(triangle.maxY, tileY + tileHeight);
+    if (x0 >= x1 || y0 >= y1) return;
+
+    // pixels are processed in groups of four aligned to the tile, so the first group may begin left of the bounds
+    const int alignedX0 = x0 - ((x0 - tileX) & 3);
+
+    // Evaluate each edge at the corners of the region. Edges the region lies fully inside of are dropped, which also
+    //  keeps the remaining edge values small enough for 32-bit stepping.
+    int32_t rowEdge[3];
+    int32_t stepX[3];
+    int32_t stepY[3];
+    for (uint edge = 0; edge < 3; ++edge)
+    {
+        const int64_t A = triangle.edgeA[edge];
+        const int64_t B = triangle.edgeB[edge];
+        const int64_t C = triangle.edgeC[edge];
+        const auto Evaluate = [&](int px, int py) {return A*(int64_t(px)*One + Half) + B*(int64_t(py)*One + Half) + C;};
+
+        const int64_t e00 = Evaluate(x0, y0);
+        const int64_t e10 = Evaluate(x1 - 1, y0);
+        const int64_t e01 = Evaluate(x0, y1 - 1);
+        const int64_t e11 = Evaluate(x1 - 1, y1 - 1);
+        if (max({e00, e10, e01, e11}) < 0) return;
+
+        if (min({e00, e10, e01, e11}) >= 0)
+        {
+            rowEdge[edge] = 0;
+            stepX[edge] = 0;
+            stepY[edge] = 0;
+        }
+        else
+        {
+            rowEdge[edge] = static_cast<int32_t>(Evaluate(alignedX0, y0));
+            stepX[edge] = static_cast<int32_t>(A * One);
+            stepY[edge] = static_cast<int32_t>(B * One);
+        }
+    }
+
+    XMVECTOR laneStep[3];
+    XMVECTOR groupStep[3];
+    for (uint edge = 0; edge < 3; ++edge)
+    {
+        const uint32_t s = static_cast<uint32_t>(stepX[edge]);
+        laneStep[edge] = XMVectorSetInt(0, s, 2*s, 3*s);
+        groupStep[edge] = XMVectorReplicateInt(4*s);
+    }
+
+    const XMVECTOR laneOffsets = XMVectorSet(0.0f, 1.0f, 2.0f, 3.0f);
+    const XMVECTOR boundsMin = XMVectorReplicate(float(x0));
+    const XMVECTOR boundsMax = XMVectorReplicate(float(x1));
+    const XMVECTOR signMask = g_XMNegativeZero;
+    const bool testDepth = state.depthEnable;
+    const bool writeDepth = state.depthEnable && state.depthWrite;
+
+    XMVECTOR planeDx[6];
+    for (uint i = 0; i < 6; ++i) planeDx[i] = XMVectorReplicate(triangle.planes[i][1]);
+
+    for (int y = y0; y < y1; ++y)
+    {
+        XMVECTOR edges[3];
+        for (uint edge = 0; edge < 3; ++edge)
+        {
+            const int32_t value = rowEdge[edge] + stepY[edge] * (y - y0);
+            edges[edge] = XMVectorAddInt(XMVectorReplicateInt(static_cast<uint32_t>(value)), laneStep[edge]);
+        }
+
+        // per-row base of each attribute plane
+        const float dy = (y + 0.5f) - triangle.refY;
+        XMVECTOR planeRow[6];
+        for (uint i = 0; i < 6; ++i) planeRow[i] = XMVectorReplicate(triangle.planes[i][0] + triangle.planes[i][2]*dy);
+
+        uint32_t* pColorRow = &tile.color[(y - tileY)*TileSize];
+        float* pDepthRow = &tile.depth[(y - tileY)*TileSize];
+
+        for (int x = alignedX0; x < x1; x += 4)
+        {
+            // covered where no edge value is negative, and within the bounds
+            const XMVECTOR laneX = XMVectorAdd(XMVectorReplicate(float(x)), laneOffsets);
+            XMVECTOR mask = XMVectorEqualInt(XMVectorAndInt(XMVectorOrInt(XMVectorOrInt(edges[0], edges[1]), edges[2]), signMask),
+                                             XMVectorZero());
+            mask = XMVectorAndInt(mask, XMVectorAndInt(XMVectorGreaterOrEqual(laneX, boundsMin), XMVectorLess(laneX, boundsMax)));
+
+            for (uint edge = 0; edge < 3; ++edge) edges[edge] = XMVectorAddInt(edges[edge], groupStep[edge]);
+            if (XMVector4EqualInt(mask, XMVectorZero())) continue;
+
+            const int local = x - tileX;
+            const XMVECTOR dx = XMVectorSubtract(XMVectorAdd(laneX, g_XMOneHalf), XMVectorReplicate(triangle.refX));
+
+            // depth is linear in screen space
+            const XMVECTOR depth = XMVectorMultiplyAdd(planeDx[0], dx, planeRow[0]);
+            if (testDepth)
+            {
+                const XMVECTOR stored = XMLoadFloat4A(reinterpret_cast<const XMFLOAT4A*>(pDepthRow + local));
+                mask = XMVectorAndInt(mask, DepthTest(state.depthFunc, depth, stored));
+                if (XMVector4EqualInt(mask, XMVectorZero())) continue;
+
+                if (writeDepth)
+                {
+                    XMStoreFloat4A(reinterpret_cast<XMFLOAT4A*>(pDepthRow + local), XMVectorSelect(stored, depth, mask));
+                }
+            }
+
+            // PSMain: perspective-correct interpolated vertex color, written to the tile even for depth-only targets
+            {
+                const XMVECTOR w = XMVectorReciprocal(XMVectorMultiplyAdd(planeDx[1], dx, planeRow[1]));
+                XMMATRIX colors(XMVectorMultiply(XMVectorMultiplyAdd(planeDx[2], dx, planeRow[2]), w),
+                                XMVectorMultiply(XMVectorMultiplyAdd(planeDx[3], dx, planeRow[3]), w),
+                                XMVectorMultiply(XMVectorMultiplyAdd(planeDx[4], dx, planeRow[4]), w),
+                                XMVectorMultiply(XMVectorMultiplyAdd(planeDx[5], dx, planeRow[5]), w));
+                colors = XMMatrixTranspose(colors);     // rows are now one pixel each
+
+                XMUBYTEN4 packed[4];
+                for (uint i = 0; i < 4; ++i) XMStoreUByteN4(&packed[i], colors.r[i]);
+
+                const XMVECTOR stored = XMLoadInt4A(pColorRow + local);
+                const XMVECTOR shaded = XMVectorSetInt(packed[0].v, packed[1].v, packed[2].v, packed[3].v);
+                XMStoreInt4A(pColorRow + local, XMVectorSelect(stored, shaded, mask));
+            }
+        }
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                     Worker Pool
+//**********************************************************************************************************************
+void SoftwareRasterizer::ParallelFor(uint count, const function<void(uint index, uint workerIndex)>& function)
+{
+    // a grain of one leaves balancing to stealing, as tiles and chunks vary widely in cost
+    const uint externalIndex = m_pJobSystem->GetThreadCount();
+    m_pJobSystem->ParallelFor(count, [&](uint index)
+    {
+        function(index, min(m_pJobSystem->GetThreadIndex(), externalIndex));
+    }, 1);
+}
@@ -0,0 +1,152 @@
+// SoftwareRasterizer - Binned, tile-parallel triangle rasterizer for the software backend.
+//
+// Draws are processed in three stages. Vertices are transformed in parallel chunks, then triangles are clipped, set up
+//  and binned into screen tiles, again in parallel chunks of consecutive triangles. Finally each tile is rasterized by
+//  a single worker which walks the bins in chunk order, so output is identical to in-order submission regardless of
+//  the number of threads. Coverage uses 4-bit subpixel fixed point edge functions with the D3D top-left fill rule, and
+//  pixels are shaded four at a time with DirectXMath vectors, so SSE/NEON are used wherever DirectXMath uses them.
+//
+// Only the fixed-function equivalent of shaders.hlsl is supported: an MVP transform of the position and a perspective
+//  correct interpolation of the vertex color, written to an R8G8B8A8_UNORM target with an optional D32 depth buffer.
+//
+// TODO: blending, MSAA, and anything which would require interpreting shader bytecode
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "Common.h"
+#include "JobSystem.h"
+
+using namespace DirectX;
+
+
+// surfaces being rendered to, in CPU memory
+struct RasterTarget
+{
+    uint32_t*   pColor;         // R8G8B8A8_UNORM, may be null for depth-only rendering
+    float*      pDepth;         // D32_FLOAT, may be null
+    uint        width;
+    uint        height;
+    uint        colorPitch;     // in pixels
+    uint        depthPitch;     // in pixels
+};
+
+// fixed-function state which would come from the PSO and command list
+struct RasterState
+{
+    D3D12_VIEWPORT          viewport;
+    D3D12_RECT              scissorRect;
+    D3D12_CULL_MODE         cullMode;
+    bool                    frontCounterClockwise;
+    bool                    depthEnable;
+    bool                    depthWrite;
+    D3D12_COMPARISON_FUNC   depthFunc;
+};
+
+// geometry for a single draw, laid out like the buffers GeometryManager creates
+struct RasterDraw
+{
+    const UINT8*    pPositions;         // float3 or float4 positions
+    uint            positionStride;
+    uint            positionComponents;
+    const UINT8*    pColors;            // float3 or float4 colors, white if null
+    uint            colorStride;
+    uint            colorComponents;
+    uint            vertexCount;
+
+    const void*     pIndices;           // sequential vertices if null
+    bool            indices16Bit;
+    uint            indexCount;
+    int             baseVertex;
+
+    XMFLOAT4X4      modelViewProjection;
+};
+
+struct RasterStats
+{
+    uint64 trianglesSubmitted;
+    uint64 trianglesCulled;             // back-facing, degenerate, or outside the scissor rect
+    uint64 trianglesClipped;            // required clipping against the near/far planes or guard band
+    uint64 trianglesRasterized;         // after clipping and culling
+};
+
+
+class SoftwareRasterizer
+{
+public:
+    SoftwareRasterizer(uint threadCount = 0);   // zero shares the engine's job system, otherwise a private pool is made
+    ~SoftwareRasterizer();
+
+    void ClearColor(const RasterTarget& target, const float color[4], const D3D12_RECT* pRect = nullptr);
+    void ClearDepth(const RasterTarget& target, float depth, const D3D12_RECT* pRect = nullptr);
+    void Draw(const RasterTarget& target, const RasterState& state, const RasterDraw& draw);
+
+    uint GetThreadCount() const                 {return m_pJobSystem->GetThreadCount();}
+    const RasterStats& GetStats() const         {return m_stats;}
+    void ResetStats()                           {m_stats = {};}
+
+    static constexpr int TileSize       = 64;   // pixels per tile side
+    static constexpr int SubpixelBits   = 4;    // fixed point precision of snapped vertex positions
+    static constexpr float GuardBand    = 4096; // pixels beyond the viewport center before x/y clipping is needed
+
+private:
+    // screen-space triangle after setup
+    struct TriangleSetup
+    {
+        int     minX, minY, maxX, maxY;     // pixel bounds, max exclusive
+        int     edgeA[3];                   // edge equations in subpixel units, bias for fill rule folded into C
+        int     edgeB[3];
+        int64_t edgeC[3];
+        float   refX, refY;                 // position of vertex 0, which attribute planes are relative to
+        float   planes[6][3];               // z, 1/w, rgba/w as value at ref, d/dx and d/dy
+    };
+
+    // triangles set up by a single chunk, along with the tiles they touch
+    struct BinChunk
+    {
+        std::vector<TriangleSetup>          triangles;
+        std::vector<std::vector<uint32_t>>  tileBins;   // triangle indices per tile
+        RasterStats                         stats;
+    };
+
+    // local copy of one tile's pixels, so that rasterization stays in cache and never steps off the edge of a target
+    struct alignas(16) TileBuffer
+    {
+        uint32_t    color[TileSize * TileSize];
+        float       depth[TileSize * TileSize];
+    };
+
+    struct ClipVertex
+    {
+        XMFLOAT4 position;
+        XMFLOAT4 color;
+    };
+
+    // stages
+    void TransformVertices(const RasterDraw& draw, uint begin, uint end);
+    void SetupTriangles(const RasterDraw& draw, const RasterState& state, uint chunkIndex, uint begin, uint end);
+    void SetupTriangle(const ClipVertex* pVertices, const RasterState& state, BinChunk& chunk);
+    void RasterizeTile(const RasterTarget& target, const RasterState& state, uint tileIndex, uint workerIndex);
+    void RasterizeTriangle(const TriangleSetup& triangle, const RasterState& state, int tileX, int tileY,
+                           int tileWidth, int tileHeight, TileBuffer& tile);
+
+    // worker pool
+    void ParallelFor(uint count, const std::function<void(uint index, uint workerIndex)>& function);
+
+    std::unique_ptr<JobSystem>          m_pOwnedJobSystem;  // only when a thread count was given
+    JobSystem*                          m_pJobSystem;
+
+    // per-draw working memory, retained between draws to avoid reallocation
+    std::vector<XMFLOAT4A>              m_clipPositions;
+    std::vector<XMFLOAT4A>              m_colors;
+    std::vector<BinChunk>               m_chunks;
+    uint                                m_activeChunkCount;
+    std::vector<TileBuffer>             m_tileBuffers;  // one per job system thread, plus one for a thread outside it
+    std::vector<uint>                   m_activeTiles;
+    uint                                m_tilesX;
+    uint                                m_tilesY;
+
+    RasterStats                         m_stats;
+};
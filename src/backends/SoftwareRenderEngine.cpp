@@ -0,0 +1,302 @@
+#include "SoftwareRenderEngine.h"
+
+#include "Profiler.h"
+
+using namespace std;
+
+
+namespace
+{
+    uint ComponentCount(DXGI_FORMAT format)
+    {
+        switch (format)
+        {
+        case DXGI_FORMAT_R32G32B32A32_FLOAT:    return 4;
+        case DXGI_FORMAT_R32G32B32_FLOAT:       return 3;
+        default:                                return 0;   // unsupported
+        }
+    }
+
+    // constant buffers hold transposed matrices for HLSL's column-major packing
+    XMMATRIX LoadConstantMatrix(const void* pData)
+    {
+        return XMMatrixTranspose(XMLoadFloat4x4(static_cast<const XMFLOAT4X4*>(pData)));
+    }
+
+    RasterTarget TargetFromResources(NullResource* pRenderTarget, NullResource* pDepthStencil)
+    {
+        RasterTarget target = {};
+        NullResource* pReference = (pRenderTarget != nullptr) ? pRenderTarget : pDepthStencil;
+        if (pReference != nullptr)
+        {
+            target.width  = static_cast<uint>(pReference->GetDesc().Width);
+            target.height = pReference->GetDesc().Height;
+        }
+        if (pRenderTarget != nullptr)
+        {
+            target.pColor = reinterpret_cast<uint32_t*>(pRenderTarget->GetData());
+            target.colorPitch = static_cast<uint>(pRenderTarget->GetRowPitch() / sizeof(uint32_t));
+        }
+        if (pDepthStencil != nullptr)
+        {
+            target.pDepth = reinterpret_cast<float*>(pDepthStencil->GetData());
+            target.depthPitch = static_cast<uint>(pDepthStencil->GetRowPitch() / sizeof(float));
+        }
+        return target;
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                  Command List
+//**********************************************************************************************************************
+HRESULT SoftwareCommandList::Reset(ID3D12CommandAllocator* pAllocator, ID3D12PipelineState* pInitialState)
+{
+    m_commands.clear();
+    return NullCommandList::Reset(pAllocator, pInitialState);
+}
+
+void SoftwareCommandList::DrawInstanced(UINT vertexCountPerInstance, UINT instanceCount, UINT startVertexLocation,
+                                        UINT startInstanceLocation)
+{
+    const uint64 errorCount = m_pStats->validationErrors;
+    NullCommandList::DrawInstanced(vertexCountPerInstance, instanceCount, startVertexLocation, startInstanceLocation);
+    if (m_pStats->validationErrors == errorCount && m_isOpen)
+    {
+        RecordDraw(false, vertexCountPerInstance, instanceCount, startVertexLocation, 0);
+    }
+}
+
+void SoftwareCommandList::DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation,
+                                               INT baseVertexLocation, UINT startInstanceLocation)
+{
+    const uint64 errorCount = m_pStats->validationErrors;
+    NullCommandList::DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation,
+                                          startInstanceLocation);
+    if (m_pStats->validationErrors == errorCount && m_isOpen)
+    {
+        RecordDraw(true, indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation);
+    }
+}
+
+void SoftwareCommandList::ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView, D3D12_CLEAR_FLAGS clearFlags,
+                                                FLOAT depth, UINT8 stencil, UINT numRects, const D3D12_RECT* pRects)
+{
+    NullCommandList::ClearDepthStencilView(depthStencilView, clearFlags, depth, stencil, numRects, pRects);
+
+    // there is no stencil buffer, and rects are only honored for color
+    if (m_isOpen && (clearFlags & D3D12_CLEAR_FLAG_DEPTH))
+    {
+        Command command = {};
+        command.type = ClearDepthCommand;
+        command.pDepthStencil = NullDescriptorHeap::FromHandle(depthStencilView)->pResource.Get();
+        command.clearDepth = depth;
+        m_commands.push_back(command);
+    }
+}
+
+void SoftwareCommandList::ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView, const FLOAT colorRGBA[4],
+                                                UINT numRects, const D3D12_RECT* pRects)
+{
+    NullCommandList::ClearRenderTargetView(renderTargetView, colorRGBA, numRects, pRects);
+
+    if (m_isOpen)
+    {
+        Command command = {};
+        command.type = ClearColorCommand;
+        command.pRenderTarget = NullDescriptorHeap::FromHandle(renderTargetView)->pResource.Get();
+        memcpy(command.clearColor, colorRGBA, sizeof(command.clearColor));
+        m_commands.push_back(command);
+    }
+}
+
+void SoftwareCommandList::RecordDraw(bool indexed, uint count, uint instanceCount, uint start, int baseVertex)
+{
+    Command command = {};
+    command.type            = DrawCommand;
+    command.pRenderTarget   = (m_numRenderTargets > 0) ? m_pRenderTargets[0]->pResource.Get() : nullptr;
+    command.pDepthStencil   = (m_pDepthStencil != nullptr) ? m_pDepthStencil->pResource.Get() : nullptr;
+    command.positions       = FindVertexStream("POSITION");
+    command.colors          = FindVertexStream("COLOR");
+    command.indexBufferView = m_indexBufferView;
+    command.indexed         = indexed;
+    command.count           = count;
+    command.instanceCount   = instanceCount;
+    command.start           = start;
+    command.baseVertex      = baseVertex;
+    command.sceneConstants  = FindConstantBuffer(0);
+    command.meshConstants   = FindConstantBuffer(1);
+
+    const D3D12_RASTERIZER_DESC& rasterizerState = m_pPipelineState->GetRasterizerState();
+    const D3D12_DEPTH_STENCIL_DESC& depthStencilState = m_pPipelineState->GetDepthStencilState();
+    command.state.viewport              = m_viewport;
+    command.state.scissorRect           = m_scissorRect;
+    command.state.cullMode              = rasterizerState.CullMode;
+    command.state.frontCounterClockwise = rasterizerState.FrontCounterClockwise;
+    command.state.depthEnable           = depthStencilState.DepthEnable;
+    command.state.depthWrite            = (depthStencilState.DepthWriteMask == D3D12_DEPTH_WRITE_MASK_ALL);
+    command.state.depthFunc             = depthStencilState.DepthFunc;
+
+    // only the fixed-function equivalent of shaders.hlsl can be executed
+    NULL_BACKEND_VALIDATE(m_pStats, command.positions.components != 0, "Software backend: draw without a float3/float4 POSITION stream");
+    const bool constantsBound = command.sceneConstants.Holds(2) && command.meshConstants.Holds(1);
+    NULL_BACKEND_VALIDATE(m_pStats, constantsBound,
+                          "Software backend: draw without scene and mesh constant buffers bound");
+    NULL_BACKEND_VALIDATE(m_pStats, command.pRenderTarget == nullptr ||
+                                    command.pRenderTarget->GetDesc().Format == DXGI_FORMAT_R8G8B8A8_UNORM,
+                          "Software backend: only R8G8B8A8_UNORM render targets are supported");
+
+    if (command.positions.components != 0 && constantsBound)
+    {
+        m_commands.push_back(command);
+    }
+}
+
+SoftwareCommandList::ConstantBuffer SoftwareCommandList::FindConstantBuffer(uint shaderRegister)
+{
+    ConstantBuffer buffer = {};
+    const int index = m_pRootSignature->FindConstantBuffer(shaderRegister, 0);
+    if (index < 0) return buffer;
+
+    const NullRootParameter& parameter = m_pRootSignature->GetParameter(index);
+    if (parameter.type == D3D12_ROOT_PARAMETER_TYPE_CBV)
+    {
+        buffer.address = m_rootAddresses[index];
+        return buffer;
+    }
+    buffer.constantCount = min<uint>(parameter.num32BitValues, _countof(buffer.constants));
+    memcpy(buffer.constants, m_rootConstants + parameter.constantsOffset, buffer.constantCount * sizeof(UINT));
+    return buffer;
+}
+
+bool SoftwareCommandList::ConstantBuffer::Holds(uint matrixCount) const
+{
+    return (address != 0) || (constantCount * sizeof(UINT) >= matrixCount * sizeof(XMFLOAT4X4));
+}
+
+XMMATRIX SoftwareCommandList::ConstantBuffer::LoadMatrix(uint index) const
+{
+    if (address != 0) return LoadConstantMatrix(reinterpret_cast<const XMFLOAT4X4*>(address) + index);
+    return LoadConstantMatrix(reinterpret_cast<const XMFLOAT4X4*>(constants) + index);
+}
+
+SoftwareCommandList::VertexStream SoftwareCommandList::FindVertexStream(const char* pSemanticName)
+{
+    VertexStream stream = {};
+    for (const D3D12_INPUT_ELEMENT_DESC& element : m_pPipelineState->GetInputLayout())
+    {
+        if (strcmp(element.SemanticName, pSemanticName) != 0 || element.SemanticIndex != 0) continue;
+
+        const D3D12_VERTEX_BUFFER_VIEW& view = m_vertexBufferViews[element.InputSlot];
+        if (view.BufferLocation == 0 || view.StrideInBytes == 0) break;
+
+        stream.location     = view.BufferLocation + element.AlignedByteOffset;
+        stream.stride       = view.StrideInBytes;
+        stream.components   = ComponentCount(element.Format);
+        stream.vertexCount  = view.SizeInBytes / view.StrideInBytes;
+        break;
+    }
+    return stream;
+}
+
+void SoftwareCommandList::Execute(SoftwareRasterizer& rasterizer)
+{
+    for (const Command& command : m_commands)
+    {
+        const RasterTarget target = TargetFromResources(command.pRenderTarget, command.pDepthStencil);
+
+        switch (command.type)
+        {
+        case ClearColorCommand:
+        {
+            rasterizer.ClearColor(target, command.clearColor);
+            break;
+        }
+        case ClearDepthCommand:
+        {
+            rasterizer.ClearDepth(target, command.clearDepth);
+            break;
+        }
+        case DrawCommand:
+        {
+            // VSMain's transform, with root CBVs' constants as they are now rather than when the draw was recorded
+            const XMMATRIX model = command.meshConstants.LoadMatrix(0);
+            const XMMATRIX view = command.sceneConstants.LoadMatrix(0);
+            const XMMATRIX projection = command.sceneConstants.LoadMatrix(1);
+
+            RasterDraw draw = {};
+            XMStoreFloat4x4(&draw.modelViewProjection, model * view * projection);
+            draw.pPositions         = reinterpret_cast<const UINT8*>(command.positions.location);
+            draw.positionStride     = command.positions.stride;
+            draw.positionComponents = command.positions.components;
+            draw.vertexCount        = command.positions.vertexCount;
+            if (command.colors.components != 0)
+            {
+                draw.pColors         = reinterpret_cast<const UINT8*>(command.colors.location);
+                draw.colorStride     = command.colors.stride;
+                draw.colorComponents = command.colors.components;
+                draw.vertexCount     = min(draw.vertexCount, command.colors.vertexCount);
+            }
+
+            draw.indexCount = command.count;
+            draw.baseVertex = command.baseVertex;
+            if (command.indexed)
+            {
+                draw.indices16Bit = (command.indexBufferView.Format == DXGI_FORMAT_R16_UINT);
+                draw.pIndices = reinterpret_cast<const UINT8*>(command.indexBufferView.BufferLocation) +
+                                command.start * (draw.indices16Bit ? sizeof(uint16_t) : sizeof(uint32_t));
+            }
+            else
+            {
+                draw.baseVertex += command.start;
+            }
+
+            // the shader ignores SV_InstanceID, so every instance lands in the same place
+            for (uint instance = 0; instance < command.instanceCount; ++instance)
+            {
+                rasterizer.Draw(target, command.state, draw);
+            }
+            break;
+        }
+        }
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                      Engine
+//**********************************************************************************************************************
+SoftwareRenderEngine::SoftwareRenderEngine(UINT width, UINT height, uint threadCount) :
+    NullRenderEngine(width, height, L"Software Render Engine"),
+    m_rasterizer(threadCount)
+{
+}
+
+HRESULT SoftwareRenderEngine::CreateCommandList(ID3D12GraphicsCommandList6** ppCommandList)
+{
+    *ppCommandList = new SoftwareCommandList(&m_stats);
+    m_stats.commandListsCreated++;
+    return S_OK;
+}
+
+void SoftwareRenderEngine::ExecuteCommandList(ID3D12GraphicsCommandList6* pCommandList)
+{
+    PROFILE_FUNCTION();
+    NullRenderEngine::ExecuteCommandList(pCommandList);
+
+    // the rasterizer stands in for the device, so its execution is reported as GPU time
+    FrameStatTimer gpuTimer(m_frameStats, FrameStatGpuTime);
+    static_cast<SoftwareCommandList*>(pCommandList)->Execute(m_rasterizer);
+}
+
+void SoftwareRenderEngine::PrintStats() const
+{
+    NullRenderEngine::PrintStats();
+
+    const RasterStats& stats = m_rasterizer.GetStats();
+    PrintMessage(Info, "Rasterizer threads:     {}", m_rasterizer.GetThreadCount());
+    PrintMessage(Info, "Triangles submitted:    {}", stats.trianglesSubmitted);
+    PrintMessage(Info, "Triangles culled:       {}", stats.trianglesCulled);
+    PrintMessage(Info, "Triangles clipped:      {}", stats.trianglesClipped);
+    PrintMessage(Info, "Triangles rasterized:   {}", stats.trianglesRasterized);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "backends/NullRenderEngine.h"
+#include "backends/SoftwareRasterizer.h"
+
+
+// Command list which records clears and draws, replaying them through the software rasterizer on execution. Buffer
+//  and constant contents are read at execution time, just as they would be by a GPU.
+class SoftwareCommandList : public NullCommandList
+{
+public:
+    SoftwareCommandList(RenderEngineStats* pStats) : NullCommandList(pStats) {}
+
+    // ID3D12GraphicsCommandList
+    HRESULT STDMETHODCALLTYPE Reset(ID3D12CommandAllocator* pAllocator, ID3D12PipelineState* pInitialState);
+    void STDMETHODCALLTYPE DrawInstanced(UINT vertexCountPerInstance, UINT instanceCount, UINT startVertexLocation,
+                                         UINT startInstanceLocation);
+    void STDMETHODCALLTYPE DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation,
+                                                INT baseVertexLocation, UINT startInstanceLocation);
+    void STDMETHODCALLTYPE ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView, D3D12_CLEAR_FLAGS clearFlags,
+                                                 FLOAT depth, UINT8 stencil, UINT numRects, const D3D12_RECT* pRects);
+    void STDMETHODCALLTYPE ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView, const FLOAT colorRGBA[4],
+                                                 UINT numRects, const D3D12_RECT* pRects);
+
+    void Execute(SoftwareRasterizer& rasterizer);
+
+private:
+    enum CommandType
+    {
+        ClearColorCommand,
+        ClearDepthCommand,
+        DrawCommand
+    };
+
+    // a vertex attribute located through the PSO's input layout and the bound vertex buffers
+    struct VertexStream
+    {
+        D3D12_GPU_VIRTUAL_ADDRESS   location;
+        uint                        stride;
+        uint                        components;
+        uint                        vertexCount;
+    };
+
+    // A constant buffer as a draw sees it, located through the root signature by register: a root CBV, whose contents
+    //  are read at execution, or root constants, copied as they were when the draw was recorded.
+    struct ConstantBuffer
+    {
+        D3D12_GPU_VIRTUAL_ADDRESS   address;            // zero for root constants
+        UINT                        constants[32];      // two matrices, the most a draw reads from one buffer
+        uint                        constantCount;
+
+        bool Holds(uint matrixCount) const;
+        XMMATRIX LoadMatrix(uint index) const;
+    };
+
+    struct Command
+    {
+        CommandType                 type;
+        NullResource*               pRenderTarget;
+        NullResource*               pDepthStencil;
+
+        // clears
+        float                       clearColor[4];
+        float                       clearDepth;
+
+        // draws
+        RasterState                 state;
+        VertexStream                positions;
+        VertexStream                colors;
+        D3D12_INDEX_BUFFER_VIEW     indexBufferView;    // unused for non-indexed draws
+        bool                        indexed;
+        uint                        count;              // indices or vertices per instance
+        uint                        instanceCount;
+        uint                        start;              // first index or vertex
+        int                         baseVertex;
+        ConstantBuffer              sceneConstants;     // b0
+        ConstantBuffer              meshConstants;      // b1
+    };
+
+    void RecordDraw(bool indexed, uint count, uint instanceCount, uint start, int baseVertex);
+    VertexStream FindVertexStream(const char* pSemanticName);
+    ConstantBuffer FindConstantBuffer(uint shaderRegister);
+
+    std::vector<Command> m_commands;
+};
+
+
+// Renders scenes on the CPU, for golden-image testing and for machines without a GPU. Everything other than draws and
+//  clears behaves exactly as the null engine, which this builds upon.
+class SoftwareRenderEngine : public NullRenderEngine
+{
+public:
+    SoftwareRenderEngine(UINT width, UINT height, uint threadCount = 0);
+
+    // API access provided to clients
+    HRESULT CreateCommandList(ID3D12GraphicsCommandList6**              ppCommandList);
+    void ExecuteCommandList(ID3D12GraphicsCommandList6*                 pCommandList);
+
+    // getters/setters
+    SoftwareRasterizer& GetRasterizer()     {return m_rasterizer;}
+    void PrintStats() const;
+
+private:
+    SoftwareRasterizer m_rasterizer;
+};
@@ -0,0 +1,908 @@
+#include "VulkanObjects.h"
+
+using namespace std;
+
+
+namespace
+{
+    VkShaderStageFlags ToVkShaderStages(D3D12_SHADER_VISIBILITY visibility)
+    {
+        switch (visibility)
+        {
+        case D3D12_SHADER_VISIBILITY_VERTEX:    return VK_SHADER_STAGE_VERTEX_BIT;
+        case D3D12_SHADER_VISIBILITY_HULL:      return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+        case D3D12_SHADER_VISIBILITY_DOMAIN:    return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+        case D3D12_SHADER_VISIBILITY_GEOMETRY:  return VK_SHADER_STAGE_GEOMETRY_BIT;
+        case D3D12_SHADER_VISIBILITY_PIXEL:     return VK_SHADER_STAGE_FRAGMENT_BIT;
+        default:                                return VK_SHADER_STAGE_ALL_GRAPHICS;
+        }
+    }
+
+    VkPrimitiveTopology ToVkTopology(D3D12_PRIMITIVE_TOPOLOGY topology)
+    {
+        switch (topology)
+        {
+        case D3D_PRIMITIVE_TOPOLOGY_POINTLIST:      return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+        case D3D_PRIMITIVE_TOPOLOGY_LINELIST:       return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+        case D3D_PRIMITIVE_TOPOLOGY_LINESTRIP:      return VK_PRIMITIVE_TOPOLOGY_LINE_STRIP;
+        case D3D_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP:  return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+        default:                                    return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        }
+    }
+
+    VkPrimitiveTopology ToVkTopology(D3D12_PRIMITIVE_TOPOLOGY_TYPE topologyType)
+    {
+        switch (topologyType)
+        {
+        case D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT:   return VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
+        case D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE:    return VK_PRIMITIVE_TOPOLOGY_LINE_LIST;
+        default:                                    return VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+        }
+    }
+
+    VkBlendFactor ToVkBlendFactor(D3D12_BLEND blend)
+    {
+        switch (blend)
+        {
+        case D3D12_BLEND_ZERO:              return VK_BLEND_FACTOR_ZERO;
+        case D3D12_BLEND_ONE:               return VK_BLEND_FACTOR_ONE;
+        case D3D12_BLEND_SRC_COLOR:         return VK_BLEND_FACTOR_SRC_COLOR;
+        case D3D12_BLEND_INV_SRC_COLOR:     return VK_BLEND_FACTOR_ONE_MINUS_SRC_COLOR;
+        case D3D12_BLEND_SRC_ALPHA:         return VK_BLEND_FACTOR_SRC_ALPHA;
+        case D3D12_BLEND_INV_SRC_ALPHA:     return VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+        case D3D12_BLEND_DEST_ALPHA:        return VK_BLEND_FACTOR_DST_ALPHA;
+        case D3D12_BLEND_INV_DEST_ALPHA:    return VK_BLEND_FACTOR_ONE_MINUS_DST_ALPHA;
+        case D3D12_BLEND_DEST_COLOR:        return VK_BLEND_FACTOR_DST_COLOR;
+        case D3D12_BLEND_INV_DEST_COLOR:    return VK_BLEND_FACTOR_ONE_MINUS_DST_COLOR;
+        case D3D12_BLEND_SRC_ALPHA_SAT:     return VK_BLEND_FACTOR_SRC_ALPHA_SATURATE;
+        case D3D12_BLEND_BLEND_FACTOR:      return VK_BLEND_FACTOR_CONSTANT_COLOR;
+        case D3D12_BLEND_INV_BLEND_FACTOR:  return VK_BLEND_FACTOR_ONE_MINUS_CONSTANT_COLOR;
+        case D3D12_BLEND_SRC1_COLOR:        return VK_BLEND_FACTOR_SRC1_COLOR;
+        case D3D12_BLEND_INV_SRC1_COLOR:    return VK_BLEND_FACTOR_ONE_MINUS_SRC1_COLOR;
+        case D3D12_BLEND_SRC1_ALPHA:        return VK_BLEND_FACTOR_SRC1_ALPHA;
+        case D3D12_BLEND_INV_SRC1_ALPHA:    return VK_BLEND_FACTOR_ONE_MINUS_SRC1_ALPHA;
+        default:                            return VK_BLEND_FACTOR_ONE;
+        }
+    }
+
+    VkBlendOp ToVkBlendOp(D3D12_BLEND_OP blendOp)
+    {
+        switch (blendOp)
+        {
+        case D3D12_BLEND_OP_SUBTRACT:       return VK_BLEND_OP_SUBTRACT;
+        case D3D12_BLEND_OP_REV_SUBTRACT:   return VK_BLEND_OP_REVERSE_SUBTRACT;
+        case D3D12_BLEND_OP_MIN:            return VK_BLEND_OP_MIN;
+        case D3D12_BLEND_OP_MAX:            return VK_BLEND_OP_MAX;
+        default:                            return VK_BLEND_OP_ADD;
+        }
+    }
+
+    // D3D12's comparison functions are Vulkan's compare ops offset by one
+    VkCompareOp ToVkCompareOp(D3D12_COMPARISON_FUNC func)
+    {
+        return static_cast<VkCompareOp>(max(static_cast<int>(func) - D3D12_COMPARISON_FUNC_NEVER, 0));
+    }
+
+    // the name of the first entry point in a SPIR-V module, which DXC takes from the HLSL function name
+    string SpirvEntryPoint(const D3D12_SHADER_BYTECODE& bytecode)
+    {
+        constexpr uint32_t OpEntryPoint = 15;
+        constexpr size_t HeaderWords = 5;
+
+        const uint32_t* pWords = static_cast<const uint32_t*>(bytecode.pShaderBytecode);
+        const size_t wordCount = bytecode.BytecodeLength / sizeof(uint32_t);
+        for (size_t i = HeaderWords; i < wordCount;)
+        {
+            const uint32_t opcode = pWords[i] & 0xFFFF;
+            const uint32_t length = pWords[i] >> 16;
+            if (length == 0 || i + length > wordCount) break;
+
+            // execution model and function id come before the name
+            if (opcode == OpEntryPoint && length > 3)
+            {
+                const char* pName = reinterpret_cast<const char*>(&pWords[i + 3]);
+                return string(pName, strnlen(pName, (length - 3) * sizeof(uint32_t)));
+            }
+            i += length;
+        }
+        return "main";
+    }
+}
+
+
+bool CheckVkResult(VkResult result, const string& msg, bool except)
+{
+    if (result >= VK_SUCCESS) return true;
+
+    PrintMessage(Error, "Vulkan error {}\n\t{}", static_cast<int>(result), msg);
+    if (except)
+    {
+        throw exception();
+    }
+    return false;
+}
+
+VkFormat ToVkFormat(DXGI_FORMAT format, bool depth)
+{
+    switch (format)
+    {
+    case DXGI_FORMAT_R8G8B8A8_UNORM:        return VK_FORMAT_R8G8B8A8_UNORM;
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:   return VK_FORMAT_R8G8B8A8_SRGB;
+    case DXGI_FORMAT_B8G8R8A8_UNORM:        return VK_FORMAT_B8G8R8A8_UNORM;
+    case DXGI_FORMAT_R8_UNORM:              return VK_FORMAT_R8_UNORM;
+    case DXGI_FORMAT_R16G16B16A16_FLOAT:    return VK_FORMAT_R16G16B16A16_SFLOAT;
+    case DXGI_FORMAT_R32G32B32A32_FLOAT:    return VK_FORMAT_R32G32B32A32_SFLOAT;
+    case DXGI_FORMAT_R32G32B32_FLOAT:       return VK_FORMAT_R32G32B32_SFLOAT;
+    case DXGI_FORMAT_R32G32_FLOAT:          return VK_FORMAT_R32G32_SFLOAT;
+    case DXGI_FORMAT_R32_FLOAT:
+    case DXGI_FORMAT_R32_TYPELESS:          return depth ? VK_FORMAT_D32_SFLOAT : VK_FORMAT_R32_SFLOAT;
+    case DXGI_FORMAT_D32_FLOAT:             return VK_FORMAT_D32_SFLOAT;
+    default:                                return VK_FORMAT_UNDEFINED;
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                                      Device
+//**********************************************************************************************************************
+uint VulkanDevice::FindMemoryType(uint typeBits, VkMemoryPropertyFlags flags) const
+{
+    for (uint i = 0; i < memoryProperties.memoryTypeCount; ++i)
+    {
+        if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & flags) == flags) return i;
+    }
+    return UINT32_MAX;
+}
+
+VulkanResource* VulkanDevice::FindBuffer(D3D12_GPU_VIRTUAL_ADDRESS address, VkDeviceSize* pOffset) const
+{
+    auto itr = buffers.upper_bound(address);
+    if (address == 0 || itr == buffers.begin()) return nullptr;
+
+    --itr;
+    const VkDeviceSize offset = address - itr->first;
+    if (offset >= itr->second->GetSize()) return nullptr;
+
+    *pOffset = offset;
+    return itr->second;
+}
+
+
+//**********************************************************************************************************************
+//                                                      Resource
+//**********************************************************************************************************************
+VulkanResource::VulkanResource(RenderEngineStats* pStats, VulkanDevice* pDevice, const D3D12_HEAP_PROPERTIES& heapProperties,
+                               const D3D12_RESOURCE_DESC& desc) :
+    NullResource(pStats, heapProperties, desc, false),
+    m_pDevice(pDevice),
+    m_buffer(VK_NULL_HANDLE),
+    m_bufferMemory(VK_NULL_HANDLE),
+    m_image(VK_NULL_HANDLE),
+    m_imageMemory(VK_NULL_HANDLE),
+    m_imageView(VK_NULL_HANDLE),
+    m_format(VK_FORMAT_UNDEFINED),
+    m_aspect(0),
+    m_layout(VK_IMAGE_LAYOUT_UNDEFINED)
+{
+    if (desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE2D)
+    {
+        if (!CreateImage()) return;
+    }
+    else if (desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER)
+    {
+        PrintMessage(Error, "Vulkan backend: only buffers and 2D textures are supported");
+        return;
+    }
+
+    // the buffer is also the CPU storage, so it must exist even for textures
+    if (CreateBuffer(GetSize()) && !IsTexture())
+    {
+        m_pDevice->buffers[reinterpret_cast<D3D12_GPU_VIRTUAL_ADDRESS>(GetData())] = this;
+    }
+}
+
+VulkanResource::~VulkanResource()
+{
+    const auto itr = m_pDevice->buffers.find(reinterpret_cast<D3D12_GPU_VIRTUAL_ADDRESS>(GetData()));
+    if (itr != m_pDevice->buffers.end() && itr->second == this) m_pDevice->buffers.erase(itr);
+
+    // freeing memory unmaps it, and the base class does not own it
+    vkDestroyImageView(m_pDevice->device, m_imageView, nullptr);
+    vkDestroyImage(m_pDevice->device, m_image, nullptr);
+    vkFreeMemory(m_pDevice->device, m_imageMemory, nullptr);
+    vkDestroyBuffer(m_pDevice->device, m_buffer, nullptr);
+    vkFreeMemory(m_pDevice->device, m_bufferMemory, nullptr);
+}
+
+bool VulkanResource::CreateBuffer(VkDeviceSize size)
+{
+    const VkDevice device = m_pDevice->device;
+
+    VkBufferCreateInfo bufferInfo = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    bufferInfo.size         = max<VkDeviceSize>(size, 4);
+    bufferInfo.usage        = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+                              VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                              VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode  = VK_SHARING_MODE_EXCLUSIVE;
+    if (!CheckVkResult(vkCreateBuffer(device, &bufferInfo, nullptr, &m_buffer), "creating buffer")) return false;
+
+    VkMemoryRequirements requirements = {};
+    vkGetBufferMemoryRequirements(device, m_buffer, &requirements);
+
+    // Root CBVs must start on a 256 byte boundary, which the mapping might not, so allocate enough slack to move the
+    //  buffer along to the first offset which satisfies both its own alignment and constant buffer placement.
+    const VkDeviceSize placement = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+    const VkDeviceSize slack = placement + requirements.alignment;
+
+    VkMemoryAllocateInfo allocateInfo = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocateInfo.allocationSize     = requirements.size + slack;
+    allocateInfo.memoryTypeIndex    = m_pDevice->FindMemoryType(requirements.memoryTypeBits,
+                                                                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (allocateInfo.memoryTypeIndex == UINT32_MAX)
+    {
+        PrintMessage(Error, "Vulkan backend: no host-visible memory for buffers");
+        return false;
+    }
+    if (!CheckVkResult(vkAllocateMemory(device, &allocateInfo, nullptr, &m_bufferMemory), "allocating buffer memory")) return false;
+
+    UINT8* pMapped = nullptr;
+    if (!CheckVkResult(vkMapMemory(device, m_bufferMemory, 0, VK_WHOLE_SIZE, 0, reinterpret_cast<void**>(&pMapped)),
+                       "mapping buffer memory")) return false;
+
+    VkDeviceSize offset = 0;
+    while (offset < slack && reinterpret_cast<uintptr_t>(pMapped + offset) % placement != 0)
+    {
+        offset += requirements.alignment;
+    }
+    if (offset >= slack)
+    {
+        PrintMessage(Warning, "Vulkan backend: buffer could not be placed on a constant buffer boundary");
+        offset = 0;
+    }
+    if (!CheckVkResult(vkBindBufferMemory(device, m_buffer, m_bufferMemory, offset), "binding buffer memory")) return false;
+
+    memset(pMapped + offset, 0, size);
+    SetExternalData(pMapped + offset);
+    return true;
+}
+
+bool VulkanResource::CreateImage()
+{
+    const VkDevice device = m_pDevice->device;
+    const D3D12_RESOURCE_DESC desc = GetDesc();
+    const bool depth = (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL) != 0;
+
+    m_format = ToVkFormat(desc.Format, depth);
+    m_aspect = depth ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    if (m_format == VK_FORMAT_UNDEFINED)
+    {
+        PrintMessage(Error, "Vulkan backend: unsupported texture format {}", magic_enum::enum_name(desc.Format));
+        return false;
+    }
+
+    // only mip 0 is created, matching the CPU storage of the null backend
+    VkImageCreateInfo imageInfo = {VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    imageInfo.imageType     = VK_IMAGE_TYPE_2D;
+    imageInfo.format        = m_format;
+    imageInfo.extent        = {static_cast<uint>(desc.Width), desc.Height, 1};
+    imageInfo.mipLevels     = 1;
+    imageInfo.arrayLayers   = 1;
+    imageInfo.samples       = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling        = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage         = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    imageInfo.sharingMode   = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (depth)                                                      imageInfo.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    if (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET)       imageInfo.usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    if (desc.Flags & D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS)    imageInfo.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+    if (!CheckVkResult(vkCreateImage(device, &imageInfo, nullptr, &m_image), "creating image")) return false;
+
+    VkMemoryRequirements requirements = {};
+    vkGetImageMemoryRequirements(device, m_image, &requirements);
+
+    // prefer device local memory, but software implementations may have nothing of the sort
+    VkMemoryAllocateInfo allocateInfo = {VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    allocateInfo.allocationSize = requirements.size;
+    allocateInfo.memoryTypeIndex = m_pDevice->FindMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (allocateInfo.memoryTypeIndex == UINT32_MAX)
+    {
+        allocateInfo.memoryTypeIndex = m_pDevice->FindMemoryType(requirements.memoryTypeBits, 0);
+    }
+    if (!CheckVkResult(vkAllocateMemory(device, &allocateInfo, nullptr, &m_imageMemory), "allocating image memory")) return false;
+    if (!CheckVkResult(vkBindImageMemory(device, m_image, m_imageMemory, 0), "binding image memory")) return false;
+
+    VkImageViewCreateInfo viewInfo = {VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+    viewInfo.image              = m_image;
+    viewInfo.viewType           = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format             = m_format;
+    viewInfo.subresourceRange   = {m_aspect, 0, 1, 0, 1};
+    return CheckVkResult(vkCreateImageView(device, &viewInfo, nullptr, &m_imageView), "creating image view");
+}
+
+void VulkanResource::Transition(VkCommandBuffer commandBuffer, VkImageLayout layout)
+{
+    // Barriers are deliberately coarse, and are issued even when the layout is unchanged so that back to back writes
+    //  are ordered. Overlap between commands matters little next to keeping this obviously correct.
+    VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barrier.srcAccessMask       = VK_ACCESS_MEMORY_WRITE_BIT;
+    barrier.dstAccessMask       = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    barrier.oldLayout           = m_layout;
+    barrier.newLayout           = layout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image               = m_image;
+    barrier.subresourceRange    = {m_aspect, 0, 1, 0, 1};
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                         0, nullptr, 0, nullptr, 1, &barrier);
+    m_layout = layout;
+}
+
+void VulkanResource::RecordReadback(VkCommandBuffer commandBuffer)
+{
+    Transition(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+    // rows are tightly packed in the CPU storage, which is what a zero row length asks for
+    const D3D12_RESOURCE_DESC desc = GetDesc();
+    VkBufferImageCopy region = {};
+    region.imageSubresource = {m_aspect, 0, 0, 1};
+    region.imageExtent      = {static_cast<uint>(desc.Width), desc.Height, 1};
+    vkCmdCopyImageToBuffer(commandBuffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_buffer, 1, &region);
+
+    // make the copy visible to the host once the submission's fence is signaled
+    VkBufferMemoryBarrier barrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+    barrier.srcAccessMask       = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask       = VK_ACCESS_HOST_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer              = m_buffer;
+    barrier.size                = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                         0, nullptr, 1, &barrier, 0, nullptr);
+}
+
+
+//**********************************************************************************************************************
+//                                                  Pipeline Objects
+//**********************************************************************************************************************
+VulkanRootSignature::VulkanRootSignature(RenderEngineStats* pStats, VulkanDevice* pDevice,
+                                         const CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC& desc) :
+    NullRootSignature(pStats, desc),
+    m_pDevice(pDevice),
+    m_setLayout(VK_NULL_HANDLE),
+    m_pipelineLayout(VK_NULL_HANDLE),
+    m_bindings(NumParameters(), -1)
+{
+    std::vector<VkDescriptorSetLayoutBinding> bindings;
+    for (uint i = 0; i < NumParameters(); ++i)
+    {
+        // SPIR-V makes every unannotated constant buffer a uniform buffer, so root constants could never reach it
+        // TODO: root SRV/UAVs and descriptor tables
+        const NullRootParameter& parameter = GetParameter(i);
+        NULL_BACKEND_VALIDATE(m_pStats, parameter.type != D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS,
+                              "Vulkan backend: root constants for b{} are not supported, bind it as a root CBV",
+                              parameter.shaderRegister);
+        if (parameter.type != D3D12_ROOT_PARAMETER_TYPE_CBV) continue;
+        NULL_BACKEND_VALIDATE(m_pStats, parameter.registerSpace == 0,
+                              "Vulkan backend: root CBV b{} is in space {}, only space 0 is supported",
+                              parameter.shaderRegister, parameter.registerSpace);
+
+        VkDescriptorSetLayoutBinding binding = {};
+        binding.binding         = parameter.shaderRegister;
+        binding.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        binding.descriptorCount = 1;
+        binding.stageFlags      = ToVkShaderStages(parameter.visibility);
+        bindings.push_back(binding);
+        m_bindings[i] = parameter.shaderRegister;
+    }
+
+    VkDescriptorSetLayoutCreateInfo setLayoutInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    setLayoutInfo.flags         = VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+    setLayoutInfo.bindingCount  = static_cast<uint>(bindings.size());
+    setLayoutInfo.pBindings     = bindings.data();
+    if (!CheckVkResult(vkCreateDescriptorSetLayout(m_pDevice->device, &setLayoutInfo, nullptr, &m_setLayout),
+                       "creating descriptor set layout")) return;
+
+    VkPipelineLayoutCreateInfo layoutInfo = {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    layoutInfo.setLayoutCount   = 1;
+    layoutInfo.pSetLayouts      = &m_setLayout;
+    CheckVkResult(vkCreatePipelineLayout(m_pDevice->device, &layoutInfo, nullptr, &m_pipelineLayout), "creating pipeline layout");
+}
+
+VulkanRootSignature::~VulkanRootSignature()
+{
+    vkDestroyPipelineLayout(m_pDevice->device, m_pipelineLayout, nullptr);
+    vkDestroyDescriptorSetLayout(m_pDevice->device, m_setLayout, nullptr);
+}
+
+
+VulkanPipelineState::VulkanPipelineState(RenderEngineStats* pStats, VulkanDevice* pDevice,
+                                         const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc) :
+    NullPipelineState(pStats, &desc),
+    m_pDevice(pDevice),
+    m_pRootSignature(static_cast<VulkanRootSignature*>(desc.pRootSignature)),
+    m_pipeline(VK_NULL_HANDLE)
+{
+    if (m_pRootSignature == nullptr) return;
+
+    // shaders
+    std::vector<VkPipelineShaderStageCreateInfo> stages;
+    std::vector<string> entryPoints;
+    entryPoints.reserve(2);
+    for (const auto& [bytecode, stage] : {make_pair(desc.VS, VK_SHADER_STAGE_VERTEX_BIT), make_pair(desc.PS, VK_SHADER_STAGE_FRAGMENT_BIT)})
+    {
+        if (bytecode.pShaderBytecode == nullptr) continue;
+
+        entryPoints.push_back(SpirvEntryPoint(bytecode));
+        VkPipelineShaderStageCreateInfo stageInfo = {VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO};
+        stageInfo.stage     = stage;
+        stageInfo.module    = CreateShaderModule(bytecode);
+        stageInfo.pName     = entryPoints.back().c_str();
+        stages.push_back(stageInfo);
+    }
+
+    // vertex input, with strides left to the bound views
+    std::vector<VkVertexInputBindingDescription> vertexBindings;
+    std::vector<VkVertexInputAttributeDescription> vertexAttributes;
+    uint slotOffsets[D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT] = {};
+    const std::vector<D3D12_INPUT_ELEMENT_DESC>& inputLayout = GetInputLayout();
+    for (uint i = 0; i < inputLayout.size(); ++i)
+    {
+        const D3D12_INPUT_ELEMENT_DESC& element = inputLayout[i];
+
+        VkVertexInputAttributeDescription attribute = {};
+        attribute.location  = i;
+        attribute.binding   = element.InputSlot;
+        attribute.format    = ToVkFormat(element.Format);
+        attribute.offset    = (element.AlignedByteOffset == D3D12_APPEND_ALIGNED_ELEMENT) ? slotOffsets[element.InputSlot] :
+                                                                                            element.AlignedByteOffset;
+        slotOffsets[element.InputSlot] = attribute.offset + BytesPerPixel(element.Format);
+        NULL_BACKEND_VALIDATE(m_pStats, attribute.format != VK_FORMAT_UNDEFINED, "Vulkan backend: unsupported vertex format {}",
+                              magic_enum::enum_name(element.Format));
+        vertexAttributes.push_back(attribute);
+
+        if (find(m_vertexSlots.begin(), m_vertexSlots.end(), element.InputSlot) == m_vertexSlots.end())
+        {
+            VkVertexInputBindingDescription binding = {};
+            binding.binding     = element.InputSlot;
+            binding.inputRate   = (element.InputSlotClass == D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA) ?
+                                  VK_VERTEX_INPUT_RATE_INSTANCE : VK_VERTEX_INPUT_RATE_VERTEX;
+            vertexBindings.push_back(binding);
+            m_vertexSlots.push_back(element.InputSlot);
+        }
+    }
+
+    VkPipelineVertexInputStateCreateInfo vertexInput = {VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
+    vertexInput.vertexBindingDescriptionCount   = static_cast<uint>(vertexBindings.size());
+    vertexInput.pVertexBindingDescriptions      = vertexBindings.data();
+    vertexInput.vertexAttributeDescriptionCount = static_cast<uint>(vertexAttributes.size());
+    vertexInput.pVertexAttributeDescriptions    = vertexAttributes.data();
+
+    // the exact topology is set with the draw, within the class given here
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly = {VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
+    inputAssembly.topology = ToVkTopology(desc.PrimitiveTopologyType);
+
+    VkPipelineViewportStateCreateInfo viewportState = {VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
+    viewportState.viewportCount = 1;
+    viewportState.scissorCount  = 1;
+
+    // Viewports are flipped to keep D3D's orientation, so clockwise on screen is still clockwise in framebuffer space.
+    const D3D12_RASTERIZER_DESC& rasterizerDesc = GetRasterizerState();
+    VkPipelineRasterizationStateCreateInfo rasterization = {VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO};
+    rasterization.polygonMode               = (rasterizerDesc.FillMode == D3D12_FILL_MODE_WIREFRAME) ? VK_POLYGON_MODE_LINE : VK_POLYGON_MODE_FILL;
+    rasterization.cullMode                  = (rasterizerDesc.CullMode == D3D12_CULL_MODE_FRONT) ? VK_CULL_MODE_FRONT_BIT :
+                                              (rasterizerDesc.CullMode == D3D12_CULL_MODE_BACK)  ? VK_CULL_MODE_BACK_BIT  : VK_CULL_MODE_NONE;
+    rasterization.frontFace                 = rasterizerDesc.FrontCounterClockwise ? VK_FRONT_FACE_COUNTER_CLOCKWISE : VK_FRONT_FACE_CLOCKWISE;
+    rasterization.depthClampEnable          = !rasterizerDesc.DepthClipEnable;
+    rasterization.depthBiasEnable           = (rasterizerDesc.DepthBias != 0 || rasterizerDesc.SlopeScaledDepthBias != 0.0f);
+    rasterization.depthBiasConstantFactor   = static_cast<float>(rasterizerDesc.DepthBias);
+    rasterization.depthBiasClamp            = rasterizerDesc.DepthBiasClamp;
+    rasterization.depthBiasSlopeFactor      = rasterizerDesc.SlopeScaledDepthBias;
+    rasterization.lineWidth                 = 1.0f;
+
+    // TODO: MSAA
+    NULL_BACKEND_VALIDATE(m_pStats, desc.SampleDesc.Count <= 1, "Vulkan backend: multisampled pipelines are not supported");
+    VkPipelineMultisampleStateCreateInfo multisample = {VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO};
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    // TODO: stencil
+    const D3D12_DEPTH_STENCIL_DESC& depthStencilDesc = GetDepthStencilState();
+    NULL_BACKEND_VALIDATE(m_pStats, !depthStencilDesc.StencilEnable, "Vulkan backend: stencil testing is not supported");
+    VkPipelineDepthStencilStateCreateInfo depthStencil = {VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO};
+    depthStencil.depthTestEnable    = depthStencilDesc.DepthEnable;
+    depthStencil.depthWriteEnable   = depthStencilDesc.DepthEnable && (depthStencilDesc.DepthWriteMask == D3D12_DEPTH_WRITE_MASK_ALL);
+    depthStencil.depthCompareOp     = ToVkCompareOp(depthStencilDesc.DepthFunc);
+
+    // write masks share their bit layout between the two APIs
+    VkPipelineColorBlendAttachmentState blendAttachments[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT] = {};
+    VkFormat colorFormats[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT] = {};
+    for (uint i = 0; i < desc.NumRenderTargets; ++i)
+    {
+        const D3D12_RENDER_TARGET_BLEND_DESC& target = desc.BlendState.RenderTarget[desc.BlendState.IndependentBlendEnable ? i : 0];
+        blendAttachments[i].blendEnable         = target.BlendEnable;
+        blendAttachments[i].srcColorBlendFactor = ToVkBlendFactor(target.SrcBlend);
+        blendAttachments[i].dstColorBlendFactor = ToVkBlendFactor(target.DestBlend);
+        blendAttachments[i].colorBlendOp        = ToVkBlendOp(target.BlendOp);
+        blendAttachments[i].srcAlphaBlendFactor = ToVkBlendFactor(target.SrcBlendAlpha);
+        blendAttachments[i].dstAlphaBlendFactor = ToVkBlendFactor(target.DestBlendAlpha);
+        blendAttachments[i].alphaBlendOp        = ToVkBlendOp(target.BlendOpAlpha);
+        blendAttachments[i].colorWriteMask      = target.RenderTargetWriteMask;
+        colorFormats[i] = ToVkFormat(desc.RTVFormats[i]);
+    }
+
+    VkPipelineColorBlendStateCreateInfo colorBlend = {VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO};
+    colorBlend.attachmentCount  = desc.NumRenderTargets;
+    colorBlend.pAttachments     = blendAttachments;
+
+    const VkDynamicState dynamicStates[] =
+    {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR,
+        VK_DYNAMIC_STATE_PRIMITIVE_TOPOLOGY,
+        VK_DYNAMIC_STATE_VERTEX_INPUT_BINDING_STRIDE,
+    };
+    VkPipelineDynamicStateCreateInfo dynamicState = {VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
+    dynamicState.dynamicStateCount  = _countof(dynamicStates);
+    dynamicState.pDynamicStates     = dynamicStates;
+
+    // dynamic rendering takes attachment formats in place of a render pass
+    VkPipelineRenderingCreateInfo renderingInfo = {VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO};
+    renderingInfo.colorAttachmentCount      = desc.NumRenderTargets;
+    renderingInfo.pColorAttachmentFormats   = colorFormats;
+    renderingInfo.depthAttachmentFormat     = (desc.DSVFormat != DXGI_FORMAT_UNKNOWN) ? ToVkFormat(desc.DSVFormat, true) : VK_FORMAT_UNDEFINED;
+
+    VkGraphicsPipelineCreateInfo pipelineInfo = {VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
+    pipelineInfo.pNext                  = &renderingInfo;
+    pipelineInfo.stageCount             = static_cast<uint>(stages.size());
+    pipelineInfo.pStages                = stages.data();
+    pipelineInfo.pVertexInputState      = &vertexInput;
+    pipelineInfo.pInputAssemblyState    = &inputAssembly;
+    pipelineInfo.pViewportState         = &viewportState;
+    pipelineInfo.pRasterizationState    = &rasterization;
+    pipelineInfo.pMultisampleState      = &multisample;
+    pipelineInfo.pDepthStencilState     = &depthStencil;
+    pipelineInfo.pColorBlendState       = &colorBlend;
+    pipelineInfo.pDynamicState          = &dynamicState;
+    pipelineInfo.layout                 = m_pRootSignature->GetPipelineLayout();
+
+    // TODO: pipeline cache
+    const bool modulesCreated = all_of(stages.begin(), stages.end(), [](const auto& stage) {return stage.module != VK_NULL_HANDLE;});
+    if (modulesCreated && !stages.empty())
+    {
+        CheckVkResult(vkCreateGraphicsPipelines(m_pDevice->device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline),
+                      "creating graphics pipeline");
+    }
+
+    for (const VkPipelineShaderStageCreateInfo& stage : stages)
+    {
+        vkDestroyShaderModule(m_pDevice->device, stage.module, nullptr);
+    }
+}
+
+VulkanPipelineState::~VulkanPipelineState()
+{
+    vkDestroyPipeline(m_pDevice->device, m_pipeline, nullptr);
+}
+
+VkShaderModule VulkanPipelineState::CreateShaderModule(const D3D12_SHADER_BYTECODE& bytecode)
+{
+    constexpr uint32_t SpirvMagic = 0x07230203;
+
+    const bool isSpirv = bytecode.BytecodeLength >= sizeof(uint32_t) &&
+                         *static_cast<const uint32_t*>(bytecode.pShaderBytecode) == SpirvMagic;
+    if (!isSpirv)
+    {
+        PrintMessage(Error, "Vulkan backend: shader bytecode is not SPIR-V, was it compiled before the engine was created?");
+        m_pStats->validationErrors++;
+        return VK_NULL_HANDLE;
+    }
+
+    VkShaderModuleCreateInfo moduleInfo = {VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+    moduleInfo.codeSize = bytecode.BytecodeLength;
+    moduleInfo.pCode    = static_cast<const uint32_t*>(bytecode.pShaderBytecode);
+
+    VkShaderModule module = VK_NULL_HANDLE;
+    CheckVkResult(vkCreateShaderModule(m_pDevice->device, &moduleInfo, nullptr, &module), "creating shader module");
+    return module;
+}
+
+
+//**********************************************************************************************************************
+//                                                  Command List
+//**********************************************************************************************************************
+HRESULT VulkanCommandList::Reset(ID3D12CommandAllocator* pAllocator, ID3D12PipelineState* pInitialState)
+{
+    m_commands.clear();
+    return NullCommandList::Reset(pAllocator, pInitialState);
+}
+
+void VulkanCommandList::DrawInstanced(UINT vertexCountPerInstance, UINT instanceCount, UINT startVertexLocation,
+                                      UINT startInstanceLocation)
+{
+    const uint64 errorCount = m_pStats->validationErrors;
+    NullCommandList::DrawInstanced(vertexCountPerInstance, instanceCount, startVertexLocation, startInstanceLocation);
+    if (m_pStats->validationErrors == errorCount && m_isOpen)
+    {
+        RecordDraw(false, vertexCountPerInstance, instanceCount, startVertexLocation, 0, startInstanceLocation);
+    }
+}
+
+void VulkanCommandList::DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation,
+                                             INT baseVertexLocation, UINT startInstanceLocation)
+{
+    const uint64 errorCount = m_pStats->validationErrors;
+    NullCommandList::DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation,
+                                          startInstanceLocation);
+    if (m_pStats->validationErrors == errorCount && m_isOpen)
+    {
+        RecordDraw(true, indexCountPerInstance, instanceCount, startIndexLocation, baseVertexLocation, startInstanceLocation);
+    }
+}
+
+void VulkanCommandList::ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView, D3D12_CLEAR_FLAGS clearFlags,
+                                              FLOAT depth, UINT8 stencil, UINT numRects, const D3D12_RECT* pRects)
+{
+    NullCommandList::ClearDepthStencilView(depthStencilView, clearFlags, depth, stencil, numRects, pRects);
+
+    // there is no stencil, and rects are not honored, so the whole target is cleared
+    NullResource* pResource = NullDescriptorHeap::FromHandle(depthStencilView)->pResource.Get();
+    if (m_isOpen && pResource != nullptr && (clearFlags & D3D12_CLEAR_FLAG_DEPTH))
+    {
+        Command command = {};
+        command.type = ClearDepthCommand;
+        command.pDepthStencil = static_cast<VulkanResource*>(pResource);
+        command.clearValue.depthStencil = {depth, stencil};
+        m_commands.push_back(command);
+    }
+}
+
+void VulkanCommandList::ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView, const FLOAT colorRGBA[4],
+                                              UINT numRects, const D3D12_RECT* pRects)
+{
+    NullCommandList::ClearRenderTargetView(renderTargetView, colorRGBA, numRects, pRects);
+
+    NullResource* pResource = NullDescriptorHeap::FromHandle(renderTargetView)->pResource.Get();
+    if (m_isOpen && pResource != nullptr)
+    {
+        Command command = {};
+        command.type = ClearColorCommand;
+        command.pRenderTargets[0] = static_cast<VulkanResource*>(pResource);
+        command.numRenderTargets = 1;
+        memcpy(command.clearValue.color.float32, colorRGBA, sizeof(command.clearValue.color.float32));
+        m_commands.push_back(command);
+    }
+}
+
+void VulkanCommandList::RecordDraw(bool indexed, uint count, uint instanceCount, uint start, int baseVertex, uint startInstance)
+{
+    Command command = {};
+    command.type                = DrawCommand;
+    command.numRenderTargets    = m_numRenderTargets;
+    command.pDepthStencil       = (m_pDepthStencil != nullptr) ? static_cast<VulkanResource*>(m_pDepthStencil->pResource.Get()) : nullptr;
+    command.pPipelineState      = static_cast<VulkanPipelineState*>(m_pPipelineState);
+    command.pRootSignature      = static_cast<VulkanRootSignature*>(m_pRootSignature);
+    command.viewport            = m_viewport;
+    command.scissorRect         = m_scissorRect;
+    command.topology            = m_topology;
+    command.indexBufferView     = m_indexBufferView;
+    command.indexed             = indexed;
+    command.count               = count;
+    command.instanceCount       = instanceCount;
+    command.start               = start;
+    command.baseVertex          = baseVertex;
+    command.startInstance       = startInstance;
+    for (uint i = 0; i < m_numRenderTargets; ++i)
+    {
+        command.pRenderTargets[i] = static_cast<VulkanResource*>(m_pRenderTargets[i]->pResource.Get());
+    }
+    memcpy(command.vertexBufferViews, m_vertexBufferViews, sizeof(m_vertexBufferViews));
+
+    // root CBVs as they are bound now, resolved to buffers at execution
+    for (uint i = 0; i < command.pRootSignature->NumParameters(); ++i)
+    {
+        const int binding = command.pRootSignature->GetBinding(i);
+        if (binding >= 0) command.constantBuffers.push_back({binding, m_rootAddresses[i]});
+    }
+
+    m_commands.push_back(command);
+}
+
+void VulkanCommandList::Execute(VkCommandBuffer commandBuffer, std::vector<VulkanResource*>& writtenTextures)
+{
+    const Command* pRenderingCommand = nullptr;    // the draw which began the open rendering scope, if any
+
+    const auto EndRendering = [&]()
+    {
+        if (pRenderingCommand != nullptr) vkCmdEndRendering(commandBuffer);
+        pRenderingCommand = nullptr;
+    };
+    const auto MarkWritten = [&](VulkanResource* pTexture)
+    {
+        if (pTexture != nullptr && find(writtenTextures.begin(), writtenTextures.end(), pTexture) == writtenTextures.end())
+        {
+            writtenTextures.push_back(pTexture);
+        }
+    };
+    const auto SameTargets = [](const Command& a, const Command& b)
+    {
+        return a.numRenderTargets == b.numRenderTargets && a.pDepthStencil == b.pDepthStencil &&
+               equal(a.pRenderTargets, a.pRenderTargets + a.numRenderTargets, b.pRenderTargets);
+    };
+
+    for (const Command& command : m_commands)
+    {
+        switch (command.type)
+        {
+        case ClearColorCommand:
+        {
+            EndRendering();
+            VulkanResource* pTarget = command.pRenderTargets[0];
+            const VkImageSubresourceRange range = {pTarget->GetAspect(), 0, 1, 0, 1};
+            pTarget->Transition(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+            vkCmdClearColorImage(commandBuffer, pTarget->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                 &command.clearValue.color, 1, &range);
+            MarkWritten(pTarget);
+            break;
+        }
+        case ClearDepthCommand:
+        {
+            EndRendering();
+            VulkanResource* pTarget = command.pDepthStencil;
+            const VkImageSubresourceRange range = {pTarget->GetAspect(), 0, 1, 0, 1};
+            pTarget->Transition(commandBuffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+            vkCmdClearDepthStencilImage(commandBuffer, pTarget->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                        &command.clearValue.depthStencil, 1, &range);
+            MarkWritten(pTarget);
+            break;
+        }
+        case DrawCommand:
+        {
+            if (pRenderingCommand == nullptr || !SameTargets(*pRenderingCommand, command))
+            {
+                EndRendering();
+                BeginRendering(commandBuffer, command);
+                pRenderingCommand = &command;
+
+                for (uint i = 0; i < command.numRenderTargets; ++i) MarkWritten(command.pRenderTargets[i]);
+                MarkWritten(command.pDepthStencil);
+            }
+
+            if (!BindDrawState(commandBuffer, command)) break;
+
+            if (command.indexed)
+            {
+                vkCmdDrawIndexed(commandBuffer, command.count, command.instanceCount, command.start, command.baseVertex,
+                                 command.startInstance);
+            }
+            else
+            {
+                vkCmdDraw(commandBuffer, command.count, command.instanceCount, command.start, command.startInstance);
+            }
+            break;
+        }
+        }
+    }
+
+    EndRendering();
+}
+
+void VulkanCommandList::BeginRendering(VkCommandBuffer commandBuffer, const Command& command)
+{
+    VkRenderingAttachmentInfo colorAttachments[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT] = {};
+    VkRenderingAttachmentInfo depthAttachment = {VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
+    VkExtent2D extent = {UINT32_MAX, UINT32_MAX};
+
+    // targets keep their contents, clears having been recorded separately
+    const auto Attach = [&](VulkanResource* pTarget, VkImageLayout layout, VkRenderingAttachmentInfo& attachment)
+    {
+        pTarget->Transition(commandBuffer, layout);
+        attachment.sType        = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        attachment.imageView    = pTarget->GetImageView();
+        attachment.imageLayout  = layout;
+        attachment.loadOp       = VK_ATTACHMENT_LOAD_OP_LOAD;
+        attachment.storeOp      = VK_ATTACHMENT_STORE_OP_STORE;
+
+        const D3D12_RESOURCE_DESC desc = pTarget->GetDesc();
+        extent.width  = min(extent.width, static_cast<uint>(desc.Width));
+        extent.height = min(extent.height, desc.Height);
+    };
+
+    for (uint i = 0; i < command.numRenderTargets; ++i)
+    {
+        Attach(command.pRenderTargets[i], VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, colorAttachments[i]);
+    }
+    if (command.pDepthStencil != nullptr)
+    {
+        Attach(command.pDepthStencil, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, depthAttachment);
+    }
+
+    VkRenderingInfo renderingInfo = {VK_STRUCTURE_TYPE_RENDERING_INFO};
+    renderingInfo.renderArea            = {{0, 0}, extent};
+    renderingInfo.layerCount            = 1;
+    renderingInfo.colorAttachmentCount  = command.numRenderTargets;
+    renderingInfo.pColorAttachments     = colorAttachments;
+    renderingInfo.pDepthAttachment      = (command.pDepthStencil != nullptr) ? &depthAttachment : nullptr;
+    vkCmdBeginRendering(commandBuffer, &renderingInfo);
+}
+
+bool VulkanCommandList::BindDrawState(VkCommandBuffer commandBuffer, const Command& command)
+{
+    const VulkanPipelineState* pPipelineState = command.pPipelineState;
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pPipelineState->GetPipeline());
+
+    // D3D's viewport origin is the top left with y running down, which a negative height reproduces
+    const D3D12_VIEWPORT& d3dViewport = command.viewport;
+    const VkViewport viewport = {d3dViewport.TopLeftX, d3dViewport.TopLeftY + d3dViewport.Height, d3dViewport.Width,
+                                 -d3dViewport.Height, d3dViewport.MinDepth, d3dViewport.MaxDepth};
+    const D3D12_RECT& d3dScissor = command.scissorRect;
+    const VkRect2D scissor = {{d3dScissor.left, d3dScissor.top},
+                              {static_cast<uint>(max<LONG>(d3dScissor.right - d3dScissor.left, 0)),
+                               static_cast<uint>(max<LONG>(d3dScissor.bottom - d3dScissor.top, 0))}};
+    vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+    vkCmdSetPrimitiveTopology(commandBuffer, ToVkTopology(command.topology));
+
+    // vertex and index buffers, located by address
+    for (uint slot : pPipelineState->GetVertexSlots())
+    {
+        const D3D12_VERTEX_BUFFER_VIEW& view = command.vertexBufferViews[slot];
+        VkDeviceSize offset = 0;
+        const VulkanResource* pBuffer = m_pDevice->FindBuffer(view.BufferLocation, &offset);
+        if (pBuffer == nullptr)
+        {
+            PrintMessage(Error, "Vulkan backend: vertex buffer slot {} does not point into a buffer, draw skipped", slot);
+            m_pStats->validationErrors++;
+            return false;
+        }
+
+        const VkBuffer buffer = pBuffer->GetBuffer();
+        const VkDeviceSize size = view.SizeInBytes;
+        const VkDeviceSize stride = view.StrideInBytes;
+        vkCmdBindVertexBuffers2(commandBuffer, slot, 1, &buffer, &offset, &size, &stride);
+    }
+    if (command.indexed)
+    {
+        VkDeviceSize offset = 0;
+        const VulkanResource* pBuffer = m_pDevice->FindBuffer(command.indexBufferView.BufferLocation, &offset);
+        if (pBuffer == nullptr)
+        {
+            PrintMessage(Error, "Vulkan backend: index buffer does not point into a buffer, draw skipped");
+            m_pStats->validationErrors++;
+            return false;
+        }
+
+        const VkIndexType indexType = (command.indexBufferView.Format == DXGI_FORMAT_R16_UINT) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+        vkCmdBindIndexBuffer(commandBuffer, pBuffer->GetBuffer(), offset, indexType);
+    }
+
+    // root CBVs are pushed, much as they are written into the root arguments of a D3D12 command list
+    const uint constantBufferCount = static_cast<uint>(command.constantBuffers.size());
+    if (constantBufferCount == 0) return true;
+
+    std::vector<VkDescriptorBufferInfo> bufferInfos(constantBufferCount);
+    std::vector<VkWriteDescriptorSet> writes(constantBufferCount);
+    for (uint i = 0; i < constantBufferCount; ++i)
+    {
+        const auto& [binding, address] = command.constantBuffers[i];
+        VkDeviceSize offset = 0;
+        const VulkanResource* pBuffer = m_pDevice->FindBuffer(address, &offset);
+        if (pBuffer == nullptr)
+        {
+            PrintMessage(Error, "Vulkan backend: root CBV for b{} does not point into a buffer, draw skipped", binding);
+            m_pStats->validationErrors++;
+            return false;
+        }
+
+        bufferInfos[i].buffer   = pBuffer->GetBuffer();
+        bufferInfos[i].offset   = offset;
+        bufferInfos[i].range    = min<VkDeviceSize>(pBuffer->GetSize() - offset, m_pDevice->properties.limits.maxUniformBufferRange);
+
+        writes[i].sType             = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[i].dstBinding        = binding;
+        writes[i].descriptorCount   = 1;
+        writes[i].descriptorType    = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        writes[i].pBufferInfo       = &bufferInfos[i];
+    }
+    m_pDevice->vkCmdPushDescriptorSet(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, command.pRootSignature->GetPipelineLayout(),
+                                      0, constantBufferCount, writes.data());
+    return true;
+}
@@ -0,0 +1,201 @@
+// VulkanObjects - D3D12 interface implementations backed by Vulkan objects.
+//
+// These build upon the null backend's objects, which continue to do all validation and state tracking. Buffers live in
+//  host-visible Vulkan memory which doubles as the null resource's CPU storage, so maps, copies and GPU virtual
+//  addresses behave exactly as they do in the null backend while the device reads the very same bytes. Textures are
+//  device images, and their CPU storage is a readback buffer which receives the image contents after each execution.
+//
+// Root CBVs become push descriptors, with the HLSL register as the binding, which is where DXC places them by default.
+//
+// Root constants are rejected rather than mapped onto push constants: DXC compiles a cbuffer to a push constant block
+//  only when the source marks it [[vk::push_constant]], and otherwise to a uniform buffer, which only a root CBV can
+//  bind. Root signatures for this backend therefore keep every constant buffer a root CBV.
+//
+// TODO: root SRV/UAVs and descriptor tables, stencil, and uploads into textures
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "backends/NullObjects.h"
+
+class VulkanResource;
+
+
+bool CheckVkResult(VkResult result, const std::string& msg = "", bool except = false);
+VkFormat ToVkFormat(DXGI_FORMAT format, bool depth = false);
+
+
+// device level objects shared by everything the backend creates
+struct VulkanDevice
+{
+    VkInstance                          instance;
+    VkPhysicalDevice                    physicalDevice;
+    VkDevice                            device;
+    VkQueue                             queue;
+    uint                                queueFamily;
+    VkPhysicalDeviceProperties          properties;
+    VkPhysicalDeviceMemoryProperties    memoryProperties;
+    PFN_vkCmdPushDescriptorSetKHR       vkCmdPushDescriptorSet;
+
+    // buffers keyed by the start of their address range, so that views and root descriptors can be resolved
+    std::map<D3D12_GPU_VIRTUAL_ADDRESS, VulkanResource*> buffers;
+
+    uint FindMemoryType(uint typeBits, VkMemoryPropertyFlags flags) const;
+    VulkanResource* FindBuffer(D3D12_GPU_VIRTUAL_ADDRESS address, VkDeviceSize* pOffset) const;
+};
+
+
+//**********************************************************************************************************************
+//                                                      Resource
+//**********************************************************************************************************************
+class VulkanResource : public NullResource
+{
+public:
+    VulkanResource(RenderEngineStats* pStats, VulkanDevice* pDevice, const D3D12_HEAP_PROPERTIES& heapProperties,
+                   const D3D12_RESOURCE_DESC& desc);
+    ~VulkanResource();
+
+    bool IsValid() const                    {return m_buffer != VK_NULL_HANDLE;}
+    bool IsTexture() const                  {return m_image != VK_NULL_HANDLE;}
+
+    // buffers are the resource itself, textures use theirs for readback
+    VkBuffer GetBuffer() const              {return m_buffer;}
+    VkImage GetImage() const                {return m_image;}
+    VkImageView GetImageView() const        {return m_imageView;}
+    VkFormat GetFormat() const              {return m_format;}
+    VkImageAspectFlags GetAspect() const    {return m_aspect;}
+
+    // images are transitioned as they are recorded, since execution is serialized
+    void Transition(VkCommandBuffer commandBuffer, VkImageLayout layout);
+    void RecordReadback(VkCommandBuffer commandBuffer);
+
+private:
+    bool CreateBuffer(VkDeviceSize size);
+    bool CreateImage();
+
+    VulkanDevice*       m_pDevice;
+    VkBuffer            m_buffer;
+    VkDeviceMemory      m_bufferMemory;
+    VkImage             m_image;
+    VkDeviceMemory      m_imageMemory;
+    VkImageView         m_imageView;
+    VkFormat            m_format;
+    VkImageAspectFlags  m_aspect;
+    VkImageLayout       m_layout;
+};
+
+
+//**********************************************************************************************************************
+//                                                  Pipeline Objects
+//**********************************************************************************************************************
+class VulkanRootSignature : public NullRootSignature
+{
+public:
+    VulkanRootSignature(RenderEngineStats* pStats, VulkanDevice* pDevice,
+                        const CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC& desc);
+    ~VulkanRootSignature();
+
+    bool IsValid() const                        {return m_pipelineLayout != VK_NULL_HANDLE;}
+    VkPipelineLayout GetPipelineLayout() const  {return m_pipelineLayout;}
+    int GetBinding(uint parameterIndex) const   {return m_bindings[parameterIndex];}   // -1 if not a root CBV
+
+private:
+    VulkanDevice*           m_pDevice;
+    VkDescriptorSetLayout   m_setLayout;
+    VkPipelineLayout        m_pipelineLayout;
+    std::vector<int>        m_bindings;
+};
+
+
+// Vertex attributes take their location from their position in the input layout, which matches the order DXC assigns
+//  to vertex shader inputs, and vertex buffer slots map directly onto bindings. Strides come from the bound views.
+class VulkanPipelineState : public NullPipelineState
+{
+public:
+    VulkanPipelineState(RenderEngineStats* pStats, VulkanDevice* pDevice, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc);
+    ~VulkanPipelineState();
+
+    bool IsValid() const                            {return m_pipeline != VK_NULL_HANDLE;}
+    VkPipeline GetPipeline() const                  {return m_pipeline;}
+    VulkanRootSignature* GetRootSignature() const   {return m_pRootSignature.Get();}
+    const std::vector<uint>& GetVertexSlots() const {return m_vertexSlots;}
+
+private:
+    VkShaderModule CreateShaderModule(const D3D12_SHADER_BYTECODE& bytecode);
+
+    VulkanDevice*                   m_pDevice;
+    ComPtr<VulkanRootSignature>     m_pRootSignature;
+    VkPipeline                      m_pipeline;
+    std::vector<uint>               m_vertexSlots;
+};
+
+
+//**********************************************************************************************************************
+//                                                  Command List
+//**********************************************************************************************************************
+// Records clears and draws along with the state they need, translating them into a Vulkan command buffer on execution.
+//  Dynamic rendering scopes are opened and closed around runs of draws to the same targets.
+class VulkanCommandList : public NullCommandList
+{
+public:
+    VulkanCommandList(RenderEngineStats* pStats, VulkanDevice* pDevice) : NullCommandList(pStats), m_pDevice(pDevice) {}
+
+    // ID3D12GraphicsCommandList
+    HRESULT STDMETHODCALLTYPE Reset(ID3D12CommandAllocator* pAllocator, ID3D12PipelineState* pInitialState);
+    void STDMETHODCALLTYPE DrawInstanced(UINT vertexCountPerInstance, UINT instanceCount, UINT startVertexLocation,
+                                         UINT startInstanceLocation);
+    void STDMETHODCALLTYPE DrawIndexedInstanced(UINT indexCountPerInstance, UINT instanceCount, UINT startIndexLocation,
+                                                INT baseVertexLocation, UINT startInstanceLocation);
+    void STDMETHODCALLTYPE ClearDepthStencilView(D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView, D3D12_CLEAR_FLAGS clearFlags,
+                                                 FLOAT depth, UINT8 stencil, UINT numRects, const D3D12_RECT* pRects);
+    void STDMETHODCALLTYPE ClearRenderTargetView(D3D12_CPU_DESCRIPTOR_HANDLE renderTargetView, const FLOAT colorRGBA[4],
+                                                 UINT numRects, const D3D12_RECT* pRects);
+
+    // records into the command buffer, returning textures which were written so that they can be read back
+    void Execute(VkCommandBuffer commandBuffer, std::vector<VulkanResource*>& writtenTextures);
+
+private:
+    enum CommandType
+    {
+        ClearColorCommand,
+        ClearDepthCommand,
+        DrawCommand
+    };
+
+    struct Command
+    {
+        CommandType                 type;
+        VulkanResource*             pRenderTargets[D3D12_SIMULTANEOUS_RENDER_TARGET_COUNT];
+        uint                        numRenderTargets;
+        VulkanResource*             pDepthStencil;
+
+        // clears
+        VkClearValue                clearValue;
+
+        // draws
+        VulkanPipelineState*        pPipelineState;
+        VulkanRootSignature*        pRootSignature;     // bound to the list, which is what root arguments follow
+        D3D12_VIEWPORT              viewport;
+        D3D12_RECT                  scissorRect;
+        D3D12_PRIMITIVE_TOPOLOGY    topology;
+        D3D12_VERTEX_BUFFER_VIEW    vertexBufferViews[D3D12_IA_VERTEX_INPUT_RESOURCE_SLOT_COUNT];
+        D3D12_INDEX_BUFFER_VIEW     indexBufferView;
+        std::vector<std::pair<int, D3D12_GPU_VIRTUAL_ADDRESS>> constantBuffers;    // binding and address
+        bool                        indexed;
+        uint                        count;              // indices or vertices per instance
+        uint                        instanceCount;
+        uint                        start;              // first index or vertex
+        int                         baseVertex;
+        uint                        startInstance;
+    };
+
+    void RecordDraw(bool indexed, uint count, uint instanceCount, uint start, int baseVertex, uint startInstance);
+    void BeginRendering(VkCommandBuffer commandBuffer, const Command& command);
+    bool BindDrawState(VkCommandBuffer commandBuffer, const Command& command);
+
+    VulkanDevice*           m_pDevice;
+    std::vector<Command>    m_commands;
+};
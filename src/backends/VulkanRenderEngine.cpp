@@ -0,0 +1,348 @@
+#include "VulkanRenderEngine.h"
+
+#include <cstring>
+
+#include "Profiler.h"
+
+using namespace std;
+
+
+//**********************************************************************************************************************
+//                                              Constructors & Destructors
+//**********************************************************************************************************************
+VulkanRenderEngine::VulkanRenderEngine(UINT width, UINT height) :
+    NullRenderEngine(width, height, L"Vulkan Render Engine"),
+    m_device{},
+    m_commandPool(VK_NULL_HANDLE),
+    m_commandBuffer(VK_NULL_HANDLE),
+    m_fence(VK_NULL_HANDLE),
+    m_timestampPool(VK_NULL_HANDLE),
+    m_timestamps(false),
+    m_submissionCount(0),
+    m_gpuMilliseconds(0.0)
+{
+}
+
+VulkanRenderEngine::~VulkanRenderEngine()
+{
+    // Scenes own the objects this device backs and are typically destroyed after OnDestroy(), so the device has to
+    //  outlive them and can only go once the engine itself does. Our own SRV heap holds references to the textures
+    //  registered with it, so it must let go of them first.
+    m_pSrvHeap.Reset();
+    DestroyDevice();
+}
+
+
+//**********************************************************************************************************************
+//                                              Engine Primary Interfaces
+//**********************************************************************************************************************
+void VulkanRenderEngine::Init(const WindowHandle window)
+{
+    CreateDevice();
+    NullRenderEngine::Init(window);
+}
+
+void VulkanRenderEngine::Flush()
+{
+    // submissions are waited upon as they are made, but be thorough
+    if (m_device.queue != VK_NULL_HANDLE) vkQueueWaitIdle(m_device.queue);
+}
+
+
+//**********************************************************************************************************************
+//                                              Mediated API Access
+//**********************************************************************************************************************
+HRESULT VulkanRenderEngine::CreateCommandList(ID3D12GraphicsCommandList6** ppCommandList)
+{
+    *ppCommandList = new VulkanCommandList(&m_stats, &m_device);
+    m_stats.commandListsCreated++;
+    return S_OK;
+}
+
+void VulkanRenderEngine::ExecuteCommandList(ID3D12GraphicsCommandList6* pCommandList)
+{
+    PROFILE_FUNCTION();
+    NullRenderEngine::ExecuteCommandList(pCommandList);
+
+    VulkanCommandList* pVulkanCommandList = static_cast<VulkanCommandList*>(pCommandList);
+    if (pVulkanCommandList->IsOpen()) return;
+
+    VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    CheckVkResult(vkBeginCommandBuffer(m_commandBuffer, &beginInfo), "beginning command buffer", true);
+
+    if (m_timestamps)
+    {
+        vkCmdResetQueryPool(m_commandBuffer, m_timestampPool, 0, 2);
+        vkCmdWriteTimestamp(m_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestampPool, 0);
+    }
+
+    // render targets are copied back into their CPU storage once the list's work is done
+    m_writtenTextures.clear();
+    pVulkanCommandList->Execute(m_commandBuffer, m_writtenTextures);
+    for (VulkanResource* pTexture : m_writtenTextures)
+    {
+        pTexture->RecordReadback(m_commandBuffer);
+    }
+
+    if (m_timestamps) vkCmdWriteTimestamp(m_commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestampPool, 1);
+    CheckVkResult(vkEndCommandBuffer(m_commandBuffer), "ending command buffer", true);
+
+    // TODO: overlap recording of the next list with execution of this one
+    VkSubmitInfo submitInfo = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &m_commandBuffer;
+    CheckVkResult(vkQueueSubmit(m_device.queue, 1, &submitInfo, m_fence), "submitting command buffer", true);
+    {
+        PROFILE_SCOPE("vkWaitForFences");
+        CheckVkResult(vkWaitForFences(m_device.device, 1, &m_fence, VK_TRUE, UINT64_MAX), "waiting for submission", true);
+    }
+    vkResetFences(m_device.device, 1, &m_fence);
+    vkResetCommandBuffer(m_commandBuffer, 0);
+    m_submissionCount++;
+
+    if (m_timestamps)
+    {
+        uint64_t timestamps[2] = {};
+        const VkResult result = vkGetQueryPoolResults(m_device.device, m_timestampPool, 0, 2, sizeof(timestamps), timestamps,
+                                                      sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+        if (result == VK_SUCCESS)
+        {
+            const double ticks = static_cast<double>(timestamps[1] - timestamps[0]);
+            const double milliseconds = ticks * m_device.properties.limits.timestampPeriod / 1.0e6;
+            m_gpuMilliseconds += milliseconds;
+            m_frameStats.Add(FrameStatGpuTime, milliseconds);
+        }
+    }
+}
+
+void VulkanRenderEngine::PrintStats() const
+{
+    NullRenderEngine::PrintStats();
+
+    PrintMessage(Info, "Device:                 {}", m_deviceName);
+    PrintMessage(Info, "Submissions:            {}", m_submissionCount);
+    if (m_timestamps)
+    {
+        PrintMessage(Info, "GPU time:               {:.3f}ms ({:.3f}ms per submission)", m_gpuMilliseconds,
+                     m_gpuMilliseconds / max<uint64>(m_submissionCount, 1));
+    }
+}
+
+
+//**********************************************************************************************************************
+//                                              Engine Internal Helpers
+//**********************************************************************************************************************
+NullResource* VulkanRenderEngine::NewResource(const D3D12_HEAP_PROPERTIES& heapProperties, const D3D12_RESOURCE_DESC& desc)
+{
+    VulkanResource* pResource = new VulkanResource(&m_stats, &m_device, heapProperties, desc);
+    if (!pResource->IsValid())
+    {
+        pResource->Release();
+        return nullptr;
+    }
+    return pResource;
+}
+
+NullRootSignature* VulkanRenderEngine::NewRootSignature(const CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC& desc)
+{
+    VulkanRootSignature* pRootSignature = new VulkanRootSignature(&m_stats, &m_device, desc);
+    if (!pRootSignature->IsValid())
+    {
+        pRootSignature->Release();
+        return nullptr;
+    }
+    return pRootSignature;
+}
+
+NullPipelineState* VulkanRenderEngine::NewPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc)
+{
+    // TODO: parse pipeline state streams
+    if (pDesc == nullptr)
+    {
+        PrintMessage(Error, "Vulkan backend: pipeline state streams are not supported");
+        m_stats.validationErrors++;
+        return nullptr;
+    }
+
+    VulkanPipelineState* pPipelineState = new VulkanPipelineState(&m_stats, &m_device, *pDesc);
+    if (!pPipelineState->IsValid())
+    {
+        pPipelineState->Release();
+        return nullptr;
+    }
+    return pPipelineState;
+}
+
+void VulkanRenderEngine::CreateDevice()
+{
+    // instance, with validation in debug builds where the layer is installed
+    VkApplicationInfo applicationInfo = {VK_STRUCTURE_TYPE_APPLICATION_INFO};
+    applicationInfo.pApplicationName    = "Shade";
+    applicationInfo.pEngineName         = "Shade";
+    applicationInfo.apiVersion          = VK_API_VERSION_1_3;
+
+    std::vector<const char*> layers;
+#if defined(_DEBUG)
+    uint layerCount = 0;
+    vkEnumerateInstanceLayerProperties(&layerCount, nullptr);
+    std::vector<VkLayerProperties> availableLayers(layerCount);
+    vkEnumerateInstanceLayerProperties(&layerCount, availableLayers.data());
+    for (const VkLayerProperties& layer : availableLayers)
+    {
+        if (strcmp(layer.layerName, "VK_LAYER_KHRONOS_validation") == 0) layers.push_back("VK_LAYER_KHRONOS_validation");
+    }
+#endif
+
+    VkInstanceCreateInfo instanceInfo = {VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO};
+    instanceInfo.pApplicationInfo       = &applicationInfo;
+    instanceInfo.enabledLayerCount      = static_cast<uint>(layers.size());
+    instanceInfo.ppEnabledLayerNames    = layers.data();
+    CheckVkResult(vkCreateInstance(&instanceInfo, nullptr, &m_device.instance), "creating instance", true);
+
+    uint queueFamily = 0;
+    m_device.physicalDevice = ChoosePhysicalDevice(&queueFamily);
+    if (m_device.physicalDevice == VK_NULL_HANDLE)
+    {
+        PrintMessage(FatalError, "No Vulkan 1.3 device with VK_KHR_push_descriptor and a graphics queue was found");
+        throw exception();
+    }
+    m_device.queueFamily = queueFamily;
+    vkGetPhysicalDeviceProperties(m_device.physicalDevice, &m_device.properties);
+    vkGetPhysicalDeviceMemoryProperties(m_device.physicalDevice, &m_device.memoryProperties);
+    m_deviceName = m_device.properties.deviceName;
+
+    // device, with whichever optional features the pipeline translation can make use of
+    VkPhysicalDeviceFeatures supportedFeatures = {};
+    vkGetPhysicalDeviceFeatures(m_device.physicalDevice, &supportedFeatures);
+
+    VkPhysicalDeviceFeatures2 features = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2};
+    features.features.fillModeNonSolid  = supportedFeatures.fillModeNonSolid;
+    features.features.depthClamp        = supportedFeatures.depthClamp;
+    features.features.depthBiasClamp    = supportedFeatures.depthBiasClamp;
+    features.features.independentBlend  = supportedFeatures.independentBlend;
+    features.features.dualSrcBlend      = supportedFeatures.dualSrcBlend;
+
+    VkPhysicalDeviceVulkan13Features features13 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES};
+    features13.dynamicRendering = VK_TRUE;
+    features.pNext = &features13;
+
+    const float queuePriority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo = {VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO};
+    queueInfo.queueFamilyIndex  = queueFamily;
+    queueInfo.queueCount        = 1;
+    queueInfo.pQueuePriorities  = &queuePriority;
+
+    const char* pExtensions[] = {VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME};
+    VkDeviceCreateInfo deviceInfo = {VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
+    deviceInfo.pNext                    = &features;
+    deviceInfo.queueCreateInfoCount     = 1;
+    deviceInfo.pQueueCreateInfos        = &queueInfo;
+    deviceInfo.enabledExtensionCount    = _countof(pExtensions);
+    deviceInfo.ppEnabledExtensionNames  = pExtensions;
+    CheckVkResult(vkCreateDevice(m_device.physicalDevice, &deviceInfo, nullptr, &m_device.device), "creating device", true);
+    vkGetDeviceQueue(m_device.device, queueFamily, 0, &m_device.queue);
+    m_device.vkCmdPushDescriptorSet = reinterpret_cast<PFN_vkCmdPushDescriptorSetKHR>(
+        vkGetDeviceProcAddr(m_device.device, "vkCmdPushDescriptorSetKHR"));
+
+    // a single command buffer suffices, since every submission is waited upon
+    VkCommandPoolCreateInfo poolInfo = {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    poolInfo.flags              = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    poolInfo.queueFamilyIndex   = queueFamily;
+    CheckVkResult(vkCreateCommandPool(m_device.device, &poolInfo, nullptr, &m_commandPool), "creating command pool", true);
+
+    VkCommandBufferAllocateInfo commandBufferInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+    commandBufferInfo.commandPool           = m_commandPool;
+    commandBufferInfo.level                 = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferInfo.commandBufferCount    = 1;
+    CheckVkResult(vkAllocateCommandBuffers(m_device.device, &commandBufferInfo, &m_commandBuffer), "allocating command buffer", true);
+
+    VkFenceCreateInfo fenceInfo = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+    CheckVkResult(vkCreateFence(m_device.device, &fenceInfo, nullptr, &m_fence), "creating fence", true);
+
+    // GPU timing, where the queue supports it
+    uint queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_device.physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_device.physicalDevice, &queueFamilyCount, queueFamilies.data());
+    if (queueFamilies[queueFamily].timestampValidBits > 0)
+    {
+        VkQueryPoolCreateInfo queryPoolInfo = {VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+        queryPoolInfo.queryType     = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolInfo.queryCount    = 2;
+        m_timestamps = CheckVkResult(vkCreateQueryPool(m_device.device, &queryPoolInfo, nullptr, &m_timestampPool),
+                                     "creating timestamp query pool");
+    }
+
+    PrintMessage(Info, "Vulkan device: {} (API {}.{}.{})", m_deviceName, VK_API_VERSION_MAJOR(m_device.properties.apiVersion),
+                 VK_API_VERSION_MINOR(m_device.properties.apiVersion), VK_API_VERSION_PATCH(m_device.properties.apiVersion));
+}
+
+void VulkanRenderEngine::DestroyDevice()
+{
+    if (m_device.device != VK_NULL_HANDLE)
+    {
+        vkDeviceWaitIdle(m_device.device);
+        if (!m_device.buffers.empty())
+        {
+            PrintMessage(Warning, "Vulkan backend: {} buffers outlived the engine", m_device.buffers.size());
+        }
+
+        vkDestroyQueryPool(m_device.device, m_timestampPool, nullptr);
+        vkDestroyFence(m_device.device, m_fence, nullptr);
+        vkDestroyCommandPool(m_device.device, m_commandPool, nullptr);
+        vkDestroyDevice(m_device.device, nullptr);
+    }
+    if (m_device.instance != VK_NULL_HANDLE) vkDestroyInstance(m_device.instance, nullptr);
+    m_device = {};
+}
+
+// picks the most capable device which has everything the backend relies upon
+VkPhysicalDevice VulkanRenderEngine::ChoosePhysicalDevice(uint* pQueueFamily)
+{
+    uint deviceCount = 0;
+    vkEnumeratePhysicalDevices(m_device.instance, &deviceCount, nullptr);
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(m_device.instance, &deviceCount, devices.data());
+
+    VkPhysicalDevice bestDevice = VK_NULL_HANDLE;
+    int bestScore = -1;
+    for (VkPhysicalDevice device : devices)
+    {
+        VkPhysicalDeviceProperties properties = {};
+        vkGetPhysicalDeviceProperties(device, &properties);
+        if (properties.apiVersion < VK_API_VERSION_1_3) continue;
+
+        uint extensionCount = 0;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+        const bool hasPushDescriptor = any_of(extensions.begin(), extensions.end(), [](const VkExtensionProperties& extension)
+        {
+            return strcmp(extension.extensionName, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME) == 0;
+        });
+        if (!hasPushDescriptor) continue;
+
+        uint queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
+        uint queueFamily = UINT32_MAX;
+        for (uint i = 0; i < queueFamilyCount && queueFamily == UINT32_MAX; ++i)
+        {
+            if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) queueFamily = i;
+        }
+        if (queueFamily == UINT32_MAX) continue;
+
+        const int score = (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)   ? 3 :
+                          (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU) ? 2 :
+                          (properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU)    ? 1 : 0;
+        if (score > bestScore)
+        {
+            bestDevice = device;
+            bestScore = score;
+            *pQueueFamily = queueFamily;
+        }
+    }
+    return bestDevice;
+}
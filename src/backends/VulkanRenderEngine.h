@@ -0,0 +1,55 @@
+#pragma once
+
+#include "backends/NullRenderEngine.h"
+#include "backends/VulkanObjects.h"
+
+
+// Renders scenes through Vulkan 1.3, which brings Shade to Linux GPUs, and to machines without one by way of lavapipe.
+//  Clients still speak D3D12, and the null engine's objects continue to validate everything they are asked to do,
+//  with command lists translated into a Vulkan command buffer as they are executed. Shaders are compiled to SPIR-V.
+//
+// Submissions are synchronous, so render targets are read back into CPU memory as each command list completes, where
+//  they can be inspected exactly as with the software engine. ImGui draw data is generated but not rendered.
+class VulkanRenderEngine : public NullRenderEngine
+{
+public:
+    VulkanRenderEngine(UINT width, UINT height);
+    ~VulkanRenderEngine();
+
+    // primary interfaces for render loop
+    void Init(const WindowHandle window);   // window is ignored
+    void Flush();
+
+    // API access provided to clients
+    HRESULT CreateCommandList(ID3D12GraphicsCommandList6**              ppCommandList);
+    void ExecuteCommandList(ID3D12GraphicsCommandList6*                 pCommandList);
+
+    // getters/setters
+    ShaderFormat GetShaderFormat() const    {return ShaderFormatSpirv;}
+    void PrintStats() const;
+
+protected:
+    // object construction
+    NullResource* NewResource(const D3D12_HEAP_PROPERTIES& heapProperties, const D3D12_RESOURCE_DESC& desc);
+    NullRootSignature* NewRootSignature(const CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC& desc);
+    NullPipelineState* NewPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC* pDesc);
+
+private:
+    // device setup and teardown
+    void CreateDevice();
+    void DestroyDevice();
+    VkPhysicalDevice ChoosePhysicalDevice(uint* pQueueFamily);
+
+    VulkanDevice                    m_device;
+    VkCommandPool                   m_commandPool;
+    VkCommandBuffer                 m_commandBuffer;
+    VkFence                         m_fence;
+    VkQueryPool                     m_timestampPool;
+    bool                            m_timestamps;       // false if the queue cannot write them
+    std::vector<VulkanResource*>    m_writtenTextures;  // scratch for each submission
+
+    // statistics
+    uint64                          m_submissionCount;
+    double                          m_gpuMilliseconds;
+    std::string                     m_deviceName;
+};
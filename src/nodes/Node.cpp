@@ -1,4 +1,5 @@
 #include "Node.h"
+#include "NodeEditor.h"
 
 
 int Node::NodeCounter       = 0;
@@ -12,10 +13,39 @@ int Node::EdgeCounter       = 0;
 Node::Node(NodeClass nodeClass, std::string nodeName) :
     m_id(NodeCounter++),
     m_nodeClass(nodeClass),
-    m_name(nodeName)
+    m_name(nodeName),
+    m_isDirty(true),
+    m_pNodeEditor(nullptr),
+    m_pAttributes(nullptr),
+    m_inputCount(0),
+    m_outputCount(0)
 {
 }
 
+void Node::SetAttributes(AttributeData* pAttributes, uint inputCount, uint outputCount)
+{
+    m_pAttributes = pAttributes;
+    m_inputCount = inputCount;
+    m_outputCount = outputCount;
+}
+
+AttributeData* Node::GetAttribute(const int attr)
+{
+    for (AttributeData& attribute : Attributes())
+    {
+        if (attribute.ID == attr) return &attribute;
+    }
+
+    PrintMessage(Warning, "Node {} is being queried for missing attribute {}", m_id, attr);
+    return nullptr;
+}
+
+void Node::SetDirty()
+{
+    if (!m_isDirty && m_pNodeEditor != nullptr) m_pNodeEditor->OnNodeDirty(this);
+    m_isDirty = true;
+}
+
 void Node::Draw()
 {
     ImNodes::BeginNode(m_id);
@@ -25,10 +55,16 @@ void Node::Draw()
     ImNodes::EndNode();
 }
 
+FrameString Node::Title() const
+{
+    return FrameFormat("{}| {}", m_id, m_name);
+}
+
 void Node::DrawTitleBar()
 {
+    const FrameString title = Title();
     ImNodes::BeginNodeTitleBar();
-    ImGui::Text("%u| %s", m_id, m_name.c_str());
+    ImGui::TextUnformatted(title.data(), title.data() + title.size());
     ImNodes::EndNodeTitleBar();
 }
 
@@ -70,13 +106,14 @@ void NodePipelineStateDesc::Draw()
 //                                                  Numeric Node
 //=====================================================================================================================
 NodeNumeric::NodeNumeric(NodeNumericSubtype subtype, std::string nodeName) :
-    Node(NodeClass::Numeric, nodeName)
+    Node(NodeClass::Numeric, nodeName),
+    m_subtype(subtype)
 {
 }
 
 NodeTypeFlat NodeNumeric::NodeType() const
 {
-    return NodeTypeFlat::NumericConstant;
+    return NodeTypeFlat::Numeric;
 }
 
 void NodeNumeric::Draw()
@@ -2,10 +2,13 @@
 
 #include "Common.h"
 #include <imnodes.h>
+#include "FrameArena.h"
 #include "NodeLink.h"
+#include "NodeStorage.h"
 
 
 class NodeEditor;
+class NodeEvaluator;
 
 // classifications of node types to determine validity of node connections
 enum class NodeClass
@@ -45,6 +48,18 @@ enum class NodePipelineComponentSubtype
     InputLayoutDesc
 };
 
+// values which vary per pixel, read from the pixel shader's inputs
+enum class NodeSystemValue
+{
+    PixelX,         // render target coordinates, in pixels
+    PixelY,
+    Depth,          // view-space distance from the camera
+    ColorR,         // interpolated vertex color
+    ColorG,
+    ColorB,
+    ColorA
+};
+
 // enum cateloging all subtypes
 enum class NodeTypeFlat
 {
@@ -65,7 +80,8 @@ enum class NodeTypeFlat
     PipelineComponentResource,
     PipelineComponentBlendState,
     PipelineComponentRasterizerState,
-    PipelineComponentInputLayoutDesc
+    PipelineComponentInputLayoutDesc,
+    ShaderPixelOutput
 };
 
 
@@ -74,18 +90,24 @@ class Node
 {
 public:
     Node(NodeClass nodeClass = NodeClass::Invalid, std::string nodeName = "Unnamed Node");
+    virtual ~Node() {}
 
     // getters
     const int Id() const                                    {return m_id;}
     const NodeClass Class() const                           {return m_nodeClass;}
-    const std::string Name() const                          {return m_name;}
+    const std::string& Name() const                         {return m_name;}
+    void SetName(std::string name)                          {m_name = std::move(name);}
+    FrameString Title() const;                              // as shown in the title bar, valid for this frame
     virtual NodeTypeFlat NodeType() const                   {return NodeTypeFlat::Null;}
 
-    // attribute management
-    virtual const std::vector<int> Attributes() const       {return {};}
-    virtual const std::vector<int> AttributesIn() const     {return {};}
-    virtual const std::vector<int> AttributesOut() const    {return {};}
-    virtual AttributeData* GetAttribute(const int attr)     {return nullptr;}
+    // attributes, stored in the node with its inputs first, then its outputs
+    Span<AttributeData> Attributes()                        {return {m_pAttributes, m_inputCount + m_outputCount};}
+    Span<AttributeData> AttributesIn()                      {return {m_pAttributes, m_inputCount};}
+    Span<AttributeData> AttributesOut()                     {return {m_pAttributes + m_inputCount, m_outputCount};}
+    Span<const AttributeData> Attributes() const            {return {m_pAttributes, m_inputCount + m_outputCount};}
+    Span<const AttributeData> AttributesIn() const          {return {m_pAttributes, m_inputCount};}
+    Span<const AttributeData> AttributesOut() const         {return {m_pAttributes + m_inputCount, m_outputCount};}
+    AttributeData* GetAttribute(const int attr);            // by ID, or null if the node has no such attribute
 
     // incoming/outgoing link management
     virtual void AddLink(int linkId, Node* pStart, int startAttr, Node* pEnd, int endAttr) {}
@@ -93,14 +115,15 @@ public:
     virtual void LinkOutput(int outAttr, Node* pOther, int otherAttr)   {} // TODO: multiple outputs, or force splitter
     virtual void LinkAttribute(int attr, AttributeData pOtherData)      {};
 
-    // state updates
+    // state updates, where setting a node dirty queues it with its editor's evaluator
     const bool IsDirty() const                              {return m_isDirty;}
-    void SetDirty()                                         {m_isDirty = true;}
+    void SetDirty();
     void ClearDirty()                                       {m_isDirty = false;}
-    virtual void SetChildrenDirty()                         {}
+    void SetNodeEditor(NodeEditor* pNodeEditor)             {m_pNodeEditor = pNodeEditor;}
 
     // primary functions
     virtual void Update()                                   {}
+    virtual void Evaluate(NodeEvaluator& evaluator)         {}  // outputs from inputs, through the evaluator's slots
     virtual void Draw();
 
     // static counters to ensure no collisions in ImNode IDs
@@ -112,13 +135,19 @@ protected:
     // draw helpers
     void DrawTitleBar();
 
-    int          m_id;
-    NodeTypeFlat m_nodeType;
-    NodeClass    m_nodeClass;
-    std::string  m_name;
-    bool         m_isDirty;
+    // for constructors, as nodes are never copied or moved once pooled
+    void SetAttributes(AttributeData* pAttributes, uint inputCount, uint outputCount);
 
-    NodeEditor*  m_pNodeEditor;
+    int            m_id;
+    NodeTypeFlat   m_nodeType;
+    NodeClass      m_nodeClass;
+    std::string    m_name;
+    bool           m_isDirty;
+
+    NodeEditor*    m_pNodeEditor;
+    AttributeData* m_pAttributes;
+    uint           m_inputCount;
+    uint           m_outputCount;
 };
 
 
@@ -144,12 +173,27 @@ class NodeNumeric : public Node // performs math operations
 public:
     NodeNumeric(NodeNumericSubtype subtype, std::string nodeName = "Unnamed Numeric Node");
 
+    NodeNumericSubtype Subtype() const                      {return m_subtype;}
     virtual NodeTypeFlat NodeType() const;
 
     virtual void Draw();
 
 protected:
+    NodeNumericSubtype m_subtype;
+};
+
+
+class NodeShaderOutput : public Node // the color a pixel shader writes
+{
+public:
+    NodeShaderOutput(std::string nodeName = "Pixel Output");
+
+    virtual NodeTypeFlat NodeType() const;
+
+    virtual void Draw();
 
+protected:
+    AttributeData m_attrChannels[4];        // inputs for red, green, blue and alpha
 };
 
 
@@ -163,17 +207,49 @@ public:
 
     virtual NodeTypeFlat NodeType() const;
 
-    virtual const std::vector<int> Attributes() const;
-    virtual const std::vector<int> AttributesIn() const;
-    virtual const std::vector<int> AttributesOut() const;
-
-    virtual AttributeData* GetAttribute(const int attr);
+    float Value() const                                     {return m_value;}
+    void SetValue(float value)                              {m_value = value; SetDirty();}
 
+    virtual void Evaluate(NodeEvaluator& evaluator);
     virtual void Draw();
 
 protected:
     float m_value;
 
-    AttributeData m_attrInput;
+    AttributeData m_attributes[2];          // an unused input, then the value
+};
+
+
+class NodeNumericSystemValue : public NodeNumeric // reads a value varying per pixel
+{
+public:
+    NodeNumericSystemValue(std::string nodeName = "System Value");
+
+    virtual NodeTypeFlat NodeType() const;
+
+    NodeSystemValue Value() const                           {return m_value;}
+    void SetValue(NodeSystemValue value)                    {m_value = value; SetDirty();}
+
+    virtual void Evaluate(NodeEvaluator& evaluator);
+    virtual void Draw();
+
+protected:
+    NodeSystemValue m_value;
+
     AttributeData m_attrOutput;
 };
+
+
+class NodeNumericMath : public NodeNumeric // applies an arithmetic operator to two scalars
+{
+public:
+    NodeNumericMath(NodeNumericSubtype subtype);            // one of Add, Subtract, Multiply or Divide
+
+    virtual NodeTypeFlat NodeType() const;
+
+    virtual void Evaluate(NodeEvaluator& evaluator);
+    virtual void Draw();
+
+protected:
+    AttributeData m_attributes[3];          // the left then the right operand, then the result
+};
@@ -0,0 +1,378 @@
+#include "NodeCompiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Util.h"
+
+using namespace std;
+
+
+namespace
+{
+    bool IsArithmetic(NodeIrOp op)
+    {
+        return op != NodeIrOp::Constant && op != NodeIrOp::SystemValue;
+    }
+
+    uint ComponentCount(AttributeType type)
+    {
+        return static_cast<uint>(type) - static_cast<uint>(AttributeType::Float) + 1;
+    }
+
+    float Evaluate(NodeIrOp op, float a, float b)
+    {
+        switch (op)
+        {
+        case NodeIrOp::Add:         return a + b;
+        case NodeIrOp::Subtract:    return a - b;
+        case NodeIrOp::Multiply:    return a * b;
+        default:                    return a / b;
+        }
+    }
+
+    uint32 Bits(float value)
+    {
+        uint32 bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    // Shortest text which parses back to the same float. HLSL has no literal for infinities or NaN, and a negative
+    //  literal is parenthesized so that it can follow an operator.
+    string Literal(float value)
+    {
+        if (!isfinite(value)) return fmt::format("asfloat(0x{:08x}u)", Bits(value));
+
+        string text = fmt::format("{}", value);
+        if (text.find_first_of(".e") == string::npos) text += ".0";
+        return signbit(value) ? "(" + text + ")" : text;
+    }
+
+    const char* TypeName(AttributeType type)
+    {
+        const char* names[] = {"float", "float2", "float3", "float4"};
+        return names[ComponentCount(type) - 1];
+    }
+
+    const char* SystemValueExpression(NodeSystemValue value)
+    {
+        switch (value)
+        {
+        case NodeSystemValue::PixelX:   return "position.x";
+        case NodeSystemValue::PixelY:   return "position.y";
+        case NodeSystemValue::Depth:    return "position.w";
+        case NodeSystemValue::ColorR:   return "color.r";
+        case NodeSystemValue::ColorG:   return "color.g";
+        case NodeSystemValue::ColorB:   return "color.b";
+        default:                        return "color.a";
+        }
+    }
+
+    const char* OperatorSymbol(NodeIrOp op)
+    {
+        switch (op)
+        {
+        case NodeIrOp::Add:         return "+";
+        case NodeIrOp::Subtract:    return "-";
+        case NodeIrOp::Multiply:    return "*";
+        default:                    return "/";
+        }
+    }
+}
+
+
+//=====================================================================================================================
+//                                                      Lowering
+//=====================================================================================================================
+bool NodeCompiler::Compile(Node* pOutput, NodeIr& ir)
+{
+    ir.instructions.clear();
+    ir.outputs.clear();
+    ir.nodeCount = 0;
+    m_pIr = &ir;
+    m_valueNumbers.clear();
+    m_nodeValues.Clear();
+    m_error.clear();
+
+    if (pOutput == nullptr)
+    {
+        const NodeSystemValue colors[] = {NodeSystemValue::ColorR, NodeSystemValue::ColorG, NodeSystemValue::ColorB,
+                                          NodeSystemValue::ColorA};
+        for (NodeSystemValue color : colors)
+        {
+            NodeIrInstruction instruction = {NodeIrOp::SystemValue, AttributeType::Float};
+            instruction.systemValue = color;
+            ir.outputs.push_back(Add(instruction));
+        }
+        return true;
+    }
+
+    // unlinked channels are black and opaque
+    const float unlinkedChannels[] = {0.0f, 0.0f, 0.0f, 1.0f};
+    const Span<AttributeData> channels = pOutput->AttributesIn();
+    for (uint i = 0; i < channels.size(); ++i)
+    {
+        uint value = 0;
+        if (!Lower(channels[i], unlinkedChannels[i], value)) return false;
+        ir.outputs.push_back(value);
+    }
+    ir.nodeCount = static_cast<uint>(m_nodeValues.Size()) + 1;
+
+    EliminateDeadCode(ir);
+    return true;
+}
+
+// Iterative, with a frame per arithmetic node whose operands are being lowered, so that however long a chain of nodes
+//  the call stack stays flat. Operands are lowered first to last, in the order recursion would lower them.
+bool NodeCompiler::Lower(const AttributeData& rootInput, float rootUnlinkedValue, uint& rootValue)
+{
+    m_frames.clear();
+    const AttributeData* pInput = &rootInput;
+    float unlinkedValue = rootUnlinkedValue;
+    for (;;)
+    {
+        uint value = 0;
+        bool pending = false;
+        if (!LowerNode(*pInput, unlinkedValue, value, pending)) return false;
+
+        // a value completes the operand awaiting it, and each node whose operands are then all lowered in turn
+        while (!pending)
+        {
+            if (m_frames.empty())
+            {
+                rootValue = value;
+                return true;
+            }
+            LowerFrame& frame = m_frames.back();
+            frame.instruction.operands[frame.operand++] = value;
+            if (frame.operand < 2) break;
+
+            value = Add(frame.instruction);
+            m_nodeValues[frame.pNode->Id()] = value;
+            m_frames.pop_back();
+        }
+
+        const LowerFrame& frame = m_frames.back();
+        pInput = &frame.pNode->AttributesIn()[frame.operand];
+        unlinkedValue = frame.identity;
+    }
+}
+
+bool NodeCompiler::LowerNode(const AttributeData& input, float unlinkedValue, uint& value, bool& pending)
+{
+    pending = false;
+    if (input.pLink == nullptr)
+    {
+        value = AddConstant(AttributeType::Float, unlinkedValue);
+        return true;
+    }
+    if (input.pLink->DataType != AttributeType::Float)
+    {
+        m_error = fmt::format("Node #{} ({}) has a {} input, where only floats can be compiled", input.pNode->Id(),
+                              input.pNode->Name(), magic_enum::enum_name(input.pLink->DataType));
+        return false;
+    }
+
+    Node* pNode = input.pLink->InputNode;
+    if (const uint* pValue = m_nodeValues.Find(pNode->Id()))
+    {
+        if (*pValue == Lowering)
+        {
+            m_error = fmt::format("Node #{} ({}) is part of a cycle", pNode->Id(), pNode->Name());
+            return false;
+        }
+        value = *pValue;
+        return true;
+    }
+
+    NodeIrInstruction instruction = {NodeIrOp::Constant, AttributeType::Float};
+    switch (pNode->NodeType())
+    {
+    case NodeTypeFlat::NumericConstant:
+    {
+        value = AddConstant(AttributeType::Float, static_cast<NodeNumericConstant*>(pNode)->Value());
+        break;
+    }
+    case NodeTypeFlat::NumericSystemValue:
+    {
+        instruction.op = NodeIrOp::SystemValue;
+        instruction.systemValue = static_cast<NodeNumericSystemValue*>(pNode)->Value();
+        value = Add(instruction);
+        break;
+    }
+    case NodeTypeFlat::NumericAdd:
+    case NodeTypeFlat::NumericSubtract:
+    case NodeTypeFlat::NumericMultiply:
+    case NodeTypeFlat::NumericDivide:
+    {
+        const NodeTypeFlat type = pNode->NodeType();
+        const NodeIrOp ops[] = {NodeIrOp::Add, NodeIrOp::Subtract, NodeIrOp::Multiply, NodeIrOp::Divide};
+        instruction.op = ops[static_cast<uint>(type) - static_cast<uint>(NodeTypeFlat::NumericAdd)];
+
+        // an unlinked operand is the operator's identity, and the operands are lowered before the node is added
+        const float identity = (instruction.op == NodeIrOp::Add || instruction.op == NodeIrOp::Subtract) ? 0.0f : 1.0f;
+        m_nodeValues[pNode->Id()] = Lowering;
+        m_frames.push_back({pNode, instruction, identity, 0});
+        pending = true;
+        return true;
+    }
+    default:
+    {
+        m_error = fmt::format("Node #{} ({}) cannot be compiled into a shader", pNode->Id(),
+                              magic_enum::enum_name(pNode->NodeType()));
+        return false;
+    }
+    }
+
+    m_nodeValues[pNode->Id()] = value;
+    return true;
+}
+
+
+//=====================================================================================================================
+//                                                  Folding and Numbering
+//=====================================================================================================================
+uint NodeCompiler::Add(NodeIrInstruction instruction)
+{
+    vector<NodeIrInstruction>& instructions = m_pIr->instructions;
+    if (IsArithmetic(instruction.op))
+    {
+        uint& a = instruction.operands[0];
+        uint& b = instruction.operands[1];
+        const bool commutative = (instruction.op == NodeIrOp::Add || instruction.op == NodeIrOp::Multiply);
+        if (commutative && a > b) std::swap(a, b);
+
+        if (instructions[a].op == NodeIrOp::Constant && instructions[b].op == NodeIrOp::Constant)
+        {
+            NodeIrInstruction folded = {NodeIrOp::Constant, instruction.type};
+            for (uint i = 0; i < ComponentCount(instruction.type); ++i)
+            {
+                folded.constant[i] = Evaluate(instruction.op, instructions[a].constant[i], instructions[b].constant[i]);
+            }
+            instruction = folded;
+        }
+        else switch (instruction.op)
+        {
+        case NodeIrOp::Add:
+            if (IsConstant(a, 0.0f)) return b;
+            if (IsConstant(b, 0.0f)) return a;
+            break;
+        case NodeIrOp::Subtract:
+            if (IsConstant(b, 0.0f)) return a;
+            if (a == b) return AddConstant(instruction.type, 0.0f);
+            break;
+        case NodeIrOp::Multiply:
+            if (IsConstant(a, 1.0f)) return b;
+            if (IsConstant(b, 1.0f)) return a;
+            if (IsConstant(a, 0.0f) || IsConstant(b, 0.0f)) return AddConstant(instruction.type, 0.0f);
+            break;
+        default:
+            if (IsConstant(b, 1.0f)) return a;
+            break;
+        }
+    }
+
+    const float* c = instruction.constant;
+    const ValueKey key = {instruction.op, instruction.type, instruction.operands[0], instruction.operands[1],
+                          instruction.systemValue, Bits(c[0]), Bits(c[1]), Bits(c[2]), Bits(c[3])};
+    auto [found, added] = m_valueNumbers.try_emplace(key, static_cast<uint>(instructions.size()));
+    if (added) instructions.push_back(instruction);
+    return found->second;
+}
+
+uint NodeCompiler::AddConstant(AttributeType type, float value)
+{
+    NodeIrInstruction instruction = {NodeIrOp::Constant, type};
+    for (uint i = 0; i < ComponentCount(type); ++i) instruction.constant[i] = value;
+    return Add(instruction);
+}
+
+bool NodeCompiler::IsConstant(uint value, float constant) const
+{
+    const NodeIrInstruction& instruction = m_pIr->instructions[value];
+    if (instruction.op != NodeIrOp::Constant) return false;
+    for (uint i = 0; i < ComponentCount(instruction.type); ++i)
+    {
+        if (instruction.constant[i] != constant) return false;
+    }
+    return true;
+}
+
+void NodeCompiler::EliminateDeadCode(NodeIr& ir)
+{
+    // operands come first, so a backwards pass marks everything live
+    vector<bool> live(ir.instructions.size(), false);
+    for (uint output : ir.outputs) live[output] = true;
+    for (size_t i = ir.instructions.size(); i-- > 0;)
+    {
+        const NodeIrInstruction& instruction = ir.instructions[i];
+        if (!live[i] || !IsArithmetic(instruction.op)) continue;
+        live[instruction.operands[0]] = true;
+        live[instruction.operands[1]] = true;
+    }
+
+    vector<uint> renumbered(ir.instructions.size(), 0);
+    uint count = 0;
+    for (uint i = 0; i < ir.instructions.size(); ++i)
+    {
+        if (!live[i]) continue;
+        NodeIrInstruction instruction = ir.instructions[i];
+        if (IsArithmetic(instruction.op))
+        {
+            instruction.operands[0] = renumbered[instruction.operands[0]];
+            instruction.operands[1] = renumbered[instruction.operands[1]];
+        }
+        renumbered[i] = count;
+        ir.instructions[count++] = instruction;
+    }
+    ir.instructions.resize(count);
+    for (uint& output : ir.outputs) output = renumbered[output];
+}
+
+
+//=====================================================================================================================
+//                                                      Emission
+//=====================================================================================================================
+string NodeCompiler::EmitHlsl(const NodeIr& ir)
+{
+    string code = fmt::format("// Generated from the node graph, {} nodes in {} instructions, and overwritten when it "
+                              "changes.\n\nfloat4 NodeGraphColor(float4 position, float4 color)\n{{\n",
+                              ir.nodeCount, ir.instructions.size());
+
+    vector<string> expressions(ir.instructions.size());
+    uint temporaries = 0;
+    for (uint i = 0; i < ir.instructions.size(); ++i)
+    {
+        const NodeIrInstruction& instruction = ir.instructions[i];
+        switch (instruction.op)
+        {
+        case NodeIrOp::Constant:
+        {
+            const uint components = ComponentCount(instruction.type);
+            expressions[i] = Literal(instruction.constant[0]);
+            for (uint c = 1; c < components; ++c) expressions[i] += ", " + Literal(instruction.constant[c]);
+            if (components > 1) expressions[i] = fmt::format("{}({})", TypeName(instruction.type), expressions[i]);
+            break;
+        }
+        case NodeIrOp::SystemValue:
+        {
+            expressions[i] = SystemValueExpression(instruction.systemValue);
+            break;
+        }
+        default:
+        {
+            expressions[i] = fmt::format("v{}", temporaries++);
+            fmt::format_to(back_inserter(code), "    const {} {} = {} {} {};\n", TypeName(instruction.type),
+                           expressions[i], expressions[instruction.operands[0]], OperatorSymbol(instruction.op),
+                           expressions[instruction.operands[1]]);
+            break;
+        }
+        }
+    }
+
+    fmt::format_to(back_inserter(code), "    return float4({}, {}, {}, {});\n}}\n", expressions[ir.outputs[0]],
+                   expressions[ir.outputs[1]], expressions[ir.outputs[2]], expressions[ir.outputs[3]]);
+    return code;
+}
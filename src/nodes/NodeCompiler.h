@@ -0,0 +1,85 @@
+// NodeCompiler - Compiles the node graph feeding a pixel output into HLSL, through a typed SSA IR.
+//
+// Lowering walks back from the output's inputs, so nodes which do not reach it cost nothing. Each instruction is value
+//  numbered as it is added: one identical to an earlier instruction is that instruction, commutative operands are
+//  ordered first, and one whose operands are all constants is folded into a constant. Identities such as x + 0, x * 1,
+//  x * 0 and x - x are simplified along the way. DXC compiles with fast math by default, so folding them is what DXC
+//  itself would do. What folding leaves unused is then removed by dead code elimination.
+//
+// The HLSL declares a temporary per arithmetic instruction left, with constants written as literals and system values
+//  as reads of the pixel shader's inputs, so that it compiles to the same DXIL as a hand-written equivalent.
+#pragma once
+
+#include <climits>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "FlatHashMap.h"
+#include "Node.h"
+
+
+enum class NodeIrOp
+{
+    Constant,
+    SystemValue,
+    Add,
+    Subtract,
+    Multiply,
+    Divide
+};
+
+struct NodeIrInstruction
+{
+    NodeIrOp            op;
+    AttributeType       type;           // one of Float to Float4
+    uint                operands[2];    // earlier instructions, of arithmetic
+    float               constant[4];    // per component, of constants
+    NodeSystemValue     systemValue;
+};
+
+struct NodeIr
+{
+    std::vector<NodeIrInstruction>  instructions;   // each after its operands
+    std::vector<uint>               outputs;        // red, green, blue and alpha
+    uint                            nodeCount;      // reached from the output
+};
+
+
+class NodeCompiler
+{
+public:
+    // Lowers and optimizes the graph feeding pOutput, failing for cycles and for nodes which cannot be compiled. With
+    //  no output, the program passes the vertex color through, as shaders.hlsl does.
+    bool Compile(Node* pOutput, NodeIr& ir);
+    const std::string& GetError() const                     {return m_error;}
+
+    static void EliminateDeadCode(NodeIr& ir);
+    static std::string EmitHlsl(const NodeIr& ir);          // the NodeGraphColor() function shaders.hlsl includes
+
+private:
+    typedef std::tuple<NodeIrOp, AttributeType, uint, uint, NodeSystemValue, uint, uint, uint, uint> ValueKey;
+    static constexpr uint Lowering = UINT_MAX;              // a node's value until lowered, so reaching it is a cycle
+
+    // an arithmetic node being lowered, whose operands before the current one have their values
+    struct LowerFrame
+    {
+        Node*               pNode;
+        NodeIrInstruction   instruction;
+        float               identity;       // the value of an unlinked operand
+        uint                operand;        // lowered next
+    };
+
+    bool Lower(const AttributeData& input, float unlinkedValue, uint& value);
+    bool LowerNode(const AttributeData& input, float unlinkedValue, uint& value, bool& pending);    // pending a frame
+    uint Add(NodeIrInstruction instruction);                // folded and numbered
+    uint AddConstant(AttributeType type, float value);
+    bool IsConstant(uint value, float constant) const;
+
+    NodeIr*                     m_pIr;
+    std::map<ValueKey, uint>    m_valueNumbers;
+    FlatHashMap<int, uint>      m_nodeValues;               // by node ID, or Lowering while being lowered
+    std::vector<LowerFrame>     m_frames;                   // innermost last
+    std::string                 m_error;
+};
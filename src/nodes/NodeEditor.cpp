@@ -1,107 +1,607 @@
 #include "NodeEditor.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#include "JobSystem.h"
+#include "MemoryTracker.h"
+#include "Profiler.h"
 #include "Util.h"
 
 
+namespace
+{
+    constexpr uint64 UnsavedGeneration = ~uint64(0);       // which no edit generation reaches
+
+    void WriteJsonString(std::ofstream& file, std::string_view text)
+    {
+        file << '"';
+        for (char c : text)
+        {
+            if      (c == '"' || c == '\\')   file << '\\' << c;
+            else if (UINT8(c) < 0x20)           file << ' ';
+            else                                file << c;
+        }
+        file << '"';
+    }
+}
+
+
 NodeEditor::NodeEditor() :
     m_linkCounter(0),
-    m_shouldReevaluate(true)
+    m_shouldReevaluate(true),
+    m_lastAutosave(std::chrono::steady_clock::now()),
+    m_editGeneration(0),
+    m_savedGeneration(0),
+    m_autosaveGeneration(0)
 {
 }
 NodeEditor::~NodeEditor()
 {
+    FinishAutosave();
 }
 
 
 int NodeEditor::AddNode(NodeTypeFlat nodeType, ImVec2 position)
 {
-    int nodeId = -1;
-    Node* pNode = nullptr;
+    MEMORY_SCOPE(MemoryTagNodeEditor);
+    Node* pNode = CreateNode(nodeType);
+    if (pNode == nullptr) return -1;
+
+    m_evaluator.AddNode(pNode);
+    LOG_INFO("Added new node #{}: {}", pNode->Id(), magic_enum::enum_name(nodeType));
+
+    // if called, must have an accompanying BeginNode/EndNode pair for ID
+    ImNodes::SetNodeScreenSpacePos(pNode->Id(), position);
+    return pNode->Id();
+}
+
+Node* NodeEditor::CreateNode(NodeTypeFlat nodeType)
+{
+    PoolHandle handle = {UINT32_MAX, 0};                    // resolving to no node
 
     switch (nodeType)
     {
     case NodeTypeFlat::Null:
     {
-        pNode = new Node();
+        handle = m_nodes.Create<Node>();
         break;
     }
     // Numeric
     case NodeTypeFlat::NumericConstant:
     {
-        pNode = new NodeNumericConstant();
+        handle = m_nodes.Create<NodeNumericConstant>();
+        break;
+    }
+    case NodeTypeFlat::NumericSystemValue:
+    {
+        handle = m_nodes.Create<NodeNumericSystemValue>();
+        break;
+    }
+    case NodeTypeFlat::NumericAdd:
+    case NodeTypeFlat::NumericSubtract:
+    case NodeTypeFlat::NumericMultiply:
+    case NodeTypeFlat::NumericDivide:
+    {
+        const NodeNumericSubtype subtypes[] = {NodeNumericSubtype::Add, NodeNumericSubtype::Subtract,
+                                               NodeNumericSubtype::Multiply, NodeNumericSubtype::Divide};
+        const int subtype = static_cast<int>(nodeType) - static_cast<int>(NodeTypeFlat::NumericAdd);
+        handle = m_nodes.Create<NodeNumericMath>(subtypes[subtype]);
+        break;
+    }
+    // Shader
+    case NodeTypeFlat::ShaderPixelOutput:
+    {
+        handle = m_nodes.Create<NodeShaderOutput>();
         break;
     }
     default:
     {
-        PrintMessage(Error, "Unhandled Node type in AddNode: {}", magic_enum::enum_name(nodeType));
+        LOG_ERROR("Unhandled Node type in AddNode: {}", magic_enum::enum_name(nodeType));
         break;
     }
     };
 
-    if (pNode != nullptr)
+    Node* pNode = m_nodes.Get(handle);
+    if (pNode == nullptr) return nullptr;
+
+    pNode->SetNodeEditor(this);
+    m_nodeHandles[pNode->Id()] = handle;
+    m_editGeneration++;
+    for (AttributeData& attribute : pNode->Attributes())
     {
-        m_nodes.push_back(pNode);
-        nodeId = pNode->Id();
-        PrintMessage(Info, "Added new node #{}: {}", nodeId, magic_enum::enum_name(nodeType));
-        for (const int attr : pNode->Attributes())
-        {
-            m_mapAttributeToNode[attr] = pNode;
-        }
+        m_attributes[attribute.ID] = &attribute;
+    }
+    return pNode;
+}
+
+int NodeEditor::AddLink(int startAttr, int endAttr)
+{
+    MEMORY_SCOPE(MemoryTagNodeEditor);
+    LOG_DEBUG("Attempting node link {} -> {}", startAttr, endAttr);
+    AttributeData* const* ppStart = m_attributes.Find(startAttr);
+    AttributeData* const* ppEnd = m_attributes.Find(endAttr);
+    if (ppStart == nullptr || ppEnd == nullptr)
+    {
+        LOG_ERROR("Attempting to link missing attributes");
+        return -1;
+    }
+    AttributeData* pStart = *ppStart;
+    AttributeData* pEnd = *ppEnd;
+    Node* pStartNode = pStart->pNode;
+    Node* pEndNode = pEnd->pNode;
+    LOG_DEBUG("\t{}", pStartNode->Name());
+    LOG_DEBUG("\t{}", pEndNode->Name());
+
+    if (pStart->DataType != pEnd->DataType)
+    {
+        LOG_ERROR("Attempting to link unrelated attributes");
+        return -1;
+    }
+
+    if (!m_evaluator.AddLink(pStartNode, pEndNode))
+    {
+        LOG_ERROR("Linking node #{} into #{} would form a cycle", pStartNode->Id(), pEndNode->Id());
+        return -1;
+    }
 
-        // if called, must have an accompanying BeginNode/EndNode pair for ID
-        ImNodes::SetNodeScreenSpacePos(nodeId, position);
+    // an input takes a single value, so linking it again replaces its link
+    if (NodeLink* pOldLink = pEnd->pLink)
+    {
+        const int oldLinkId = pOldLink->LinkID;
+        AttributeData* pOldStart = pOldLink->InputNode->GetAttribute(pOldLink->InputAttr);
+        if (pOldStart->pLink == pOldLink) pOldStart->pLink = nullptr;
+        m_evaluator.RemoveLink(pOldLink->InputNode, pEndNode);
+        m_links.Destroy(*m_linkHandles.Find(oldLinkId));
+        m_linkHandles.Erase(oldLinkId);
     }
 
-    return nodeId;
+    const int linkId = static_cast<int>(m_linkCounter++);
+    const NodeLink link = {linkId, pStart->DataType, pStartNode, pEndNode, startAttr, endAttr};
+    const PoolHandle handle = m_links.Create(link);
+    m_linkHandles[linkId] = handle;
+
+    NodeLink* pLink = m_links.Get(handle);
+    pStart->pLink = pLink;
+    pEnd->pLink = pLink;
+    m_editGeneration++;
+    return linkId;
+}
+
+Node* NodeEditor::GetNode(int nodeId) const
+{
+    const PoolHandle* pHandle = m_nodeHandles.Find(nodeId);
+    return (pHandle != nullptr) ? m_nodes.Get(*pHandle) : nullptr;
+}
+
+void NodeEditor::OnNodeDirty(Node* pNode)
+{
+    m_evaluator.MarkDirty(pNode);
+    m_editGeneration++;
 }
 
 void NodeEditor::Update()
 {
+    MEMORY_SCOPE(MemoryTagNodeEditor);
     int startAttr = -1;
     int endAttr = -1;
 
     // check for new links
     if (ImNodes::IsLinkCreated(&startAttr, &endAttr))
     {
-        PrintMessage(Info, "Attempting node link {} -> {}", startAttr, endAttr);
-        Node* pStartNode = m_mapAttributeToNode[startAttr];
-        Node* pEndNode   = m_mapAttributeToNode[endAttr];
-        PrintMessage(Info, "\t{}", pStartNode->Name());
-        PrintMessage(Info, "\t{}", pEndNode->Name());
+        AddLink(startAttr, endAttr);
+    }
+
+    // TODO: check for deleted nodes
+    // TODO: check for updated links
+    // TODO: check for deleted links
+    // TODO: handlers for context menu popups
+
+    // Only edits whose changes reach a pixel output recompile the graph, and the shader only recompiles if the HLSL
+    //  generated differs. Evaluation visits only what changed, so a frame without edits costs nothing, and edits
+    //  reaching enough nodes spread them across the job system.
+    m_evaluator.EvaluateParallel(JobSystem::Get());
+    for (const Node* pNode : m_evaluator.GetEvaluated())
+    {
+        m_shouldReevaluate |= (pNode->NodeType() == NodeTypeFlat::ShaderPixelOutput);
+    }
+    if (m_shouldReevaluate)
+    {
+        CompileGraph();
+        m_shouldReevaluate = false;
+    }
 
+    // Only the records are built on this thread, as node positions live in imnodes. Hashing every chunk of them and
+    //  writing those which changed grows with the graph, so runs as a job, and not at all while nothing has changed.
+    if (m_autosave.valid() && m_autosave.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+    {
+        FinishAutosave();
+    }
+    const auto now = std::chrono::steady_clock::now();
+    const std::chrono::duration<float> sinceAutosave = now - m_lastAutosave;
+    if (!m_graphFilename.empty() && m_nodes.Size() != 0 && !m_autosave.valid() &&
+        m_editGeneration != m_savedGeneration && sinceAutosave.count() >= AutosaveInterval)
+    {
+        StartAutosave();
+        m_lastAutosave = now;
+    }
+}
 
-        AttributeData* pStart = pStartNode->GetAttribute(startAttr);
-        AttributeData* pEnd = pEndNode->GetAttribute(endAttr);
+bool NodeEditor::CompileGraph()
+{
+    PROFILE_FUNCTION();
+    MEMORY_SCOPE(MemoryTagNodeEditor);
+    const auto start = std::chrono::steady_clock::now();
+
+    auto isOutput = [](const Node* pNode) {return pNode->NodeType() == NodeTypeFlat::ShaderPixelOutput;};
+    const Span<Node* const> nodes = m_nodes.Objects();
+    auto output = std::find_if(nodes.begin(), nodes.end(), isOutput);
+    if (!m_compiler.Compile((output != nodes.end()) ? *output : nullptr, m_ir))
+    {
+        m_compileStatus = m_compiler.GetError();
+        LOG_WARNING("Node graph not compiled: {}", m_compileStatus);
+        return false;
+    }
+    const std::string code = NodeCompiler::EmitHlsl(m_ir);
+    m_program.Build(m_ir);
+
+    const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+    m_compileStatus = fmt::format("{} nodes, {} instructions", m_ir.nodeCount, m_ir.instructions.size());
+    LOG_DEBUG("Node graph compiled to {} instructions in {:.3f}ms", m_ir.instructions.size(), duration.count());
+
+    if (code == m_generatedCode) return true;
+    m_generatedCode = code;
+    if (m_outputFilename.empty()) return true;
+
+    std::ofstream file(m_outputFilename, std::ios::binary);
+    file << m_generatedCode;
+    if (!file.good())
+    {
+        LOG_ERROR("Failed to write the node graph's HLSL to {}", m_outputFilename);
+        return false;
+    }
+    return true;
+}
+
+void NodeEditor::SetOutputFile(const std::string& filename)
+{
+    // what the file already holds isn't rewritten, so that shaders including it keep their cached bytecode
+    m_outputFilename = filename;
+    std::ifstream file(filename, std::ios::binary);
+    std::stringstream contents;
+    contents << file.rdbuf();
+    m_generatedCode = contents.str();
+    CompileGraph();
+}
 
-        if (pStart->DataType == pEnd->DataType)
+bool NodeEditor::SaveGraph(const std::filesystem::path& path)
+{
+    PROFILE_FUNCTION();
+    MEMORY_SCOPE(MemoryTagNodeEditor);
+    BuildGraphRecords();
+    const uint64 generation = m_editGeneration;
+    const bool saved = m_graphFile.Save(path, {m_fileStrings.data(), m_fileStrings.size()},
+                                        {m_fileNodes.data(), m_fileNodes.size()},
+                                        {m_fileLinks.data(), m_fileLinks.size()});
+    if (saved && path == m_graphFilename) m_savedGeneration = generation;
+    return saved;
+}
+
+void NodeEditor::StartAutosave()
+{
+    PROFILE_FUNCTION();
+    MEMORY_SCOPE(MemoryTagNodeEditor);
+    BuildGraphRecords();
+    m_autosaveGeneration = m_editGeneration;
+
+    // The records and file are left alone by this thread until the save is finished. The job owns its promise, which
+    //  it is done with by the time it is destroyed along with the job's captures.
+    std::promise<bool> result;
+    m_autosave = result.get_future();
+    auto save = [this, result = std::move(result)]() mutable
+    {
+        PROFILE_SCOPE("Autosave Node Graph");
+        MEMORY_SCOPE(MemoryTagNodeEditor);
+        try
+        {
+            result.set_value(m_graphFile.Save(m_graphFilename, {m_fileStrings.data(), m_fileStrings.size()},
+                                              {m_fileNodes.data(), m_fileNodes.size()},
+                                              {m_fileLinks.data(), m_fileLinks.size()}));
+        }
+        catch (...)
         {
-            NodeLink* pLink = new NodeLink;
-            pLink->LinkID = m_linkCounter++;
-            pLink->DataType = pStart->DataType;
-            pLink->InputAttr = startAttr;
-            pLink->InputNode = pStartNode;
-            pLink->OutputAttr = endAttr;
-            pLink->OutputNode = pEndNode;
+            result.set_exception(std::current_exception());
+        }
+    };
+
+    JobSystem& jobSystem = JobSystem::Get();
+    if (jobSystem.GetThreadCount() == 1)
+    {
+        save();
+        return;
+    }
+    jobSystem.Submit(jobSystem.CreateJob(std::move(save)));
+}
 
-            pStart->pLink = pLink;
-            pEnd->pLink = pLink;
+void NodeEditor::FinishAutosave()
+{
+    if (!m_autosave.valid()) return;
+
+    // a failed save is retried at the next interval, having logged why
+    bool saved = false;
+    try
+    {
+        saved = m_autosave.get();
+    }
+    catch (...)
+    {
+        LOG_WARNING("Node graph could not be saved to {}", PathToUtf8(m_graphFilename));
+    }
+    if (saved) m_savedGeneration = m_autosaveGeneration;
+}
 
-            m_nodeLinks.push_back(pLink);
+bool NodeEditor::LoadGraph(const std::filesystem::path& path)
+{
+    PROFILE_FUNCTION();
+    MEMORY_SCOPE(MemoryTagNodeEditor);
+    const auto start = std::chrono::steady_clock::now();
+    FinishAutosave();
+    const bool wasEmpty = (m_nodes.Size() == 0);
+    if (!m_graphFile.Open(path)) return false;
+
+    // Every string a node refers to is checked before any node is created, so that a damaged file adds nothing. A type
+    //  named by a string but unknown to this build, such as one saved by a newer build, loads as a null node.
+    const uint nodeCount = m_graphFile.GetNodeCount();
+    const uint linkCount = m_graphFile.GetLinkCount();
+    const uint stringCount = m_graphFile.GetStringCount();
+    std::vector<NodeTypeFlat> types(nodeCount);
+    bool valid = true;
+    for (uint i = 0; valid && i < nodeCount; ++i)
+    {
+        const NodeGraphNode& record = m_graphFile.GetNode(i);
+        valid = record.type < stringCount && record.name < stringCount;
+        const std::string_view typeName = valid ? m_graphFile.GetString(record.type) : std::string_view();
+        types[i] = magic_enum::enum_cast<NodeTypeFlat>(typeName).value_or(NodeTypeFlat::Null);
+        if (valid && types[i] == NodeTypeFlat::NumericSystemValue)
+        {
+            valid = record.parameter < stringCount &&
+                    magic_enum::enum_cast<NodeSystemValue>(m_graphFile.GetString(record.parameter)).has_value();
         }
-        else
+    }
+
+    // Nodes join the evaluator in topological order, so that every link runs forwards in its order and adding it
+    //  reorders nothing. Links are counted per source to list each source's targets contiguously.
+    std::vector<uint> targetsBegin(nodeCount + 1, 0);
+    std::vector<uint> targets(linkCount);
+    std::vector<uint> producerCounts(nodeCount, 0);
+    for (uint i = 0; valid && i < linkCount; ++i)
+    {
+        const NodeGraphLink& link = m_graphFile.GetLink(i);
+        valid = link.source < nodeCount && link.target < nodeCount;
+        if (valid) targetsBegin[link.source + 1]++;
+    }
+    for (uint i = 0; valid && i < nodeCount; ++i) targetsBegin[i + 1] += targetsBegin[i];
+    std::vector<uint> targetsEnd(targetsBegin.begin(), targetsBegin.end() - 1);
+    for (uint i = 0; valid && i < linkCount; ++i)
+    {
+        const NodeGraphLink& link = m_graphFile.GetLink(i);
+        targets[targetsEnd[link.source]++] = link.target;
+        producerCounts[link.target]++;
+    }
+    std::vector<uint> order;
+    order.reserve(nodeCount);
+    for (uint i = 0; valid && i < nodeCount; ++i)
+    {
+        if (producerCounts[i] == 0) order.push_back(i);
+    }
+    for (size_t i = 0; valid && i < order.size(); ++i)
+    {
+        for (uint link = targetsBegin[order[i]]; link < targetsBegin[order[i] + 1]; ++link)
         {
-            PrintMessage(Error, "Attempting to link unrelated attributes");
+            if (--producerCounts[targets[link]] == 0) order.push_back(targets[link]);
         }
     }
+    if (!valid || order.size() != nodeCount)
+    {
+        LOG_WARNING("Node graph file {} has {}, and was not loaded", PathToUtf8(path),
+                    valid ? "links forming a cycle" : "references to missing strings or nodes");
+        m_graphFile.Close();
+        return false;
+    }
 
-    // TODO: check for deleted nodes
-    // TODO: check for updated links
-    // TODO: check for deleted links
-    // TODO: handlers for context menu popups
+    m_nodeHandles.Reserve(m_nodeHandles.Size() + nodeCount);
+    m_linkHandles.Reserve(m_linkHandles.Size() + linkCount);
+    std::vector<Node*> nodes(nodeCount);
+    for (uint i = 0; i < nodeCount; ++i)
+    {
+        // types this build does not know or cannot create load as null nodes, without the attributes their links need
+        const NodeGraphNode& record = m_graphFile.GetNode(i);
+        nodes[i] = CreateNode(types[i]);
+        if (nodes[i] == nullptr) nodes[i] = CreateNode(NodeTypeFlat::Null);
+        nodes[i]->SetName(std::string(m_graphFile.GetString(record.name)));
+        ImNodes::SetNodeGridSpacePos(nodes[i]->Id(), ImVec2(record.position[0], record.position[1]));
+    }
+    for (uint i : order)
+    {
+        m_evaluator.AddNode(nodes[i]);
+    }
+    for (uint i = 0; i < nodeCount; ++i)
+    {
+        const NodeGraphNode& record = m_graphFile.GetNode(i);
+        if (nodes[i]->NodeType() == NodeTypeFlat::NumericConstant)
+        {
+            float value = 0.0f;
+            memcpy(&value, &record.parameter, sizeof(value));
+            static_cast<NodeNumericConstant*>(nodes[i])->SetValue(value);
+        }
+        else if (nodes[i]->NodeType() == NodeTypeFlat::NumericSystemValue)
+        {
+            const std::string_view name = m_graphFile.GetString(record.parameter);
+            static_cast<NodeNumericSystemValue*>(nodes[i])->SetValue(*magic_enum::enum_cast<NodeSystemValue>(name));
+        }
+    }
+
+    uint skippedLinks = 0;
+    for (uint i = 0; i < linkCount; ++i)
+    {
+        const NodeGraphLink& link = m_graphFile.GetLink(i);
+        const Span<AttributeData> outputs = nodes[link.source]->AttributesOut();
+        const Span<AttributeData> inputs = nodes[link.target]->AttributesIn();
+        const bool linked = link.output < outputs.size() && link.input < inputs.size() &&
+                            AddLink(outputs[link.output].ID, inputs[link.input].ID) >= 0;
+        if (!linked) skippedLinks++;
+    }
+    m_graphFile.Close();
+    m_shouldReevaluate = true;
+
+    const std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+    LOG_INFO("Loaded {} nodes and {} links from {} in {:.3f}ms", nodeCount, linkCount - skippedLinks,
+             PathToUtf8(path), duration.count());
+    if (skippedLinks != 0) LOG_WARNING("{} links between missing attributes were not loaded", skippedLinks);
+
+    // creating and linking the nodes counted as edits, but an editor holding only its graph file needs no saving
+    if (wasEmpty && path == m_graphFilename) m_savedGeneration = m_editGeneration;
+    return true;
+}
+
+bool NodeEditor::ExportGraphJson(const std::filesystem::path& path)
+{
+    PROFILE_FUNCTION();
+    MEMORY_SCOPE(MemoryTagNodeEditor);
+    BuildGraphRecords();
+
+    // a node or link per line, in the order they're saved, so that diffs show each edit on its own line
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << "{\n\"version\": " << NodeGraphFile::Version << ",\n\"nodes\": [";
+    for (size_t i = 0; i < m_fileNodes.size(); ++i)
+    {
+        const NodeGraphNode& record = m_fileNodes[i];
+        file << (i == 0 ? "\n" : ",\n") << "{\"type\": ";
+        WriteJsonString(file, m_fileStrings[record.type]);
+        file << ", \"name\": ";
+        WriteJsonString(file, m_fileStrings[record.name]);
+        file << fmt::format(", \"position\": [{}, {}]", record.position[0], record.position[1]);
+
+        const Node* pNode = m_nodes.Objects()[i];
+        if (pNode->NodeType() == NodeTypeFlat::NumericConstant)
+        {
+            file << fmt::format(", \"value\": {}", static_cast<const NodeNumericConstant*>(pNode)->Value());
+        }
+        else if (pNode->NodeType() == NodeTypeFlat::NumericSystemValue)
+        {
+            file << ", \"value\": ";
+            WriteJsonString(file, m_fileStrings[record.parameter]);
+        }
+        file << "}";
+    }
+    file << "\n],\n\"links\": [";
+    for (size_t i = 0; i < m_fileLinks.size(); ++i)
+    {
+        const NodeGraphLink& link = m_fileLinks[i];
+        file << (i == 0 ? "\n" : ",\n");
+        file << fmt::format("{{\"source\": {}, \"output\": {}, \"target\": {}, \"input\": {}}}",
+                            link.source, link.output, link.target, link.input);
+    }
+    file << "\n]\n}\n";
+    file.close();
+    if (file.fail())
+    {
+        LOG_ERROR("Failed to write the node graph's JSON to {}", PathToUtf8(path));
+        return false;
+    }
+    return true;
+}
+
+void NodeEditor::SetGraphFile(const std::filesystem::path& path)
+{
+    // a file which exists but can't be loaded is left alone rather than overwritten by the next save
+    FinishAutosave();
+    m_graphFilename = path;
+    m_savedGeneration = UnsavedGeneration;
+    std::error_code error;
+    if (std::filesystem::exists(path, error) && !LoadGraph(path))
+    {
+        LOG_WARNING("Node graph file {} will not be saved to", PathToUtf8(path));
+        m_graphFilename.clear();
+        return;
+    }
+    m_lastAutosave = std::chrono::steady_clock::now();
+}
+
+void NodeEditor::BuildGraphRecords()
+{
+    FinishAutosave();
+    m_fileStrings.clear();
+    m_fileStringIndices.clear();
+    m_fileNodes.clear();
+    m_fileLinks.clear();
+    m_fileNodeIndices.Clear();
+
+    const auto intern = [this](std::string_view text)
+    {
+        const auto [entry, inserted] = m_fileStringIndices.try_emplace(text, uint32(m_fileStrings.size()));
+        if (inserted) m_fileStrings.push_back(text);
+        return entry->second;
+    };
+
+    // nodes by their position in the pool, which is creation order until one is destroyed
+    const Span<Node* const> nodes = m_nodes.Objects();
+    m_fileNodes.reserve(nodes.size());
+    m_fileNodeIndices.Reserve(nodes.size());
+    for (uint32 i = 0; i < nodes.size(); ++i)
+    {
+        m_fileNodeIndices[nodes[i]->Id()] = i;
+    }
+    for (uint32 i = 0; i < nodes.size(); ++i)
+    {
+        const Node* pNode = nodes[i];
+        const ImVec2 position = ImNodes::GetNodeGridSpacePos(pNode->Id());
+        NodeGraphNode record = {intern(magic_enum::enum_name(pNode->NodeType())), intern(pNode->Name()),
+                                {position.x, position.y}, 0};
+        if (pNode->NodeType() == NodeTypeFlat::NumericConstant)
+        {
+            const float value = static_cast<const NodeNumericConstant*>(pNode)->Value();
+            memcpy(&record.parameter, &value, sizeof(value));
+        }
+        else if (pNode->NodeType() == NodeTypeFlat::NumericSystemValue)
+        {
+            const NodeSystemValue value = static_cast<const NodeNumericSystemValue*>(pNode)->Value();
+            record.parameter = intern(magic_enum::enum_name(value));
+        }
+        m_fileNodes.push_back(record);
+
+        // each link once, from the input it feeds, which holds only that link
+        const Span<const AttributeData> inputs = pNode->AttributesIn();
+        for (uint32 input = 0; input < inputs.size(); ++input)
+        {
+            const NodeLink* pLink = inputs[input].pLink;
+            if (pLink == nullptr) continue;
+            const Span<const AttributeData> outputs = static_cast<const Node*>(pLink->InputNode)->AttributesOut();
+            uint32 output = 0;
+            while (outputs[output].ID != pLink->InputAttr) output++;
+            m_fileLinks.push_back({*m_fileNodeIndices.Find(pLink->InputNode->Id()), output, i, input});
+        }
+    }
+
+    // the strings are the nodes' own until copied, which the buffer is only reallocated for when it outgrows itself
+    size_t stringBytes = 0;
+    for (std::string_view text : m_fileStrings) stringBytes += text.size();
+    m_fileStringData.clear();
+    m_fileStringData.reserve(stringBytes);
+    for (std::string_view& text : m_fileStrings)
+    {
+        const size_t offset = m_fileStringData.size();
+        m_fileStringData.append(text);
+        text = std::string_view(m_fileStringData.data() + offset, text.size());
+    }
 }
 
 void NodeEditor::Draw()
 {
+    MEMORY_SCOPE(MemoryTagNodeEditor);
     ImGui::Begin("Node Editor", nullptr, ImGuiWindowFlags_MenuBar);
 
     //menu bar and controls
@@ -117,20 +617,37 @@ void NodeEditor::Draw()
             // TODO: select on clicking list entry
             ImGuiWindowFlags listWindowFlags = ImGuiWindowFlags_HorizontalScrollbar;
             ImGui::Begin("Contents", nullptr, listWindowFlags);
-            for (const Node* pNode : m_nodes)
+
+            // entries are two lines each, and only those scrolled into view are submitted
+            const float entryHeight = ImGui::GetTextLineHeight() * 2.0f + ImGui::GetStyle().ItemSpacing.y;
+            const Span<Node* const> nodes = m_nodes.Objects();
+            ImGuiListClipper nodeClipper;
+            nodeClipper.Begin(static_cast<int>(nodes.size()), entryHeight);
+            while (nodeClipper.Step())
             {
-                ImGui::Text("%d %s\n    %s",
-                            pNode->Id(), pNode->Name().c_str(),
-                            magic_enum::enum_name(pNode->NodeType()).data());
+                for (int i = nodeClipper.DisplayStart; i < nodeClipper.DisplayEnd; ++i)
+                {
+                    const Node* pNode = nodes[i];
+                    ImGui::Text("%d %s\n    %s",
+                                pNode->Id(), pNode->Name().c_str(),
+                                magic_enum::enum_name(pNode->NodeType()).data());
+                }
             }
 
             ImGui::Separator();
 
-            for (const NodeLink* pLink : m_nodeLinks)
+            const Span<NodeLink* const> links = m_links.Objects();
+            ImGuiListClipper linkClipper;
+            linkClipper.Begin(static_cast<int>(links.size()), entryHeight);
+            while (linkClipper.Step())
             {
-                ImGui::Text("%d %d->%d (%d->%d)\n    %s",
-                            pLink->LinkID, pLink->InputNode->Id(), pLink->OutputNode->Id(), pLink->InputAttr, pLink->OutputAttr,
-                            magic_enum::enum_name(pLink->DataType).data());
+                for (int i = linkClipper.DisplayStart; i < linkClipper.DisplayEnd; ++i)
+                {
+                    const NodeLink* pLink = links[i];
+                    ImGui::Text("%d %d->%d (%d->%d)\n    %s",
+                                pLink->LinkID, pLink->InputNode->Id(), pLink->OutputNode->Id(), pLink->InputAttr,
+                                pLink->OutputAttr, magic_enum::enum_name(pLink->DataType).data());
+                }
             }
 
             ImGui::End();
@@ -155,14 +672,33 @@ void NodeEditor::Draw()
 
                     if (ImGui::MenuItem("null"))
                     {
-                        PrintMessage("Attempting to add Null node\n");
+                        LOG_DEBUG("Attempting to add Null node");
                         AddNode(NodeTypeFlat::Null, nodePosition);
                     }
                     else if (ImGui::MenuItem("constant"))
                     {
-                        PrintMessage("Attempting to add constant node\n");
+                        LOG_DEBUG("Attempting to add constant node");
                         AddNode(NodeTypeFlat::NumericConstant, nodePosition);
                     }
+                    else if (ImGui::MenuItem("system value"))
+                    {
+                        AddNode(NodeTypeFlat::NumericSystemValue, nodePosition);
+                    }
+                    else if (ImGui::BeginMenu("math"))
+                    {
+                        const NodeTypeFlat mathTypes[] = {NodeTypeFlat::NumericAdd, NodeTypeFlat::NumericSubtract,
+                                                          NodeTypeFlat::NumericMultiply, NodeTypeFlat::NumericDivide};
+                        for (NodeTypeFlat type : mathTypes)
+                        {
+                            const char* pName = magic_enum::enum_name(type).data() + strlen("Numeric");
+                            if (ImGui::MenuItem(pName)) AddNode(type, nodePosition);
+                        }
+                        ImGui::EndMenu();
+                    }
+                    else if (ImGui::MenuItem("pixel output"))
+                    {
+                        AddNode(NodeTypeFlat::ShaderPixelOutput, nodePosition);
+                    }
 
                     ImGui::EndPopup();
                 }
@@ -176,17 +712,42 @@ void NodeEditor::Draw()
         DrawNodes();
 
         // draw links
-        for (const NodeLink* pLink : m_nodeLinks)
+        for (const NodeLink* pLink : m_links.Objects())
         {
             ImNodes::Link(pLink->LinkID, pLink->InputAttr, pLink->OutputAttr);
         }
 
         ImNodes::EndNodeEditor();
+        DetectMovedNodes();
     }
 
     ImGui::End();
 }
 
+// Nodes are only moved by imnodes, as they are dragged, and only the selected ones. Their positions are compared with
+//  those of the last frame, so that other drags, such as of links, selection boxes or widgets, are not taken for edits.
+void NodeEditor::DetectMovedNodes()
+{
+    const int selectedCount = ImNodes::NumSelectedNodes();
+    m_selectedNodes.resize(selectedCount);
+    if (selectedCount > 0) ImNodes::GetSelectedNodes(m_selectedNodes.data());
+
+    bool moved = false;
+    for (int nodeId : m_selectedNodes)
+    {
+        const ImVec2 position = ImNodes::GetNodeGridSpacePos(nodeId);
+        const ImVec2* pLast = m_selectedPositions.Find(nodeId);
+        moved |= (pLast != nullptr && (pLast->x != position.x || pLast->y != position.y));
+    }
+    if (moved) m_editGeneration++;
+
+    m_selectedPositions.Clear();
+    for (int nodeId : m_selectedNodes)
+    {
+        m_selectedPositions[nodeId] = ImNodes::GetNodeGridSpacePos(nodeId);
+    }
+}
+
 void NodeEditor::DrawControls()
 {
     // TODO: useful menu options
@@ -204,6 +765,32 @@ void NodeEditor::DrawControls()
             ImGui::Text("some more text");
             ImGui::EndMenu();
         }
+        if (ImGui::BeginMenu("graph file"))
+        {
+            const std::string filename = PathToUtf8(m_graphFilename);
+            ImGui::TextUnformatted(m_graphFilename.empty() ? "not saved to a file" : filename.c_str());
+            ImGui::Text("%u chunks, %u written by the last save", m_graphFile.GetChunkCount(),
+                        m_graphFile.GetChunksWritten());
+            ImGui::Separator();
+            if (ImGui::MenuItem("save", nullptr, false, !m_graphFilename.empty())) SaveGraph(m_graphFilename);
+            if (ImGui::MenuItem("export JSON", nullptr, false, !m_graphFilename.empty()))
+            {
+                std::filesystem::path jsonPath = m_graphFilename;
+                ExportGraphJson(jsonPath.replace_extension(".json"));
+            }
+            ImGui::EndMenu();
+        }
+        if (ImGui::BeginMenu("generated HLSL"))
+        {
+            ImGui::TextUnformatted(m_outputFilename.empty() ? "not written to a file" : m_outputFilename.c_str());
+            ImGui::Separator();
+            ImGui::TextUnformatted(m_generatedCode.c_str());
+            ImGui::Separator();
+            ImGui::Text("CPU bytecode: %u instructions on %u registers", m_program.GetInstructionCount(),
+                        m_program.GetRegisterCount());
+            ImGui::EndMenu();
+        }
+        ImGui::TextDisabled("%s", m_compileStatus.c_str());
         ImGui::EndMenuBar();
     }
 }
@@ -211,7 +798,7 @@ void NodeEditor::DrawControls()
 void NodeEditor::DrawNodes()
 {
     // draw all nodes
-    for (auto pNode : m_nodes)
+    for (Node* pNode : m_nodes.Objects())
     {
         pNode->Draw();
     }
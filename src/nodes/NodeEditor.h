@@ -2,32 +2,98 @@
 
 #include <imnodes.h>
 #include "Common.h"
+#include "FlatHashMap.h"
 #include "Node.h"
-#include <map>
+#include "NodeCompiler.h"
+#include "NodeEvaluator.h"
+#include "NodeGraphFile.h"
+#include "NodeProgram.h"
+#include "NodeStorage.h"
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 
 class NodeEditor
 {
 public:
+    static constexpr float AutosaveInterval = 5.0f;        // seconds between saves to the graph file, if edited
+
     NodeEditor();
     ~NodeEditor();
 
     int AddNode(NodeTypeFlat nodeType, ImVec2 position);
+    int AddLink(int startAttr, int endAttr);                // from an output to an input, replacing the input's link
+    Node* GetNode(int nodeId) const;                        // or null if there is no such node
+    size_t GetNodeCount() const                             {return m_nodes.Size();}
+    void OnNodeDirty(Node* pNode);                          // from Node::SetDirty(), queuing it for evaluation
+    NodeEvaluator& GetEvaluator()                           {return m_evaluator;}
     void Update();
     void Draw();
 
+    // Compiles the graph feeding the first pixel output into HLSL, writing it to the output file if it changed so that
+    //  shaders including it are recompiled by the watcher.
+    bool CompileGraph();
+    void SetOutputFile(const std::string& filename);        // compiling into it now
+    const std::string& GetGeneratedCode() const             {return m_generatedCode;}
+    const NodeProgram& GetProgram() const                   {return m_program;}     // the same graph, for the CPU
+
+    // Saves the graph to a binary file, writing only what changed since the file was last saved or loaded, and loads
+    //  one into the editor alongside the nodes already there. JSON is written for reading and diffing, not loaded.
+    bool SaveGraph(const std::filesystem::path& path);
+    bool LoadGraph(const std::filesystem::path& path);
+    bool ExportGraphJson(const std::filesystem::path& path);
+    void SetGraphFile(const std::filesystem::path& path);   // loading it if it exists, then saving to it periodically
+
 private:
 
+    Node* CreateNode(NodeTypeFlat nodeType);                // or null for an unhandled type, not yet evaluated
+    void BuildGraphRecords();                               // of every node and link, for the graph file
+    void StartAutosave();                                   // saving the records on the job system
+    void FinishAutosave();                                  // waiting for the autosave in flight, if any
+    void DetectMovedNodes();
     void DrawControls();
     void DrawNodes();
 
     uint m_linkCounter;
 
-    std::vector<Node*> m_nodes;
-    std::vector<NodeLink*> m_nodeLinks;
+    NodePool<Node> m_nodes;
+    NodePool<NodeLink> m_links;
+
+    FlatHashMap<int, PoolHandle> m_nodeHandles;             // by node ID
+    FlatHashMap<int, PoolHandle> m_linkHandles;             // by link ID
+    FlatHashMap<int, AttributeData*> m_attributes;          // by attribute ID, for resolving links as they're made
+
+    bool m_shouldReevaluate;        // compiling the graph, as set by evaluating a pixel output
+
+    NodeEvaluator m_evaluator;
+    NodeCompiler m_compiler;
+    NodeIr m_ir;
+    NodeProgram m_program;
+    std::string m_outputFilename;
+    std::string m_generatedCode;    // as last written, or as found in the output file
+    std::string m_compileStatus;
 
-    std::map<int, Node*> m_mapAttributeToNode;    // used for updating nodes when links change
-    std::map<int, AttributeData> m_mapAttributeToAttributeData;
+    NodeGraphFile m_graphFile;              // written by the autosave in flight, if any
+    std::filesystem::path m_graphFilename;  // saved to periodically, or empty
+    std::chrono::steady_clock::time_point m_lastAutosave;
+    uint64 m_editGeneration;                // counts edits to the graph, and frames in which nodes moved
+    uint64 m_savedGeneration;               // as of the last load from or save to the graph file
+    uint64 m_autosaveGeneration;            // as of the autosave in flight
+    std::future<bool> m_autosave;           // valid while an autosave is in flight or not yet finished
+    std::vector<int> m_selectedNodes;       // by ID, as of this frame
+    FlatHashMap<int, ImVec2> m_selectedPositions;   // of the selected nodes, as of the last frame, to find them moved
 
-    bool m_shouldReevaluate;
+    // Records of the graph as last saved, kept to not allocate per save, and read by the autosave in flight. Strings
+    //  are copied into one buffer, so that a save need not read the nodes.
+    std::vector<std::string_view> m_fileStrings;
+    std::string m_fileStringData;
+    std::unordered_map<std::string_view, uint32> m_fileStringIndices;
+    std::vector<NodeGraphNode> m_fileNodes;
+    std::vector<NodeGraphLink> m_fileLinks;
+    FlatHashMap<int, uint32> m_fileNodeIndices;             // by node ID
 };
@@ -0,0 +1,288 @@
+#include "NodeEvaluator.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "Util.h"
+
+using namespace std;
+
+
+NodeEvaluator::NodeEvaluator() :
+    m_visit(0)
+{
+}
+
+
+//=====================================================================================================================
+//                                                  Topological Order
+//=====================================================================================================================
+void NodeEvaluator::AddNode(Node* pNode)
+{
+    // a node without links can go anywhere in the order, so goes last
+    const uint state = static_cast<uint>(m_states.size());
+    m_states.push_back({pNode, static_cast<uint>(m_order.size()), 0, 0, UINT_MAX, false, false, false, {}, {}});
+    m_order.push_back(state);
+    m_stateOfNode[pNode->Id()] = state;
+
+    for (AttributeData& output : pNode->AttributesOut())
+    {
+        output.ValueSlot = static_cast<int>(m_values.size());
+        m_values.push_back({output.DataType, false, {}});
+        m_slotStates.push_back(state);
+    }
+    Queue(state);
+}
+
+bool NodeEvaluator::AddLink(Node* pSource, Node* pTarget)
+{
+    const uint source = StateOf(pSource);
+    const uint target = StateOf(pTarget);
+    if (source == target) return false;
+
+    // A link running backwards in the order moves what the target reaches before the source after what reaches the
+    //  source, keeping the positions those nodes held between them. Reaching the source from the target is a cycle.
+    const uint lower = m_states[target].order;
+    const uint upper = m_states[source].order;
+    if (lower < upper)
+    {
+        vector<uint> forwards;
+        vector<uint> backwards;
+        m_visit++;
+        Search(target, upper, true, forwards);
+        if (m_states[source].visit == m_visit) return false;
+        Search(source, lower, false, backwards);
+
+        const auto earlier = [this](uint a, uint b) {return m_states[a].order < m_states[b].order;};
+        sort(forwards.begin(), forwards.end(), earlier);
+        sort(backwards.begin(), backwards.end(), earlier);
+        vector<uint> positions;
+        for (uint state : backwards) positions.push_back(m_states[state].order);
+        for (uint state : forwards) positions.push_back(m_states[state].order);
+        sort(positions.begin(), positions.end());
+
+        uint position = 0;
+        for (const vector<uint>* pStates : {&backwards, &forwards})
+        {
+            for (uint state : *pStates)
+            {
+                m_states[state].order = positions[position];
+                m_order[positions[position++]] = state;
+            }
+        }
+    }
+
+    m_states[source].consumers.push_back(target);
+    m_states[target].producers.push_back(source);
+    Queue(target);
+    return true;
+}
+
+void NodeEvaluator::RemoveLink(Node* pSource, Node* pTarget)
+{
+    const uint source = StateOf(pSource);
+    const uint target = StateOf(pTarget);
+    vector<uint>& consumers = m_states[source].consumers;
+    vector<uint>& producers = m_states[target].producers;
+    consumers.erase(find(consumers.begin(), consumers.end(), target));
+    producers.erase(find(producers.begin(), producers.end(), source));
+    Queue(target);
+}
+
+uint NodeEvaluator::GetOrder(const Node* pNode) const
+{
+    return m_states[StateOf(pNode)].order;
+}
+
+uint NodeEvaluator::StateOf(const Node* pNode) const
+{
+    return *m_stateOfNode.Find(pNode->Id());
+}
+
+// depth first, through consumers up to the bound in the order or through producers down to it
+void NodeEvaluator::Search(uint start, uint bound, bool forwards, vector<uint>& reached)
+{
+    m_stack.assign(1, start);
+    m_states[start].visit = m_visit;
+    while (!m_stack.empty())
+    {
+        const uint state = m_stack.back();
+        m_stack.pop_back();
+        reached.push_back(state);
+
+        for (uint next : forwards ? m_states[state].consumers : m_states[state].producers)
+        {
+            NodeState& nextState = m_states[next];
+            const bool inBounds = forwards ? (nextState.order <= bound) : (nextState.order >= bound);
+            if (nextState.visit == m_visit || !inBounds) continue;
+            nextState.visit = m_visit;
+            m_stack.push_back(next);
+        }
+    }
+}
+
+
+//=====================================================================================================================
+//                                                      Evaluation
+//=====================================================================================================================
+void NodeEvaluator::MarkDirty(Node* pNode)
+{
+    Queue(StateOf(pNode));
+}
+
+void NodeEvaluator::Queue(uint state)
+{
+    if (m_states[state].queued) return;
+    m_states[state].queued = true;
+    m_queue.push_back(state);
+    push_heap(m_queue.begin(), m_queue.end(), [this](uint a, uint b) {return m_states[a].order > m_states[b].order;});
+}
+
+uint NodeEvaluator::Evaluate()
+{
+    PROFILE_FUNCTION();
+    m_evaluated.clear();
+
+    // links added since the last pass may have reordered what is queued
+    const auto later = [this](uint a, uint b) {return m_states[a].order > m_states[b].order;};
+    make_heap(m_queue.begin(), m_queue.end(), later);
+    while (!m_queue.empty())
+    {
+        pop_heap(m_queue.begin(), m_queue.end(), later);
+        NodeState& state = m_states[m_queue.back()];
+        m_queue.pop_back();
+        state.queued = false;
+
+        state.changed = false;
+        state.pNode->Evaluate(*this);
+        state.pNode->ClearDirty();
+        m_evaluated.push_back(state.pNode);
+        if (!state.changed) continue;
+
+        for (uint consumer : state.consumers) Queue(consumer);
+    }
+    return static_cast<uint>(m_evaluated.size());
+}
+
+uint NodeEvaluator::EvaluateParallel(JobSystem& jobSystem)
+{
+    PROFILE_FUNCTION();
+
+    // the cone of everything queued, in order, which a serial pass would evaluate at most
+    vector<uint>& cone = m_cone;
+    cone.clear();
+    m_visit++;
+    for (uint state : m_queue)
+    {
+        if (m_states[state].visit != m_visit) Search(state, UINT_MAX, true, cone);
+    }
+    if (cone.size() < ParallelThreshold || jobSystem.GetThreadCount() == 1) return Evaluate();
+    sort(cone.begin(), cone.end(), [this](uint a, uint b) {return m_states[a].order < m_states[b].order;});
+
+    // a node joins its producer's task if each is the other's only link within the cone
+    const auto inCone = [this](uint state) {return m_states[state].visit == m_visit;};
+    const auto onlyInCone = [&inCone](const vector<uint>& states, uint& only)
+    {
+        uint count = 0;
+        for (uint state : states)
+        {
+            if (!inCone(state) || (count > 0 && state == only)) continue;
+            only = state;
+            count++;
+        }
+        return count == 1;
+    };
+    m_tasks.clear();
+    for (uint state : cone)
+    {
+        NodeState& node = m_states[state];
+        node.nextInTask = UINT_MAX;
+        node.changed = false;
+        node.evaluated = false;
+
+        uint producer = 0;
+        uint consumer = 0;
+        if (onlyInCone(node.producers, producer) && onlyInCone(m_states[producer].consumers, consumer))
+        {
+            Task& task = m_tasks[m_states[producer].task];
+            m_states[task.last].nextInTask = state;
+            task.last = state;
+            task.cost++;
+            node.task = m_states[producer].task;
+            continue;
+        }
+
+        uint level = 0;
+        for (uint p : node.producers)
+        {
+            if (inCone(p)) level = max(level, m_tasks[m_states[p].task].level + 1);
+        }
+        node.task = static_cast<uint>(m_tasks.size());
+        m_tasks.push_back({state, state, 1, level});
+    }
+
+    // each level waits for the one before, with its largest tasks started first
+    const auto scheduled = [](const Task& a, const Task& b)
+    {
+        return (a.level != b.level) ? (a.level < b.level) : (a.cost > b.cost);
+    };
+    sort(m_tasks.begin(), m_tasks.end(), scheduled);
+    for (size_t begin = 0, end = 0; begin < m_tasks.size(); begin = end)
+    {
+        while (end < m_tasks.size() && m_tasks[end].level == m_tasks[begin].level) end++;
+        const Task* pTasks = &m_tasks[begin];
+        jobSystem.ParallelFor(static_cast<uint>(end - begin), [this, pTasks](uint i) {RunTask(pTasks[i]);}, 1);
+    }
+
+    m_evaluated.clear();
+    for (uint state : cone)
+    {
+        NodeState& node = m_states[state];
+        node.queued = false;
+        if (node.evaluated) m_evaluated.push_back(node.pNode);
+    }
+    m_queue.clear();
+    return static_cast<uint>(m_evaluated.size());
+}
+
+// a task's nodes in order, skipping those queued by nothing but producers whose outputs didn't change
+void NodeEvaluator::RunTask(const Task& task)
+{
+    for (uint state = task.first; state != UINT_MAX; state = m_states[state].nextInTask)
+    {
+        NodeState& node = m_states[state];
+        bool dirty = node.queued;
+        for (uint producer : node.producers)
+        {
+            dirty |= (m_states[producer].visit == m_visit && m_states[producer].changed);
+        }
+        if (!dirty) continue;
+
+        node.pNode->Evaluate(*this);
+        node.pNode->ClearDirty();
+        node.evaluated = true;
+    }
+}
+
+NodeValue NodeEvaluator::GetInput(const AttributeData& input, float unlinkedValue) const
+{
+    if (input.pLink == nullptr)
+    {
+        return {input.DataType, false, {unlinkedValue, unlinkedValue, unlinkedValue, unlinkedValue}};
+    }
+
+    const AttributeData* pOutput = input.pLink->InputNode->GetAttribute(input.pLink->InputAttr);
+    return m_values[pOutput->ValueSlot];
+}
+
+void NodeEvaluator::SetOutput(const AttributeData& output, const NodeValue& value)
+{
+    NodeValue& cached = m_values[output.ValueSlot];
+    const bool changed = value.varying || cached.varying || value.type != cached.type ||
+                         memcmp(value.components, cached.components, sizeof(value.components)) != 0;
+    cached = value;
+    if (changed) m_states[m_slotStates[output.ValueSlot]].changed = true;
+}
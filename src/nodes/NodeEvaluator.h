@@ -0,0 +1,91 @@
+// NodeEvaluator - Incremental evaluation of the node graph on the CPU, caching each output's value in a typed slot.
+//
+// Nodes are kept in a topological order, maintained as links are added with Pearce and Kelly's algorithm: a link which
+//  already runs forwards in the order changes nothing, and one which runs backwards only reorders the nodes between its
+//  ends which it connects, while finding any cycle it would form. Removing a link never invalidates the order.
+//
+// Editing a node or its links queues it, and evaluation pops queued nodes earliest in the order first, so each node is
+//  evaluated at most once and only after everything it reads. A node queues what its outputs feed only if their values
+//  changed, which limits a pass to the part of the edit's downstream cone that actually changes. Varying values have
+//  no single value to compare, so always count as changed.
+//
+// Large passes run in parallel. The downstream cone is partitioned into tasks by connectivity, with chains of nodes
+//  which each feed only the next fused into one task, so a task starts at a graph's sources or where branches merge.
+//  Tasks are levelled by their longest path from the cone's start, and the tasks of a level run concurrently, largest
+//  first. Levels only wait on each other where branches merge, so independent chains of nodes run as a single level.
+//  Nodes are still skipped when nothing they read changed, so the result matches a serial pass exactly.
+#pragma once
+
+#include <vector>
+
+#include "FlatHashMap.h"
+#include "Node.h"
+
+
+class JobSystem;
+
+class NodeEvaluator
+{
+public:
+    static constexpr uint ParallelThreshold = 1024;        // nodes in a cone below which passes stay serial
+
+    NodeEvaluator();
+
+    void AddNode(Node* pNode);                              // with slots for its outputs, and queued
+    bool AddLink(Node* pSource, Node* pTarget);             // false, changing nothing, if it would form a cycle
+    void RemoveLink(Node* pSource, Node* pTarget);
+    void MarkDirty(Node* pNode);
+
+    // evaluates queued nodes, returning how many, in parallel if their downstream cone is large enough
+    uint Evaluate();
+    uint EvaluateParallel(JobSystem& jobSystem);
+    const std::vector<Node*>& GetEvaluated() const          {return m_evaluated;}   // by the last Evaluate()
+
+    // for nodes' Evaluate(), reading inputs as their linked outputs' values or as unlinkedValue, and writing outputs
+    NodeValue GetInput(const AttributeData& input, float unlinkedValue) const;
+    void SetOutput(const AttributeData& output, const NodeValue& value);
+    const NodeValue& GetValue(const AttributeData& output) const    {return m_values[output.ValueSlot];}
+
+    uint GetOrder(const Node* pNode) const;                 // position in the topological order
+    uint GetNodeCount() const                               {return static_cast<uint>(m_order.size());}
+
+private:
+    struct NodeState
+    {
+        Node*               pNode;
+        uint                order;          // position in m_order
+        uint                visit;          // the last search which reached it
+        uint                task;           // of the last parallel pass
+        uint                nextInTask;     // or UINT_MAX for the last
+        bool                queued;
+        bool                changed;        // an output, by the last evaluation
+        bool                evaluated;      // by the last parallel pass
+        std::vector<uint>   consumers;      // of its outputs, once per link
+        std::vector<uint>   producers;      // of its inputs, once per link
+    };
+
+    struct Task
+    {
+        uint                first;          // state
+        uint                last;
+        uint                cost;           // estimated as the number of nodes
+        uint                level;          // after every task it reads from
+    };
+
+    uint StateOf(const Node* pNode) const;
+    void Search(uint start, uint bound, bool forwards, std::vector<uint>& reached);
+    void Queue(uint state);
+    void RunTask(const Task& task);
+
+    std::vector<NodeState>          m_states;
+    FlatHashMap<int, uint>          m_stateOfNode;          // by node ID
+    std::vector<uint>               m_order;                // states, topologically
+    std::vector<uint>               m_queue;                // heap of queued states, earliest in the order first
+    std::vector<NodeValue>          m_values;               // by slot
+    std::vector<uint>               m_slotStates;           // the state owning each slot
+    std::vector<Node*>              m_evaluated;
+    std::vector<Task>               m_tasks;                // of the last parallel pass
+    std::vector<uint>               m_cone;                 // of the last parallel pass
+    std::vector<uint>               m_stack;                // of the search, kept to not allocate per search
+    uint                            m_visit;
+};
@@ -0,0 +1,302 @@
+#include "NodeGraphFile.h"
+
+#include <cstring>
+#include <fstream>
+
+#include "Hash.h"
+#include "Profiler.h"
+#include "Util.h"
+
+using namespace std;
+
+
+namespace
+{
+    constexpr uint32 Magic = 0x474E4853;    // "SHNG"
+
+    uint64 AlignChunk(uint64 size)
+    {
+        return (size + 7) & ~uint64(7);
+    }
+
+    void WritePadding(ostream& file, uint64 size)
+    {
+        const char padding[8] = {};
+        file.write(padding, AlignChunk(size) - size);
+    }
+}
+
+
+NodeGraphFile::NodeGraphFile() :
+    m_fileSize(0),
+    m_chunksWritten(0),
+    m_pStringEnds(nullptr),
+    m_pStringCharacters(nullptr),
+    m_stringCount(0),
+    m_nodeCount(0),
+    m_linkCount(0)
+{
+}
+
+
+//=====================================================================================================================
+//                                                      Saving
+//=====================================================================================================================
+bool NodeGraphFile::Save(const filesystem::path& path, Span<const string_view> strings,
+                         Span<const NodeGraphNode> nodes, Span<const NodeGraphLink> links)
+{
+    PROFILE_FUNCTION();
+    Close();
+    m_chunksWritten = 0;
+
+    // the string table is small and a single chunk, of each string's end then all their characters
+    uint32 characterCount = 0;
+    for (string_view text : strings) characterCount += static_cast<uint32>(text.size());
+    m_stringData.resize(strings.size() * sizeof(uint32) + characterCount);
+    uint8_t* pEnds = m_stringData.data();
+    char* pCharacters = reinterpret_cast<char*>(pEnds + strings.size() * sizeof(uint32));
+    uint32 end = 0;
+    for (size_t i = 0; i < strings.size(); ++i)
+    {
+        memcpy(pCharacters + end, strings[i].data(), strings[i].size());
+        end += static_cast<uint32>(strings[i].size());
+        memcpy(pEnds + i * sizeof(uint32), &end, sizeof(end));
+    }
+
+    m_payloads.clear();
+    m_payloads.push_back({NodeGraphChunkType::Strings, static_cast<uint32>(strings.size()), m_stringData.data(),
+                          m_stringData.size()});
+    AddPayloads(NodeGraphChunkType::Nodes, nodes.data(), sizeof(NodeGraphNode), static_cast<uint>(nodes.size()));
+    AddPayloads(NodeGraphChunkType::Links, links.data(), sizeof(NodeGraphLink), static_cast<uint>(links.size()));
+
+    // chunks matching those in the same place of the file as last written keep their offsets, the rest are zeroed
+    m_chunks.clear();
+    uint64 liveSize = sizeof(Header) + m_payloads.size() * sizeof(Chunk);
+    uint64 changedSize = m_payloads.size() * sizeof(Chunk);
+    for (const Payload& payload : m_payloads)
+    {
+        Hasher hasher;
+        hasher.Add(payload.pData, payload.size);
+        Chunk chunk = {payload.type, payload.count, 0, payload.size, hasher.Finish().low};
+
+        const size_t i = m_chunks.size();
+        if (i < m_directory.size())
+        {
+            const Chunk& written = m_directory[i];
+            const bool unchanged = written.type == chunk.type && written.count == chunk.count &&
+                                   written.size == chunk.size && written.hash == chunk.hash;
+            if (unchanged) chunk.offset = written.offset;
+        }
+        if (chunk.offset == 0) changedSize += AlignChunk(chunk.size);
+        liveSize += AlignChunk(chunk.size);
+        m_chunks.push_back(chunk);
+    }
+
+    // the file may have been replaced or edited since, in which case its chunks aren't what the directory says
+    error_code error;
+    const bool appendable = !m_directory.empty() && path == m_path && filesystem::file_size(path, error) == m_fileSize;
+    if (appendable && m_chunks.size() == m_directory.size() && changedSize == m_chunks.size() * sizeof(Chunk))
+    {
+        return true;
+    }
+
+    const bool compact = m_fileSize + changedSize > liveSize * 2;
+    const bool written = (appendable && !compact) ? WriteChanged(path) : WriteWhole(path);
+    if (!written)
+    {
+        LOG_WARNING("Node graph could not be saved to {}", PathToUtf8(path));
+        m_path.clear();
+        m_directory.clear();
+        return false;
+    }
+    m_path = path;
+    m_directory = m_chunks;
+    return true;
+}
+
+void NodeGraphFile::AddPayloads(NodeGraphChunkType type, const void* pRecords, size_t recordSize, uint count)
+{
+    for (uint first = 0; first < count; first += ChunkRecords)
+    {
+        const uint chunkCount = min(ChunkRecords, count - first);
+        const uint8_t* pData = static_cast<const uint8_t*>(pRecords) + first * recordSize;
+        m_payloads.push_back({type, chunkCount, pData, chunkCount * recordSize});
+    }
+}
+
+// to a temporary file renamed over the old one, so that a failed save leaves it as it was
+bool NodeGraphFile::WriteWhole(const filesystem::path& path)
+{
+    uint64 offset = AlignChunk(sizeof(Header));
+    for (Chunk& chunk : m_chunks)
+    {
+        chunk.offset = offset;
+        offset += AlignChunk(chunk.size);
+    }
+    const Header header = {Magic, Version, offset, static_cast<uint32>(m_chunks.size()), 0};
+
+    filesystem::path tempPath = path;
+    tempPath += ".tmp";
+    ofstream file(tempPath, ios::binary | ios::trunc);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    WritePadding(file, sizeof(header));
+    for (size_t i = 0; i < m_chunks.size(); ++i)
+    {
+        file.write(static_cast<const char*>(m_payloads[i].pData), m_payloads[i].size);
+        WritePadding(file, m_payloads[i].size);
+    }
+    file.write(reinterpret_cast<const char*>(m_chunks.data()), m_chunks.size() * sizeof(Chunk));
+    file.close();
+
+    error_code error;
+    if (file.fail())
+    {
+        filesystem::remove(tempPath, error);
+        return false;
+    }
+    filesystem::rename(tempPath, path, error);
+    if (error)
+    {
+        filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    m_fileSize = offset + m_chunks.size() * sizeof(Chunk);
+    m_chunksWritten = static_cast<uint>(m_chunks.size());
+    return true;
+}
+
+// after the end of the file, with the header rewritten last to point at the new directory
+bool NodeGraphFile::WriteChanged(const filesystem::path& path)
+{
+    fstream file(path, ios::binary | ios::in | ios::out);
+    if (!file.good()) return false;
+
+    file.seekp(m_fileSize);
+    WritePadding(file, m_fileSize);
+    uint64 offset = AlignChunk(m_fileSize);
+    for (size_t i = 0; i < m_chunks.size(); ++i)
+    {
+        Chunk& chunk = m_chunks[i];
+        if (chunk.offset != 0) continue;
+        chunk.offset = offset;
+        file.write(static_cast<const char*>(m_payloads[i].pData), m_payloads[i].size);
+        WritePadding(file, m_payloads[i].size);
+        offset += AlignChunk(chunk.size);
+        m_chunksWritten++;
+    }
+    file.write(reinterpret_cast<const char*>(m_chunks.data()), m_chunks.size() * sizeof(Chunk));
+    file.flush();
+
+    const Header header = {Magic, Version, offset, static_cast<uint32>(m_chunks.size()), 0};
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+    if (file.fail()) return false;
+
+    m_fileSize = offset + m_chunks.size() * sizeof(Chunk);
+    return true;
+}
+
+
+//=====================================================================================================================
+//                                                      Loading
+//=====================================================================================================================
+bool NodeGraphFile::Open(const filesystem::path& path)
+{
+    PROFILE_FUNCTION();
+    Close();
+    m_path.clear();
+    m_directory.clear();
+    m_stringCount = 0;
+    m_nodeChunks.clear();
+    m_linkChunks.clear();
+    m_nodeCount = 0;
+    m_linkCount = 0;
+    if (!m_file.Open(path)) return false;
+
+    const uint8_t* pData = m_file.GetData();
+    const uint64 size = m_file.GetSize();
+    Header header = {};
+    bool valid = size >= sizeof(header);
+    if (valid)
+    {
+        memcpy(&header, pData, sizeof(header));
+        valid = header.magic == Magic && header.version == Version && header.directoryOffset % 8 == 0 &&
+                header.directoryOffset <= size && header.chunkCount <= (size - header.directoryOffset) / sizeof(Chunk);
+    }
+    if (valid)
+    {
+        m_directory.resize(header.chunkCount);
+        memcpy(m_directory.data(), pData + header.directoryOffset, header.chunkCount * sizeof(Chunk));
+    }
+
+    // the strings first, then full chunks of records but for the last of nodes and of links, all within the file
+    for (size_t i = 0; valid && i < m_directory.size(); ++i)
+    {
+        const Chunk& chunk = m_directory[i];
+        valid = chunk.offset >= sizeof(header) && chunk.offset % 8 == 0 && chunk.offset <= size &&
+                chunk.size <= size - chunk.offset && (chunk.type == NodeGraphChunkType::Strings) == (i == 0);
+        if (!valid) break;
+
+        const uint8_t* pChunk = pData + chunk.offset;
+        switch (chunk.type)
+        {
+        case NodeGraphChunkType::Strings:
+        {
+            m_pStringEnds = reinterpret_cast<const uint32*>(pChunk);
+            m_pStringCharacters = reinterpret_cast<const char*>(pChunk) + uint64(chunk.count) * sizeof(uint32);
+            m_stringCount = chunk.count;
+            valid = uint64(chunk.count) * sizeof(uint32) <= chunk.size;
+            const uint64 characterCount = valid ? chunk.size - uint64(chunk.count) * sizeof(uint32) : 0;
+            for (uint32 s = 0, end = 0; valid && s < chunk.count; end = m_pStringEnds[s++])
+            {
+                valid = m_pStringEnds[s] >= end && m_pStringEnds[s] <= characterCount;
+            }
+            break;
+        }
+        case NodeGraphChunkType::Nodes:
+        {
+            valid = chunk.size == uint64(chunk.count) * sizeof(NodeGraphNode) && chunk.count <= ChunkRecords &&
+                    m_nodeCount % ChunkRecords == 0 && m_linkChunks.empty();
+            m_nodeChunks.push_back(reinterpret_cast<const NodeGraphNode*>(pChunk));
+            m_nodeCount += chunk.count;
+            break;
+        }
+        case NodeGraphChunkType::Links:
+        {
+            valid = chunk.size == uint64(chunk.count) * sizeof(NodeGraphLink) && chunk.count <= ChunkRecords &&
+                    m_linkCount % ChunkRecords == 0;
+            m_linkChunks.push_back(reinterpret_cast<const NodeGraphLink*>(pChunk));
+            m_linkCount += chunk.count;
+            break;
+        }
+        default:
+        {
+            valid = false;
+            break;
+        }
+        }
+    }
+    if (!valid || m_directory.empty())
+    {
+        LOG_WARNING("Node graph file {} is invalid and was not loaded", PathToUtf8(path));
+        Close();
+        m_directory.clear();
+        m_stringCount = 0;
+        m_nodeCount = 0;
+        m_linkCount = 0;
+        return false;
+    }
+
+    m_path = path;
+    m_fileSize = size;
+    return true;
+}
+
+string_view NodeGraphFile::GetString(uint i) const
+{
+    if (i >= m_stringCount) return {};
+    const uint32 begin = (i == 0) ? 0 : m_pStringEnds[i - 1];
+    return string_view(m_pStringCharacters + begin, m_pStringEnds[i] - begin);
+}
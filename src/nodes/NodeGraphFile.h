@@ -0,0 +1,124 @@
+// NodeGraphFile - Versioned binary container for saved node graphs, memory mapped to load and appended to to save.
+//
+// A file is a header, chunks of fixed-size plain records, and a directory of the chunks which the header points to.
+//  Loading maps the file and reads records in place, so nothing is parsed per node. Strings, such as node names and
+//  the names of node types and system values, are stored once in a string table and referred to by index, which also
+//  keeps files valid when enums are reordered. Nodes are split into chunks of a few thousand records, as are links.
+//
+// Saving compares each chunk's hash with the chunk in the same place of the directory as last written, and appends only
+//  the chunks which differ, followed by a new directory. The header is rewritten last and is what commits a save, so a
+//  save interrupted part way leaves the header pointing at the previous directory and its untouched chunks. Once the
+//  chunks superseded outweigh the live ones, the file is instead rewritten whole, to a temporary file renamed over it.
+#pragma once
+
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "MappedFile.h"
+#include "NodeStorage.h"
+
+
+enum class NodeGraphChunkType : uint32
+{
+    Strings,        // offsets of each string's end, then their characters
+    Nodes,
+    Links
+};
+
+struct NodeGraphNode
+{
+    uint32  type;           // string naming its NodeTypeFlat
+    uint32  name;           // string
+    float   position[2];    // in the editor's grid space
+    uint32  parameter;      // a constant's value as the bits of a float, a system value's string, or zero
+};
+
+struct NodeGraphLink
+{
+    uint32  source;         // node, by index
+    uint32  output;         // of the source's outputs
+    uint32  target;
+    uint32  input;          // of the target's inputs
+};
+
+
+class NodeGraphFile
+{
+public:
+    static constexpr uint32 Version = 1;
+    static constexpr uint ChunkRecords = 4096;              // nodes or links per chunk
+
+    NodeGraphFile();
+
+    // Writes only the chunks which changed since this file was last saved or opened, appending them. Any open mapping
+    //  is closed first.
+    bool Save(const std::filesystem::path& path, Span<const std::string_view> strings,
+              Span<const NodeGraphNode> nodes, Span<const NodeGraphLink> links);
+    uint GetChunksWritten() const                           {return m_chunksWritten;}   // by the last save
+    uint GetChunkCount() const                              {return static_cast<uint>(m_directory.size());}
+
+    // Maps and validates a file, whose records are then read in place until it is closed.
+    bool Open(const std::filesystem::path& path);
+    void Close()                                            {m_file.Close();}
+
+    uint GetStringCount() const                             {return m_stringCount;}
+    std::string_view GetString(uint i) const;             // empty if out of range
+    uint GetNodeCount() const                               {return m_nodeCount;}
+    const NodeGraphNode& GetNode(uint i) const              {return m_nodeChunks[i / ChunkRecords][i % ChunkRecords];}
+    uint GetLinkCount() const                               {return m_linkCount;}
+    const NodeGraphLink& GetLink(uint i) const              {return m_linkChunks[i / ChunkRecords][i % ChunkRecords];}
+
+private:
+    struct Header
+    {
+        uint32  magic;
+        uint32  version;
+        uint64  directoryOffset;
+        uint32  chunkCount;
+        uint32  reserved;
+    };
+
+    // an entry of the directory, with chunks listed strings first, then nodes and links in order
+    struct Chunk
+    {
+        NodeGraphChunkType  type;
+        uint32              count;          // records, or strings
+        uint64              offset;         // from the start of the file, 8 byte aligned
+        uint64              size;           // in bytes
+        uint64              hash;           // of the contents, to find those unchanged when saving
+    };
+
+    struct Payload
+    {
+        NodeGraphChunkType  type;
+        uint32              count;
+        const void*         pData;
+        size_t              size;
+    };
+
+    void AddPayloads(NodeGraphChunkType type, const void* pRecords, size_t recordSize, uint count);
+    bool WriteWhole(const std::filesystem::path& path);
+    bool WriteChanged(const std::filesystem::path& path);
+
+    MappedFile                          m_file;
+    std::filesystem::path               m_path;             // as last saved or opened
+    std::vector<Chunk>                  m_directory;        // of m_path, as last saved or opened
+    uint64                              m_fileSize;         // of m_path, as last saved or opened
+    uint                                m_chunksWritten;
+
+    // of the save in progress, kept to not allocate per save
+    std::vector<Payload>                m_payloads;
+    std::vector<Chunk>                  m_chunks;
+    std::vector<uint8_t>                m_stringData;
+
+    // of the open file
+    const uint32*                       m_pStringEnds;
+    const char*                         m_pStringCharacters;
+    uint                                m_stringCount;
+    std::vector<const NodeGraphNode*>   m_nodeChunks;
+    std::vector<const NodeGraphLink*>   m_linkChunks;
+    uint                                m_nodeCount;
+    uint                                m_linkCount;
+};
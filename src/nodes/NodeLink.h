@@ -27,13 +27,21 @@ enum class AttributeType
     NodePtr,    // direct pointer to another node
 };
 
+// a value as evaluated on the CPU, cached by the evaluator in a slot per output attribute
+struct NodeValue
+{
+    AttributeType   type;           // one of Float to Float4
+    bool            varying;        // differs per pixel, as system values do, so has no single value
+    float           components[4];
+};
+
 struct AttributeData
 {
     int             ID;         // ID of this attribute
     AttributeType   DataType;   // data type to pass through links
     Node*           pNode;      // owning node
     NodeLink*       pLink;      // pointer to input/output link
-    void*           pPassthrough;
+    int             ValueSlot;  // the evaluator's slot caching an output's value, or -1
     bool            IsInput;    // indicates if this is an input or output attribute
 };
 
@@ -1,4 +1,5 @@
 #include "Node.h"
+#include "NodeEditor.h"
 #include "Util.h"
 
 
@@ -8,9 +9,10 @@
 NodeNumericConstant::NodeNumericConstant(std::string nodeName) :
     NodeNumeric(NodeNumericSubtype::Constant, nodeName),
     m_value(3.14f),
-    m_attrInput({AttributeCounter++, AttributeType::Float, this, nullptr, nullptr, true}),
-    m_attrOutput({AttributeCounter++, AttributeType::Float, this, nullptr, nullptr, true})
+    m_attributes{{AttributeCounter++, AttributeType::Float, this, nullptr, -1, true},
+                 {AttributeCounter++, AttributeType::Float, this, nullptr, -1, false}}
 {
+    SetAttributes(m_attributes, 1, 1);
 }
 
 
@@ -19,56 +21,146 @@ NodeTypeFlat NodeNumericConstant::NodeType() const
     return NodeTypeFlat::NumericConstant;
 }
 
-const std::vector<int> NodeNumericConstant::Attributes() const
+void NodeNumericConstant::Evaluate(NodeEvaluator& evaluator)
 {
-    return {m_attrInput.ID, m_attrOutput.ID};
+    evaluator.SetOutput(m_attributes[1], {AttributeType::Float, false, {m_value}});
 }
-const std::vector<int> NodeNumericConstant::AttributesIn() const
+
+void NodeNumericConstant::Draw()
+{
+    ImNodes::BeginNode(m_id);
+
+    DrawTitleBar();
+
+    ImNodes::BeginInputAttribute(m_attributes[0].ID);
+    ImNodes::EndInputAttribute();
+
+    // default width is stupidly large, so fit the wider of the title and the value as the drag displays it
+    const FrameString title = Title();
+    const FrameString value = FrameFormat("{:.3f}", m_value);
+    float titleLength = ImGui::CalcTextSize(title.data(), title.data() + title.size()).x;
+    float valueLength = ImGui::CalcTextSize(value.data(), value.data() + value.size()).x;
+    float dragWidth = std::max(titleLength, valueLength) + ImGui::GetStyle().FramePadding.x * 2.0f;
+    ImGui::SetNextItemWidth(dragWidth);
+    if (ImGui::DragFloat("##ConstantNodeValue", &m_value)) SetDirty();
+
+    ImNodes::BeginOutputAttribute(m_attributes[1].ID);
+    ImNodes::EndOutputAttribute();
+
+    ImNodes::EndNode();
+}
+
+
+//=====================================================================================================================
+//                                                  Numeric System Value
+//=====================================================================================================================
+NodeNumericSystemValue::NodeNumericSystemValue(std::string nodeName) :
+    NodeNumeric(NodeNumericSubtype::SystemValue, nodeName),
+    m_value(NodeSystemValue::PixelX),
+    m_attrOutput({AttributeCounter++, AttributeType::Float, this, nullptr, -1, false})
 {
-    return {m_attrInput.ID};
+    SetAttributes(&m_attrOutput, 0, 1);
 }
-const std::vector<int> NodeNumericConstant::AttributesOut() const
+
+NodeTypeFlat NodeNumericSystemValue::NodeType() const
+{
+    return NodeTypeFlat::NumericSystemValue;
+}
+
+void NodeNumericSystemValue::Evaluate(NodeEvaluator& evaluator)
 {
-    return {m_attrOutput.ID};
+    evaluator.SetOutput(m_attrOutput, {AttributeType::Float, true, {}});
 }
 
-AttributeData* NodeNumericConstant::GetAttribute(const int attr)
+void NodeNumericSystemValue::Draw()
 {
-    AttributeData* pResult = nullptr;
+    ImNodes::BeginNode(m_id);
+
+    DrawTitleBar();
 
-    if (attr == m_attrInput.ID)
+    ImGui::SetNextItemWidth(ImGui::CalcTextSize("ColorR").x * 2.0f);
+    if (ImGui::BeginCombo("##SystemValue", magic_enum::enum_name(m_value).data()))
     {
-        pResult = &m_attrInput;
+        for (NodeSystemValue value : magic_enum::enum_values<NodeSystemValue>())
+        {
+            if (ImGui::Selectable(magic_enum::enum_name(value).data(), value == m_value)) SetValue(value);
+        }
+        ImGui::EndCombo();
     }
-    else if (attr == m_attrOutput.ID)
+
+    ImNodes::BeginOutputAttribute(m_attrOutput.ID);
+    ImGui::TextUnformatted("value");
+    ImNodes::EndOutputAttribute();
+
+    ImNodes::EndNode();
+}
+
+
+//=====================================================================================================================
+//                                                  Numeric Math
+//=====================================================================================================================
+NodeNumericMath::NodeNumericMath(NodeNumericSubtype subtype) :
+    NodeNumeric(subtype, std::string(magic_enum::enum_name(subtype))),
+    m_attributes{{AttributeCounter++, AttributeType::Float, this, nullptr, -1, true},
+                 {AttributeCounter++, AttributeType::Float, this, nullptr, -1, true},
+                 {AttributeCounter++, AttributeType::Float, this, nullptr, -1, false}}
+{
+    SetAttributes(m_attributes, 2, 1);
+}
+
+NodeTypeFlat NodeNumericMath::NodeType() const
+{
+    switch (m_subtype)
     {
-        pResult = &m_attrOutput;
+    case NodeNumericSubtype::Add:       return NodeTypeFlat::NumericAdd;
+    case NodeNumericSubtype::Subtract:  return NodeTypeFlat::NumericSubtract;
+    case NodeNumericSubtype::Multiply:  return NodeTypeFlat::NumericMultiply;
+    case NodeNumericSubtype::Divide:    return NodeTypeFlat::NumericDivide;
+    default:                            return NodeTypeFlat::Numeric;
     }
-    else
+}
+
+void NodeNumericMath::Evaluate(NodeEvaluator& evaluator)
+{
+    // an unlinked operand is the operator's identity, as when compiled
+    const bool additive = (m_subtype == NodeNumericSubtype::Add || m_subtype == NodeNumericSubtype::Subtract);
+    const NodeValue a = evaluator.GetInput(m_attributes[0], additive ? 0.0f : 1.0f);
+    const NodeValue b = evaluator.GetInput(m_attributes[1], additive ? 0.0f : 1.0f);
+
+    NodeValue result = {m_attributes[2].DataType, a.varying || b.varying, {}};
+    const uint components = static_cast<uint>(result.type) - static_cast<uint>(AttributeType::Float) + 1;
+    for (uint i = 0; i < components && !result.varying; ++i)
     {
-        PrintMessage(Warning, "Node {} is being queried for missing attribute {}", m_id, attr);
+        switch (m_subtype)
+        {
+        case NodeNumericSubtype::Add:       result.components[i] = a.components[i] + b.components[i]; break;
+        case NodeNumericSubtype::Subtract:  result.components[i] = a.components[i] - b.components[i]; break;
+        case NodeNumericSubtype::Multiply:  result.components[i] = a.components[i] * b.components[i]; break;
+        default:                            result.components[i] = a.components[i] / b.components[i]; break;
+        }
     }
-
-    return pResult;
+    evaluator.SetOutput(m_attributes[2], result);
 }
 
-void NodeNumericConstant::Draw()
+void NodeNumericMath::Draw()
 {
     ImNodes::BeginNode(m_id);
 
     DrawTitleBar();
 
-    ImNodes::BeginInputAttribute(m_attrInput.ID);
+    // an unlinked operand is the operator's identity, so that a node with one link passes it through
+    ImNodes::BeginInputAttribute(m_attributes[0].ID);
+    ImGui::TextUnformatted("a");
+    ImNodes::EndInputAttribute();
+    ImNodes::BeginInputAttribute(m_attributes[1].ID);
+    ImGui::TextUnformatted("b");
     ImNodes::EndInputAttribute();
 
-    // default width is stupidly large
-    float titleLength = ImGui::CalcTextSize((std::to_string(m_id) + ' ' + m_name).c_str()).x;
-    float valueLength = ImGui::CalcTextSize(std::to_string(m_value).c_str()).x;
-    float dragWidth = std::max(titleLength, valueLength) + ImGui::GetStyle().FramePadding.x * 2.0f;
-    ImGui::SetNextItemWidth(dragWidth);
-    ImGui::DragFloat("##ConstantNodeValue", &m_value);
-
-    ImNodes::BeginOutputAttribute(m_attrOutput.ID);
+    // the value cached by the last evaluation, which a system value upstream leaves varying per pixel
+    ImNodes::BeginOutputAttribute(m_attributes[2].ID);
+    const NodeValue& result = m_pNodeEditor->GetEvaluator().GetValue(m_attributes[2]);
+    if (result.varying) ImGui::TextUnformatted("result");
+    else ImGui::Text("result = %.3f", result.components[0]);
     ImNodes::EndOutputAttribute();
 
     ImNodes::EndNode();
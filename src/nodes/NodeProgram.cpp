@@ -0,0 +1,194 @@
+#include "NodeProgram.h"
+
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cstring>
+
+using namespace std;
+using namespace DirectX;
+
+
+namespace
+{
+    typedef XMVECTOR (XM_CALLCONV* VectorOperator)(FXMVECTOR, FXMVECTOR);
+
+    // a block of lanes, with loads and stores unaligned as inputs are the caller's streams
+    template <VectorOperator Operator>
+    void Execute(float* pDestination, const float* pA, const float* pB)
+    {
+        for (uint i = 0; i < NodeProgram::BlockSize; i += 4)
+        {
+            const XMVECTOR a = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(pA + i));
+            const XMVECTOR b = XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(pB + i));
+            XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(pDestination + i), Operator(a, b));
+        }
+    }
+
+    uint ComponentCount(AttributeType type)
+    {
+        return static_cast<uint>(type) - static_cast<uint>(AttributeType::Float) + 1;
+    }
+}
+
+
+NodeProgram::NodeProgram() :
+    m_registerCount(0)
+{
+}
+
+
+//=====================================================================================================================
+//                                                      Building
+//=====================================================================================================================
+void NodeProgram::Build(const NodeIr& ir)
+{
+    m_code.clear();
+    m_constants.clear();
+    m_inputs.clear();
+    m_outputs.clear();
+
+    // constants then inputs take the first registers, which no instruction writes
+    const uint valueCount = static_cast<uint>(ir.instructions.size());
+    vector<array<uint, 4>> registers(valueCount);
+    for (uint i = 0; i < valueCount; ++i)
+    {
+        const NodeIrInstruction& instruction = ir.instructions[i];
+        if (instruction.op != NodeIrOp::Constant) continue;
+        for (uint c = 0; c < ComponentCount(instruction.type); ++c)
+        {
+            registers[i][c] = static_cast<uint>(m_constants.size());
+            m_constants.push_back(instruction.constant[c]);
+        }
+    }
+    for (uint i = 0; i < valueCount; ++i)
+    {
+        const NodeIrInstruction& instruction = ir.instructions[i];
+        if (instruction.op != NodeIrOp::SystemValue) continue;
+        registers[i][0] = static_cast<uint>(m_constants.size() + m_inputs.size());
+        m_inputs.push_back(instruction.systemValue);
+    }
+
+    // temporaries are freed after the instruction which reads them last, unless they are outputs
+    vector<uint> lastUse(valueCount, 0);
+    for (uint i = 0; i < valueCount; ++i)
+    {
+        const NodeIrInstruction& instruction = ir.instructions[i];
+        if (instruction.op == NodeIrOp::Constant || instruction.op == NodeIrOp::SystemValue) continue;
+        lastUse[instruction.operands[0]] = i;
+        lastUse[instruction.operands[1]] = i;
+    }
+    for (uint output : ir.outputs) lastUse[output] = UINT_MAX;
+
+    const uint temporaryBase = static_cast<uint>(m_constants.size() + m_inputs.size());
+    vector<uint> freeRegisters;
+    m_registerCount = temporaryBase;
+    for (uint i = 0; i < valueCount; ++i)
+    {
+        const NodeIrInstruction& instruction = ir.instructions[i];
+        if (instruction.op == NodeIrOp::Constant || instruction.op == NodeIrOp::SystemValue) continue;
+
+        const uint components = ComponentCount(instruction.type);
+        for (uint c = 0; c < components; ++c)
+        {
+            if (freeRegisters.empty())
+            {
+                registers[i][c] = m_registerCount++;
+            }
+            else
+            {
+                registers[i][c] = freeRegisters.back();
+                freeRegisters.pop_back();
+            }
+
+            // scalar operands are broadcast across components
+            NodeInstruction code = {instruction.op, registers[i][c], {}};
+            for (uint o = 0; o < 2; ++o)
+            {
+                const uint operand = instruction.operands[o];
+                const uint operandComponents = ComponentCount(ir.instructions[operand].type);
+                code.operands[o] = registers[operand][min(c, operandComponents - 1)];
+            }
+            m_code.push_back(code);
+        }
+
+        for (uint o = 0; o < 2; ++o)
+        {
+            const uint operand = instruction.operands[o];
+            if (lastUse[operand] != i || (o == 1 && operand == instruction.operands[0])) continue;
+            for (uint c = 0; c < ComponentCount(ir.instructions[operand].type); ++c)
+            {
+                if (registers[operand][c] >= temporaryBase) freeRegisters.push_back(registers[operand][c]);
+            }
+        }
+    }
+
+    for (uint output : ir.outputs)
+    {
+        for (uint c = 0; c < ComponentCount(ir.instructions[output].type); ++c)
+        {
+            m_outputs.push_back(registers[output][c]);
+        }
+    }
+}
+
+
+//=====================================================================================================================
+//                                                    Interpretation
+//=====================================================================================================================
+void NodeProgram::Run(const float* const pInputs[], float* const pOutputs[], uint count, Scratch& scratch) const
+{
+    // Every register has a block of storage, though inputs only use theirs for the last block, when it is partial and
+    //  their streams are too short to read in place, or when they have no stream and read zeros.
+    vector<float>& storage = scratch.storage;
+    vector<const float*>& registers = scratch.registers;
+    if (storage.size() < size_t(m_registerCount) * BlockSize) storage.resize(size_t(m_registerCount) * BlockSize);
+    if (registers.size() < m_registerCount) registers.resize(m_registerCount);
+    for (uint r = 0; r < m_registerCount; ++r) registers[r] = &storage[size_t(r) * BlockSize];
+    for (uint r = 0; r < m_constants.size(); ++r) fill_n(&storage[size_t(r) * BlockSize], BlockSize, m_constants[r]);
+
+    const uint inputBase = static_cast<uint>(m_constants.size());
+    for (uint i = 0; i < m_inputs.size(); ++i)
+    {
+        if (pInputs[static_cast<uint>(m_inputs[i])] == nullptr)
+        {
+            fill_n(&storage[size_t(inputBase + i) * BlockSize], BlockSize, 0.0f);
+        }
+    }
+    for (uint begin = 0; begin < count; begin += BlockSize)
+    {
+        const uint lanes = min(BlockSize, count - begin);
+        for (uint i = 0; i < m_inputs.size(); ++i)
+        {
+            const float* pStream = pInputs[static_cast<uint>(m_inputs[i])];
+            float* pStorage = &storage[size_t(inputBase + i) * BlockSize];
+            if (pStream == nullptr) continue;
+            if (lanes == BlockSize)
+            {
+                registers[inputBase + i] = pStream + begin;
+                continue;
+            }
+            memcpy(pStorage, pStream + begin, lanes * sizeof(float));
+            registers[inputBase + i] = pStorage;
+        }
+
+        for (const NodeInstruction& code : m_code)
+        {
+            float* pDestination = &storage[size_t(code.destination) * BlockSize];
+            const float* pA = registers[code.operands[0]];
+            const float* pB = registers[code.operands[1]];
+            switch (code.op)
+            {
+            case NodeIrOp::Add:         Execute<XMVectorAdd>(pDestination, pA, pB);         break;
+            case NodeIrOp::Subtract:    Execute<XMVectorSubtract>(pDestination, pA, pB);    break;
+            case NodeIrOp::Multiply:    Execute<XMVectorMultiply>(pDestination, pA, pB);    break;
+            default:                    Execute<XMVectorDivide>(pDestination, pA, pB);      break;
+            }
+        }
+
+        for (uint o = 0; o < m_outputs.size(); ++o)
+        {
+            memcpy(pOutputs[o] + begin, registers[m_outputs[o]], lanes * sizeof(float));
+        }
+    }
+}
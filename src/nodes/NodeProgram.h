@@ -0,0 +1,58 @@
+// NodeProgram - A compiled node graph as flat register bytecode, interpreted over thousands of inputs per call.
+//
+// Building scalarizes the compiler's IR into three-operand instructions on registers of one float each, so float2 to
+//  float4 values take a register per component. Registers are laid out SoA: each holds a float for every lane of a
+//  block, and an instruction is a loop over a block of contiguous floats, four lanes to a DirectXMath vector. The
+//  interpreter thus dispatches once per instruction per block, rather than once per node per input as walking the
+//  graph does, and never chases a pointer while evaluating.
+//
+// Constants are broadcast into registers once per call. Inputs, the IR's system values, are streams the caller
+//  provides, read in place for whole blocks. Temporaries reuse the registers of values no longer read, which keeps the
+//  block's registers in the L1 cache for graphs of a few dozen nodes.
+#pragma once
+
+#include <vector>
+
+#include "NodeCompiler.h"
+
+
+struct NodeInstruction
+{
+    NodeIrOp    op;             // one of the arithmetic operators
+    uint        destination;
+    uint        operands[2];
+};
+
+
+class NodeProgram
+{
+public:
+    static constexpr uint BlockSize = 256;                  // lanes per block, a multiple of the vector width
+
+    // the registers of a run, kept by the caller, one per thread running, so that runs after the first allocate nothing
+    struct Scratch
+    {
+        std::vector<float>          storage;                // a block per register
+        std::vector<const float*>   registers;              // into the storage, or an input's stream
+    };
+
+    NodeProgram();
+
+    void Build(const NodeIr& ir);
+
+    // Evaluates count lanes. Inputs are indexed by NodeSystemValue, each a stream of count floats or null for zeros,
+    //  and outputs take count floats for each component of each of the IR's outputs. Thread-safe, given a scratch per
+    //  thread, which grows to fit the program the first time it runs it.
+    void Run(const float* const pInputs[], float* const pOutputs[], uint count, Scratch& scratch) const;
+
+    uint GetInstructionCount() const                        {return static_cast<uint>(m_code.size());}
+    uint GetRegisterCount() const                           {return m_registerCount;}
+    uint GetOutputCount() const                             {return static_cast<uint>(m_outputs.size());}
+
+private:
+    std::vector<NodeInstruction>    m_code;
+    std::vector<float>              m_constants;            // in the first registers
+    std::vector<NodeSystemValue>    m_inputs;               // in the registers following the constants
+    std::vector<uint>               m_outputs;              // registers, by output component
+    uint                            m_registerCount;        // constants, inputs and temporaries
+};
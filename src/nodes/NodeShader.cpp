@@ -0,0 +1,42 @@
+#include "Node.h"
+#include "Util.h"
+
+
+//=====================================================================================================================
+//                                                  Pixel Output
+//=====================================================================================================================
+NodeShaderOutput::NodeShaderOutput(std::string nodeName) :
+    Node(NodeClass::Shader, nodeName),
+    m_attrChannels{{AttributeCounter++, AttributeType::Float, this, nullptr, -1, true},
+                   {AttributeCounter++, AttributeType::Float, this, nullptr, -1, true},
+                   {AttributeCounter++, AttributeType::Float, this, nullptr, -1, true},
+                   {AttributeCounter++, AttributeType::Float, this, nullptr, -1, true}}
+{
+    SetAttributes(m_attrChannels, _countof(m_attrChannels), 0);
+}
+
+NodeTypeFlat NodeShaderOutput::NodeType() const
+{
+    return NodeTypeFlat::ShaderPixelOutput;
+}
+
+void NodeShaderOutput::Draw()
+{
+    ImNodes::BeginNode(m_id);
+
+    // title bar
+    ImNodes::PushColorStyle(ImNodesCol_TitleBar, IM_COL32(191, 109, 11, 255));
+    DrawTitleBar();
+    ImNodes::PopColorStyle();
+
+    // unlinked channels are black and opaque
+    const char* channelNames[] = {"red", "green", "blue", "alpha"};
+    for (uint i = 0; i < _countof(m_attrChannels); ++i)
+    {
+        ImNodes::BeginInputAttribute(m_attrChannels[i].ID);
+        ImGui::TextUnformatted(channelNames[i]);
+        ImNodes::EndInputAttribute();
+    }
+
+    ImNodes::EndNode();
+}
@@ -0,0 +1,204 @@
+// NodeStorage - Pooled storage for the node editor's nodes and links, addressed by generational handles.
+//
+// Objects are constructed in place in large chunks which never move, so pointers into them stay valid for an object's
+//  lifetime, as attributes' links and the evaluator's nodes need, and nodes created together share cache lines rather
+//  than being scattered across the heap. Memory of a destroyed object is reused by the next object of the same size.
+//
+// A handle is an index into a dense table of slots, with the slot's generation when the object was created. A slot is
+//  reused once its object is destroyed, with its generation advanced, so a handle kept past its object's lifetime
+//  resolves to null rather than to whatever replaced it. Live objects are also listed densely, for iteration.
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Common.h"
+
+
+// a contiguous range of objects owned elsewhere, as std::span is in C++20
+template <typename T>
+class Span
+{
+public:
+    Span()                                                  : m_pData(nullptr), m_size(0) {}
+    Span(T* pData, size_t size)                             : m_pData(pData), m_size(size) {}
+
+    T* begin() const                                        {return m_pData;}
+    T* end() const                                          {return m_pData + m_size;}
+    T& operator[](size_t i) const                           {return m_pData[i];}
+    T* data() const                                         {return m_pData;}
+    size_t size() const                                     {return m_size;}
+    bool empty() const                                      {return m_size == 0;}
+
+private:
+    T*      m_pData;
+    size_t  m_size;
+};
+
+
+struct PoolHandle
+{
+    uint32  index;                                          // of the slot
+    uint32  generation;                                     // of the slot, when the object was created
+};
+
+
+// Objects of T or of classes derived from it, which T's destructor must then be virtual for.
+template <typename T>
+class NodePool
+{
+public:
+    static constexpr size_t ChunkSize = 64 * 1024;
+    static constexpr size_t Granularity = alignof(std::max_align_t);
+
+    NodePool()                                              : m_pCurrent(nullptr), m_pEnd(nullptr) {}
+    ~NodePool();
+
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    template <typename U = T, typename... Args>
+    PoolHandle Create(Args&&... args);
+    void Destroy(PoolHandle handle);
+
+    T* Get(PoolHandle handle) const;                        // or null for a handle outliving its object
+    Span<T* const> Objects() const                          {return Span<T* const>(m_objects.data(), m_objects.size());}
+    size_t Size() const                                     {return m_objects.size();}
+
+private:
+    struct Slot
+    {
+        T*          pObject;                                // or null while free
+        uint32      generation;
+        uint32      dense;                                  // position in m_objects
+        uint32      size;                                   // of the object's allocation
+    };
+
+    struct FreeList
+    {
+        size_t              size;
+        std::vector<void*>  memory;
+    };
+
+    void* Allocate(size_t size);
+
+    std::vector<std::unique_ptr<std::byte[]>>   m_chunks;
+    std::byte*                                  m_pCurrent;     // next free byte in the last chunk
+    std::byte*                                  m_pEnd;
+    std::vector<FreeList>                       m_freeLists;    // by allocation size, of which there are few
+    std::vector<Slot>                           m_slots;
+    std::vector<uint32>                         m_freeSlots;
+    std::vector<T*>                             m_objects;      // live, in creation order until one is destroyed
+    std::vector<uint32>                         m_objectSlots;  // the slot of each of m_objects
+};
+
+
+//=====================================================================================================================
+//                                                  Template Definitions
+//=====================================================================================================================
+template <typename T>
+NodePool<T>::~NodePool()
+{
+    for (T* pObject : m_objects) pObject->~T();
+}
+
+template <typename T>
+template <typename U, typename... Args>
+PoolHandle NodePool<T>::Create(Args&&... args)
+{
+    static_assert(std::is_base_of_v<T, U>, "pools hold T and classes derived from it");
+    static_assert(alignof(U) <= Granularity, "pooled objects are over-aligned");
+
+    const size_t size = (sizeof(U) + Granularity - 1) & ~(Granularity - 1);
+    T* pObject = new (Allocate(size)) U(std::forward<Args>(args)...);
+
+    uint32 index = 0;
+    if (m_freeSlots.empty())
+    {
+        index = static_cast<uint32>(m_slots.size());
+        m_slots.push_back({nullptr, 0, 0, 0});
+    }
+    else
+    {
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+
+    Slot& slot = m_slots[index];
+    slot.pObject = pObject;
+    slot.dense = static_cast<uint32>(m_objects.size());
+    slot.size = static_cast<uint32>(size);
+    m_objects.push_back(pObject);
+    m_objectSlots.push_back(index);
+    return {index, slot.generation};
+}
+
+template <typename T>
+void NodePool<T>::Destroy(PoolHandle handle)
+{
+    T* pObject = Get(handle);
+    if (pObject == nullptr) return;
+
+    Slot& slot = m_slots[handle.index];
+    pObject->~T();
+    for (FreeList& freeList : m_freeLists)
+    {
+        if (freeList.size == slot.size) freeList.memory.push_back(pObject);
+    }
+
+    // the last live object takes the destroyed one's place in the dense list
+    m_objects[slot.dense] = m_objects.back();
+    m_objectSlots[slot.dense] = m_objectSlots.back();
+    m_slots[m_objectSlots[slot.dense]].dense = slot.dense;
+    m_objects.pop_back();
+    m_objectSlots.pop_back();
+
+    slot.pObject = nullptr;
+    slot.generation++;
+    m_freeSlots.push_back(handle.index);
+}
+
+template <typename T>
+T* NodePool<T>::Get(PoolHandle handle) const
+{
+    if (handle.index >= m_slots.size()) return nullptr;
+    const Slot& slot = m_slots[handle.index];
+    return (slot.generation == handle.generation) ? slot.pObject : nullptr;
+}
+
+template <typename T>
+void* NodePool<T>::Allocate(size_t size)
+{
+    FreeList* pFreeList = nullptr;
+    for (FreeList& freeList : m_freeLists)
+    {
+        if (freeList.size == size) pFreeList = &freeList;
+    }
+    if (pFreeList == nullptr)
+    {
+        m_freeLists.push_back({size, {}});
+        pFreeList = &m_freeLists.back();
+    }
+    if (!pFreeList->memory.empty())
+    {
+        void* pMemory = pFreeList->memory.back();
+        pFreeList->memory.pop_back();
+        return pMemory;
+    }
+
+    if (size_t(m_pEnd - m_pCurrent) < size)
+    {
+        const size_t chunkSize = std::max(ChunkSize, size);
+        m_chunks.push_back(std::make_unique<std::byte[]>(chunkSize));
+        m_pCurrent = m_chunks.back().get();
+        m_pEnd = m_pCurrent + chunkSize;
+    }
+    void* pMemory = m_pCurrent;
+    m_pCurrent += size;
+    return pMemory;
+}
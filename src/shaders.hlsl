@@ -1,3 +1,11 @@
+// Permutation keywords, each defined as 0 or 1 by the pipeline:
+//  VISUALIZE_DEPTH     shades by distance from the camera rather than by vertex color
+//  NODE_GRAPH          shades by the node editor's graph, compiled into node_graph.hlsl, unless visualizing depth
+//
+// The pipeline derives its root signature and input layout from what these read once compiled, so a variant which
+//  compiles out an input leaves its stream unbound. Inputs are compiled out rather than left unread, as Vulkan
+//  requires every declared input to have a stream bound.
+
 cbuffer SceneConstants : register(b0)
 {
     float4x4 ViewMatrix;
@@ -8,27 +16,52 @@ cbuffer MeshConstants : register(b1)
     float4x4 ModelMatrix;
 };
 
+struct VSInput
+{
+    float4 position : POSITION;
+#if !VISUALIZE_DEPTH
+    float4 color : COLOR;
+#endif
+};
+
 struct PSInput
 {
     float4 position : SV_POSITION;
+#if !VISUALIZE_DEPTH
     float4 color : COLOR;
+#endif
 };
 
-PSInput VSMain(float4 position : POSITION, float4 color : COLOR)
+PSInput VSMain(VSInput input)
 {
     PSInput result;
 
     // model/view/projection matrix
     float4x4 MVP = mul(mul(ModelMatrix, ViewMatrix), ProjectionMatrix);
-    result.position = mul(position, MVP);
+    result.position = mul(input.position, MVP);
 
+#if !VISUALIZE_DEPTH
     // passthrough per-vertex color for interpolation
-    result.color = color;
+    result.color = input.color;
+#endif
 
     return result;
 }
 
+static const float DepthVisualizationRange = 100.0;
+
+#if NODE_GRAPH && !VISUALIZE_DEPTH
+#include "node_graph.hlsl"
+#endif
+
 float4 PSMain(PSInput input) : SV_TARGET
 {
+#if VISUALIZE_DEPTH
+    // view-space depth, which SV_POSITION carries in w, from black at the camera to white at the range
+    return float4(saturate(input.position.w / DepthVisualizationRange).xxx, 1.0);
+#elif NODE_GRAPH
+    return NodeGraphColor(input.position, input.color);
+#else
     return input.color;
+#endif
 }